@@ -0,0 +1,195 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/AsyncReadback.h"
+#include "API/CopyContext.h"
+
+namespace Falcor
+{
+    bool ReadbackRequest::isReady()
+    {
+        if (mResolved == false && mpFence->getGpuValue() >= mFenceValue)
+        {
+            // Resolve through the heap so that callbacks are invoked in order
+            ReadbackHeap::SharedPtr pHeap = mpHeap.lock();
+            if (pHeap)
+            {
+                pHeap->processCompletedRequests();
+            }
+            else
+            {
+                resolve();
+            }
+        }
+        return mResolved;
+    }
+
+    void ReadbackRequest::wait()
+    {
+        if (mResolved) return;
+        ReadbackHeap::SharedPtr pHeap = mpHeap.lock();
+        if (pHeap)
+        {
+            pHeap->wait(this);
+        }
+        else
+        {
+            // The context is gone, which means its commands were already submitted
+            mpFence->syncCpu();
+            resolve();
+        }
+    }
+
+    const std::vector<uint8>& ReadbackRequest::getData()
+    {
+        wait();
+        return mData;
+    }
+
+    void ReadbackRequest::resolve()
+    {
+        assert(mResolved == false);
+        const uint8* pStaging = (const uint8*)mpStaging->map(Buffer::MapType::Read) + mLayout.offset;
+        size_t sliceSize = size_t(mLayout.rowSize) * mLayout.rowCount;
+        mData.resize(sliceSize * mLayout.depth);
+
+        if (mLayout.rowSize == mLayout.rowPitch)
+        {
+            memcpy(mData.data(), pStaging, mData.size());
+        }
+        else
+        {
+            uint8* pDst = mData.data();
+            for (uint32_t z = 0; z < mLayout.depth; z++)
+            {
+                for (uint32_t y = 0; y < mLayout.rowCount; y++)
+                {
+                    memcpy(pDst, pStaging, mLayout.rowSize);
+                    pDst += mLayout.rowSize;
+                    pStaging += mLayout.rowPitch;
+                }
+            }
+        }
+        mpStaging->unmap();
+
+        ReadbackHeap::SharedPtr pHeap = mpHeap.lock();
+        if (pHeap)
+        {
+            pHeap->releaseStagingBuffer(mpStaging);
+        }
+        mpStaging = nullptr;
+        mResolved = true;
+
+        if (mCallback)
+        {
+            Callback callback = std::move(mCallback);
+            mCallback = nullptr;
+            callback(mData);
+        }
+    }
+
+    ReadbackHeap::SharedPtr ReadbackHeap::create(CopyContext* pContext, GpuFence::SharedPtr pFence)
+    {
+        return SharedPtr(new ReadbackHeap(pContext, pFence));
+    }
+
+    Buffer::SharedPtr ReadbackHeap::acquireStagingBuffer(size_t size)
+    {
+        size_t bucketSize = kMinStagingSize;
+        while (bucketSize < size)
+        {
+            bucketSize <<= 1;
+        }
+
+        auto it = mAvailableBuffers.find(bucketSize);
+        if (it != mAvailableBuffers.end())
+        {
+            Buffer::SharedPtr pBuffer = it->second;
+            mAvailableBuffers.erase(it);
+            mAvailableBytes -= bucketSize;
+            return pBuffer;
+        }
+
+        return Buffer::create(bucketSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+    }
+
+    void ReadbackHeap::releaseStagingBuffer(Buffer::SharedPtr pBuffer)
+    {
+        size_t size = pBuffer->getSize();
+        if (mAvailableBytes + size > kMaxAvailableBytes)
+        {
+            // Let the buffer go. The device will defer the release until the GPU is done with it
+            return;
+        }
+        mAvailableBuffers.insert(std::make_pair(size, pBuffer));
+        mAvailableBytes += size;
+    }
+
+    ReadbackRequest::SharedPtr ReadbackHeap::createRequest(Buffer::SharedPtr pStaging, const ReadbackRequest::Layout& layout, const ReadbackRequest::Callback& callback)
+    {
+        ReadbackRequest::SharedPtr pRequest = ReadbackRequest::SharedPtr(new ReadbackRequest());
+        pRequest->mpHeap = shared_from_this();
+        pRequest->mpFence = mpFence;
+        pRequest->mpStaging = pStaging;
+        pRequest->mLayout = layout;
+        pRequest->mCallback = callback;
+        // The commands will be signaled with the fence's current CPU value when the context is flushed
+        pRequest->mFenceValue = mpFence->getCpuValue();
+        mPendingRequests.push_back(pRequest);
+        return pRequest;
+    }
+
+    void ReadbackHeap::processCompletedRequests()
+    {
+        uint64_t gpuVal = mpFence->getGpuValue();
+        while (mPendingRequests.size() && mPendingRequests.front()->mFenceValue <= gpuVal)
+        {
+            // Pop before resolving. The callback might create new requests
+            ReadbackRequest::SharedPtr pRequest = mPendingRequests.front();
+            mPendingRequests.pop_front();
+            pRequest->resolve();
+        }
+    }
+
+    void ReadbackHeap::wait(ReadbackRequest* pRequest)
+    {
+        if (pRequest->mResolved) return;
+
+        if (mpFence->getGpuValue() < pRequest->mFenceValue)
+        {
+            // If the copy is still in the command list, submit it first
+            if (mpFence->getCpuValue() <= pRequest->mFenceValue)
+            {
+                mpContext->flush(false);
+            }
+            mpFence->syncCpu();
+        }
+        processCompletedRequests();
+        assert(pRequest->mResolved);
+    }
+}
@@ -0,0 +1,143 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <deque>
+#include <functional>
+#include <map>
+#include "API/Buffer.h"
+#include "API/LowLevel/GpuFence.h"
+
+namespace Falcor
+{
+    class CopyContext;
+    class ReadbackHeap;
+
+    /** A pending GPU-to-CPU copy. Returned by CopyContext::asyncReadTextureSubresource() and CopyContext::asyncReadBuffer().
+        The copy is recorded into the context's command list and the data becomes available once the GPU executed it. You can poll the request using isReady(), block using wait(), or provide a callback when creating the request.
+        Requests issued on the same context complete in the order they were issued.
+    */
+    class ReadbackRequest
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ReadbackRequest>;
+        using Callback = std::function<void(const std::vector<uint8>& data)>;
+
+        /** Describes where the data is located inside the staging buffer
+        */
+        struct Layout
+        {
+            size_t offset = 0;      ///< Offset of the first row in the staging buffer
+            uint32_t rowSize = 0;   ///< Number of bytes to read from each row
+            uint32_t rowPitch = 0;  ///< Distance in bytes between two rows in the staging buffer
+            uint32_t rowCount = 1;  ///< Number of rows in each slice
+            uint32_t depth = 1;     ///< Number of slices
+        };
+
+        /** Check if the data is available. This function doesn't block
+        */
+        bool isReady();
+
+        /** Block until the data is available. If the copy command wasn't submitted yet, this will flush the context
+        */
+        void wait();
+
+        /** Get the data. Blocks if the request is not ready yet
+        */
+        const std::vector<uint8>& getData();
+
+    private:
+        friend class ReadbackHeap;
+        friend class CopyContext;
+        ReadbackRequest() = default;
+        void resolve();
+
+        std::weak_ptr<ReadbackHeap> mpHeap;
+        GpuFence::SharedPtr mpFence;
+        Buffer::SharedPtr mpStaging;
+        Layout mLayout;
+        uint64_t mFenceValue = 0;
+        Callback mCallback;
+        std::vector<uint8> mData;
+        bool mResolved = false;
+    };
+
+    /** Manages the staging buffers used for asynchronous readbacks and tracks the pending requests using the owning context's fence.
+        Each CopyContext owns a heap. Staging buffers are bucketed by size and recycled once their content was copied out, so steady-state readbacks don't allocate.
+        This class is not thread-safe.
+    */
+    class ReadbackHeap : public std::enable_shared_from_this<ReadbackHeap>
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ReadbackHeap>;
+        using SharedConstPtr = std::shared_ptr<const ReadbackHeap>;
+
+        /** Create a new heap
+            \param[in] pContext The context the copy commands are recorded into. The heap doesn't hold a reference to it, the context is expected to own the heap
+            \param[in] pFence The fence signaled when the context's command list is submitted
+        */
+        static SharedPtr create(CopyContext* pContext, GpuFence::SharedPtr pFence);
+
+        /** Get a staging buffer which can hold at least size bytes
+        */
+        Buffer::SharedPtr acquireStagingBuffer(size_t size);
+
+        /** Create a request for data which is copied into pStaging by the commands currently being recorded
+        */
+        ReadbackRequest::SharedPtr createRequest(Buffer::SharedPtr pStaging, const ReadbackRequest::Layout& layout, const ReadbackRequest::Callback& callback);
+
+        /** Resolve all the requests the GPU finished executing and invoke their callbacks. Doesn't block
+        */
+        void processCompletedRequests();
+
+        /** Block until a request is complete. Resolves all the requests issued before it as well
+        */
+        void wait(ReadbackRequest* pRequest);
+
+        /** Get the number of requests the GPU didn't finish yet
+        */
+        size_t getPendingRequestCount() const { return mPendingRequests.size(); }
+
+        /** Get the total size of the staging buffers which are waiting to be reused
+        */
+        size_t getAvailableStagingSize() const { return mAvailableBytes; }
+
+    private:
+        friend class ReadbackRequest;
+        ReadbackHeap(CopyContext* pContext, GpuFence::SharedPtr pFence) : mpContext(pContext), mpFence(pFence) {}
+        void releaseStagingBuffer(Buffer::SharedPtr pBuffer);
+
+        static const size_t kMinStagingSize = 64 * 1024;
+        static const size_t kMaxAvailableBytes = 128 * 1024 * 1024;
+
+        CopyContext* mpContext;
+        GpuFence::SharedPtr mpFence;
+        std::deque<ReadbackRequest::SharedPtr> mPendingRequests;
+        std::multimap<size_t, Buffer::SharedPtr> mAvailableBuffers;
+        size_t mAvailableBytes = 0;
+    };
+}
@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "API/Buffer.h"
 #include "API/Device.h"
+#include "Utils/FrameTelemetry.h"
 
 namespace Falcor
 {
@@ -45,9 +46,25 @@ namespace Falcor
         else return nullptr;
     }
 
+    Buffer::SharedPtr Buffer::createTransient(size_t size, BindFlags usage, const void* pInitData)
+    {
+        Buffer::SharedPtr pBuffer = SharedPtr(new Buffer(size, usage, CpuAccess::Write));
+        pBuffer->mIsTransient = true;
+        // The allocation happens when mapping the buffer
+        if (pBuffer->apiInit(true) == false) return nullptr;
+
+        uint8_t* pData = (uint8_t*)pBuffer->map(MapType::WriteDiscard);
+        if (pInitData) memcpy(pData, pInitData, size);
+        return pBuffer;
+    }
+
     Buffer::~Buffer()
     {
-        if (mDynamicData.pResourceHandle)
+        if (mIsTransient || mUploadPageId)
+        {
+            // The memory belongs to the upload ring, it will be recycled once the GPU is done with it
+        }
+        else if (mDynamicData.pResourceHandle)
         {
             gpDevice->getResourceAllocator()->release(mDynamicData);
         }
@@ -80,12 +97,28 @@ namespace Falcor
                 return nullptr;
             }
 
-            // Allocate a new buffer
-            if (mDynamicData.pResourceHandle)
+            // Allocate a new buffer. Constant buffers are re-mapped for every update, so they take their memory from the upload ring as well
+            UploadRingAllocator* pUploadAllocator = gpDevice->getUploadAllocator().get();
+            bool useUploadRing = mIsTransient || (mBindFlags == BindFlags::Constant && mSize <= pUploadAllocator->getPageSize());
+            if (mDynamicData.pResourceHandle && mIsTransient == false && mUploadPageId == 0)
             {
                 gpDevice->getResourceAllocator()->release(mDynamicData);
             }
-            mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize, getBufferDataAlignment(this));
+
+            if (useUploadRing)
+            {
+                ResourceAllocator::BaseData data = pUploadAllocator->allocate(mSize, getBufferDataAlignment(this));
+                mDynamicData = {};
+                mDynamicData.pResourceHandle = data.pResourceHandle;
+                mDynamicData.offset = data.offset;
+                mDynamicData.pData = data.pData;
+                if (mIsTransient == false) mUploadPageId = pUploadAllocator->getActivePageId();
+            }
+            else
+            {
+                mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize, getBufferDataAlignment(this));
+                mUploadPageId = 0;
+            }
             mApiHandle = mDynamicData.pResourceHandle;
             invalidateViews();
             return mDynamicData.pData;
@@ -100,7 +133,7 @@ namespace Falcor
             }
             else
             {
-                logWarning("Buffer::map() performance warning - using staging resource which require us to flush the pipeline and wait for the GPU to finish its work");
+                logWarning("Buffer::map() performance warning - using staging resource which require us to flush the pipeline and wait for the GPU to finish its work. Use CopyContext::asyncReadBuffer() instead");
                 if (mpStagingResource == nullptr)
                 {
                     mpStagingResource = Buffer::create(mSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
@@ -115,6 +148,11 @@ namespace Falcor
         }
     }
 
+    bool Buffer::isUploadMemoryExpired() const
+    {
+        return mUploadPageId && (gpDevice->getUploadAllocator()->isPageAlive(mUploadPageId) == false);
+    }
+
     void CopyContext::updateBuffer(const Buffer* pBuffer, const void* pData, size_t offset, size_t numBytes)
     {
         if (numBytes == 0)
@@ -129,9 +167,10 @@ namespace Falcor
         }
 
         mCommandsPending = true;
+        gFrameCounters.uploadBytes += numBytes;
         // Allocate a buffer on the upload heap
         uint8_t* pInitData = (uint8_t*)pData + offset;
-        Buffer::SharedPtr pUploadBuffer = Buffer::create(numBytes, Buffer::BindFlags::None, Buffer::CpuAccess::Write, pInitData);
+        Buffer::SharedPtr pUploadBuffer = Buffer::createTransient(numBytes, Buffer::BindFlags::None, pInitData);
 
         copyBufferRegion(pBuffer, offset, pUploadBuffer.get(), 0, numBytes);
     }
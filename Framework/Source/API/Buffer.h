@@ -80,6 +80,19 @@ namespace Falcor
         */
         static SharedPtr create(size_t size, Resource::BindFlags bind, CpuAccess cpuAccess, const void* pInitData = nullptr);
 
+        /** Create a CPU-writable buffer whose memory comes from the device's UploadRingAllocator. This is much cheaper than create(), but the memory is recycled once the GPU is done with the commands recorded so far.
+            Use it for data which is consumed within the frame, like staging data or constants which are rewritten every frame. Calling map(MapType::WriteDiscard) on the buffer will allocate from the ring again.
+            \param[in] size The size in bytes of the buffer.
+            \param[in] bind Buffer bind flags
+            \param[in] pInitData Optional parameter. Initial buffer data. Pointed buffer size should be at least Size bytes.
+            \return A pointer to a new buffer object, or nullptr if creation failed.
+        */
+        static SharedPtr createTransient(size_t size, Resource::BindFlags bind, const void* pInitData = nullptr);
+
+        /** Check if the upload ring recycled the memory of a constant buffer since it was last mapped. Constant buffers take their memory from the ring when mapped with MapType::WriteDiscard, so their content has to be written again when this returns true
+        */
+        bool isUploadMemoryExpired() const;
+
         /** Update the buffer's data
             \param[in] pData Pointer to the source data.
             \param[in] offset Byte offset into the destination buffer, indicating where to start copy into.
@@ -145,6 +158,8 @@ namespace Falcor
 
         size_t mSize = 0;
         CpuAccess mCpuAccess;
+        bool mIsTransient = false;
+        uint64_t mUploadPageId = 0;     // The upload ring page holding the memory of a constant buffer, 0 if the memory comes from the resource allocator
         ResourceAllocator::AllocationData mDynamicData;
         Buffer::SharedPtr mpStagingResource; // For buffers that have both CPU read flag and can be used by the GPU
     };
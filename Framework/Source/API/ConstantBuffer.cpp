@@ -65,6 +65,8 @@ namespace Falcor
 
     bool ConstantBuffer::uploadToGPU(size_t offset, size_t size)
     {
+        // The upload ring recycled the memory of the last update, write the CPU copy again
+        if (isUploadMemoryExpired()) mDirty = true;
         if (mDirty) mpCbv = nullptr;
         return VariablesBuffer::uploadToGPU(offset, size);
     }
@@ -74,4 +74,50 @@ namespace Falcor
         }
         updateTextureSubresources(pTexture, 0, subresourceCount, pData);
     }
+
+    ReadbackHeap* CopyContext::getReadbackHeap()
+    {
+        if (mpReadbackHeap == nullptr)
+        {
+            mpReadbackHeap = ReadbackHeap::create(this, mpLowLevelData->getFence());
+        }
+        return mpReadbackHeap.get();
+    }
+
+    std::vector<uint8> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    {
+        ReadbackRequest::SharedPtr pRequest = asyncReadTextureSubresource(pTexture, subresourceIndex);
+        pRequest->wait();
+        return std::move(pRequest->mData);
+    }
+
+    ReadbackRequest::SharedPtr CopyContext::asyncReadBuffer(const Buffer* pBuffer, size_t offset, size_t numBytes, const ReadbackRequest::Callback& callback)
+    {
+        if (numBytes == 0)
+        {
+            numBytes = pBuffer->getSize() - offset;
+        }
+
+        if (pBuffer->adjustSizeOffsetParams(numBytes, offset) == false)
+        {
+            logWarning("CopyContext::asyncReadBuffer() - size and offset are invalid. Nothing to read.");
+            return nullptr;
+        }
+
+        Buffer::SharedPtr pStaging = getReadbackHeap()->acquireStagingBuffer(numBytes);
+        copyBufferRegion(pStaging.get(), 0, pBuffer, offset, numBytes);
+
+        ReadbackRequest::Layout layout;
+        layout.rowSize = (uint32_t)numBytes;
+        layout.rowPitch = (uint32_t)numBytes;
+        return getReadbackHeap()->createRequest(pStaging, layout, callback);
+    }
+
+    void CopyContext::processReadbacks()
+    {
+        if (mpReadbackHeap)
+        {
+            mpReadbackHeap->processCompletedRequests();
+        }
+    }
 }
\ No newline at end of file
@@ -27,6 +27,7 @@
 ***************************************************************************/
 #pragma once
 #include "API/Resource.h"
+#include "API/AsyncReadback.h"
 #ifdef FALCOR_LOW_LEVEL_API
 #include "API/LowLevel/LowLevelContextData.h"
 #endif
@@ -48,8 +49,37 @@ namespace Falcor
         void updateTexture(const Texture* pTexture, const void* pData);
         void updateTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const void* pData);
         void updateTextureSubresources(const Texture* pTexture, uint32_t firstSubresource, uint32_t subresourceCount, const void* pData);
+
+        /** Update a rectangle of a 2D texture subresource. The offset and size must be multiples of the format's block size
+            \param[in] pData The texels of the rectangle, with tightly packed rows
+        */
+        void updateTextureRegion(const Texture* pTexture, uint32_t subresourceIndex, const uvec2& offset, const uvec2& size, const void* pData);
+
+        /** Read a texture subresource. This function blocks until the GPU finished executing all the commands recorded so far. Prefer using asyncReadTextureSubresource()
+        */
         std::vector<uint8> readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
 
+        /** Record a copy of a texture subresource into a staging buffer. Doesn't block
+            \param[in] pTexture The texture to read
+            \param[in] subresourceIndex The subresource to read
+            \param[in] callback Optional. Will be called with the data once the GPU finished the copy
+            \return A request which can be used to poll or wait for the data
+        */
+        ReadbackRequest::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const ReadbackRequest::Callback& callback = nullptr);
+
+        /** Record a copy of a buffer region into a staging buffer. Doesn't block
+            \param[in] pBuffer The buffer to read
+            \param[in] offset Offset in bytes from the start of the buffer
+            \param[in] numBytes Number of bytes to read. 0 means read until the end of the buffer
+            \param[in] callback Optional. Will be called with the data once the GPU finished the copy
+            \return A request which can be used to poll or wait for the data, or nullptr if the offset and size are invalid
+        */
+        ReadbackRequest::SharedPtr asyncReadBuffer(const Buffer* pBuffer, size_t offset = 0, size_t numBytes = 0, const ReadbackRequest::Callback& callback = nullptr);
+
+        /** Resolve the readback requests the GPU finished executing and invoke their callbacks. The device calls this once a frame
+        */
+        void processReadbacks();
+
         /** Reset
         */
         virtual void reset();
@@ -94,8 +124,10 @@ namespace Falcor
 #endif
     protected:
         void bindDescriptorHeaps();
+        ReadbackHeap* getReadbackHeap();
         CopyContext() = default;
         bool mCommandsPending = false;
+        ReadbackHeap::SharedPtr mpReadbackHeap;
 #ifdef FALCOR_LOW_LEVEL_API
         LowLevelContextData::SharedPtr mpLowLevelData;
 #endif
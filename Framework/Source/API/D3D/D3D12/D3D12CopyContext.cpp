@@ -32,6 +32,7 @@
 #include <queue>
 #include "D3D12Resource.h"
 #include "LowLevel/D3D12DescriptorData.h"
+#include "Utils/FrameTelemetry.h"
 
 namespace Falcor
 {
@@ -88,9 +89,10 @@ namespace Falcor
         std::vector<uint64_t> rowSize(subresourceCount);
         uint64_t size;
         pDevice->GetCopyableFootprints(&texDesc, firstSubresource, subresourceCount, 0, footprint.data(), rowCount.data(), rowSize.data(), &size);
+        gFrameCounters.uploadBytes += size;
 
         // Allocate a buffer on the upload heap
-        Buffer::SharedPtr pBuffer = Buffer::create(size, Buffer::BindFlags::None, Buffer::CpuAccess::Write, nullptr);
+        Buffer::SharedPtr pBuffer = Buffer::createTransient(size, Buffer::BindFlags::None);
         // Map the buffer
         uint8_t* pDst = (uint8_t*)pBuffer->map(Buffer::MapType::WriteDiscard);
         ID3D12ResourcePtr pResource = pBuffer->getApiHandle();
@@ -129,7 +131,41 @@ namespace Falcor
         updateTextureSubresources(pTexture, subresourceIndex, 1, pData);
     }
 
-    std::vector<uint8> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    void CopyContext::updateTextureRegion(const Texture* pTexture, uint32_t subresourceIndex, const uvec2& offset, const uvec2& size, const void* pData)
+    {
+        const ResourceFormat format = pTexture->getFormat();
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+        assert(offset.x % blockWidth == 0 && offset.y % blockHeight == 0 && size.x % blockWidth == 0 && size.y % blockHeight == 0);
+        mCommandsPending = true;
+
+        // Describe the rectangle as a placed footprint in an upload buffer
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+        footprint.Footprint.Format = getDxgiFormat(format);
+        footprint.Footprint.Width = size.x;
+        footprint.Footprint.Height = size.y;
+        footprint.Footprint.Depth = 1;
+        const uint32_t rowCount = size.y / blockHeight;
+        const uint32_t rowSize = (size.x / blockWidth) * getFormatBytesPerBlock(format);
+        footprint.Footprint.RowPitch = align_to(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, rowSize);
+
+        Buffer::SharedPtr pBuffer = Buffer::createTransient(footprint.Footprint.RowPitch * rowCount, Buffer::BindFlags::None);
+        gFrameCounters.uploadBytes += rowSize * rowCount;
+        uint8_t* pDst = (uint8_t*)pBuffer->map(Buffer::MapType::WriteDiscard);
+        for (uint32_t row = 0; row < rowCount; row++)
+        {
+            memcpy(pDst + row * footprint.Footprint.RowPitch, (const uint8_t*)pData + row * rowSize, rowSize);
+        }
+        pBuffer->unmap();
+        footprint.Offset = pBuffer->getGpuAddressOffset();
+
+        resourceBarrier(pTexture, Resource::State::CopyDest);
+        D3D12_TEXTURE_COPY_LOCATION dstLoc = { pTexture->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, subresourceIndex };
+        D3D12_TEXTURE_COPY_LOCATION srcLoc = { pBuffer->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT, footprint };
+        mpLowLevelData->getCommandList()->CopyTextureRegion(&dstLoc, offset.x, offset.y, 0, &srcLoc, nullptr);
+    }
+
+    ReadbackRequest::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const ReadbackRequest::Callback& callback)
     {
         //Get footprint
         D3D12_RESOURCE_DESC texDesc = pTexture->getApiHandle()->GetDesc();
@@ -140,36 +176,23 @@ namespace Falcor
         ID3D12Device* pDevice = gpDevice->getApiHandle();
         pDevice->GetCopyableFootprints(&texDesc, subresourceIndex, 1, 0, &footprint, &rowCount, &rowSize, &size);
 
-        //Create buffer 
-        Buffer::SharedPtr pBuffer = Buffer::create(size, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+        // Get a buffer from the readback heap
+        Buffer::SharedPtr pStaging = getReadbackHeap()->acquireStagingBuffer(size);
 
         //Copy from texture to buffer
         D3D12_TEXTURE_COPY_LOCATION srcLoc = { pTexture->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, subresourceIndex };
-        D3D12_TEXTURE_COPY_LOCATION dstLoc = { pBuffer->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT, footprint };
+        D3D12_TEXTURE_COPY_LOCATION dstLoc = { pStaging->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT, footprint };
         resourceBarrier(pTexture, Resource::State::CopySource);
         mpLowLevelData->getCommandList()->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, nullptr);
-        flush(true);
-
-        //Get buffer data
-        std::vector<uint8> result;
-		uint32_t actualRowSize = footprint.Footprint.Width * getFormatBytesPerBlock(pTexture->getFormat());
-        result.resize(rowCount * actualRowSize);
-        uint8* pData = reinterpret_cast<uint8*>(pBuffer->map(Buffer::MapType::Read));
-
-        for(uint32_t z = 0 ; z < footprint.Footprint.Depth ; z++)
-        {
-            const uint8_t* pSrcZ = pData + z * footprint.Footprint.RowPitch * rowCount;
-            uint8_t* pDstZ = result.data() + z * actualRowSize * rowCount;
-            for (uint32_t y = 0; y < rowCount; y++)
-            {
-                const uint8_t* pSrc = pSrcZ + y *  footprint.Footprint.RowPitch;
-                uint8_t* pDst = pDstZ + y * actualRowSize;
-                memcpy(pDst, pSrc, actualRowSize);
-            }
-        }
+        mCommandsPending = true;
 
-        pBuffer->unmap();
-        return result;
+        ReadbackRequest::Layout layout;
+        layout.offset = footprint.Offset;
+        layout.rowSize = (uint32_t)rowSize;
+        layout.rowPitch = footprint.Footprint.RowPitch;
+        layout.rowCount = rowCount;
+        layout.depth = footprint.Footprint.Depth;
+        return getReadbackHeap()->createRequest(pStaging, layout, callback);
     }
     
     void CopyContext::resourceBarrier(const Resource* pResource, Resource::State newState)
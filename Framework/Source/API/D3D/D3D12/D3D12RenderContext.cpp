@@ -32,6 +32,7 @@
 #include "D3D12Resource.h"
 #include "API/D3D/D3DState.h"
 #include "API/DescriptorSet.h"
+#include "Utils/FrameTelemetry.h"
 
 namespace Falcor
 {
@@ -218,6 +219,7 @@ namespace Falcor
     void RenderContext::prepareForDraw()
     {
         assert(mpGraphicsState);
+        gFrameCounters.drawCalls++;
 
         // Apply the vars. Must be first because applyGraphicsVars() might cause a flush
         if (mpGraphicsVars)
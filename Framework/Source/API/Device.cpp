@@ -33,6 +33,11 @@
 namespace Falcor
 {
     Device::SharedPtr gpDevice;
+
+    // 64 pages of 2MB. Once the ring owns that many pages, allocations wait for the GPU instead of growing it
+    static const uint32_t kUploadRingMaxPageCount = 64;
+    // Number of frames a cached descriptor-set can go unused before it's evicted
+    static const uint32_t kDescSetCacheMaxIdleFrames = 60;
     
     Device::SharedPtr Device::create(Window::SharedPtr& pWindow, const Device::Desc& desc)
     {
@@ -65,6 +70,7 @@ namespace Falcor
         poolDesc.setDescCount(DescriptorPool::Type::StructuredBufferSrv, 2 * 1024).setDescCount(DescriptorPool::Type::StructuredBufferUav, 2 * 1024).setDescCount(DescriptorPool::Type::TypedBufferSrv, 2 * 1024).setDescCount(DescriptorPool::Type::TypedBufferUav, 2 * 1024);
 #endif
         mpGpuDescPool = DescriptorPool::create(poolDesc, mpRenderContext->getLowLevelData()->getFence());
+        mpDescSetCache = DescriptorSetCache::create(mpGpuDescPool, kDescSetCacheMaxIdleFrames);
         poolDesc.setShaderVisible(false).setDescCount(DescriptorPool::Type::Rtv, 16 * 1024).setDescCount(DescriptorPool::Type::Dsv, 1024);
         mpCpuDescPool = DescriptorPool::create(poolDesc, mpRenderContext->getLowLevelData()->getFence());
 
@@ -74,6 +80,7 @@ namespace Falcor
 
         // Create the swap-chain
         mpResourceAllocator = ResourceAllocator::create(1024 * 1024 * 2, mpRenderContext->getLowLevelData()->getFence());
+        mpUploadAllocator = UploadRingAllocator::create(1024 * 1024 * 2, kUploadRingMaxPageCount, mpRenderContext->getLowLevelData()->getFence());
         if (createSwapChain(desc.colorFormat) == false)
         {
             return false;
@@ -81,8 +88,10 @@ namespace Falcor
 
         mpFrameFence = GpuFence::create();
 
-        // Update the FBOs
-        if (updateDefaultFBO(mpWindow->getClientAreaWidth(), mpWindow->getClientAreaHeight(), desc.colorFormat, desc.depthFormat) == false)
+        // Update the FBOs. Headless devices use the size from the descriptor
+        uint32_t width = mpWindow ? mpWindow->getClientAreaWidth() : desc.headlessWidth;
+        uint32_t height = mpWindow ? mpWindow->getClientAreaHeight() : desc.headlessHeight;
+        if (updateDefaultFBO(width, height, desc.colorFormat, desc.depthFormat) == false)
         {
             return false;
         }
@@ -172,17 +181,22 @@ namespace Falcor
     void Device::cleanup()
     {
         mpRenderContext->flush(true);
+        // Invoke the callbacks of the readbacks which are still in flight
+        mpRenderContext->processReadbacks();
         // Release all the bound resources. Need to do that before deleting the RenderContext
         mpRenderContext->setGraphicsState(nullptr);
         mpRenderContext->setGraphicsVars(nullptr);
         mpRenderContext->setComputeState(nullptr);
         mpRenderContext->setComputeVars(nullptr);
+        // The cache keeps views and samplers alive, release them while the device is still fully functional
+        mpDescSetCache.reset();
 
         for (uint32_t i = 0; i < arraysize(mCmdQueues); i++) mCmdQueues[i].clear();
         for (uint32_t i = 0; i < arraysize(mpSwapChainFbos); i++) mpSwapChainFbos[i].reset();
         mDeferredReleases = decltype(mDeferredReleases)();
 
         mpRenderContext.reset();
+        mpUploadAllocator.reset();
         mpResourceAllocator.reset();
         mpCpuDescPool.reset();
         mpGpuDescPool.reset();
@@ -198,7 +212,10 @@ namespace Falcor
         mpRenderContext->flush();
         apiPresent();
         mpFrameFence->gpuSignal(mpRenderContext->getLowLevelData()->getCommandQueue());
+        mpUploadAllocator->endFrame();
+        mpDescSetCache->endFrame();
         executeDeferredReleases();
+        mpRenderContext->processReadbacks();
         mpRenderContext->reset();
         mFrameID++;
     }
@@ -32,6 +32,8 @@
 #include "API/RenderContext.h"
 #include "API/LowLevel/DescriptorPool.h"
 #include "API/LowLevel/ResourceAllocator.h"
+#include "API/LowLevel/UploadRingAllocator.h"
+#include "API/LowLevel/DescriptorSetCache.h"
 #include "API/QueryHeap.h"
 
 namespace Falcor
@@ -65,6 +67,8 @@ namespace Falcor
             bool enableVsync = false;                                       ///< Controls vertical-sync
             bool enableDebugLayer = DEFAULT_ENABLE_DEBUG_LAYER;             ///< Enable the debug layer. The default for release build is false, for debug build it's true.
             bool enableVR = false;                                          ///< Create a device matching OpenVR requirements
+            uint32_t headlessWidth = 1920;                                  ///< Back-buffer width when the device is created without a window (null backend only)
+            uint32_t headlessHeight = 1080;                                 ///< Back-buffer height when the device is created without a window (null backend only)
 
             static_assert((uint32_t)LowLevelContextData::CommandQueueType::Direct == 2, "Default initialization of cmdQueues assumes that Direct queue index is 0");
             uint32_t cmdQueues[kQueueTypeCount] = { 0, 0, 1 };  ///< Command queues to create. If not direct-queues are created, mpRenderContext will not be initialized
@@ -78,7 +82,7 @@ namespace Falcor
         };
 
         /** Create a new device.
-        \param[in] pWindow a previously-created window object
+        \param[in] pWindow a previously-created window object. The null backend also accepts nullptr, in which case the swap-chain size is taken from the descriptor
         \param[in] desc Device configuration descriptor.
         \return nullptr if the function failed, otherwise a new device object
         */
@@ -138,7 +142,9 @@ namespace Falcor
 
         DescriptorPool::SharedPtr getCpuDescriptorPool() const { return mpCpuDescPool; }
         DescriptorPool::SharedPtr getGpuDescriptorPool() const { return mpGpuDescPool; }
+        DescriptorSetCache::SharedPtr getDescriptorSetCache() const { return mpDescSetCache; }
         ResourceAllocator::SharedPtr getResourceAllocator() const { return mpResourceAllocator; }
+        UploadRingAllocator::SharedPtr getUploadAllocator() const { return mpUploadAllocator; }
         QueryHeap::SharedPtr getTimestampQueryHeap() const { return mTimestampQueryHeap; }
         void releaseResource(ApiObjectHandle pResource);
         double getGpuTimestampFrequency() const { return mGpuTimestampFrequency; } // ms/tick
@@ -173,8 +179,10 @@ namespace Falcor
 
         ApiHandle mApiHandle;
         ResourceAllocator::SharedPtr mpResourceAllocator;
+        UploadRingAllocator::SharedPtr mpUploadAllocator;
         DescriptorPool::SharedPtr mpCpuDescPool;
         DescriptorPool::SharedPtr mpGpuDescPool;
+        DescriptorSetCache::SharedPtr mpDescSetCache;
         bool mIsWindowOccluded = false;
         GpuFence::SharedPtr mpFrameFence;
 
@@ -0,0 +1,192 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/LowLevel/DescriptorSetCache.h"
+#include "Utils/Profiler.h"
+
+namespace Falcor
+{
+    static void hashCombine(size_t& seed, size_t value)
+    {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+
+    static size_t hashKey(const DescriptorSet::Layout& layout, const std::vector<std::shared_ptr<const void>>& objects)
+    {
+        size_t hash = std::hash<uint32_t>()((uint32_t)layout.getVisibility());
+        for (size_t i = 0; i < layout.getRangeCount(); i++)
+        {
+            const auto& range = layout.getRange(i);
+            hashCombine(hash, (size_t)range.type);
+            hashCombine(hash, range.baseRegIndex);
+            hashCombine(hash, range.descCount);
+            hashCombine(hash, range.regSpace);
+        }
+
+        for (const auto& pObj : objects)
+        {
+            hashCombine(hash, std::hash<const void*>()(pObj.get()));
+        }
+        return hash;
+    }
+
+    static bool isSameLayout(const DescriptorSet::Layout& a, const DescriptorSet::Layout& b)
+    {
+        if (a.getVisibility() != b.getVisibility() || a.getRangeCount() != b.getRangeCount()) return false;
+        for (size_t i = 0; i < a.getRangeCount(); i++)
+        {
+            const auto& ra = a.getRange(i);
+            const auto& rb = b.getRange(i);
+            if (ra.type != rb.type || ra.baseRegIndex != rb.baseRegIndex || ra.descCount != rb.descCount || ra.regSpace != rb.regSpace) return false;
+        }
+        return true;
+    }
+
+    static bool isSameObjects(const std::vector<std::shared_ptr<const void>>& a, const std::vector<std::shared_ptr<const void>>& b)
+    {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (a[i].get() != b[i].get()) return false;
+        }
+        return true;
+    }
+
+    void DescriptorSetCache::Key::reset(const DescriptorSet::Layout* pLayout)
+    {
+        mpLayout = pLayout;
+        mObjects.clear();
+        mCacheable = true;
+    }
+
+    void DescriptorSetCache::Key::addObject(const std::shared_ptr<const void>& pObject)
+    {
+        mObjects.push_back(pObject);
+    }
+
+    DescriptorSetCache::SharedPtr DescriptorSetCache::create(const DescriptorPool::SharedPtr& pPool, uint32_t maxIdleFrames)
+    {
+        return SharedPtr(new DescriptorSetCache(pPool, maxIdleFrames));
+    }
+
+    DescriptorSetCache::~DescriptorSetCache() = default;
+
+    DescriptorSet::SharedPtr DescriptorSetCache::createSet(const DescriptorSet::Layout& layout)
+    {
+        DescriptorSet::SharedPtr pSet = DescriptorSet::create(mpPool, layout);
+        if (pSet == nullptr && mEntries.size())
+        {
+            // The cache might be holding the descriptors we need. Drop it and try again
+            clear();
+            mpPool->executeDeferredReleases();
+            pSet = DescriptorSet::create(mpPool, layout);
+        }
+        return pSet;
+    }
+
+    DescriptorSet::SharedPtr DescriptorSetCache::getSet(Key& key, bool& isNew)
+    {
+        assert(key.mpLayout);
+        if (key.mCacheable == false)
+        {
+            mStats.uncacheableThisFrame++;
+            isNew = true;
+            return createSet(*key.mpLayout);
+        }
+
+        size_t hash = hashKey(*key.mpLayout, key.mObjects);
+        auto range = mEntries.equal_range(hash);
+        for (auto it = range.first; it != range.second; it++)
+        {
+            Entry& entry = it->second;
+            if (isSameObjects(entry.objects, key.mObjects) && isSameLayout(entry.layout, *key.mpLayout))
+            {
+                mStats.hitsThisFrame++;
+                entry.lastUsedFrame = mFrameIndex;
+                isNew = false;
+                return entry.pSet;
+            }
+        }
+
+        mStats.missesThisFrame++;
+        isNew = true;
+        DescriptorSet::SharedPtr pSet = createSet(*key.mpLayout);
+        if (pSet)
+        {
+            Entry entry;
+            entry.layout = *key.mpLayout;
+            entry.objects = std::move(key.mObjects);
+            entry.pSet = pSet;
+            entry.lastUsedFrame = mFrameIndex;
+            mEntries.emplace(hash, std::move(entry));
+            mStats.entryCount = (uint32_t)mEntries.size();
+        }
+        return pSet;
+    }
+
+    void DescriptorSetCache::endFrame()
+    {
+        // Evict the idle entries. Sets which are still referenced by a ProgramVars object stay alive until it lets go of them
+        for (auto it = mEntries.begin(); it != mEntries.end();)
+        {
+            if (mFrameIndex - it->second.lastUsedFrame > mMaxIdleFrames)
+            {
+                it = mEntries.erase(it);
+                mStats.evictions++;
+            }
+            else
+            {
+                it++;
+            }
+        }
+        mStats.entryCount = (uint32_t)mEntries.size();
+
+        mStats.hitsLastFrame = mStats.hitsThisFrame;
+        mStats.missesLastFrame = mStats.missesThisFrame;
+        mStats.uncacheableLastFrame = mStats.uncacheableThisFrame;
+        mStats.hitsThisFrame = 0;
+        mStats.missesThisFrame = 0;
+        mStats.uncacheableThisFrame = 0;
+        mFrameIndex++;
+
+        if (gProfileEnabled)
+        {
+            uint32_t requests = mStats.hitsLastFrame + mStats.missesLastFrame;
+            Profiler::reportValue("DescSetCache hit-rate(%)", requests ? 100.0 * mStats.hitsLastFrame / requests : 100.0);
+            Profiler::reportValue("DescSetCache new sets", mStats.missesLastFrame + mStats.uncacheableLastFrame);
+            Profiler::reportValue("DescSetCache entries", mStats.entryCount);
+        }
+    }
+
+    void DescriptorSetCache::clear()
+    {
+        mStats.evictions += mEntries.size();
+        mEntries.clear();
+        mStats.entryCount = 0;
+    }
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <unordered_map>
+#include "API/DescriptorSet.h"
+
+namespace Falcor
+{
+    /** Cache of descriptor-sets, keyed by the set's layout and the objects (views and samplers) written into it.
+        Sets handed out by the cache are never modified, so the same set can be shared by multiple ProgramVars and reused across frames.
+        Entries which were not used for a number of frames are evicted. The descriptors return to the pool once the GPU is done with them.
+    */
+    class DescriptorSetCache
+    {
+    public:
+        using SharedPtr = std::shared_ptr<DescriptorSetCache>;
+        using SharedConstPtr = std::shared_ptr<const DescriptorSetCache>;
+
+        /** The content of a descriptor-set
+        */
+        class Key
+        {
+        public:
+            /** Start a new key
+                \param[in] pLayout The layout of the set. The object must stay alive until the key is passed to DescriptorSetCache::getSet()
+            */
+            void reset(const DescriptorSet::Layout* pLayout);
+
+            /** Append the object which will be written into the next descriptor. The key keeps a reference to the object so that its address can't be reused while the key is alive
+            */
+            void addObject(const std::shared_ptr<const void>& pObject);
+
+            /** Mark the set as uncacheable. Use it for sets which contain descriptors whose content can change without the object changing, like constant-buffers
+            */
+            void setUncacheable() { mCacheable = false; }
+
+            bool isCacheable() const { return mCacheable; }
+            const DescriptorSet::Layout* getLayout() const { return mpLayout; }
+        private:
+            friend class DescriptorSetCache;
+            const DescriptorSet::Layout* mpLayout = nullptr;
+            std::vector<std::shared_ptr<const void>> mObjects;
+            bool mCacheable = true;
+        };
+
+        struct Stats
+        {
+            uint32_t hitsThisFrame = 0;         ///< Number of requests served from the cache since the last call to endFrame()
+            uint32_t missesThisFrame = 0;       ///< Number of cacheable sets created since the last call to endFrame()
+            uint32_t hitsLastFrame = 0;         ///< Number of requests served from the cache during the previous frame
+            uint32_t missesLastFrame = 0;       ///< Number of cacheable sets created during the previous frame
+            uint32_t uncacheableThisFrame = 0;  ///< Number of uncacheable sets created since the last call to endFrame()
+            uint32_t uncacheableLastFrame = 0;  ///< Number of uncacheable sets created during the previous frame
+            uint64_t evictions = 0;             ///< Total number of entries evicted
+            uint32_t entryCount = 0;            ///< Number of sets currently in the cache
+        };
+
+        /** Create a new cache
+            \param[in] pPool The pool to allocate the sets from
+            \param[in] maxIdleFrames Number of frames an entry can go unused before it's evicted
+        */
+        static SharedPtr create(const DescriptorPool::SharedPtr& pPool, uint32_t maxIdleFrames);
+        ~DescriptorSetCache();
+
+        /** Get a set matching the key. The objects in the key are moved into the cache.
+            \param[in] key The set content. Uncacheable keys always create a new set.
+            \param[out] isNew Set to true if a new set was created. The caller must write the descriptors into new sets, in the same order they were added to the key.
+            \return A descriptor-set, or nullptr if the pool ran out of descriptors
+        */
+        DescriptorSet::SharedPtr getSet(Key& key, bool& isNew);
+
+        /** Mark the end of a frame. Evicts the idle entries, rolls over the statistics and reports the hit-rate to the profiler
+        */
+        void endFrame();
+
+        /** Drop all the entries
+        */
+        void clear();
+
+        const Stats& getStats() const { return mStats; }
+    private:
+        DescriptorSetCache(const DescriptorPool::SharedPtr& pPool, uint32_t maxIdleFrames) : mpPool(pPool), mMaxIdleFrames(maxIdleFrames) {}
+
+        struct Entry
+        {
+            DescriptorSet::Layout layout;
+            std::vector<std::shared_ptr<const void>> objects;
+            DescriptorSet::SharedPtr pSet;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        DescriptorPool::SharedPtr mpPool;
+        uint32_t mMaxIdleFrames;
+        uint64_t mFrameIndex = 0;
+        std::unordered_multimap<size_t, Entry> mEntries;
+        Stats mStats;
+
+        DescriptorSet::SharedPtr createSet(const DescriptorSet::Layout& layout);
+    };
+}
@@ -63,6 +63,7 @@ namespace Falcor
         void executeDeferredReleases();
 
     private:
+        friend class UploadRingAllocator;
         ResourceAllocator(size_t pageSize, GpuFence::SharedPtr pFence) : mPageSize(pageSize), mpFence(pFence) {}
         struct PageData : public BaseData
         {
@@ -0,0 +1,121 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/LowLevel/UploadRingAllocator.h"
+
+namespace Falcor
+{
+    UploadRingAllocator::SharedPtr UploadRingAllocator::create(size_t pageSize, uint32_t maxPageCount, GpuFence::SharedPtr pFence)
+    {
+        assert(maxPageCount > 0);
+        SharedPtr pAllocator = SharedPtr(new UploadRingAllocator(pageSize, maxPageCount, pFence));
+        pAllocator->acquireNewPage();
+        return pAllocator;
+    }
+
+    UploadRingAllocator::~UploadRingAllocator() = default;
+
+    void UploadRingAllocator::acquireNewPage()
+    {
+        if (mActivePage.pResourceHandle)
+        {
+            // The page can be reused once the GPU is done with all the commands recorded so far
+            mRetiredPages.push({ mpFence->getCpuValue(), mActivePageId, mActivePage });
+            mActivePage = {};
+        }
+        mCurrentOffset = 0;
+        mActivePageId++;
+
+        if (mRetiredPages.size())
+        {
+            const RetiredPage& oldest = mRetiredPages.front();
+            bool gpuDone = oldest.fenceValue <= mpFence->getGpuValue();
+            // We can only wait for values which were already signaled. If the oldest page belongs to the commands which are still being recorded, we have to grow
+            bool canWait = oldest.fenceValue < mpFence->getCpuValue();
+            if (gpuDone || (mStats.pageCount >= mMaxPageCount && canWait))
+            {
+                if (gpuDone == false)
+                {
+                    mpFence->syncCpu();
+                    mStats.fenceStalls++;
+                }
+                mActivePage = oldest.data;
+                mRetiredPages.pop();
+                mOldestPageId = mRetiredPages.size() ? mRetiredPages.front().pageId : mActivePageId;
+                return;
+            }
+        }
+
+        ResourceAllocator::initBasePageData(mActivePage, mPageSize);
+        mStats.pageCount++;
+        mStats.peakPageCount = std::max(mStats.peakPageCount, mStats.pageCount);
+    }
+
+    ResourceAllocator::BaseData UploadRingAllocator::allocate(size_t size, size_t alignment)
+    {
+        mStats.bytesThisFrame += size;
+        mStats.allocationsThisFrame++;
+
+        ResourceAllocator::BaseData data;
+        if (size > mPageSize)
+        {
+            mStats.largeAllocations++;
+            ResourceAllocator::initBasePageData(data, size);
+            mRetiredLargeAllocations.push({ mpFence->getCpuValue(), 0, data });
+            return data;
+        }
+
+        size_t offset = align_to(alignment, mCurrentOffset);
+        if (offset + size > mPageSize)
+        {
+            acquireNewPage();
+            offset = 0;
+        }
+
+        data.pResourceHandle = mActivePage.pResourceHandle;
+        data.offset = mActivePage.offset + offset;
+        data.pData = mActivePage.pData + offset;
+        mCurrentOffset = offset + size;
+        return data;
+    }
+
+    void UploadRingAllocator::endFrame()
+    {
+        mStats.bytesLastFrame = mStats.bytesThisFrame;
+        mStats.allocationsLastFrame = mStats.allocationsThisFrame;
+        mStats.peakBytesPerFrame = std::max(mStats.peakBytesPerFrame, mStats.bytesThisFrame);
+        mStats.bytesThisFrame = 0;
+        mStats.allocationsThisFrame = 0;
+
+        uint64_t gpuVal = mpFence->getGpuValue();
+        while (mRetiredLargeAllocations.size() && mRetiredLargeAllocations.front().fenceValue <= gpuVal)
+        {
+            mRetiredLargeAllocations.pop();
+        }
+    }
+}
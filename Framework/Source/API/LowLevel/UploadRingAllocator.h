@@ -0,0 +1,117 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#ifdef FALCOR_LOW_LEVEL_API
+#include <queue>
+#include "GpuFence.h"
+#include "ResourceAllocator.h"
+
+namespace Falcor
+{
+    /** Linear allocator for transient upload data.
+        Allocations are bumped out of persistently mapped pages. There is no per-allocation release - a page is retired as a whole once it fills up, and recycled once the GPU passed the fence value it was retired with.
+        Use it only for data which is consumed by the GPU before the owning page is recycled, i.e. data which is rewritten every frame or consumed by a copy.
+    */
+    class UploadRingAllocator
+    {
+    public:
+        using SharedPtr = std::shared_ptr<UploadRingAllocator>;
+        using SharedConstPtr = std::shared_ptr<const UploadRingAllocator>;
+
+        /** Allocator statistics. The per-frame values are rolled over by endFrame()
+        */
+        struct Stats
+        {
+            size_t bytesThisFrame = 0;          ///< Bytes allocated since the last call to endFrame()
+            size_t bytesLastFrame = 0;          ///< Bytes allocated during the previous frame
+            size_t peakBytesPerFrame = 0;       ///< Largest number of bytes allocated in a single frame
+            uint32_t allocationsThisFrame = 0;  ///< Number of allocations since the last call to endFrame()
+            uint32_t allocationsLastFrame = 0;  ///< Number of allocations during the previous frame
+            uint32_t pageCount = 0;             ///< Number of pages currently owned by the allocator
+            uint32_t peakPageCount = 0;         ///< Largest number of pages the allocator owned at once
+            uint64_t fenceStalls = 0;           ///< Number of times the CPU had to wait for the GPU to retire a page
+            uint64_t largeAllocations = 0;      ///< Number of allocations larger than a page. Those are backed by a dedicated resource
+        };
+
+        /** Create a new allocator
+            \param[in] pageSize The size of each page in bytes
+            \param[in] maxPageCount The number of pages the allocator can own before allocate() waits for the GPU instead of creating a new page
+            \param[in] pFence The fence used to track the GPU progress. Must be signaled every time work is submitted
+        */
+        static SharedPtr create(size_t pageSize, uint32_t maxPageCount, GpuFence::SharedPtr pFence);
+        ~UploadRingAllocator();
+
+        /** Allocate memory. The memory stays valid until the GPU passes the current value of the fence
+            \param[in] size The size of the allocation in bytes
+            \param[in] alignment The required alignment of the allocation offset
+        */
+        ResourceAllocator::BaseData allocate(size_t size, size_t alignment = 1);
+
+        /** Get the ID of the page allocations which fit in a page come from. Every page acquisition gets a new, larger ID
+        */
+        uint64_t getActivePageId() const { return mActivePageId; }
+
+        /** Check if a page wasn't recycled since it was acquired. Pages are recycled in the order they were retired, so every ID from the oldest retired page on is alive
+            \param[in] pageId The value of getActivePageId() right after allocating from the page
+        */
+        bool isPageAlive(uint64_t pageId) const { return pageId >= mOldestPageId; }
+
+        /** Mark the end of a frame. Rolls over the per-frame statistics and releases the retired dedicated resources
+        */
+        void endFrame();
+
+        /** Get the statistics
+        */
+        const Stats& getStats() const { return mStats; }
+
+        size_t getPageSize() const { return mPageSize; }
+    private:
+        UploadRingAllocator(size_t pageSize, uint32_t maxPageCount, GpuFence::SharedPtr pFence) : mPageSize(pageSize), mMaxPageCount(maxPageCount), mpFence(pFence) {}
+
+        struct RetiredPage
+        {
+            uint64_t fenceValue;
+            uint64_t pageId;
+            ResourceAllocator::BaseData data;
+        };
+
+        size_t mPageSize;
+        uint32_t mMaxPageCount;
+        GpuFence::SharedPtr mpFence;
+        ResourceAllocator::BaseData mActivePage;
+        size_t mCurrentOffset = 0;
+        uint64_t mActivePageId = 0;
+        uint64_t mOldestPageId = 1;
+        std::queue<RetiredPage> mRetiredPages;
+        std::queue<RetiredPage> mRetiredLargeAllocations;
+        Stats mStats;
+
+        void acquireNewPage();
+    };
+}
+#endif // FALCOR_LOW_LEVEL_API
@@ -0,0 +1,112 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#define NOMINMAX
+#include "API/Formats.h"
+#include "API/Null/NullHandles.h"
+
+#ifndef FALCOR_NULL
+#define FALCOR_NULL
+#endif
+
+namespace Falcor
+{
+    class DescriptorSet;
+    /*!
+    *  \addtogroup Falcor
+    *  @{
+    */
+
+    /** The null backend implements the low-level API without talking to a GPU. Every call is validated and counted (see NullDeviceStats)
+        and resources are backed by system memory, which makes it possible to measure the CPU cost of building and submitting a frame.
+    */
+
+    using ApiObjectHandle = NullApiObject::SharedPtr;
+
+    using HeapCpuHandle = NullDescriptor*;
+    using HeapGpuHandle = NullDescriptor*;
+
+    class DescriptorHeapEntry;
+
+#ifdef _WIN32
+    using WindowHandle = HWND;
+#else
+    using WindowHandle = void*;
+#endif
+
+    using DeviceHandle = NullApiObject::SharedPtr;
+    using CommandListHandle = NullApiObject::SharedPtr;
+    using CommandQueueHandle = NullApiObject::SharedPtr;
+    using ApiCommandQueueType = uint32_t;
+    using CommandAllocatorHandle = NullApiObject::SharedPtr;
+    using CommandSignatureHandle = void*;
+    using FenceHandle = NullFence::SharedPtr;
+    using ResourceHandle = NullResource::SharedPtr;
+    using RtvHandle = std::shared_ptr<DescriptorSet>;
+    using DsvHandle = std::shared_ptr<DescriptorSet>;
+    using SrvHandle = std::shared_ptr<DescriptorSet>;
+    using SamplerHandle = std::shared_ptr<DescriptorSet>;
+    using UavHandle = std::shared_ptr<DescriptorSet>;
+    using CbvHandle = std::shared_ptr<DescriptorSet>;
+    using FboHandle = void*;
+    using GpuAddress = uint64_t;
+    using QueryHeapHandle = NullApiObject::SharedPtr;
+
+    using GraphicsStateHandle = NullApiObject::SharedPtr;
+    using ComputeStateHandle = NullApiObject::SharedPtr;
+    using ShaderHandle = NullApiObject::SharedPtr;
+    using RootSignatureHandle = NullApiObject::SharedPtr;
+    using DescriptorHeapHandle = NullApiObject::SharedPtr;
+
+    using VaoHandle = void*;
+    using VertexShaderHandle = void*;
+    using FragmentShaderHandle = void*;
+    using DomainShaderHandle = void*;
+    using HullShaderHandle = void*;
+    using GeometryShaderHandle = void*;
+    using ComputeShaderHandle = void*;
+    using ProgramHandle = void*;
+    using DepthStencilStateHandle = void*;
+    using RasterizerStateHandle = void*;
+    using BlendStateHandle = void*;
+    using DescriptorSetApiHandle = void*;
+
+    static const uint32_t kSwapChainBuffers = 3;
+
+    inline constexpr uint32_t getMaxViewportCount() { return 16; }
+
+    /** The null backend compiles shaders through the HLSL path so that the reflection data matches the D3D12 backend
+    */
+#define appendShaderExtension(_a)  _a ".hlsl"
+    /*! @} */
+}
+
+#define DEFAULT_API_MAJOR_VERSION 1
+#define DEFAULT_API_MINOR_VERSION 0
+
+#define UNSUPPORTED_IN_NULL(msg_) {Falcor::logWarning(msg_ + std::string(" is not supported by the null backend. Ignoring call."));}
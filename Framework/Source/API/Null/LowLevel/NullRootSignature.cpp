@@ -0,0 +1,145 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/LowLevel/RootSignature.h"
+#include "API/Device.h"
+
+namespace Falcor
+{
+    // The null backend follows the D3D12 root-signature layout rules, so that the CPU-side binding work matches what D3D12 does
+    static const uint32_t kMaxRootCostInDwords = 64;
+
+    bool RootSignature::apiInit()
+    {
+        mSizeInBytes = 0;
+        mElementByteOffset.resize(mDesc.mSets.size());
+
+        for (size_t i = 0; i < mDesc.mSets.size(); i++)
+        {
+            const auto& set = mDesc.mSets[i];
+            assert(set.getRangeCount() == 1);
+            // Root CBVs cost 2 DWORDs, descriptor-tables cost a single DWORD
+            uint32_t byteOffset = (set.getRangeCount() == 1 && set.getRange(0).type == DescType::Cbv) ? 8 : 4;
+            mElementByteOffset[i] = mSizeInBytes;
+            mSizeInBytes += byteOffset;
+        }
+
+        if (mSizeInBytes > sizeof(uint32_t) * kMaxRootCostInDwords)
+        {
+            logError("Root-signature cost is too high. Root-signatures are limited to 64 DWORDs, trying to create a signature with " + std::to_string(mSizeInBytes / sizeof(uint32_t)) + " DWORDs");
+            return false;
+        }
+
+        mApiHandle = std::make_shared<NullApiObject>();
+        return true;
+    }
+
+    ProgramReflection::ShaderAccess getRequiredShaderAccess(RootSignature::DescType type);
+
+    static uint32_t initializeBufferDescriptors(const ProgramReflection* pReflector, RootSignature::Desc& desc, ProgramReflection::BufferReflection::Type bufferType, RootSignature::DescType descType)
+    {
+        uint32_t cost = 0;
+        const auto& bufMap = pReflector->getBufferMap(bufferType);
+        for (const auto& buf : bufMap)
+        {
+            const ProgramReflection::BufferReflection* pBuffer = buf.second.get();
+            if (pBuffer->getShaderAccess() == getRequiredShaderAccess(descType))
+            {
+                RootSignature::DescriptorSetLayout descTable;
+                uint32_t count = buf.second->getArraySize() ? buf.second->getArraySize() : 1;
+                descTable.addRange(descType, pBuffer->getRegisterIndex(), count, pBuffer->getRegisterSpace());
+                cost += 1;
+                desc.addDescriptorSet(descTable);
+            }
+        }
+        return cost;
+    }
+
+    RootSignature::SharedPtr RootSignature::create(const ProgramReflection* pReflector)
+    {
+        uint32_t cost = 0;
+        RootSignature::Desc d;
+
+        cost += initializeBufferDescriptors(pReflector, d, ProgramReflection::BufferReflection::Type::Constant, RootSignature::DescType::Cbv);
+        cost += initializeBufferDescriptors(pReflector, d, ProgramReflection::BufferReflection::Type::Structured, RootSignature::DescType::StructuredBufferSrv);
+        cost += initializeBufferDescriptors(pReflector, d, ProgramReflection::BufferReflection::Type::Structured, RootSignature::DescType::StructuredBufferUav);
+
+        const ProgramReflection::ResourceMap& resMap = pReflector->getResourceMap();
+        for (auto& resIt : resMap)
+        {
+            const ProgramReflection::Resource& resource = resIt.second;
+            assert(resource.descOffset == 0);
+            RootSignature::DescType descType;
+            if (resource.type == ProgramReflection::Resource::ResourceType::Sampler)
+            {
+                descType = RootSignature::DescType::Sampler;
+            }
+            else
+            {
+                switch (resource.type)
+                {
+                case ProgramReflection::Resource::ResourceType::RawBuffer:
+                case ProgramReflection::Resource::ResourceType::Texture:
+                    descType = (resource.shaderAccess == ProgramReflection::ShaderAccess::ReadWrite) ? RootSignature::DescType::TextureUav : RootSignature::DescType::TextureSrv;
+                    break;
+                case ProgramReflection::Resource::ResourceType::StructuredBuffer:
+                    descType = (resource.shaderAccess == ProgramReflection::ShaderAccess::ReadWrite) ? RootSignature::DescType::StructuredBufferUav : RootSignature::DescType::StructuredBufferSrv;
+                    break;
+                case ProgramReflection::Resource::ResourceType::TypedBuffer:
+                    descType = (resource.shaderAccess == ProgramReflection::ShaderAccess::ReadWrite) ? RootSignature::DescType::TypedBufferUav : RootSignature::DescType::TypedBufferSrv;
+                    break;
+                default:
+                    should_not_get_here();
+                }
+            }
+
+            uint32_t count = resource.arraySize ? resource.arraySize : 1;
+            RootSignature::DescriptorSetLayout descTable;
+            descTable.addRange(descType, resource.regIndex, count, resource.regSpace);
+            d.addDescriptorSet(descTable);
+            cost += 1;
+        }
+
+        if (cost > kMaxRootCostInDwords)
+        {
+            logError("RootSignature::create(): The required storage cost is " + std::to_string(cost) + " DWORDS, which is larger then the max allowed cost of 64 DWORDS");
+            return nullptr;
+        }
+        return (cost != 0) ? RootSignature::create(d) : RootSignature::getEmpty();
+    }
+
+    void RootSignature::bindForCompute(CopyContext* pCtx)
+    {
+        gNullDeviceStats.rootSignatureBinds++;
+    }
+
+    void RootSignature::bindForGraphics(CopyContext* pCtx)
+    {
+        gNullDeviceStats.rootSignatureBinds++;
+    }
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/Buffer.h"
+#include "API/Device.h"
+#include "API/LowLevel/ResourceAllocator.h"
+
+namespace Falcor
+{
+    // Match the D3D12 placement rules so that the allocator behaves the same way
+    static const size_t kConstantBufferDataAlignment = 256;
+    static const size_t kTextureDataAlignment = 512;
+
+    NullResource::SharedPtr createNullBuffer(size_t size)
+    {
+        gNullDeviceStats.buffersCreated++;
+        return NullResource::create(size);
+    }
+
+    size_t getBufferDataAlignment(const Buffer* pBuffer)
+    {
+        switch (pBuffer->getBindFlags())
+        {
+        case Buffer::BindFlags::Constant:
+            return kConstantBufferDataAlignment;
+        case Buffer::BindFlags::None:
+            return kTextureDataAlignment;
+        default:
+            return 1;
+        }
+    }
+
+    void* mapBufferApi(const Buffer::ApiHandle& apiHandle, size_t size)
+    {
+        return apiHandle->getData();
+    }
+
+    bool Buffer::apiInit(bool hasInitData)
+    {
+        if (mBindFlags == BindFlags::Constant)
+        {
+            mSize = align_to(kConstantBufferDataAlignment, mSize);
+        }
+
+        if (mCpuAccess == CpuAccess::Write)
+        {
+            mState = Resource::State::GenericRead;
+            if (hasInitData == false) // Else the allocation will happen when updating the data
+            {
+                mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize, getBufferDataAlignment(this));
+                mApiHandle = mDynamicData.pResourceHandle;
+            }
+        }
+        else if (mCpuAccess == CpuAccess::Read && mBindFlags == BindFlags::None)
+        {
+            mState = Resource::State::CopyDest;
+            mApiHandle = createNullBuffer(mSize);
+        }
+        else
+        {
+            mState = Resource::State::Common;
+            mApiHandle = createNullBuffer(mSize);
+        }
+
+        return true;
+    }
+
+    uint64_t Buffer::getGpuAddress() const
+    {
+        return mDynamicData.offset + mApiHandle->getGpuAddress();
+    }
+
+    void Buffer::unmap()
+    {
+    }
+
+    uint64_t Buffer::makeResident(Buffer::GpuAccessFlags flags) const
+    {
+        UNSUPPORTED_IN_NULL("Buffer::makeResident()");
+        return 0;
+    }
+
+    void Buffer::evict() const
+    {
+        UNSUPPORTED_IN_NULL("Buffer::evict()");
+    }
+}
@@ -0,0 +1,208 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/CopyContext.h"
+#include "API/Device.h"
+#include "API/Buffer.h"
+#include "API/Texture.h"
+#include "Utils/FrameTelemetry.h"
+
+namespace Falcor
+{
+    size_t getNullSubresourceSize(const Texture* pTexture, uint32_t mipLevel);
+    size_t getNullSubresourceOffset(const Texture* pTexture, uint32_t subresourceIndex);
+
+    // The null device executes copies immediately when they are recorded. This keeps uploads and readbacks correct without a command-list
+
+    static uint8_t* getResourceData(const Resource* pResource)
+    {
+        uint8_t* pData = pResource->getApiHandle()->getData();
+        const Buffer* pBuffer = dynamic_cast<const Buffer*>(pResource);
+        if (pData && pBuffer)
+        {
+            // Dynamic buffers are sub-allocated from a ResourceAllocator page
+            pData += pBuffer->getGpuAddressOffset();
+        }
+        return pData;
+    }
+
+    static size_t getResourceSize(const Resource* pResource)
+    {
+        const Buffer* pBuffer = dynamic_cast<const Buffer*>(pResource);
+        return pBuffer ? pBuffer->getSize() : pResource->getApiHandle()->getSize();
+    }
+
+    static void recordCopy(const Resource* pDst, const Resource* pSrc, size_t bytes)
+    {
+        const Buffer* pSrcBuffer = dynamic_cast<const Buffer*>(pSrc);
+        const Buffer* pDstBuffer = dynamic_cast<const Buffer*>(pDst);
+
+        gNullDeviceStats.copyCalls++;
+        if (pSrcBuffer && pSrcBuffer->getCpuAccess() == Buffer::CpuAccess::Write)
+        {
+            gNullDeviceStats.bytesUploaded += bytes;
+        }
+        else if (pDstBuffer && pDstBuffer->getCpuAccess() == Buffer::CpuAccess::Read)
+        {
+            gNullDeviceStats.bytesReadBack += bytes;
+        }
+        else
+        {
+            gNullDeviceStats.bytesCopied += bytes;
+        }
+    }
+
+    static void copyData(const Resource* pDst, size_t dstOffset, const Resource* pSrc, size_t srcOffset, size_t bytes)
+    {
+        uint8_t* pDstData = getResourceData(pDst);
+        const uint8_t* pSrcData = getResourceData(pSrc);
+        if (pDstData && pSrcData && bytes)
+        {
+            memcpy(pDstData + dstOffset, pSrcData + srcOffset, bytes);
+        }
+        recordCopy(pDst, pSrc, bytes);
+    }
+
+    void CopyContext::bindDescriptorHeaps()
+    {
+    }
+
+    void CopyContext::updateTextureSubresources(const Texture* pTexture, uint32_t firstSubresource, uint32_t subresourceCount, const void* pData)
+    {
+        mCommandsPending = true;
+        const uint8_t* pSubResData = (uint8_t*)pData;
+        for (uint32_t i = 0; i < subresourceCount; i++)
+        {
+            uint32_t subresource = i + firstSubresource;
+            updateTextureSubresource(pTexture, subresource, pSubResData);
+            pSubResData += getNullSubresourceSize(pTexture, pTexture->getSubresourceMipLevel(subresource));
+        }
+    }
+
+    void CopyContext::updateTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const void* pData)
+    {
+        mCommandsPending = true;
+        size_t dataSize = getNullSubresourceSize(pTexture, pTexture->getSubresourceMipLevel(subresourceIndex));
+        gFrameCounters.uploadBytes += dataSize;
+
+        // Go through an upload buffer like the other backends do, so that the allocator cost shows up in measurements
+        Buffer::SharedPtr pStaging = Buffer::createTransient(dataSize, Buffer::BindFlags::None, pData);
+        resourceBarrier(pTexture, Resource::State::CopyDest);
+        copyData(pTexture, getNullSubresourceOffset(pTexture, subresourceIndex), pStaging.get(), 0, dataSize);
+    }
+
+    void CopyContext::updateTextureRegion(const Texture* pTexture, uint32_t subresourceIndex, const uvec2& offset, const uvec2& size, const void* pData)
+    {
+        const ResourceFormat format = pTexture->getFormat();
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+        assert(offset.x % blockWidth == 0 && offset.y % blockHeight == 0 && size.x % blockWidth == 0 && size.y % blockHeight == 0);
+        mCommandsPending = true;
+
+        // Subresources are tightly packed, see getNullSubresourceSize()
+        const uint32_t mipLevel = pTexture->getSubresourceMipLevel(subresourceIndex);
+        const uint32_t bytesPerBlock = getFormatBytesPerBlock(format);
+        const size_t dstRowPitch = (size_t)(align_to(blockWidth, pTexture->getWidth(mipLevel)) / blockWidth) * bytesPerBlock;
+        const uint32_t rowCount = size.y / blockHeight;
+        const size_t rowSize = (size_t)(size.x / blockWidth) * bytesPerBlock;
+        gFrameCounters.uploadBytes += rowSize * rowCount;
+
+        Buffer::SharedPtr pStaging = Buffer::createTransient(rowSize * rowCount, Buffer::BindFlags::None, pData);
+        resourceBarrier(pTexture, Resource::State::CopyDest);
+        uint8_t* pDstData = getResourceData(pTexture);
+        const uint8_t* pSrcData = getResourceData(pStaging.get());
+        if (pDstData && pSrcData)
+        {
+            pDstData += getNullSubresourceOffset(pTexture, subresourceIndex) + (offset.y / blockHeight) * dstRowPitch + (offset.x / blockWidth) * bytesPerBlock;
+            for (uint32_t row = 0; row < rowCount; row++)
+            {
+                memcpy(pDstData + row * dstRowPitch, pSrcData + row * rowSize, rowSize);
+            }
+        }
+        recordCopy(pTexture, pStaging.get(), rowSize * rowCount);
+    }
+
+    ReadbackRequest::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const ReadbackRequest::Callback& callback)
+    {
+        mCommandsPending = true;
+        size_t dataSize = getNullSubresourceSize(pTexture, pTexture->getSubresourceMipLevel(subresourceIndex));
+        Buffer::SharedPtr pStaging = getReadbackHeap()->acquireStagingBuffer(dataSize);
+
+        resourceBarrier(pTexture, Resource::State::CopySource);
+        copyData(pStaging.get(), 0, pTexture, getNullSubresourceOffset(pTexture, subresourceIndex), dataSize);
+
+        // The data is tightly packed
+        ReadbackRequest::Layout layout;
+        layout.rowSize = (uint32_t)dataSize;
+        layout.rowPitch = (uint32_t)dataSize;
+        return getReadbackHeap()->createRequest(pStaging, layout, callback);
+    }
+
+    void CopyContext::resourceBarrier(const Resource* pResource, Resource::State newState)
+    {
+        // If the resource is a buffer with CPU access, no need to do anything
+        const Buffer* pBuffer = dynamic_cast<const Buffer*>(pResource);
+        if (pBuffer && pBuffer->getCpuAccess() != Buffer::CpuAccess::None) return;
+
+        if (pResource->getState() != newState)
+        {
+            gNullDeviceStats.resourceBarriers++;
+            mCommandsPending = true;
+            pResource->mState = newState;
+        }
+    }
+
+    void CopyContext::copyResource(const Resource* pDst, const Resource* pSrc)
+    {
+        resourceBarrier(pDst, Resource::State::CopyDest);
+        resourceBarrier(pSrc, Resource::State::CopySource);
+        copyData(pDst, 0, pSrc, 0, std::min(getResourceSize(pDst), getResourceSize(pSrc)));
+        mCommandsPending = true;
+    }
+
+    void CopyContext::copySubresource(const Texture* pDst, uint32_t dstSubresourceIdx, const Texture* pSrc, uint32_t srcSubresourceIdx)
+    {
+        resourceBarrier(pDst, Resource::State::CopyDest);
+        resourceBarrier(pSrc, Resource::State::CopySource);
+
+        size_t dstSize = getNullSubresourceSize(pDst, pDst->getSubresourceMipLevel(dstSubresourceIdx));
+        size_t srcSize = getNullSubresourceSize(pSrc, pSrc->getSubresourceMipLevel(srcSubresourceIdx));
+        assert(dstSize == srcSize);
+        copyData(pDst, getNullSubresourceOffset(pDst, dstSubresourceIdx), pSrc, getNullSubresourceOffset(pSrc, srcSubresourceIdx), std::min(dstSize, srcSize));
+        mCommandsPending = true;
+    }
+
+    void CopyContext::copyBufferRegion(const Buffer* pDst, uint64_t dstOffset, const Buffer* pSrc, uint64_t srcOffset, uint64_t numBytes)
+    {
+        resourceBarrier(pDst, Resource::State::CopyDest);
+        resourceBarrier(pSrc, Resource::State::CopySource);
+        assert(dstOffset + numBytes <= pDst->getSize() && srcOffset + numBytes <= pSrc->getSize());
+        copyData(pDst, dstOffset, pSrc, srcOffset, numBytes);
+        mCommandsPending = true;
+    }
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/Device.h"
+
+namespace Falcor
+{
+    struct DeviceApiData
+    {
+    };
+
+    CommandQueueHandle Device::getCommandQueueHandle(LowLevelContextData::CommandQueueType type, uint32_t index) const
+    {
+        return mCmdQueues[(uint32_t)type][index];
+    }
+
+    ApiCommandQueueType Device::getApiCommandQueueType(LowLevelContextData::CommandQueueType type) const
+    {
+        return (ApiCommandQueueType)type;
+    }
+
+    bool Device::getApiFboData(uint32_t width, uint32_t height, ResourceFormat colorFormat, ResourceFormat depthFormat, std::vector<ResourceHandle>& apiHandles, uint32_t& currentBackBufferIndex)
+    {
+        // The swap-chain images are regular resources, so the back-buffer can be read back like any other texture
+        size_t size = (size_t)width * height * getFormatBytesPerBlock(colorFormat);
+        for (uint32_t i = 0; i < kSwapChainBuffers; i++)
+        {
+            apiHandles[i] = NullResource::create(size);
+            gNullDeviceStats.texturesCreated++;
+        }
+        currentBackBufferIndex = 0;
+        return true;
+    }
+
+    void Device::destroyApiObjects()
+    {
+        safe_delete(mpApiData);
+        mpWindow.reset();
+    }
+
+    void Device::apiPresent()
+    {
+        gNullDeviceStats.presents++;
+        mCurrentBackBufferIndex = (mCurrentBackBufferIndex + 1) % kSwapChainBuffers;
+    }
+
+    bool Device::apiInit(const Desc& desc)
+    {
+        mpApiData = new DeviceApiData;
+        mApiHandle = std::make_shared<NullApiObject>();
+
+        for (uint32_t i = 0; i < kQueueTypeCount; i++)
+        {
+            for (uint32_t j = 0; j < desc.cmdQueues[i]; j++)
+            {
+                mCmdQueues[i].push_back(std::make_shared<NullApiObject>());
+            }
+        }
+
+        // A 1GHz timestamp counter. GpuTimer always returns 0 ticks, but the frequency still needs to be valid
+        mGpuTimestampFrequency = 1.0e-6;
+        return true;
+    }
+
+    bool Device::createSwapChain(ResourceFormat colorFormat)
+    {
+        return true;
+    }
+
+    void Device::apiResizeSwapChain(uint32_t width, uint32_t height, ResourceFormat colorFormat)
+    {
+    }
+
+    bool Device::isWindowOccluded() const
+    {
+        return false;
+    }
+
+    bool Device::isExtensionSupported(const std::string& name) const
+    {
+        return false;
+    }
+}
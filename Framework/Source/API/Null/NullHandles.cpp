@@ -0,0 +1,84 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/Null/NullHandles.h"
+
+namespace Falcor
+{
+    NullDeviceStats gNullDeviceStats;
+
+    // Start at a non-zero address so that a valid resource never reports a null GPU address
+    static const uint64_t kGpuAddressAlignment = 64 * 1024;
+    static uint64_t sNextGpuAddress = kGpuAddressAlignment;
+
+    NullResource::SharedPtr NullResource::create(size_t size)
+    {
+        SharedPtr pResource = SharedPtr(new NullResource(size, sNextGpuAddress));
+        uint64_t range = std::max(size, (size_t)1);
+        sNextGpuAddress += align_to(kGpuAddressAlignment, range);
+        gNullDeviceStats.bytesAllocated += size;
+        return pResource;
+    }
+
+    NullResource::~NullResource() = default;
+
+    uint8_t* NullResource::getData()
+    {
+        if (mSize == 0) return nullptr;
+        if (mData.empty())
+        {
+            mData.resize(mSize, 0);
+        }
+        return mData.data();
+    }
+
+    std::string NullDeviceStats::toString() const
+    {
+        std::string s;
+        s += "Draws: " + std::to_string(drawCalls) + "\n";
+        s += "Dispatches: " + std::to_string(dispatchCalls) + "\n";
+        s += "Clears: " + std::to_string(clearCalls) + "\n";
+        s += "Copies: " + std::to_string(copyCalls) + "\n";
+        s += "Resource barriers: " + std::to_string(resourceBarriers) + "\n";
+        s += "Root-signature binds: " + std::to_string(rootSignatureBinds) + "\n";
+        s += "Descriptor-table binds: " + std::to_string(descriptorTableBinds) + "\n";
+        s += "Root CBV binds: " + std::to_string(rootCbvBinds) + "\n";
+        s += "Pipeline-state binds: " + std::to_string(pipelineStateBinds) + "\n";
+        s += "Pipeline-states created: " + std::to_string(pipelineStatesCreated) + "\n";
+        s += "Descriptor writes: " + std::to_string(descriptorWrites) + "\n";
+        s += "Command-list submits: " + std::to_string(commandListSubmits) + "\n";
+        s += "Presents: " + std::to_string(presents) + "\n";
+        s += "Buffers created: " + std::to_string(buffersCreated) + "\n";
+        s += "Textures created: " + std::to_string(texturesCreated) + "\n";
+        s += "Bytes allocated: " + std::to_string(bytesAllocated) + "\n";
+        s += "Bytes uploaded: " + std::to_string(bytesUploaded) + "\n";
+        s += "Bytes copied: " + std::to_string(bytesCopied) + "\n";
+        s += "Bytes read back: " + std::to_string(bytesReadBack) + "\n";
+        return s;
+    }
+}
@@ -0,0 +1,130 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Base class of all the objects the null backend returns as API handles
+    */
+    class NullApiObject
+    {
+    public:
+        using SharedPtr = std::shared_ptr<NullApiObject>;
+        virtual ~NullApiObject() = default;
+    };
+
+    /** A buffer or texture allocation. The memory is allocated on first access, so resources which are never read or written by the CPU
+        (render-targets, for example) don't consume system memory.
+    */
+    class NullResource : public NullApiObject
+    {
+    public:
+        using SharedPtr = std::shared_ptr<NullResource>;
+
+        /** Create a new resource
+            \param[in] size The size of the resource in bytes
+        */
+        static SharedPtr create(size_t size);
+        ~NullResource();
+
+        /** Get the size of the resource in bytes
+        */
+        size_t getSize() const { return mSize; }
+
+        /** Get a pointer to the resource memory. Returns nullptr for empty resources
+        */
+        uint8_t* getData();
+
+        /** Get a fake GPU virtual address. Each resource gets a unique, non-overlapping range
+        */
+        uint64_t getGpuAddress() const { return mGpuAddress; }
+    private:
+        NullResource(size_t size, uint64_t gpuAddress) : mSize(size), mGpuAddress(gpuAddress) {}
+        size_t mSize;
+        uint64_t mGpuAddress;
+        std::vector<uint8_t> mData;
+    };
+
+    /** The null-backend fence. The 'GPU' finishes its work immediately, so signaling the fence also completes it
+    */
+    class NullFence : public NullApiObject
+    {
+    public:
+        using SharedPtr = std::shared_ptr<NullFence>;
+        static SharedPtr create() { return SharedPtr(new NullFence()); }
+        uint64_t completedValue = 0;
+    private:
+        NullFence() = default;
+    };
+
+    /** A descriptor is just a pointer to the object it references
+    */
+    struct NullDescriptor
+    {
+        const void* pObject = nullptr;
+    };
+
+    /** Counters which are updated by the null backend. Use these to measure how much work the CPU generates per frame.
+        The counters are never reset by the backend, call reset() at the start of the range you'd like to measure.
+    */
+    struct NullDeviceStats
+    {
+        uint64_t drawCalls = 0;                 ///< Draw calls, including indirect draws
+        uint64_t dispatchCalls = 0;             ///< Compute dispatches, including indirect dispatches
+        uint64_t clearCalls = 0;                ///< RTV, DSV and UAV clears
+        uint64_t copyCalls = 0;                 ///< Resource, subresource and buffer-region copies, including uploads and readbacks
+        uint64_t resourceBarriers = 0;          ///< State transitions
+        uint64_t rootSignatureBinds = 0;        ///< Root-signature binds
+        uint64_t descriptorTableBinds = 0;      ///< Descriptor-set binds
+        uint64_t rootCbvBinds = 0;              ///< Constant-buffers bound directly into the root-signature
+        uint64_t pipelineStateBinds = 0;        ///< Graphics and compute state-object binds
+        uint64_t pipelineStatesCreated = 0;     ///< Graphics and compute state-object creations
+        uint64_t descriptorWrites = 0;          ///< Descriptors written into a descriptor-set
+        uint64_t commandListSubmits = 0;        ///< Command-lists submitted to a queue
+        uint64_t presents = 0;                  ///< Swap-chain presents
+        uint64_t buffersCreated = 0;            ///< Buffers created, including pages allocated by the ResourceAllocator
+        uint64_t texturesCreated = 0;           ///< Textures created, including the swap-chain images
+        uint64_t bytesAllocated = 0;            ///< Total size of the buffers and textures created
+        uint64_t bytesUploaded = 0;             ///< Bytes copied from CPU-writable buffers into GPU resources
+        uint64_t bytesCopied = 0;               ///< Bytes copied between GPU resources
+        uint64_t bytesReadBack = 0;             ///< Bytes copied into CPU-readable buffers
+
+        /** Reset all the counters
+        */
+        void reset() { *this = NullDeviceStats(); }
+
+        /** Get a human-readable summary of the counters
+        */
+        std::string toString() const;
+    };
+
+    extern NullDeviceStats gNullDeviceStats;
+}
@@ -0,0 +1,311 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/RenderContext.h"
+#include "API/Device.h"
+#include "API/DescriptorSet.h"
+#include "Utils/FrameTelemetry.h"
+
+namespace Falcor
+{
+    struct BlitData
+    {
+        FullScreenPass::UniquePtr pPass;
+        GraphicsVars::SharedPtr pVars;
+        GraphicsState::SharedPtr pState;
+
+        Sampler::SharedPtr pLinearSampler;
+        Sampler::SharedPtr pPointSampler;
+
+        ConstantBuffer::SharedPtr pSrcRectBuffer;
+        vec2 prevSrcRectOffset;
+        vec2 prevSrcReftScale;
+
+        // Variable offsets in constant buffer
+        size_t offsetVarOffset;
+        size_t scaleVarOffset;
+    };
+
+    static BlitData gBlitData;
+    static void initBlitData()
+    {
+        if (gBlitData.pVars == nullptr)
+        {
+            gBlitData.pPass = FullScreenPass::create("Framework/Shaders/Blit.vs.slang", "Framework/Shaders/Blit.ps.slang");
+            gBlitData.pVars = GraphicsVars::create(gBlitData.pPass->getProgram()->getActiveVersion()->getReflector());
+            gBlitData.pState = GraphicsState::create();
+
+            gBlitData.pSrcRectBuffer = gBlitData.pVars->getConstantBuffer("SrcRectCB");
+            gBlitData.offsetVarOffset = (uint32_t)gBlitData.pSrcRectBuffer->getVariableOffset("gOffset");
+            gBlitData.scaleVarOffset = (uint32_t)gBlitData.pSrcRectBuffer->getVariableOffset("gScale");
+            gBlitData.prevSrcRectOffset = vec2(-1.0f);
+            gBlitData.prevSrcReftScale = vec2(-1.0f);
+
+            Sampler::Desc desc;
+            desc.setFilterMode(Sampler::Filter::Linear, Sampler::Filter::Linear, Sampler::Filter::Point).setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp);
+            gBlitData.pLinearSampler = Sampler::create(desc);
+            desc.setFilterMode(Sampler::Filter::Point, Sampler::Filter::Point, Sampler::Filter::Point).setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp);
+            gBlitData.pPointSampler = Sampler::create(desc);
+            assert(gBlitData.pPass->getProgram()->getActiveVersion()->getReflector()->getResourceDesc("gTex")->regIndex == 0);
+        }
+    }
+
+    void releaseBlitData()
+    {
+        gBlitData.pSrcRectBuffer = nullptr;
+        gBlitData.pVars = nullptr;
+        gBlitData.pPass = nullptr;
+        gBlitData.pState = nullptr;
+    }
+
+    RenderContext::~RenderContext()
+    {
+        releaseBlitData();
+    }
+
+    RenderContext::SharedPtr RenderContext::create(CommandQueueHandle queue)
+    {
+        SharedPtr pCtx = SharedPtr(new RenderContext());
+        pCtx->mpLowLevelData = LowLevelContextData::create(LowLevelContextData::CommandQueueType::Direct, queue);
+        if (pCtx->mpLowLevelData == nullptr)
+        {
+            return nullptr;
+        }
+
+        if (spDrawCommandSig == nullptr)
+        {
+            initDrawCommandSignatures();
+        }
+
+        return pCtx;
+    }
+
+    void RenderContext::clearRtv(const RenderTargetView* pRtv, const glm::vec4& color)
+    {
+        resourceBarrier(pRtv->getResource(), Resource::State::RenderTarget);
+        gNullDeviceStats.clearCalls++;
+        mCommandsPending = true;
+    }
+
+    void RenderContext::clearDsv(const DepthStencilView* pDsv, float depth, uint8_t stencil, bool clearDepth, bool clearStencil)
+    {
+        resourceBarrier(pDsv->getResource(), Resource::State::DepthStencil);
+        gNullDeviceStats.clearCalls++;
+        mCommandsPending = true;
+    }
+
+    static void NullSetVao(RenderContext* pCtx, const Vao* pVao)
+    {
+        if (pVao)
+        {
+            for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+            {
+                const Buffer* pVB = pVao->getVertexBuffer(i).get();
+                if (pVB)
+                {
+                    pCtx->resourceBarrier(pVB, Resource::State::VertexBuffer);
+                }
+            }
+
+            const Buffer* pIB = pVao->getIndexBuffer().get();
+            if (pIB)
+            {
+                pCtx->resourceBarrier(pIB, Resource::State::IndexBuffer);
+            }
+        }
+    }
+
+    static void NullSetFbo(RenderContext* pCtx, const Fbo* pFbo)
+    {
+        if (pFbo)
+        {
+            for (uint32_t i = 0; i < Fbo::getMaxColorTargetCount(); i++)
+            {
+                Texture::SharedPtr pTexture = pFbo->getColorTexture(i);
+                if (pTexture)
+                {
+                    // Fetching the view matches the work the other backends do when building the RTV array
+                    pFbo->getRenderTargetView(i);
+                    pCtx->resourceBarrier(pTexture.get(), Resource::State::RenderTarget);
+                }
+            }
+
+            Texture::SharedPtr pTexture = pFbo->getDepthStencilTexture();
+            if (pTexture)
+            {
+                pFbo->getDepthStencilView();
+                pCtx->resourceBarrier(pTexture.get(), Resource::State::DepthStencil);
+            }
+        }
+    }
+
+    void RenderContext::prepareForDraw()
+    {
+        assert(mpGraphicsState);
+        gFrameCounters.drawCalls++;
+
+        // Apply the vars. Must be first because applyGraphicsVars() might cause a flush
+        if (mpGraphicsVars)
+        {
+            applyGraphicsVars();
+        }
+        else
+        {
+            RootSignature::getEmpty()->bindForGraphics(this);
+        }
+        mBindGraphicsRootSig = false;
+
+        NullSetVao(this, mpGraphicsState->getVao().get());
+        NullSetFbo(this, mpGraphicsState->getFbo().get());
+
+        // The GSO lookup is the expensive part, the bind itself is free
+        mpGraphicsState->getGSO(mpGraphicsVars.get());
+        gNullDeviceStats.pipelineStateBinds++;
+        mCommandsPending = true;
+    }
+
+    void RenderContext::drawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation)
+    {
+        prepareForDraw();
+        gNullDeviceStats.drawCalls++;
+    }
+
+    void RenderContext::draw(uint32_t vertexCount, uint32_t startVertexLocation)
+    {
+        drawInstanced(vertexCount, 1, startVertexLocation, 0);
+    }
+
+    void RenderContext::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+    {
+        prepareForDraw();
+        gNullDeviceStats.drawCalls++;
+    }
+
+    void RenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation)
+    {
+        drawIndexedInstanced(indexCount, 1, startIndexLocation, baseVertexLocation, 0);
+    }
+
+    void RenderContext::drawIndirect(const Buffer* argBuffer, uint64_t argBufferOffset)
+    {
+        prepareForDraw();
+        resourceBarrier(argBuffer, Resource::State::IndirectArg);
+        gNullDeviceStats.drawCalls++;
+    }
+
+    void RenderContext::drawIndexedIndirect(const Buffer* argBuffer, uint64_t argBufferOffset)
+    {
+        prepareForDraw();
+        resourceBarrier(argBuffer, Resource::State::IndirectArg);
+        gNullDeviceStats.drawCalls++;
+    }
+
+    void RenderContext::initDrawCommandSignatures()
+    {
+    }
+
+    void RenderContext::blit(ShaderResourceView::SharedPtr pSrc, RenderTargetView::SharedPtr pDst, const uvec4& srcRect, const uvec4& dstRect, Sampler::Filter filter)
+    {
+        initBlitData(); // This has to be here and can't be in the constructor. FullScreenPass will allocate some buffers which depends on the ResourceAllocator which depends on the fence inside the RenderContext. Dependencies are fun!
+        if (filter == Sampler::Filter::Linear)
+        {
+            gBlitData.pVars->setSampler(0, 0, 0, gBlitData.pLinearSampler);
+        }
+        else
+        {
+            gBlitData.pVars->setSampler(0, 0, 0, gBlitData.pPointSampler);
+        }
+
+        assert(pSrc->getViewInfo().arraySize == 1 && pSrc->getViewInfo().mipCount == 1);
+        assert(pDst->getViewInfo().arraySize == 1 && pDst->getViewInfo().mipCount == 1);
+
+        const Texture* pSrcTexture = dynamic_cast<const Texture*>(pSrc->getResource());
+        const Texture* pDstTexture = dynamic_cast<const Texture*>(pDst->getResource());
+        assert(pSrcTexture != nullptr && pDstTexture != nullptr);
+
+        vec2 srcRectOffset(0.0f);
+        vec2 srcRectScale(1.0f);
+        uint32_t srcMipLevel = pSrc->getViewInfo().mostDetailedMip;
+        uint32_t dstMipLevel = pDst->getViewInfo().mostDetailedMip;
+        GraphicsState::Viewport dstViewport(0.0f, 0.0f, (float)pDstTexture->getWidth(dstMipLevel), (float)pDstTexture->getHeight(dstMipLevel), 0.0f, 1.0f);
+
+        // If src rect specified
+        if (srcRect.x != (uint32_t)-1)
+        {
+            const vec2 srcSize(pSrcTexture->getWidth(srcMipLevel), pSrcTexture->getHeight(srcMipLevel));
+            srcRectOffset = vec2(srcRect.x, srcRect.y) / srcSize;
+            srcRectScale = vec2(srcRect.z - srcRect.x, srcRect.w - srcRect.y) / srcSize;
+        }
+
+        // If dest rect specified
+        if (dstRect.x != (uint32_t)-1)
+        {
+            dstViewport = GraphicsState::Viewport((float)dstRect.x, (float)dstRect.y, (float)(dstRect.z - dstRect.x), (float)(dstRect.w - dstRect.y), 0.0f, 1.0f);
+        }
+
+        // Update buffer/state
+        if (srcRectOffset != gBlitData.prevSrcRectOffset)
+        {
+            gBlitData.pSrcRectBuffer->setVariable(gBlitData.offsetVarOffset, srcRectOffset);
+            gBlitData.prevSrcRectOffset = srcRectOffset;
+        }
+
+        if (srcRectScale != gBlitData.prevSrcReftScale)
+        {
+            gBlitData.pSrcRectBuffer->setVariable(gBlitData.scaleVarOffset, srcRectScale);
+            gBlitData.prevSrcReftScale = srcRectScale;
+        }
+
+        gBlitData.pState->setViewport(0, dstViewport);
+
+        pushGraphicsState(gBlitData.pState);
+        pushGraphicsVars(gBlitData.pVars);
+
+        if (pSrcTexture->getSampleCount() > 1)
+        {
+            gBlitData.pPass->getProgram()->addDefine("SAMPLE_COUNT", std::to_string(pSrcTexture->getSampleCount()));
+        }
+        else
+        {
+            gBlitData.pPass->getProgram()->removeDefine("SAMPLE_COUNT");
+        }
+
+        Fbo::SharedPtr pFbo = Fbo::create();
+        Texture::SharedPtr pSharedTex = std::const_pointer_cast<Texture>(pDstTexture->shared_from_this());
+        pFbo->attachColorTarget(pSharedTex, 0, pDst->getViewInfo().mostDetailedMip, pDst->getViewInfo().firstArraySlice, pDst->getViewInfo().arraySize);
+        gBlitData.pState->pushFbo(pFbo, false);
+        gBlitData.pVars->setSrv(0, 0, 0, pSrc);
+        gBlitData.pPass->execute(this);
+
+        // Release the resources we bound
+        gBlitData.pVars->setSrv(0, 0, 0, nullptr);
+        gBlitData.pState->popFbo(false);
+        popGraphicsState();
+        popGraphicsVars();
+    }
+}
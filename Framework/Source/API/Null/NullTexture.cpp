@@ -0,0 +1,98 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "API/Texture.h"
+#include "API/Device.h"
+
+namespace Falcor
+{
+    /** Size of a single subresource of a specific mip-level. Subresources are tightly packed, blocks of compressed formats are laid out row by row
+    */
+    size_t getNullSubresourceSize(const Texture* pTexture, uint32_t mipLevel)
+    {
+        assert(mipLevel < pTexture->getMipCount());
+        ResourceFormat format = pTexture->getFormat();
+
+        uint32_t w = pTexture->getWidth(mipLevel);
+        uint32_t perW = getFormatWidthCompressionRatio(format);
+        uint32_t bw = align_to(perW, w) / perW;
+
+        uint32_t h = pTexture->getHeight(mipLevel);
+        uint32_t perH = getFormatHeightCompressionRatio(format);
+        uint32_t bh = align_to(perH, h) / perH;
+
+        size_t size = (size_t)bh * bw * getFormatBytesPerBlock(format);
+        return size * pTexture->getDepth(mipLevel) * pTexture->getSampleCount();
+    }
+
+    /** Offset of a subresource inside the texture memory. Subresources are stored in subresource-index order (all the mips of slice 0, then slice 1, etc.)
+    */
+    size_t getNullSubresourceOffset(const Texture* pTexture, uint32_t subresourceIndex)
+    {
+        uint32_t mipCount = pTexture->getMipCount();
+        uint32_t arraySlice = pTexture->getSubresourceArraySlice(subresourceIndex);
+        uint32_t mipLevel = pTexture->getSubresourceMipLevel(subresourceIndex);
+
+        size_t sliceSize = 0;
+        for (uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            sliceSize += getNullSubresourceSize(pTexture, mip);
+        }
+
+        size_t offset = sliceSize * arraySlice;
+        for (uint32_t mip = 0; mip < mipLevel; mip++)
+        {
+            offset += getNullSubresourceSize(pTexture, mip);
+        }
+        return offset;
+    }
+
+    void Texture::apinit(const void* pData, bool autoGenMips)
+    {
+        uint32_t arraySize = (mType == Texture::Type::TextureCube) ? mArraySize * 6 : mArraySize;
+        size_t size = 0;
+        for (uint32_t mip = 0; mip < mMipLevels; mip++)
+        {
+            size += getNullSubresourceSize(this, mip);
+        }
+        size *= arraySize;
+
+        mApiHandle = NullResource::create(size);
+        gNullDeviceStats.texturesCreated++;
+
+        if (pData)
+        {
+            uploadInitData(pData, autoGenMips);
+        }
+    }
+
+    Texture::~Texture()
+    {
+        gpDevice->releaseResource(mApiHandle);
+    }
+}
@@ -56,6 +56,12 @@ namespace Falcor
         return invalidBind;
     }
 
+    uint32_t ProgramReflection::allocateBindingCacheId()
+    {
+        static uint32_t sCacheCount = 0;
+        return sCacheCount++;
+    }
+
     bool ProgramReflection::init(ShaderReflection* pSlangReflector, std::string& log)
     {
         bool b = true;
@@ -395,6 +395,25 @@ namespace Falcor
         */
         bool isSampleFrequency() const { return mIsSampleFrequency; }
 
+        /** Get an object holding bindings which were pre-resolved from this reflection object.
+            The object is created on the first call by invoking T's constructor with this reflection object, and lives as long as the reflection object does.
+            Use it to resolve variable names once per program version instead of looking them up every frame.
+        */
+        template<typename T>
+        const T& getBindingCache() const
+        {
+            static const uint32_t id = allocateBindingCacheId();
+            if (id >= mBindingCaches.size())
+            {
+                mBindingCaches.resize(id + 1);
+            }
+            if (mBindingCaches[id] == nullptr)
+            {
+                mBindingCaches[id] = std::make_shared<T>(this);
+            }
+            return *static_cast<const T*>(mBindingCaches[id].get());
+        }
+
     // TODO(tfoley): switch this back
     public://private:
         bool init(
@@ -416,6 +435,9 @@ namespace Falcor
         ResourceMap mResources;
         uvec3 mThreadGroupSize;
         bool mIsSampleFrequency = false;
+
+        static uint32_t allocateBindingCacheId();
+        mutable std::vector<std::shared_ptr<void>> mBindingCaches;
     };
 
     inline const std::string to_string(ProgramReflection::Variable::Type type)
@@ -169,7 +169,7 @@ namespace Falcor
         for (size_t i = 0; i < mpRootSignature->getDescriptorSetCount(); i++)
         {
             const auto& set = mpRootSignature->getDescriptorSet(i);
-#ifdef FALCOR_D3D12
+#if defined FALCOR_D3D12 || defined FALCOR_NULL
             mRootSets[i].active = (set.getRangeCount() >= 1 && set.getRange(0).type != RootSignature::DescType::Cbv);
 #else
             mRootSets[i].active = true;
@@ -241,6 +241,35 @@ namespace Falcor
         return std::static_pointer_cast<ConstantBuffer>(it->second[arrayIndex].pResource);
     }
 
+    ProgramVars::ConstantBufferHandle ProgramVars::getConstantBufferHandle(const ProgramReflection* pReflector, const std::string& name)
+    {
+        ConstantBufferHandle handle;
+        auto binding = pReflector->getBufferBinding(name);
+        if (binding.regSpace == ProgramReflection::kInvalidLocation)
+        {
+            std::string nameNoIndex;
+            if (parseArrayIndex(name, nameNoIndex, handle.arrayIndex) == false) return handle;
+            binding = pReflector->getBufferBinding(nameNoIndex);
+            if (binding.regSpace == ProgramReflection::kInvalidLocation) return handle;
+        }
+
+        if (pReflector->getBufferDesc(binding.regSpace, binding.baseRegIndex, binding.shaderAccess, ProgramReflection::BufferReflection::Type::Constant) == nullptr)
+        {
+            return handle;
+        }
+
+        handle.location = BindLocation(binding.regSpace, binding.baseRegIndex);
+        return handle;
+    }
+
+    ConstantBuffer::SharedPtr ProgramVars::getConstantBuffer(const ConstantBufferHandle& handle) const
+    {
+        if (handle.isValid() == false) return nullptr;
+        auto& it = mAssignedCbs.find(handle.location);
+        if (it == mAssignedCbs.end()) return nullptr;
+        return std::static_pointer_cast<ConstantBuffer>(it->second[handle.arrayIndex].pResource);
+    }
+
     bool ProgramVars::setConstantBuffer(uint32_t regSpace, uint32_t baseRegIndex, uint32_t arrayIndex, const ConstantBuffer::SharedPtr& pCB)
     {
         BindLocation loc(regSpace, baseRegIndex);
@@ -702,7 +731,7 @@ namespace Falcor
         {
             const auto& samplerVec = samplerIt.second;
             const auto& rootData = samplerVec[0].rootData;
-            if (rootSets[rootData.rootIndex].dirty)
+            if (rootSets[rootData.rootIndex].writeDescriptors)
             {
                 for(uint32_t i = 0 ; i < samplerVec.size() ; i++)
                 {
@@ -728,7 +757,7 @@ namespace Falcor
             const auto& resVec = resIt.second;
             auto& rootData = resVec[0].rootData;
 
-            if (rootSets[rootData.rootIndex].dirty)
+            if (rootSets[rootData.rootIndex].writeDescriptors)
             {
                 for (uint32_t i = 0; i < resVec.size(); i++)
                 {
@@ -809,6 +838,47 @@ namespace Falcor
         }
     }
 
+    template<typename ViewType>
+    void initCacheKeys(const ProgramVars::ResourceMap<ViewType>& resMap, const ProgramVars::RootSetVec& rootSets, std::vector<DescriptorSetCache::Key>& keys)
+    {
+        for (auto& resIt : resMap)
+        {
+            const auto& resVec = resIt.second;
+            uint32_t rootIndex = resVec[0].rootData.rootIndex;
+            if (rootSets[rootIndex].pDescSet) continue;
+
+            // Must match the views bindUavSrvCommon() writes
+            for (const auto& resDesc : resVec)
+            {
+                keys[rootIndex].addObject(resDesc.pResource ? resDesc.pView : ViewType::getNullView());
+            }
+        }
+    }
+
+    void initSamplerCacheKeys(const ProgramVars::ResourceMap<Sampler>& samplers, const ProgramVars::RootSetVec& rootSets, std::vector<DescriptorSetCache::Key>& keys)
+    {
+        for (auto& samplerIt : samplers)
+        {
+            const auto& samplerVec = samplerIt.second;
+            uint32_t rootIndex = samplerVec[0].rootData.rootIndex;
+            if (rootSets[rootIndex].pDescSet) continue;
+
+            for (const auto& samplerDesc : samplerVec)
+            {
+                keys[rootIndex].addObject(samplerDesc.pSampler ? samplerDesc.pSampler : Sampler::getDefault());
+            }
+        }
+    }
+
+    void initCbCacheKeys(const ProgramVars::ResourceMap<ConstantBuffer>& cbMap, std::vector<DescriptorSetCache::Key>& keys)
+    {
+        // The CB descriptor points to the buffer's current allocation, which changes every time the buffer is updated
+        for (auto& bufIt : cbMap)
+        {
+            keys[bufIt.second[0].rootData.rootIndex].setUncacheable();
+        }
+    }
+
     template<bool forGraphics>
     bool applyProgramVarsCommon(const ProgramVars* pVars, ProgramVars::RootSetVec& rootSets, CopyContext* pContext, bool bindRootSig)
     {
@@ -829,21 +899,40 @@ namespace Falcor
         uploadUavSrvCommon<ShaderResourceView, false>(pContext, pVars->getAssignedSrvs(), rootSets);
         uploadUavSrvCommon<UnorderedAccessView, true>(pContext, pVars->getAssignedUavs(), rootSets);
 
-        // Allocate and mark the dirty sets
+        // Find the sets which need a new descriptor-set and build their cache keys
+        bool needNewSets = false;
         for (uint32_t i = 0; i < rootSets.size(); i++)
         {
             rootSets[i].dirty = (rootSets[i].pDescSet == nullptr);
-            if (rootSets[i].active)
+            rootSets[i].writeDescriptors = false;
+            needNewSets = needNewSets || (rootSets[i].active && rootSets[i].dirty);
+        }
+
+        if (needNewSets)
+        {
+            std::vector<DescriptorSetCache::Key> keys(rootSets.size());
+            for (uint32_t i = 0; i < rootSets.size(); i++)
+            {
+                keys[i].reset(&pVars->getRootSignature()->getDescriptorSet(i));
+            }
+            initCacheKeys(pVars->getAssignedSrvs(), rootSets, keys);
+            initCacheKeys(pVars->getAssignedUavs(), rootSets, keys);
+            initSamplerCacheKeys(pVars->getAssignedSamplers(), rootSets, keys);
+            initCbCacheKeys(pVars->getAssignedCbs(), keys);
+
+            // Get the sets from the cache. Only sets which were just created need their descriptors written
+            DescriptorSetCache* pCache = gpDevice->getDescriptorSetCache().get();
+            for (uint32_t i = 0; i < rootSets.size(); i++)
             {
-                if (rootSets[i].pDescSet == nullptr)
+                if (rootSets[i].active && rootSets[i].pDescSet == nullptr)
                 {
-                    DescriptorSet::Layout layout;
-                    const auto& set = pVars->getRootSignature()->getDescriptorSet(i);
-                    rootSets[i].pDescSet = DescriptorSet::create(gpDevice->getGpuDescriptorPool(), set);
+                    bool isNew;
+                    rootSets[i].pDescSet = pCache->getSet(keys[i], isNew);
                     if (rootSets[i].pDescSet == nullptr)
                     {
                         return false;
                     }
+                    rootSets[i].writeDescriptors = isNew;
                 }
             }
         }
@@ -223,7 +223,8 @@ namespace Falcor
         {
             bool active = false;
             mutable std::shared_ptr<DescriptorSet> pDescSet;
-            mutable bool dirty = false;
+            mutable bool dirty = false;             // The set needs to be bound
+            mutable bool writeDescriptors = false;  // The set was just created and its descriptors need to be written
         };
         
         union BindLocation
@@ -240,6 +241,27 @@ namespace Falcor
             bool operator==(const BindLocation& other) const { return u64 == other.u64; }
         };
 
+        /** A pre-resolved constant buffer location. Resolve it once with getConstantBufferHandle() and use it on hot paths instead of the buffer name.
+        */
+        struct ConstantBufferHandle
+        {
+            BindLocation location;
+            uint32_t arrayIndex = 0;
+            bool isValid() const { return location.u64 != uint64_t(-1); }
+        };
+
+        /** Resolve a constant buffer name into a handle. The handle is valid for all vars created from the same reflection object.
+            \param[in] pReflector The program reflection
+            \param[in] name The name of the buffer
+            \return The handle. If the buffer doesn't exist the handle is invalid, no warning is logged
+        */
+        static ConstantBufferHandle getConstantBufferHandle(const ProgramReflection* pReflector, const std::string& name);
+
+        /** Get a constant buffer object using a pre-resolved handle.
+            \return If the handle is valid, a shared pointer to the CB. Otherwise returns nullptr
+        */
+        ConstantBuffer::SharedPtr getConstantBuffer(const ConstantBufferHandle& handle) const;
+
         template<typename T>
         using ResourceMap = std::unordered_map<BindLocation, std::vector<ResourceData<T>>, BindLocation>;
         using SamplerMap = std::unordered_map<BindLocation, std::vector<Sampler::SharedConstPtr>, BindLocation>;
@@ -28,7 +28,6 @@
 #include "Framework.h"
 #include "API/Texture.h"
 #include "API/Device.h"
-#include "Utils/ThreadPool.h"
 
 namespace Falcor
 {
@@ -97,18 +96,20 @@ namespace Falcor
         }
     }
 
-    void Texture::captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags) const
+    void Texture::captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags, const Bitmap::ExportCallback& callback) const
     {
         uint32_t subresource = getSubresourceIndex(arraySlice, mipLevel);
-        std::vector<uint8> textureData = gpDevice->getRenderContext()->readTextureSubresource(this, subresource);
+        uint32_t width = getWidth(mipLevel);
+        uint32_t height = getHeight(mipLevel);
+        ResourceFormat resourceFormat = getFormat();
 
-        auto& func = [=]
+        // Once the GPU finished the copy, hand the data to the export queue which converts and encodes it on a worker thread
+        auto readbackFunc = [=](const std::vector<uint8>& textureData)
         {
-            Bitmap::saveImage(filename, getWidth(mipLevel), getHeight(mipLevel), format, exportFlags, getFormat(), true, (void*)textureData.data());
+            Bitmap::saveImageAsync(filename, width, height, format, exportFlags, resourceFormat, true, std::vector<uint8_t>(textureData), callback);
         };
 
-        static ThreadPool<16> sThreadPool;
-        sThreadPool.getAvailable() = std::thread(func);
+        gpDevice->getRenderContext()->asyncReadTextureSubresource(this, subresource, readbackFunc);
     }
 
     void Texture::uploadInitData(const void* pData, bool autoGenMips)
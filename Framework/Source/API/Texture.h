@@ -149,13 +149,15 @@ namespace Falcor
         static SharedPtr create2DMS(uint32_t width, uint32_t height, ResourceFormat format, uint32_t sampleCount, uint32_t arraySize = 1, BindFlags bindFlags = BindFlags::ShaderResource);
         
         /** Capture the texture to a PNG image.\n
+            This function doesn't block. Once the GPU finished copying the texture, usually after the frame is presented, the image is queued to Bitmap::saveImageAsync() and written by an export thread.
             \param[in] mipLevel Requested mip-level
             \param[in] arraySlice Requested array-slice
             \param[in] filename Name of the PNG file to save.
             \param[in] fileFormat Destination image file format (e.g., PNG, PFM, etc.)
             \param[in] exportFlags Save flags, see Bitmap::ExportFlags
+            \param[in] callback Optional. Called from the export thread once the file was written
         */
-        void captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format = Bitmap::FileFormat::PngFile, Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None) const;
+        void captureToFile(uint32_t mipLevel, uint32_t arraySlice, const std::string& filename, Bitmap::FileFormat format = Bitmap::FileFormat::PngFile, Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None, const Bitmap::ExportCallback& callback = nullptr) const;
 
         /** Generates mipmaps for a specified texture object.
         */
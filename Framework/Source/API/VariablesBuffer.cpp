@@ -103,7 +103,15 @@ namespace Falcor
 
         if(size == -1)
         {
-            size = mSize - offset;
+            if(offset == 0 && mCpuAccess != CpuAccess::Write)
+            {
+                offset = std::min(mDirtyBegin, mSize);
+                size = std::min(mDirtyEnd, mSize) - offset;
+            }
+            else
+            {
+                size = mSize - offset;
+            }
         }
 
         if(size + offset > mSize)
@@ -112,11 +120,23 @@ namespace Falcor
             return false;
         }
 
-        updateData(mData.data(), offset, size);
+        if(size)
+        {
+            updateData(mData.data() + offset, offset, size);
+        }
         mDirty = false;
+        mDirtyBegin = SIZE_MAX;
+        mDirtyEnd = 0;
         return true;
     }
 
+    void VariablesBuffer::markDirty(size_t offset, size_t size)
+    {
+        mDirtyBegin = std::min(mDirtyBegin, offset);
+        mDirtyEnd = std::max(mDirtyEnd, offset + size);
+        mDirty = true;
+    }
+
     template<typename VarType>
     bool checkVariableType(ProgramReflection::Variable::Type shaderType, const std::string& name, const std::string& bufferName)
     {
@@ -203,7 +223,7 @@ namespace Falcor
         {
             const uint8_t* pVar = mData.data() + offset + elementIndex * mElementSize;
             *(VarType*)pVar = value;
-            mDirty = true;
+            markDirty(offset + elementIndex * mElementSize, sizeof(VarType));
         }
     }
 
@@ -305,7 +325,7 @@ namespace Falcor
             {
                 pData[i] = pValue[i];
             }
-            mDirty = true;
+            markDirty((uint8_t*)pData - mData.data(), count * sizeof(VarType));
         }
     }
 
@@ -406,7 +426,7 @@ namespace Falcor
             return;
         }
         memcpy(mData.data() + offset, pSrc, size);
-        mDirty = true;
+        markDirty(offset, size);
     }
 
     bool checkResourceDimension(const Texture* pTexture, const ProgramReflection::Resource* pResourceDesc, const std::string& name, const std::string& bufferName)
@@ -561,7 +581,7 @@ namespace Falcor
 
         if(bOK)
         {
-            mDirty = true;
+            markDirty(0, mSize);
             setTextureInternal(offset, pTexture, pSampler);
         }
     }
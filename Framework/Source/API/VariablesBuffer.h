@@ -55,6 +55,7 @@ namespace Falcor
 
         /** Apply the changes to the actual GPU buffer.
         Note that it is possible to use this function to update only part of the GPU copy of the buffer. This might lead to inconsistencies between the GPU and CPU buffer, so make sure you know what you are doing.
+        When called with the default arguments, only the range modified since the last upload is written. Buffers with CPU write access are always uploaded whole, since mapping them discards the previous content.
         \param[in] offset Offset into the buffer to write to
         \param[in] size   Number of bytes to upload. If this value is -1, will update the [Offset, EndOfBuffer] range.
         */
@@ -101,9 +102,13 @@ namespace Falcor
 
         void setTextureInternal(size_t offset, const Texture* pTexture, const Sampler* pSampler);
 
+        void markDirty(size_t offset, size_t size);
+
         ProgramReflection::BufferReflection::SharedConstPtr mpReflector;
         std::vector<uint8_t> mData;
         mutable bool mDirty = true;
+        size_t mDirtyBegin = 0;         ///< Byte range modified since the last upload
+        size_t mDirtyEnd = SIZE_MAX;
         size_t mElementCount;
         size_t mElementSize;
     };
@@ -104,8 +104,11 @@ namespace Falcor
     {
         if (mCpuAccess == CpuAccess::Write)
         {
-            mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize);
-            mApiHandle = mDynamicData.pResourceHandle;
+            if (hasInitData == false) // Else the allocation will happen when updating the data
+            {
+                mDynamicData = gpDevice->getResourceAllocator()->allocate(mSize);
+                mApiHandle = mDynamicData.pResourceHandle;
+            }
         }
         else
         {
@@ -29,6 +29,7 @@
 #include "API/CopyContext.h"
 #include "API/Buffer.h"
 #include "API/Texture.h"
+#include "Utils/FrameTelemetry.h"
 
 namespace Falcor
 {
@@ -154,7 +155,7 @@ namespace Falcor
         dataSize = getMipLevelPackedDataSize(pTexture, mipLevel);
 
         // Upload the data to a staging buffer
-        pStaging = Buffer::create(dataSize, Buffer::BindFlags::None, pSrcData ? Buffer::CpuAccess::Write : Buffer::CpuAccess::Read, pSrcData);
+        pStaging = pSrcData ? Buffer::createTransient(dataSize, Buffer::BindFlags::None, pSrcData) : Buffer::create(dataSize, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
 
         vkCopy = {};
         vkCopy.bufferOffset = pStaging->getGpuAddressOffset();
@@ -176,6 +177,7 @@ namespace Falcor
         Buffer::SharedPtr pStaging;
         size_t dataSize;
         initTexAccessParams(pTexture, subresourceIndex, vkCopy, pStaging, pData, dataSize);
+        gFrameCounters.uploadBytes += dataSize;
 
         // Execute the copy
         resourceBarrier(pTexture, Resource::State::CopyDest);
@@ -183,27 +185,63 @@ namespace Falcor
         vkCmdCopyBufferToImage(mpLowLevelData->getCommandList(), pStaging->getApiHandle(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vkCopy);
     }
 
-    std::vector<uint8> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    void CopyContext::updateTextureRegion(const Texture* pTexture, uint32_t subresourceIndex, const uvec2& offset, const uvec2& size, const void* pData)
     {
+        const ResourceFormat format = pTexture->getFormat();
+        assert(isDepthStencilFormat(format) == false);
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+        assert(offset.x % blockWidth == 0 && offset.y % blockHeight == 0 && size.x % blockWidth == 0 && size.y % blockHeight == 0);
         mCommandsPending = true;
-        VkBufferImageCopy vkCopy;
-        Buffer::SharedPtr pStaging;
-        size_t dataSize;
-        initTexAccessParams(pTexture, subresourceIndex, vkCopy, pStaging, nullptr, dataSize);
+
+        // The rectangle is tightly packed, so the buffer row length and image height can be left at 0
+        const size_t dataSize = (size_t)(size.x / blockWidth) * (size.y / blockHeight) * getFormatBytesPerBlock(format);
+        Buffer::SharedPtr pStaging = Buffer::createTransient(dataSize, Buffer::BindFlags::None, pData);
+        gFrameCounters.uploadBytes += dataSize;
+
+        VkBufferImageCopy vkCopy = {};
+        vkCopy.bufferOffset = pStaging->getGpuAddressOffset();
+        vkCopy.imageSubresource.aspectMask = getAspectFlagsFromFormat(format);
+        vkCopy.imageSubresource.baseArrayLayer = pTexture->getSubresourceArraySlice(subresourceIndex);
+        vkCopy.imageSubresource.layerCount = 1;
+        vkCopy.imageSubresource.mipLevel = pTexture->getSubresourceMipLevel(subresourceIndex);
+        vkCopy.imageOffset = { (int32_t)offset.x, (int32_t)offset.y, 0 };
+        vkCopy.imageExtent = { size.x, size.y, 1 };
+
+        // Execute the copy
+        resourceBarrier(pTexture, Resource::State::CopyDest);
+        resourceBarrier(pStaging.get(), Resource::State::CopySource);
+        vkCmdCopyBufferToImage(mpLowLevelData->getCommandList(), pStaging->getApiHandle(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vkCopy);
+    }
+
+    ReadbackRequest::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const ReadbackRequest::Callback& callback)
+    {
+        mCommandsPending = true;
+        assert(isDepthStencilFormat(pTexture->getFormat()) == false);
+        uint32_t mipLevel = pTexture->getSubresourceMipLevel(subresourceIndex);
+        size_t dataSize = getMipLevelPackedDataSize(pTexture, mipLevel);
+        Buffer::SharedPtr pStaging = getReadbackHeap()->acquireStagingBuffer(dataSize);
+
+        VkBufferImageCopy vkCopy = {};
+        vkCopy.bufferOffset = pStaging->getGpuAddressOffset();
+        vkCopy.imageSubresource.aspectMask = getAspectFlagsFromFormat(pTexture->getFormat());
+        vkCopy.imageSubresource.baseArrayLayer = pTexture->getSubresourceArraySlice(subresourceIndex);
+        vkCopy.imageSubresource.layerCount = 1;
+        vkCopy.imageSubresource.mipLevel = mipLevel;
+        vkCopy.imageExtent.width = pTexture->getWidth(mipLevel);
+        vkCopy.imageExtent.height = pTexture->getHeight(mipLevel);
+        vkCopy.imageExtent.depth = pTexture->getDepth(mipLevel);
 
         // Execute the copy
         resourceBarrier(pTexture, Resource::State::CopySource);
         resourceBarrier(pStaging.get(), Resource::State::CopyDest);
         vkCmdCopyImageToBuffer(mpLowLevelData->getCommandList(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pStaging->getApiHandle(), 1, &vkCopy);
 
-        flush(true);
-
-        // Map and read the results
-        std::vector<uint8> result(dataSize);
-        uint8* pData = reinterpret_cast<uint8*>(pStaging->map(Buffer::MapType::Read));
-        memcpy_s(result.data(), result.size(), pData, dataSize);
-
-        return result;
+        // The data is tightly packed
+        ReadbackRequest::Layout layout;
+        layout.rowSize = (uint32_t)dataSize;
+        layout.rowPitch = (uint32_t)dataSize;
+        return getReadbackHeap()->createRequest(pStaging, layout, callback);
     }
 
     void CopyContext::resourceBarrier(const Resource* pResource, Resource::State newState)
@@ -31,6 +31,7 @@
 #include "API/Device.h"
 #include "glm/gtc/type_ptr.hpp"
 #include "VKState.h"
+#include "Utils/FrameTelemetry.h"
 
 namespace Falcor
 {
@@ -191,6 +192,7 @@ namespace Falcor
 
     void RenderContext::prepareForDraw()
     {
+        gFrameCounters.drawCalls++;
         // Apply the vars. Must be first because applyGraphicsVars() might cause a flush
         if(mpGraphicsVars)
         {
@@ -39,7 +39,7 @@ namespace Falcor
             const auto& rootData = bufIt.second[0].rootData;
             ConstantBuffer* pCB = dynamic_cast<ConstantBuffer*>(bufIt.second[0].pResource.get());
 
-            if (rootSets[rootData.rootIndex].dirty)
+            if (rootSets[rootData.rootIndex].writeDescriptors)
             {
                 rootSets[rootData.rootIndex].pDescSet->setCb(rootData.rangeIndex, 0, pCB);
             }
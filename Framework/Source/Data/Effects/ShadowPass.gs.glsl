@@ -34,6 +34,11 @@ layout(set = 0, binding = 3) uniform PerLightCB
     CsmData gCsmData;
 };
 
+layout(set = 0, binding = 4) uniform CascadeMaskCB
+{
+    uint gCascadeMask;
+};
+
 layout(location = 0) out vec2 outputData_texC;
 
 layout(location = 0) in vec2 input_texC[3];
@@ -48,6 +53,12 @@ void main()
 {
     int InstanceID = gl_InvocationID;
 
+    // Only emit into the cascades the instances of the draw overlap
+    if((gCascadeMask & (1u << InstanceID)) == 0)
+    {
+        return;
+    }
+
     // void main(triangle ShadowPassVSOut input[3], uint InstanceID : SV_GSInstanceID, inout TriangleStream<ShadowPassPSIn> outStream)
 
     for(int i = 0 ; i < 3 ; i++)
@@ -183,6 +183,7 @@ struct MaterialValues
     int32_t id           DEFAULTS(-1);   // Scene-unique material id, -1 is a wrong material
 };
 
+#if defined(HOST_CODE) || !defined(_MS_MATERIAL_TABLE)
 struct MaterialTextures
 {
     Texture2D layers[MatMaxLayers];        // A single texture per layer
@@ -199,6 +200,31 @@ struct MaterialData
     MaterialTextures textures;
     SamplerState samplerState;  // The sampler state to use when sampling the object
 };
+#else
+/** When using the scene-wide material table, the textures and sampler are indices into gMaterialTextures and gMaterialSamplers.
+    The layout must match MaterialTable::Entry.
+*/
+struct MaterialTextures
+{
+    uint32_t layers[MatMaxLayers];
+    uint32_t alphaMap;
+    uint32_t normalMap;
+    uint32_t heightMap;
+    uint32_t ambientMap;
+};
+
+struct MaterialData
+{
+    MaterialDesc desc;
+    MaterialValues values;
+    MaterialTextures textures;
+    uint32_t samplerState;
+};
+
+StructuredBuffer<MaterialData> gMaterialTable;
+Texture2D gMaterialTextures[MatTableMaxTextures];
+SamplerState gMaterialSamplers[MatTableMaxSamplers];
+#endif
 
 struct PreparedMaterialData
 {
@@ -273,6 +299,98 @@ struct LightData
     */
 };
 
+/**
+    Describes the froxel grid used for clustered light culling (see LightClusters).
+    The view-space depth of slice z is nearZ * (farZ / nearZ)^(z / gridSizeZ), so a depth d maps to the slice log(d) * depthScale + depthBias.
+*/
+struct LightClusterParams
+{
+    uint32_t    gridSizeX       DEFAULTS(16);
+    uint32_t    gridSizeY       DEFAULTS(9);
+    uint32_t    gridSizeZ       DEFAULTS(24);
+    uint32_t    pad0;
+    float       depthScale      DEFAULTS(0);
+    float       depthBias       DEFAULTS(0);
+    float2      pad1;
+};
+
+/**
+    Transforms of a mesh instance, stored in the instance buffer (see InstanceBuffers).
+*/
+struct InstanceData
+{
+    float4x4    worldMat;
+    float4x4    worldInvTransposeMat;   // Only the upper 3x3 is used
+};
+
+/**
+    A streamed mip level of a virtual texture.
+*/
+struct VirtualTextureMip
+{
+    uint32_t    firstEntry;                                 ///< Index of the first page table entry of the level
+    uint32_t    pagesX;                                     ///< Number of pages per row
+    uint32_t    width;                                      ///< Size of the level, in texels
+    uint32_t    height;
+};
+
+/**
+    Describes how to sample a virtual texture (see VirtualTexture). Pages live in a physical atlas and are located through a page table with one entry per page of every level.
+*/
+struct VirtualTextureData
+{
+    float       atlasInvWidth;
+    float       atlasInvHeight;
+    uint32_t    pageSize;                                   ///< Size of a page in texels, without the border
+    uint32_t    pageBorder;                                 ///< Border texels on each side of an atlas page
+    uint32_t    atlasPagesX;                                ///< Number of pages per atlas row
+    uint32_t    mipCount;
+    uint32_t    pad0;
+    uint32_t    pad1;
+    VirtualTextureMip mips[VirtualTextureMaxMips];
+};
+
+/**
+    Prefiltered environment lighting baked by LightProbe.
+*/
+struct LightProbeData
+{
+    float       specularMipCount;                           ///< Levels of the prefiltered map. Level i is filtered for roughness i / (count - 1)
+    float       intensity;                                  ///< Scale applied to the probe lighting
+    float       pad0;
+    float       pad1;
+    float4      shIrradiance[9];                            ///< L2 spherical harmonics of the irradiance divided by pi, in xyz. The diffuse radiance is albedo * sum(sh[i] * Y_i(n))
+};
+
+/**
+    A world-space emissive triangle. Built on the CPU by EmissiveTriangleTable.
+*/
+struct EmissiveTriangle
+{
+    float3      p0;
+    float       area;                                       ///< Surface area in world space
+    float3      p1;
+    float       flux;                                       ///< Luminance of the emitted radiance times the area. Used as the sampling weight
+    float3      p2;
+    uint32_t    instanceIndex;                              ///< Index of the mesh instance the triangle belongs to
+    float3      normal;                                     ///< Normalized geometric normal
+    float       pad0;
+    float3      radiance;                                   ///< Emitted radiance, taken from the emissive material layers
+    float       pad1;
+};
+
+/**
+    An entry of the alias table used to pick emissive triangles proportionally to their flux in O(1).
+    Pick a uniform entry i, then keep it if the fractional part of the random number is below 'threshold', otherwise use 'alias'.
+*/
+struct EmissiveAliasEntry
+{
+    float       threshold;
+    uint32_t    alias;
+    float       pdf;                                        ///< Probability of picking the triangle with the same index
+    float       pad;
+};
+
 /*******************************************************************
                     Shared material routines
 *******************************************************************/
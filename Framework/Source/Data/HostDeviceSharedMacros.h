@@ -155,6 +155,48 @@
 */
 #define     MatMaxLayers    3
 
+/**
+    Capacity of the texture and sampler arrays used by the scene-wide material table (see _MS_MATERIAL_TABLE).
+*/
+#define     MatTableMaxTextures    256
+#define     MatTableMaxSamplers    16
+
+/**
+    Index stored in a material table entry for a missing texture, or a texture/sampler which didn't fit into the table's arrays.
+*/
+#define     MatTableInvalidIndex   0xffffffff
+
+/**
+    Access a material texture/sampler. With _MS_MATERIAL_TABLE the material stores indices into the table's descriptor arrays.
+    MATERIAL_TEXTURE_VALID() must be checked before sampling. When it's false, the shader uses the material's constant value instead.
+*/
+#if defined(HLSL_CODE) && defined(_MS_MATERIAL_TABLE)
+#define MATERIAL_TEXTURE(mat_, tex_) gMaterialTextures[(mat_).textures.tex_]
+#define MATERIAL_SAMPLER(mat_) gMaterialSamplers[(mat_).samplerState]
+#define MATERIAL_TEXTURE_VALID(mat_, tex_) ((mat_).textures.tex_ != MatTableInvalidIndex && (mat_).samplerState != MatTableInvalidIndex)
+#else
+#define MATERIAL_TEXTURE(mat_, tex_) (mat_).textures.tex_
+#define MATERIAL_SAMPLER(mat_) (mat_).samplerState
+#define MATERIAL_TEXTURE_VALID(mat_, tex_) true
+#endif
+
 #define ROUGHNESS_CHANNEL_BIT 2
 
+/*******************************************************************
+                    Virtual textures
+*******************************************************************/
+
+/**
+    Maximum number of streamed mip levels of a virtual texture (see VirtualTexture). With 128-texel pages, enough for a 4M x 4M texture.
+*/
+#define     VirtualTextureMaxMips    16
+
+/**
+    Layout of a virtual texture page table entry: VirtualTextureEntryValid | (mip << VirtualTextureEntryMipShift) | slot, or 0 if no page covering the entry is resident yet (see VirtualTexturePageTable)
+*/
+#define     VirtualTextureEntryValid       0x80000000
+#define     VirtualTextureEntryMipShift    24
+#define     VirtualTextureEntryMipMask     0x7f        ///< Mask of the mip level, after shifting it down
+#define     VirtualTextureEntrySlotMask    0xffffff
+
 #endif //_HOST_DEVICE_SHARED_MACROS_H
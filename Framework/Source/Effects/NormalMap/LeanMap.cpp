@@ -34,6 +34,12 @@
 namespace Falcor
 {
     Texture::SharedPtr LeanMap::createFromNormalMap(const Falcor::Texture* pNormalMap)
+    {
+        auto normalMapData = gpDevice->getRenderContext()->readTextureSubresource(pNormalMap, 0);
+        return createFromNormalMapData(pNormalMap, normalMapData);
+    }
+
+    Texture::SharedPtr LeanMap::createFromNormalMapData(const Falcor::Texture* pNormalMap, const std::vector<uint8>& normalMapData)
     {
         uint32_t texW = pNormalMap->getWidth();
         uint32_t texH = pNormalMap->getHeight();
@@ -42,8 +48,6 @@ namespace Falcor
 
         leanData.resize(texW * texH);
 
-        auto normalMapData = gpDevice->getRenderContext()->readTextureSubresource(pNormalMap, 0);
-
         const float oneBy255 = 1.0f / 255.0f;
         for(auto y = 0u; y < texH; y++)
         {
@@ -115,7 +119,15 @@ namespace Falcor
         const Texture* pNormalMap = pMaterial->getNormalMap().get();
         if(pNormalMap)
         {
-            mpLeanMaps[materialID] = createFromNormalMap(pNormalMap);
+            auto readback = mPendingReadbacks.find(pNormalMap);
+            if(readback != mPendingReadbacks.end())
+            {
+                mpLeanMaps[materialID] = createFromNormalMapData(pNormalMap, readback->second->getData());
+            }
+            else
+            {
+                mpLeanMaps[materialID] = createFromNormalMap(pNormalMap);
+            }
             mShaderArraySize = max(materialID + 1, mShaderArraySize);
         }
         return true;
@@ -125,6 +137,30 @@ namespace Falcor
     {
         UniquePtr pLeanMaps = UniquePtr(new LeanMap);
 
+        // Request all the normal maps up front, so that we only wait for the GPU once
+        auto requestNormalMap = [&pLeanMaps](const Material* pMaterial)
+        {
+            const Texture* pNormalMap = pMaterial->getNormalMap().get();
+            if(pNormalMap && pLeanMaps->mPendingReadbacks.find(pNormalMap) == pLeanMaps->mPendingReadbacks.end())
+            {
+                pLeanMaps->mPendingReadbacks[pNormalMap] = gpDevice->getRenderContext()->asyncReadTextureSubresource(pNormalMap, 0);
+            }
+        };
+
+        for(uint32_t i = 0; i < pScene->getMaterialCount(); i++)
+        {
+            requestNormalMap(pScene->getMaterial(i).get());
+        }
+
+        for(uint32_t model = 0; model < pScene->getModelCount(); model++)
+        {
+            const Model* pModel = pScene->getModel(model).get();
+            for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                requestNormalMap(pModel->getMesh(meshID)->getMaterial().get());
+            }
+        }
+
         // Initialize scene materials
         for(uint32_t i = 0; i < pScene->getMaterialCount(); i++)
         {
@@ -149,6 +185,8 @@ namespace Falcor
             }
         }
 
+        pLeanMaps->mPendingReadbacks.clear();
+
         if(pLeanMaps->mpLeanMaps.size() == 0)
         {
             logWarning("Trying to create SceneLeanMaps for a scene without materials.");
@@ -30,6 +30,7 @@
 #include <memory>
 #include "API/Texture.h"
 #include "API/Sampler.h"
+#include "API/AsyncReadback.h"
 
 namespace Falcor
 {
@@ -51,7 +52,9 @@ namespace Falcor
     private:
         LeanMap() = default;
         bool createLeanMap(const Falcor::Material* pMaterial);
+        static Falcor::Texture::SharedPtr createFromNormalMapData(const Falcor::Texture* pNormalMap, const std::vector<uint8>& normalMapData);
         std::map<uint32_t, Falcor::Texture::SharedPtr> mpLeanMaps;
+        std::map<const Falcor::Texture*, ReadbackRequest::SharedPtr> mPendingReadbacks;
         uint32_t mShaderArraySize = 0;
     };
 }
\ No newline at end of file
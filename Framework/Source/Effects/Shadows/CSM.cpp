@@ -31,6 +31,8 @@
 #include "glm/gtx/transform.hpp"
 #include "Utils/Math/FalcorMath.h"
 #include "Graphics/FboHelper.h"
+#include <xmmintrin.h>
+#include <algorithm>
 
 namespace Falcor
 {
@@ -55,6 +57,15 @@ namespace Falcor
         { (uint32_t)CascadedShadowMaps::PartitionMode::PSSM, "PSSM" }
     };
 
+    const Gui::DropdownList kSdsmSourceList = {
+        { (uint32_t)CascadedShadowMaps::SdsmSource::GpuReduction, "GPU Reduction" },
+        { (uint32_t)CascadedShadowMaps::SdsmSource::InstanceBounds, "CPU Instance Bounds" },
+        { (uint32_t)CascadedShadowMaps::SdsmSource::SoftwareRaster, "CPU Software Raster" }
+    };
+
+    // Width of the CPU depth buffer used by SdsmSource::SoftwareRaster. The height follows the camera aspect ratio
+    static const uint32_t kCpuDepthBufferWidth = 256;
+
     const Gui::DropdownList kMaxAniso = {
         { (uint32_t)1, "1" },
         { (uint32_t)2, "2" },
@@ -67,9 +78,9 @@ namespace Falcor
     {
     public:
         using UniquePtr = std::unique_ptr<CsmSceneRenderer>;
-        static UniquePtr create(const Scene::SharedConstPtr& pScene, const ProgramVars::BindLocation& alphaMapCbLoc, const ProgramVars::BindLocation& alphaMapLoc, const ProgramVars::BindLocation& alphaMapSamplerLoc) 
+        static UniquePtr create(const Scene::SharedConstPtr& pScene, const ProgramVars::BindLocation& alphaMapCbLoc, const ProgramVars::BindLocation& alphaMapLoc, const ProgramVars::BindLocation& alphaMapSamplerLoc, const ProgramVars::BindLocation& cascadeMaskCbLoc) 
         { 
-            return UniquePtr(new CsmSceneRenderer(pScene, alphaMapCbLoc, alphaMapLoc, alphaMapSamplerLoc)); 
+            return UniquePtr(new CsmSceneRenderer(pScene, alphaMapCbLoc, alphaMapLoc, alphaMapSamplerLoc, cascadeMaskCbLoc)); 
         }
 
         void setDepthClamp(bool enable) { mDepthClamp = enable; }
@@ -81,13 +92,81 @@ namespace Falcor
             SceneRenderer::renderScene(pContext, pCamera);
         }
 
+        /** Render the culled shadow casters instead of walking the scene
+        */
+        void renderCasters(RenderContext* pContext, Camera* pCamera, const CascadedShadowMaps::CasterList& casters)
+        {
+            pContext->getGraphicsState()->setRasterizerState(nullptr);
+            mpLastSetRs = nullptr;
+
+            CurrentWorkingData currentData;
+            currentData.pContext = pContext;
+            currentData.pState = pContext->getGraphicsState().get();
+            currentData.pVars = pContext->getGraphicsVars().get();
+            currentData.pBindings = &getProgramBindings(currentData.pVars);
+            currentData.pCamera = pCamera;
+            currentData.pMaterial = nullptr;
+            currentData.pModel = nullptr;
+            currentData.drawID = 0;
+            setPerFrameData(currentData);
+
+            Program* pProgram = currentData.pState->getProgram().get();
+            ConstantBuffer* pMaskCB = currentData.pVars->getConstantBuffer(mBindLocations.cascadeMaskCB.regSpace, mBindLocations.cascadeMaskCB.baseRegIndex, 0).get();
+            const Scene::ModelInstance* pModelInstance = nullptr;
+            bool skipModel = false;
+            for (const auto& batch : casters.batches)
+            {
+                // Batches are grouped by model instance
+                if (batch.pModelInstance != pModelInstance)
+                {
+                    if (currentData.pModel && currentData.pModel->hasBones()) pProgram->removeDefine("_VERTEX_BLENDING");
+                    pModelInstance = batch.pModelInstance;
+                    currentData.pModel = pModelInstance->getObject().get();
+                    skipModel = (setPerModelData(currentData) == false);
+                    if (currentData.pModel->hasBones()) pProgram->addDefine("_VERTEX_BLENDING");
+                    mpLastMaterial = nullptr;
+                }
+                if (skipModel) continue;
+
+                const Mesh* pMesh = currentData.pModel->getMesh(batch.meshID).get();
+                if (setPerMeshData(currentData, pMesh) == false) continue;
+                currentData.pState->setVao(pMesh->getVao());
+                if (pMaskCB)
+                {
+                    pMaskCB->setBlob(&batch.cascadeMask, 0u, sizeof(uint32_t));
+                }
+
+                uint32_t activeInstances = 0;
+                for (uint32_t i = 0; i < batch.instanceCount; i++)
+                {
+                    if (setPerMeshInstanceData(currentData, pModelInstance, casters.instances[batch.firstInstance + i], activeInstances))
+                    {
+                        currentData.drawID++;
+                        activeInstances++;
+                        if (activeInstances == mMaxInstanceCount)
+                        {
+                            draw(currentData, pMesh, activeInstances);
+                            activeInstances = 0;
+                        }
+                    }
+                }
+                if (activeInstances != 0)
+                {
+                    draw(currentData, pMesh, activeInstances);
+                }
+            }
+
+            if (currentData.pModel && currentData.pModel->hasBones()) pProgram->removeDefine("_VERTEX_BLENDING");
+        }
+
     protected:
-        CsmSceneRenderer(const Scene::SharedConstPtr& pScene, const ProgramVars::BindLocation& alphaMapCbLoc, const ProgramVars::BindLocation& alphaMapLoc, const ProgramVars::BindLocation& alphaMapSamplerLoc) 
+        CsmSceneRenderer(const Scene::SharedConstPtr& pScene, const ProgramVars::BindLocation& alphaMapCbLoc, const ProgramVars::BindLocation& alphaMapLoc, const ProgramVars::BindLocation& alphaMapSamplerLoc, const ProgramVars::BindLocation& cascadeMaskCbLoc) 
             : SceneRenderer(std::const_pointer_cast<Scene>(pScene))
         { 
             mBindLocations.alphaCB = alphaMapCbLoc;
             mBindLocations.alphaMap = alphaMapLoc;
             mBindLocations.alphaMapSampler = alphaMapSamplerLoc;
+            mBindLocations.cascadeMaskCB = cascadeMaskCbLoc;
 
             setObjectCullState(false); 
             Sampler::Desc desc;
@@ -111,6 +190,7 @@ namespace Falcor
             ProgramVars::BindLocation alphaMap;
             ProgramVars::BindLocation alphaCB;
             ProgramVars::BindLocation alphaMapSampler;
+            ProgramVars::BindLocation cascadeMaskCB;
         } mBindLocations;
 
         bool mDepthClamp;
@@ -341,9 +421,10 @@ namespace Falcor
         auto alphaSampler = getResourceBindLocation(pReflector.get(), "alphaSampler");
         auto alphaMapCB = getBufferBindLocation(pReflector.get(), "AlphaMapCB");
         auto alphaMap = getResourceBindLocation(pReflector.get(), "alphaMap");
+        auto cascadeMaskCB = getBufferBindLocation(pReflector.get(), "CascadeMaskCB");
         mPerLightCbLoc = getBufferBindLocation(pReflector.get(), "PerLightCB");
 
-        mpCsmSceneRenderer = CsmSceneRenderer::create(mpScene, alphaMapCB, alphaMap, alphaSampler);
+        mpCsmSceneRenderer = CsmSceneRenderer::create(mpScene, alphaMapCB, alphaMap, alphaSampler, cascadeMaskCB);
         mpSceneRenderer = SceneRenderer::create(std::const_pointer_cast<Scene>(mpScene));
         mpSceneRenderer->setObjectCullState(true);
     }
@@ -383,7 +464,12 @@ namespace Falcor
             if (pGui->beginGroup(sdsmGroup))
             {
                 pGui->addCheckBox("Enable", mControls.useMinMaxSdsm);
-                if(pGui->addIntVar("Readback Latency", mSdsmData.readbackLatency))
+                uint32_t source = static_cast<uint32_t>(mControls.sdsmSource);
+                if (pGui->addDropdown("Source", kSdsmSourceList, source))
+                {
+                    mControls.sdsmSource = static_cast<SdsmSource>(source);
+                }
+                if(mControls.sdsmSource == SdsmSource::GpuReduction && pGui->addIntVar("Readback Latency", mSdsmData.readbackLatency))
                 {
                     createSdsmData(nullptr);
                 }
@@ -404,6 +490,18 @@ namespace Falcor
                 pGui->endGroup();
             }
 
+            // Shadow casters
+            const char* castersGroup = "Shadow Casters";
+            if (pGui->beginGroup(castersGroup))
+            {
+                pGui->addText(("Batches: " + std::to_string(mCasters.batches.size())).c_str());
+                for (int32_t c = 0; c < mCsmData.cascadeCount; c++)
+                {
+                    pGui->addText(("Cascade " + std::to_string(c) + ": " + std::to_string(mCasters.cascadeInstanceCount[c]) + " instances").c_str());
+                }
+                pGui->endGroup();
+            }
+
             if (mCsmData.filterMode == CsmFilterFixedPcf || mCsmData.filterMode == CsmFilterStochasticPcf)
             {
                 i32 kernelWidth = mCsmData.pcfKernelWidth;
@@ -500,7 +598,7 @@ namespace Falcor
         return distance;
     }
 
-    void getCascadeCropParams(const glm::vec3 crd[8], const glm::mat4& lightVP, glm::vec4& scale, glm::vec4& offset)
+    void getCascadeCropParams(const glm::vec3 crd[8], const glm::mat4& lightVP, const glm::vec4* pReceiverRect, glm::vec4& scale, glm::vec4& offset)
     {
         // Transform the frustum into light clip-space and calculate min-max
         glm::vec4 maxCS(-1, -1, 0, 1);
@@ -513,6 +611,20 @@ namespace Falcor
             minCS = min(minCS, c);
         }
 
+        // Nothing outside the receivers' light-space rectangle needs to be in the shadow map
+        if(pReceiverRect)
+        {
+            const glm::vec2 cropMin = max(glm::vec2(minCS), glm::vec2(pReceiverRect->x, pReceiverRect->y));
+            const glm::vec2 cropMax = min(glm::vec2(maxCS), glm::vec2(pReceiverRect->z, pReceiverRect->w));
+            if(cropMin.x < cropMax.x && cropMin.y < cropMax.y)
+            {
+                minCS.x = cropMin.x;
+                minCS.y = cropMin.y;
+                maxCS.x = cropMax.x;
+                maxCS.y = cropMax.y;
+            }
+        }
+
         glm::vec4 delta = maxCS - minCS;
         scale = glm::vec4(2, 2, 1, 1) / delta;
 
@@ -547,6 +659,18 @@ namespace Falcor
             return;
         }
 
+        // When the visible instances are known, the cascades can be cropped to the receivers. The directional light's projection is affine, so the box bounds are exact
+        glm::vec4 receiverRect;
+        const glm::vec4* pReceiverRect = nullptr;
+        if(mControls.useMinMaxSdsm && mControls.sdsmSource != SdsmSource::GpuReduction && mCpuBounds.hasReceivers && mpLight->getType() == LightDirectional)
+        {
+            const glm::mat4& m = mCsmData.globalMat;
+            const glm::vec2 rangeX = mCpuBounds.receivers.getRange(glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]));
+            const glm::vec2 rangeY = mCpuBounds.receivers.getRange(glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]));
+            receiverRect = glm::vec4(rangeX.x, rangeY.x, rangeX.y, rangeY.y);
+            pReceiverRect = &receiverRect;
+        }
+
         float nearPlane = pCamera->getNearPlane();
         float farPlane = pCamera->getFarPlane();
         float depthRange = farPlane - nearPlane;
@@ -591,7 +715,7 @@ namespace Falcor
                 cascadeFrust[i + 4] = camFrustum.crd[i] + end;
             }
 
-            getCascadeCropParams(cascadeFrust, mCsmData.globalMat, mCsmData.cascadeScale[c], mCsmData.cascadeOffset[c]);
+            getCascadeCropParams(cascadeFrust, mCsmData.globalMat, pReceiverRect, mCsmData.cascadeScale[c], mCsmData.cascadeOffset[c]);
         }
     }
 
@@ -611,6 +735,94 @@ namespace Falcor
 #define check_offset(_a)
 #endif
 
+    void CascadedShadowMaps::cullShadowCasters()
+    {
+        mCasters.batches.clear();
+        mCasters.instances.clear();
+        for (uint32_t c = 0; c < CSM_MAX_CASCADES; c++)
+        {
+            mCasters.cascadeInstanceCount[c] = 0;
+        }
+
+        // The light-space region each cascade covers, the inverse of the crop transform. A caster can be anywhere between the light and the cascade's far plane
+        const uint32_t allCascades = (1u << mCsmData.cascadeCount) - 1;
+        glm::vec3 cascadeMin[CSM_MAX_CASCADES];
+        glm::vec3 cascadeMax[CSM_MAX_CASCADES];
+        for (int32_t c = 0; c < mCsmData.cascadeCount; c++)
+        {
+            const glm::vec3 scale(mCsmData.cascadeScale[c]);
+            const glm::vec3 offset(mCsmData.cascadeOffset[c]);
+            const glm::vec3 a = (glm::vec3(-1, -1, 0) - offset) / scale;
+            const glm::vec3 b = (glm::vec3(1, 1, 1) - offset) / scale;
+            cascadeMin[c] = min(a, b);
+            cascadeMax[c] = max(a, b);
+        }
+
+        // Only the directional light's projection is affine, so only its light-space boxes are exact. Skinned meshes can move outside of their bounds
+        const bool cullCasters = (mpLight->getType() == LightDirectional);
+
+        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(modelID, instanceID).get();
+                if (pModelInstance->isVisible() == false) continue;
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    const bool cullMesh = cullCasters && (pModel->getMesh(meshID)->hasBones() == false);
+                    mMeshCasters.clear();
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID).get();
+                        if (pMeshInstance->isVisible() == false) continue;
+
+                        uint32_t mask = allCascades;
+                        if (cullMesh)
+                        {
+                            const BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix()).transform(mCsmData.globalMat);
+                            const glm::vec3 boxMin = box.center - box.extent;
+                            const glm::vec3 boxMax = box.center + box.extent;
+                            mask = 0;
+                            for (int32_t c = 0; c < mCsmData.cascadeCount; c++)
+                            {
+                                bool overlaps = boxMin.x <= cascadeMax[c].x && boxMax.x >= cascadeMin[c].x && boxMin.y <= cascadeMax[c].y && boxMax.y >= cascadeMin[c].y && boxMin.z <= cascadeMax[c].z;
+                                // Without depth clamp, casters in front of the cascade are clipped anyway
+                                if (mControls.depthClamp == false) overlaps = overlaps && boxMax.z >= cascadeMin[c].z;
+                                mask |= overlaps ? (1u << c) : 0;
+                            }
+                        }
+                        if (mask) mMeshCasters.push_back(std::make_pair(mask, pMeshInstance));
+                    }
+
+                    // One batch per distinct cascade mask
+                    std::stable_sort(mMeshCasters.begin(), mMeshCasters.end(), [](const std::pair<uint32_t, const Model::MeshInstance*>& a, const std::pair<uint32_t, const Model::MeshInstance*>& b) { return a.first < b.first; });
+                    for (size_t i = 0; i < mMeshCasters.size(); i++)
+                    {
+                        const uint32_t mask = mMeshCasters[i].first;
+                        if (i == 0 || mask != mMeshCasters[i - 1].first)
+                        {
+                            CasterBatch batch;
+                            batch.pModelInstance = pModelInstance;
+                            batch.meshID = meshID;
+                            batch.cascadeMask = mask;
+                            batch.firstInstance = (uint32_t)mCasters.instances.size();
+                            batch.instanceCount = 0;
+                            mCasters.batches.push_back(batch);
+                        }
+                        mCasters.instances.push_back(mMeshCasters[i].second);
+                        mCasters.batches.back().instanceCount++;
+                        for (int32_t c = 0; c < mCsmData.cascadeCount; c++)
+                        {
+                            mCasters.cascadeInstanceCount[c] += (mask >> c) & 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     void CascadedShadowMaps::renderScene(RenderContext* pCtx)
     {
         auto& pCB = mShadowPass.pGraphicsVars->getConstantBuffer(mPerLightCbLoc.regSpace, mPerLightCbLoc.baseRegIndex, 0);
@@ -631,7 +843,7 @@ namespace Falcor
         pCB->setBlob(&mCsmData, 0, sizeof(mCsmData));
         pCtx->pushGraphicsVars(mShadowPass.pGraphicsVars);
         pCtx->pushGraphicsState(mShadowPass.pState);
-        mpCsmSceneRenderer->renderScene(pCtx, mpLightCamera.get());
+        mpCsmSceneRenderer->renderCasters(pCtx, mpLightCamera.get(), mCasters);
         pCtx->popGraphicsState();
         pCtx->popGraphicsVars();
     }
@@ -704,11 +916,189 @@ namespace Falcor
         //}
     }
 
+    void CascadedShadowMaps::BoxArrays::clear()
+    {
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            center[i].clear();
+            extent[i].clear();
+        }
+    }
+
+    void CascadedShadowMaps::BoxArrays::add(const BoundingBox& box)
+    {
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            center[i].push_back(box.center[i]);
+            extent[i].push_back(box.extent[i]);
+        }
+    }
+
+    void CascadedShadowMaps::BoxArrays::pad()
+    {
+        // Repeat the first box, it doesn't change the range
+        while(center[0].size() % 4)
+        {
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                center[i].push_back(center[i][0]);
+                extent[i].push_back(extent[i][0]);
+            }
+        }
+    }
+
+    glm::vec2 CascadedShadowMaps::BoxArrays::getRange(const glm::vec4& plane) const
+    {
+        // The range of an affine function over a box is center value +/- the extent projected on the absolute plane normal. 4 boxes at a time
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 n[3] = { _mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z) };
+        const __m128 absN[3] = { _mm_andnot_ps(signMask, n[0]), _mm_andnot_ps(signMask, n[1]), _mm_andnot_ps(signMask, n[2]) };
+        const __m128 d = _mm_set1_ps(plane.w);
+
+        __m128 minValue = _mm_set1_ps(FLT_MAX);
+        __m128 maxValue = _mm_set1_ps(-FLT_MAX);
+        for(size_t i = 0; i < center[0].size(); i += 4)
+        {
+            __m128 c = d;
+            __m128 e = _mm_setzero_ps();
+            for(uint32_t axis = 0; axis < 3; axis++)
+            {
+                c = _mm_add_ps(c, _mm_mul_ps(n[axis], _mm_loadu_ps(&center[axis][i])));
+                e = _mm_add_ps(e, _mm_mul_ps(absN[axis], _mm_loadu_ps(&extent[axis][i])));
+            }
+            minValue = _mm_min_ps(minValue, _mm_sub_ps(c, e));
+            maxValue = _mm_max_ps(maxValue, _mm_add_ps(c, e));
+        }
+
+        float minValues[4], maxValues[4];
+        _mm_storeu_ps(minValues, minValue);
+        _mm_storeu_ps(maxValues, maxValue);
+        return glm::vec2(min(min(minValues[0], minValues[1]), min(minValues[2], minValues[3])), max(max(maxValues[0], maxValues[1]), max(maxValues[2], maxValues[3])));
+    }
+
+    void CascadedShadowMaps::collectVisibleInstances(const Camera* pCamera)
+    {
+        mCpuBounds.visible.clear();
+        for(uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            for(uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const auto& pModelInstance = mpScene->getModelInstance(modelID, instanceID);
+                if(pModelInstance->isVisible() == false) continue;
+
+                for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for(uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const auto& pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID);
+                        if(pMeshInstance->isVisible() == false) continue;
+
+                        VisibleInstance instance;
+                        instance.box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                        if(pCamera->isObjectCulled(instance.box)) continue;
+                        instance.pMesh = pMeshInstance->getObject().get();
+                        instance.worldMat = pModelInstance->getTransformMatrix() * pMeshInstance->getTransformMatrix();
+                        mCpuBounds.visible.push_back(instance);
+                    }
+                }
+            }
+        }
+
+        mCpuBounds.receivers.clear();
+        for(const auto& instance : mCpuBounds.visible)
+        {
+            mCpuBounds.receivers.add(instance.box);
+        }
+        mCpuBounds.receivers.pad();
+        mCpuBounds.hasReceivers = (mCpuBounds.visible.empty() == false);
+    }
+
+    void CascadedShadowMaps::calcCpuDepthBounds(const Camera* pCamera, glm::vec2& distanceRange)
+    {
+        collectVisibleInstances(pCamera);
+
+        const float nearPlane = pCamera->getNearPlane();
+        const float farPlane = pCamera->getFarPlane();
+        glm::vec2 depthRange(FLT_MAX, -FLT_MAX);
+
+        // Rasterize the visible meshes. Skinned meshes and meshes which can't be read fall back to their bounds
+        mCpuBounds.unrasterized.clear();
+        if(mControls.sdsmSource == SdsmSource::SoftwareRaster)
+        {
+            const uint32_t height = std::max(1u, (uint32_t)(kCpuDepthBufferWidth / pCamera->getAspectRatio()));
+            if(mCpuBounds.pRasterizer == nullptr)
+            {
+                mCpuBounds.pRasterizer = DepthRasterizer::create(kCpuDepthBufferWidth, height);
+            }
+            else if(mCpuBounds.pRasterizer->getHeight() != height)
+            {
+                mCpuBounds.pRasterizer->resize(kCpuDepthBufferWidth, height);
+            }
+
+            std::vector<Mesh::SharedConstPtr> meshes;
+            for(const auto& instance : mCpuBounds.visible)
+            {
+                if(instance.pMesh->hasBones() == false) meshes.push_back(instance.pMesh->shared_from_this());
+            }
+            mCpuBounds.pRasterizer->cacheMeshes(meshes);
+
+            DepthRasterizer* pRasterizer = mCpuBounds.pRasterizer.get();
+            pRasterizer->begin(pCamera->getViewProjMatrix());
+            for(const auto& instance : mCpuBounds.visible)
+            {
+                if(instance.pMesh->hasBones() || pRasterizer->rasterizeMesh(instance.pMesh, instance.worldMat) == false)
+                {
+                    mCpuBounds.unrasterized.add(instance.box);
+                }
+            }
+
+            glm::vec2 rasterRange;
+            if(pRasterizer->getDepthRange(rasterRange))
+            {
+                depthRange = rasterRange;
+            }
+        }
+        else
+        {
+            for(const auto& instance : mCpuBounds.visible)
+            {
+                mCpuBounds.unrasterized.add(instance.box);
+            }
+        }
+
+        if(mCpuBounds.unrasterized.center[0].size())
+        {
+            // View-space depth is -z
+            const glm::mat4& view = pCamera->getViewMatrix();
+            mCpuBounds.unrasterized.pad();
+            const glm::vec2 boundsRange = mCpuBounds.unrasterized.getRange(-glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]));
+            depthRange = glm::vec2(min(depthRange.x, boundsRange.x), max(depthRange.y, boundsRange.y));
+        }
+
+        if(depthRange.x > depthRange.y)
+        {
+            // Nothing is visible
+            distanceRange = glm::vec2(0, 1);
+            return;
+        }
+
+        distanceRange = (depthRange - nearPlane) / (farPlane - nearPlane);
+        distanceRange = glm::clamp(distanceRange, glm::vec2(0), glm::vec2(1));
+    }
+
     void CascadedShadowMaps::calcDistanceRange(RenderContext* pRenderCtx, const Camera* pCamera, Texture::SharedPtr pDepthBuffer, glm::vec2& distanceRange)
     {
         if(mControls.useMinMaxSdsm)
         {
-            reduceDepthSdsmMinMax(pRenderCtx, pCamera, pDepthBuffer, distanceRange);
+            if(mControls.sdsmSource == SdsmSource::GpuReduction)
+            {
+                reduceDepthSdsmMinMax(pRenderCtx, pCamera, pDepthBuffer, distanceRange);
+            }
+            else
+            {
+                calcCpuDepthBounds(pCamera, distanceRange);
+            }
             distanceRange.x *= 0.9f;
         }
         else
@@ -739,6 +1129,7 @@ namespace Falcor
         mpCsmSceneRenderer->setDepthClamp(mControls.depthClamp);
         pRenderCtx->pushGraphicsState(mShadowPass.pState);
         partitionCascades(pCamera, distanceRange);
+        cullShadowCasters();
         renderScene(pRenderCtx);
 
         if(mCsmData.filterMode == CsmFilterVsm || mCsmData.filterMode == CsmFilterEvsm2 || mCsmData.filterMode == CsmFilterEvsm4)
@@ -32,6 +32,7 @@
 #include "Graphics/Light.h"
 #include "Graphics/Scene/Scene.h"
 #include "Utils/Math/ParallelReduction.h"
+#include "Utils/DepthRasterizer.h"
 
 namespace Falcor
 {
@@ -52,6 +53,35 @@ namespace Falcor
             PSSM,
         };
 
+        /** Where SDSM gets the depth range of the visible pixels from
+        */
+        enum class SdsmSource
+        {
+            GpuReduction,       ///< Reduce the depth buffer on the GPU. The result is read back after the readback latency, so cascades trail the camera or the CPU waits
+            InstanceBounds,     ///< Depth range of the bounding boxes of the visible mesh instances. Computed on the CPU in the same frame
+            SoftwareRaster,     ///< Rasterize the visible meshes into a low-resolution CPU depth buffer. Tighter than InstanceBounds, still no GPU sync
+        };
+
+        /** Instances of a mesh which overlap the same set of cascades. They are drawn with a single instanced draw, and the geometry shader only emits their triangles into the cascades in the mask
+        */
+        struct CasterBatch
+        {
+            const Scene::ModelInstance* pModelInstance;
+            uint32_t meshID;
+            uint32_t cascadeMask;       ///< Bit c is set if the instances overlap cascade c
+            uint32_t firstInstance;     ///< Offset of the first instance in CasterList::instances
+            uint32_t instanceCount;
+        };
+
+        /** The shadow casters of the last setup() call
+        */
+        struct CasterList
+        {
+            std::vector<CasterBatch> batches;
+            std::vector<const Model::MeshInstance*> instances;
+            uint32_t cascadeInstanceCount[CSM_MAX_CASCADES] = {};   ///< Number of mesh instances drawn into each cascade. Empty cascades are not drawn
+        };
+
         /** Destructor
         */
         ~CascadedShadowMaps();
@@ -86,6 +116,9 @@ namespace Falcor
         void setVsmLightBleedReduction(float reduction) { mCsmData.lightBleedingReduction = reduction; }
         void setDepthBias(float depthBias) { mCsmData.depthBias = depthBias; }
         void setSdsmReadbackLatency(uint32_t latency);
+        void setSdsmSource(SdsmSource source) { mControls.sdsmSource = source; }
+        SdsmSource getSdsmSource() const { return mControls.sdsmSource; }
+        const CasterList& getShadowCasters() const { return mCasters; }
     private:
         CascadedShadowMaps(uint32_t mapWidth, uint32_t mapHeight, Light::SharedConstPtr pLight, Scene::SharedConstPtr pScene, uint32_t cascadeCount, ResourceFormat shadowMapFormat);
         Light::SharedConstPtr mpLight;
@@ -123,8 +156,45 @@ namespace Falcor
         SdsmData mSdsmData;
         void createSdsmData(Texture::SharedPtr pTexture);
         void reduceDepthSdsmMinMax(RenderContext* pRenderCtx, const Camera* pCamera, Texture::SharedPtr pDepthBuffer, glm::vec2& distanceRange);
+
+        // CPU depth bounds
+        struct VisibleInstance
+        {
+            BoundingBox box;
+            const Mesh* pMesh;
+            glm::mat4 worldMat;
+        };
+
+        // Boxes stored as separate arrays for SSE, padded to a multiple of 4
+        struct BoxArrays
+        {
+            std::vector<float> center[3];
+            std::vector<float> extent[3];
+
+            void clear();
+            void add(const BoundingBox& box);
+            void pad();
+            glm::vec2 getRange(const glm::vec4& plane) const;
+        };
+
+        struct CpuBoundsData
+        {
+            std::vector<VisibleInstance> visible;
+            BoxArrays receivers;                ///< All the visible boxes, used to crop the cascades in light space
+            BoxArrays unrasterized;             ///< Boxes whose depth range comes from the bounds
+            DepthRasterizer::SharedPtr pRasterizer;
+            bool hasReceivers = false;
+        };
+        CpuBoundsData mCpuBounds;
+        void collectVisibleInstances(const Camera* pCamera);
+        void calcCpuDepthBounds(const Camera* pCamera, glm::vec2& distanceRange);
         void createVsmSampleState(uint32_t maxAnisotropy);
 
+        // Shadow-caster culling
+        CasterList mCasters;
+        std::vector<std::pair<uint32_t, const Model::MeshInstance*>> mMeshCasters;   ///< Cascade mask and instance, scratch space of cullShadowCasters()
+        void cullShadowCasters();
+
         GaussianBlur::UniquePtr mpGaussianBlur;
 
         // Depth-pass
@@ -139,6 +209,7 @@ namespace Falcor
         {
             bool depthClamp = true;
             bool useMinMaxSdsm = true;
+            SdsmSource sdsmSource = SdsmSource::GpuReduction;
             glm::vec2 distanceRange = glm::vec2(0, 1);
             float pssmLambda = 0.5f;
             PartitionMode partitionMode = PartitionMode::Logarithmic;
@@ -65,13 +65,13 @@
 #include "API/ComputeContext.h"
 #include "API/QueryHeap.h"
 
-#if defined FALCOR_D3D12 || defined FALCOR_VK
+#ifdef FALCOR_LOW_LEVEL_API
 #include "API/DescriptorSet.h"
 #include "API/LowLevel/DescriptorPool.h"
 #include "API/LowLevel/FencedPool.h"
 #include "API/LowLevel/GpuFence.h"
 #include "API/LowLevel/RootSignature.h"
-#endif //FALCOR_D3D12 || defined FALCOR_VK
+#endif //FALCOR_LOW_LEVEL_API
 
 // Graphics
 #include "Graphics/Camera/Camera.h"
@@ -79,7 +79,11 @@
 #include "Graphics/GraphicsState.h"
 #include "Graphics/FullScreenPass.h"
 #include "Graphics/TextureHelper.h"
+#include "Graphics/TextureCache.h"
+#include "Graphics/DdsFile.h"
+#include "Graphics/VirtualTexture.h"
 #include "Graphics/Light.h"
+#include "Graphics/LightProbe.h"
 #include "Graphics/Program.h"
 #include "Graphics/GraphicsProgram.h"
 #include "Graphics/FboHelper.h"
@@ -90,6 +94,7 @@
 #include "Graphics/Material/Material.h"
 #include "Graphics/Material/BasicMaterial.h"
 #include "Graphics/Material/MaterialSystem.h"
+#include "Graphics/Material/MaterialTable.h"
 #include "Graphics/Material/MaterialEditor.h"
 
 // Model
@@ -99,6 +104,10 @@
 
 // Scene
 #include "Graphics/Scene/Scene.h"
+#include "Graphics/Scene/EmissiveTriangleTable.h"
+#include "Graphics/Scene/LightClusters.h"
+#include "Graphics/Scene/OcclusionCuller.h"
+#include "Graphics/Scene/InstanceBuffers.h"
 #include "Graphics/Scene/SceneRenderer.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
 #include "Graphics/Scene/SceneUtils.h"
@@ -111,8 +120,11 @@
 
 // Utils
 #include "Utils/Bitmap.h"
+#include "Utils/BlockCompression.h"
 #include "Utils/DDSHeader.h"
 #include "Utils/Font.h"
+#include "Utils/FrameTelemetry.h"
+#include "Utils/ImageDiff.h"
 #include "Utils/Gui.h"
 #include "Utils/Logger.h"
 #include "Utils/OS.h"
@@ -127,6 +139,7 @@
 #include "Utils/Video/VideoDecoder.h"
 #include "Utils/ProgressBar.h"
 #include "Utils/ThreadPool.h"
+#include "Utils/DepthRasterizer.h"
 
 // VR
 #include "VR/OpenVR/VRSystem.h"
@@ -203,15 +203,22 @@ namespace Falcor
 
     void Camera::setIntoConstantBuffer(ConstantBuffer* pCB, const std::string& varName) const
     {
-        size_t offset = pCB->getVariableOffset(varName + ".viewMat");
-
-        if (offset == ConstantBuffer::kInvalidOffset)
+        const auto& pReflector = pCB->getBufferReflector();
+        if (mCachedBinding.pReflector != pReflector || mCachedBinding.varName != varName)
         {
-            logWarning("Camera::setIntoConstantBuffer() - variable \"" + varName + "\"not found in constant buffer\n");
-            return;
+            size_t offset = pCB->getVariableOffset(varName + ".viewMat");
+            if (offset == ConstantBuffer::kInvalidOffset)
+            {
+                logWarning("Camera::setIntoConstantBuffer() - variable \"" + varName + "\"not found in constant buffer\n");
+                return;
+            }
+
+            mCachedBinding.pReflector = pReflector;
+            mCachedBinding.varName = varName;
+            mCachedBinding.offset = offset;
         }
 
-        setIntoConstantBuffer(pCB, offset);
+        setIntoConstantBuffer(pCB, mCachedBinding.offset);
     }
 
     void Camera::setIntoConstantBuffer(ConstantBuffer* pBuffer, const std::size_t& offset) const
@@ -32,6 +32,7 @@
 #include "Data/HostDeviceData.h"
 #include <vector>
 #include "graphics/Paths/MovableObject.h"
+#include "API/ProgramReflection.h"
 
 namespace Falcor
 {
@@ -158,6 +159,10 @@ namespace Falcor
         */
         bool isObjectCulled(const BoundingBox& box) const;
 
+        /** Set the camera data into a constant buffer.
+            The variable offset is resolved on the first call for a buffer layout and reused while the camera is set into buffers with the same layout and variable name.
+            Code which sets the camera into several programs should resolve the offset once per program and use the offset overload.
+        */
         void setIntoConstantBuffer(ConstantBuffer* pBuffer, const std::string& varName) const;
         void setIntoConstantBuffer(ConstantBuffer* pBuffer, const std::size_t& offset) const;
 
@@ -198,5 +203,13 @@ namespace Falcor
             float       negW;   ///< Camera frustum plane, sign of the coordinates
             glm::vec3   sign;   ///< Camera frustum plane position
         } mutable mFrustumPlanes[6];
+
+        /* Offset resolved by the last setIntoConstantBuffer() call which used a variable name */
+        struct
+        {
+            ProgramReflection::BufferReflection::SharedConstPtr pReflector;
+            std::string varName;
+            size_t offset = 0;
+        } mutable mCachedBinding;
     };
 }
\ No newline at end of file
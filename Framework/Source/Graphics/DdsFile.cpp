@@ -0,0 +1,521 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "DdsFile.h"
+#include "API/Device.h"
+#include "API/CopyContext.h"
+#include "Utils/DDSHeader.h"
+#include "Utils/OS.h"
+
+namespace Falcor
+{
+    using namespace DdsHelper;
+
+    static const uint32_t kDdsMagicNumber = 0x20534444;
+
+    static bool checkDdsChannelMask(const DdsHeader::PixelFormat& format, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return (format.rMask == r && format.gMask == g && format.bMask == b && format.aMask == a);
+    }
+
+    static uint32_t makeFourCC(char name[4])
+    {
+        uint32_t fourCC = 0;
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            uint32_t shift = i * 8;
+            fourCC |= ((uint32_t)name[i]) << shift;
+        }
+        return fourCC;
+    }
+
+    static DXGI_FORMAT getRgbDxgiFormat(const DdsHeader::PixelFormat& format)
+    {
+        switch(format.bitcount)
+        {
+        case 32:
+            if(checkDdsChannelMask(format, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+            {
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            }
+
+            if(checkDdsChannelMask(format, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+            {
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+            }
+
+            if(checkDdsChannelMask(format, 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
+            {
+                return DXGI_FORMAT_B8G8R8X8_UNORM;
+            }
+
+            if(checkDdsChannelMask(format, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+            {
+                return DXGI_FORMAT_R10G10B10A2_UNORM;
+            }
+
+            if(checkDdsChannelMask(format, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
+            {
+                return DXGI_FORMAT_R16G16_UNORM;
+            }
+
+            if(checkDdsChannelMask(format, 0xffffffff, 0x00000000, 0x00000000, 0x00000000))
+            {
+                return DXGI_FORMAT_R32_FLOAT;
+            }
+            break;
+
+        case 16:
+            if(checkDdsChannelMask(format, 0x7c00, 0x03e0, 0x001f, 0x8000))
+            {
+                return DXGI_FORMAT_B5G5R5A1_UNORM;
+            }
+            if(checkDdsChannelMask(format, 0xf800, 0x07e0, 0x001f, 0x0000))
+            {
+                return DXGI_FORMAT_B5G6R5_UNORM;
+            }
+
+            if(checkDdsChannelMask(format, 0x0f00, 0x00f0, 0x000f, 0xf000))
+            {
+                return DXGI_FORMAT_B4G4R4A4_UNORM;
+            }
+            break;
+        }
+        should_not_get_here();
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    static DXGI_FORMAT getLuminanceDxgiFormat(const DdsHeader::PixelFormat& format)
+    {
+        switch(format.bitcount)
+        {
+        case 16:
+            if(checkDdsChannelMask(format, 0x0000ffff, 0x00000000, 0x00000000, 0x00000000))
+            {
+                return DXGI_FORMAT_R16_UNORM;
+            }
+            if(checkDdsChannelMask(format, 0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
+            {
+                return DXGI_FORMAT_R8G8_UNORM;
+            }
+            break;
+        case 8:
+            if(checkDdsChannelMask(format, 0x000000ff, 0x00000000, 0x00000000, 0x00000000))
+            {
+                return DXGI_FORMAT_R8_UNORM;
+            }
+            break;
+        }
+        should_not_get_here();
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    static DXGI_FORMAT getDxgiAlphaFormat(const DdsHeader::PixelFormat& format)
+    {
+        switch(format.bitcount)
+        {
+        case 8:
+            return DXGI_FORMAT_A8_UNORM;
+        default:
+            should_not_get_here();
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    static DXGI_FORMAT getDxgiBumpFormat(const DdsHeader::PixelFormat& format)
+    {
+        switch(format.bitcount)
+        {
+        case 16:
+            if(checkDdsChannelMask(format, 0x00ff, 0xff00, 0x0000, 0x0000))
+            {
+                return DXGI_FORMAT_R8G8_SNORM;
+            }
+            break;
+        case 32:
+            if(checkDdsChannelMask(format, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+            {
+                return DXGI_FORMAT_R8G8B8A8_SNORM;
+            }
+            if(checkDdsChannelMask(format, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
+            {
+                return DXGI_FORMAT_R16G16_SNORM;
+            }
+            break;
+        }
+        should_not_get_here();
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    static DXGI_FORMAT getDxgiFormatFrom4CC(uint32_t fourCC)
+    {
+        if(fourCC == makeFourCC("DXT1"))
+        {
+            return DXGI_FORMAT_BC1_UNORM;
+        }
+        if(fourCC == makeFourCC("DXT2"))
+        {
+            return DXGI_FORMAT_BC2_UNORM;
+        }
+        if(fourCC == makeFourCC("DXT3"))
+        {
+            return DXGI_FORMAT_BC2_UNORM;
+        }
+        if(fourCC == makeFourCC("DXT4"))
+        {
+            return DXGI_FORMAT_BC3_UNORM;
+        }
+        if(fourCC == makeFourCC("DXT5"))
+        {
+            return DXGI_FORMAT_BC3_UNORM;
+        }
+
+        if(fourCC == makeFourCC("ATI1"))
+        {
+            return DXGI_FORMAT_BC4_UNORM;
+        }
+        if(fourCC == makeFourCC("BC4U"))
+        {
+            return DXGI_FORMAT_BC4_UNORM;
+        }
+        if(fourCC == makeFourCC("BC4S"))
+        {
+            return DXGI_FORMAT_BC4_SNORM;
+        }
+
+        if(fourCC == makeFourCC("ATI2"))
+        {
+            return DXGI_FORMAT_BC5_UNORM;
+        }
+        if(fourCC == makeFourCC("BC5U"))
+        {
+            return DXGI_FORMAT_BC5_UNORM;
+        }
+        if(fourCC == makeFourCC("BC5S"))
+        {
+            return DXGI_FORMAT_BC5_SNORM;
+        }
+
+        if(fourCC == makeFourCC("RGBG"))
+        {
+            return DXGI_FORMAT_R8G8_B8G8_UNORM;
+        }
+        if(fourCC == makeFourCC("GRGB"))
+        {
+            return DXGI_FORMAT_G8R8_G8B8_UNORM;
+        }
+
+        if(fourCC == makeFourCC("YUY2"))
+        {
+            return DXGI_FORMAT_YUY2;
+        }
+
+        switch(fourCC)
+        {
+        case 36:
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case 110:
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case 111:
+            return DXGI_FORMAT_R16_FLOAT;
+        case 112:
+            return DXGI_FORMAT_R16G16_FLOAT;
+        case 113:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case 114:
+            return DXGI_FORMAT_R32_FLOAT;
+        case 115:
+            return DXGI_FORMAT_R32G32_FLOAT;
+        case 116:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        }
+
+        should_not_get_here();
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    static DXGI_FORMAT getDxgiFormatFromPixelFormat(const DdsHeader::PixelFormat& format)
+    {
+        if(format.flags & DdsHeader::PixelFormat::kRgbMask)
+        {
+            return getRgbDxgiFormat(format);
+        }
+        else if (format.flags & DdsHeader::PixelFormat::kLuminanceMask)
+        {
+            return getLuminanceDxgiFormat(format);
+        }
+        else if(format.flags & DdsHeader::PixelFormat::kAlphaMask)
+        {
+            return getDxgiAlphaFormat(format);
+        }
+        else if (format.flags & DdsHeader::PixelFormat::kBumpMask)
+        {
+            return getDxgiBumpFormat(format);
+        }
+        else if(format.flags & DdsHeader::PixelFormat::kFourCCFlag)
+        {
+            return getDxgiFormatFrom4CC(format.fourCC);
+        }
+
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    static DdsFile::SharedPtr openError(const std::string& filename, const std::string& msg)
+    {
+        logError("DdsFile::open() - " + msg + " '" + filename + "'");
+        return nullptr;
+    }
+
+    DdsFile::~DdsFile()
+    {
+        if (mpData) unmapFile(mpData);
+    }
+
+    DdsFile::SharedPtr DdsFile::open(const std::string& filename)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            return openError(filename, "can't find");
+        }
+
+        size_t size = 0;
+        const uint8_t* pData = (const uint8_t*)mapFileForReading(fullpath, size);
+        if (pData == nullptr)
+        {
+            return openError(filename, "can't open");
+        }
+
+        // The object owns the mapping from here on
+        SharedPtr pFile = SharedPtr(new DdsFile);
+        pFile->mpData = pData;
+        pFile->mSize = size;
+
+        size_t offset = sizeof(uint32_t) + sizeof(DdsHeader);
+        if (size < offset || *(const uint32_t*)pData != kDdsMagicNumber)
+        {
+            return openError(filename, "not a valid DDS file");
+        }
+
+        const DdsHeader& header = *(const DdsHeader*)(pData + sizeof(uint32_t));
+        const DdsHeaderDX10* pDx10Header = nullptr;
+        if ((header.pixelFormat.flags & DdsHeader::PixelFormat::kFourCCFlag) && (makeFourCC("DX10") == header.pixelFormat.fourCC))
+        {
+            if (size < offset + sizeof(DdsHeaderDX10))
+            {
+                return openError(filename, "truncated header in");
+            }
+            pDx10Header = (const DdsHeaderDX10*)(pData + offset);
+            offset += sizeof(DdsHeaderDX10);
+        }
+
+        pFile->mFormat = falcorFormatFromDXGIFormat(pDx10Header ? pDx10Header->dxgiFormat : getDxgiFormatFromPixelFormat(header.pixelFormat));
+        if (pFile->mFormat == ResourceFormat::Unknown)
+        {
+            return openError(filename, "unsupported format in");
+        }
+
+#ifdef FALCOR_VK
+        // Vulkan has no BGRX formats. Upload as BGRA and fill the alpha channel
+        if (pFile->mFormat == ResourceFormat::BGRX8Unorm || pFile->mFormat == ResourceFormat::BGRX8UnormSrgb)
+        {
+            pFile->mFormat = (pFile->mFormat == ResourceFormat::BGRX8Unorm) ? ResourceFormat::BGRA8Unorm : ResourceFormat::BGRA8UnormSrgb;
+            pFile->mFillAlpha = true;
+        }
+#endif
+
+        pFile->mWidth = std::max(header.width, 1u);
+        pFile->mHeight = std::max(header.height, 1u);
+        pFile->mMipCount = (header.flags & DdsHeader::kMipCountMask) ? std::max(header.mipCount, 1u) : 1;
+
+        if (pDx10Header)
+        {
+            pFile->mArraySize = std::max(pDx10Header->arraySize, 1u);
+            switch (pDx10Header->resourceDimension)
+            {
+            case D3D10_RESOURCE_DIMENSION_TEXTURE1D:
+                pFile->mType = Texture::Type::Texture1D;
+                pFile->mHeight = 1;
+                break;
+            case D3D10_RESOURCE_DIMENSION_TEXTURE2D:
+                pFile->mType = (pDx10Header->miscFlag & DdsHeaderDX10::kCubeMapMask) ? Texture::Type::TextureCube : Texture::Type::Texture2D;
+                break;
+            case D3D10_RESOURCE_DIMENSION_TEXTURE3D:
+                pFile->mType = Texture::Type::Texture3D;
+                pFile->mDepth = std::max(header.depth, 1u);
+                pFile->mArraySize = 1;
+                break;
+            default:
+                return openError(filename, "the resource dimension is not supported by Falcor in");
+            }
+        }
+        else if (header.flags & DdsHeader::kDepthMask)
+        {
+            pFile->mType = Texture::Type::Texture3D;
+            pFile->mDepth = std::max(header.depth, 1u);
+        }
+        else if (header.caps[1] & DdsHeader::kCaps2CubeMapMask)
+        {
+            pFile->mType = Texture::Type::TextureCube;
+        }
+
+        // Locate the subresources
+        const ResourceFormat format = pFile->mFormat;
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+        const uint32_t bytesPerBlock = getFormatBytesPerBlock(format);
+
+        // Validate the counts before allocating anything based on them
+        uint32_t maxMipCount = 1;
+        for (uint32_t dim = std::max(std::max(pFile->mWidth, pFile->mHeight), pFile->mDepth); dim > 1; dim >>= 1) maxMipCount++;
+        if (pFile->mMipCount > maxMipCount)
+        {
+            return openError(filename, "invalid mip count in");
+        }
+
+        // Every subresource takes at least one block, so a larger count can't fit in the file
+        const uint64_t subresourceCount = (uint64_t)pFile->mArraySize * ((pFile->mType == Texture::Type::TextureCube) ? 6 : 1) * pFile->mMipCount;
+        if (subresourceCount * bytesPerBlock > size - offset)
+        {
+            return openError(filename, "invalid array size or truncated data in");
+        }
+
+        const uint32_t sliceCount = pFile->getSliceCount();
+        pFile->mSubresources.resize(sliceCount * pFile->mMipCount);
+
+        for (uint32_t slice = 0; slice < sliceCount; slice++)
+        {
+            for (uint32_t mip = 0; mip < pFile->mMipCount; mip++)
+            {
+                Subresource& s = pFile->mSubresources[slice * pFile->mMipCount + mip];
+                s.width = std::max(pFile->mWidth >> mip, 1u);
+                s.height = std::max(pFile->mHeight >> mip, 1u);
+                s.depth = std::max(pFile->mDepth >> mip, 1u);
+                s.rowPitch = ((s.width + blockWidth - 1) / blockWidth) * bytesPerBlock;
+                s.rowCount = (s.height + blockHeight - 1) / blockHeight;
+                s.size = (size_t)s.rowPitch * s.rowCount * s.depth;
+                if (offset + s.size > size)
+                {
+                    return openError(filename, "truncated data in");
+                }
+                s.pData = pData + offset;
+                offset += s.size;
+            }
+        }
+
+        return pFile;
+    }
+
+    void DdsFile::uploadMip(CopyContext* pContext, const Texture* pTexture, uint32_t mipLevel)
+    {
+        for (uint32_t slice = 0; slice < getSliceCount(); slice++)
+        {
+            const Subresource& s = getSubresource(slice, mipLevel);
+            const void* pSrc = s.pData;
+            if (mFillAlpha)
+            {
+                // The only case the mapped data can't be used as-is
+                mScratch.assign(s.pData, s.pData + s.size);
+                for (size_t i = 3; i < mScratch.size(); i += 4) mScratch[i] = 0xff;
+                pSrc = mScratch.data();
+            }
+            pContext->updateTextureSubresource(pTexture, pTexture->getSubresourceIndex(slice, mipLevel), pSrc);
+        }
+    }
+
+    Texture::SharedPtr DdsFile::createTexture(Texture::BindFlags bindFlags, bool generateMips, size_t mipTailSize)
+    {
+        const uint32_t mipLevels = generateMips ? Texture::kMaxPossible : mMipCount;
+        Texture::SharedPtr pTexture;
+        switch (mType)
+        {
+        case Texture::Type::Texture1D:
+            pTexture = Texture::create1D(mWidth, mFormat, mArraySize, mipLevels, nullptr, bindFlags);
+            break;
+        case Texture::Type::Texture2D:
+            pTexture = Texture::create2D(mWidth, mHeight, mFormat, mArraySize, mipLevels, nullptr, bindFlags);
+            break;
+        case Texture::Type::Texture3D:
+            pTexture = Texture::create3D(mWidth, mHeight, mDepth, mFormat, mipLevels, nullptr, bindFlags);
+            break;
+        case Texture::Type::TextureCube:
+            pTexture = Texture::createCube(mWidth, mHeight, mFormat, mArraySize, mipLevels, nullptr, bindFlags);
+            break;
+        default:
+            should_not_get_here();
+        }
+        if (pTexture == nullptr)
+        {
+            return nullptr;
+        }
+
+        CopyContext* pContext = gpDevice->getRenderContext().get();
+        mpTexture = nullptr;
+        mResidentMip = 0;
+
+        if (generateMips)
+        {
+            uploadMip(pContext, pTexture.get(), 0);
+            pTexture->generateMips();
+            return pTexture;
+        }
+
+        // Upload from the coarsest level. Always upload the last level, so that the texture has valid content
+        mResidentMip = mMipCount - 1;
+        uploadMip(pContext, pTexture.get(), mResidentMip);
+        while (mResidentMip > 0 && (mipTailSize == 0 || getSubresource(0, mResidentMip - 1).size <= mipTailSize))
+        {
+            mResidentMip--;
+            uploadMip(pContext, pTexture.get(), mResidentMip);
+        }
+
+        // Keep a reference until streamNextMip() uploaded the rest of the chain
+        if (mResidentMip > 0)
+        {
+            mpTexture = pTexture;
+        }
+        return pTexture;
+    }
+
+    bool DdsFile::streamNextMip(CopyContext* pContext)
+    {
+        if (mpTexture == nullptr)
+        {
+            return false;
+        }
+
+        mResidentMip--;
+        uploadMip(pContext, mpTexture.get(), mResidentMip);
+        if (mResidentMip == 0)
+        {
+            mpTexture = nullptr;
+            return false;
+        }
+        return true;
+    }
+}
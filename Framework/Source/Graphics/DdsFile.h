@@ -0,0 +1,124 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include "API/Texture.h"
+
+namespace Falcor
+{
+    class CopyContext;
+
+    /** Memory-mapped DDS file.
+        open() only parses the header. The payload stays mapped and every subresource is addressed in place, so the texels are copied once, from the file view straight into the upload heap.
+        DDS stores rows top to bottom, which is the layout D3D and Vulkan expect and the one TextureHelper loads every image in, so no flip is needed.
+        The payload is ordered by array slice (cube faces are slices), then by mip, which is the order of Texture::getSubresourceIndex().
+    */
+    class DdsFile
+    {
+    public:
+        using SharedPtr = std::shared_ptr<DdsFile>;
+        using SharedConstPtr = std::shared_ptr<const DdsFile>;
+
+        /** Where a subresource lives in the mapped file
+        */
+        struct Subresource
+        {
+            const uint8_t* pData = nullptr;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t depth = 0;
+            uint32_t rowPitch = 0;      ///< Bytes per row of blocks
+            uint32_t rowCount = 0;      ///< Rows of blocks per depth slice
+            size_t size = 0;
+        };
+
+        ~DdsFile();
+
+        /** Open a DDS file
+            \param[in] filename The file to open. If it can't be found relative to the current directory, the common directories are searched
+            \return A new object, or nullptr if the file doesn't exist, is truncated or uses a format Falcor doesn't support
+        */
+        static SharedPtr open(const std::string& filename);
+
+        /** Create a texture from the file. The levels are uploaded from the coarsest to the finest.
+            \param[in] bindFlags The bind flags to create the texture with
+            \param[in] generateMips If true, only mip 0 is uploaded and the rest of the chain is generated on the GPU
+            \param[in] mipTailSize If not 0, only the levels which take at most mipTailSize bytes per array slice are uploaded, plus the coarsest level. The finer levels are uploaded by streamNextMip(), so the texture can be used, at a lower resolution, before they arrive
+            \return The new texture, or nullptr if it can't be created
+        */
+        Texture::SharedPtr createTexture(Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource, bool generateMips = false, size_t mipTailSize = 0);
+
+        /** Upload the next finer mip level of the texture created by createTexture(). The file must stay open until the function returns false.
+            \return true if there are more levels to upload
+        */
+        bool streamNextMip(CopyContext* pContext);
+
+        /** Get the most detailed level uploaded so far. Bind the texture with getSRV(getResidentMip()) while it is streaming
+        */
+        uint32_t getResidentMip() const { return mResidentMip; }
+
+        /** Get a subresource
+            \param[in] arraySlice The array slice. For cubemaps, this is arraySlice * 6 + face
+        */
+        const Subresource& getSubresource(uint32_t arraySlice, uint32_t mipLevel) const { return mSubresources[arraySlice * mMipCount + mipLevel]; }
+
+        Texture::Type getType() const { return mType; }
+        ResourceFormat getFormat() const { return mFormat; }
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        uint32_t getDepth() const { return mDepth; }
+        uint32_t getArraySize() const { return mArraySize; }
+        uint32_t getMipCount() const { return mMipCount; }
+
+        /** Get the number of stored slices, including the cubemap faces
+        */
+        uint32_t getSliceCount() const { return (mType == Texture::Type::TextureCube) ? mArraySize * 6 : mArraySize; }
+
+    private:
+        DdsFile() = default;
+        void uploadMip(CopyContext* pContext, const Texture* pTexture, uint32_t mipLevel);
+
+        const uint8_t* mpData = nullptr;
+        size_t mSize = 0;
+        Texture::Type mType = Texture::Type::Texture2D;
+        ResourceFormat mFormat = ResourceFormat::Unknown;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        uint32_t mDepth = 1;
+        uint32_t mArraySize = 1;
+        uint32_t mMipCount = 1;
+        bool mFillAlpha = false;
+        std::vector<Subresource> mSubresources;
+
+        Texture::SharedPtr mpTexture;
+        uint32_t mResidentMip = 0;
+        std::vector<uint8_t> mScratch;
+    };
+}
@@ -83,21 +83,29 @@ namespace Falcor
 
     void Light::setIntoConstantBuffer(ConstantBuffer* pBuffer, const std::string& varName)
     {
-        size_t offset = pBuffer->getVariableOffset(varName + ".worldPos");
-        if (offset == ConstantBuffer::kInvalidOffset)
+        const auto& pReflector = pBuffer->getBufferReflector();
+        if (mCachedBinding.pReflector != pReflector || mCachedBinding.varName != varName)
         {
-            logWarning("AreaLight::setIntoConstantBuffer() - variable \"" + varName + "\"not found in constant buffer\n");
-            return;
-        }
+            size_t offset = pBuffer->getVariableOffset(varName + ".worldPos");
+            if (offset == ConstantBuffer::kInvalidOffset)
+            {
+                logWarning("Light::setIntoConstantBuffer() - variable \"" + varName + "\"not found in constant buffer\n");
+                return;
+            }
+
+            check_offset(worldDir);
+            check_offset(intensity);
+            check_offset(aabbMin);
+            check_offset(aabbMax);
+            check_offset(transMat);
+            check_offset(numIndices);
 
-        check_offset(worldDir);
-        check_offset(intensity);
-        check_offset(aabbMin);
-        check_offset(aabbMax);
-        check_offset(transMat);
-        check_offset(numIndices);
+            mCachedBinding.pReflector = pReflector;
+            mCachedBinding.varName = varName;
+            mCachedBinding.offset = offset;
+        }
 
-        setIntoConstantBuffer(pBuffer, offset);
+        setIntoConstantBuffer(pBuffer, mCachedBinding.offset);
     }
 
     void Light::resetGlobalIdCounter()
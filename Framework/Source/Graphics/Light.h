@@ -35,6 +35,7 @@
 #include "Utils/Gui.h"
 #include "Graphics/Model/Model.h"
 #include "Graphics/Paths/MovableObject.h"
+#include "API/ProgramReflection.h"
 
 namespace Falcor
 {
@@ -53,6 +54,8 @@ namespace Falcor
         virtual ~Light() = default;
 
         /** Set the light parameters into a program. To use this you need to include 'Falcor.h' inside your shader.
+            The variable offset is resolved on the first call for a buffer layout and reused while the light is set into buffers with the same layout and variable name.
+            Code which sets the light into several programs should resolve the offset once per program and use the offset overload.
             \param[in] pBuffer The constant buffer to set the parameters into.
             \param[in] varName The name of the light variable in the program.
         */
@@ -120,6 +123,14 @@ namespace Falcor
         glm::vec3 mUiLightIntensityColor = glm::vec3(0.5f, 0.5f, 0.5f);
         float     mUiLightIntensityScale = 1.0f;
         LightData mData;
+
+        /* Offset resolved by the last setIntoConstantBuffer() call which used a variable name. Holding the reflection guarantees a cached offset is never matched against a different buffer layout */
+        struct
+        {
+            ProgramReflection::BufferReflection::SharedConstPtr pReflector;
+            std::string varName;
+            size_t offset = 0;
+        } mCachedBinding;
     };
 
     /** Directional light source.
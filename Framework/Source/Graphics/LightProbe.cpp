@@ -0,0 +1,682 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/LightProbe.h"
+#include "Graphics/TextureHelper.h"
+#include "Graphics/TextureCache.h"
+#include "API/Device.h"
+#include "API/RenderContext.h"
+#include "API/ProgramVars.h"
+#include "Utils/OS.h"
+#include "glm/gtc/packing.hpp"
+#include <xmmintrin.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kCacheMagic = 'F' | ('P' << 8) | ('R' << 16) | ('B' << 24);
+        const uint32_t kCacheVersion = 1;
+        const uint32_t kMaxSourceWidth = 2048;
+        const uint32_t kMaxShWidth = 256;
+        const uint32_t kBrdfLutSize = 64;
+        const uint32_t kBrdfLutSampleCount = 512;
+        const float kPi = 3.14159265f;
+
+        struct CacheHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t mipCount;
+        };
+
+        /** An equirectangular image, laid out like dirToSphericalCrd(): u follows the azimuth, v goes from +Y to -Y
+        */
+        struct Image
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<glm::vec4> texels;
+        };
+
+        struct BakeResult
+        {
+            glm::vec4 sh[9];
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t mipCount = 0;
+            std::vector<uint16_t> halfs;    // RGBA16Float, all the levels back to back
+        };
+
+        template<typename WorkerType>
+        void runWorkers(uint32_t threadCount, const WorkerType& worker)
+        {
+            std::vector<std::thread> threads;
+            for (uint32_t i = 1; i < threadCount; i++)
+            {
+                threads.push_back(std::thread(worker));
+            }
+            worker();
+            for (auto& t : threads) t.join();
+        }
+
+        glm::vec3 equirectToDir(float u, float v)
+        {
+            float phi = (2 * u - 1) * kPi;
+            float theta = v * kPi;
+            return glm::vec3(sin(theta) * cos(phi), cos(theta), -sin(theta) * sin(phi));
+        }
+
+        glm::vec2 dirToEquirect(const glm::vec3& dir)
+        {
+            return glm::vec2((1 + atan2(-dir.z, dir.x) / kPi) * 0.5f, acos(glm::clamp(dir.y, -1.0f, 1.0f)) / kPi);
+        }
+
+        Image downsample(const Image& src)
+        {
+            Image dst;
+            dst.width = std::max(1u, src.width >> 1);
+            dst.height = std::max(1u, src.height >> 1);
+            dst.texels.resize(dst.width * dst.height);
+            for (uint32_t y = 0; y < dst.height; y++)
+            {
+                uint32_t y0 = std::min(y * 2, src.height - 1);
+                uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+                for (uint32_t x = 0; x < dst.width; x++)
+                {
+                    uint32_t x0 = std::min(x * 2, src.width - 1);
+                    uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+                    dst.texels[y * dst.width + x] = 0.25f * (src.texels[y0 * src.width + x0] + src.texels[y0 * src.width + x1] + src.texels[y1 * src.width + x0] + src.texels[y1 * src.width + x1]);
+                }
+            }
+            return dst;
+        }
+
+        /** Bilinear fetch, wrapping horizontally and clamping vertically
+        */
+        __m128 sampleBilinear(const Image& image, const glm::vec2& uv)
+        {
+            float x = uv.x * image.width - 0.5f;
+            float y = uv.y * image.height - 0.5f;
+            float fx = floor(x);
+            float fy = floor(y);
+            int32_t w = (int32_t)image.width;
+            int32_t h = (int32_t)image.height;
+            int32_t x0 = ((int32_t)fx % w + w) % w;
+            int32_t x1 = (x0 + 1) % w;
+            int32_t y0 = glm::clamp((int32_t)fy, 0, h - 1);
+            int32_t y1 = glm::clamp((int32_t)fy + 1, 0, h - 1);
+
+            const float* pTexels = &image.texels[0].x;
+            __m128 t00 = _mm_loadu_ps(pTexels + (y0 * w + x0) * 4);
+            __m128 t10 = _mm_loadu_ps(pTexels + (y0 * w + x1) * 4);
+            __m128 t01 = _mm_loadu_ps(pTexels + (y1 * w + x0) * 4);
+            __m128 t11 = _mm_loadu_ps(pTexels + (y1 * w + x1) * 4);
+            __m128 wx = _mm_set1_ps(x - fx);
+            __m128 wy = _mm_set1_ps(y - fy);
+            __m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), wx));
+            __m128 bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), wx));
+            return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+        }
+
+        __m128 sampleTrilinear(const std::vector<Image>& mips, const glm::vec3& dir, float lod)
+        {
+            glm::vec2 uv = dirToEquirect(dir);
+            lod = glm::clamp(lod, 0.0f, (float)(mips.size() - 1));
+            uint32_t level = (uint32_t)lod;
+            __m128 c0 = sampleBilinear(mips[level], uv);
+            if (level + 1 == mips.size()) return c0;
+            __m128 c1 = sampleBilinear(mips[level + 1], uv);
+            return _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(c1, c0), _mm_set1_ps(lod - level)));
+        }
+
+        glm::vec2 hammersley(uint32_t i, uint32_t count)
+        {
+            uint32_t bits = i;
+            bits = (bits << 16u) | (bits >> 16u);
+            bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+            bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+            bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+            bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+            return glm::vec2((i + 0.5f) / count, bits * 2.3283064365386963e-10f);
+        }
+
+        /** Sample a GGX half-vector around +Z
+        */
+        glm::vec3 importanceSampleGGX(const glm::vec2& xi, float alpha)
+        {
+            float phi = 2 * kPi * xi.x;
+            float cosTheta = sqrt((1 - xi.y) / (1 + (alpha * alpha - 1) * xi.y));
+            float sinTheta = sqrt(1 - cosTheta * cosTheta);
+            return glm::vec3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta);
+        }
+
+        float evalGGX(float NdotH, float alpha)
+        {
+            float a2 = alpha * alpha;
+            float d = NdotH * NdotH * (a2 - 1) + 1;
+            return a2 / (kPi * d * d);
+        }
+
+        void evalShBasis(const glm::vec3& d, float y[9])
+        {
+            y[0] = 0.282095f;
+            y[1] = 0.488603f * d.y;
+            y[2] = 0.488603f * d.z;
+            y[3] = 0.488603f * d.x;
+            y[4] = 1.092548f * d.x * d.y;
+            y[5] = 1.092548f * d.y * d.z;
+            y[6] = 0.315392f * (3 * d.z * d.z - 1);
+            y[7] = 1.092548f * d.x * d.z;
+            y[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+        }
+
+        /** Project the radiance into L2 SH, then convolve with the clamped cosine and divide by pi, so that evaluating the result gives the diffuse radiance of a white surface
+        */
+        void projectSh(const Image& image, glm::vec4 sh[9])
+        {
+            for (uint32_t i = 0; i < 9; i++) sh[i] = glm::vec4(0);
+
+            const float texelArea = (2 * kPi / image.width) * (kPi / image.height);
+            for (uint32_t y = 0; y < image.height; y++)
+            {
+                const float v = (y + 0.5f) / image.height;
+                const float solidAngle = texelArea * sin(v * kPi);
+                for (uint32_t x = 0; x < image.width; x++)
+                {
+                    float basis[9];
+                    evalShBasis(equirectToDir((x + 0.5f) / image.width, v), basis);
+                    const glm::vec4& radiance = image.texels[y * image.width + x];
+                    for (uint32_t i = 0; i < 9; i++)
+                    {
+                        sh[i] += radiance * (basis[i] * solidAngle);
+                    }
+                }
+            }
+
+            const float bands[3] = { kPi, 2 * kPi / 3, kPi / 4 };
+            for (uint32_t i = 0; i < 9; i++)
+            {
+                const uint32_t band = (i == 0) ? 0 : (i < 4 ? 1 : 2);
+                sh[i] *= bands[band] / kPi;
+                sh[i].w = 0;
+            }
+        }
+
+        struct GgxSample
+        {
+            glm::vec3 L;        // Around +Z, with N = V = +Z
+            float NdotL;
+            float lod;          // Source level matching the sample's solid angle
+        };
+
+        std::vector<GgxSample> generateSamples(float roughness, uint32_t sampleCount, uint32_t sourceWidth, uint32_t sourceHeight)
+        {
+            const float alpha = std::max(roughness * roughness, 1e-4f);
+            const float texelSolidAngle = 4 * kPi / (sourceWidth * sourceHeight);
+            std::vector<GgxSample> samples;
+            for (uint32_t i = 0; i < sampleCount; i++)
+            {
+                glm::vec3 H = importanceSampleGGX(hammersley(i, sampleCount), alpha);
+                GgxSample s;
+                s.L = 2 * H.z * H - glm::vec3(0, 0, 1);
+                s.NdotL = s.L.z;
+                if (s.NdotL <= 0) continue;
+
+                // With N = V, the pdf of L is D(NdotH) / 4
+                const float pdf = evalGGX(H.z, alpha) / 4;
+                const float sampleSolidAngle = 1 / (sampleCount * pdf);
+                s.lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1, 0.0f);
+                samples.push_back(s);
+            }
+            return samples;
+        }
+
+        BakeResult bake(const Image& source, const LightProbe::Desc& desc)
+        {
+            BakeResult result;
+
+            std::vector<Image> mips(1, source);
+            while (mips.back().width > 1 || mips.back().height > 1)
+            {
+                mips.push_back(downsample(mips.back()));
+            }
+
+            // The SH don't need many texels
+            const Image* pShImage = &mips[0];
+            for (const Image& mip : mips)
+            {
+                pShImage = &mip;
+                if (mip.width <= kMaxShWidth) break;
+            }
+            projectSh(*pShImage, result.sh);
+
+            result.width = std::max(2u, desc.specularWidth);
+            result.height = result.width / 2;
+            uint32_t maxMipCount = 1;
+            while ((result.height >> maxMipCount) > 0) maxMipCount++;
+            result.mipCount = glm::clamp(desc.specularMipCount, 1u, maxMipCount);
+
+            // Flatten the levels into rows, the unit of work of the threads
+            struct Row
+            {
+                uint32_t mip;
+                uint32_t y;
+                size_t offset;  // In texels, from the start of the chain
+            };
+            std::vector<Row> rows;
+            std::vector<std::vector<GgxSample>> samples(result.mipCount);
+            size_t texelCount = 0;
+            for (uint32_t mip = 0; mip < result.mipCount; mip++)
+            {
+                uint32_t w = std::max(1u, result.width >> mip);
+                uint32_t h = std::max(1u, result.height >> mip);
+                for (uint32_t y = 0; y < h; y++)
+                {
+                    rows.push_back({ mip, y, texelCount + y * w });
+                }
+                texelCount += w * h;
+                if (mip > 0)
+                {
+                    samples[mip] = generateSamples((float)mip / (result.mipCount - 1), desc.sampleCount, source.width, source.height);
+                }
+            }
+            result.halfs.resize(texelCount * 4);
+
+            // Roughness 0 is a plain resampling of the source
+            const float mip0Lod = std::max(std::log2((float)source.width / result.width), 0.0f);
+
+            std::atomic<uint32_t> nextRow(0);
+            auto worker = [&]()
+            {
+                while (true)
+                {
+                    uint32_t r = nextRow.fetch_add(1);
+                    if (r >= rows.size()) break;
+                    const Row& row = rows[r];
+                    const uint32_t w = std::max(1u, result.width >> row.mip);
+                    const uint32_t h = std::max(1u, result.height >> row.mip);
+                    const std::vector<GgxSample>& mipSamples = samples[row.mip];
+
+                    for (uint32_t x = 0; x < w; x++)
+                    {
+                        const glm::vec3 N = equirectToDir((x + 0.5f) / w, (row.y + 0.5f) / h);
+                        __m128 color;
+                        if (row.mip == 0)
+                        {
+                            color = sampleTrilinear(mips, N, mip0Lod);
+                        }
+                        else
+                        {
+                            const glm::vec3 up = fabs(N.y) < 0.999f ? glm::vec3(0, 1, 0) : glm::vec3(1, 0, 0);
+                            const glm::vec3 T = glm::normalize(glm::cross(up, N));
+                            const glm::vec3 B = glm::cross(N, T);
+
+                            __m128 sum = _mm_setzero_ps();
+                            float weight = 0;
+                            for (const GgxSample& s : mipSamples)
+                            {
+                                const glm::vec3 L = T * s.L.x + B * s.L.y + N * s.L.z;
+                                sum = _mm_add_ps(sum, _mm_mul_ps(sampleTrilinear(mips, L, s.lod), _mm_set1_ps(s.NdotL)));
+                                weight += s.NdotL;
+                            }
+                            color = _mm_mul_ps(sum, _mm_set1_ps(weight > 0 ? 1 / weight : 0));
+                        }
+
+                        float c[4];
+                        _mm_storeu_ps(c, color);
+                        uint16_t* pDst = &result.halfs[(row.offset + x) * 4];
+                        pDst[0] = glm::packHalf1x16(c[0]);
+                        pDst[1] = glm::packHalf1x16(c[1]);
+                        pDst[2] = glm::packHalf1x16(c[2]);
+                        pDst[3] = glm::packHalf1x16(1.0f);
+                    }
+                }
+            };
+
+            const uint32_t threadCount = desc.threadCount ? desc.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+            runWorkers(std::min(threadCount, (uint32_t)rows.size()), worker);
+            return result;
+        }
+
+        /** Resample the faces of a cube map, in D3D order (+X, -X, +Y, -Y, +Z, -Z), into an equirectangular image
+        */
+        Image cubeToEquirect(const Image faces[6], uint32_t width)
+        {
+            Image image;
+            image.width = width;
+            image.height = std::max(1u, width / 2);
+            image.texels.resize(image.width * image.height);
+            for (uint32_t y = 0; y < image.height; y++)
+            {
+                for (uint32_t x = 0; x < image.width; x++)
+                {
+                    const glm::vec3 d = equirectToDir((x + 0.5f) / image.width, (y + 0.5f) / image.height);
+                    const glm::vec3 a = glm::abs(d);
+                    uint32_t face;
+                    float sc, tc, ma;
+                    if (a.x >= a.y && a.x >= a.z)
+                    {
+                        face = d.x > 0 ? 0 : 1;
+                        sc = d.x > 0 ? -d.z : d.z;
+                        tc = -d.y;
+                        ma = a.x;
+                    }
+                    else if (a.y >= a.z)
+                    {
+                        face = d.y > 0 ? 2 : 3;
+                        sc = d.x;
+                        tc = d.y > 0 ? d.z : -d.z;
+                        ma = a.y;
+                    }
+                    else
+                    {
+                        face = d.z > 0 ? 4 : 5;
+                        sc = d.z > 0 ? d.x : -d.x;
+                        tc = -d.y;
+                        ma = a.z;
+                    }
+
+                    const Image& f = faces[face];
+                    uint32_t fx = std::min((uint32_t)((sc / ma + 1) * 0.5f * f.width), f.width - 1);
+                    uint32_t fy = std::min((uint32_t)((tc / ma + 1) * 0.5f * f.height), f.height - 1);
+                    image.texels[y * image.width + x] = f.texels[fy * f.width + fx];
+                }
+            }
+            return image;
+        }
+
+        Image toImage(const std::vector<uint8>& data, uint32_t width, uint32_t height, ResourceFormat format)
+        {
+            Image image;
+            image.width = width;
+            image.height = height;
+            image.texels.resize(width * height);
+            if (format == ResourceFormat::RGBA32Float)
+            {
+                memcpy(image.texels.data(), data.data(), image.texels.size() * sizeof(glm::vec4));
+            }
+            else
+            {
+                assert(format == ResourceFormat::RGBA16Float);
+                const uint16_t* pHalfs = (const uint16_t*)data.data();
+                for (size_t i = 0; i < image.texels.size() * 4; i++)
+                {
+                    image.texels[i / 4][i % 4] = glm::unpackHalf1x16(pHalfs[i]);
+                }
+            }
+            return image;
+        }
+
+        bool loadSource(const std::string& filename, Image& image)
+        {
+            Texture::SharedPtr pTexture = createTextureFromFile(filename, false, false);
+            if (pTexture == nullptr)
+            {
+                return false;
+            }
+            RenderContext* pContext = gpDevice->getRenderContext().get();
+
+            if (pTexture->getType() == Texture::Type::Texture2D)
+            {
+                // Let the GPU decode whatever the format is
+                const uint32_t width = std::min(pTexture->getWidth(), kMaxSourceWidth);
+                const uint32_t height = std::max(1u, pTexture->getHeight() * width / pTexture->getWidth());
+                Texture::SharedPtr pFloat = Texture::create2D(width, height, ResourceFormat::RGBA32Float, 1, 1, nullptr, Resource::BindFlags::RenderTarget | Resource::BindFlags::ShaderResource);
+                pContext->blit(pTexture->getSRV(0, 1, 0, 1), pFloat->getRTV());
+                image = toImage(pContext->readTextureSubresource(pFloat.get(), 0), width, height, ResourceFormat::RGBA32Float);
+
+                // 8-bit images are display-referred
+                if (getFormatType(pTexture->getFormat()) == FormatType::Unorm)
+                {
+                    for (glm::vec4& t : image.texels)
+                    {
+                        t = glm::vec4(glm::pow(glm::vec3(t), glm::vec3(2.2f)), t.w);
+                    }
+                }
+                return true;
+            }
+
+            if (pTexture->getType() == Texture::Type::TextureCube && (pTexture->getFormat() == ResourceFormat::RGBA32Float || pTexture->getFormat() == ResourceFormat::RGBA16Float))
+            {
+                Image faces[6];
+                for (uint32_t face = 0; face < 6; face++)
+                {
+                    faces[face] = toImage(pContext->readTextureSubresource(pTexture.get(), pTexture->getSubresourceIndex(face, 0)), pTexture->getWidth(), pTexture->getHeight(), pTexture->getFormat());
+                }
+                image = cubeToEquirect(faces, std::min(pTexture->getWidth() * 4, kMaxSourceWidth));
+                return true;
+            }
+
+            logError("LightProbe::create() - " + filename + " is not supported. Light probes must be 2D equirectangular maps, or RGBA16Float/RGBA32Float cube maps");
+            return false;
+        }
+
+        std::string getCachePath(const std::string& key)
+        {
+            return TextureCache::getDirectory() + '\\' + key + ".probe";
+        }
+
+        bool loadFromCache(const std::string& key, BakeResult& result)
+        {
+            std::ifstream file(getCachePath(key), std::ios::binary);
+            if (file.fail()) return false;
+
+            CacheHeader header;
+            file.read((char*)&header, sizeof(header));
+            if (file.fail() || header.magic != kCacheMagic || header.version != kCacheVersion) return false;
+
+            // A corrupt header must not make us allocate more than the file holds, or create a texture with more levels than the full mip chain
+            uint32_t maxMipCount = 0;
+            while ((std::max(header.width, header.height) >> maxMipCount) > 0) maxMipCount++;
+            uint64_t texelCount = 0;
+            for (uint32_t mip = 0; mip < std::min(header.mipCount, maxMipCount); mip++)
+            {
+                texelCount += (uint64_t)std::max(1u, header.width >> mip) * std::max(1u, header.height >> mip);
+            }
+            const std::streamoff dataOffset = file.tellg();
+            file.seekg(0, std::ios::end);
+            const uint64_t fileSize = (uint64_t)file.tellg();
+            file.seekg(dataOffset);
+            const uint64_t expectedSize = sizeof(header) + sizeof(result.sh) + texelCount * 4 * sizeof(uint16_t);
+            if (header.width == 0 || header.height == 0 || header.mipCount == 0 || header.mipCount > maxMipCount || fileSize != expectedSize)
+            {
+                logWarning("LightProbe - ignoring the corrupt cache entry '" + getCachePath(key) + "'");
+                return false;
+            }
+
+            result.width = header.width;
+            result.height = header.height;
+            result.mipCount = header.mipCount;
+            result.halfs.resize(texelCount * 4);
+            file.read((char*)result.sh, sizeof(result.sh));
+            file.read((char*)result.halfs.data(), result.halfs.size() * sizeof(uint16_t));
+            return file.fail() == false;
+        }
+
+        void storeToCache(const std::string& key, const BakeResult& result)
+        {
+            // Write to a unique temporary file and rename it, so that readers never see a partial entry
+            const std::string path = getCachePath(key);
+            const uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+            const std::string tempPath = path + '.' + std::to_string(unique) + ".tmp";
+            FILE* pFile = fopen(tempPath.c_str(), "wb");
+            if (pFile == nullptr)
+            {
+                logWarning("LightProbe - can't create '" + tempPath + "'");
+                return;
+            }
+
+            const CacheHeader header = { kCacheMagic, kCacheVersion, result.width, result.height, result.mipCount };
+            bool written = fwrite(&header, sizeof(header), 1, pFile) == 1;
+            written = written && fwrite(result.sh, sizeof(result.sh), 1, pFile) == 1;
+            written = written && fwrite(result.halfs.data(), sizeof(uint16_t), result.halfs.size(), pFile) == result.halfs.size();
+            written = (fclose(pFile) == 0) && written;
+
+            // rename() fails if another writer stored the same probe first
+            if (written == false || std::rename(tempPath.c_str(), path.c_str()) != 0)
+            {
+                std::remove(tempPath.c_str());
+            }
+        }
+    }
+
+    Texture::SharedPtr LightProbe::spBrdfLut;
+    uint64_t LightProbe::sObjectCount = 0;
+
+    LightProbe::~LightProbe()
+    {
+        assert(sObjectCount > 0);
+        sObjectCount--;
+        if (sObjectCount == 0)
+        {
+            // Release the texture while the device is still alive
+            spBrdfLut = nullptr;
+        }
+    }
+
+    const Texture::SharedPtr& LightProbe::getBrdfLut() const
+    {
+        if (spBrdfLut) return spBrdfLut;
+
+        // Split-sum integration: for a view angle and a roughness, the scale and bias applied to F0
+        std::vector<glm::vec2> texels(kBrdfLutSize * kBrdfLutSize);
+        for (uint32_t y = 0; y < kBrdfLutSize; y++)
+        {
+            const float roughness = (y + 0.5f) / kBrdfLutSize;
+            const float alpha = roughness * roughness;
+            const float k = alpha / 2;
+            for (uint32_t x = 0; x < kBrdfLutSize; x++)
+            {
+                const float NdotV = (x + 0.5f) / kBrdfLutSize;
+                const glm::vec3 V(sqrt(1 - NdotV * NdotV), 0, NdotV);
+                glm::vec2 sum(0);
+                for (uint32_t i = 0; i < kBrdfLutSampleCount; i++)
+                {
+                    const glm::vec3 H = importanceSampleGGX(hammersley(i, kBrdfLutSampleCount), alpha);
+                    const float VdotH = glm::dot(V, H);
+                    const glm::vec3 L = 2 * VdotH * H - V;
+                    const float NdotL = L.z;
+                    if (NdotL <= 0) continue;
+
+                    const float G = (NdotV / (NdotV * (1 - k) + k)) * (NdotL / (NdotL * (1 - k) + k));
+                    const float visibility = G * VdotH / (H.z * NdotV);
+                    const float Fc = pow(1 - VdotH, 5.0f);
+                    sum += glm::vec2((1 - Fc) * visibility, Fc * visibility);
+                }
+                texels[y * kBrdfLutSize + x] = sum / (float)kBrdfLutSampleCount;
+            }
+        }
+        spBrdfLut = Texture::create2D(kBrdfLutSize, kBrdfLutSize, ResourceFormat::RG32Float, 1, 1, texels.data());
+        return spBrdfLut;
+    }
+
+    LightProbe::SharedPtr LightProbe::create(uint32_t width, uint32_t height, const glm::vec4* pTexels, const Desc& desc)
+    {
+        if (width == 0 || height == 0 || pTexels == nullptr)
+        {
+            logError("LightProbe::create() - empty source image");
+            return nullptr;
+        }
+
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.texels.assign(pTexels, pTexels + width * height);
+        BakeResult result = bake(image, desc);
+
+        SharedPtr pProbe = SharedPtr(new LightProbe);
+        pProbe->init(result.sh, result.width, result.height, result.mipCount, result.halfs.data());
+        return pProbe->mpSpecular ? pProbe : nullptr;
+    }
+
+    LightProbe::SharedPtr LightProbe::create(const std::string& filename, const Desc& desc)
+    {
+        std::string cacheKey;
+        BakeResult result;
+        if (TextureCache::isEnabled())
+        {
+            const std::string options = "probe|" + std::to_string(kCacheVersion) + '|' + std::to_string(desc.specularWidth) + '|' + std::to_string(desc.specularMipCount) + '|' + std::to_string(desc.sampleCount);
+            cacheKey = TextureCache::getKey(filename, options);
+        }
+
+        if (cacheKey.empty() || loadFromCache(cacheKey, result) == false)
+        {
+            Image image;
+            if (loadSource(filename, image) == false)
+            {
+                return nullptr;
+            }
+            result = bake(image, desc);
+            if (cacheKey.size())
+            {
+                storeToCache(cacheKey, result);
+            }
+        }
+
+        SharedPtr pProbe = SharedPtr(new LightProbe);
+        pProbe->init(result.sh, result.width, result.height, result.mipCount, result.halfs.data());
+        if (pProbe->mpSpecular == nullptr)
+        {
+            return nullptr;
+        }
+        pProbe->mpSpecular->setSourceFilename(filename);
+        return pProbe;
+    }
+
+    void LightProbe::init(const glm::vec4 sh[9], uint32_t width, uint32_t height, uint32_t mipCount, const void* pSpecularData)
+    {
+        mData = {};
+        for (uint32_t i = 0; i < 9; i++)
+        {
+            mData.shIrradiance[i] = sh[i];
+        }
+        mData.specularMipCount = (float)mipCount;
+        mData.intensity = 1;
+        mpSpecular = Texture::create2D(width, height, ResourceFormat::RGBA16Float, 1, mipCount, pSpecularData);
+    }
+
+    void LightProbe::setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const std::string& varName) const
+    {
+        size_t offset = pCB->getVariableOffset(varName + ".specularMipCount");
+        if (offset == ConstantBuffer::kInvalidOffset)
+        {
+            logWarning("LightProbe::setIntoProgramVars() - variable \"" + varName + "\" not found in constant buffer");
+            return;
+        }
+        pCB->setBlob(&mData, offset, sizeof(mData));
+        pVars->setTexture(varName + "Specular", mpSpecular);
+        pVars->setTexture(varName + "BrdfLut", getBrdfLut());
+    }
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Texture.h"
+#include "Data/HostDeviceData.h"
+
+namespace Falcor
+{
+    class ConstantBuffer;
+    class ProgramVars;
+
+    /** Light probe baked on the CPU from an environment map.
+        The environment is projected into L2 spherical harmonics for diffuse lighting, and prefiltered with GGX importance sampling into an equirectangular mip chain for specular lighting, one roughness per level. Specular shading uses the split-sum approximation, with a shared BRDF integration texture (see ShadingUtils/LightProbe.slang).
+        The bake runs on all the hardware threads. Samples are taken from a mip chain of the source, at the level matching the sample's solid angle, which removes most of the noise with a few hundred samples.
+        When the texture cache is enabled (see TextureCache), baked probes are stored in the cache directory, keyed by the content of the source file and the bake options.
+    */
+    class LightProbe
+    {
+    public:
+        using SharedPtr = std::shared_ptr<LightProbe>;
+        using SharedConstPtr = std::shared_ptr<const LightProbe>;
+
+        struct Desc
+        {
+            uint32_t specularWidth = 512;   ///< Width of the first level of the prefiltered map. The height is half of it
+            uint32_t specularMipCount = 7;  ///< Number of roughness levels, clamped to the length of the mip chain
+            uint32_t sampleCount = 256;     ///< GGX samples per texel
+            uint32_t threadCount = 0;       ///< Threads used for the bake. 0 means one per hardware thread
+        };
+
+        /** Bake a probe from an environment map file. Equirectangular maps of any format and RGBA16Float/RGBA32Float cube maps are supported
+            \return A new object, or nullptr if the file can't be loaded
+        */
+        static SharedPtr create(const std::string& filename, const Desc& desc = Desc());
+
+        /** Bake a probe from an equirectangular image in memory
+            \param[in] pTexels width * height RGBA texels, top row first. The layout matches dirToSphericalCrd()
+        */
+        static SharedPtr create(uint32_t width, uint32_t height, const glm::vec4* pTexels, const Desc& desc = Desc());
+
+        ~LightProbe();
+
+        /** Get the split-sum BRDF integration texture. Indexed by (NdotV, roughness), returns the scale and bias to apply to the specular color. Created on first use, shared by all probes and released with the last one
+        */
+        const Texture::SharedPtr& getBrdfLut() const;
+
+        /** Get the prefiltered specular map
+        */
+        const Texture::SharedPtr& getSpecularTexture() const { return mpSpecular; }
+
+        /** Get the shader data. The SH coefficients are in shIrradiance
+        */
+        const LightProbeData& getData() const { return mData; }
+
+        /** Set the scale applied to the probe lighting
+        */
+        void setIntensity(float intensity) { mData.intensity = intensity; }
+        float getIntensity() const { return mData.intensity; }
+
+        /** Bind the probe. The LightProbeData struct is written at varName in the constant buffer, the specular map is bound to the texture <varName>Specular and the BRDF texture to <varName>BrdfLut
+        */
+        void setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const std::string& varName) const;
+
+    private:
+        LightProbe() { sObjectCount++; }
+        void init(const glm::vec4 sh[9], uint32_t width, uint32_t height, uint32_t mipCount, const void* pSpecularData);
+        Texture::SharedPtr mpSpecular;
+        LightProbeData mData;
+
+        // Static
+        static Texture::SharedPtr spBrdfLut;
+        static uint64_t sObjectCount;
+    };
+}
@@ -38,12 +38,14 @@
 namespace Falcor
 {
     uint32_t Material::sMaterialCounter = 0;
+    uint64_t Material::sVersionCounter = 0;
     std::vector<Material::DescId> Material::sDescIdentifier;
 
     Material::Material(const std::string& name) : mName(name)
     {
         mData.values.id = sMaterialCounter;
         sMaterialCounter++;
+        markChanged();
     }
 
     Material::SharedPtr Material::create(const std::string& name)
@@ -123,6 +125,7 @@ namespace Falcor
         desc.blending = (uint32_t)layer.blend;
         vals.pmf = layer.pmf;
         mDescDirty = true;
+        markChanged();
 
         // Update the index by type
         if(desc.type != MatNone && mData.desc.layerIdByType[desc.type].id == -1)
@@ -192,6 +195,7 @@ namespace Falcor
         }
 
         mDescDirty = true;
+        markChanged();
     }
 
     void Material::normalize() const
@@ -297,12 +301,85 @@ namespace Falcor
     }
 
 #if _LOG_ENABLED
-#define check_offset(_a) assert(pCB->getVariableOffset(std::string(varName) + "." + #_a) == (offsetof(MaterialData, _a) + offset))
+#define check_offset(_a) assert(pCB->getVariableOffset(std::string(varName) + "." + #_a) == (offsetof(MaterialData, _a) + bindings.dataOffset))
 #else
 #define check_offset(_a)
 #endif
 
+    Material::ProgramBindings Material::resolveBindings(const ProgramReflection* pReflector, const std::string& cbName, const std::string& varName)
+    {
+        ProgramBindings bindings;
+        const auto& pBufDesc = pReflector->getBufferDesc(cbName, ProgramReflection::BufferReflection::Type::Constant);
+        if (pBufDesc == nullptr)
+        {
+            return bindings;
+        }
+
+        size_t offset;
+        if (pBufDesc->getVariableData(varName + ".desc.layers[0].type", offset) == nullptr)
+        {
+            logError("Material::resolveBindings() - variable \"" + varName + "\" not found in constant buffer \"" + cbName + "\"");
+            return bindings;
+        }
+        bindings.dataOffset = offset;
+
+        const auto pTexDesc = pReflector->getResourceDesc(varName + ".textures.layers");
+        if (pTexDesc)
+        {
+            bindings.texRegSpace = pTexDesc->regSpace;
+            bindings.texRegIndex = pTexDesc->regIndex;
+        }
+        else
+        {
+            logWarning("Material::resolveBindings() - can't find the first texture object");
+        }
+
+        const auto pSamplerDesc = pReflector->getResourceDesc(varName + ".samplerState");
+        if (pSamplerDesc)
+        {
+            bindings.samplerRegSpace = pSamplerDesc->regSpace;
+            bindings.samplerRegIndex = pSamplerDesc->regIndex;
+            bindings.samplerArrayIndex = pSamplerDesc->descOffset;
+        }
+        return bindings;
+    }
+
+    /** Bindings resolved by the name-based setIntoProgramVars(), cached per program reflection.
+        They are keyed by the constant buffer reflection, then by the variable name.
+    */
+    struct NamedBindingCache
+    {
+        NamedBindingCache(const ProgramReflection*) {}
+        mutable std::unordered_map<const ProgramReflection::BufferReflection*, std::unordered_map<std::string, Material::ProgramBindings>> bindings;
+    };
+
     void Material::setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const char varName[]) const
+    {
+        const ProgramReflection* pReflector = pVars->getReflection().get();
+        const auto& pBufDesc = pCB->getBufferReflector();
+        auto& cbBindings = pReflector->getBindingCache<NamedBindingCache>().bindings[pBufDesc.get()];
+        auto it = cbBindings.find(varName);
+        if (it == cbBindings.end())
+        {
+            ProgramBindings bindings = resolveBindings(pReflector, pBufDesc->getName(), varName);
+            if (bindings.isValid())
+            {
+                check_offset(values.layers[0].albedo);
+                check_offset(values.id);
+            }
+            it = cbBindings.emplace(varName, bindings).first;
+        }
+
+        const ProgramBindings& bindings = it->second;
+        if (bindings.isValid() == false)
+        {
+            logError(std::string("Material::setIntoConstantBuffer() - variable \"") + varName + "\"not found in constant buffer\n");
+            return;
+        }
+        setIntoProgramVars(pVars, pCB, bindings);
+    }
+
+    void Material::setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const ProgramBindings& bindings) const
     {
         // OPTME:
         // We can specialize this function based on the API we are using. This might be worth the extra maintenance cost:
@@ -316,26 +393,13 @@ namespace Falcor
         static const size_t dataSize = sizeof(MaterialDesc) + sizeof(MaterialValues);
         static_assert(dataSize % sizeof(glm::vec4) == 0, "Material::MaterialData size should be a multiple of 16");
 
-        size_t offset = pCB->getVariableOffset(std::string(varName) + ".desc.layers[0].type");
-
-        if(offset == ConstantBuffer::kInvalidOffset)
-        {
-            logError(std::string("Material::setIntoConstantBuffer() - variable \"") + varName + "\"not found in constant buffer\n");
-            return;
-        }
-
-        check_offset(values.layers[0].albedo);
-        check_offset(values.id);
-        assert(offset + dataSize <= pCB->getSize());
-
-        pCB->setBlob(&mData, offset, dataSize);
+        assert(bindings.isValid());
+        assert(bindings.dataOffset + dataSize <= pCB->getSize());
+        pCB->setBlob(&mData, bindings.dataOffset, dataSize);
 
         // Now set the textures
-        std::string resourceName = std::string(varName) + ".textures.layers";
-        const auto pResourceDesc = pVars->getReflection()->getResourceDesc(resourceName);
-        if (pResourceDesc == nullptr)
+        if (bindings.texRegSpace == uint32_t(-1))
         {
-            logWarning(std::string("Material::setIntoConstantBuffer() - can't find the first texture object"));
             return;
         }
 
@@ -345,7 +409,7 @@ namespace Falcor
         {
             if (pTextures[i] != nullptr)
             {
-                pVars->setSrv(pResourceDesc->regSpace, pResourceDesc->regIndex, i, pTextures[i]->getSRV());
+                pVars->setSrv(bindings.texRegSpace, bindings.texRegIndex, i, pTextures[i]->getSRV());
             }
         }
 
@@ -355,15 +419,18 @@ namespace Falcor
             if (pTextures[i] != nullptr)
             {
 #ifdef FALCOR_VK
-                uint32_t bindIndex = pResourceDesc->regIndex + 1 + i - MatMaxLayers;
+                uint32_t bindIndex = bindings.texRegIndex + 1 + i - MatMaxLayers;
 #else
-                uint32_t bindIndex = pResourceDesc->regIndex + i;
+                uint32_t bindIndex = bindings.texRegIndex + i;
 #endif
-                pVars->setSrv(pResourceDesc->regSpace, bindIndex, 0, pTextures[i]->getSRV());
+                pVars->setSrv(bindings.texRegSpace, bindIndex, 0, pTextures[i]->getSRV());
             }
         }
 
-        pVars->setSampler("gMaterial.samplerState", mData.samplerState);
+        if (bindings.samplerRegSpace != uint32_t(-1))
+        {
+            pVars->setSampler(bindings.samplerRegSpace, bindings.samplerRegIndex, bindings.samplerArrayIndex, mData.samplerState);
+        }
     }
 
     bool Material::operator==(const Material& other) const
@@ -376,6 +443,7 @@ namespace Falcor
         mData.textures.layers[layerId] = pTexture;
         mData.desc.layers[layerId].hasTexture = (pTexture != nullptr);
         mDescDirty = true;
+        markChanged();
     }
 
     void Material::setNormalMap(Texture::SharedPtr& pNormalMap)
@@ -383,6 +451,7 @@ namespace Falcor
         mData.textures.normalMap = pNormalMap; 
         mData.desc.hasNormalMap = (pNormalMap != nullptr);
         mDescDirty = true;
+        markChanged();
     }
 
     void Material::setAlphaMap(const Texture::SharedPtr& pAlphaMap)
@@ -390,6 +459,7 @@ namespace Falcor
         mData.textures.alphaMap = pAlphaMap;
         mData.desc.hasAlphaMap = (pAlphaMap != nullptr);
         mDescDirty = true;
+        markChanged();
     }
 
     void Material::setAmbientOcclusionMap(const Texture::SharedPtr& pAoMap)
@@ -397,6 +467,7 @@ namespace Falcor
         mData.textures.ambientMap = pAoMap;
         mData.desc.hasAmbientMap = (pAoMap != nullptr);
         mDescDirty = true;
+        markChanged();
     }
 
     void Material::setHeightMap(const Texture::SharedPtr& pHeightMap)
@@ -404,6 +475,7 @@ namespace Falcor
         mData.textures.heightMap = pHeightMap;
         mData.desc.hasHeightMap = (pHeightMap != nullptr);
         mDescDirty = true;
+        markChanged();
     }
 
     void Material::removeDescIdentifier() const
@@ -41,6 +41,7 @@ namespace Falcor
     class Texture;
     class ProgramVars;
     class ConstantBuffer;
+    class ProgramReflection;
 
     /** A surface material object
         The core part of material is the 'SMaterial m_Material' data structure. It consists of multiple layers and modifiers.
@@ -154,7 +155,7 @@ namespace Falcor
 
         /** Set the material ID
         */
-        void setID(int32_t id) { mData.values.id = id; }
+        void setID(int32_t id) { mData.values.id = id; markChanged(); }
         
         /** Reset all global id counter of model, mesh and material
         */
@@ -183,27 +184,27 @@ namespace Falcor
 
         /** Set a layer's type.
         */
-        void setLayerType(uint32_t layerId, Layer::Type type) { mData.desc.layers[layerId].type = (uint32_t)type; mDescDirty = true; }
+        void setLayerType(uint32_t layerId, Layer::Type type) { mData.desc.layers[layerId].type = (uint32_t)type; mDescDirty = true; markChanged(); }
 
         /** Set a layer's NDF
         */
-        void setLayerNdf(uint32_t layerId, Layer::NDF ndf) { mData.desc.layers[layerId].ndf = (uint32_t)ndf; mDescDirty = true; }
+        void setLayerNdf(uint32_t layerId, Layer::NDF ndf) { mData.desc.layers[layerId].ndf = (uint32_t)ndf; mDescDirty = true; markChanged(); }
 
         /** Set a layer's blend
         */
-        void setLayerBlend(uint32_t layerId, Layer::Blend blend) { mData.desc.layers[layerId].blending = (uint32_t)blend; mDescDirty = true; }
+        void setLayerBlend(uint32_t layerId, Layer::Blend blend) { mData.desc.layers[layerId].blending = (uint32_t)blend; mDescDirty = true; markChanged(); }
 
         /** Set a layer's albedo color
         */
-        void setLayerAlbedo(uint32_t layerId, const glm::vec4& albedo) { mData.values.layers[layerId].albedo = albedo; }
+        void setLayerAlbedo(uint32_t layerId, const glm::vec4& albedo) { mData.values.layers[layerId].albedo = albedo; markChanged(); }
 
         /** Set a layer's roughness
         */
-        void setLayerRoughness(uint32_t layerId, const glm::vec4& roughness) { mData.values.layers[layerId].roughness = roughness; }
+        void setLayerRoughness(uint32_t layerId, const glm::vec4& roughness) { mData.values.layers[layerId].roughness = roughness; markChanged(); }
 
         /** Set extra parameters on a layer interpreted based on layer type (IoR, etc.)
         */
-        void setLayerUserParam(uint32_t layerId, const glm::vec4& data) { mData.values.layers[layerId].extraParam = data; }
+        void setLayerUserParam(uint32_t layerId, const glm::vec4& data) { mData.values.layers[layerId].extraParam = data; markChanged(); }
 
         /** Set a layer's texture
         */
@@ -231,7 +232,7 @@ namespace Falcor
 
         /** Set the alpha threshold value
         */
-        void setAlphaThreshold(float threshold) { mData.values.alphaThreshold = threshold; }
+        void setAlphaThreshold(float threshold) { mData.values.alphaThreshold = threshold; markChanged(); }
         
         /** Get the alpha threshold value
         */
@@ -255,7 +256,7 @@ namespace Falcor
 
         /** Set the height scale values
         */
-        void setHeightModifiers(const glm::vec2& mod) { mData.values.height = mod; }
+        void setHeightModifiers(const glm::vec2& mod) { mData.values.height = mod; markChanged(); }
 
         /** Get the height scale value
         */
@@ -267,7 +268,7 @@ namespace Falcor
 
         /** Set the material as double-sided. Meshes with double sided materials should be drawn without culling, and for backfacing polygons, the normal has to be inverted.
         */
-        void setDoubleSided(bool doubleSided) { mDoubleSided = doubleSided; mDescDirty = true; }
+        void setDoubleSided(bool doubleSided) { mDoubleSided = doubleSided; mDescDirty = true; markChanged(); }
 
         /** Set the material parameters into a constant buffer. To use this you need to include 'Falcor.h' inside your shader.
             \param[in] pVars The graphics vars of the shader to set material into.
@@ -276,9 +277,36 @@ namespace Falcor
         */
         void setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const char varName[]) const;
 
+        /** Offsets and bind locations used by setIntoProgramVars(), resolved from the program reflection
+        */
+        struct ProgramBindings
+        {
+            size_t dataOffset = size_t(-1);         ///< Offset of the material data in the constant buffer
+            uint32_t texRegSpace = uint32_t(-1);
+            uint32_t texRegIndex = 0;
+            uint32_t samplerRegSpace = uint32_t(-1);
+            uint32_t samplerRegIndex = 0;
+            uint32_t samplerArrayIndex = 0;
+            bool isValid() const { return dataOffset != size_t(-1); }
+        };
+
+        /** Resolve the bindings of a material variable. Do this once per program and use the result with setIntoProgramVars() to avoid string lookups every draw.
+            \param[in] pReflector The program reflection
+            \param[in] cbName The name of the constant buffer containing the material
+            \param[in] varName The name of the material variable in the buffer
+        */
+        static ProgramBindings resolveBindings(const ProgramReflection* pReflector, const std::string& cbName, const std::string& varName);
+
+        /** Set the material parameters into a constant buffer using pre-resolved bindings.
+            \param[in] pVars The graphics vars of the shader to set material into.
+            \param[in] pCB The constant buffer to set the parameters into.
+            \param[in] bindings The bindings returned by resolveBindings()
+        */
+        void setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const ProgramBindings& bindings) const;
+
         /** Override all sampling types of materials
         */
-        void setSampler(const Sampler::SharedPtr& pSampler) { mData.samplerState = pSampler; }
+        void setSampler(const Sampler::SharedPtr& pSampler) { mData.samplerState = pSampler; markChanged(); }
                 
         /** Return global sampler override 
         */
@@ -297,6 +325,8 @@ namespace Falcor
         uint64_t getDescIdentifier() const;
 
     private:
+        friend class MaterialTable;
+        friend class CpuPathTracer;
         void finalize() const;
         void normalize() const;
         void updateTextureCount() const;
@@ -309,6 +339,9 @@ namespace Falcor
         bool mDoubleSided = false;          ///< Used for culling 
         std::string mName;
         mutable uint32_t mTextureCount = 0;
+        uint64_t mVersion = 0;              ///< Changes whenever the material data changes. Drawn from a global counter, so a new material never matches the version of a deleted one. Used by MaterialTable to skip unchanged materials
+        static uint64_t sVersionCounter;
+        void markChanged() { mVersion = ++sVersionCounter; }
 
         // The next functions and fields are used for material compilation into shaders.
         // We only compile based on the material descriptor, so as an optimization we minimize the number of shader permutations based on the desc
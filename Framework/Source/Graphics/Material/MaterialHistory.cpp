@@ -84,6 +84,12 @@ namespace Falcor
         return mOriginalMaterials.count(pMesh) > 0;
     }
 
+    Material::SharedPtr MaterialHistory::getOriginalMaterial(const Mesh* pMesh) const
+    {
+        auto it = mOriginalMaterials.find(pMesh);
+        return (it == mOriginalMaterials.end()) ? nullptr : it->second;
+    }
+
     void MaterialHistory::onModelRemoved(const Model* pModel)
     {
         for (uint32_t i = 0; i < pModel->getMeshCount(); i++)
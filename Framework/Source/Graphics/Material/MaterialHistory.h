@@ -54,6 +54,9 @@ namespace Falcor
         // Check whether a mesh has its material overridden
         bool hasOverride(const Mesh* pMesh) const;
 
+        // Get the original material of an overridden mesh. Returns nullptr if the mesh doesn't have an override
+        Material::SharedPtr getOriginalMaterial(const Mesh* pMesh) const;
+
         // Revert all mesh material overrides for a model
         void onModelRemoved(const Model* pModel);
 
@@ -0,0 +1,308 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MaterialTable.h"
+#include "Graphics/Scene/Scene.h"
+#include "API/ProgramVars.h"
+
+namespace Falcor
+{
+    const char* MaterialTable::kTableName = "gMaterialTable";
+    const char* MaterialTable::kTexturesName = "gMaterialTextures";
+    const char* MaterialTable::kSamplersName = "gMaterialSamplers";
+
+    static_assert(sizeof(MaterialTextures) == sizeof(Texture::SharedPtr) * (MatMaxLayers + 4), "MaterialTable texture count doesn't match MaterialTextures");
+
+    MaterialTable::SharedPtr MaterialTable::create()
+    {
+        return SharedPtr(new MaterialTable());
+    }
+
+    uint32_t MaterialTable::getTextureIndex(const Texture::SharedPtr& pTexture)
+    {
+        if (pTexture == nullptr) return kInvalidIndex;
+
+        auto it = mTextureIndices.find(pTexture.get());
+        if (it != mTextureIndices.end())
+        {
+            mTextureRefCount[it->second]++;
+            return it->second;
+        }
+
+        uint32_t index;
+        if (mFreeTextureSlots.size())
+        {
+            index = mFreeTextureSlots.back();
+            mFreeTextureSlots.pop_back();
+        }
+        else if (mTextures.size() < MatTableMaxTextures)
+        {
+            index = (uint32_t)mTextures.size();
+            mTextures.push_back(nullptr);
+            mTextureRefCount.push_back(0);
+        }
+        else
+        {
+            if (mOverflowReported == false)
+            {
+                logWarning("MaterialTable - the scene uses more than " + std::to_string(MatTableMaxTextures) + " material textures. Increase MatTableMaxTextures. The remaining textures are replaced with the material constants.");
+                mOverflowReported = true;
+            }
+            return kInvalidIndex;
+        }
+
+        mTextures[index] = pTexture;
+        mTextureRefCount[index] = 1;
+        mTextureIndices[pTexture.get()] = index;
+        return index;
+    }
+
+    uint32_t MaterialTable::getSamplerIndex(const Sampler::SharedPtr& pSampler)
+    {
+        auto it = mSamplerIndices.find(pSampler.get());
+        if (it != mSamplerIndices.end())
+        {
+            mSamplerRefCount[it->second]++;
+            return it->second;
+        }
+
+        uint32_t index;
+        if (mFreeSamplerSlots.size())
+        {
+            index = mFreeSamplerSlots.back();
+            mFreeSamplerSlots.pop_back();
+        }
+        else if (mSamplers.size() < MatTableMaxSamplers)
+        {
+            index = (uint32_t)mSamplers.size();
+            mSamplers.push_back(nullptr);
+            mSamplerRefCount.push_back(0);
+        }
+        else
+        {
+            if (mOverflowReported == false)
+            {
+                logWarning("MaterialTable - the scene uses more than " + std::to_string(MatTableMaxSamplers) + " material samplers. Increase MatTableMaxSamplers. Materials without a sampler use their constant values.");
+                mOverflowReported = true;
+            }
+            return kInvalidIndex;
+        }
+
+        mSamplers[index] = pSampler;
+        mSamplerRefCount[index] = 1;
+        mSamplerIndices[pSampler.get()] = index;
+        return index;
+    }
+
+    void MaterialTable::packEntry(const Material* pMaterial, Entry& entry)
+    {
+        pMaterial->finalize();
+        const MaterialData& data = pMaterial->mData;
+        entry.desc = data.desc;
+        entry.values = data.values;
+
+        auto pTextures = (const Texture::SharedPtr*)&data.textures;
+        for (uint32_t i = 0; i < kTexCount; i++)
+        {
+            entry.textures[i] = getTextureIndex(pTextures[i]);
+        }
+        entry.samplerIndex = getSamplerIndex(data.samplerState);
+    }
+
+    void MaterialTable::releaseEntry(const Entry& entry)
+    {
+        for (uint32_t i = 0; i < kTexCount; i++)
+        {
+            uint32_t index = entry.textures[i];
+            if (index != kInvalidIndex && --mTextureRefCount[index] == 0)
+            {
+                mTextureIndices.erase(mTextures[index].get());
+                mTextures[index] = nullptr;
+                mFreeTextureSlots.push_back(index);
+            }
+        }
+
+        uint32_t index = entry.samplerIndex;
+        if (index != kInvalidIndex && --mSamplerRefCount[index] == 0)
+        {
+            mSamplerIndices.erase(mSamplers[index].get());
+            mSamplers[index] = nullptr;
+            mFreeSamplerSlots.push_back(index);
+        }
+    }
+
+    void MaterialTable::markDirty(size_t index)
+    {
+        mDirtyBegin = (mDirtyEnd > mDirtyBegin) ? std::min(mDirtyBegin, index) : index;
+        mDirtyEnd = std::max(mDirtyEnd, index + 1);
+    }
+
+    bool MaterialTable::update(const Scene* pScene)
+    {
+        // Collect the scene materials and the materials referenced by the meshes. Meshes can use materials which were never added to the scene
+        std::vector<const Material*> materials;
+        std::unordered_map<const Material*, uint32_t> materialIndices;
+        auto addMaterial = [&](const Material* pMaterial)
+        {
+            if (pMaterial == nullptr || materialIndices.find(pMaterial) != materialIndices.end()) return;
+            materialIndices[pMaterial] = (uint32_t)materials.size();
+            materials.push_back(pMaterial);
+        };
+
+        for (uint32_t i = 0; i < pScene->getMaterialCount(); i++)
+        {
+            addMaterial(pScene->getMaterial(i).get());
+        }
+
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                addMaterial(pModel->getMesh(meshID)->getMaterial().get());
+            }
+        }
+
+        // Same materials, only re-pack the ones whose version changed
+        if (materials == mMaterials)
+        {
+            bool changed = false;
+            for (size_t i = 0; i < mMaterials.size(); i++)
+            {
+                if (mMaterials[i]->mVersion == mVersions[i]) continue;
+
+                // Pack before releasing, so that slots shared by the old and new entry are kept
+                Entry entry;
+                packEntry(mMaterials[i], entry);
+                releaseEntry(mEntries[i]);
+                mEntries[i] = entry;
+                mVersions[i] = mMaterials[i]->mVersion;
+                markDirty(i);
+                changed = true;
+            }
+            return changed;
+        }
+
+        // The set of materials changed. Reuse the entries of materials which were already in the table and didn't change
+        std::vector<Entry> entries(materials.size());
+        std::vector<uint32_t> versions(materials.size());
+        std::vector<bool> reused(mMaterials.size(), false);
+        for (size_t i = 0; i < materials.size(); i++)
+        {
+            const Material* pMaterial = materials[i];
+            versions[i] = pMaterial->mVersion;
+            auto it = mMaterialIndices.find(pMaterial);
+            if (it != mMaterialIndices.end() && mVersions[it->second] == pMaterial->mVersion)
+            {
+                entries[i] = mEntries[it->second];
+                reused[it->second] = true;
+                if (it->second != i) markDirty(i);
+            }
+            else
+            {
+                packEntry(pMaterial, entries[i]);
+                markDirty(i);
+            }
+        }
+
+        // Release the slots referenced by materials which were removed or re-packed
+        for (size_t i = 0; i < mEntries.size(); i++)
+        {
+            if (reused[i] == false) releaseEntry(mEntries[i]);
+        }
+
+        mEntries.swap(entries);
+        mVersions.swap(versions);
+        mMaterials.swap(materials);
+        mMaterialIndices.swap(materialIndices);
+        mDirtyEnd = std::min(mDirtyEnd, mEntries.size());
+        return true;
+    }
+
+    uint32_t MaterialTable::getMaterialIndex(const Material* pMaterial) const
+    {
+        auto it = mMaterialIndices.find(pMaterial);
+        return (it == mMaterialIndices.end()) ? kInvalidIndex : it->second;
+    }
+
+    bool MaterialTable::setIntoProgramVars(ProgramVars* pVars)
+    {
+        const ProgramReflection* pReflector = pVars->getReflection().get();
+
+        // (Re)create the buffer if it's too small
+        if (mpBuffer == nullptr || mpBuffer->getElementCount() < mEntries.size())
+        {
+            const auto& pBufDesc = pReflector->getBufferDesc(kTableName, ProgramReflection::BufferReflection::Type::Structured);
+            if (pBufDesc == nullptr)
+            {
+                logWarning(std::string("MaterialTable::setIntoProgramVars() - can't find \"") + kTableName + "\". Was the program compiled with _MS_MATERIAL_TABLE?");
+                return false;
+            }
+            if (pBufDesc->getRequiredSize() != sizeof(Entry))
+            {
+                logError("MaterialTable::setIntoProgramVars() - the shader material struct size doesn't match the table entry size");
+                return false;
+            }
+            mpBuffer = StructuredBuffer::create(pBufDesc, std::max<size_t>(mEntries.size(), 1), Resource::BindFlags::ShaderResource);
+            mDirtyBegin = 0;
+            mDirtyEnd = mEntries.size();
+        }
+
+        // ProgramVars uploads the buffer when it's applied
+        if (mDirtyEnd > mDirtyBegin)
+        {
+            mpBuffer->setBlob(mEntries.data() + mDirtyBegin, mDirtyBegin * sizeof(Entry), (mDirtyEnd - mDirtyBegin) * sizeof(Entry));
+            mDirtyBegin = mDirtyEnd = 0;
+        }
+        pVars->setStructuredBuffer(kTableName, mpBuffer);
+
+        // Setting an unchanged view or sampler is a no-op, so rebinding every frame doesn't invalidate the descriptor sets
+        const ProgramReflection::Resource* pTexDesc = pReflector->getResourceDesc(kTexturesName);
+        if (pTexDesc)
+        {
+            for (uint32_t i = 0; i < (uint32_t)mTextures.size(); i++)
+            {
+                // Released slots are not referenced by any entry
+                if (mTextureRefCount[i] == 0) continue;
+                pVars->setSrv(pTexDesc->regSpace, pTexDesc->regIndex, pTexDesc->descOffset + i, mTextures[i]->getSRV());
+            }
+        }
+
+        const ProgramReflection::Resource* pSamplerDesc = pReflector->getResourceDesc(kSamplersName);
+        if (pSamplerDesc)
+        {
+            for (uint32_t i = 0; i < (uint32_t)mSamplers.size(); i++)
+            {
+                // A null sampler is a valid slot, ProgramVars binds the default sampler for it
+                if (mSamplerRefCount[i] == 0) continue;
+                pVars->setSampler(pSamplerDesc->regSpace, pSamplerDesc->regIndex, pSamplerDesc->descOffset + i, mSamplers[i]);
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Material/Material.h"
+#include "API/StructuredBuffer.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    class Scene;
+    class ProgramVars;
+
+    /** Scene-wide material table.
+        Packs every material used by a scene into a single structured buffer, and deduplicates the material textures and samplers into descriptor arrays.
+        Shaders compiled with _MS_MATERIAL_TABLE fetch the material from the table using a per-draw index, so changing materials between draws only requires setting a single constant.
+        Materials are only re-packed when their version changes, and only the changed entries are re-uploaded.
+        Textures and samplers which don't fit into the descriptor arrays get MatTableInvalidIndex. The shaders then use the material's constant values instead.
+    */
+    class MaterialTable
+    {
+    public:
+        using SharedPtr = std::shared_ptr<MaterialTable>;
+        using SharedConstPtr = std::shared_ptr<const MaterialTable>;
+
+        static const uint32_t kInvalidIndex = MatTableInvalidIndex;
+        static const char* kTableName;
+        static const char* kTexturesName;
+        static const char* kSamplersName;
+
+        /** Create a new material table
+        */
+        static SharedPtr create();
+
+        /** Collect the materials used by the scene and pack them into the table. Only materials that changed since the last call are re-packed.
+            \param[in] pScene The scene to collect the materials from
+            \return true if the table content changed, otherwise false
+        */
+        bool update(const Scene* pScene);
+
+        /** Get the index of a material in the table
+            \return The material index, or kInvalidIndex if the material was not part of the scene when update() was called
+        */
+        uint32_t getMaterialIndex(const Material* pMaterial) const;
+
+        /** Bind the table, textures and samplers into a program vars object. The program must be compiled with _MS_MATERIAL_TABLE.
+            \return false if the program doesn't declare the material table, otherwise true
+        */
+        bool setIntoProgramVars(ProgramVars* pVars);
+
+        uint32_t getMaterialCount() const { return (uint32_t)mEntries.size(); }
+        uint32_t getTextureCount() const { return (uint32_t)mTextures.size(); }
+        uint32_t getSamplerCount() const { return (uint32_t)mSamplers.size(); }
+
+    private:
+        MaterialTable() = default;
+
+        static const uint32_t kTexCount = MatMaxLayers + 4;
+
+        // Matches the shader-side MaterialData when compiled with _MS_MATERIAL_TABLE
+        struct Entry
+        {
+            MaterialDesc desc;
+            MaterialValues values;
+            uint32_t textures[kTexCount];
+            uint32_t samplerIndex;
+        };
+
+        void packEntry(const Material* pMaterial, Entry& entry);
+        void releaseEntry(const Entry& entry);
+        uint32_t getTextureIndex(const Texture::SharedPtr& pTexture);
+        uint32_t getSamplerIndex(const Sampler::SharedPtr& pSampler);
+        void markDirty(size_t index);
+
+        std::vector<Entry> mEntries;
+        std::vector<const Material*> mMaterials;
+        std::vector<uint32_t> mVersions;                        ///< The material version each entry was packed from
+        std::unordered_map<const Material*, uint32_t> mMaterialIndices;
+
+        // Texture and sampler slots are reference counted by the entries using them. Released slots are reused before the arrays grow
+        std::vector<Texture::SharedPtr> mTextures;
+        std::vector<uint32_t> mTextureRefCount;
+        std::vector<uint32_t> mFreeTextureSlots;
+        std::unordered_map<const Texture*, uint32_t> mTextureIndices;
+        std::vector<Sampler::SharedPtr> mSamplers;
+        std::vector<uint32_t> mSamplerRefCount;
+        std::vector<uint32_t> mFreeSamplerSlots;
+        std::unordered_map<const Sampler*, uint32_t> mSamplerIndices;
+
+        StructuredBuffer::SharedPtr mpBuffer;
+        size_t mDirtyBegin = 0;
+        size_t mDirtyEnd = 0;
+        bool mOverflowReported = false;
+    };
+}
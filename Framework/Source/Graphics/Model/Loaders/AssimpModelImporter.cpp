@@ -296,7 +296,15 @@ namespace Falcor
                 {
                     // create a new texture
                     std::string fullpath = folder + '\\' + s;
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    if (is_set(mFlags, Model::LoadFlags::CompressTextures))
+                    {
+                        const bool isNormalMap = (getFalcorTexTypeFromAi(aiType, isObjFile) == BasicMaterial::MapType::NormalMap);
+                        pTex = createCompressedTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb), isNormalMap);
+                    }
+                    else
+                    {
+                        pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    }
                     if (pTex)
                     {
                         mTextureCache[s] = pTex;
@@ -708,6 +716,38 @@ namespace Falcor
         return Animation::create(std::string(pAiAnim->mName.C_Str()), animationSets, duration, ticksPerSecond);
     }
 
+    Mesh::CpuGeometry createCpuGeometry(const aiMesh* pAiMesh)
+    {
+        Mesh::CpuGeometry geometry;
+        const uint32_t vertexCount = pAiMesh->mNumVertices;
+        geometry.positions.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            geometry.positions[i] = glm::vec3(pAiMesh->mVertices[i].x, pAiMesh->mVertices[i].y, pAiMesh->mVertices[i].z);
+        }
+
+        if (pAiMesh->HasNormals())
+        {
+            geometry.normals.resize(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                geometry.normals[i] = glm::vec3(pAiMesh->mNormals[i].x, pAiMesh->mNormals[i].y, pAiMesh->mNormals[i].z);
+            }
+        }
+
+        if (pAiMesh->HasTextureCoords(0))
+        {
+            geometry.texCrd.resize(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                geometry.texCrd[i] = glm::vec2(pAiMesh->mTextureCoords[0][i].x, pAiMesh->mTextureCoords[0][i].y);
+            }
+        }
+
+        geometry.indices = createIndexBufferData(pAiMesh);
+        return geometry;
+    }
+
     BoundingBox createMeshBbox(const aiMesh* pAiMesh)
     {
         glm::vec3 boxMin, boxMax;
@@ -779,6 +819,11 @@ namespace Falcor
 
         Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
 
+        if (is_set(mFlags, Model::LoadFlags::KeepCpuGeometry) && (topology == Vao::Topology::TriangleList))
+        {
+            pMesh->setCpuGeometry(createCpuGeometry(pAiMesh));
+        }
+
         if (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false)
         {
             aiMesh* pM = const_cast<aiMesh*>(pAiMesh);
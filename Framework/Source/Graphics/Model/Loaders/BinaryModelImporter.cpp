@@ -934,6 +934,28 @@ namespace Falcor
                 // create the mesh
                 auto pMesh = Mesh::create(pVBs, numVertices, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
 
+                if(is_set(flags, Model::LoadFlags::KeepCpuGeometry))
+                {
+                    // Each attribute lives in its own buffer, so the stride is the element size
+                    auto readAttrib = [&](uint32_t bufferIndex, auto& dst)
+                    {
+                        using T = typename std::remove_reference<decltype(dst)>::type::value_type;
+                        uint32_t stride = pLayout->getBufferLayout(bufferIndex)->getStride();
+                        dst.resize(numVertices);
+                        for(int32_t v = 0; v < numVertices; v++)
+                        {
+                            memcpy(&dst[v], buffers[bufferIndex].vec.data() + stride * v, std::min<size_t>(stride, sizeof(T)));
+                        }
+                    };
+
+                    Mesh::CpuGeometry geometry;
+                    readAttrib(positionBufferIndex, geometry.positions);
+                    if(normalBufferIndex != kInvalidBufferIndex) readAttrib(normalBufferIndex, geometry.normals);
+                    if(texCoordBufferIndex != kInvalidBufferIndex) readAttrib(texCoordBufferIndex, geometry.texCrd);
+                    geometry.indices = indices;
+                    pMesh->setCpuGeometry(std::move(geometry));
+                }
+
                 if (version >= 6)
                 {
                     falcorMeshCache.push_back(pMesh);
@@ -36,12 +36,112 @@
 #include "API/VertexLayout.h"
 #include "Graphics/Camera/Camera.h"
 #include "Data/VertexAttrib.h"
+#include "API/Device.h"
+#include <unordered_map>
 
 namespace Falcor
 { 
     uint32_t Mesh::sMeshCounter = 0;
     Mesh::~Mesh() = default;
 
+    std::vector<std::vector<glm::vec3>> Mesh::readTriangles(const std::vector<const Mesh*>& meshes, const std::string& warningPrefix)
+    {
+        auto warn = [&warningPrefix](const std::string& msg)
+        {
+            if (warningPrefix.size()) logWarning(warningPrefix + " - " + msg + ". Skipping mesh");
+        };
+
+        // Record all the reads first, so that we only wait for the GPU once. The device is only accessed if a mesh doesn't have CPU geometry
+        RenderContext* pContext = nullptr;
+        std::unordered_map<const Buffer*, ReadbackRequest::SharedPtr> reads;
+        for (const Mesh* pMesh : meshes)
+        {
+            if (pMesh->getCpuGeometry()) continue;
+            const Vao* pVao = pMesh->getVao().get();
+            Vao::ElementDesc element = pVao->getElementIndexByLocation(VERTEX_POSITION_LOC);
+            if (element.vbIndex == Vao::ElementDesc::kInvalidIndex) continue;
+            if (pContext == nullptr) pContext = gpDevice->getRenderContext().get();
+            const Buffer* pVB = pVao->getVertexBuffer(element.vbIndex).get();
+            const Buffer* pIB = pVao->getIndexBuffer().get();
+            if (reads.find(pVB) == reads.end()) reads[pVB] = pContext->asyncReadBuffer(pVB);
+            if (pIB && reads.find(pIB) == reads.end()) reads[pIB] = pContext->asyncReadBuffer(pIB);
+        }
+
+        std::vector<std::vector<glm::vec3>> triangles(meshes.size());
+        for (size_t meshIndex = 0; meshIndex < meshes.size(); meshIndex++)
+        {
+            const Mesh* pMesh = meshes[meshIndex];
+            std::vector<glm::vec3>& vertices = triangles[meshIndex];
+            const CpuGeometry* pGeometry = pMesh->getCpuGeometry().get();
+            if (pGeometry)
+            {
+                if (pGeometry->positions.empty()) continue;
+                const size_t indexCount = pGeometry->indices.size() - pGeometry->indices.size() % 3;
+                vertices.reserve(indexCount);
+                for (size_t i = 0; i < indexCount; i++)
+                {
+                    vertices.push_back(pGeometry->positions[std::min<size_t>(pGeometry->indices[i], pGeometry->positions.size() - 1)]);
+                }
+                continue;
+            }
+
+            const Vao* pVao = pMesh->getVao().get();
+            Vao::ElementDesc element = pVao->getElementIndexByLocation(VERTEX_POSITION_LOC);
+            if (pVao->getPrimitiveTopology() != Vao::Topology::TriangleList || element.vbIndex == Vao::ElementDesc::kInvalidIndex)
+            {
+                warn("the mesh must be a triangle list with positions");
+                continue;
+            }
+
+            const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(element.vbIndex).get();
+            const ResourceFormat format = pLayout->getElementFormat(element.elementIndex);
+            if (format != ResourceFormat::RGB32Float && format != ResourceFormat::RGBA32Float)
+            {
+                warn("unsupported position format " + to_string(format));
+                continue;
+            }
+
+            const std::vector<uint8>& vbData = reads[pVao->getVertexBuffer(element.vbIndex).get()]->getData();
+            const uint32_t offset = pLayout->getElementOffset(element.elementIndex);
+            const uint32_t stride = pLayout->getStride();
+            const uint32_t vertexCount = pMesh->getVertexCount();
+            if (vertexCount == 0 || offset + (size_t)stride * (vertexCount - 1) + sizeof(glm::vec3) > vbData.size())
+            {
+                warn("the vertex buffer is smaller than the mesh");
+                continue;
+            }
+
+            auto getVertex = [&](uint32_t index)
+            {
+                glm::vec3 v;
+                memcpy(&v, vbData.data() + offset + (size_t)index * stride, sizeof(v));
+                return v;
+            };
+
+            const Buffer* pIB = pVao->getIndexBuffer().get();
+            if (pIB)
+            {
+                const std::vector<uint8>& ibData = reads[pIB]->getData();
+                const bool is16Bit = (pVao->getIndexBufferFormat() == ResourceFormat::R16Uint);
+                const uint32_t indexCount = std::min(pMesh->getIndexCount(), (uint32_t)(ibData.size() / (is16Bit ? sizeof(uint16_t) : sizeof(uint32_t))));
+                vertices.reserve(indexCount - indexCount % 3);
+                for (uint32_t i = 0; i < indexCount - indexCount % 3; i++)
+                {
+                    uint32_t index = is16Bit ? ((const uint16_t*)ibData.data())[i] : ((const uint32_t*)ibData.data())[i];
+                    vertices.push_back(getVertex(std::min(index, vertexCount - 1)));
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < vertexCount - vertexCount % 3; i++)
+                {
+                    vertices.push_back(getVertex(i));
+                }
+            }
+        }
+        return triangles;
+    }
+
     Mesh::SharedPtr Mesh::create(const Vao::BufferVec& vertexBuffers,
         uint32_t vertexCount,
         const Buffer::SharedPtr& pIndexBuffer,
@@ -56,6 +56,16 @@ namespace Falcor
         using SharedPtr = std::shared_ptr<Mesh>;
         using SharedConstPtr = std::shared_ptr<const Mesh>;
 
+        /** Object-space geometry kept in system memory, for code which needs the mesh on the CPU without reading back the vertex buffers. See Model::LoadFlags::KeepCpuGeometry
+        */
+        struct CpuGeometry
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> normals;     ///< Empty if the mesh doesn't have normals
+            std::vector<glm::vec2> texCrd;      ///< Empty if the mesh doesn't have texture coordinates
+            std::vector<uint32_t> indices;
+        };
+
         /** create a new mesh
             \param[in] VertexBuffers Vector of vertex buffer descriptors
             \param[in] VertexCount Number of vertices in the vertex buffer
@@ -116,6 +126,23 @@ namespace Falcor
         */
         const uint32_t getId() const { return mId; }
 
+        /** Attach a system-memory copy of the geometry
+        */
+        void setCpuGeometry(CpuGeometry&& geometry) { mpCpuGeometry = std::make_shared<const CpuGeometry>(std::move(geometry)); }
+
+        /** Get the system-memory copy of the geometry
+            \return The geometry, or nullptr if the mesh was loaded without Model::LoadFlags::KeepCpuGeometry
+        */
+        const std::shared_ptr<const CpuGeometry>& getCpuGeometry() const { return mpCpuGeometry; }
+
+        /** Get the object-space triangles of meshes, 3 vertices per triangle.
+            Meshes loaded with Model::LoadFlags::KeepCpuGeometry are read from their CPU geometry. The others are read back from the GPU, waiting for it only once for all of them
+            \param[in] meshes The meshes to read
+            \param[in] warningPrefix If not empty, a warning starting with it is logged for every mesh which isn't a triangle list with float positions
+            \return One triangle list per mesh. The list of an unsupported mesh is empty
+        */
+        static std::vector<std::vector<glm::vec3>> readTriangles(const std::vector<const Mesh*>& meshes, const std::string& warningPrefix = "");
+
         /** Reset all global id counter of model, mesh and material
         */
         static void resetGlobalIdCounter();
@@ -148,5 +175,6 @@ namespace Falcor
         Material::SharedPtr mpMaterial;
         BoundingBox mBoundingBox;
         Vao::SharedPtr mpVao;
+        std::shared_ptr<const CpuGeometry> mpCpuGeometry;
     };
 }
\ No newline at end of file
@@ -65,6 +65,8 @@ namespace Falcor
             AssumeLinearSpaceTextures   = 0x4,    ///< By default, textures representing colors (diffuse/specular) are interpreted as sRGB data. Use this flag to force linear space for color textures.
             DontMergeMeshes             = 0x8,    ///< Preserve the original list of meshes in the scene, don't merge meshes with the same material
             BuffersAsShaderResource     = 0x10,   ///< Generate the VBs and IB with the shader-resource-view bind flag
+            CompressTextures            = 0x20,   ///< Block-compress textures loaded from uncompressed image files on the CPU. Normal maps use BC5, HDR images BC6H. See createCompressedTextureFromFile()
+            KeepCpuGeometry             = 0x40,   ///< Keep a system-memory copy of the triangle geometry in each mesh (see Mesh::getCpuGeometry()). Used by CPU-side consumers such as CpuPathTracer, so they don't read the vertex buffers back from the GPU
         };
 
         /** create a new model from file
@@ -231,6 +233,7 @@ namespace Falcor
 
     protected:
         friend class SimpleModelImporter;
+        friend class SceneSnapshot;
 
         Model();
         Model(const Model& other);
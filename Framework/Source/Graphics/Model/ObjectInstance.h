@@ -125,6 +125,7 @@ namespace Falcor
 
             mBase.translation = translation;
             mBase.matrixDirty = true;
+            mTransformVersion++;
         };
 
         /** Gets the position/translation of the instance
@@ -135,7 +136,7 @@ namespace Falcor
         /** Sets scale of the instance
             \param[in] scaling Instance scale
         */
-        void setScaling(const glm::vec3& scaling) { mBase.scale = scaling; mBase.matrixDirty = true; }
+        void setScaling(const glm::vec3& scaling) { mBase.scale = scaling; mBase.matrixDirty = true; mTransformVersion++; }
 
         /** Gets scale of the instance
             \return Scale of the instance
@@ -155,6 +156,7 @@ namespace Falcor
             mBase.target = mBase.translation + rotMtx[2]; // position + forward
 
             mBase.matrixDirty = true;
+            mTransformVersion++;
         }
 
         /** Gets rotation for the instance
@@ -171,9 +173,9 @@ namespace Falcor
         }
 
 // #toodo comments
-        void setUpVector(const glm::vec3& up) { mBase.up = glm::normalize(up); mBase.matrixDirty = true; }
+        void setUpVector(const glm::vec3& up) { mBase.up = glm::normalize(up); mBase.matrixDirty = true; mTransformVersion++; }
 
-        void setTarget(const glm::vec3& target) { mBase.target = target; mBase.matrixDirty = true; }
+        void setTarget(const glm::vec3& target) { mBase.target = target; mBase.matrixDirty = true; mTransformVersion++; }
 
         /** Gets the up vector of the instance
             \return Up vector
@@ -194,6 +196,10 @@ namespace Falcor
             return mFinalTransformMatrix;
         }
 
+        /** Gets a counter which is incremented every time the instance transform changes. Used to detect moved instances without recomputing their transform
+        */
+        uint32_t getTransformVersion() const { return mTransformVersion; }
+
         /** Gets the bounding box
             \return Bounding box
         */
@@ -212,6 +218,7 @@ namespace Falcor
             mMovable.up = up;
             mMovable.scale = glm::vec3(1.0f);
             mMovable.matrixDirty = true;
+            mTransformVersion++;
         }
 
         SharedPtr shared_from_this()
@@ -317,5 +324,6 @@ namespace Falcor
 
         mutable glm::mat4 mFinalTransformMatrix;
         mutable BoundingBox mBoundingBox;
+        uint32_t mTransformVersion = 0;
     };
 }
@@ -311,7 +311,8 @@ namespace Falcor
         spSetCodeGenTarget(slangRequest, SLANG_SPIRV);
         spAddPreprocessorDefine(slangRequest, "FALCOR_GLSL", "1");
         SlangSourceLanguage sourceLanguage = SLANG_SOURCE_LANGUAGE_GLSL;
-#elif defined FALCOR_D3D
+#elif defined FALCOR_D3D || defined FALCOR_NULL
+        // The null backend never runs the generated code, but it needs real reflection data, so it uses the HLSL path
         // Note: we could compile Slang directly to DXBC (by having Slang invoke the MS compiler for us,
         // but that path seems to have more issues at present, so let's just go to HLSL instead...)
         spSetCodeGenTarget(slangRequest, SLANG_HLSL);
@@ -260,6 +260,7 @@ namespace Falcor
         if (pGui->addFloat3Var("Translation", t, -FLT_MAX, FLT_MAX))
         {
             pInstance->setTranslation(t, true);
+            mpScene->markInstanceMoved(pInstance.get());
             mSceneDirty = true;
         }
     }
@@ -283,6 +284,7 @@ namespace Falcor
         if (pGui->addFloat3Var("Scaling", s, 0, FLT_MAX))
         {
             pInstance->setScaling(s);
+            mpScene->markInstanceMoved(pInstance.get());
             mSceneDirty = true;
         }
     }
@@ -615,7 +617,9 @@ namespace Falcor
     void SceneEditor::setActiveInstanceRotationAngles(const glm::vec3& rotation)
     {
         mInstanceRotationAngles[mSelectedModel][mSelectedModelInstance] = rotation;
-        mpScene->getModelInstance(mSelectedModel, mSelectedModelInstance)->setRotation(rotation);
+        const auto& pInstance = mpScene->getModelInstance(mSelectedModel, mSelectedModelInstance);
+        pInstance->setRotation(rotation);
+        mpScene->markInstanceMoved(pInstance.get());
         mSceneDirty = true;
     }
 
@@ -773,6 +777,7 @@ namespace Falcor
         {
             auto& pInstance = mpScene->getModelInstance(mSelectedModel, mSelectedModelInstance);
             activeGizmo->applyDelta(pInstance);
+            mpScene->markInstanceMoved(pInstance.get());
 
             if (mActiveGizmoType == Gizmo::Type::Rotate)
             {
@@ -83,8 +83,9 @@ namespace Falcor
         if (currentData.pCamera)
         {
             // Set camera for regular shader
-            ConstantBuffer* pCB = mpProgramVars->getConstantBuffer(kPerFrameCbName).get();
-            currentData.pCamera->setIntoConstantBuffer(pCB, sCameraDataOffset);
+            const ProgramBindings& bindings = getProgramBindings(mpProgramVars.get());
+            ConstantBuffer* pCB = mpProgramVars->getConstantBuffer(bindings.perFrameCb).get();
+            currentData.pCamera->setIntoConstantBuffer(pCB, bindings.cameraDataOffset);
         }
     }
 
@@ -0,0 +1,487 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "EmissiveTriangleTable.h"
+#include "Graphics/Scene/Scene.h"
+#include "API/ProgramVars.h"
+#include "API/Device.h"
+#include "glm/gtc/packing.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace Falcor
+{
+    const char* EmissiveTriangleTable::kTrianglesName = "gEmissiveTriangles";
+    const char* EmissiveTriangleTable::kAliasTableName = "gEmissiveAliasTable";
+
+    // Transforming fewer triangles than this is faster than spawning threads
+    static const uint32_t kParallelTriangleThreshold = 4096;
+    // Relative flux change below which the alias table is kept. Rigid transforms change the area by rounding only
+    static const float kFluxTolerance = 1e-4f;
+
+    EmissiveTriangleTable::SharedPtr EmissiveTriangleTable::create()
+    {
+        return SharedPtr(new EmissiveTriangleTable());
+    }
+
+    /** Average the texels of the coarsest mip level. Returns false for formats which can't be decoded on the CPU
+    */
+    static bool computeTextureAverage(const Texture* pTexture, glm::vec3& average)
+    {
+        const ResourceFormat format = pTexture->getFormat();
+        switch (format)
+        {
+        case ResourceFormat::R8Unorm:
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGBA32Float:
+            break;
+        default:
+            return false;
+        }
+
+        // With a full mip chain this reads a single texel
+        const uint32_t mip = pTexture->getMipCount() - 1;
+        const std::vector<uint8> data = gpDevice->getRenderContext()->readTextureSubresource(pTexture, pTexture->getSubresourceIndex(0, mip));
+        const uint32_t bytesPerTexel = getFormatBytesPerBlock(format);
+        const size_t texelCount = (size_t)pTexture->getWidth(mip) * pTexture->getHeight(mip);
+        if (texelCount == 0 || data.size() < texelCount * bytesPerTexel) return false;
+
+        glm::dvec3 sum(0);
+        for (size_t i = 0; i < texelCount; i++)
+        {
+            const uint8* pTexel = data.data() + i * bytesPerTexel;
+            glm::vec3 c;
+            switch (format)
+            {
+            case ResourceFormat::R8Unorm:
+                c = glm::vec3(pTexel[0] / 255.0f, 0, 0);
+                break;
+            case ResourceFormat::RGBA8Unorm:
+            case ResourceFormat::RGBA8UnormSrgb:
+                c = glm::vec3(pTexel[0], pTexel[1], pTexel[2]) / 255.0f;
+                break;
+            case ResourceFormat::RGBA16Float:
+            {
+                uint64_t packed;
+                memcpy(&packed, pTexel, sizeof(packed));
+                c = glm::vec3(glm::unpackHalf4x16(packed));
+            }
+            break;
+            case ResourceFormat::RGBA32Float:
+                memcpy(&c, pTexel, sizeof(c));
+                break;
+            default:
+                // BGRA/BGRX
+                c = glm::vec3(pTexel[2], pTexel[1], pTexel[0]) / 255.0f;
+                break;
+            }
+            sum += glm::dvec3(isSrgbFormat(format) ? SRGBToLinear(c) : c);
+        }
+        average = glm::vec3(sum / (double)texelCount);
+        return true;
+    }
+
+    const EmissiveTriangleTable::TextureAverage& EmissiveTriangleTable::getTextureAverage(const Texture::SharedPtr& pTexture)
+    {
+        auto it = mTextureAverages.find(pTexture.get());
+        if (it != mTextureAverages.end() && it->second.pTexture.lock() == pTexture)
+        {
+            return it->second;
+        }
+
+        TextureAverage& average = mTextureAverages[pTexture.get()];
+        average.pTexture = pTexture;
+        average.valid = computeTextureAverage(pTexture.get(), average.value);
+        if (average.valid == false)
+        {
+            logWarning("EmissiveTriangleTable - can't average emissive texture '" + pTexture->getSourceFilename() + "' with format " + to_string(pTexture->getFormat()) + ". Using the layer color instead");
+        }
+        return average;
+    }
+
+    glm::vec3 EmissiveTriangleTable::getEmittedRadiance(const Material* pMaterial)
+    {
+        glm::vec3 radiance(0);
+        if (pMaterial == nullptr) return radiance;
+
+        for (uint32_t i = 0; i < pMaterial->getNumLayers(); i++)
+        {
+            const Material::Layer layer = pMaterial->getLayer(i);
+            if (layer.type == Material::Layer::Type::Emissive)
+            {
+                // A texture replaces the layer color when shading, so its average is what the triangles emit
+                const TextureAverage* pAverage = layer.pTexture ? &getTextureAverage(layer.pTexture) : nullptr;
+                radiance += (pAverage && pAverage->valid) ? pAverage->value : glm::vec3(layer.albedo);
+            }
+        }
+        return radiance;
+    }
+
+    void EmissiveTriangleTable::markTrianglesDirty(uint32_t first, uint32_t count)
+    {
+        if (count == 0) return;
+        mDirtyBegin = (mDirtyBegin < mDirtyEnd) ? std::min(mDirtyBegin, first) : first;
+        mDirtyEnd = std::max(mDirtyEnd, first + count);
+    }
+
+    void EmissiveTriangleTable::readMeshTriangles(const std::vector<Mesh::SharedConstPtr>& meshes)
+    {
+        std::vector<const Mesh*> rawMeshes;
+        for (const auto& pMesh : meshes) rawMeshes.push_back(pMesh.get());
+        std::vector<std::vector<glm::vec3>> triangles = Mesh::readTriangles(rawMeshes, "EmissiveTriangleTable");
+
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            MeshTriangles& entry = mMeshTriangles[meshes[i].get()];
+            entry.pMesh = meshes[i];
+            entry.vertices = std::move(triangles[i]);
+        }
+    }
+
+    void EmissiveTriangleTable::transformInstances(const std::vector<uint32_t>& instances)
+    {
+        auto transform = [this, &instances](uint32_t i)
+        {
+            const Instance& instance = mInstances[instances[i]];
+            const std::vector<glm::vec3>& vertices = mMeshTriangles.at(instance.pMesh).vertices;
+            const float radianceLuminance = luminance(instance.radiance);
+            for (uint32_t t = 0; t < instance.triangleCount; t++)
+            {
+                EmissiveTriangle& tri = mTriangles[instance.firstTriangle + t];
+                tri.p0 = glm::vec3(instance.world * glm::vec4(vertices[t * 3 + 0], 1));
+                tri.p1 = glm::vec3(instance.world * glm::vec4(vertices[t * 3 + 1], 1));
+                tri.p2 = glm::vec3(instance.world * glm::vec4(vertices[t * 3 + 2], 1));
+                const glm::vec3 cross = glm::cross(tri.p1 - tri.p0, tri.p2 - tri.p0);
+                const float length = glm::length(cross);
+                tri.area = 0.5f * length;
+                tri.normal = (length > 0) ? cross / length : glm::vec3(0, 1, 0);
+                tri.radiance = instance.radiance;
+                tri.flux = radianceLuminance * tri.area;
+                tri.instanceIndex = instances[i];
+            }
+        };
+
+        uint32_t triangleCount = 0;
+        for (uint32_t i : instances) triangleCount += mInstances[i].triangleCount;
+
+        const uint32_t instanceCount = (uint32_t)instances.size();
+        const uint32_t threadCount = std::min(std::thread::hardware_concurrency(), instanceCount);
+        if (triangleCount < kParallelTriangleThreshold || threadCount <= 1)
+        {
+            for (uint32_t i = 0; i < instanceCount; i++) transform(i);
+            return;
+        }
+
+        // Instances can have very different triangle counts, so threads grab them one at a time
+        std::atomic<uint32_t> next(0);
+        auto worker = [&]()
+        {
+            for (uint32_t i = next++; i < instanceCount; i = next++) transform(i);
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& t : threads) t.join();
+    }
+
+    void EmissiveTriangleTable::buildAliasTable()
+    {
+        // Vose's alias method
+        const uint32_t count = (uint32_t)mTriangles.size();
+        mAliasTable.resize(count);
+        mTotalFlux = 0;
+        for (const auto& tri : mTriangles) mTotalFlux += tri.flux;
+
+        if (mTotalFlux <= 0)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                mAliasTable[i] = { 1.0f, i, 0.0f, 0.0f };
+            }
+            return;
+        }
+
+        std::vector<float> scaled(count);
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            mAliasTable[i].pdf = mTriangles[i].flux / mTotalFlux;
+            scaled[i] = mAliasTable[i].pdf * count;
+            (scaled[i] < 1.0f ? small : large).push_back(i);
+        }
+
+        while (small.size() && large.size())
+        {
+            uint32_t s = small.back();
+            uint32_t l = large.back();
+            small.pop_back();
+            mAliasTable[s].threshold = scaled[s];
+            mAliasTable[s].alias = l;
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0f;
+            if (scaled[l] < 1.0f)
+            {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+
+        // Whatever is left is 1 up to rounding errors
+        for (uint32_t i : large) { mAliasTable[i].threshold = 1.0f; mAliasTable[i].alias = i; }
+        for (uint32_t i : small) { mAliasTable[i].threshold = 1.0f; mAliasTable[i].alias = i; }
+    }
+
+    bool EmissiveTriangleTable::update(const Scene* pScene)
+    {
+        // Collect the emissive mesh instances
+        std::vector<Instance> instances;
+        std::vector<Mesh::SharedConstPtr> newMeshes;
+        std::unordered_map<const Mesh*, bool> usedMeshes;
+        for (uint32_t modelId = 0; modelId < pScene->getModelCount(); modelId++)
+        {
+            const Model* pModel = pScene->getModel(modelId).get();
+            for (uint32_t meshId = 0; meshId < pModel->getMeshCount(); meshId++)
+            {
+                const Mesh::SharedPtr& pSharedMesh = pModel->getMesh(meshId);
+                const Mesh* pMesh = pSharedMesh.get();
+                const glm::vec3 radiance = getEmittedRadiance(pMesh->getMaterial().get());
+                if (radiance == glm::vec3(0)) continue;
+
+                if (usedMeshes.emplace(pMesh, true).second)
+                {
+                    auto cached = mMeshTriangles.find(pMesh);
+                    if (cached == mMeshTriangles.end() || cached->second.pMesh.lock() != pSharedMesh)
+                    {
+                        newMeshes.push_back(pSharedMesh);
+                    }
+                }
+
+                for (uint32_t modelInstanceId = 0; modelInstanceId < pScene->getModelInstanceCount(modelId); modelInstanceId++)
+                {
+                    const auto& pModelInstance = pScene->getModelInstance(modelId, modelInstanceId);
+                    for (uint32_t meshInstanceId = 0; meshInstanceId < pModel->getMeshInstanceCount(meshId); meshInstanceId++)
+                    {
+                        const auto& pMeshInstance = pModel->getMeshInstance(meshId, meshInstanceId);
+                        Instance instance;
+                        instance.pMesh = pMesh;
+                        instance.pModelInstance = pModelInstance.get();
+                        instance.pMeshInstance = pMeshInstance.get();
+                        instance.world = pModelInstance->getTransformMatrix() * pMeshInstance->getTransformMatrix();
+                        instance.radiance = radiance;
+                        instances.push_back(instance);
+                    }
+                }
+            }
+        }
+
+        // Drop the meshes which left the scene, so that the cache doesn't grow and stale pointers can't match new meshes
+        for (auto it = mMeshTriangles.begin(); it != mMeshTriangles.end();)
+        {
+            it = (usedMeshes.find(it->first) == usedMeshes.end()) ? mMeshTriangles.erase(it) : std::next(it);
+        }
+        for (auto it = mTextureAverages.begin(); it != mTextureAverages.end();)
+        {
+            it = it->second.pTexture.expired() ? mTextureAverages.erase(it) : std::next(it);
+        }
+
+        bool sameMeshes = true;
+        if (newMeshes.size())
+        {
+            readMeshTriangles(newMeshes);
+            sameMeshes = false;
+        }
+
+        // Check if the set of instances is the same as in the previous update
+        bool sameInstances = sameMeshes && (instances.size() == mInstances.size());
+        for (size_t i = 0; sameInstances && i < instances.size(); i++)
+        {
+            sameInstances = (instances[i].pMesh == mInstances[i].pMesh) && (instances[i].pModelInstance == mInstances[i].pModelInstance) && (instances[i].pMeshInstance == mInstances[i].pMeshInstance);
+        }
+
+        if (sameInstances == false)
+        {
+            uint32_t triangleCount = 0;
+            std::vector<uint32_t> all(instances.size());
+            for (uint32_t i = 0; i < (uint32_t)instances.size(); i++)
+            {
+                instances[i].firstTriangle = triangleCount;
+                instances[i].triangleCount = (uint32_t)mMeshTriangles[instances[i].pMesh].vertices.size() / 3;
+                triangleCount += instances[i].triangleCount;
+                all[i] = i;
+            }
+
+            mInstances.swap(instances);
+            mTriangles.resize(triangleCount);
+            transformInstances(all);
+            buildAliasTable();
+            // Also covers the placeholder entry of an empty table
+            mDirtyBegin = 0;
+            mDirtyEnd = std::max(triangleCount, 1u);
+            mAliasDirty = true;
+            return true;
+        }
+
+        // Same instances. Only re-transform the ones that moved or whose material changed
+        std::vector<uint32_t> changed;
+        for (uint32_t i = 0; i < (uint32_t)instances.size(); i++)
+        {
+            Instance& instance = mInstances[i];
+            if (instance.world != instances[i].world || instance.radiance != instances[i].radiance)
+            {
+                instance.world = instances[i].world;
+                instance.radiance = instances[i].radiance;
+                changed.push_back(i);
+            }
+        }
+
+        if (changed.empty()) return false;
+
+        std::vector<float> prevFlux;
+        for (uint32_t i : changed)
+        {
+            for (uint32_t t = 0; t < mInstances[i].triangleCount; t++) prevFlux.push_back(mTriangles[mInstances[i].firstTriangle + t].flux);
+        }
+
+        transformInstances(changed);
+
+        bool fluxChanged = false;
+        size_t f = 0;
+        for (uint32_t i : changed)
+        {
+            for (uint32_t t = 0; t < mInstances[i].triangleCount; t++, f++)
+            {
+                const float flux = mTriangles[mInstances[i].firstTriangle + t].flux;
+                fluxChanged = fluxChanged || (fabsf(flux - prevFlux[f]) > kFluxTolerance * glm::max(flux, prevFlux[f]));
+            }
+        }
+
+        if (fluxChanged)
+        {
+            buildAliasTable();
+            mAliasDirty = true;
+        }
+
+        for (uint32_t i : changed)
+        {
+            markTrianglesDirty(mInstances[i].firstTriangle, mInstances[i].triangleCount);
+        }
+        return true;
+    }
+
+    uint32_t EmissiveTriangleTable::sampleTriangle(float u, float& pdf) const
+    {
+        assert(mAliasTable.size());
+        const uint32_t count = (uint32_t)mAliasTable.size();
+        const float scaled = u * count;
+        uint32_t index = std::min((uint32_t)scaled, count - 1);
+        if (scaled - index >= mAliasTable[index].threshold)
+        {
+            index = mAliasTable[index].alias;
+        }
+        pdf = mAliasTable[index].pdf;
+        return index;
+    }
+
+    glm::vec3 EmissiveTriangleTable::sampleTrianglePoint(const EmissiveTriangle& tri, const glm::vec2& u)
+    {
+        const float su = sqrt(u.x);
+        const float b0 = 1 - su;
+        const float b1 = u.y * su;
+        return tri.p0 * b0 + tri.p1 * b1 + tri.p2 * (1 - b0 - b1);
+    }
+
+    bool EmissiveTriangleTable::setIntoProgramVars(ProgramVars* pVars)
+    {
+        const ProgramReflection* pReflector = pVars->getReflection().get();
+        const uint32_t elementCount = std::max(getTriangleCount(), 1u);
+
+        // The shader uses the buffer size as the triangle count, so the buffers are recreated whenever the count changes
+        if (mpTriangleBuffer == nullptr || mpTriangleBuffer->getElementCount() != elementCount)
+        {
+            const auto& pTriDesc = pReflector->getBufferDesc(kTrianglesName, ProgramReflection::BufferReflection::Type::Structured);
+            const auto& pAliasDesc = pReflector->getBufferDesc(kAliasTableName, ProgramReflection::BufferReflection::Type::Structured);
+            if (pTriDesc == nullptr || pAliasDesc == nullptr)
+            {
+                logWarning("EmissiveTriangleTable::setIntoProgramVars() - can't find the emissive triangle buffers. Was the program compiled with _MS_EMISSIVE_TRIANGLES?");
+                return false;
+            }
+            if (pTriDesc->getRequiredSize() != sizeof(EmissiveTriangle) || pAliasDesc->getRequiredSize() != sizeof(EmissiveAliasEntry))
+            {
+                logError("EmissiveTriangleTable::setIntoProgramVars() - the shader struct sizes don't match the host structs");
+                return false;
+            }
+            mpTriangleBuffer = StructuredBuffer::create(pTriDesc, elementCount, Resource::BindFlags::ShaderResource);
+            mpAliasBuffer = StructuredBuffer::create(pAliasDesc, elementCount, Resource::BindFlags::ShaderResource);
+            mDirtyBegin = 0;
+            mDirtyEnd = elementCount;
+            mAliasDirty = true;
+        }
+
+        // ProgramVars uploads the buffers when they're applied. Only the range written by setBlob() since the last upload is sent to the GPU
+        if (mTriangles.empty())
+        {
+            if (mDirtyEnd > mDirtyBegin || mAliasDirty)
+            {
+                // A single entry with a zero pdf, so shaders can detect an empty table
+                EmissiveTriangle tri = {};
+                EmissiveAliasEntry entry = { 1.0f, 0, 0.0f, 0.0f };
+                mpTriangleBuffer->setBlob(&tri, 0, sizeof(tri));
+                mpAliasBuffer->setBlob(&entry, 0, sizeof(entry));
+            }
+        }
+        else
+        {
+            const uint32_t dirtyEnd = std::min(mDirtyEnd, getTriangleCount());
+            if (dirtyEnd > mDirtyBegin)
+            {
+                mpTriangleBuffer->setBlob(mTriangles.data() + mDirtyBegin, mDirtyBegin * sizeof(EmissiveTriangle), (dirtyEnd - mDirtyBegin) * sizeof(EmissiveTriangle));
+            }
+            if (mAliasDirty)
+            {
+                mpAliasBuffer->setBlob(mAliasTable.data(), 0, mAliasTable.size() * sizeof(EmissiveAliasEntry));
+            }
+        }
+        mDirtyBegin = mDirtyEnd = 0;
+        mAliasDirty = false;
+
+        pVars->setStructuredBuffer(kTrianglesName, mpTriangleBuffer);
+        pVars->setStructuredBuffer(kAliasTableName, mpAliasBuffer);
+        return true;
+    }
+}
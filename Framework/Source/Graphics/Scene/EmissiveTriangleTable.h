@@ -0,0 +1,134 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Model/Model.h"
+#include "API/StructuredBuffer.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    class Scene;
+    class ProgramVars;
+
+    /** Scene-wide table of emissive triangles.
+        Gathers the world-space triangles of every mesh instance with an emissive material, together with their area and flux, and builds an alias table so that a triangle can be picked proportionally to its power in O(1). This replaces iterating over one AreaLight per emissive mesh instance.
+        update() only re-transforms the instances that moved, and only the triangles of those instances are uploaded again. The alias table is only rebuilt if the triangle fluxes changed.
+        Textured emissive layers contribute the average of their texture to the triangle radiance and flux.
+        The table can be sampled on the CPU, or bound to programs compiled with _MS_EMISSIVE_TRIANGLES and sampled using sampleEmissiveTriangle() in Lights.slang.
+    */
+    class EmissiveTriangleTable
+    {
+    public:
+        using SharedPtr = std::shared_ptr<EmissiveTriangleTable>;
+        using SharedConstPtr = std::shared_ptr<const EmissiveTriangleTable>;
+
+        static const char* kTrianglesName;
+        static const char* kAliasTableName;
+
+        /** Create a new table
+        */
+        static SharedPtr create();
+
+        /** Collect the emissive mesh instances of the scene and update the triangles
+            \param[in] pScene The scene to collect the instances from
+            \return true if the table content changed, otherwise false
+        */
+        bool update(const Scene* pScene);
+
+        /** Pick a triangle with probability proportional to its flux. Must not be called on an empty table
+            \param[in] u Uniform random number in [0,1)
+            \param[out] pdf The probability of picking the returned triangle
+            \return The triangle index
+        */
+        uint32_t sampleTriangle(float u, float& pdf) const;
+
+        /** Uniformly sample a point on a triangle
+            \param[in] tri The triangle
+            \param[in] u Uniform random numbers in [0,1)
+        */
+        static glm::vec3 sampleTrianglePoint(const EmissiveTriangle& tri, const glm::vec2& u);
+
+        /** Bind the triangles and the alias table into a program vars object. The program must be compiled with _MS_EMISSIVE_TRIANGLES.
+            \return false if the program doesn't declare the table, otherwise true
+        */
+        bool setIntoProgramVars(ProgramVars* pVars);
+
+        uint32_t getTriangleCount() const { return (uint32_t)mTriangles.size(); }
+        const EmissiveTriangle& getTriangle(uint32_t index) const { return mTriangles[index]; }
+        uint32_t getInstanceCount() const { return (uint32_t)mInstances.size(); }
+        float getTotalFlux() const { return mTotalFlux; }
+
+    private:
+        EmissiveTriangleTable() = default;
+
+        struct MeshTriangles
+        {
+            std::weak_ptr<const Mesh> pMesh;    ///< Detects a new mesh allocated at the address of a destroyed one
+            std::vector<glm::vec3> vertices;    ///< Object-space vertices, 3 per triangle
+        };
+
+        struct TextureAverage
+        {
+            std::weak_ptr<const Texture> pTexture;
+            glm::vec3 value;
+            bool valid;
+        };
+
+        struct Instance
+        {
+            const Mesh* pMesh;
+            const void* pModelInstance;
+            const void* pMeshInstance;
+            glm::mat4 world;
+            glm::vec3 radiance;
+            uint32_t firstTriangle;
+            uint32_t triangleCount;
+        };
+
+        glm::vec3 getEmittedRadiance(const Material* pMaterial);
+        const TextureAverage& getTextureAverage(const Texture::SharedPtr& pTexture);
+        void readMeshTriangles(const std::vector<Mesh::SharedConstPtr>& meshes);
+        void markTrianglesDirty(uint32_t first, uint32_t count);
+        void transformInstances(const std::vector<uint32_t>& instances);
+        void buildAliasTable();
+
+        std::vector<Instance> mInstances;
+        std::vector<EmissiveTriangle> mTriangles;
+        std::vector<EmissiveAliasEntry> mAliasTable;
+        std::unordered_map<const Mesh*, MeshTriangles> mMeshTriangles;
+        std::unordered_map<const Texture*, TextureAverage> mTextureAverages;
+        float mTotalFlux = 0;
+
+        StructuredBuffer::SharedPtr mpTriangleBuffer;
+        StructuredBuffer::SharedPtr mpAliasBuffer;
+        // Range of triangles which changed since the last upload
+        uint32_t mDirtyBegin = 0;
+        uint32_t mDirtyEnd = 0;
+        bool mAliasDirty = false;
+    };
+}
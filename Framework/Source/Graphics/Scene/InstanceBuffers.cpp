@@ -0,0 +1,274 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "InstanceBuffers.h"
+#include "API/ProgramVars.h"
+
+namespace Falcor
+{
+    const char* InstanceBuffers::kInstancesName = "gInstances";
+    const char* InstanceBuffers::kVisibleName = "gVisibleInstances";
+
+    // Dirty instances closer than this are uploaded together. Re-uploading a few unchanged matrices is cheaper than issuing another copy
+    static const uint32_t kMaxUploadGap = 64;
+
+    static_assert(sizeof(InstanceData) == sizeof(glm::mat4) * 2, "InstanceData size doesn't match the shader struct");
+
+    InstanceBuffers::SharedPtr InstanceBuffers::create()
+    {
+        return SharedPtr(new InstanceBuffers());
+    }
+
+    void InstanceBuffers::rebuildLayout(const Scene* pScene)
+    {
+        mEntries.clear();
+        mFirstSlot.clear();
+        mSlotFirstInstance.clear();
+
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance* pModelInstance = pScene->getModelInstance(modelID, instanceID).get();
+                mFirstSlot[pModelInstance] = (uint32_t)mSlotFirstInstance.size();
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    if (pModel->getMesh(meshID)->hasBones())
+                    {
+                        mSlotFirstInstance.push_back(kInvalidIndex);
+                        continue;
+                    }
+
+                    mSlotFirstInstance.push_back((uint32_t)mEntries.size());
+                    for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                    {
+                        Entry entry;
+                        entry.pModelInstance = pModelInstance;
+                        entry.pMeshInstance = pModel->getMeshInstance(meshID, i).get();
+                        mEntries.push_back(entry);
+                    }
+                }
+            }
+        }
+
+        mData.resize(mEntries.size());
+        for (uint32_t i = 0; i < (uint32_t)mEntries.size(); i++)
+        {
+            updateTransforms(i);
+        }
+        mDirty.clear();
+        mUploadAll = true;
+        mVisibleRanges.assign(mSlotFirstInstance.size(), glm::uvec2(0));
+    }
+
+    void InstanceBuffers::updateTransforms(uint32_t index)
+    {
+        Entry& entry = mEntries[index];
+        entry.modelVersion = entry.pModelInstance->getTransformVersion();
+        entry.meshVersion = entry.pMeshInstance->getTransformVersion();
+
+        glm::mat4 worldMat = entry.pModelInstance->getTransformMatrix() * entry.pMeshInstance->getTransformMatrix();
+        mData[index].worldMat = worldMat;
+        mData[index].worldInvTransposeMat = glm::mat4(transpose(inverse(glm::mat3(worldMat))));
+    }
+
+    bool InstanceBuffers::update(const Scene* pScene)
+    {
+        // Walk the scene in layout order. Any mismatch means instances were added or removed
+        bool layoutValid = true;
+        uint32_t index = 0;
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount() && layoutValid; modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID) && layoutValid; instanceID++)
+            {
+                const Scene::ModelInstance* pModelInstance = pScene->getModelInstance(modelID, instanceID).get();
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount() && layoutValid; meshID++)
+                {
+                    if (pModel->getMesh(meshID)->hasBones()) continue;
+
+                    for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++, index++)
+                    {
+                        if (index >= mEntries.size() || mEntries[index].pModelInstance != pModelInstance || mEntries[index].pMeshInstance != pModel->getMeshInstance(meshID, i).get())
+                        {
+                            layoutValid = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        mStats = Stats();
+        if (layoutValid == false || index != mEntries.size())
+        {
+            rebuildLayout(pScene);
+            mStats.instanceCount = mStats.updatedCount = (uint32_t)mEntries.size();
+            return true;
+        }
+
+        mDirty.clear();
+        for (uint32_t i = 0; i < (uint32_t)mEntries.size(); i++)
+        {
+            const Entry& entry = mEntries[i];
+            if (entry.modelVersion != entry.pModelInstance->getTransformVersion() || entry.meshVersion != entry.pMeshInstance->getTransformVersion())
+            {
+                updateTransforms(i);
+                mDirty.push_back(i);
+            }
+        }
+        mStats.instanceCount = (uint32_t)mEntries.size();
+        mStats.updatedCount = (uint32_t)mDirty.size();
+        return mDirty.size() != 0;
+    }
+
+    uint32_t InstanceBuffers::getSlot(const Scene::ModelInstance* pModelInstance, uint32_t meshID) const
+    {
+        auto it = mFirstSlot.find(pModelInstance);
+        if (it == mFirstSlot.end()) return kInvalidIndex;
+
+        uint32_t slot = it->second + meshID;
+        return (mSlotFirstInstance[slot] == kInvalidIndex) ? kInvalidIndex : slot;
+    }
+
+    void InstanceBuffers::clearVisible()
+    {
+        mVisible.clear();
+        std::fill(mVisibleRanges.begin(), mVisibleRanges.end(), glm::uvec2(0));
+    }
+
+    void InstanceBuffers::addVisible(uint32_t slot, uint32_t instanceID)
+    {
+        glm::uvec2& range = mVisibleRanges[slot];
+        if (range.y == 0)
+        {
+            range.x = (uint32_t)mVisible.size();
+        }
+        assert(range.x + range.y == mVisible.size());
+        range.y++;
+        mVisible.push_back(mSlotFirstInstance[slot] + instanceID);
+    }
+
+    void InstanceBuffers::uploadDirtyRanges()
+    {
+        // Upload the whole buffer if most of it changed, otherwise merge nearby instances into runs
+        if (mUploadAll || mDirty.size() > mEntries.size() / 2)
+        {
+            if (mData.size())
+            {
+                mpInstanceBuffer->setBlob(mData.data(), 0, mData.size() * sizeof(InstanceData));
+                mpInstanceBuffer->uploadToGPU(0, mData.size() * sizeof(InstanceData));
+                mStats.uploadCount++;
+            }
+            mUploadAll = false;
+            mDirty.clear();
+            return;
+        }
+
+        size_t i = 0;
+        while (i < mDirty.size())
+        {
+            uint32_t first = mDirty[i];
+            uint32_t last = first;
+            for (i++; i < mDirty.size() && mDirty[i] - last <= kMaxUploadGap; i++)
+            {
+                last = mDirty[i];
+            }
+
+            // uploadToGPU() only copies if the buffer was changed since the last upload, so every run needs its own setBlob()
+            size_t offset = first * sizeof(InstanceData);
+            size_t size = (last - first + 1) * sizeof(InstanceData);
+            mpInstanceBuffer->setBlob(mData.data() + first, offset, size);
+            mpInstanceBuffer->uploadToGPU(offset, size);
+            mStats.uploadCount++;
+        }
+        mDirty.clear();
+    }
+
+    /** The instance buffer reflections, resolved once per program
+    */
+    struct InstanceBufferBindings
+    {
+        InstanceBufferBindings(const ProgramReflection* pReflector)
+        {
+            pInstancesDesc = pReflector->getBufferDesc(InstanceBuffers::kInstancesName, ProgramReflection::BufferReflection::Type::Structured);
+            pVisibleDesc = pReflector->getBufferDesc(InstanceBuffers::kVisibleName, ProgramReflection::BufferReflection::Type::Structured);
+        }
+
+        ProgramReflection::BufferReflection::SharedConstPtr pInstancesDesc;
+        ProgramReflection::BufferReflection::SharedConstPtr pVisibleDesc;
+        mutable bool warned = false;    ///< The missing buffers are reported once per program
+    };
+
+    bool InstanceBuffers::setIntoProgramVars(ProgramVars* pVars)
+    {
+        const InstanceBufferBindings& bindings = pVars->getReflection()->getBindingCache<InstanceBufferBindings>();
+        const auto& pInstancesDesc = bindings.pInstancesDesc;
+        const auto& pVisibleDesc = bindings.pVisibleDesc;
+        if (pInstancesDesc == nullptr || pVisibleDesc == nullptr)
+        {
+            if (bindings.warned == false)
+            {
+                logWarning("InstanceBuffers::setIntoProgramVars() - can't find the instance buffers. Was the program compiled with _MS_INSTANCE_BUFFERS?");
+                bindings.warned = true;
+            }
+            return false;
+        }
+
+        if (mpInstanceBuffer == nullptr || mpInstanceBuffer->getElementCount() < mData.size())
+        {
+            if (pInstancesDesc->getRequiredSize() != sizeof(InstanceData))
+            {
+                logError("InstanceBuffers::setIntoProgramVars() - the shader instance struct size doesn't match InstanceData");
+                return false;
+            }
+            mpInstanceBuffer = StructuredBuffer::create(pInstancesDesc, std::max<size_t>(mData.size(), 1), Resource::BindFlags::ShaderResource);
+            mUploadAll = true;
+        }
+        if (mpVisibleBuffer == nullptr || mpVisibleBuffer->getElementCount() < mVisible.size())
+        {
+            // Leave some room, the visible count changes with the camera
+            mpVisibleBuffer = StructuredBuffer::create(pVisibleDesc, std::max<size_t>(mVisible.size() + mVisible.size() / 2, 1), Resource::BindFlags::ShaderResource);
+        }
+
+        // Upload explicitly instead of letting ProgramVars do it, so that only the changed ranges are copied
+        uploadDirtyRanges();
+        if (mVisible.size())
+        {
+            mpVisibleBuffer->setBlob(mVisible.data(), 0, mVisible.size() * sizeof(uint32_t));
+            mpVisibleBuffer->uploadToGPU(0, mVisible.size() * sizeof(uint32_t));
+        }
+        mStats.visibleCount = (uint32_t)mVisible.size();
+
+        pVars->setStructuredBuffer(kInstancesName, mpInstanceBuffer);
+        pVars->setStructuredBuffer(kVisibleName, mpVisibleBuffer);
+        return true;
+    }
+}
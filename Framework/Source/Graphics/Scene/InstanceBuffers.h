@@ -0,0 +1,126 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Scene/Scene.h"
+#include "API/StructuredBuffer.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    class ProgramVars;
+
+    /** Persistent instance transform buffers.
+        Stores the world and inverse-transpose matrices of every mesh instance of a scene in a structured buffer. The instances of a mesh inside a model instance are contiguous. A matrix is only recomputed and uploaded when its model or mesh instance moved.
+        Every frame, the renderer appends the indices of the instances which passed culling to the visible-instance list. Shaders compiled with _MS_INSTANCE_BUFFERS read instance i of a draw from gInstances[gVisibleInstances[gVisibleInstanceOffset + i]], so all the visible instances of a mesh are drawn with a single call, regardless of the size of the per-mesh constant buffer arrays.
+        Skinned meshes are not stored, they keep using the bone matrices.
+    */
+    class InstanceBuffers
+    {
+    public:
+        using SharedPtr = std::shared_ptr<InstanceBuffers>;
+        using SharedConstPtr = std::shared_ptr<const InstanceBuffers>;
+
+        static const uint32_t kInvalidIndex = (uint32_t)-1;
+        static const char* kInstancesName;
+        static const char* kVisibleName;
+
+        /** Statistics of the last update() and setIntoProgramVars() calls
+        */
+        struct Stats
+        {
+            uint32_t instanceCount = 0;     ///< Number of mesh instances in the buffer
+            uint32_t updatedCount = 0;      ///< Number of instances whose transforms changed
+            uint32_t uploadCount = 0;       ///< Number of buffer uploads issued for the changed instances
+            uint32_t visibleCount = 0;      ///< Number of entries in the last visible list
+        };
+
+        /** Create new instance buffers
+        */
+        static SharedPtr create();
+
+        /** Refresh the transforms of the instances which moved. The layout is rebuilt if instances were added or removed
+            \return true if any transform changed, otherwise false
+        */
+        bool update(const Scene* pScene);
+
+        /** Get the slot of a mesh inside a model instance. A slot holds all the instances of the mesh, in the order of Model::getMeshInstance()
+            \return The slot index, or kInvalidIndex if the mesh is skinned or the model instance was not part of the scene when update() was called
+        */
+        uint32_t getSlot(const Scene::ModelInstance* pModelInstance, uint32_t meshID) const;
+
+        /** Clear the visible-instance list. Call once per render pass, before adding the visible instances
+        */
+        void clearVisible();
+
+        /** Append an instance to the visible-instance list. The visible instances of a slot must be added consecutively
+            \param[in] slot Slot returned by getSlot()
+            \param[in] instanceID Mesh instance ID inside the slot
+        */
+        void addVisible(uint32_t slot, uint32_t instanceID);
+
+        /** Get the visible instances of a slot
+            \return The offset of the slot's first entry in the visible list (x) and the number of visible instances (y)
+        */
+        const glm::uvec2& getVisibleRange(uint32_t slot) const { return mVisibleRanges[slot]; }
+
+        /** Upload the changed transforms and the visible-instance list, and bind both buffers into a program vars object. The program must be compiled with _MS_INSTANCE_BUFFERS.
+            \return false if the program doesn't declare the instance buffers, otherwise true
+        */
+        bool setIntoProgramVars(ProgramVars* pVars);
+
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        InstanceBuffers() = default;
+
+        struct Entry
+        {
+            const Scene::ModelInstance* pModelInstance;
+            const Model::MeshInstance* pMeshInstance;
+            uint32_t modelVersion;
+            uint32_t meshVersion;
+        };
+
+        void rebuildLayout(const Scene* pScene);
+        void updateTransforms(uint32_t index);
+        void uploadDirtyRanges();
+
+        std::vector<Entry> mEntries;
+        std::vector<InstanceData> mData;
+        std::vector<uint32_t> mDirty;                           ///< Indices of the changed instances, in increasing order
+        std::unordered_map<const Scene::ModelInstance*, uint32_t> mFirstSlot;  ///< Slot of mesh 0 of each model instance
+        std::vector<uint32_t> mSlotFirstInstance;               ///< First instance of each slot, kInvalidIndex for skinned meshes
+        std::vector<uint32_t> mVisible;
+        std::vector<glm::uvec2> mVisibleRanges;
+
+        StructuredBuffer::SharedPtr mpInstanceBuffer;
+        StructuredBuffer::SharedPtr mpVisibleBuffer;
+        bool mUploadAll = false;
+        Stats mStats;
+    };
+}
@@ -0,0 +1,507 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightClusters.h"
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Camera/Camera.h"
+#include "API/ProgramVars.h"
+#include "API/ConstantBuffer.h"
+#include "Utils/CpuTimer.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <random>
+#include <thread>
+
+namespace Falcor
+{
+    const char* LightClusters::kLightsName = "gClusteredLights";
+    const char* LightClusters::kRangesName = "gLightClusterRanges";
+    const char* LightClusters::kIndicesName = "gLightClusterIndices";
+
+    const float LightClusters::kDefaultIntensityThreshold = 1e-3f;
+
+    // Binning fewer light/cluster pairs than this is faster than spawning threads
+    static const uint32_t kParallelWorkThreshold = 1 << 16;
+    // Padding entries of the bounds arrays. Far enough to never intersect a cluster, close enough for the squared distance not to overflow
+    static const float kPaddingCenter = 1e18f;
+
+    LightClusters::SharedPtr LightClusters::create(uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ)
+    {
+        return SharedPtr(new LightClusters(gridSizeX, gridSizeY, gridSizeZ));
+    }
+
+    LightClusters::LightClusters(uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ)
+    {
+        setGridSize(gridSizeX, gridSizeY, gridSizeZ);
+    }
+
+    void LightClusters::setGridSize(uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ)
+    {
+        assert(gridSizeX > 0 && gridSizeY > 0 && gridSizeZ > 0);
+        mParams.gridSizeX = gridSizeX;
+        mParams.gridSizeY = gridSizeY;
+        mParams.gridSizeZ = gridSizeZ;
+    }
+
+    float LightClusters::getLightRadius(const LightData& light) const
+    {
+        if (light.type != LightPoint) return std::numeric_limits<float>::infinity();
+
+        // The shader attenuates point lights by 1/d^2
+        const float intensity = glm::max(light.intensity.x, glm::max(light.intensity.y, light.intensity.z));
+        if (intensity <= 0) return 0;
+        if (mIntensityThreshold <= 0) return std::numeric_limits<float>::infinity();
+        return sqrt(intensity / mIntensityThreshold);
+    }
+
+    float LightClusters::getSliceDepth(uint32_t z) const
+    {
+        return mNearZ * pow(mFarZ / mNearZ, (float)z / (float)mParams.gridSizeZ);
+    }
+
+    glm::vec2 LightClusters::getViewPosition(const glm::vec2& ndc, float depth) const
+    {
+        // Invert the projection for a point at view-space z = -depth. Works for perspective and orthographic projections, including the camera jitter
+        const glm::mat4& p = mProjMat;
+        const float z = -depth;
+        const float w = p[2][3] * z + p[3][3];
+        glm::vec2 pos;
+        pos.x = (ndc.x * w - p[2][0] * z - p[3][0]) / p[0][0];
+        pos.y = (ndc.y * w - p[2][1] * z - p[3][1]) / p[1][1];
+        return pos;
+    }
+
+    LightClusters::ClusterBounds LightClusters::getClusterBounds(uint32_t x, uint32_t y, uint32_t z) const
+    {
+        // Tile rows go from the top of the screen down, matching getLightClusterRange()
+        const glm::vec2 ndcMin(-1.0f + 2.0f * x / mParams.gridSizeX, 1.0f - 2.0f * (y + 1) / mParams.gridSizeY);
+        const glm::vec2 ndcMax(-1.0f + 2.0f * (x + 1) / mParams.gridSizeX, 1.0f - 2.0f * y / mParams.gridSizeY);
+        const float depth[2] = { getSliceDepth(z), getSliceDepth(z + 1) };
+
+        ClusterBounds bounds;
+        bounds.min = glm::vec3(std::numeric_limits<float>::max());
+        bounds.max = glm::vec3(-std::numeric_limits<float>::max());
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            const glm::vec2 p0 = getViewPosition(ndcMin, depth[i]);
+            const glm::vec2 p1 = getViewPosition(ndcMax, depth[i]);
+            bounds.min = glm::min(bounds.min, glm::vec3(glm::min(p0, p1), depth[i]));
+            bounds.max = glm::max(bounds.max, glm::vec3(glm::max(p0, p1), depth[i]));
+        }
+        return bounds;
+    }
+
+    void LightClusters::setupFrustum(const Camera* pCamera)
+    {
+        mViewMat = pCamera->getViewMatrix();
+        mProjMat = pCamera->getProjMatrix();
+        mNearZ = pCamera->getNearPlane();
+        mFarZ = pCamera->getFarPlane();
+
+        // Slice z starts at nearZ * (farZ / nearZ)^(z / gridSizeZ)
+        const float logRange = log(mFarZ / mNearZ);
+        mParams.depthScale = mParams.gridSizeZ / logRange;
+        mParams.depthBias = -log(mNearZ) * mParams.depthScale;
+    }
+
+    void LightClusters::buildSlice(uint32_t z, std::vector<uint32_t>& indices)
+    {
+        indices.clear();
+
+        // Only the lights which overlap the slice depth range can affect its clusters
+        const float depth0 = getSliceDepth(z);
+        const float depth1 = getSliceDepth(z + 1);
+        std::vector<float> cx, cy, cz, r2;
+        std::vector<uint32_t> lights;
+        for (size_t i = 0; i < mBoundedLights.size(); i++)
+        {
+            if (mCenterZ[i] - mRadius[i] <= depth1 && mCenterZ[i] + mRadius[i] >= depth0)
+            {
+                cx.push_back(mCenterX[i]);
+                cy.push_back(mCenterY[i]);
+                cz.push_back(mCenterZ[i]);
+                r2.push_back(mRadius[i] * mRadius[i]);
+                lights.push_back(mBoundedLights[i]);
+            }
+        }
+        while (cx.size() % 4)
+        {
+            cx.push_back(kPaddingCenter);
+            cy.push_back(kPaddingCenter);
+            cz.push_back(kPaddingCenter);
+            r2.push_back(0);
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        for (uint32_t y = 0; y < mParams.gridSizeY; y++)
+        {
+            for (uint32_t x = 0; x < mParams.gridSizeX; x++)
+            {
+                const uint32_t start = (uint32_t)indices.size();
+                indices.insert(indices.end(), mGlobalLights.begin(), mGlobalLights.end());
+
+                // Sphere/AABB test against 4 lights at a time, using the squared distance from the sphere center to the box
+                const ClusterBounds bounds = getClusterBounds(x, y, z);
+                const __m128 minX = _mm_set1_ps(bounds.min.x), maxX = _mm_set1_ps(bounds.max.x);
+                const __m128 minY = _mm_set1_ps(bounds.min.y), maxY = _mm_set1_ps(bounds.max.y);
+                const __m128 minZ = _mm_set1_ps(bounds.min.z), maxZ = _mm_set1_ps(bounds.max.z);
+                for (size_t i = 0; i < cx.size(); i += 4)
+                {
+                    const __m128 px = _mm_loadu_ps(&cx[i]);
+                    const __m128 py = _mm_loadu_ps(&cy[i]);
+                    const __m128 pz = _mm_loadu_ps(&cz[i]);
+                    const __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minX, px), zero), _mm_max_ps(_mm_sub_ps(px, maxX), zero));
+                    const __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minY, py), zero), _mm_max_ps(_mm_sub_ps(py, maxY), zero));
+                    const __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minZ, pz), zero), _mm_max_ps(_mm_sub_ps(pz, maxZ), zero));
+                    const __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(dist2, _mm_loadu_ps(&r2[i])));
+                    while (mask)
+                    {
+                        const uint32_t lane = (mask & 1) ? 0 : (mask & 2) ? 1 : (mask & 4) ? 2 : 3;
+                        indices.push_back(lights[i + lane]);
+                        mask &= mask - 1;
+                    }
+                }
+
+                // Offsets are relative to the slice for now, build() adds the slice offset
+                mRanges[getClusterIndex(x, y, z)] = glm::uvec2(start, (uint32_t)indices.size() - start);
+            }
+        }
+    }
+
+    void LightClusters::build(const Scene* pScene, const Camera* pCamera)
+    {
+        std::vector<LightData> lights(pScene->getLightCount());
+        for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+        {
+            lights[i] = pScene->getLight(i)->getData();
+        }
+        build(lights, pCamera);
+    }
+
+    void LightClusters::build(const std::vector<LightData>& lights, const Camera* pCamera)
+    {
+        const auto startTime = CpuTimer::getCurrentTimePoint();
+
+        if (lights.size() != mLights.size() || (lights.size() && memcmp(lights.data(), mLights.data(), lights.size() * sizeof(LightData)) != 0))
+        {
+            mLights = lights;
+            mLightsDirty = true;
+        }
+
+        setupFrustum(pCamera);
+
+        // Transform the light bounds to view space
+        const glm::mat4& viewMat = mViewMat;
+        mCenterX.clear();
+        mCenterY.clear();
+        mCenterZ.clear();
+        mRadius.clear();
+        mBoundedLights.clear();
+        mGlobalLights.clear();
+        for (uint32_t i = 0; i < (uint32_t)mLights.size(); i++)
+        {
+            const float radius = getLightRadius(mLights[i]);
+            if (radius == std::numeric_limits<float>::infinity())
+            {
+                mGlobalLights.push_back(i);
+            }
+            else if (radius > 0)
+            {
+                const glm::vec3 center = glm::vec3(viewMat * glm::vec4(mLights[i].worldPos, 1));
+                mCenterX.push_back(center.x);
+                mCenterY.push_back(center.y);
+                mCenterZ.push_back(-center.z);
+                mRadius.push_back(radius);
+                mBoundedLights.push_back(i);
+            }
+        }
+
+        // Bin the slices independently. Slices hold different numbers of lights, so threads grab them one at a time
+        const uint32_t sliceCount = mParams.gridSizeZ;
+        mRanges.resize(getClusterCount());
+        std::vector<std::vector<uint32_t>> sliceIndices(sliceCount);
+        const uint32_t threadCount = std::min(std::thread::hardware_concurrency(), sliceCount);
+        if ((uint64_t)mBoundedLights.size() * getClusterCount() < kParallelWorkThreshold || threadCount <= 1)
+        {
+            for (uint32_t z = 0; z < sliceCount; z++) buildSlice(z, sliceIndices[z]);
+        }
+        else
+        {
+            std::atomic<uint32_t> next(0);
+            auto worker = [&]()
+            {
+                for (uint32_t z = next++; z < sliceCount; z = next++) buildSlice(z, sliceIndices[z]);
+            };
+
+            std::vector<std::thread> threads;
+            for (uint32_t i = 1; i < threadCount; i++)
+            {
+                threads.push_back(std::thread(worker));
+            }
+            worker();
+            for (auto& t : threads) t.join();
+        }
+
+        // Concatenate the slice lists
+        mIndices.clear();
+        const uint32_t sliceClusterCount = mParams.gridSizeX * mParams.gridSizeY;
+        for (uint32_t z = 0; z < sliceCount; z++)
+        {
+            const uint32_t offset = (uint32_t)mIndices.size();
+            for (uint32_t c = z * sliceClusterCount; c < (z + 1) * sliceClusterCount; c++)
+            {
+                mRanges[c].x += offset;
+            }
+            mIndices.insert(mIndices.end(), sliceIndices[z].begin(), sliceIndices[z].end());
+        }
+        mClustersDirty = true;
+
+        mStats.lightCount = (uint32_t)mLights.size();
+        mStats.globalLightCount = (uint32_t)mGlobalLights.size();
+        mStats.indexCount = (uint32_t)mIndices.size();
+        mStats.maxClusterLightCount = 0;
+        mStats.emptyClusterCount = 0;
+        for (const auto& range : mRanges)
+        {
+            mStats.maxClusterLightCount = std::max(mStats.maxClusterLightCount, range.y);
+            mStats.emptyClusterCount += (range.y == 0) ? 1 : 0;
+        }
+        mStats.buildTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+    }
+
+    uint32_t LightClusters::validate() const
+    {
+        if (mRanges.size() != getClusterCount())
+        {
+            return getClusterCount();
+        }
+
+        // View-space bounding spheres. The radius is infinite for the lights which affect every cluster
+        std::vector<glm::vec3> centers(mLights.size());
+        std::vector<float> radii(mLights.size());
+        for (size_t i = 0; i < mLights.size(); i++)
+        {
+            centers[i] = glm::vec3(mViewMat * glm::vec4(mLights[i].worldPos, 1));
+            radii[i] = getLightRadius(mLights[i]);
+        }
+
+        const glm::mat4 invProjMat = glm::inverse(mProjMat);
+        auto unproject = [&](float x, float y, float z)
+        {
+            const glm::vec4 p = invProjMat * glm::vec4(x, y, z, 1);
+            return glm::vec3(p) / p.w;
+        };
+
+        uint32_t mismatchCount = 0;
+        std::vector<bool> inCluster(mLights.size());
+        for (uint32_t z = 0; z < mParams.gridSizeZ; z++)
+        {
+            // The inverse of the shader's slice mapping, z = log(depth) * depthScale + depthBias
+            const float depth[2] = { exp((z - mParams.depthBias) / mParams.depthScale), exp((z + 1 - mParams.depthBias) / mParams.depthScale) };
+            for (uint32_t y = 0; y < mParams.gridSizeY; y++)
+            {
+                for (uint32_t x = 0; x < mParams.gridSizeX; x++)
+                {
+                    // Intersect the 4 corner rays of the tile with the 2 slice planes
+                    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+                    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+                    for (uint32_t corner = 0; corner < 4; corner++)
+                    {
+                        const float ndcX = -1.0f + 2.0f * (x + (corner & 1)) / mParams.gridSizeX;
+                        const float ndcY = 1.0f - 2.0f * (y + (corner >> 1)) / mParams.gridSizeY;
+                        const glm::vec3 p0 = unproject(ndcX, ndcY, 0);
+                        const glm::vec3 p1 = unproject(ndcX, ndcY, 1);
+                        for (float d : depth)
+                        {
+                            const glm::vec3 p = p0 + (p1 - p0) * ((-d - p0.z) / (p1.z - p0.z));
+                            boundsMin = glm::min(boundsMin, p);
+                            boundsMax = glm::max(boundsMax, p);
+                        }
+                    }
+
+                    // Every index must be a valid light, and appear once
+                    bool mismatch = false;
+                    std::fill(inCluster.begin(), inCluster.end(), false);
+                    const glm::uvec2& range = mRanges[getClusterIndex(x, y, z)];
+                    for (uint32_t i = range.x; i < range.x + range.y; i++)
+                    {
+                        if (i >= mIndices.size() || mIndices[i] >= mLights.size() || inCluster[mIndices[i]])
+                        {
+                            mismatch = true;
+                            break;
+                        }
+                        inCluster[mIndices[i]] = true;
+                    }
+
+                    for (size_t i = 0; i < mLights.size() && mismatch == false; i++)
+                    {
+                        if (radii[i] == std::numeric_limits<float>::infinity())
+                        {
+                            mismatch = (inCluster[i] == false);
+                        }
+                        else if (radii[i] <= 0)
+                        {
+                            mismatch = inCluster[i];
+                        }
+                        else
+                        {
+                            // The two computations round differently, so only flag spheres which are clearly inside or outside
+                            const glm::vec3 d = glm::max(boundsMin - centers[i], glm::vec3(0)) + glm::max(centers[i] - boundsMax, glm::vec3(0));
+                            const float distance = glm::length(d);
+                            const float tolerance = 1e-4f * (radii[i] + glm::length(centers[i]));
+                            mismatch = (distance < radii[i] - tolerance && inCluster[i] == false) || (distance > radii[i] + tolerance && inCluster[i]);
+                        }
+                    }
+                    mismatchCount += mismatch ? 1 : 0;
+                }
+            }
+        }
+        return mismatchCount;
+    }
+
+    LightClusters::Stats LightClusters::benchmark(const Camera* pCamera, uint32_t lightCount, uint32_t iterations, bool validateResult)
+    {
+        setupFrustum(pCamera);
+
+        // Place the lights uniformly in screen space and in log depth, so they spread over the clusters like the slices do
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        const glm::mat4 invViewMat = glm::inverse(pCamera->getViewMatrix());
+        std::vector<LightData> lights(lightCount);
+        for (auto& light : lights)
+        {
+            const glm::vec2 ndc(uniform(rng) * 2 - 1, uniform(rng) * 2 - 1);
+            const float depth = mNearZ * pow(mFarZ / mNearZ, uniform(rng));
+            const glm::vec2 pos = getViewPosition(ndc, depth);
+            const float radius = depth * (0.02f + 0.18f * uniform(rng));
+            light.type = LightPoint;
+            light.worldPos = glm::vec3(invViewMat * glm::vec4(pos, -depth, 1));
+            light.intensity = glm::vec3(radius * radius * std::max(mIntensityThreshold, kDefaultIntensityThreshold));
+        }
+
+        float totalTime = 0;
+        for (uint32_t i = 0; i < std::max(iterations, 1u); i++)
+        {
+            build(lights, pCamera);
+            totalTime += mStats.buildTime;
+        }
+
+        if (validateResult)
+        {
+            const uint32_t mismatchCount = validate();
+            if (mismatchCount)
+            {
+                logError("LightClusters::benchmark() - " + std::to_string(mismatchCount) + " clusters don't match the brute-force result");
+            }
+        }
+
+        Stats stats = mStats;
+        stats.buildTime = totalTime / std::max(iterations, 1u);
+        return stats;
+    }
+
+    struct LightClusterBindings
+    {
+        LightClusterBindings(const ProgramReflection* pReflector)
+        {
+            pLightsDesc = pReflector->getBufferDesc(LightClusters::kLightsName, ProgramReflection::BufferReflection::Type::Structured);
+            pRangesDesc = pReflector->getBufferDesc(LightClusters::kRangesName, ProgramReflection::BufferReflection::Type::Structured);
+            pIndicesDesc = pReflector->getBufferDesc(LightClusters::kIndicesName, ProgramReflection::BufferReflection::Type::Structured);
+        }
+        ProgramReflection::BufferReflection::SharedConstPtr pLightsDesc;
+        ProgramReflection::BufferReflection::SharedConstPtr pRangesDesc;
+        ProgramReflection::BufferReflection::SharedConstPtr pIndicesDesc;
+        mutable bool warned = false;
+    };
+
+    bool LightClusters::setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, size_t paramsOffset)
+    {
+        // Resolved once per program version, which also limits the warning below to once per program
+        const auto& bindings = pVars->getReflection()->getBindingCache<LightClusterBindings>();
+        const auto& pLightsDesc = bindings.pLightsDesc;
+        const auto& pRangesDesc = bindings.pRangesDesc;
+        const auto& pIndicesDesc = bindings.pIndicesDesc;
+        if (pLightsDesc == nullptr || pRangesDesc == nullptr || pIndicesDesc == nullptr || paramsOffset == ConstantBuffer::kInvalidOffset)
+        {
+            if (bindings.warned == false)
+            {
+                logWarning("LightClusters::setIntoProgramVars() - can't find the light cluster buffers. Was the program compiled with _MS_LIGHT_CLUSTERS?");
+                bindings.warned = true;
+            }
+            return false;
+        }
+
+        // The shader never reads past the ranges, so the light and index buffers only grow
+        if (mpLightBuffer == nullptr || mpLightBuffer->getElementCount() < mLights.size())
+        {
+            if (pLightsDesc->getRequiredSize() != sizeof(LightData))
+            {
+                logError("LightClusters::setIntoProgramVars() - the shader light struct size doesn't match LightData");
+                return false;
+            }
+            mpLightBuffer = StructuredBuffer::create(pLightsDesc, std::max<size_t>(mLights.size(), 1), Resource::BindFlags::ShaderResource);
+            mLightsDirty = true;
+        }
+        if (mpRangeBuffer == nullptr || mpRangeBuffer->getElementCount() != mRanges.size())
+        {
+            mpRangeBuffer = StructuredBuffer::create(pRangesDesc, std::max<size_t>(mRanges.size(), 1), Resource::BindFlags::ShaderResource);
+            mClustersDirty = true;
+        }
+        if (mpIndexBuffer == nullptr || mpIndexBuffer->getElementCount() < mIndices.size())
+        {
+            // Leave some room, the index count changes with the camera
+            mpIndexBuffer = StructuredBuffer::create(pIndicesDesc, std::max<size_t>(mIndices.size() + mIndices.size() / 2, 1), Resource::BindFlags::ShaderResource);
+            mClustersDirty = true;
+        }
+
+        // ProgramVars uploads the buffers when they're applied
+        if (mLightsDirty && mLights.size())
+        {
+            mpLightBuffer->setBlob(mLights.data(), 0, mLights.size() * sizeof(LightData));
+        }
+        mLightsDirty = false;
+        if (mClustersDirty && mRanges.size())
+        {
+            mpRangeBuffer->setBlob(mRanges.data(), 0, mRanges.size() * sizeof(glm::uvec2));
+            if (mIndices.size())
+            {
+                mpIndexBuffer->setBlob(mIndices.data(), 0, mIndices.size() * sizeof(uint32_t));
+            }
+        }
+        mClustersDirty = false;
+
+        pCB->setBlob(&mParams, paramsOffset, sizeof(mParams));
+        pVars->setStructuredBuffer(kLightsName, mpLightBuffer);
+        pVars->setStructuredBuffer(kRangesName, mpRangeBuffer);
+        pVars->setStructuredBuffer(kIndicesName, mpIndexBuffer);
+        return true;
+    }
+}
@@ -0,0 +1,173 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Light.h"
+#include "API/StructuredBuffer.h"
+
+namespace Falcor
+{
+    class Scene;
+    class Camera;
+    class ProgramVars;
+    class ConstantBuffer;
+
+    /** Clustered light culling.
+        Splits the view frustum of a camera into a grid of froxels, tiles in screen space and exponential slices in depth, and bins the lights into them. Point and spot lights are bounded by the sphere at which their radiance drops below an intensity threshold. Directional and area lights affect every cluster.
+        The result is a compact list of light indices per cluster. Shaders compiled with _MS_LIGHT_CLUSTERS use getLightClusterRange() from ShaderCommon.slang to only visit the lights of the cluster a pixel belongs to. The lights themselves are stored in a structured buffer, so their number isn't limited by the per-frame constant buffer.
+        build() only runs on the CPU. Together with validate() and benchmark(), it can be used without a GPU device.
+    */
+    class LightClusters
+    {
+    public:
+        using SharedPtr = std::shared_ptr<LightClusters>;
+        using SharedConstPtr = std::shared_ptr<const LightClusters>;
+
+        static const char* kLightsName;
+        static const char* kRangesName;
+        static const char* kIndicesName;
+
+        static const float kDefaultIntensityThreshold;
+
+        /** Build statistics, updated by every build() call
+        */
+        struct Stats
+        {
+            float buildTime = 0;                ///< CPU time of the last build, in milliseconds
+            uint32_t lightCount = 0;            ///< Number of lights passed to build()
+            uint32_t globalLightCount = 0;      ///< Number of lights which affect every cluster
+            uint32_t indexCount = 0;            ///< Total number of light indices in all the clusters
+            uint32_t maxClusterLightCount = 0;  ///< Largest number of lights in a single cluster
+            uint32_t emptyClusterCount = 0;
+        };
+
+        /** Create a new cluster grid
+            \param[in] gridSizeX Number of tiles along the screen width
+            \param[in] gridSizeY Number of tiles along the screen height
+            \param[in] gridSizeZ Number of depth slices between the camera near and far planes
+        */
+        static SharedPtr create(uint32_t gridSizeX = 16, uint32_t gridSizeY = 9, uint32_t gridSizeZ = 24);
+
+        /** Set the grid dimensions. Takes effect on the next build()
+        */
+        void setGridSize(uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ);
+
+        /** Set the radiance below which a point light is considered to have no effect. Smaller values result in larger light bounds. 0 disables culling of point lights
+        */
+        void setIntensityThreshold(float threshold) { mIntensityThreshold = threshold; }
+        float getIntensityThreshold() const { return mIntensityThreshold; }
+
+        /** Bin the scene lights into the clusters of a camera
+        */
+        void build(const Scene* pScene, const Camera* pCamera);
+
+        /** Bin a list of lights into the clusters of a camera. Doesn't access the GPU
+        */
+        void build(const std::vector<LightData>& lights, const Camera* pCamera);
+
+        /** Compare the result of the last build() with a brute-force test of every light against every cluster.
+            The reference doesn't reuse the build data: cluster corners come from the inverse projection and the slice mapping the shader uses, and light bounds from the world-space light data. Lights within a small tolerance of a cluster boundary are accepted either way
+            \return The number of clusters whose light list doesn't match
+        */
+        uint32_t validate() const;
+
+        /** Build clusters for randomly placed point lights inside the camera frustum and measure the average build time. Doesn't access the GPU
+            \param[in] pCamera The camera to build the clusters for
+            \param[in] lightCount Number of random lights
+            \param[in] iterations Number of builds to average
+            \param[in] validateResult Validate the last build and log an error if it fails
+            \return The statistics of the last build, with buildTime set to the average build time
+        */
+        Stats benchmark(const Camera* pCamera, uint32_t lightCount, uint32_t iterations, bool validateResult = true);
+
+        /** Bind the lights, cluster ranges and light indices into a program vars object and write the grid parameters into the per-frame constant buffer. The program must be compiled with _MS_LIGHT_CLUSTERS.
+            \param[in] pVars The program vars
+            \param[in] pCB The constant buffer declaring gLightClusters
+            \param[in] paramsOffset The offset of gLightClusters in pCB
+            \return false if the program doesn't declare the cluster buffers, otherwise true
+        */
+        bool setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, size_t paramsOffset);
+
+        /** Get the radius beyond which a light's radiance is below the intensity threshold. Returns infinity for lights which affect the whole scene, and 0 for lights which emit nothing
+        */
+        float getLightRadius(const LightData& light) const;
+
+        uint32_t getClusterCount() const { return mParams.gridSizeX * mParams.gridSizeY * mParams.gridSizeZ; }
+        uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * mParams.gridSizeY + y) * mParams.gridSizeX + x; }
+
+        /** Get the offset and count of a cluster's lights in the index list
+        */
+        const glm::uvec2& getClusterRange(uint32_t clusterIndex) const { return mRanges[clusterIndex]; }
+        const std::vector<uint32_t>& getLightIndices() const { return mIndices; }
+        const LightClusterParams& getParams() const { return mParams; }
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        LightClusters(uint32_t gridSizeX, uint32_t gridSizeY, uint32_t gridSizeZ);
+
+        // View-space bounds of a cluster. z is the positive distance along the view direction
+        struct ClusterBounds
+        {
+            glm::vec3 min;
+            glm::vec3 max;
+        };
+
+        void setupFrustum(const Camera* pCamera);
+        ClusterBounds getClusterBounds(uint32_t x, uint32_t y, uint32_t z) const;
+        float getSliceDepth(uint32_t z) const;
+        glm::vec2 getViewPosition(const glm::vec2& ndc, float depth) const;
+        void buildSlice(uint32_t z, std::vector<uint32_t>& indices);
+
+        LightClusterParams mParams;
+        float mIntensityThreshold = kDefaultIntensityThreshold;
+
+        // Frustum of the last build
+        glm::mat4 mViewMat;
+        glm::mat4 mProjMat;
+        float mNearZ = 0;
+        float mFarZ = 0;
+
+        // View-space light bounds, stored as separate arrays for SSE. Padded to a multiple of 4
+        std::vector<float> mCenterX;
+        std::vector<float> mCenterY;
+        std::vector<float> mCenterZ;
+        std::vector<float> mRadius;
+        std::vector<uint32_t> mBoundedLights;   ///< Light index of each entry in the bounds arrays
+        std::vector<uint32_t> mGlobalLights;    ///< Lights which are added to every cluster
+
+        std::vector<LightData> mLights;
+        std::vector<glm::uvec2> mRanges;
+        std::vector<uint32_t> mIndices;
+        Stats mStats;
+
+        StructuredBuffer::SharedPtr mpLightBuffer;
+        StructuredBuffer::SharedPtr mpRangeBuffer;
+        StructuredBuffer::SharedPtr mpIndexBuffer;
+        bool mLightsDirty = false;
+        bool mClustersDirty = false;
+    };
+}
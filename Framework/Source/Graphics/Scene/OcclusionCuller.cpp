@@ -0,0 +1,265 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "OcclusionCuller.h"
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Camera/Camera.h"
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+    OcclusionCuller::SharedPtr OcclusionCuller::create(uint32_t width, uint32_t height)
+    {
+        return SharedPtr(new OcclusionCuller(width, height));
+    }
+
+    OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+    {
+        mpRasterizer = DepthRasterizer::create(width, height);
+    }
+
+    void OcclusionCuller::setOccluder(const Mesh* pMesh, bool isOccluder)
+    {
+        if (isOccluder)
+        {
+            if (pMesh->hasBones())
+            {
+                logWarning("OcclusionCuller::setOccluder() - skinned meshes can't be used as occluders");
+                return;
+            }
+            mOccluders[pMesh] = pMesh->shared_from_this();
+            mOccludersDirty = true;
+        }
+        else
+        {
+            mOccluders.erase(pMesh);
+        }
+    }
+
+    void OcclusionCuller::setOccluderProxy(const Mesh* pMesh, const std::vector<glm::vec3>& triangles)
+    {
+        if (triangles.empty())
+        {
+            mProxies.erase(pMesh);
+        }
+        else
+        {
+            Proxy& proxy = mProxies[pMesh];
+            proxy.pMesh = pMesh->shared_from_this();
+            proxy.triangles.assign(triangles.begin(), triangles.end() - triangles.size() % 3);
+        }
+    }
+
+    // Check if any instance of a mesh is large compared to its distance to the camera
+    static bool isLargeOnScreen(const Scene* pScene, uint32_t modelID, uint32_t meshID, const glm::vec3& cameraPos, float minSizeRatio)
+    {
+        const Model* pModel = pScene->getModel(modelID).get();
+        for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+        {
+            const auto& pModelInstance = pScene->getModelInstance(modelID, instanceID);
+            for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+            {
+                const BoundingBox box = pModel->getMeshInstance(meshID, meshInstanceID)->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                if (2 * glm::length(box.extent) >= minSizeRatio * glm::length(box.center - cameraPos)) return true;
+            }
+        }
+        return false;
+    }
+
+    void OcclusionCuller::selectOccluders(Scene* pScene, const Camera* pCamera, uint32_t maxTriangleCount, float minSizeRatio)
+    {
+        mOccluders.clear();
+        mSelection.valid = (pCamera != nullptr);
+        mSelection.cameraPos = pCamera ? pCamera->getPosition() : glm::vec3();
+        mSelection.maxTriangleCount = maxTriangleCount;
+        mSelection.minSizeRatio = minSizeRatio;
+
+        const float minSize = 2 * pScene->getRadius() * minSizeRatio;
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                if (pMesh->hasBones() || pMesh->getPrimitiveCount() > maxTriangleCount) continue;
+                if (pCamera)
+                {
+                    if (isLargeOnScreen(pScene, modelID, meshID, mSelection.cameraPos, minSizeRatio) == false) continue;
+                }
+                else if (2 * glm::length(pMesh->getBoundingBox().extent) < minSize) continue;
+                setOccluder(pMesh, true);
+            }
+        }
+    }
+
+    bool OcclusionCuller::updateSelection(Scene* pScene, const Camera* pCamera, float moveThreshold)
+    {
+        if (mSelection.valid && glm::length(pCamera->getPosition() - mSelection.cameraPos) <= moveThreshold * pScene->getRadius())
+        {
+            return false;
+        }
+        selectOccluders(pScene, pCamera, mSelection.maxTriangleCount, mSelection.minSizeRatio);
+        return true;
+    }
+
+    void OcclusionCuller::clearOccluders()
+    {
+        mOccluders.clear();
+        mProxies.clear();
+        mOccludersDirty = false;
+        mSelection.valid = false;
+    }
+
+    const std::vector<glm::vec3>* OcclusionCuller::getOccluderTriangles(const Mesh* pMesh) const
+    {
+        auto proxy = mProxies.find(pMesh);
+        if (proxy != mProxies.end()) return &proxy->second.triangles;
+        return (mOccluders.find(pMesh) != mOccluders.end()) ? mpRasterizer->getMeshTriangles(pMesh) : nullptr;
+    }
+
+    void OcclusionCuller::build(const Scene* pScene, const Camera* pCamera)
+    {
+        const auto startTime = CpuTimer::getCurrentTimePoint();
+
+        // Drop the occluders and proxies of destroyed meshes, so a new mesh allocated at the same address isn't mistaken for them
+        for (auto it = mOccluders.begin(); it != mOccluders.end();)
+        {
+            it = it->second.expired() ? mOccluders.erase(it) : std::next(it);
+        }
+        for (auto it = mProxies.begin(); it != mProxies.end();)
+        {
+            it = it->second.pMesh.expired() ? mProxies.erase(it) : std::next(it);
+        }
+
+        // Read the new occluders. Meshes with a proxy don't need their own positions
+        if (mOccludersDirty)
+        {
+            std::vector<Mesh::SharedConstPtr> meshes;
+            for (const auto& occluder : mOccluders)
+            {
+                if (mProxies.find(occluder.first) == mProxies.end()) meshes.push_back(occluder.second.lock());
+            }
+            mpRasterizer->cacheMeshes(meshes);
+            mOccludersDirty = false;
+        }
+        else
+        {
+            mpRasterizer->pruneMeshCache();
+        }
+
+        // Gather the occluder instances inside the frustum
+        mOccluderInstances.clear();
+        mStats = Stats();
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const std::vector<glm::vec3>* pTriangles = getOccluderTriangles(pModel->getMesh(meshID).get());
+                if (pTriangles == nullptr) continue;
+
+                for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+                {
+                    const auto& pModelInstance = pScene->getModelInstance(modelID, instanceID);
+                    if (pModelInstance->isVisible() == false) continue;
+
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const auto& pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID);
+                        if (pMeshInstance->isVisible() == false) continue;
+                        if (pCamera->isObjectCulled(pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix()))) continue;
+
+                        DepthRasterizer::Occluder occluder;
+                        occluder.pVertices = pTriangles->data();
+                        occluder.triangleCount = (uint32_t)pTriangles->size() / 3;
+                        occluder.worldMat = pModelInstance->getTransformMatrix() * pMeshInstance->getTransformMatrix();
+                        mOccluderInstances.push_back(occluder);
+                        mStats.occluderTriangleCount += occluder.triangleCount;
+                    }
+                }
+            }
+        }
+
+        mpRasterizer->begin(pCamera->getViewProjMatrix());
+        mpRasterizer->rasterizeOccluders(mOccluderInstances);
+
+        mStats.occluderCount = (uint32_t)mOccluderInstances.size();
+        mStats.buildTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+    }
+
+    bool OcclusionCuller::isVisible(const BoundingBox& box)
+    {
+        const bool visible = mpRasterizer->isBoxVisible(box);
+        mStats.testedCount++;
+        mStats.culledCount += visible ? 0 : 1;
+        return visible;
+    }
+
+    OcclusionCuller::Stats OcclusionCuller::benchmark(const Scene* pScene, const Camera* pCamera, uint32_t iterations)
+    {
+        // The same boxes SceneRenderer tests after frustum culling
+        std::vector<BoundingBox> boxes;
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const auto& pModelInstance = pScene->getModelInstance(modelID, instanceID);
+                if (pModelInstance->isVisible() == false) continue;
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const auto& pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID);
+                        BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                        if (pMeshInstance->isVisible() && pCamera->isObjectCulled(box) == false) boxes.push_back(box);
+                    }
+                }
+            }
+        }
+
+        float buildTime = 0;
+        float testTime = 0;
+        iterations = std::max(iterations, 1u);
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            build(pScene, pCamera);
+            buildTime += mStats.buildTime;
+
+            const auto startTime = CpuTimer::getCurrentTimePoint();
+            for (const auto& box : boxes) isVisible(box);
+            testTime += CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+        }
+
+        Stats result = mStats;
+        result.buildTime = buildTime / iterations;
+        result.testTime = testTime / iterations;
+        return result;
+    }
+}
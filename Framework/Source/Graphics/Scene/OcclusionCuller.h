@@ -0,0 +1,155 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/DepthRasterizer.h"
+#include "Utils/AABB.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    class Scene;
+    class Camera;
+    class Mesh;
+
+    /** CPU occlusion culling.
+        Selected occluder meshes, or simplified proxies registered for them, are rasterized into a small depth buffer with DepthRasterizer. Bounding boxes can then be tested against it before their instances are drawn.
+        Occluder positions are read the first time build() sees them, from the CPU geometry of meshes loaded with Model::LoadFlags::KeepCpuGeometry and from the GPU otherwise. Occluders and proxies only hold weak references to their meshes, and build() drops the ones whose mesh was destroyed. Skinned meshes are never used as occluders, since the CPU doesn't see their animated positions.
+    */
+    class OcclusionCuller
+    {
+    public:
+        using SharedPtr = std::shared_ptr<OcclusionCuller>;
+        using SharedConstPtr = std::shared_ptr<const OcclusionCuller>;
+
+        /** Statistics, reset by every build() call
+        */
+        struct Stats
+        {
+            float buildTime = 0;                ///< CPU time of the last build, in milliseconds
+            float testTime = 0;                 ///< CPU time spent testing boxes. Only measured by benchmark()
+            uint32_t occluderCount = 0;         ///< Number of occluder instances rasterized by the last build
+            uint32_t occluderTriangleCount = 0;
+            uint32_t testedCount = 0;           ///< Number of boxes tested since the last build
+            uint32_t culledCount = 0;           ///< Number of tested boxes which were hidden
+
+            float getCulledPercentage() const { return testedCount ? 100.0f * culledCount / testedCount : 0.0f; }
+        };
+
+        /** Create a new culler
+            \param[in] width Depth buffer width
+            \param[in] height Depth buffer height
+        */
+        static SharedPtr create(uint32_t width = 256, uint32_t height = 128);
+
+        /** Set the depth buffer resolution
+        */
+        void setResolution(uint32_t width, uint32_t height) { mpRasterizer->resize(width, height); }
+
+        /** Set the number of threads used to rasterize the occluders. 0 uses one thread per hardware thread
+        */
+        void setThreadCount(uint32_t threadCount) { mpRasterizer->setThreadCount(threadCount); }
+
+        /** Add or remove a mesh from the occluder set. Every instance of the mesh will be rasterized
+        */
+        void setOccluder(const Mesh* pMesh, bool isOccluder);
+
+        /** Rasterize a simplified triangle list instead of the mesh itself. The proxy must not extend beyond the mesh's surface, otherwise it will hide objects which are visible
+            \param[in] pMesh The mesh
+            \param[in] triangles Object-space positions, 3 per triangle. An empty list removes the proxy
+        */
+        void setOccluderProxy(const Mesh* pMesh, const std::vector<glm::vec3>& triangles);
+
+        /** Replace the occluders by the scene meshes which are good occluders: static meshes with few triangles and large bounds. Proxies are kept
+            \param[in] pScene The scene
+            \param[in] pCamera The camera to select the occluders for, or nullptr to select them for the whole scene
+            \param[in] maxTriangleCount Meshes with more triangles are skipped
+            \param[in] minSizeRatio Meshes are skipped if the bounding box diagonal of each of their instances is smaller than this fraction of its distance to the camera. Without a camera, the object-space diagonal is compared with the scene diameter instead
+        */
+        void selectOccluders(Scene* pScene, const Camera* pCamera = nullptr, uint32_t maxTriangleCount = 2048, float minSizeRatio = 0.05f);
+
+        /** Select the occluders for a camera with the parameters of the last selectOccluders() call, if the camera moved by more than a fraction of the scene radius since the last selection. Meant to be called every frame
+            \param[in] pScene The scene
+            \param[in] pCamera The camera
+            \param[in] moveThreshold Distance the camera has to move before the occluders are selected again, as a fraction of the scene radius
+            \return true if the occluders were selected again, otherwise false
+        */
+        bool updateSelection(Scene* pScene, const Camera* pCamera, float moveThreshold = 0.1f);
+
+        /** Remove all the occluders and proxies
+        */
+        void clearOccluders();
+
+        /** Rasterize the occluder instances which are inside a camera's frustum
+        */
+        void build(const Scene* pScene, const Camera* pCamera);
+
+        /** Check if a world-space box may be visible from the camera of the last build
+        */
+        bool isVisible(const BoundingBox& box);
+
+        /** Build the occluders and test every frustum-visible mesh instance of the scene, and measure the average time
+            \param[in] pScene The scene
+            \param[in] pCamera The camera
+            \param[in] iterations Number of runs to average
+            \return The statistics of the last run, with buildTime and testTime set to the averages
+        */
+        Stats benchmark(const Scene* pScene, const Camera* pCamera, uint32_t iterations);
+
+        const Stats& getStats() const { return mStats; }
+        DepthRasterizer* getRasterizer() const { return mpRasterizer.get(); }
+
+    private:
+        OcclusionCuller(uint32_t width, uint32_t height);
+
+        /** Get the triangles to rasterize for a mesh, or nullptr if it isn't an occluder
+        */
+        const std::vector<glm::vec3>* getOccluderTriangles(const Mesh* pMesh) const;
+
+        DepthRasterizer::SharedPtr mpRasterizer;
+        // Keyed by address for the lookups. The weak references detect a new mesh allocated at the address of a destroyed one
+        struct Proxy
+        {
+            std::weak_ptr<const Mesh> pMesh;
+            std::vector<glm::vec3> triangles;
+        };
+        std::unordered_map<const Mesh*, std::weak_ptr<const Mesh>> mOccluders;
+        std::unordered_map<const Mesh*, Proxy> mProxies;
+        bool mOccludersDirty = false;   ///< Occluders were added which are not cached by the rasterizer yet
+
+        // Parameters of the last selectOccluders() call, reused by updateSelection()
+        struct
+        {
+            bool valid = false;
+            glm::vec3 cameraPos;
+            uint32_t maxTriangleCount = 2048;
+            float minSizeRatio = 0.05f;
+        } mSelection;
+        std::vector<DepthRasterizer::Occluder> mOccluderInstances;
+        Stats mStats;
+    };
+}
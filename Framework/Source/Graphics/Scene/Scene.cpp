@@ -28,13 +28,47 @@
 #include "Framework.h"
 #include "Scene.h"
 #include "SceneImporter.h"
+#include "SceneExporter.h"
+#include "SceneSnapshot.h"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 namespace Falcor
 {
     uint32_t Scene::sSceneCounter = 0;
 
+    // Updating fewer instances than this is faster than spawning threads
+    static const size_t kParallelExtentsThreshold = 4096;
+
+    // Call func(i) for every i in [0, count). Threads grab the items one at a time, so each item is only touched by a single thread
+    template<typename Func>
+    static void forEachParallel(uint32_t count, bool parallel, const Func& func)
+    {
+        const uint32_t threadCount = std::min(std::thread::hardware_concurrency(), count);
+        if (parallel == false || threadCount <= 1)
+        {
+            for (uint32_t i = 0; i < count; i++) func(i);
+            return;
+        }
+
+        std::atomic<uint32_t> next(0);
+        auto worker = [&]()
+        {
+            for (uint32_t i = next++; i < count; i = next++) func(i);
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& t : threads) t.join();
+    }
+
     const Scene::UserVariable Scene::kInvalidVar;
 
     const char* Scene::kFileFormatString = "Scene files\0*.fscene\0\0";
@@ -42,9 +76,37 @@ namespace Falcor
     Scene::SharedPtr Scene::loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
     {
         Scene::SharedPtr pScene = create();
+
+        // Use the snapshot if it's still up-to-date
+        std::string fullpath;
+        if (is_set(sceneLoadFlags, LoadFlags::IgnoreSnapshot) == false && findFileInDataDirectories(filename, fullpath))
+        {
+            if (SceneSnapshot::load(*pScene, SceneSnapshot::getSnapshotFilename(fullpath), modelLoadFlags))
+            {
+                if (is_set(sceneLoadFlags, LoadFlags::GenerateAreaLights))
+                {
+                    pScene->createAreaLights();
+                }
+
+                if (is_set(sceneLoadFlags, LoadFlags::StoreMaterialHistory) == false)
+                {
+                    pScene->deleteMaterialHistory();
+                }
+                return pScene;
+            }
+
+            // The snapshot might have partially initialized the scene
+            pScene = create();
+        }
+
         if (SceneImporter::loadScene(*pScene, filename, modelLoadFlags, sceneLoadFlags) == false)
         {
-            pScene = false;
+            return nullptr;
+        }
+
+        if (is_set(sceneLoadFlags, LoadFlags::CreateSnapshot) && findFileInDataDirectories(filename, fullpath))
+        {
+            SceneExporter::saveSnapshot(SceneSnapshot::getSnapshotFilename(fullpath), pScene, modelLoadFlags);
         }
         return pScene;
     }
@@ -66,55 +128,162 @@ namespace Falcor
 
     Scene::~Scene() = default;
 
+    void Scene::rebuildInstanceBounds()
+    {
+        mInstanceBounds.clear();
+        mInstanceIndices.clear();
+        mMovedInstances.clear();
+        for (uint32_t i = 0; i < getModelCount(); ++i)
+        {
+            for (uint32_t j = 0; j < getModelInstanceCount(i); ++j)
+            {
+                InstanceBounds bounds;
+                bounds.pInstance = getModelInstance(i, j).get();
+                mInstanceIndices[bounds.pInstance] = (uint32_t)mInstanceBounds.size();
+                mInstanceBounds.push_back(bounds);
+            }
+        }
+
+        mBlockBounds.resize((mInstanceBounds.size() + kExtentsBlockSize - 1) / kExtentsBlockSize);
+        forEachParallel((uint32_t)mBlockBounds.size(), mInstanceBounds.size() >= kParallelExtentsThreshold, [this](uint32_t blockID)
+        {
+            const size_t first = (size_t)blockID * kExtentsBlockSize;
+            const size_t last = std::min(first + kExtentsBlockSize, mInstanceBounds.size());
+            for (size_t i = first; i < last; i++)
+            {
+                updateInstanceBounds(mInstanceBounds[i], true);
+            }
+            updateBlockBounds(blockID);
+        });
+    }
+
+    bool Scene::updateInstanceBounds(InstanceBounds& bounds, bool force)
+    {
+        const uint32_t version = bounds.pInstance->getTransformVersion();
+        if (force == false && version == bounds.transformVersion)
+        {
+            return false;
+        }
+
+        const BoundingBox& box = bounds.pInstance->getBoundingBox();
+        bounds.min = box.getMinPos();
+        bounds.max = box.getMaxPos();
+        bounds.transformVersion = version;
+        return true;
+    }
+
+    void Scene::updateBlockBounds(uint32_t blockID)
+    {
+        const size_t first = (size_t)blockID * kExtentsBlockSize;
+        const size_t last = std::min(first + kExtentsBlockSize, mInstanceBounds.size());
+
+        BlockBounds& block = mBlockBounds[blockID];
+        block.min = mInstanceBounds[first].min;
+        block.max = mInstanceBounds[first].max;
+        for (size_t i = first + 1; i < last; i++)
+        {
+            block.min = min(block.min, mInstanceBounds[i].min);
+            block.max = max(block.max, mInstanceBounds[i].max);
+        }
+    }
+
+    void Scene::markInstanceMoved(const IMovableObject* pInstance)
+    {
+        // A pending rebuild refreshes every instance anyway
+        if (mExtentsDirty) return;
+
+        auto it = mInstanceIndices.find(pInstance);
+        if (it != mInstanceIndices.end())
+        {
+            mMovedInstances.push_back(it->second);
+        }
+    }
+
     void Scene::updateExtents()
     {
-        if (mExtentsDirty)
+        const bool rebuild = mExtentsDirty;
+        mExtentsDirty = false;
+        if (rebuild)
+        {
+            rebuildInstanceBounds();
+        }
+        else
         {
-            mExtentsDirty = false;
+            if (mMovedInstances.empty())
+            {
+                return;
+            }
 
-            mRadius = 0.f;
-            float k = 0.f;
-            mCenter = vec3(0, 0, 0);
-            for (uint32_t i = 0; i < getModelCount(); ++i)
+            // Only the moved instances and the blocks containing them are refreshed. An instance may be listed more than once
+            std::sort(mMovedInstances.begin(), mMovedInstances.end());
+            mMovedInstances.erase(std::unique(mMovedInstances.begin(), mMovedInstances.end()), mMovedInstances.end());
+
+            // Group the moved instances by block, so that every block is refreshed by a single thread
+            std::vector<uint32_t> groupStart;
+            for (uint32_t i = 0; i < (uint32_t)mMovedInstances.size(); i++)
             {
-                const auto& model = getModel(i);
-                const float r = model->getRadius();
-                const vec3 c = model->getCenter();
-                for (uint32_t j = 0; j < getModelInstanceCount(i); ++j)
+                if (i == 0 || mMovedInstances[i] / kExtentsBlockSize != mMovedInstances[i - 1] / kExtentsBlockSize)
                 {
-                    const auto& inst = getModelInstance(i, j);
-                    const vec3 instC = vec3(vec4(c, 1.f) * inst->getTransformMatrix());
-                    const vec3 scaling = inst->getScaling();
-                    const float instR = r * max(scaling.x, max(scaling.y, scaling.z));
-
-                    if (k == 0.f)
-                    {
-                        mCenter = instC;
-                        mRadius = instR;
-                    }
-                    else
-                    {
-                        vec3 dir = instC - mCenter;
-                        if (length(dir) > 1e-6f)
-                            dir = normalize(dir);
-                        vec3 a = mCenter - dir * mRadius;
-                        vec3 b = instC + dir * instR;
-
-                        mCenter = (a + b) * 0.5f;
-                        mRadius = length(a - b);
-                    }
-                    k++;
+                    groupStart.push_back(i);
                 }
             }
+            groupStart.push_back((uint32_t)mMovedInstances.size());
 
-            // Update light extents
-            for (auto& light : mpLights)
+            const uint32_t groupCount = (uint32_t)groupStart.size() - 1;
+            std::vector<uint8_t> groupChanged(groupCount, 0);
+            forEachParallel(groupCount, mMovedInstances.size() >= kParallelExtentsThreshold, [&](uint32_t g)
             {
-                if (light->getType() == LightDirectional)
+                // The transform version filters the instances which were marked but didn't move
+                for (uint32_t i = groupStart[g]; i < groupStart[g + 1]; i++)
                 {
-                    auto pDirLight = std::dynamic_pointer_cast<DirectionalLight>(light);
-                    pDirLight->setWorldParams(getCenter(), getRadius());
+                    if (updateInstanceBounds(mInstanceBounds[mMovedInstances[i]], false)) groupChanged[g] = 1;
                 }
+                if (groupChanged[g]) updateBlockBounds(mMovedInstances[groupStart[g]] / kExtentsBlockSize);
+            });
+            mMovedInstances.clear();
+            if (std::find(groupChanged.begin(), groupChanged.end(), 1) == groupChanged.end())
+            {
+                return;
+            }
+        }
+
+        // Reduce the blocks
+        const uint32_t blockCount = (uint32_t)mBlockBounds.size();
+        BoundingBox box;
+        if (blockCount)
+        {
+            vec3 boxMin = mBlockBounds[0].min;
+            vec3 boxMax = mBlockBounds[0].max;
+            for (uint32_t b = 1; b < blockCount; b++)
+            {
+                boxMin = min(boxMin, mBlockBounds[b].min);
+                boxMax = max(boxMax, mBlockBounds[b].max);
+            }
+            box = BoundingBox::fromMinMax(boxMin, boxMax);
+        }
+        else
+        {
+            box.center = vec3(0, 0, 0);
+            box.extent = vec3(0, 0, 0);
+        }
+
+        if (rebuild == false && box == mBoundingBox)
+        {
+            return;
+        }
+
+        // The sphere encloses the box
+        mBoundingBox = box;
+        mCenter = box.center;
+        mRadius = length(box.extent);
+
+        // Update light extents
+        for (auto& light : mpLights)
+        {
+            if (light->getType() == LightDirectional)
+            {
+                auto pDirLight = std::dynamic_pointer_cast<DirectionalLight>(light);
+                pDirLight->setWorldParams(mCenter, mRadius);
             }
         }
     }
@@ -127,10 +296,15 @@ namespace Falcor
             if (path->animate(currentTime))
             {
                 changed = true;
+                for (uint32_t i = 0; i < path->getAttachedObjectCount(); i++)
+                {
+                    markInstanceMoved(path->getAttachedObject(i).get());
+                }
             }
         }
 
-        mExtentsDirty = mExtentsDirty || changed;
+        // The extents are only refreshed here, once per frame, so the getters never have to look for moved instances
+        updateExtents();
 
         // Ignore the elapsed time we got from the user. This will allow camera movement in cases where the time is frozen
         if (cameraController)
@@ -183,6 +357,7 @@ namespace Falcor
             if (getModel(modelID) == pInstance->getObject())
             {
                 mModels[modelID].push_back(pInstance);
+                mExtentsDirty = true;
                 return;
             }
         }
@@ -315,6 +490,7 @@ namespace Falcor
         merge(mpPaths);
         merge(mpMaterials);
         merge(mCameras);
+        merge(mSourceFiles);
 #undef merge
         mUserVars.insert(pFrom->mUserVars.begin(), pFrom->mUserVars.end());
         mExtentsDirty = true;
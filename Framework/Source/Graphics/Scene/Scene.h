@@ -29,6 +29,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include "Graphics/Model/Model.h"
 #include "Graphics/Light.h"
 #include "Graphics/Material/Material.h"
@@ -99,7 +100,9 @@ namespace Falcor
         {
 			None                =   0x0,
 			GenerateAreaLights  =   0x1,    ///< Create area light(s) for meshes that have emissive material
-            StoreMaterialHistory =  0x2     ///< Store history of overridden mesh materials
+            StoreMaterialHistory =  0x2,    ///< Store history of overridden mesh materials
+            CreateSnapshot      =   0x4,    ///< After parsing the scene file, write a binary snapshot of the scene next to it. Following loads will use the snapshot as long as the source files don't change
+            IgnoreSnapshot      =   0x8,    ///< Always parse the scene file, even if a valid snapshot exists
         };
 
         static Scene::SharedPtr loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None, Scene::LoadFlags sceneLoadFlags = LoadFlags::None);
@@ -140,7 +143,7 @@ namespace Falcor
         uint32_t getMaterialCount() const { return (uint32_t)mpMaterials.size(); }
         const Material::SharedPtr& getMaterial(uint32_t index) const { return mpMaterials[index]; }
 
-        const MaterialHistory::SharedPtr& getMaterialHistory() { return mpMaterialHistory; }
+        const MaterialHistory::SharedPtr& getMaterialHistory() const { return mpMaterialHistory; }
         void deleteMaterialHistory();
 
         // Object paths
@@ -178,15 +181,32 @@ namespace Falcor
 
         const uint32_t getId() const { return mId; }
 
+        /** Add a file the scene was created from (scene file, included scene files, model files). The list is used to validate scene snapshots
+        */
+        void addSourceFile(const std::string& fullpath) { mSourceFiles.push_back(fullpath); }
+
+        /** Get the list of files the scene was created from
+        */
+        const std::vector<std::string>& getSourceFiles() const { return mSourceFiles; }
+
         static const uint32_t kNoPath = (uint32_t)-1;
 
         void merge(const Scene* pFrom);
 
         /**
-            Return scene extents
+            Return scene extents. Moved instances are accounted for by update(), the getters only rebuild the extents after models or instances were added or removed
         */
-        const vec3& getCenter() { updateExtents(); return mCenter; }
-        const float getRadius() { updateExtents(); return mRadius; }
+        const vec3& getCenter() { if (mExtentsDirty) updateExtents(); return mCenter; }
+        const float getRadius() { if (mExtentsDirty) updateExtents(); return mRadius; }
+
+        /** Get the world-space bounding box of all the model instances
+        */
+        const BoundingBox& getBoundingBox() { if (mExtentsDirty) updateExtents(); return mBoundingBox; }
+
+        /** Notify the scene that a model instance was moved. Instances animated by the scene's paths are tracked automatically, call this after changing an instance transform directly.
+            The extents are updated on the next call to update()
+        */
+        void markInstanceMoved(const IMovableObject* pInstance);
 
         /**
             This routine creates area light(s) in the scene. All meshes that
@@ -210,9 +230,34 @@ namespace Falcor
 
         Scene();
         /**
-            Update changed scene extents (radius and center).
+            Update changed scene extents (bounding box, radius and center).
+            Only the bounds of the instances passed to markInstanceMoved() since the last call are recomputed. Large updates are split by block over worker threads.
         */
         void updateExtents();
+
+        /** World-space bounds of a model instance, cached by updateExtents()
+        */
+        struct InstanceBounds
+        {
+            const ModelInstance* pInstance = nullptr;
+            uint32_t transformVersion = 0;
+            vec3 min;
+            vec3 max;
+        };
+
+        /** Union of the bounds of kExtentsBlockSize consecutive instances
+        */
+        struct BlockBounds
+        {
+            vec3 min;
+            vec3 max;
+        };
+
+        static const uint32_t kExtentsBlockSize = 256;
+
+        void rebuildInstanceBounds();
+        bool updateInstanceBounds(InstanceBounds& bounds, bool force);
+        void updateBlockBounds(uint32_t blockID);
         
         static uint32_t sSceneCounter;
 
@@ -225,6 +270,7 @@ namespace Falcor
         std::vector<ObjectPath::SharedPtr> mpPaths;
 
         MaterialHistory::SharedPtr mpMaterialHistory;
+        std::vector<std::string> mSourceFiles;
 
         vec3 mAmbientIntensity;
         uint32_t mActiveCameraID = 0;
@@ -234,8 +280,13 @@ namespace Falcor
 
         float mRadius = -1.f;
         vec3 mCenter = vec3(0, 0, 0);
+        BoundingBox mBoundingBox;
 
-        bool mExtentsDirty = true;
+        std::vector<InstanceBounds> mInstanceBounds;
+        std::vector<BlockBounds> mBlockBounds;
+        std::unordered_map<const IMovableObject*, uint32_t> mInstanceIndices;    ///< Index of each instance in mInstanceBounds
+        std::vector<uint32_t> mMovedInstances;  ///< Instances moved since the last updateExtents() call
+        bool mExtentsDirty = true;     ///< Set when models or instances are added or removed
 
         using string_uservar_map = std::map<const std::string, UserVariable>;
         string_uservar_map mUserVars;
@@ -31,6 +31,7 @@
 #include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
 #include "Externals/RapidJson/include/rapidjson/prettywriter.h"
 #include "SceneExportImportCommon.h"
+#include "SceneSnapshot.h"
 #include "glm/detail/func_trigonometric.hpp"
 #include "Utils/OS.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
@@ -43,6 +44,11 @@ namespace Falcor
         return exporter.save(exportOptions);
     }
 
+    bool SceneExporter::saveSnapshot(const std::string& filename, const Scene::SharedPtr& pScene, Model::LoadFlags modelLoadFlags)
+    {
+        return SceneSnapshot::save(filename, pScene.get(), modelLoadFlags);
+    }
+
     template<typename T>
     void addLiteral(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const std::string& key, const T& value)
     {
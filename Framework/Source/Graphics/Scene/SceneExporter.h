@@ -56,6 +56,13 @@ namespace Falcor
 
         static bool saveScene(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions = ExportAll);
 
+        /** Save a binary snapshot of a fully-processed scene. Snapshots load much faster than scene files, since they don't require parsing the scene file or importing the models.
+            \param[in] filename The snapshot filename. Scene::loadFromFile() looks for the snapshot using SceneSnapshot::getSnapshotFilename().
+            \param[in] pScene The scene to save
+            \param[in] modelLoadFlags The flags the scene's models were loaded with
+        */
+        static bool saveSnapshot(const std::string& filename, const Scene::SharedPtr& pScene, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None);
+
         static const uint32_t kVersion = 2;
 
     private:
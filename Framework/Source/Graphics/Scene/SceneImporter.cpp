@@ -197,6 +197,12 @@ namespace Falcor
             return false;
         }
 
+        std::string modelFullpath;
+        if (findFileInDataDirectories(file, modelFullpath))
+        {
+            mScene.addSourceFile(modelFullpath);
+        }
+
         pModel->setFilename(modelFile.GetString());
 
         bool instanceAdded = false;
@@ -1166,15 +1172,17 @@ namespace Falcor
         if(findFileInDataDirectories(filename, fullpath))
         {
             // Load the file
-            std::ifstream fileStream(fullpath);
-            std::stringstream strStream;
-            strStream << fileStream.rdbuf();
-            std::string jsonData = strStream.str();
+            std::string jsonData;
+            if (readFileToString(fullpath, jsonData) == false)
+            {
+                return error("Can't read file.");
+            }
             rapidjson::StringStream JStream(jsonData.c_str());
 
             // Get the file directory
             auto last = fullpath.find_last_of("/\\");
             mDirectory = fullpath.substr(0, last);
+            mScene.addSourceFile(fullpath);
 
             // create the DOM
             mJDoc.ParseStream(JStream);
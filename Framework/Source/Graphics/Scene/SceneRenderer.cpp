@@ -40,17 +40,6 @@
 
 namespace Falcor
 {
-    size_t SceneRenderer::sBonesOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sCameraDataOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sWorldMatArraySize = 0;
-    size_t SceneRenderer::sWorldMatOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sWorldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sDrawIDOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sLightCountOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sAmbientLightOffset = ConstantBuffer::kInvalidOffset;
-
     const char* SceneRenderer::kPerMaterialCbName = "InternalPerMaterialCB";
     const char* SceneRenderer::kPerFrameCbName = "InternalPerFrameCB";
     const char* SceneRenderer::kPerMeshCbName = "InternalPerMeshCB";
@@ -65,72 +54,114 @@ namespace Falcor
         setCameraControllerType(CameraControllerType::SixDof);
     }
 
-    void SceneRenderer::updateVariableOffsets(const ProgramReflection* pReflector)
+    SceneRenderer::ProgramBindings::ProgramBindings(const ProgramReflection* pReflector)
     {
-        if (sWorldMatOffset == ConstantBuffer::kInvalidOffset)
-        {
-            const auto pPerMeshCbData = pReflector->getBufferDesc(kPerMeshCbName, ProgramReflection::BufferReflection::Type::Constant);
+        perFrameCb = ProgramVars::getConstantBufferHandle(pReflector, kPerFrameCbName);
+        perMeshCb = ProgramVars::getConstantBufferHandle(pReflector, kPerMeshCbName);
+        perMaterialCb = ProgramVars::getConstantBufferHandle(pReflector, kPerMaterialCbName);
 
-            if (pPerMeshCbData != nullptr)
-            {
-                assert(pPerMeshCbData->getVariableData("gWorldMat[0]")->isRowMajor == false); // We copy into CBs as column-major
-                assert(pPerMeshCbData->getVariableData("gWorldInvTransposeMat[0]")->isRowMajor == false);
-                assert(pPerMeshCbData->getVariableData("gWorldMat")->arraySize == pPerMeshCbData->getVariableData("gWorldInvTransposeMat")->arraySize);
-
-                sWorldMatArraySize = pPerMeshCbData->getVariableData("gWorldMat")->arraySize;
-                sWorldMatOffset = pPerMeshCbData->getVariableData("gWorldMat[0]")->location;
-                sWorldInvTransposeMatOffset = pPerMeshCbData->getVariableData("gWorldInvTransposeMat[0]")->location;
-                sMeshIdOffset = pPerMeshCbData->getVariableData("gMeshId")->location;
-                sDrawIDOffset = pPerMeshCbData->getVariableData("gDrawId[0]")->location;
-            }
+        const auto pPerMeshCbData = pReflector->getBufferDesc(kPerMeshCbName, ProgramReflection::BufferReflection::Type::Constant);
+        if (pPerMeshCbData != nullptr)
+        {
+            assert(pPerMeshCbData->getVariableData("gWorldMat[0]")->isRowMajor == false); // We copy into CBs as column-major
+            assert(pPerMeshCbData->getVariableData("gWorldInvTransposeMat[0]")->isRowMajor == false);
+            assert(pPerMeshCbData->getVariableData("gWorldMat")->arraySize == pPerMeshCbData->getVariableData("gWorldInvTransposeMat")->arraySize);
+
+            worldMatArraySize = pPerMeshCbData->getVariableData("gWorldMat")->arraySize;
+            worldMatOffset = pPerMeshCbData->getVariableData("gWorldMat[0]")->location;
+            worldInvTransposeMatOffset = pPerMeshCbData->getVariableData("gWorldInvTransposeMat[0]")->location;
+            meshIdOffset = pPerMeshCbData->getVariableData("gMeshId")->location;
+            drawIdOffset = pPerMeshCbData->getVariableData("gDrawId[0]")->location;
+            const auto& pVisibleOffset = pPerMeshCbData->getVariableData("gVisibleInstanceOffset");
+            visibleInstanceOffset = pVisibleOffset ? pVisibleOffset->location : ConstantBuffer::kInvalidOffset;
         }
 
-        if (sCameraDataOffset == ConstantBuffer::kInvalidOffset)
+        const auto pPerFrameCbData = pReflector->getBufferDesc(kPerFrameCbName, ProgramReflection::BufferReflection::Type::Constant);
+        if (pPerFrameCbData != nullptr)
         {
-            const auto pPerFrameCbData = pReflector->getBufferDesc(kPerFrameCbName, ProgramReflection::BufferReflection::Type::Constant);
+            const auto& pCameraOffset = pPerFrameCbData->getVariableData("gCam.viewMat");
+            cameraDataOffset = pCameraOffset ? pCameraOffset->location : ConstantBuffer::kInvalidOffset;
+            const auto& pCountOffset = pPerFrameCbData->getVariableData("gLightsCount");
+            lightCountOffset = pCountOffset ? pCountOffset->location : ConstantBuffer::kInvalidOffset;
+            const auto& pLightOffset = pPerFrameCbData->getVariableData("gLights[0].worldPos");
+            lightArrayOffset = pLightOffset ? pLightOffset->location : ConstantBuffer::kInvalidOffset;
+            const auto& pLightArray = pPerFrameCbData->getVariableData("gLights");
+            lightArraySize = pLightArray ? pLightArray->arraySize : 0;
+            const auto& pClustersOffset = pPerFrameCbData->getVariableData("gLightClusters.gridSizeX");
+            lightClustersOffset = pClustersOffset ? pClustersOffset->location : ConstantBuffer::kInvalidOffset;
+            const auto& pAmbientOffset = pPerFrameCbData->getVariableData("gAmbientLighting");
+            ambientLightOffset = pAmbientOffset ? pAmbientOffset->location : ConstantBuffer::kInvalidOffset;
+        }
 
-            if (pPerFrameCbData != nullptr)
+        const auto pPerMaterialCbData = pReflector->getBufferDesc(kPerMaterialCbName, ProgramReflection::BufferReflection::Type::Constant);
+        if (pPerMaterialCbData != nullptr)
+        {
+            const auto& pIndexOffset = pPerMaterialCbData->getVariableData("gMaterialIndex");
+            if (pIndexOffset)
+            {
+                materialIndexOffset = pIndexOffset->location;
+            }
+            else
             {
-                sCameraDataOffset = pPerFrameCbData->getVariableData("gCam.viewMat")->location;
-                const auto& pCountOffset = pPerFrameCbData->getVariableData("gLightsCount");
-                sLightCountOffset = pCountOffset ? pCountOffset->location : ConstantBuffer::kInvalidOffset;
-                const auto& pLightOffset = pPerFrameCbData->getVariableData("gLights[0].worldPos");
-                sLightArrayOffset = pLightOffset ? pLightOffset->location : ConstantBuffer::kInvalidOffset;
-                const auto& pAmbientOffset = pPerFrameCbData->getVariableData("gAmbientLighting");
-                sAmbientLightOffset = pAmbientOffset ? pAmbientOffset->location : ConstantBuffer::kInvalidOffset;
+                material = Material::resolveBindings(pReflector, kPerMaterialCbName, "gMaterial");
             }
         }
     }
 
     void SceneRenderer::setPerFrameData(const CurrentWorkingData& currentData)
     {
-        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerFrameCbName).get();
+        const ProgramBindings& bindings = *currentData.pBindings;
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(bindings.perFrameCb).get();
         if (pCB)
         {
             // Set camera
-            if (currentData.pCamera)
+            if (currentData.pCamera && bindings.cameraDataOffset != ConstantBuffer::kInvalidOffset)
             {
-                currentData.pCamera->setIntoConstantBuffer(pCB, sCameraDataOffset);
+                currentData.pCamera->setIntoConstantBuffer(pCB, bindings.cameraDataOffset);
             }
 
             // Set lights
-            if (sLightArrayOffset != ConstantBuffer::kInvalidOffset)
+            uint32_t lightCount = mpScene->getLightCount();
+            if (mpLightClusters)
+            {
+                if (currentData.pCamera)
+                {
+                    mpLightClusters->build(mpScene.get(), currentData.pCamera);
+                    mpLightClusters->setIntoProgramVars(currentData.pVars, pCB, bindings.lightClustersOffset);
+                }
+            }
+            else if (bindings.lightArrayOffset != ConstantBuffer::kInvalidOffset)
             {
-                assert(mpScene->getLightCount() < 16);  // Max array size in the shader
-                for (uint_t i = 0; i < mpScene->getLightCount(); i++)
+                if (lightCount > bindings.lightArraySize)
+                {
+                    if (mLightOverflowReported == false)
+                    {
+                        logWarning("SceneRenderer::setPerFrameData() - the scene has " + std::to_string(lightCount) + " lights, but the shader only supports " + std::to_string(bindings.lightArraySize) + ". Enable light clusters or increase MAX_LIGHT_SOURCES.");
+                        mLightOverflowReported = true;
+                    }
+                    lightCount = (uint32_t)bindings.lightArraySize;
+                }
+                for (uint_t i = 0; i < lightCount; i++)
                 {
-                    mpScene->getLight(i)->setIntoConstantBuffer(pCB, i * Light::getShaderStructSize() + sLightArrayOffset);
+                    mpScene->getLight(i)->setIntoConstantBuffer(pCB, i * Light::getShaderStructSize() + bindings.lightArrayOffset);
                 }
             }
-            if (sLightCountOffset != ConstantBuffer::kInvalidOffset)
+            if (bindings.lightCountOffset != ConstantBuffer::kInvalidOffset)
             {
-                pCB->setVariable(sLightCountOffset, mpScene->getLightCount());
+                pCB->setVariable(bindings.lightCountOffset, lightCount);
             }
-            if (sAmbientLightOffset != ConstantBuffer::kInvalidOffset)
+            if (bindings.ambientLightOffset != ConstantBuffer::kInvalidOffset)
             {
-                pCB->setVariable(sAmbientLightOffset, mpScene->getAmbientIntensity());
+                pCB->setVariable(bindings.ambientLightOffset, mpScene->getAmbientIntensity());
             }
         }
+
+        // Bind the material table once, the draws only set the material index
+        if (mpMaterialTable)
+        {
+            mpMaterialTable->update(mpScene.get());
+            mpMaterialTable->setIntoProgramVars(currentData.pVars);
+        }
     }
 
     bool SceneRenderer::setPerModelData(const CurrentWorkingData& currentData)
@@ -138,15 +169,11 @@ namespace Falcor
         // Set bones
         if (currentData.pModel->hasBones())
         {
-            ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+            const ProgramBindings& bindings = *currentData.pBindings;
+            ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(bindings.perMeshCb).get();
             if (pCB)
             {
-                if (sBonesOffset == ConstantBuffer::kInvalidOffset)
-                {
-                    sBonesOffset = pCB->getVariableOffset("gWorldMat[0]");
-                }
-
-                pCB->setVariableArray(sBonesOffset, currentData.pModel->getBonesMatrices(), currentData.pModel->getBonesCount());
+                pCB->setVariableArray(bindings.worldMatOffset, currentData.pModel->getBonesMatrices(), currentData.pModel->getBonesCount());
             }
         }
         return true;
@@ -164,7 +191,8 @@ namespace Falcor
 
     bool SceneRenderer::setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID)
     {
-        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+        const ProgramBindings& bindings = *currentData.pBindings;
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(bindings.perMeshCb).get();
         if (pCB)
         {
             const Mesh* pMesh = pMeshInstance->getObject().get();
@@ -175,13 +203,13 @@ namespace Falcor
                 glm::mat4 worldMat = pModelInstance->getTransformMatrix() * pMeshInstance->getTransformMatrix();
                 glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
 
-                assert(drawInstanceID < sWorldMatArraySize);
-                pCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
-                pCB->setBlob(&worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
+                assert(drawInstanceID < bindings.worldMatArraySize);
+                pCB->setBlob(&worldMat, bindings.worldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
+                pCB->setBlob(&worldInvTransposeMat, bindings.worldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
             }
 
             // Set mesh id
-            pCB->setVariable(sMeshIdOffset, pMesh->getId());
+            pCB->setVariable(bindings.meshIdOffset, pMesh->getId());
         }
 
         return true;
@@ -189,15 +217,81 @@ namespace Falcor
 
     bool SceneRenderer::setPerMaterialData(const CurrentWorkingData& currentData, const Material* pMaterial)
     {
-        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMaterialCbName).get();
+        const ProgramBindings& bindings = *currentData.pBindings;
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(bindings.perMaterialCb).get();
         if (pCB)
         {
-            pMaterial->setIntoProgramVars(currentData.pVars, pCB, "gMaterial");
+            if (mpMaterialTable)
+            {
+                uint32_t materialIndex = mpMaterialTable->getMaterialIndex(pMaterial);
+                if (materialIndex == MaterialTable::kInvalidIndex || bindings.materialIndexOffset == ConstantBuffer::kInvalidOffset)
+                {
+                    if (bindings.materialTableWarned == false)
+                    {
+                        logWarning("SceneRenderer::setPerMaterialData() - material is not in the material table, or the program wasn't compiled with _MS_MATERIAL_TABLE. Skipping the draws of the affected materials");
+                        bindings.materialTableWarned = true;
+                    }
+                    return false;
+                }
+                pCB->setVariable(bindings.materialIndexOffset, materialIndex);
+            }
+            else if (bindings.material.isValid())
+            {
+                pMaterial->setIntoProgramVars(currentData.pVars, pCB, bindings.material);
+            }
         }
 
         return true;
     }
 
+    void SceneRenderer::toggleMaterialTable(bool on)
+    {
+        if (on == false)
+        {
+            mpMaterialTable = nullptr;
+        }
+        else if (mpMaterialTable == nullptr)
+        {
+            mpMaterialTable = MaterialTable::create();
+        }
+    }
+
+    void SceneRenderer::toggleLightClusters(bool on)
+    {
+        if (on == false)
+        {
+            mpLightClusters = nullptr;
+        }
+        else if (mpLightClusters == nullptr)
+        {
+            mpLightClusters = LightClusters::create();
+        }
+    }
+
+    void SceneRenderer::toggleOcclusionCulling(bool on)
+    {
+        if (on == false)
+        {
+            mpOcclusionCuller = nullptr;
+        }
+        else if (mpOcclusionCuller == nullptr)
+        {
+            mpOcclusionCuller = OcclusionCuller::create();
+        }
+    }
+
+    void SceneRenderer::toggleInstanceBuffers(bool on)
+    {
+        if (on == false)
+        {
+            mpInstanceBuffers = nullptr;
+        }
+        else if (mpInstanceBuffers == nullptr)
+        {
+            mpInstanceBuffers = InstanceBuffers::create();
+        }
+    }
+
     void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount)
     {
         // Draw
@@ -242,6 +336,22 @@ namespace Falcor
             // Bind VAO and set topology
             currentData.pState->setVao(pMesh->getVao());
 
+            // The visible instances were collected by buildVisibleInstances(), draw them all at once. Programs compiled without _MS_INSTANCE_BUFFERS use the per-instance constant buffer path below
+            const uint32_t slot = useInstanceBuffers(currentData) ? mpInstanceBuffers->getSlot(pModelInstance, meshID) : InstanceBuffers::kInvalidIndex;
+            if (slot != InstanceBuffers::kInvalidIndex)
+            {
+                const glm::uvec2& range = mpInstanceBuffers->getVisibleRange(slot);
+                const ProgramBindings& bindings = *currentData.pBindings;
+                ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(bindings.perMeshCb).get();
+                if (range.y == 0 || pCB == nullptr) return;
+
+                pCB->setVariable(bindings.visibleInstanceOffset, range.x);
+                pCB->setVariable(bindings.meshIdOffset, pMesh->getId());
+                currentData.drawID += range.y;
+                draw(currentData, pMesh, range.y);
+                return;
+            }
+
             uint32_t activeInstances = 0;
 
             const uint32_t instanceCount = pModel->getMeshInstanceCount(meshID);
@@ -250,7 +360,7 @@ namespace Falcor
                 const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, instanceID).get();
                 BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
 
-                if ((mCullEnabled == false) || (currentData.pCamera->isObjectCulled(box) == false))
+                if ((mCullEnabled == false) || (currentData.pCamera->isObjectCulled(box) == false && (mpOcclusionCuller == nullptr || mpOcclusionCuller->isVisible(box))))
                 {
                     if (pMeshInstance->isVisible())
                     {
@@ -277,6 +387,44 @@ namespace Falcor
         }
     }
 
+    void SceneRenderer::buildVisibleInstances(CurrentWorkingData& currentData)
+    {
+        // The visible list is uploaded before the first draw, so it has to be complete before rendering starts
+        mpInstanceBuffers->update(mpScene.get());
+        mpInstanceBuffers->clearVisible();
+
+        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(modelID, instanceID).get();
+                if (pModelInstance->isVisible() == false) continue;
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    const uint32_t slot = mpInstanceBuffers->getSlot(pModelInstance, meshID);
+                    if (slot == InstanceBuffers::kInvalidIndex) continue;
+
+                    for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, i).get();
+                        if (pMeshInstance->isVisible() == false) continue;
+
+                        if (mCullEnabled)
+                        {
+                            BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                            if (currentData.pCamera->isObjectCulled(box) || (mpOcclusionCuller && mpOcclusionCuller->isVisible(box) == false)) continue;
+                        }
+                        mpInstanceBuffers->addVisible(slot, i);
+                    }
+                }
+            }
+        }
+
+        mpInstanceBuffers->setIntoProgramVars(currentData.pVars);
+    }
+
     void SceneRenderer::renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance)
     {
         const Model* pModel = pModelInstance->getObject().get();
@@ -321,6 +469,25 @@ namespace Falcor
     {
         setPerFrameData(currentData);
 
+        if (mpOcclusionCuller && mCullEnabled)
+        {
+            mpOcclusionCuller->updateSelection(mpScene.get(), currentData.pCamera);
+            mpOcclusionCuller->build(mpScene.get(), currentData.pCamera);
+        }
+
+        if (mpInstanceBuffers)
+        {
+            if (useInstanceBuffers(currentData))
+            {
+                buildVisibleInstances(currentData);
+            }
+            else if (currentData.pBindings->instanceBuffersWarned == false)
+            {
+                logWarning("SceneRenderer::renderScene() - can't find gVisibleInstanceOffset. Was the program compiled with _MS_INSTANCE_BUFFERS? Falling back to per-instance constant buffers");
+                currentData.pBindings->instanceBuffersWarned = true;
+            }
+        }
+
         for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
         {
             currentData.pModel = mpScene->getModel(modelID).get();
@@ -341,12 +508,11 @@ namespace Falcor
 
     void SceneRenderer::renderScene(RenderContext* pContext, Camera* pCamera)
     {
-        updateVariableOffsets(pContext->getGraphicsVars()->getReflection().get());
-
         CurrentWorkingData currentData;
         currentData.pContext = pContext;
         currentData.pState = pContext->getGraphicsState().get();
         currentData.pVars = pContext->getGraphicsVars().get();
+        currentData.pBindings = &getProgramBindings(currentData.pVars);
         currentData.pCamera = pCamera;
         currentData.pMaterial = nullptr;
         currentData.pModel = nullptr;
@@ -32,7 +32,12 @@
 #include "Graphics/Scene/Scene.h"
 #include "utils/CpuTimer.h"
 #include "API/ConstantBuffer.h"
+#include "API/ProgramVars.h"
 #include "Utils/DebugDrawer.h"
+#include "Graphics/Material/MaterialTable.h"
+#include "Graphics/Scene/LightClusters.h"
+#include "Graphics/Scene/OcclusionCuller.h"
+#include "Graphics/Scene/InstanceBuffers.h"
 
 namespace Falcor
 {
@@ -93,8 +98,73 @@ namespace Falcor
 
         void toggleStaticMaterialCompilation(bool on) { mCompileMaterialWithProgram = on; }
 
+        /** Enable/disable the scene-wide material table. When enabled, all the scene materials are packed into a single buffer which is only updated when a material changes, and each draw only sets the material index.
+            The program must be compiled with _MS_MATERIAL_TABLE defined before its vars are created.
+        */
+        void toggleMaterialTable(bool on);
+
+        /** Enable/disable clustered light culling. When enabled, the scene lights are binned into a froxel grid of the rendering camera every frame, which lifts the MAX_LIGHT_SOURCES limit of the per-frame constant buffer.
+            The program must be compiled with _MS_LIGHT_CLUSTERS defined before its vars are created.
+        */
+        void toggleLightClusters(bool on);
+
+        /** Get the light clusters, or nullptr if clustered light culling is disabled
+        */
+        LightClusters* getLightClusters() const { return mpLightClusters.get(); }
+
+        /** Enable/disable CPU occlusion culling. When enabled, the scene's occluders are rasterized into a low-resolution depth buffer at the beginning of every renderScene() call, and mesh instances which are hidden behind them are not drawn. The occluders are selected automatically for the rendering camera, and selected again whenever it moves by more than a tenth of the scene radius. Use getOcclusionCuller() to register occluder proxies.
+            Only takes effect when object culling is enabled.
+        */
+        void toggleOcclusionCulling(bool on);
+
+        /** Get the occlusion culler, or nullptr if occlusion culling is disabled
+        */
+        OcclusionCuller* getOcclusionCuller() const { return mpOcclusionCuller.get(); }
+
+        /** Enable/disable persistent instance buffers. When enabled, the mesh instance transforms are kept in a structured buffer which is only updated when an instance moves, and all the visible instances of a mesh are drawn with a single call instead of being split by the size of the per-mesh constant buffer arrays.
+            The program must be compiled with _MS_INSTANCE_BUFFERS defined before its vars are created, otherwise the per-instance constant buffers are used and a warning is logged once. setPerMeshInstanceData() is not called for non-skinned meshes in this mode.
+        */
+        void toggleInstanceBuffers(bool on);
+
+        /** Get the instance buffers, or nullptr if they are disabled
+        */
+        InstanceBuffers* getInstanceBuffers() const { return mpInstanceBuffers.get(); }
+
     protected:
 
+        /** Offsets and buffer handles used by the renderer, resolved once per program reflection object
+        */
+        struct ProgramBindings
+        {
+            ProgramBindings(const ProgramReflection* pReflector);
+
+            ProgramVars::ConstantBufferHandle perFrameCb;
+            ProgramVars::ConstantBufferHandle perMeshCb;
+            ProgramVars::ConstantBufferHandle perMaterialCb;
+
+            size_t cameraDataOffset = ConstantBuffer::kInvalidOffset;
+            size_t lightCountOffset = ConstantBuffer::kInvalidOffset;
+            size_t lightArrayOffset = ConstantBuffer::kInvalidOffset;
+            size_t lightArraySize = 0;
+            size_t lightClustersOffset = ConstantBuffer::kInvalidOffset;
+            size_t ambientLightOffset = ConstantBuffer::kInvalidOffset;
+            size_t worldMatArraySize = 0;
+            size_t worldMatOffset = ConstantBuffer::kInvalidOffset;
+            size_t worldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
+            size_t meshIdOffset = ConstantBuffer::kInvalidOffset;
+            size_t drawIdOffset = ConstantBuffer::kInvalidOffset;
+            size_t visibleInstanceOffset = ConstantBuffer::kInvalidOffset;
+            size_t materialIndexOffset = ConstantBuffer::kInvalidOffset;
+            Material::ProgramBindings material;
+
+            mutable bool materialTableWarned = false;   ///< Warnings about the material table are logged once per program
+            mutable bool instanceBuffersWarned = false; ///< Programs without _MS_INSTANCE_BUFFERS are reported once
+        };
+
+        /** Get the bindings of the program the vars object was created for
+        */
+        static const ProgramBindings& getProgramBindings(const ProgramVars* pVars) { return pVars->getReflection()->getBindingCache<ProgramBindings>(); }
+
         struct CurrentWorkingData
         {
             RenderContext* pContext = nullptr;
@@ -103,6 +173,7 @@ namespace Falcor
             const Camera* pCamera = nullptr;
             const Model* pModel = nullptr;
             const Material* pMaterial = nullptr;
+            const ProgramBindings* pBindings = nullptr;  ///< Bindings of pVars
 
             uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene, and increments per mesh instance drawn.
         };
@@ -114,19 +185,6 @@ namespace Falcor
         static const char* kPerFrameCbName;
         static const char* kPerMeshCbName;
 
-        static size_t sBonesOffset;
-        static size_t sCameraDataOffset;
-        static size_t sLightCountOffset;
-        static size_t sLightArrayOffset;
-        static size_t sAmbientLightOffset;
-        static size_t sWorldMatArraySize;
-        static size_t sWorldMatOffset;
-        static size_t sWorldInvTransposeMatOffset;
-        static size_t sMeshIdOffset;
-        static size_t sDrawIDOffset;
-
-        static void updateVariableOffsets(const ProgramReflection* pReflector);
-
         virtual void setPerFrameData(const CurrentWorkingData& currentData);
         virtual bool setPerModelData(const CurrentWorkingData& currentData);
         virtual bool setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID);
@@ -139,6 +197,8 @@ namespace Falcor
         void renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance);
         void renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID);
         void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
+        void buildVisibleInstances(CurrentWorkingData& currentData);
+        bool useInstanceBuffers(const CurrentWorkingData& currentData) const { return mpInstanceBuffers && currentData.pBindings->visibleInstanceOffset != ConstantBuffer::kInvalidOffset; }
 
         void renderScene(CurrentWorkingData& currentData);
 
@@ -149,5 +209,10 @@ namespace Falcor
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
         bool mCompileMaterialWithProgram = true;
+        MaterialTable::SharedPtr mpMaterialTable;
+        LightClusters::SharedPtr mpLightClusters;
+        OcclusionCuller::SharedPtr mpOcclusionCuller;
+        InstanceBuffers::SharedPtr mpInstanceBuffers;
+        bool mLightOverflowReported = false;
     };
 }
@@ -0,0 +1,1134 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SceneSnapshot.h"
+#include "Utils/OS.h"
+#include "API/Device.h"
+#include <algorithm>
+#include <fstream>
+
+namespace Falcor
+{
+    const char* SceneSnapshot::kFileExtension = ".fsnap";
+
+    static const char kMagic[8] = { 'F', 'S', 'n', 'a', 'p', 's', 'h', 't' };
+    static const int32_t kInvalidIndex = -1;
+    static const size_t kHashChunkSize = 64 * 1024;
+
+    // The smallest number of bytes an element of each table takes in the file, used to reject counts the file can't hold before allocating
+    static const uint64_t kMinManifestEntrySize = sizeof(uint32_t) + 2 * sizeof(uint64_t);
+    static const uint64_t kMinTextureSize = 7 * sizeof(uint32_t);
+    static const uint64_t kMinMaterialSize = sizeof(uint32_t) + sizeof(int32_t) + sizeof(bool) + sizeof(float) + sizeof(glm::vec2) + sizeof(uint32_t) + 4 * sizeof(int32_t);
+    static const uint64_t kMinVertexBufferSize = sizeof(bool);
+
+    void SceneSnapshot::writeString(const std::string& str)
+    {
+        mStream << (uint32_t)str.size();
+        mStream.write(str.c_str(), str.size());
+    }
+
+    bool SceneSnapshot::canRead(uint64_t size)
+    {
+        // Sizes come from the file. Don't trust them beyond what's left of it
+        if (mStream.isFail() || size > mStream.getRemainingStreamSize())
+        {
+            mStream.setFail();
+            return false;
+        }
+        return true;
+    }
+
+    std::string SceneSnapshot::readString()
+    {
+        uint32_t length = 0;
+        mStream >> length;
+        if (length == 0 || canRead(length) == false)
+        {
+            return std::string();
+        }
+
+        std::string str(length, '\0');
+        mStream.read(&str[0], length);
+        return str;
+    }
+
+    bool SceneSnapshot::hashFile(const std::string& fullpath, uint64_t& size, uint64_t& hash)
+    {
+        std::ifstream file(fullpath, std::ios::binary);
+        if (file.fail())
+        {
+            return false;
+        }
+
+        // 64-bit FNV-1a over the file content, read in chunks so that large assets aren't loaded whole
+        std::vector<char> chunk(kHashChunkSize);
+        hash = 0xcbf29ce484222325ull;
+        size = 0;
+        while (file)
+        {
+            file.read(chunk.data(), chunk.size());
+            const std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; i++)
+            {
+                hash ^= (uint8_t)chunk[i];
+                hash *= 0x100000001b3ull;
+            }
+            size += (uint64_t)count;
+        }
+        return file.bad() == false;
+    }
+
+    int32_t SceneSnapshot::getTextureIndex(const Texture::SharedPtr& pTexture) const
+    {
+        if (pTexture == nullptr)
+        {
+            return kInvalidIndex;
+        }
+        return mTextureIndices.at(pTexture.get());
+    }
+
+    Texture::SharedPtr SceneSnapshot::getTexture(int32_t index) const
+    {
+        return (index >= 0 && index < (int32_t)mTextures.size()) ? mTextures[index] : nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Writing
+    //////////////////////////////////////////////////////////////////////////
+    bool SceneSnapshot::save(const std::string& filename, const Scene* pScene, Model::LoadFlags modelLoadFlags)
+    {
+        // The snapshot stores the bind-pose geometry only
+        for (uint32_t i = 0; i < pScene->getModelCount(); i++)
+        {
+            const auto& pModel = pScene->getModel(i);
+            if (pModel->hasBones() || pModel->hasAnimations())
+            {
+                logWarning("Can't create a scene snapshot. Model " + pModel->getName() + " has animations, which are not supported by the snapshot format.");
+                return false;
+            }
+        }
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        if (stream.isFail())
+        {
+            logError("Can't open scene snapshot file " + filename + " for writing.");
+            return false;
+        }
+
+        SceneSnapshot snapshot(stream);
+        snapshot.collectManifest(pScene);
+        snapshot.collectMaterials(pScene);
+
+        stream.write(kMagic, sizeof(kMagic));
+        stream << kVersion << (uint32_t)modelLoadFlags;
+
+        bool succeeded = snapshot.writeManifest();
+        succeeded = succeeded && snapshot.writeTextures();
+        if (succeeded)
+        {
+            snapshot.writeMaterials();
+            succeeded = snapshot.writeModels(pScene);
+        }
+
+        if (succeeded)
+        {
+            snapshot.writeLights(pScene);
+            snapshot.writeCameras(pScene);
+            snapshot.writePaths(pScene);
+            snapshot.writeGlobals(pScene);
+            snapshot.writeUserVariables(pScene);
+            succeeded = stream.isGood();
+        }
+
+        if (succeeded == false)
+        {
+            logError("Failed to write scene snapshot " + filename + ".");
+            stream.remove();
+        }
+        return succeeded;
+    }
+
+    void SceneSnapshot::collectManifest(const Scene* pScene)
+    {
+        std::vector<std::string> files = pScene->getSourceFiles();
+
+        // Add the textures. The materials store the filenames relative to the data directories
+        auto addTextureFile = [&files](const Texture::SharedPtr& pTexture)
+        {
+            std::string fullpath;
+            if (pTexture && pTexture->getSourceFilename().size() && findFileInDataDirectories(pTexture->getSourceFilename(), fullpath))
+            {
+                files.push_back(fullpath);
+            }
+        };
+
+        auto addMaterialFiles = [&addTextureFile](const Material* pMaterial)
+        {
+            for (uint32_t i = 0; i < pMaterial->getNumLayers(); i++)
+            {
+                addTextureFile(pMaterial->getLayer(i).pTexture);
+            }
+            addTextureFile(pMaterial->getNormalMap());
+            addTextureFile(pMaterial->getAlphaMap());
+            addTextureFile(pMaterial->getAmbientOcclusionMap());
+            addTextureFile(pMaterial->getHeightMap());
+        };
+
+        for (uint32_t i = 0; i < pScene->getMaterialCount(); i++)
+        {
+            addMaterialFiles(pScene->getMaterial(i).get());
+        }
+
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const auto& pModel = pScene->getModel(modelID);
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                addMaterialFiles(pModel->getMesh(meshID)->getMaterial().get());
+            }
+        }
+
+        // Remove duplicates and hash the files
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+
+        for (const auto& f : files)
+        {
+            ManifestEntry entry;
+            entry.fullpath = f;
+            if (hashFile(f, entry.size, entry.hash))
+            {
+                mManifest.push_back(entry);
+            }
+            else
+            {
+                logWarning("Scene snapshot - can't read source file " + f + ". It will not be validated when loading the snapshot.");
+            }
+        }
+    }
+
+    void SceneSnapshot::addTexture(const Texture::SharedPtr& pTexture)
+    {
+        if (pTexture && mTextureIndices.find(pTexture.get()) == mTextureIndices.end())
+        {
+            mTextureIndices[pTexture.get()] = (int32_t)mTextures.size();
+            mTextures.push_back(pTexture);
+        }
+    }
+
+    void SceneSnapshot::addMaterial(const Material::SharedPtr& pMaterial)
+    {
+        if (mMaterialIndices.find(pMaterial.get()) != mMaterialIndices.end())
+        {
+            return;
+        }
+
+        mMaterialIndices[pMaterial.get()] = (uint32_t)mMaterials.size();
+        mMaterials.push_back(pMaterial);
+
+        for (uint32_t i = 0; i < pMaterial->getNumLayers(); i++)
+        {
+            addTexture(pMaterial->getLayer(i).pTexture);
+        }
+        addTexture(pMaterial->getNormalMap());
+        addTexture(pMaterial->getAlphaMap());
+        addTexture(pMaterial->getAmbientOcclusionMap());
+        addTexture(pMaterial->getHeightMap());
+    }
+
+    void SceneSnapshot::collectMaterials(const Scene* pScene)
+    {
+        // Scene materials come first, so that their index in the table matches the scene's material index
+        for (uint32_t i = 0; i < pScene->getMaterialCount(); i++)
+        {
+            addMaterial(pScene->getMaterial(i));
+        }
+        mSceneMaterialCount = pScene->getMaterialCount();
+
+        const auto& pHistory = pScene->getMaterialHistory();
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const auto& pModel = pScene->getModel(modelID);
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                addMaterial(pMesh->getMaterial());
+                if (pHistory && pHistory->hasOverride(pMesh))
+                {
+                    addMaterial(pHistory->getOriginalMaterial(pMesh));
+                }
+            }
+        }
+    }
+
+    bool SceneSnapshot::writeManifest()
+    {
+        mStream << (uint32_t)mManifest.size();
+        for (const auto& entry : mManifest)
+        {
+            writeString(entry.fullpath);
+            mStream << entry.size << entry.hash;
+        }
+        return mStream.isGood();
+    }
+
+    bool SceneSnapshot::writeTextures()
+    {
+        RenderContext* pContext = gpDevice->getRenderContext().get();
+
+        mStream << (uint32_t)mTextures.size();
+        for (const auto& pTexture : mTextures)
+        {
+            if (pTexture->getType() != Texture::Type::Texture2D || pTexture->getArraySize() != 1)
+            {
+                logError("Scene snapshot only supports 2D textures. Texture " + pTexture->getSourceFilename() + " can't be written.");
+                return false;
+            }
+
+            writeString(pTexture->getSourceFilename());
+            writeString(pTexture->getName());
+            mStream << (uint32_t)pTexture->getFormat() << pTexture->getWidth() << pTexture->getHeight() << pTexture->getMipCount() << (uint32_t)pTexture->getBindFlags();
+
+            // Store the entire mip-chain, so that we don't need to regenerate it when loading
+            for (uint32_t mip = 0; mip < pTexture->getMipCount(); mip++)
+            {
+                std::vector<uint8> data = pContext->readTextureSubresource(pTexture.get(), pTexture->getSubresourceIndex(0, mip));
+                mStream << (uint64_t)data.size();
+                mStream.write(data.data(), data.size());
+            }
+        }
+        return mStream.isGood();
+    }
+
+    void SceneSnapshot::writeMaterials()
+    {
+        mStream << (uint32_t)mMaterials.size() << mSceneMaterialCount;
+        for (const auto& pMaterial : mMaterials)
+        {
+            writeString(pMaterial->getName());
+            mStream << (int32_t)pMaterial->getId() << pMaterial->isDoubleSided() << pMaterial->getAlphaThreshold() << pMaterial->getHeightModifiers();
+
+            mStream << pMaterial->getNumLayers();
+            for (uint32_t i = 0; i < pMaterial->getNumLayers(); i++)
+            {
+                const Material::Layer layer = pMaterial->getLayer(i);
+                mStream << (uint32_t)layer.type << (uint32_t)layer.ndf << (uint32_t)layer.blend;
+                mStream << layer.albedo << layer.roughness << layer.extraParam << layer.pmf;
+                mStream << getTextureIndex(layer.pTexture);
+            }
+
+            mStream << getTextureIndex(pMaterial->getNormalMap());
+            mStream << getTextureIndex(pMaterial->getAlphaMap());
+            mStream << getTextureIndex(pMaterial->getAmbientOcclusionMap());
+            mStream << getTextureIndex(pMaterial->getHeightMap());
+        }
+    }
+
+    void SceneSnapshot::readBackModelGeometry(const Model* pModel, BufferReadbacks& readbacks)
+    {
+        // Meshes share buffers, so each buffer is only read once
+        CopyContext* pContext = gpDevice->getRenderContext().get();
+        auto readBuffer = [&](const Buffer::SharedPtr& pBuffer)
+        {
+            if (pBuffer && readbacks.find(pBuffer.get()) == readbacks.end())
+            {
+                readbacks[pBuffer.get()] = pContext->asyncReadBuffer(pBuffer.get());
+            }
+        };
+
+        for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            const Vao* pVao = pModel->getMesh(meshID)->getVao().get();
+            for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+            {
+                readBuffer(pVao->getVertexBuffer(i));
+            }
+            readBuffer(pVao->getIndexBuffer());
+        }
+    }
+
+    bool SceneSnapshot::writeMesh(const Mesh* pMesh, const Material* pMaterial, const BufferReadbacks& readbacks)
+    {
+        const Vao* pVao = pMesh->getVao().get();
+        const auto& pLayout = pVao->getVertexLayout();
+
+        // Vertex buffers and their layouts
+        mStream << (uint32_t)pLayout->getBufferCount();
+        for (uint32_t i = 0; i < (uint32_t)pLayout->getBufferCount(); i++)
+        {
+            const auto& pBufferLayout = pLayout->getBufferLayout(i);
+            const Buffer::SharedPtr pVB = (i < pVao->getVertexBuffersCount()) ? pVao->getVertexBuffer(i) : nullptr;
+
+            bool hasBuffer = pBufferLayout && pVB;
+            mStream << hasBuffer;
+            if (hasBuffer == false)
+            {
+                continue;
+            }
+
+            mStream << pBufferLayout->getElementCount() << (uint32_t)pBufferLayout->getInputClass() << pBufferLayout->getInstanceStepRate();
+            for (uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+            {
+                writeString(pBufferLayout->getElementName(e));
+                mStream << pBufferLayout->getElementOffset(e) << (uint32_t)pBufferLayout->getElementFormat(e) << pBufferLayout->getElementArraySize(e) << pBufferLayout->getElementShaderLocation(e);
+            }
+
+            const ReadbackRequest::SharedPtr& pVBData = readbacks.at(pVB.get());
+            if (pVBData == nullptr) return false;
+            const std::vector<uint8>& data = pVBData->getData();
+            mStream << (uint32_t)pVB->getBindFlags() << (uint64_t)data.size();
+            mStream.write(data.data(), data.size());
+        }
+
+        // Index buffer
+        const Buffer::SharedPtr pIB = pVao->getIndexBuffer();
+        bool hasIndexBuffer = (pIB != nullptr);
+        mStream << hasIndexBuffer;
+        if (hasIndexBuffer)
+        {
+            const ReadbackRequest::SharedPtr& pIBData = readbacks.at(pIB.get());
+            if (pIBData == nullptr) return false;
+            const std::vector<uint8>& data = pIBData->getData();
+            mStream << (uint32_t)pVao->getIndexBufferFormat() << (uint32_t)pIB->getBindFlags() << (uint64_t)data.size();
+            mStream.write(data.data(), data.size());
+        }
+
+        mStream << pMesh->getVertexCount() << pMesh->getIndexCount() << (uint32_t)pVao->getPrimitiveTopology();
+        mStream << pMesh->getBoundingBox().center << pMesh->getBoundingBox().extent;
+        mStream << mMaterialIndices.at(pMaterial);
+        return mStream.isGood();
+    }
+
+    bool SceneSnapshot::writeModels(const Scene* pScene)
+    {
+        const auto& pHistory = pScene->getMaterialHistory();
+
+        mStream << pScene->getModelCount();
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            writeString(pModel->getName());
+            writeString(pModel->getFilename());
+
+            // Copy the model's vertex and index buffers to staging buffers in one batch. The first mesh waits for the GPU, the others find their data ready.
+            // The requests are released after the model was written, so the staging memory is recycled for the next model
+            BufferReadbacks readbacks;
+            readBackModelGeometry(pModel, readbacks);
+
+            // Meshes. Meshes can share vertex arrays, but the snapshot stores each mesh on its own.
+            mStream << pModel->getMeshCount();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                // Meshes are written with their original material. Overrides are re-applied through the scene's material history
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                bool hasOverride = pHistory && pHistory->hasOverride(pMesh);
+                const Material* pMaterial = hasOverride ? pHistory->getOriginalMaterial(pMesh).get() : pMesh->getMaterial().get();
+                if (writeMesh(pMesh, pMaterial, readbacks) == false)
+                {
+                    return false;
+                }
+
+                // Mesh instances
+                mStream << pModel->getMeshInstanceCount(meshID);
+                for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                {
+                    mStream << pModel->getMeshInstance(meshID, i)->getTransformMatrix();
+                }
+
+                mStream << hasOverride;
+                if (hasOverride)
+                {
+                    mStream << mMaterialIndices.at(pMesh->getMaterial().get());
+                }
+            }
+
+            // Model instances
+            mStream << pScene->getModelInstanceCount(modelID);
+            for (uint32_t i = 0; i < pScene->getModelInstanceCount(modelID); i++)
+            {
+                const auto& pInstance = pScene->getModelInstance(modelID, i);
+                writeString(pInstance->getName());
+                mStream << pInstance->getTranslation() << pInstance->getRotation() << pInstance->getScaling();
+                mMovables.push_back(pInstance);
+            }
+        }
+        return mStream.isGood();
+    }
+
+    void SceneSnapshot::writeLights(const Scene* pScene)
+    {
+        // Area lights are generated from the emissive materials when loading, so we don't store them
+        uint32_t lightCount = 0;
+        for (const auto& pLight : pScene->getLights())
+        {
+            lightCount += (pLight->getType() == LightPoint || pLight->getType() == LightDirectional) ? 1 : 0;
+        }
+
+        mStream << lightCount;
+        for (const auto& pLight : pScene->getLights())
+        {
+            if (pLight->getType() == LightPoint)
+            {
+                const PointLight* pPoint = (PointLight*)pLight.get();
+                mStream << (uint32_t)LightPoint;
+                writeString(pPoint->getName());
+                mStream << pPoint->getIntensity() << pPoint->getWorldPosition() << pPoint->getWorldDirection() << pPoint->getOpeningAngle() << pPoint->getPenumbraAngle();
+            }
+            else if (pLight->getType() == LightDirectional)
+            {
+                const DirectionalLight* pDir = (DirectionalLight*)pLight.get();
+                mStream << (uint32_t)LightDirectional;
+                writeString(pDir->getName());
+                mStream << pDir->getIntensity() << pDir->getWorldDirection();
+            }
+            else
+            {
+                continue;
+            }
+            mMovables.push_back(pLight);
+        }
+    }
+
+    void SceneSnapshot::writeCameras(const Scene* pScene)
+    {
+        mStream << pScene->getCameraCount();
+        for (uint32_t i = 0; i < pScene->getCameraCount(); i++)
+        {
+            const auto pCamera = pScene->getCamera(i);
+            writeString(pCamera->getName());
+            mStream << pCamera->getPosition() << pCamera->getTarget() << pCamera->getUpVector();
+            mStream << pCamera->getFocalLength() << pCamera->getNearPlane() << pCamera->getFarPlane() << pCamera->getAspectRatio();
+            mMovables.push_back(pCamera);
+        }
+    }
+
+    void SceneSnapshot::writePaths(const Scene* pScene)
+    {
+        mStream << pScene->getPathCount();
+        for (uint32_t pathID = 0; pathID < pScene->getPathCount(); pathID++)
+        {
+            const auto& pPath = pScene->getPath(pathID);
+            writeString(pPath->getName());
+            mStream << pPath->isRepeatOn();
+
+            mStream << pPath->getKeyFrameCount();
+            for (uint32_t frameID = 0; frameID < pPath->getKeyFrameCount(); frameID++)
+            {
+                const auto& frame = pPath->getKeyFrame(frameID);
+                mStream << frame.time << frame.position << frame.target << frame.up;
+            }
+
+            // Attached objects are stored as indices into the list of movable objects we wrote
+            std::vector<uint32_t> attached;
+            for (uint32_t i = 0; i < pPath->getAttachedObjectCount(); i++)
+            {
+                const auto& pObject = pPath->getAttachedObject(i);
+                auto it = std::find(mMovables.begin(), mMovables.end(), pObject);
+                if (it != mMovables.end())
+                {
+                    attached.push_back((uint32_t)(it - mMovables.begin()));
+                }
+            }
+
+            mStream << (uint32_t)attached.size();
+            for (uint32_t index : attached)
+            {
+                mStream << index;
+            }
+        }
+    }
+
+    void SceneSnapshot::writeGlobals(const Scene* pScene)
+    {
+        mStream << pScene->getVersion() << pScene->getAmbientIntensity() << pScene->getLightingScale() << pScene->getCameraSpeed() << pScene->getActiveCameraIndex();
+    }
+
+    void SceneSnapshot::writeUserVariables(const Scene* pScene)
+    {
+        mStream << pScene->getUserVariableCount();
+        for (uint32_t varID = 0; varID < pScene->getUserVariableCount(); varID++)
+        {
+            std::string name;
+            const auto& var = pScene->getUserVariable(varID, name);
+            writeString(name);
+            mStream << (uint32_t)var.type;
+
+            switch (var.type)
+            {
+            case Scene::UserVariable::Type::Int:
+            case Scene::UserVariable::Type::Uint:
+            case Scene::UserVariable::Type::Int64:
+            case Scene::UserVariable::Type::Uint64:
+            case Scene::UserVariable::Type::Double:
+            case Scene::UserVariable::Type::Bool:
+                // All of the literals share the same union
+                mStream << var.u64;
+                break;
+            case Scene::UserVariable::Type::String:
+                writeString(var.str);
+                break;
+            case Scene::UserVariable::Type::Vec2:
+                mStream << var.vec2;
+                break;
+            case Scene::UserVariable::Type::Vec3:
+                mStream << var.vec3;
+                break;
+            case Scene::UserVariable::Type::Vec4:
+                mStream << var.vec4;
+                break;
+            case Scene::UserVariable::Type::Vector:
+                mStream << (uint32_t)var.vector.size();
+                mStream.write(var.vector.data(), var.vector.size() * sizeof(float));
+                break;
+            default:
+                should_not_get_here();
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    // Reading
+    //////////////////////////////////////////////////////////////////////////
+    bool SceneSnapshot::load(Scene& scene, const std::string& filename, Model::LoadFlags modelLoadFlags)
+    {
+        if (doesFileExist(filename) == false)
+        {
+            return false;
+        }
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+        char magic[sizeof(kMagic)];
+        uint32_t version = 0;
+        uint32_t flags = 0;
+        stream.read(magic, sizeof(magic));
+        stream >> version >> flags;
+
+        if (stream.isFail() || memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion)
+        {
+            logInfo("Scene snapshot " + filename + " has an unsupported format. Ignoring it.");
+            return false;
+        }
+
+        if (flags != (uint32_t)modelLoadFlags)
+        {
+            logInfo("Scene snapshot " + filename + " was created with different model load flags. Ignoring it.");
+            return false;
+        }
+
+        SceneSnapshot snapshot(stream);
+        if (snapshot.readAndValidateManifest() == false)
+        {
+            logInfo("Scene snapshot " + filename + " is out-of-date. Ignoring it.");
+            return false;
+        }
+
+        bool succeeded = snapshot.readTextures() && snapshot.readMaterials() && snapshot.readModels(scene) && snapshot.readLights(scene) && snapshot.readCameras(scene) && snapshot.readPaths(scene) && snapshot.readGlobals(scene) && snapshot.readUserVariables(scene);
+        if (succeeded == false)
+        {
+            logWarning("Error when reading scene snapshot " + filename + ".");
+            return false;
+        }
+
+        for (const auto& entry : snapshot.mManifest)
+        {
+            scene.addSourceFile(entry.fullpath);
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::readAndValidateManifest()
+    {
+        uint32_t count = 0;
+        mStream >> count;
+        if (canRead(count * kMinManifestEntrySize) == false)
+        {
+            return false;
+        }
+        mManifest.resize(count);
+        for (auto& entry : mManifest)
+        {
+            entry.fullpath = readString();
+            mStream >> entry.size >> entry.hash;
+        }
+
+        if (mStream.isFail())
+        {
+            return false;
+        }
+
+        for (const auto& entry : mManifest)
+        {
+            uint64_t size, hash;
+            if (hashFile(entry.fullpath, size, hash) == false || size != entry.size || hash != entry.hash)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::readTextures()
+    {
+        uint32_t count = 0;
+        mStream >> count;
+        if (canRead(count * kMinTextureSize) == false)
+        {
+            return false;
+        }
+        mTextures.resize(count);
+
+        std::vector<uint8_t> data;
+        for (auto& pTexture : mTextures)
+        {
+            std::string sourceFilename = readString();
+            std::string name = readString();
+            uint32_t format, width, height, mipCount, bindFlags;
+            mStream >> format >> width >> height >> mipCount >> bindFlags;
+
+            // Read the mip-chain into a single buffer, which is the layout Texture::create2D() expects
+            data.clear();
+            for (uint32_t mip = 0; mip < mipCount; mip++)
+            {
+                uint64_t size = 0;
+                mStream >> size;
+                if (canRead(size) == false)
+                {
+                    return false;
+                }
+                size_t offset = data.size();
+                data.resize(offset + (size_t)size);
+                mStream.read(data.data() + offset, (size_t)size);
+            }
+
+            if (mStream.isFail())
+            {
+                return false;
+            }
+
+            pTexture = Texture::create2D(width, height, (ResourceFormat)format, 1, mipCount, data.data(), (Resource::BindFlags)bindFlags);
+            if (pTexture == nullptr)
+            {
+                return false;
+            }
+            pTexture->setSourceFilename(sourceFilename);
+            pTexture->setName(name);
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::readMaterials()
+    {
+        uint32_t count = 0;
+        mStream >> count >> mSceneMaterialCount;
+        if (canRead(count * kMinMaterialSize) == false)
+        {
+            return false;
+        }
+        mMaterials.resize(count);
+
+        for (auto& pMaterial : mMaterials)
+        {
+            pMaterial = Material::create(readString());
+
+            int32_t id;
+            bool doubleSided;
+            float alphaThreshold;
+            glm::vec2 heightModifiers;
+            uint32_t layerCount;
+            mStream >> id >> doubleSided >> alphaThreshold >> heightModifiers >> layerCount;
+
+            pMaterial->setID(id);
+            pMaterial->setDoubleSided(doubleSided);
+            pMaterial->setAlphaThreshold(alphaThreshold);
+            pMaterial->setHeightModifiers(heightModifiers);
+
+            for (uint32_t i = 0; i < layerCount; i++)
+            {
+                Material::Layer layer;
+                uint32_t type, ndf, blend;
+                int32_t texID;
+                mStream >> type >> ndf >> blend;
+                mStream >> layer.albedo >> layer.roughness >> layer.extraParam >> layer.pmf;
+                mStream >> texID;
+
+                layer.type = (Material::Layer::Type)type;
+                layer.ndf = (Material::Layer::NDF)ndf;
+                layer.blend = (Material::Layer::Blend)blend;
+                layer.pTexture = getTexture(texID);
+                pMaterial->addLayer(layer);
+            }
+
+            int32_t normalID, alphaID, aoID, heightID;
+            mStream >> normalID >> alphaID >> aoID >> heightID;
+
+            Texture::SharedPtr pNormalMap = getTexture(normalID);
+            if (pNormalMap)
+            {
+                pMaterial->setNormalMap(pNormalMap);
+            }
+            pMaterial->setAlphaMap(getTexture(alphaID));
+            pMaterial->setAmbientOcclusionMap(getTexture(aoID));
+            pMaterial->setHeightMap(getTexture(heightID));
+        }
+        return (mStream.isFail() == false) && (mSceneMaterialCount <= count);
+    }
+
+    Mesh::SharedPtr SceneSnapshot::readMesh()
+    {
+        uint32_t bufferCount = 0;
+        mStream >> bufferCount;
+        if (canRead(bufferCount * kMinVertexBufferSize) == false)
+        {
+            return nullptr;
+        }
+
+        VertexLayout::SharedPtr pLayout = VertexLayout::create();
+        Vao::BufferVec vertexBuffers(bufferCount);
+        std::vector<uint8_t> data;
+
+        for (uint32_t i = 0; i < bufferCount; i++)
+        {
+            bool hasBuffer;
+            mStream >> hasBuffer;
+            if (hasBuffer == false)
+            {
+                continue;
+            }
+
+            uint32_t elementCount, inputClass, stepRate;
+            mStream >> elementCount >> inputClass >> stepRate;
+
+            VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+            for (uint32_t e = 0; e < elementCount; e++)
+            {
+                std::string name = readString();
+                uint32_t offset, format, arraySize, shaderLocation;
+                mStream >> offset >> format >> arraySize >> shaderLocation;
+                pBufferLayout->addElement(name, offset, (ResourceFormat)format, arraySize, shaderLocation);
+            }
+            pBufferLayout->setInputClass((VertexBufferLayout::InputClass)inputClass, stepRate);
+            pLayout->addBufferLayout(i, pBufferLayout);
+
+            uint32_t bindFlags;
+            uint64_t size;
+            mStream >> bindFlags >> size;
+            if (canRead(size) == false)
+            {
+                return nullptr;
+            }
+            data.resize((size_t)size);
+            mStream.read(data.data(), data.size());
+            vertexBuffers[i] = Buffer::create(data.size(), (Resource::BindFlags)bindFlags, Buffer::CpuAccess::None, data.data());
+        }
+
+        bool hasIndexBuffer;
+        mStream >> hasIndexBuffer;
+        Buffer::SharedPtr pIB;
+        if (hasIndexBuffer)
+        {
+            uint32_t format, bindFlags;
+            uint64_t size;
+            mStream >> format >> bindFlags >> size;
+            if (canRead(size) == false)
+            {
+                return nullptr;
+            }
+            data.resize((size_t)size);
+            mStream.read(data.data(), data.size());
+            pIB = Buffer::create(data.size(), (Resource::BindFlags)bindFlags, Buffer::CpuAccess::None, data.data());
+        }
+
+        uint32_t vertexCount, indexCount, topology, materialID;
+        BoundingBox box;
+        mStream >> vertexCount >> indexCount >> topology;
+        mStream >> box.center >> box.extent;
+        mStream >> materialID;
+
+        if (mStream.isFail() || materialID >= mMaterials.size())
+        {
+            return nullptr;
+        }
+
+        return Mesh::create(vertexBuffers, vertexCount, pIB, indexCount, pLayout, (Vao::Topology)topology, mMaterials[materialID], box, false);
+    }
+
+    bool SceneSnapshot::readModels(Scene& scene)
+    {
+        // Scene materials were written first
+        for (uint32_t i = 0; i < mSceneMaterialCount; i++)
+        {
+            scene.addMaterial(mMaterials[i]);
+        }
+
+        uint32_t modelCount = 0;
+        mStream >> modelCount;
+
+        struct Override
+        {
+            Mesh* pMesh;
+            Material::SharedPtr pMaterial;
+        };
+        std::vector<Override> overrides;
+
+        for (uint32_t modelID = 0; modelID < modelCount; modelID++)
+        {
+            Model::SharedPtr pModel = Model::create();
+            pModel->setName(readString());
+            pModel->setFilename(readString());
+
+            uint32_t meshCount = 0;
+            mStream >> meshCount;
+            for (uint32_t meshID = 0; meshID < meshCount; meshID++)
+            {
+                Mesh::SharedPtr pMesh = readMesh();
+                if (pMesh == nullptr)
+                {
+                    return false;
+                }
+
+                uint32_t instanceCount = 0;
+                mStream >> instanceCount;
+                for (uint32_t i = 0; i < instanceCount; i++)
+                {
+                    glm::mat4 transform;
+                    mStream >> transform;
+                    pModel->addMeshInstance(pMesh, transform);
+                }
+
+                bool hasOverride;
+                mStream >> hasOverride;
+                if (hasOverride)
+                {
+                    uint32_t materialID;
+                    mStream >> materialID;
+                    if (materialID >= mMaterials.size())
+                    {
+                        return false;
+                    }
+                    overrides.push_back({ pMesh.get(), mMaterials[materialID] });
+                }
+            }
+            pModel->calculateModelProperties();
+
+            uint32_t instanceCount = 0;
+            mStream >> instanceCount;
+            for (uint32_t i = 0; i < instanceCount; i++)
+            {
+                std::string name = readString();
+                glm::vec3 translation, rotation, scaling;
+                mStream >> translation >> rotation >> scaling;
+                auto pInstance = Scene::ModelInstance::create(pModel, translation, rotation, scaling, name);
+                scene.addModelInstance(pInstance);
+                mMovables.push_back(pInstance);
+            }
+
+            if (mStream.isFail())
+            {
+                return false;
+            }
+        }
+
+        for (const auto& o : overrides)
+        {
+            scene.getMaterialHistory()->replace(o.pMesh, o.pMaterial);
+        }
+        return true;
+    }
+
+    bool SceneSnapshot::readLights(Scene& scene)
+    {
+        uint32_t count = 0;
+        mStream >> count;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t type;
+            mStream >> type;
+            if (type == LightPoint)
+            {
+                auto pPoint = PointLight::create();
+                pPoint->setName(readString());
+                glm::vec3 intensity, position, direction;
+                float openingAngle, penumbraAngle;
+                mStream >> intensity >> position >> direction >> openingAngle >> penumbraAngle;
+                pPoint->setIntensity(intensity);
+                pPoint->setWorldPosition(position);
+                pPoint->setWorldDirection(direction);
+                pPoint->setOpeningAngle(openingAngle);
+                pPoint->setPenumbraAngle(penumbraAngle);
+                scene.addLight(pPoint);
+                mMovables.push_back(pPoint);
+            }
+            else if (type == LightDirectional)
+            {
+                auto pDir = DirectionalLight::create();
+                pDir->setName(readString());
+                glm::vec3 intensity, direction;
+                mStream >> intensity >> direction;
+                pDir->setIntensity(intensity);
+                pDir->setWorldDirection(direction);
+                scene.addLight(pDir);
+                mMovables.push_back(pDir);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return mStream.isFail() == false;
+    }
+
+    bool SceneSnapshot::readCameras(Scene& scene)
+    {
+        uint32_t count = 0;
+        mStream >> count;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto pCamera = Camera::create();
+            pCamera->setName(readString());
+            glm::vec3 position, target, up;
+            float focalLength, nearZ, farZ, aspectRatio;
+            mStream >> position >> target >> up >> focalLength >> nearZ >> farZ >> aspectRatio;
+            pCamera->setPosition(position);
+            pCamera->setTarget(target);
+            pCamera->setUpVector(up);
+            pCamera->setFocalLength(focalLength);
+            pCamera->setDepthRange(nearZ, farZ);
+            pCamera->setAspectRatio(aspectRatio);
+            scene.addCamera(pCamera);
+            mMovables.push_back(pCamera);
+        }
+        return mStream.isFail() == false;
+    }
+
+    bool SceneSnapshot::readPaths(Scene& scene)
+    {
+        uint32_t count = 0;
+        mStream >> count;
+        for (uint32_t pathID = 0; pathID < count; pathID++)
+        {
+            auto pPath = ObjectPath::create();
+            pPath->setName(readString());
+            bool repeat;
+            mStream >> repeat;
+            pPath->setAnimationRepeat(repeat);
+
+            uint32_t frameCount = 0;
+            mStream >> frameCount;
+            for (uint32_t frameID = 0; frameID < frameCount; frameID++)
+            {
+                ObjectPath::Frame frame;
+                mStream >> frame.time >> frame.position >> frame.target >> frame.up;
+                pPath->addKeyFrame(frame.time, frame.position, frame.target, frame.up);
+            }
+
+            uint32_t attachedCount = 0;
+            mStream >> attachedCount;
+            for (uint32_t i = 0; i < attachedCount; i++)
+            {
+                uint32_t index;
+                mStream >> index;
+                if (index >= mMovables.size())
+                {
+                    return false;
+                }
+                pPath->attachObject(mMovables[index]);
+            }
+            scene.addPath(pPath);
+        }
+        return mStream.isFail() == false;
+    }
+
+    bool SceneSnapshot::readGlobals(Scene& scene)
+    {
+        uint32_t version, activeCamera;
+        glm::vec3 ambientIntensity;
+        float lightingScale, cameraSpeed;
+        mStream >> version >> ambientIntensity >> lightingScale >> cameraSpeed >> activeCamera;
+
+        scene.setVersion(version);
+        scene.setAmbientIntensity(ambientIntensity);
+        scene.setLightingScale(lightingScale);
+        scene.setCameraSpeed(cameraSpeed);
+        scene.setActiveCamera(activeCamera);
+        return mStream.isFail() == false;
+    }
+
+    bool SceneSnapshot::readUserVariables(Scene& scene)
+    {
+        uint32_t count = 0;
+        mStream >> count;
+        for (uint32_t varID = 0; varID < count; varID++)
+        {
+            std::string name = readString();
+            uint32_t type;
+            mStream >> type;
+
+            Scene::UserVariable var;
+            var.type = (Scene::UserVariable::Type)type;
+            switch (var.type)
+            {
+            case Scene::UserVariable::Type::Int:
+            case Scene::UserVariable::Type::Uint:
+            case Scene::UserVariable::Type::Int64:
+            case Scene::UserVariable::Type::Uint64:
+            case Scene::UserVariable::Type::Double:
+            case Scene::UserVariable::Type::Bool:
+                mStream >> var.u64;
+                break;
+            case Scene::UserVariable::Type::String:
+                var.str = readString();
+                break;
+            case Scene::UserVariable::Type::Vec2:
+                mStream >> var.vec2;
+                break;
+            case Scene::UserVariable::Type::Vec3:
+                mStream >> var.vec3;
+                break;
+            case Scene::UserVariable::Type::Vec4:
+                mStream >> var.vec4;
+                break;
+            case Scene::UserVariable::Type::Vector:
+            {
+                uint32_t size = 0;
+                mStream >> size;
+                if (canRead((uint64_t)size * sizeof(float)) == false)
+                {
+                    return false;
+                }
+                var.vector.resize(size);
+                mStream.read(var.vector.data(), size * sizeof(float));
+                break;
+            }
+            default:
+                return false;
+            }
+            scene.addUserVariable(name, var);
+        }
+        return mStream.isFail() == false;
+    }
+}
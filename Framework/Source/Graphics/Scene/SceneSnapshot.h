@@ -0,0 +1,126 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Scene.h"
+#include "Utils/BinaryFileStream.h"
+#include "API/AsyncReadback.h"
+
+namespace Falcor
+{
+    /** Binary snapshot of a fully-processed scene.
+        A snapshot contains everything required to recreate a scene without parsing the scene file or re-importing the models: materials and their textures (including all mip-levels), model geometry, lights, cameras, paths and user variables.
+        Each snapshot starts with a manifest of the source files the scene was created from. The snapshot is only used if all the files still match the manifest.
+    */
+    class SceneSnapshot
+    {
+    public:
+        /** Write a snapshot of a scene
+            \param[in] filename The snapshot filename
+            \param[in] pScene The scene to write
+            \param[in] modelLoadFlags The flags the scene's models were loaded with. A snapshot is only valid for the same set of flags.
+            \return true if the snapshot was written successfully, otherwise false
+        */
+        static bool save(const std::string& filename, const Scene* pScene, Model::LoadFlags modelLoadFlags);
+
+        /** Load a scene from a snapshot
+            \param[in] scene The scene to populate
+            \param[in] filename The snapshot filename
+            \param[in] modelLoadFlags The requested model flags. The snapshot will be rejected if it was created using different flags.
+            \return true if the snapshot was valid and loaded successfully, otherwise false. If false is returned the scene is left empty.
+        */
+        static bool load(Scene& scene, const std::string& filename, Model::LoadFlags modelLoadFlags);
+
+        /** Get the snapshot filename matching a scene file
+        */
+        static std::string getSnapshotFilename(const std::string& sceneFullpath) { return sceneFullpath + kFileExtension; }
+
+        static const char* kFileExtension;
+        static const uint32_t kVersion = 1;
+
+    private:
+        struct ManifestEntry
+        {
+            std::string fullpath;
+            uint64_t size = 0;
+            uint64_t hash = 0;
+        };
+
+        SceneSnapshot(BinaryFileStream& stream) : mStream(stream) {}
+
+        static bool hashFile(const std::string& fullpath, uint64_t& size, uint64_t& hash);
+
+        // Writing
+        void collectManifest(const Scene* pScene);
+        void collectMaterials(const Scene* pScene);
+        void addMaterial(const Material::SharedPtr& pMaterial);
+        void addTexture(const Texture::SharedPtr& pTexture);
+        bool writeManifest();
+        bool writeTextures();
+        void writeMaterials();
+        bool writeModels(const Scene* pScene);
+        using BufferReadbacks = std::unordered_map<const Buffer*, ReadbackRequest::SharedPtr>;
+        void readBackModelGeometry(const Model* pModel, BufferReadbacks& readbacks);
+        bool writeMesh(const Mesh* pMesh, const Material* pMaterial, const BufferReadbacks& readbacks);
+        void writeLights(const Scene* pScene);
+        void writeCameras(const Scene* pScene);
+        void writePaths(const Scene* pScene);
+        void writeGlobals(const Scene* pScene);
+        void writeUserVariables(const Scene* pScene);
+
+        // Reading
+        bool readAndValidateManifest();
+        bool readTextures();
+        bool readMaterials();
+        bool readModels(Scene& scene);
+        Mesh::SharedPtr readMesh();
+        bool readLights(Scene& scene);
+        bool readCameras(Scene& scene);
+        bool readPaths(Scene& scene);
+        bool readGlobals(Scene& scene);
+        bool readUserVariables(Scene& scene);
+
+        void writeString(const std::string& str);
+        std::string readString();
+        bool canRead(uint64_t size);
+        int32_t getTextureIndex(const Texture::SharedPtr& pTexture) const;
+        Texture::SharedPtr getTexture(int32_t index) const;
+
+        BinaryFileStream& mStream;
+        std::vector<ManifestEntry> mManifest;
+
+        std::vector<Texture::SharedPtr> mTextures;
+        std::unordered_map<const Texture*, int32_t> mTextureIndices;
+        std::vector<Material::SharedPtr> mMaterials;
+        std::unordered_map<const Material*, uint32_t> mMaterialIndices;
+        uint32_t mSceneMaterialCount = 0;
+        std::vector<IMovableObject::SharedPtr> mMovables;   // Model instances, lights and cameras in the order they were written. Used to attach objects to paths.
+    };
+}
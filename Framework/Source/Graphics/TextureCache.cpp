@@ -0,0 +1,347 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureCache.h"
+#include "API/Device.h"
+#include "API/RenderContext.h"
+#include "Utils/DDSHeader.h"
+#include "Utils/Gui.h"
+#include "Utils/OS.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <thread>
+
+namespace Falcor
+{
+    using namespace DdsHelper;
+
+    // Bump when the cooking code changes, to invalidate the existing entries
+    static const char* kCacheVersion = "1";
+    static const uint32_t kDdsMagicNumber = 0x20534444;
+    static const uint32_t kDx10FourCC = 0x30315844;    // "DX10"
+    static const size_t kDdsDataOffset = sizeof(uint32_t) + sizeof(DdsHeader) + sizeof(DdsHeaderDX10);
+
+    struct CacheState
+    {
+        std::string directory;
+        TextureCache::Stats stats;
+        bool initialized = false;
+    };
+
+    static CacheState& getState()
+    {
+        static CacheState state;
+        if (state.initialized == false)
+        {
+            state.initialized = true;
+            std::string directory;
+            if (getEnvironemntVariable("FALCOR_TEXTURE_CACHE", directory))
+            {
+                TextureCache::setDirectory(directory);
+            }
+        }
+        return state;
+    }
+
+    static uint64_t getFileSize(const std::string& fullpath)
+    {
+        struct stat s;
+        return (stat(fullpath.c_str(), &s) == 0) ? (uint64_t)s.st_size : 0;
+    }
+
+    static std::string getEntryPath(const std::string& key)
+    {
+        return getState().directory + '\\' + key + ".dds";
+    }
+
+    // 64-bit hash over 8-byte words. Not cryptographic, a collision only means a wrong texture is loaded
+    static uint64_t hashData(const void* pData, size_t size, uint64_t seed)
+    {
+        const uint64_t k0 = 0x9E3779B97F4A7C15ull;
+        const uint64_t k1 = 0xC2B2AE3D27D4EB4Full;
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        uint64_t hash = seed ^ (size * k0);
+
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, pBytes + i, 8);
+            word *= k1;
+            word = (word << 31) | (word >> 33);
+            hash ^= word * k0;
+            hash = ((hash << 27) | (hash >> 37)) * 5 + 0x52DCE729;
+        }
+        for (; i < size; i++)
+        {
+            hash ^= pBytes[i] * k0;
+            hash = ((hash << 11) | (hash >> 53)) * k1;
+        }
+
+        // Final avalanche
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static size_t getMipSize(ResourceFormat format, uint32_t width, uint32_t height, uint32_t mip)
+    {
+        const uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        const uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+        const uint32_t w = std::max(width >> mip, 1u);
+        const uint32_t h = std::max(height >> mip, 1u);
+        return (size_t)((w + blockWidth - 1) / blockWidth) * ((h + blockHeight - 1) / blockHeight) * getFormatBytesPerBlock(format);
+    }
+
+    void TextureCache::setDirectory(const std::string& directory)
+    {
+        CacheState& state = getState();
+        state.directory.clear();
+        state.stats = Stats();
+        if (directory.empty())
+        {
+            return;
+        }
+
+        if (isDirectoryExists(directory) == false && createDirectory(directory) == false)
+        {
+            logWarning("TextureCache::setDirectory() - can't create the cache directory '" + directory + "'. The texture cache is disabled.");
+            return;
+        }
+        state.directory = directory;
+
+        std::vector<std::string> entries;
+        enumerateFiles(directory + "\\*.dds", entries);
+        for (const auto& entry : entries)
+        {
+            state.stats.entryCount++;
+            state.stats.cacheSize += getFileSize(directory + '\\' + entry);
+        }
+        logInfo("TextureCache - using '" + directory + "', " + std::to_string(state.stats.entryCount) + " entries, " + std::to_string(state.stats.cacheSize >> 20) + " MB");
+    }
+
+    const std::string& TextureCache::getDirectory()
+    {
+        return getState().directory;
+    }
+
+    const TextureCache::Stats& TextureCache::getStats()
+    {
+        return getState().stats;
+    }
+
+    std::string TextureCache::getKey(const std::string& filename, const std::string& options)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            return "";
+        }
+
+        size_t size = 0;
+        const void* pData = mapFileForReading(fullpath, size);
+        if (pData == nullptr)
+        {
+            return "";
+        }
+
+        const std::string salt = std::string(kCacheVersion) + '|' + options;
+        uint64_t hash = hashData(salt.data(), salt.size(), 0);
+        hash = hashData(pData, size, hash);
+        unmapFile(pData);
+
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+        return key;
+    }
+
+    Texture::SharedPtr TextureCache::load(const std::string& key, Texture::BindFlags bindFlags)
+    {
+        CacheState& state = getState();
+        if (state.directory.empty() || key.empty())
+        {
+            return nullptr;
+        }
+
+        const std::string path = getEntryPath(key);
+        size_t size = 0;
+        const uint8_t* pData = (const uint8_t*)mapFileForReading(path, size);
+        if (pData == nullptr)
+        {
+            state.stats.misses++;
+            return nullptr;
+        }
+
+        // Entries are only written by store(), so anything unexpected means the file is damaged
+        Texture::SharedPtr pTexture;
+        if (size >= kDdsDataOffset && *(const uint32_t*)pData == kDdsMagicNumber)
+        {
+            const DdsHeader& header = *(const DdsHeader*)(pData + sizeof(uint32_t));
+            const DdsHeaderDX10& dx10Header = *(const DdsHeaderDX10*)(pData + sizeof(uint32_t) + sizeof(DdsHeader));
+            const ResourceFormat format = falcorFormatFromDXGIFormat(dx10Header.dxgiFormat);
+            const uint32_t mipLevels = std::max(header.mipCount, 1u);
+
+            size_t dataSize = 0;
+            if (format != ResourceFormat::Unknown && header.pixelFormat.fourCC == kDx10FourCC)
+            {
+                for (uint32_t mip = 0; mip < mipLevels; mip++) dataSize += getMipSize(format, header.width, header.height, mip);
+            }
+            if (dataSize != 0 && size == kDdsDataOffset + dataSize)
+            {
+                pTexture = Texture::create2D(header.width, header.height, format, 1, mipLevels, pData + kDdsDataOffset, bindFlags);
+            }
+        }
+        unmapFile(pData);
+
+        if (pTexture == nullptr)
+        {
+            logWarning("TextureCache::load() - the cache entry '" + path + "' is invalid. Removing it.");
+            std::remove(path.c_str());
+            state.stats.misses++;
+            return nullptr;
+        }
+
+        state.stats.hits++;
+        state.stats.bytesLoaded += size;
+        return pTexture;
+    }
+
+    bool TextureCache::store(const std::string& key, uint32_t width, uint32_t height, ResourceFormat format, uint32_t mipLevels, const void* pData, size_t size)
+    {
+        CacheState& state = getState();
+        if (state.directory.empty() || key.empty())
+        {
+            return false;
+        }
+
+        size_t expectedSize = 0;
+        for (uint32_t mip = 0; mip < mipLevels; mip++) expectedSize += getMipSize(format, width, height, mip);
+        const DXGI_FORMAT dxgiFormat = dxgiFormatFromFalcorFormat(format);
+        if (dxgiFormat == DXGI_FORMAT_UNKNOWN || size != expectedSize)
+        {
+            logWarning("TextureCache::store() - can't store textures with format " + to_string(format) + " or with an incomplete mip chain");
+            return false;
+        }
+
+        DdsHeader header = {};
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kMipCountMask | DdsHeader::kLinearSizeMask;
+        header.width = width;
+        header.height = height;
+        header.linearSize = (uint32_t)getMipSize(format, width, height, 0);
+        header.mipCount = mipLevels;
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = kDx10FourCC;
+        header.caps[0] = DdsHeader::kCapsTextureMask | ((mipLevels > 1) ? (DdsHeader::kCapsComplexMask | DdsHeader::kCapsMipMapMask) : 0);
+
+        DdsHeaderDX10 dx10Header = {};
+        dx10Header.dxgiFormat = dxgiFormat;
+        dx10Header.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        // Write to a unique temporary file and rename it, so that readers never see a partial entry
+        const std::string path = getEntryPath(key);
+        const uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        const std::string tempPath = path + '.' + std::to_string(unique) + ".tmp";
+        FILE* pFile = fopen(tempPath.c_str(), "wb");
+        if (pFile == nullptr)
+        {
+            logWarning("TextureCache::store() - can't create '" + tempPath + "'");
+            return false;
+        }
+        bool written = fwrite(&kDdsMagicNumber, sizeof(uint32_t), 1, pFile) == 1;
+        written = written && fwrite(&header, sizeof(header), 1, pFile) == 1;
+        written = written && fwrite(&dx10Header, sizeof(dx10Header), 1, pFile) == 1;
+        written = written && fwrite(pData, 1, size, pFile) == size;
+        written = (fclose(pFile) == 0) && written;
+
+        // rename() fails if the entry already exists, in which case another writer stored the same texture
+        if (written == false || std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+
+        state.stats.writes++;
+        state.stats.entryCount++;
+        state.stats.cacheSize += kDdsDataOffset + size;
+        return true;
+    }
+
+    bool TextureCache::store(const std::string& key, const Texture* pTexture)
+    {
+        if (isEnabled() == false || key.empty())
+        {
+            return false;
+        }
+        if (pTexture->getType() != Texture::Type::Texture2D || pTexture->getArraySize() != 1)
+        {
+            logWarning("TextureCache::store() - only single 2D textures can be cached");
+            return false;
+        }
+
+        RenderContext* pContext = gpDevice->getRenderContext().get();
+        std::vector<uint8_t> data;
+        for (uint32_t mip = 0; mip < pTexture->getMipCount(); mip++)
+        {
+            std::vector<uint8> mipData = pContext->readTextureSubresource(pTexture, pTexture->getSubresourceIndex(0, mip));
+            data.insert(data.end(), mipData.begin(), mipData.end());
+        }
+        return store(key, pTexture->getWidth(), pTexture->getHeight(), pTexture->getFormat(), pTexture->getMipCount(), data.data(), data.size());
+    }
+
+    void TextureCache::renderUI(Gui* pGui, const char* group)
+    {
+        if (group == nullptr || pGui->beginGroup(group))
+        {
+            const CacheState& state = getState();
+            if (state.directory.empty())
+            {
+                pGui->addText("Texture cache disabled");
+            }
+            else
+            {
+                const Stats& stats = state.stats;
+                const uint32_t lookups = stats.hits + stats.misses;
+                std::string text = "Directory: " + state.directory + "\n";
+                text += "Entries: " + std::to_string(stats.entryCount) + " (" + std::to_string(stats.cacheSize >> 20) + " MB)\n";
+                text += "Hits: " + std::to_string(stats.hits) + ", misses: " + std::to_string(stats.misses);
+                text += ", hit rate: " + std::to_string(lookups ? (100 * stats.hits / lookups) : 0) + "%\n";
+                text += "Loaded: " + std::to_string(stats.bytesLoaded >> 20) + " MB, written: " + std::to_string(stats.writes) + " entries";
+                pGui->addText(text.c_str());
+            }
+            if (group) pGui->endGroup();
+        }
+    }
+}
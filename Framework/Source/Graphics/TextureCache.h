@@ -0,0 +1,95 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "API/Texture.h"
+
+namespace Falcor
+{
+    class Gui;
+
+    /** Derived-data cache for textures loaded from image files.
+        Cooked textures, in their final format and with all their mips, are stored as DDS files named after a hash of the source file content and the processing options. Loading the same file with the same options again memory-maps the DDS and uploads it directly, skipping image decoding, mip generation and block compression.
+        Entries are written to a temporary file and renamed into place, so an interrupted or concurrent writer never leaves a partial entry behind.
+        The cache is disabled until a directory is set, either with setDirectory() or with the FALCOR_TEXTURE_CACHE environment variable.
+    */
+    class TextureCache
+    {
+    public:
+        struct Stats
+        {
+            uint32_t hits = 0;              ///< Textures loaded from the cache
+            uint32_t misses = 0;            ///< Textures which had to be cooked
+            uint32_t writes = 0;            ///< Entries added to the cache
+            uint32_t entryCount = 0;        ///< Number of entries in the cache directory
+            uint64_t cacheSize = 0;         ///< Total size of the entries, in bytes
+            uint64_t bytesLoaded = 0;       ///< Bytes read from the cache
+        };
+
+        /** Set the cache directory. The directory is created if needed. An empty string disables the cache
+        */
+        static void setDirectory(const std::string& directory);
+
+        /** Get the cache directory. Empty if the cache is disabled
+        */
+        static const std::string& getDirectory();
+
+        /** Check if the cache is enabled
+        */
+        static bool isEnabled() { return getDirectory().size() != 0; }
+
+        /** Compute the key of a source file and its processing options
+            \param[in] filename The source file. If it can't be found relative to the current directory, the common directories are searched
+            \param[in] options The processing options, as a string. Loads with different options use different entries
+            \return The key, or an empty string if the file can't be read
+        */
+        static std::string getKey(const std::string& filename, const std::string& options);
+
+        /** Load a cooked texture
+            \return The texture, or nullptr if the key is not in the cache
+        */
+        static Texture::SharedPtr load(const std::string& key, Texture::BindFlags bindFlags);
+
+        /** Store a cooked 2D texture from CPU data
+            \param[in] pData All the mip levels, in the layout Texture::create2D() expects
+        */
+        static bool store(const std::string& key, uint32_t width, uint32_t height, ResourceFormat format, uint32_t mipLevels, const void* pData, size_t size);
+
+        /** Store a cooked 2D texture. The mips are read back from the GPU, which stalls until the texture is ready
+        */
+        static bool store(const std::string& key, const Texture* pTexture);
+
+        /** Get the cache statistics
+        */
+        static const Stats& getStats();
+
+        /** Render the statistics
+        */
+        static void renderUI(Gui* pGui, const char* group = nullptr);
+    };
+}
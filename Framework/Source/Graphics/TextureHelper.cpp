@@ -27,36 +27,17 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "TextureHelper.h"
+#include "TextureCache.h"
+#include "DdsFile.h"
 #include "API/Texture.h"
 #include "Utils/Bitmap.h"
 #include "Utils/DDSHeader.h"
-#include "Utils/BinaryFileStream.h"
 #include "Utils/StringUtils.h"
 
 static const bool kTopDown = true;
 
 namespace Falcor
 {
-    using namespace DdsHelper;
-
-    static const uint32_t kDdsMagicNumber = 0x20534444;
-
-	bool checkDdsChannelMask(const DdsHeader::PixelFormat& format, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
-	{
-        return (format.rMask == r && format.gMask == g && format.bMask == b && format.aMask == a);
-	}
-
-	uint32_t makeFourCC(char name[4])
-	{
-        uint32_t fourCC = 0;
-        for(uint32_t i = 0; i < 4; i++)
-        {
-            uint32_t shift = i * 8;
-            fourCC |= ((uint32_t)name[i]) << shift;
-        }
-        return fourCC;
-    }
-
 	ResourceFormat falcorFormatFromDXGIFormat(DXGI_FORMAT fmt) 
 	{
 		switch (fmt)
@@ -250,474 +231,141 @@ namespace Falcor
 		}
 	}
 
-    DXGI_FORMAT getRgbDxgiFormat(const DdsHeader::PixelFormat& format)
+    DXGI_FORMAT dxgiFormatFromFalcorFormat(ResourceFormat format)
     {
-        switch(format.bitcount)
+        // Search the inverse of falcorFormatFromDXGIFormat(), so that both directions stay in sync
+        for (uint32_t i = DXGI_FORMAT_UNKNOWN + 1; i <= DXGI_FORMAT_B4G4R4A4_UNORM; i++)
         {
-        case 32:
-            if(checkDdsChannelMask(format, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+            if (falcorFormatFromDXGIFormat((DXGI_FORMAT)i) == format)
             {
-                return DXGI_FORMAT_R8G8B8A8_UNORM;
+                return (DXGI_FORMAT)i;
             }
-
-            if(checkDdsChannelMask(format, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
-            {
-                return DXGI_FORMAT_B8G8R8A8_UNORM;
-            }
-
-            if(checkDdsChannelMask(format, 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
-            {
-                return DXGI_FORMAT_B8G8R8X8_UNORM;
-            }
-
-            if(checkDdsChannelMask(format, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
-            {
-                return DXGI_FORMAT_R10G10B10A2_UNORM;
-            }
-
-            if(checkDdsChannelMask(format, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
-            {
-                return DXGI_FORMAT_R16G16_UNORM;
-            }
-
-            if(checkDdsChannelMask(format, 0xffffffff, 0x00000000, 0x00000000, 0x00000000))
-            {
-                return DXGI_FORMAT_R32_FLOAT;
-            }
-            break;
-
-        case 16:
-            if(checkDdsChannelMask(format, 0x7c00, 0x03e0, 0x001f, 0x8000))
-            {
-                return DXGI_FORMAT_B5G5R5A1_UNORM;
-            }
-            if(checkDdsChannelMask(format, 0xf800, 0x07e0, 0x001f, 0x0000))
-            {
-                return DXGI_FORMAT_B5G6R5_UNORM;
-            }
-
-            if(checkDdsChannelMask(format, 0x0f00, 0x00f0, 0x000f, 0xf000))
-            {
-                return DXGI_FORMAT_B4G4R4A4_UNORM;
-            }
-            break;
         }
-        should_not_get_here();
         return DXGI_FORMAT_UNKNOWN;
     }
 
-    DXGI_FORMAT getLuminanceDxgiFormat(const DdsHeader::PixelFormat& format)
+    static Texture::SharedPtr createTextureFromDDSFile(const std::string& filename, bool generateMips, Texture::BindFlags bindFlags)
     {
-        switch(format.bitcount)
+        DdsFile::SharedPtr pFile = DdsFile::open(filename);
+        if (pFile == nullptr)
         {
-        case 16:
-            if(checkDdsChannelMask(format, 0x0000ffff, 0x00000000, 0x00000000, 0x00000000))
-            {
-                return DXGI_FORMAT_R16_UNORM;
-            }
-            if(checkDdsChannelMask(format, 0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
-            {
-                return DXGI_FORMAT_R8G8_UNORM;
-            }
-            break;
-        case 8:
-            if(checkDdsChannelMask(format, 0x000000ff, 0x00000000, 0x00000000, 0x00000000))
-            {
-                return DXGI_FORMAT_R8_UNORM;
-            }
-            break;
+            return nullptr;
         }
-        should_not_get_here();
-        return DXGI_FORMAT_UNKNOWN;
-    }
 
-    DXGI_FORMAT getDxgiAlphaFormat(const DdsHeader::PixelFormat& format)
-    {
-        switch(format.bitcount)
+        Texture::SharedPtr pTex = pFile->createTexture(bindFlags, generateMips);
+        if (pTex)
         {
-        case 8:
-            return DXGI_FORMAT_A8_UNORM;
-        default:
-            should_not_get_here();
-            return DXGI_FORMAT_UNKNOWN;
+            pTex->setSourceFilename(stripDataDirectories(filename));
         }
+        return pTex;
     }
 
-    DXGI_FORMAT getDxgiBumpFormat(const DdsHeader::PixelFormat& format)
+	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
     {
-        switch(format.bitcount)
-        {
-        case 16:
-            if(checkDdsChannelMask(format, 0x00ff, 0xff00, 0x0000, 0x0000))
-            {
-                return DXGI_FORMAT_R8G8_SNORM;
-            }
-            break;
-        case 32:
-            if(checkDdsChannelMask(format, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
-            {
-                return DXGI_FORMAT_R8G8B8A8_SNORM;
-            }
-            if(checkDdsChannelMask(format, 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
-            {
-                return DXGI_FORMAT_R16G16_SNORM;
-            }
-            break;
-        }
-        should_not_get_here();
-        return DXGI_FORMAT_UNKNOWN;
+#define no_srgb()   \
+    if(loadAsSrgb)  \
+    {               \
+        logWarning("createTexture2DFromFile() warning. " + std::to_string(pBitmap->getBytesPerPixel()) + " channel images doesn't have a matching sRGB format. Loading in linear space.");  \
     }
+			
+		if (hasSuffix(filename, ".dds"))
+		{
+			return createTextureFromDDSFile(filename, generateMipLevels, bindFlags);
+		}
 
-    DXGI_FORMAT getDxgiFormatFrom4CC(uint32_t fourCC)
-    {
-        if(fourCC == makeFourCC("DXT1"))
-        {
-            return DXGI_FORMAT_BC1_UNORM;
-        }
-        if(fourCC == makeFourCC("DXT2"))
-        {
-            return DXGI_FORMAT_BC2_UNORM;
-        }
-        if(fourCC == makeFourCC("DXT3"))
-        {
-            return DXGI_FORMAT_BC2_UNORM;
-        }
-        if(fourCC == makeFourCC("DXT4"))
-        {
-            return DXGI_FORMAT_BC3_UNORM;
-        }
-        if(fourCC == makeFourCC("DXT5"))
-        {
-            return DXGI_FORMAT_BC3_UNORM;
-        }
-
-        if(fourCC == makeFourCC("ATI1"))
-        {
-            return DXGI_FORMAT_BC4_UNORM;
-        }
-        if(fourCC == makeFourCC("BC4U"))
+        // The cached texture already has its mips, so it doesn't go through generateMips()
+        std::string cacheKey;
+        if (TextureCache::isEnabled())
         {
-            return DXGI_FORMAT_BC4_UNORM;
-        }
-        if(fourCC == makeFourCC("BC4S"))
-        {
-            return DXGI_FORMAT_BC4_SNORM;
+            cacheKey = TextureCache::getKey(filename, std::string("raw") + (generateMipLevels ? ",mips" : "") + (loadAsSrgb ? ",srgb" : ""));
+            Texture::SharedPtr pCached = TextureCache::load(cacheKey, bindFlags);
+            if (pCached)
+            {
+                pCached->setSourceFilename(stripDataDirectories(filename));
+                return pCached;
+            }
         }
 
-        if(fourCC == makeFourCC("ATI2"))
-        {
-            return DXGI_FORMAT_BC5_UNORM;
-        }
-        if(fourCC == makeFourCC("BC5U"))
-        {
-            return DXGI_FORMAT_BC5_UNORM;
-        }
-        if(fourCC == makeFourCC("BC5S"))
-        {
-            return DXGI_FORMAT_BC5_SNORM;
-        }
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
+        Texture::SharedPtr pTex;
 
-        if(fourCC == makeFourCC("RGBG"))
-        {
-            return DXGI_FORMAT_R8G8_B8G8_UNORM;
-        }
-        if(fourCC == makeFourCC("GRGB"))
+        if(pBitmap)
         {
-            return DXGI_FORMAT_G8R8_G8B8_UNORM;
-        }
+            ResourceFormat texFormat = pBitmap->getFormat();
+            if(loadAsSrgb)
+            {
+                texFormat = linearToSrgbFormat(texFormat);
+            }
 
-        if(fourCC == makeFourCC("YUY2"))
-        {
-            return DXGI_FORMAT_YUY2;
-        }
+            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
+            pTex->setSourceFilename(stripDataDirectories(filename));
 
-        switch(fourCC)
-        {
-        case 36:
-            return DXGI_FORMAT_R16G16B16A16_UNORM;
-        case 110:
-            return DXGI_FORMAT_R16G16B16A16_SNORM;
-        case 111:
-            return DXGI_FORMAT_R16_FLOAT;
-        case 112:
-            return DXGI_FORMAT_R16G16_FLOAT;
-        case 113:
-            return DXGI_FORMAT_R16G16B16A16_FLOAT;
-        case 114:
-            return DXGI_FORMAT_R32_FLOAT;
-        case 115:
-            return DXGI_FORMAT_R32G32_FLOAT;
-        case 116:
-            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+            if (cacheKey.size())
+            {
+                TextureCache::store(cacheKey, pTex.get());
+            }
         }
-
-        should_not_get_here();
-        return DXGI_FORMAT_UNKNOWN;
+        return pTex;
     }
 
-    DXGI_FORMAT getDxgiFormatFromPixelFormat(const DdsHeader::PixelFormat& format)
-	{
-        if(format.flags & DdsHeader::PixelFormat::kRgbMask)
-		{
-            return getRgbDxgiFormat(format);
-		}
-		else if (format.flags & DdsHeader::PixelFormat::kLuminanceMask)
-		{
-            return getLuminanceDxgiFormat(format);
-		}
-        else if(format.flags & DdsHeader::PixelFormat::kAlphaMask)
-		{
-            return getDxgiAlphaFormat(format);
-		}
-		else if (format.flags & DdsHeader::PixelFormat::kBumpMask)
-		{
-            return getDxgiBumpFormat(format);
-		}
-        else if(format.flags & DdsHeader::PixelFormat::kFourCCFlag)
-		{
-            return getDxgiFormatFrom4CC(format.fourCC);
-		}
-
-		return DXGI_FORMAT_UNKNOWN;
-	}
-
-	ResourceFormat getDdsResourceFormat(const DdsData& data)
-	{
-		if(data.hasDX10Header)
-		{
-			return falcorFormatFromDXGIFormat(data.dx10Header.dxgiFormat);
-		}
-		else
-		{
-			return falcorFormatFromDXGIFormat(getDxgiFormatFromPixelFormat(data.header.pixelFormat));
-		}
-	}
-
-	//Flip the data so it follows opengl conventions
-	void flipData(DdsData& ddsData, ResourceFormat format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipDepth, bool isCubemap = false)
-	{
-		if (!isCompressedFormat(format) && !kTopDown)
-		{
-			std::vector<uint8_t> oldData(ddsData.data.size());
-			oldData.swap(ddsData.data);
-			const uint8_t* currentTexture = oldData.data();
-			const uint8_t* currentDepth = oldData.data();
-			uint8_t* currentPos = ddsData.data.data();
-
-			for (uint32_t mipCounter = 0; mipCounter < mipDepth; ++mipCounter)
-			{
-				uint32_t heightPitch = max(width >> mipCounter, 1U) * getFormatBytesPerBlock(format);
-				uint32_t currentMipHeight = max(height >> mipCounter, 1U);
-				uint32_t depthPitch = currentMipHeight * heightPitch;	
-
-				for (uint32_t depthCounter = 0; depthCounter < depth; ++depthCounter)
-				{
-					currentTexture = currentDepth + depthPitch * depthCounter;
-					
-					if (isCubemap)
-					{
-						if (depthCounter % 6 == 2)
-						{
-							currentTexture += depthPitch;
-						}
-						else if (depthCounter % 6 == 3)
-						{
-							currentTexture -= depthPitch;
-						}
-					}
-					
-					for (uint32_t heightCounter = 1; heightCounter <= currentMipHeight; ++heightCounter)
-					{
-						memcpy(currentPos, currentTexture + (currentMipHeight - heightCounter) * heightPitch, heightPitch);
-						currentPos += heightPitch;
-					}
-					
-				}
-
-				currentDepth += depthPitch * depth;
-			}
-		}
-	}
-
-	void loadDDSDataFromFile(const std::string filename, DdsData& ddsData)
-	{
-        std::string fullpath;
-		if (findFileInDataDirectories(filename, fullpath) == false)
-		{
-			logError(std::string("Can't find texture file ") + filename);
-			//could not find file
-			return;
-		}
-
-		BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
-
-		//check the dds identifier
-		uint32_t ddsIdentifier;
-		stream >> ddsIdentifier;
-		if (ddsIdentifier != kDdsMagicNumber)
-		{
-			//not valid dds file apparently
-			logError(std::string("The dds file ") + filename + std::string(" is not a valid dds file"));
-			return;
-		}
-
-        stream >> ddsData.header;
-
-        if((ddsData.header.pixelFormat.flags & DdsHeader::PixelFormat::kFourCCFlag) && (makeFourCC("DX10") == ddsData.header.pixelFormat.fourCC))
-		{
-            ddsData.hasDX10Header = true;
-            stream >> ddsData.dx10Header;
-		}
-		else
-		{
-            ddsData.hasDX10Header = false;
-		}
-
-        uint32_t dataSize = stream.getRemainingStreamSize();
-        ddsData.data.resize(dataSize);
-        stream.read(ddsData.data.data(), dataSize);
-	}
-
-    static ResourceFormat convertBgrxFormatToBgra(DdsData& ddsData, ResourceFormat format)
+    Texture::SharedPtr createCompressedTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, bool isNormalMap, BlockCompression::Quality quality, Texture::BindFlags bindFlags)
     {
-#ifdef FALCOR_VK
-        switch (format)
+        if (hasSuffix(filename, ".dds"))
         {
-        case ResourceFormat::BGRX8Unorm:
-            format = ResourceFormat::BGRA8Unorm;
-            break;
-        case ResourceFormat::BGRA8UnormSrgb:
-            format = ResourceFormat::BGRA8UnormSrgb;
-            break;
-        default:
-            return format;
+            return createTextureFromDDSFile(filename, generateMipLevels, bindFlags);
         }
 
-        for (size_t i = 3; i < ddsData.data.size(); i+=4)
+        std::string cacheKey;
+        if (TextureCache::isEnabled())
         {
-            ddsData.data[i] = 0xFF;
+            const std::string options = std::string("bc,q") + std::to_string((uint32_t)quality) + (generateMipLevels ? ",mips" : "") + (loadAsSrgb ? ",srgb" : "") + (isNormalMap ? ",normal" : "");
+            cacheKey = TextureCache::getKey(filename, options);
+            Texture::SharedPtr pCached = TextureCache::load(cacheKey, bindFlags);
+            if (pCached)
+            {
+                pCached->setSourceFilename(stripDataDirectories(filename));
+                return pCached;
+            }
         }
-#endif
-        return format;
-    }
-
-    Texture::SharedPtr createTextureFromDx10Dds(DdsData& ddsData, const std::string& filename, ResourceFormat format, uint32_t mipLevels, Texture::BindFlags bindFlags)
-    {
-        format = convertBgrxFormatToBgra(ddsData, format);
-
-        uint32_t arraySize = ddsData.dx10Header.arraySize;
-        assert(arraySize > 0);
 
-        switch(ddsData.dx10Header.resourceDimension)
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
+        if (pBitmap == nullptr)
         {
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE1D:
-            return Texture::create1D(ddsData.header.width, format, arraySize, mipLevels, ddsData.data.data(), bindFlags);
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE2D:
-            if(ddsData.dx10Header.miscFlag & DdsHeaderDX10::kCubeMapMask)
-            {
-                flipData(ddsData, format, ddsData.header.width, ddsData.header.height, 6 * arraySize, mipLevels == Texture::kMaxPossible ? 1 : mipLevels, true);
-                return Texture::createCube(ddsData.header.width, ddsData.header.height, format, arraySize, mipLevels, ddsData.data.data(), bindFlags);
-            }
-            else
-            {
-                flipData(ddsData, format, ddsData.header.width, ddsData.header.height, arraySize, mipLevels == Texture::kMaxPossible ? 1 : mipLevels);
-                return Texture::create2D(ddsData.header.width, ddsData.header.height, format, arraySize, mipLevels, ddsData.data.data(), bindFlags);
-            }
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE3D:
-            flipData(ddsData, format, ddsData.header.width, ddsData.header.height, ddsData.header.depth, mipLevels == Texture::kMaxPossible ? 1 : mipLevels);
-            return Texture::create3D(ddsData.header.width, ddsData.header.height, ddsData.header.depth, format, mipLevels, ddsData.data.data(), bindFlags);
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_BUFFER:
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_UNKNOWN:
-            //these file formats are not supported 
-            logError(std::string("the resource dimension specified in ") + filename + std::string(" is not supported by Falcor"));
-        default:
-            should_not_get_here();
             return nullptr;
         }
-    }
-
-    Texture::SharedPtr createTextureFromLegacyDds(DdsData& ddsData, const std::string& filename, ResourceFormat format, uint32_t mipLevels, Texture::BindFlags bindFlags)
-    {
-        format = convertBgrxFormatToBgra(ddsData, format);
 
-        //load the volume or 3D texture
-        if(ddsData.header.flags & DdsHeader::kDepthMask)
+        const uint32_t width = pBitmap->getWidth();
+        const uint32_t height = pBitmap->getHeight();
+        const ResourceFormat srcFormat = pBitmap->getFormat();
+        const bool hasAlpha = BlockCompression::hasAlpha(pBitmap->getData(), width, height, srcFormat);
+        ResourceFormat texFormat = BlockCompression::chooseFormat(srcFormat, hasAlpha, isNormalMap, quality);
+        if (loadAsSrgb)
         {
-            flipData(ddsData, format, ddsData.header.width, ddsData.header.height, ddsData.header.depth, mipLevels == Texture::kMaxPossible ? 1 : mipLevels);
-            return Texture::create3D(ddsData.header.width, ddsData.header.height, ddsData.header.depth, format, mipLevels, ddsData.data.data(), bindFlags);
+            texFormat = linearToSrgbFormat(texFormat);
         }
-        //load the cubemap texture
-        else if(ddsData.header.caps[1] & DdsHeader::kCaps2CubeMapMask)
+
+        // Compressed textures can't generate mips on the GPU, so the encoder builds the whole chain
+        std::vector<uint8_t> blocks;
+        uint32_t mipLevels = 0;
+        if (texFormat != ResourceFormat::Unknown)
         {
-            return Texture::createCube(ddsData.header.width, ddsData.header.height, format, 1, mipLevels, ddsData.data.data(), bindFlags);
+            mipLevels = BlockCompression::encode(pBitmap->getData(), width, height, srcFormat, texFormat, quality, generateMipLevels ? Texture::kMaxPossible : 1, blocks, isNormalMap);
         }
-        //This is a 2D Texture
-        else
+
+        if (mipLevels == 0)
         {
-            flipData(ddsData, format, ddsData.header.width, ddsData.header.height, 1, mipLevels == Texture::kMaxPossible ? 1 : mipLevels);
-            return Texture::create2D(ddsData.header.width, ddsData.header.height, format, 1, mipLevels, ddsData.data.data(), bindFlags);
+            logWarning("createCompressedTextureFromFile() - can't compress '" + filename + "', loading it uncompressed.");
+            return createTextureFromFile(filename, generateMipLevels, loadAsSrgb, bindFlags);
         }
 
-        should_not_get_here();
-        return nullptr;
-    }
-
-	Texture::SharedPtr createTextureFromDDSFile(const std::string filename, bool generateMips, Texture::BindFlags bindFlags)
-	{
-		DdsData ddsData;
-		loadDDSDataFromFile(filename, ddsData);
-		
-		ResourceFormat format = getDdsResourceFormat(ddsData);
-		assert(format != ResourceFormat::Unknown);
-
-		uint32_t mipLevels;
-		if (generateMips)
-		{
-			mipLevels = Texture::kMaxPossible;
-		} 
-		else
-		{
-			mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
-		}
-	
-		if (ddsData.hasDX10Header)
-		{
-            return createTextureFromDx10Dds(ddsData, filename, format, mipLevels, bindFlags);
-		}
-		else
-		{
-            return createTextureFromLegacyDds(ddsData, filename, format, mipLevels, bindFlags);
-		}
-		
-		return nullptr;
-	}
-
-	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
-    {
-#define no_srgb()   \
-    if(loadAsSrgb)  \
-    {               \
-        logWarning("createTexture2DFromFile() warning. " + std::to_string(pBitmap->getBytesPerPixel()) + " channel images doesn't have a matching sRGB format. Loading in linear space.");  \
-    }
-			
-		if (hasSuffix(filename, ".dds"))
-		{
-			return createTextureFromDDSFile(filename, generateMipLevels, bindFlags);
-		}
-
-        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
-        Texture::SharedPtr pTex;
-
-        if(pBitmap)
+        Texture::SharedPtr pTex = Texture::create2D(width, height, texFormat, 1, mipLevels, blocks.data(), bindFlags);
+        if (pTex)
         {
-            ResourceFormat texFormat = pBitmap->getFormat();
-            if(loadAsSrgb)
+            pTex->setSourceFilename(stripDataDirectories(filename));
+            if (cacheKey.size())
             {
-                texFormat = linearToSrgbFormat(texFormat);
+                TextureCache::store(cacheKey, width, height, texFormat, mipLevels, blocks.data(), blocks.size());
             }
-
-            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
-            pTex->setSourceFilename(stripDataDirectories(filename));
         }
         return pTex;
     }
@@ -28,6 +28,7 @@
 #pragma once
 #include <string>
 #include "API/Texture.h"
+#include "Utils/BlockCompression.h"
 namespace Falcor
 {
     /*!
@@ -42,6 +43,17 @@ namespace Falcor
         \param[in] bindFlags The bind flags to create the texture with
     */
 	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+    /** create a new block-compressed texture from a file. Uncompressed images are encoded on the CPU, see BlockCompression. DDS files are loaded as-is.
+        If the image format can't be compressed or its size isn't a multiple of 4, the texture is created uncompressed.
+        \param[in] Filename Filename
+        \param[in] generateMipLevels true is mip-chain should be generated, otherwise false. The mips are generated on the CPU before encoding
+        \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for BC1, BC3 and BC7
+        \param[in] isNormalMap The texture is a tangent-space normal map. It is encoded as BC5, and the shader reconstructs Z
+        \param[in] quality The encoder quality preset
+        \param[in] bindFlags The bind flags to create the texture with
+    */
+    Texture::SharedPtr createCompressedTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, bool isNormalMap, BlockCompression::Quality quality = BlockCompression::Quality::Normal, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
     
     /*! @} */
 }
\ No newline at end of file
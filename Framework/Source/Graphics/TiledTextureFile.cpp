@@ -0,0 +1,321 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/TiledTextureFile.h"
+#include "Utils/Bitmap.h"
+#include "Utils/OS.h"
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMagic = 'F' | ('V' << 8) | ('T' << 16) | ('X' << 24);
+        const uint32_t kVersion = 1;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint32_t format;
+            uint32_t mipCount;
+            uint32_t pageSize;
+            uint32_t border;
+        };
+
+        bool isSupportedFormat(ResourceFormat format)
+        {
+            switch (format)
+            {
+            case ResourceFormat::RGBA8Unorm:
+            case ResourceFormat::RGBA8UnormSrgb:
+            case ResourceFormat::BGRA8Unorm:
+            case ResourceFormat::BGRA8UnormSrgb:
+            case ResourceFormat::RGBA32Float:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        float srgbToLinear(float c)
+        {
+            return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linearToSrgb(float c)
+        {
+            return (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+        }
+
+        // Mips are filtered in float. The channel order is kept, only the alpha channel is special
+        std::vector<glm::vec4> toFloat(const uint8_t* pSrc, uint32_t texelCount, ResourceFormat format)
+        {
+            std::vector<glm::vec4> dst(texelCount);
+            if (format == ResourceFormat::RGBA32Float)
+            {
+                memcpy(dst.data(), pSrc, texelCount * sizeof(glm::vec4));
+                return dst;
+            }
+
+            float table[256];
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                table[i] = isSrgbFormat(format) ? srgbToLinear(i / 255.0f) : i / 255.0f;
+            }
+            for (uint32_t i = 0; i < texelCount; i++)
+            {
+                const uint8_t* t = pSrc + i * 4;
+                dst[i] = glm::vec4(table[t[0]], table[t[1]], table[t[2]], t[3] / 255.0f);
+            }
+            return dst;
+        }
+
+        std::vector<uint8_t> fromFloat(const std::vector<glm::vec4>& src, ResourceFormat format)
+        {
+            std::vector<uint8_t> dst(src.size() * getFormatBytesPerBlock(format));
+            if (format == ResourceFormat::RGBA32Float)
+            {
+                memcpy(dst.data(), src.data(), dst.size());
+                return dst;
+            }
+
+            const bool srgb = isSrgbFormat(format);
+            for (size_t i = 0; i < src.size(); i++)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    float v = glm::clamp(src[i][c], 0.0f, 1.0f);
+                    if (srgb && c < 3) v = linearToSrgb(v);
+                    dst[i * 4 + c] = (uint8_t)(v * 255.0f + 0.5f);
+                }
+            }
+            return dst;
+        }
+
+        std::vector<glm::vec4> downsample(const std::vector<glm::vec4>& src, uint32_t width, uint32_t height)
+        {
+            uint32_t w = std::max(1u, width >> 1);
+            uint32_t h = std::max(1u, height >> 1);
+            std::vector<glm::vec4> dst(w * h);
+            for (uint32_t y = 0; y < h; y++)
+            {
+                uint32_t y0 = std::min(y * 2, height - 1);
+                uint32_t y1 = std::min(y * 2 + 1, height - 1);
+                for (uint32_t x = 0; x < w; x++)
+                {
+                    uint32_t x0 = std::min(x * 2, width - 1);
+                    uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                    dst[y * w + x] = 0.25f * (src[y0 * width + x0] + src[y0 * width + x1] + src[y1 * width + x0] + src[y1 * width + x1]);
+                }
+            }
+            return dst;
+        }
+    }
+
+    uint32_t TiledTextureFile::getMipCount(uint32_t width, uint32_t height, uint32_t pageSize)
+    {
+        uint32_t mipCount = 1;
+        while (std::max(width >> (mipCount - 1), height >> (mipCount - 1)) > pageSize)
+        {
+            mipCount++;
+        }
+        return mipCount;
+    }
+
+    bool TiledTextureFile::write(const std::string& filename, uint32_t width, uint32_t height, ResourceFormat format, const void* pData, uint32_t pageSize, uint32_t border)
+    {
+        if (isSupportedFormat(format) == false)
+        {
+            logError("TiledTextureFile::write() - unsupported format " + to_string(format));
+            return false;
+        }
+        if (width == 0 || height == 0 || pageSize == 0 || border >= pageSize)
+        {
+            logError("TiledTextureFile::write() - invalid dimensions");
+            return false;
+        }
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (file.fail())
+        {
+            logError("TiledTextureFile::write() - can't open " + filename + " for writing");
+            return false;
+        }
+
+        Header header;
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.width = width;
+        header.height = height;
+        header.format = (uint32_t)format;
+        header.mipCount = getMipCount(width, height, pageSize);
+        header.pageSize = pageSize;
+        header.border = border;
+        file.write((const char*)&header, sizeof(header));
+
+        const uint32_t bpp = getFormatBytesPerBlock(format);
+        const uint32_t physicalSize = pageSize + 2 * border;
+        std::vector<uint8_t> page(physicalSize * physicalSize * bpp);
+
+        std::vector<glm::vec4> mipFloat;
+        std::vector<uint8_t> mipData((const uint8_t*)pData, (const uint8_t*)pData + width * height * bpp);
+        uint32_t w = width;
+        uint32_t h = height;
+        for (uint32_t mip = 0; mip < header.mipCount; mip++)
+        {
+            if (mip > 0)
+            {
+                if (mipFloat.empty()) mipFloat = toFloat((const uint8_t*)pData, width * height, format);
+                mipFloat = downsample(mipFloat, w, h);
+                w = std::max(1u, w >> 1);
+                h = std::max(1u, h >> 1);
+                mipData = fromFloat(mipFloat, format);
+            }
+
+            const uint32_t pagesX = (w + pageSize - 1) / pageSize;
+            const uint32_t pagesY = (h + pageSize - 1) / pageSize;
+            for (uint32_t py = 0; py < pagesY; py++)
+            {
+                for (uint32_t px = 0; px < pagesX; px++)
+                {
+                    // Texels outside of the image are clamped to the edge
+                    for (uint32_t ty = 0; ty < physicalSize; ty++)
+                    {
+                        int32_t sy = glm::clamp((int32_t)(py * pageSize + ty) - (int32_t)border, 0, (int32_t)h - 1);
+                        for (uint32_t tx = 0; tx < physicalSize; tx++)
+                        {
+                            int32_t sx = glm::clamp((int32_t)(px * pageSize + tx) - (int32_t)border, 0, (int32_t)w - 1);
+                            memcpy(&page[(ty * physicalSize + tx) * bpp], &mipData[(sy * w + sx) * bpp], bpp);
+                        }
+                    }
+                    file.write((const char*)page.data(), page.size());
+                }
+            }
+        }
+
+        if (file.fail())
+        {
+            logError("TiledTextureFile::write() - failed writing " + filename);
+            return false;
+        }
+        return true;
+    }
+
+    bool TiledTextureFile::convert(const std::string& srcFilename, const std::string& dstFilename, bool loadAsSrgb, uint32_t pageSize, uint32_t border)
+    {
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(srcFilename, true);
+        if (pBitmap == nullptr)
+        {
+            return false;
+        }
+
+        ResourceFormat format = pBitmap->getFormat();
+        if (loadAsSrgb)
+        {
+            format = linearToSrgbFormat(format);
+        }
+        return write(dstFilename, pBitmap->getWidth(), pBitmap->getHeight(), format, pBitmap->getData(), pageSize, border);
+    }
+
+    TiledTextureFile::SharedPtr TiledTextureFile::open(const std::string& filename)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("TiledTextureFile::open() - can't find " + filename);
+            return nullptr;
+        }
+
+        size_t size = 0;
+        const uint8_t* pData = (const uint8_t*)mapFileForReading(fullpath, size);
+        if (pData == nullptr)
+        {
+            logError("TiledTextureFile::open() - can't read " + fullpath);
+            return nullptr;
+        }
+
+        SharedPtr pFile = SharedPtr(new TiledTextureFile);
+        pFile->mpData = pData;
+        pFile->mSize = size;
+
+        const Header* pHeader = (const Header*)pData;
+        if (size < sizeof(Header) || pHeader->magic != kMagic || pHeader->version != kVersion || pHeader->pageSize == 0 || isSupportedFormat((ResourceFormat)pHeader->format) == false
+            || pHeader->mipCount != getMipCount(pHeader->width, pHeader->height, pHeader->pageSize))
+        {
+            logError("TiledTextureFile::open() - " + fullpath + " is not a valid tiled texture");
+            return nullptr;
+        }
+
+        pFile->mWidth = pHeader->width;
+        pFile->mHeight = pHeader->height;
+        pFile->mFormat = (ResourceFormat)pHeader->format;
+        pFile->mMipCount = pHeader->mipCount;
+        pFile->mPageSize = pHeader->pageSize;
+        pFile->mBorder = pHeader->border;
+        pFile->mPageBytes = (size_t)pFile->getPhysicalPageSize() * pFile->getPhysicalPageSize() * getFormatBytesPerBlock(pFile->mFormat);
+
+        uint32_t pageCount = 0;
+        for (uint32_t mip = 0; mip < pFile->mMipCount; mip++)
+        {
+            uint32_t w = std::max(1u, pFile->mWidth >> mip);
+            uint32_t h = std::max(1u, pFile->mHeight >> mip);
+            pFile->mPagesX.push_back((w + pFile->mPageSize - 1) / pFile->mPageSize);
+            pFile->mFirstPage.push_back(pageCount);
+            pageCount += pFile->mPagesX.back() * ((h + pFile->mPageSize - 1) / pFile->mPageSize);
+        }
+        pFile->mFirstPage.push_back(pageCount);
+
+        if (size != sizeof(Header) + pageCount * pFile->mPageBytes)
+        {
+            logError("TiledTextureFile::open() - " + fullpath + " is truncated");
+            return nullptr;
+        }
+        return pFile;
+    }
+
+    TiledTextureFile::~TiledTextureFile()
+    {
+        if (mpData)
+        {
+            unmapFile(mpData);
+        }
+    }
+
+    bool TiledTextureFile::readPage(uint32_t mip, uint32_t pageX, uint32_t pageY, void* pDst) const
+    {
+        if (mip >= mMipCount || pageX >= mPagesX[mip]) return false;
+        uint32_t index = mFirstPage[mip] + pageY * mPagesX[mip] + pageX;
+        if (index >= mFirstPage[mip + 1]) return false;
+
+        memcpy(pDst, mpData + sizeof(Header) + index * mPageBytes, mPageBytes);
+        return true;
+    }
+}
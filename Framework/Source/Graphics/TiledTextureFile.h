@@ -0,0 +1,106 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include "API/Formats.h"
+
+namespace Falcor
+{
+    /** On-disk format of streamed virtual textures.
+        The file starts with a header, followed by the pages of every mip level: mip 0 first, each level in row-major page order. All pages have the same size - pageSize texels plus a border on each side, copied from the neighboring pages or clamped at the edges of the image - so a page can be filtered in an atlas without bleeding, and its offset is computed from its index.
+        The mip chain stops at the first level which fits in a single page. The file is memory-mapped, and readPage() is safe to call from any thread.
+    */
+    class TiledTextureFile
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TiledTextureFile>;
+        using SharedConstPtr = std::shared_ptr<const TiledTextureFile>;
+
+        static const uint32_t kDefaultPageSize = 128;
+        static const uint32_t kDefaultBorder = 4;
+
+        ~TiledTextureFile();
+
+        /** Convert an image file into a tiled file
+            \param[in] srcFilename The image to convert. If it can't be found relative to the current directory, the common directories are searched
+            \param[in] dstFilename The tiled file to create
+            \param[in] loadAsSrgb If true, the texels are interpreted as sRGB. Mips are filtered in linear space
+            \return true on success
+        */
+        static bool convert(const std::string& srcFilename, const std::string& dstFilename, bool loadAsSrgb, uint32_t pageSize = kDefaultPageSize, uint32_t border = kDefaultBorder);
+
+        /** Create a tiled file from mip 0 of an image. The other mips are generated with a box filter
+            \param[in] format The format of the data. 8-bit RGBA/BGRA formats and RGBA32Float are supported
+            \param[in] pData The texels of mip 0, top row first
+        */
+        static bool write(const std::string& filename, uint32_t width, uint32_t height, ResourceFormat format, const void* pData, uint32_t pageSize = kDefaultPageSize, uint32_t border = kDefaultBorder);
+
+        /** Open a tiled file
+            \return A new object, or nullptr if the file doesn't exist or is invalid
+        */
+        static SharedPtr open(const std::string& filename);
+
+        /** Get the number of mip levels needed to go from a width x height image to a level which fits in a single page
+        */
+        static uint32_t getMipCount(uint32_t width, uint32_t height, uint32_t pageSize);
+
+        /** Copy a page to pDst, which must hold getPageBytes() bytes
+            \return false if the page doesn't exist
+        */
+        bool readPage(uint32_t mip, uint32_t pageX, uint32_t pageY, void* pDst) const;
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        ResourceFormat getFormat() const { return mFormat; }
+        uint32_t getMipCount() const { return mMipCount; }
+        uint32_t getPageSize() const { return mPageSize; }
+        uint32_t getBorder() const { return mBorder; }
+
+        /** Get the size of a stored page in texels, including the borders
+        */
+        uint32_t getPhysicalPageSize() const { return mPageSize + 2 * mBorder; }
+        size_t getPageBytes() const { return mPageBytes; }
+
+    private:
+        TiledTextureFile() = default;
+
+        const uint8_t* mpData = nullptr;
+        size_t mSize = 0;
+        size_t mPageBytes = 0;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        uint32_t mMipCount = 0;
+        uint32_t mPageSize = 0;
+        uint32_t mBorder = 0;
+        ResourceFormat mFormat = ResourceFormat::Unknown;
+        std::vector<uint32_t> mFirstPage;   // Index of the first page of each mip, plus the total page count
+        std::vector<uint32_t> mPagesX;
+    };
+}
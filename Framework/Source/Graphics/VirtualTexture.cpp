@@ -0,0 +1,277 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/VirtualTexture.h"
+#include "Graphics/Camera/Camera.h"
+#include "API/CopyContext.h"
+#include "API/ProgramVars.h"
+#include "Utils/Gui.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kMaxAtlasSize = 16384;
+        const uint32_t kMaxInFlightPages = 64;
+    }
+
+    VirtualTexture::SharedPtr VirtualTexture::create(const std::string& filename, uint64_t memoryBudget, uint32_t loaderThreadCount)
+    {
+        TiledTextureFile::SharedPtr pFile = TiledTextureFile::open(filename);
+        if (pFile == nullptr)
+        {
+            return nullptr;
+        }
+        if (pFile->getMipCount() > VirtualTextureMaxMips)
+        {
+            logError("VirtualTexture::create() - " + filename + " has " + std::to_string(pFile->getMipCount()) + " levels, the maximum is " + std::to_string(VirtualTextureMaxMips));
+            return nullptr;
+        }
+
+        // Lay the slots out in a square-ish atlas
+        const uint32_t physicalSize = pFile->getPhysicalPageSize();
+        const uint32_t maxPagesPerRow = kMaxAtlasSize / physicalSize;
+        uint32_t slotCount = (uint32_t)std::min<uint64_t>(memoryBudget / pFile->getPageBytes(), maxPagesPerRow * maxPagesPerRow);
+        uint32_t pagesX = std::max(1u, (uint32_t)ceil(sqrt((double)slotCount)));
+        uint32_t pagesY = std::max(1u, slotCount / pagesX);
+        slotCount = pagesX * pagesY;
+
+        SharedPtr pTexture = SharedPtr(new VirtualTexture);
+        pTexture->mpFile = pFile;
+        pTexture->mpPageTable = VirtualTexturePageTable::create(pFile->getWidth(), pFile->getHeight(), pFile->getMipCount(), pFile->getPageSize(), slotCount);
+        if (pTexture->mpPageTable == nullptr)
+        {
+            logError("VirtualTexture::create() - the memory budget is too small for " + filename);
+            return nullptr;
+        }
+
+        pTexture->mpAtlas = Texture::create2D(pagesX * physicalSize, pagesY * physicalSize, pFile->getFormat(), 1, 1, nullptr, Resource::BindFlags::ShaderResource);
+        if (pTexture->mpAtlas == nullptr)
+        {
+            return nullptr;
+        }
+        pTexture->mpAtlas->setName(filename + " atlas");
+
+        // The page table stores the entries of all the levels back to back
+        VirtualTextureData& data = pTexture->mData;
+        data = {};
+        data.atlasInvWidth = 1.0f / pTexture->mpAtlas->getWidth();
+        data.atlasInvHeight = 1.0f / pTexture->mpAtlas->getHeight();
+        data.pageSize = pFile->getPageSize();
+        data.pageBorder = pFile->getBorder();
+        data.atlasPagesX = pagesX;
+        data.mipCount = pFile->getMipCount();
+        uint32_t entryCount = 0;
+        for (uint32_t mip = 0; mip < data.mipCount; mip++)
+        {
+            VirtualTextureMip& level = data.mips[mip];
+            level.firstEntry = entryCount;
+            level.pagesX = pTexture->mpPageTable->getPageCountX(mip);
+            level.width = std::max(1u, pFile->getWidth() >> mip);
+            level.height = std::max(1u, pFile->getHeight() >> mip);
+            entryCount += level.pagesX * pTexture->mpPageTable->getPageCountY(mip);
+        }
+        pTexture->mPageTableData.resize(entryCount, 0);
+        pTexture->mpPageTableBuffer = Buffer::create(entryCount * sizeof(uint32_t), Resource::BindFlags::ShaderResource, Buffer::CpuAccess::None, pTexture->mPageTableData.data());
+
+        for (uint32_t i = 0; i < std::max(1u, loaderThreadCount); i++)
+        {
+            pTexture->mLoaderThreads.push_back(std::thread(&VirtualTexture::loaderThread, pTexture.get()));
+        }
+        return pTexture;
+    }
+
+    VirtualTexture::~VirtualTexture()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        for (auto& t : mLoaderThreads)
+        {
+            t.join();
+        }
+    }
+
+    void VirtualTexture::loaderThread()
+    {
+        while (true)
+        {
+            LoadedPage loaded;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this] { return mStop || mLoadQueue.size(); });
+                if (mStop) return;
+                loaded.page = mLoadQueue.front();
+                mLoadQueue.pop_front();
+            }
+
+            // The file is memory-mapped, this is where the disk is actually read
+            loaded.data.resize(mpFile->getPageBytes());
+            loaded.success = mpFile->readPage(loaded.page.mip, loaded.page.x, loaded.page.y, loaded.data.data());
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCompleted.push_back(std::move(loaded));
+        }
+    }
+
+    void VirtualTexture::beginFrame()
+    {
+        mpPageTable->beginFrame();
+    }
+
+    void VirtualTexture::requestRegion(uint32_t mip, const glm::vec2& uvMin, const glm::vec2& uvMax)
+    {
+        mpPageTable->requestRegion(mip, uvMin, uvMax);
+    }
+
+    float VirtualTexture::estimateMipLevel(const BoundingBox& worldBox, const Camera* pCamera, uint32_t viewportHeight, const glm::vec2& uvExtent) const
+    {
+        const float radius = glm::length(worldBox.extent);
+        const float distance = glm::length(worldBox.center - pCamera->getPosition());
+        if (distance <= radius)
+        {
+            return 0;
+        }
+
+        // Projected diameter of the bounding sphere. proj[1][1] maps view-space height over depth to NDC, which spans the viewport height over 2 units
+        const float pixels = radius / distance * pCamera->getProjMatrix()[1][1] * viewportHeight;
+        const float texels = std::max(fabs(uvExtent.x) * mpFile->getWidth(), fabs(uvExtent.y) * mpFile->getHeight());
+        return log2(texels / std::max(pixels, 1.0f));
+    }
+
+    void VirtualTexture::requestForBounds(const BoundingBox& worldBox, const Camera* pCamera, uint32_t viewportHeight, const glm::vec2& uvMin, const glm::vec2& uvMax)
+    {
+        const float lod = estimateMipLevel(worldBox, pCamera, viewportHeight, uvMax - uvMin);
+        uint32_t mip = (uint32_t)glm::clamp(lod, 0.0f, (float)(mpPageTable->getMipCount() - 1));
+
+        // Don't let a single object take over the atlas, it would evict itself every frame
+        const glm::vec2 lo = glm::clamp(glm::min(uvMin, uvMax), glm::vec2(0), glm::vec2(1));
+        const glm::vec2 hi = glm::clamp(glm::max(uvMin, uvMax), glm::vec2(0), glm::vec2(1));
+        const uint32_t pageSize = mpPageTable->getPageSize();
+        while (mip + 1 < mpPageTable->getMipCount())
+        {
+            const VirtualTextureMip& level = mData.mips[mip];
+            uint32_t pagesX = (uint32_t)(hi.x * level.width) / pageSize - (uint32_t)(lo.x * level.width) / pageSize + 1;
+            uint32_t pagesY = (uint32_t)(hi.y * level.height) / pageSize - (uint32_t)(lo.y * level.height) / pageSize + 1;
+            if (pagesX * pagesY <= mpPageTable->getSlotCount() / 2) break;
+            mip++;
+        }
+        mpPageTable->requestRegion(mip, uvMin, uvMax);
+    }
+
+    void VirtualTexture::update(CopyContext* pContext, uint32_t maxUploads)
+    {
+        std::vector<LoadedPage> loaded;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (mCompleted.size() && loaded.size() < maxUploads)
+            {
+                loaded.push_back(std::move(mCompleted.front()));
+                mCompleted.pop_front();
+            }
+        }
+
+        // Copy the loaded pages to their slots
+        const uint32_t physicalSize = mpFile->getPhysicalPageSize();
+        mStats.uploadedPages = 0;
+        for (const LoadedPage& page : loaded)
+        {
+            mInFlight--;
+            if (page.success == false)
+            {
+                mpPageTable->onPageLoadFailed(page.page);
+                continue;
+            }
+
+            uint32_t slot = mpPageTable->onPageLoaded(page.page);
+            if (slot != VirtualTexturePageTable::kInvalidSlot)
+            {
+                uvec2 origin = uvec2(slot % mData.atlasPagesX, slot / mData.atlasPagesX) * physicalSize;
+                pContext->updateTextureRegion(mpAtlas.get(), 0, origin, uvec2(physicalSize), page.data.data());
+                mStats.uploadedPages++;
+            }
+        }
+
+        // Hand the new requests to the loader threads
+        std::vector<VirtualTexturePageTable::PageId> pages = mpPageTable->getPagesToLoad(kMaxInFlightPages - mInFlight);
+        if (pages.size())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mLoadQueue.insert(mLoadQueue.end(), pages.begin(), pages.end());
+            }
+            mCondition.notify_all();
+            mInFlight += (uint32_t)pages.size();
+        }
+
+        // Refresh the page table. The slots were written above, in the same command list, so the GPU never sees an entry before its data
+        if (mpPageTable->isDirty())
+        {
+            for (uint32_t mip = 0; mip < mData.mipCount; mip++)
+            {
+                const std::vector<uint32_t>& entries = mpPageTable->getEntries(mip);
+                std::copy(entries.begin(), entries.end(), mPageTableData.begin() + mData.mips[mip].firstEntry);
+            }
+            mpPageTableBuffer->updateData(mPageTableData.data(), 0, mPageTableData.size() * sizeof(uint32_t));
+            mpPageTable->clearDirty();
+        }
+
+        mStats.pageTable = mpPageTable->getStats();
+        mStats.queuedPages = mInFlight;
+    }
+
+    void VirtualTexture::setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const std::string& varName) const
+    {
+        size_t offset = pCB->getVariableOffset(varName + ".atlasInvWidth");
+        if (offset == ConstantBuffer::kInvalidOffset)
+        {
+            logWarning("VirtualTexture::setIntoProgramVars() - variable \"" + varName + "\" not found in constant buffer");
+            return;
+        }
+        pCB->setBlob(&mData, offset, sizeof(mData));
+        pVars->setTexture(varName + "Atlas", mpAtlas);
+        pVars->setRawBuffer(varName + "PageTable", mpPageTableBuffer);
+    }
+
+    void VirtualTexture::renderUI(Gui* pGui, const char* group)
+    {
+        if (group == nullptr || pGui->beginGroup(group))
+        {
+            const VirtualTexturePageTable::Stats& stats = mStats.pageTable;
+            std::string text = std::to_string(mpFile->getWidth()) + "x" + std::to_string(mpFile->getHeight()) + ", " + std::to_string(mData.mipCount) + " levels, ";
+            text += std::to_string(mpPageTable->getSlotCount()) + " slots (" + std::to_string((mpPageTable->getSlotCount() * mpFile->getPageBytes()) >> 20) + " MB)\n";
+            text += "Resident: " + std::to_string(stats.residentCount) + ", requested: " + std::to_string(stats.requestedCount) + ", queued: " + std::to_string(mStats.queuedPages) + "\n";
+            text += "Uploaded this frame: " + std::to_string(mStats.uploadedPages) + "\n";
+            text += "Loaded: " + std::to_string(stats.loadedCount) + ", evicted: " + std::to_string(stats.evictedCount) + ", dropped: " + std::to_string(stats.droppedCount);
+            pGui->addText(text.c_str());
+            if (group) pGui->endGroup();
+        }
+    }
+}
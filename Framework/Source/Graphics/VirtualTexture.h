@@ -0,0 +1,146 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/VirtualTexturePageTable.h"
+#include "Graphics/TiledTextureFile.h"
+#include "API/Texture.h"
+#include "API/Buffer.h"
+#include "Utils/AABB.h"
+#include "Data/HostDeviceData.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Falcor
+{
+    class Camera;
+    class CopyContext;
+    class ConstantBuffer;
+    class ProgramVars;
+    class Gui;
+
+    /** Streamed virtual texture.
+        The texture is stored on disk as a TiledTextureFile. Only the pages the renderer needs are kept in GPU memory, in a fixed-size atlas sized from a memory budget. A page table, stored in a raw buffer, points every page of every level to the finest resident page covering it, so shaders always sample something while finer pages stream in (see ShadingUtils/VirtualTexture.slang).
+        Residency is decided on the CPU by a VirtualTexturePageTable, from footprints estimated with the screen size of the objects using the texture. Pages are read by background threads and uploaded on the next update(); the least recently used pages are evicted when the atlas is full.
+        Hardware sparse residency (Texture::setSparseResidencyPageIndex()) is not implemented by the D3D12 backend, hence the atlas.
+        Per frame: beginFrame(), then request the visible footprints, then update().
+    */
+    class VirtualTexture
+    {
+    public:
+        using SharedPtr = std::shared_ptr<VirtualTexture>;
+        using SharedConstPtr = std::shared_ptr<const VirtualTexture>;
+
+        static const uint64_t kDefaultMemoryBudget = 64 * 1024 * 1024;
+
+        struct Stats
+        {
+            VirtualTexturePageTable::Stats pageTable;
+            uint32_t uploadedPages = 0;     ///< Pages copied to the atlas by the last update()
+            uint32_t queuedPages = 0;       ///< Pages waiting for or being read by the loader threads
+        };
+
+        /** Open a tiled texture for streaming
+            \param[in] filename A file created with TiledTextureFile
+            \param[in] memoryBudget Size of the page atlas, in bytes
+            \param[in] loaderThreadCount Number of background threads reading pages
+            \return A new object, or nullptr if the file can't be opened or the budget can't hold the coarsest level
+        */
+        static SharedPtr create(const std::string& filename, uint64_t memoryBudget = kDefaultMemoryBudget, uint32_t loaderThreadCount = 2);
+        ~VirtualTexture();
+
+        /** Start a new frame. Call before the requests
+        */
+        void beginFrame();
+
+        /** Request the pages of a level overlapping a UV rectangle
+        */
+        void requestRegion(uint32_t mip, const glm::vec2& uvMin, const glm::vec2& uvMax);
+
+        /** Request the pages an object needs, from its screen size. The level is chosen so that a texel covers about a pixel. If the object is so close that the pages of the region would fill more than half of the atlas, a coarser level is requested instead.
+            The caller is responsible for skipping objects outside of the view.
+            \param[in] worldBox The world-space bounds of the object
+            \param[in] pCamera The camera the object is viewed from
+            \param[in] viewportHeight Height of the render target, in pixels
+            \param[in] uvMin, uvMax The UV range the object maps
+        */
+        void requestForBounds(const BoundingBox& worldBox, const Camera* pCamera, uint32_t viewportHeight, const glm::vec2& uvMin = glm::vec2(0), const glm::vec2& uvMax = glm::vec2(1));
+
+        /** Estimate the level of detail an object needs, from its screen size. Returns a fractional level, which can be negative if the texture is magnified
+        */
+        float estimateMipLevel(const BoundingBox& worldBox, const Camera* pCamera, uint32_t viewportHeight, const glm::vec2& uvExtent = glm::vec2(1)) const;
+
+        /** Upload the pages which finished loading, queue the new requests and refresh the page table
+            \param[in] maxUploads The maximum number of pages copied to the atlas. The other loaded pages are kept for the next frames
+        */
+        void update(CopyContext* pContext, uint32_t maxUploads = 32);
+
+        /** Bind the texture. The VirtualTextureData struct is written at varName in the constant buffer, the atlas is bound to the texture <varName>Atlas and the page table to the ByteAddressBuffer <varName>PageTable
+        */
+        void setIntoProgramVars(ProgramVars* pVars, ConstantBuffer* pCB, const std::string& varName) const;
+
+        const Texture::SharedPtr& getAtlas() const { return mpAtlas; }
+        const Buffer::SharedPtr& getPageTableBuffer() const { return mpPageTableBuffer; }
+        VirtualTexturePageTable::SharedConstPtr getPageTable() const { return mpPageTable; }
+        TiledTextureFile::SharedConstPtr getFile() const { return mpFile; }
+        const VirtualTextureData& getData() const { return mData; }
+        const Stats& getStats() const { return mStats; }
+
+        /** Render the streaming statistics
+        */
+        void renderUI(Gui* pGui, const char* group = nullptr);
+
+    private:
+        VirtualTexture() = default;
+        void loaderThread();
+
+        struct LoadedPage
+        {
+            VirtualTexturePageTable::PageId page;
+            std::vector<uint8_t> data;
+            bool success = false;
+        };
+
+        TiledTextureFile::SharedPtr mpFile;
+        VirtualTexturePageTable::SharedPtr mpPageTable;
+        Texture::SharedPtr mpAtlas;
+        Buffer::SharedPtr mpPageTableBuffer;
+        std::vector<uint32_t> mPageTableData;
+        VirtualTextureData mData;
+        Stats mStats;
+
+        std::vector<std::thread> mLoaderThreads;
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<VirtualTexturePageTable::PageId> mLoadQueue;
+        std::deque<LoadedPage> mCompleted;
+        uint32_t mInFlight = 0;
+        bool mStop = false;
+    };
+}
@@ -0,0 +1,354 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/VirtualTexturePageTable.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    VirtualTexturePageTable::SharedPtr VirtualTexturePageTable::create(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t pageSize, uint32_t slotCount)
+    {
+        if (width == 0 || height == 0 || mipCount == 0 || pageSize == 0)
+        {
+            logError("VirtualTexturePageTable::create() - invalid texture dimensions");
+            return nullptr;
+        }
+        if (mipCount > kEntryMipMask + 1 || slotCount > kEntrySlotMask)
+        {
+            logError("VirtualTexturePageTable::create() - too many mip levels or slots");
+            return nullptr;
+        }
+
+        SharedPtr pTable = SharedPtr(new VirtualTexturePageTable);
+        pTable->mPageSize = pageSize;
+        pTable->mMips.resize(mipCount);
+        pTable->mEntries.resize(mipCount);
+        uint32_t pageCount = 0;
+        for (uint32_t m = 0; m < mipCount; m++)
+        {
+            Mip& mip = pTable->mMips[m];
+            mip.width = std::max(1u, width >> m);
+            mip.height = std::max(1u, height >> m);
+            mip.pagesX = (mip.width + pageSize - 1) / pageSize;
+            mip.pagesY = (mip.height + pageSize - 1) / pageSize;
+            mip.firstPage = pageCount;
+            pageCount += mip.pagesX * mip.pagesY;
+            pTable->mEntries[m].assign(mip.pagesX * mip.pagesY, 0);
+        }
+
+        const Mip& coarsest = pTable->mMips.back();
+        if (slotCount <= coarsest.pagesX * coarsest.pagesY)
+        {
+            logError("VirtualTexturePageTable::create() - " + std::to_string(slotCount) + " slots can't hold the " + std::to_string(coarsest.pagesX * coarsest.pagesY) + " pinned pages of the coarsest level and stream anything else");
+            return nullptr;
+        }
+
+        pTable->mPages.resize(pageCount);
+        pTable->mSlotOwner.assign(slotCount, (uint32_t)kInvalidSlot);
+        pTable->mFreeSlots.resize(slotCount);
+        for (uint32_t s = 0; s < slotCount; s++)
+        {
+            // Hand out the low slots first
+            pTable->mFreeSlots[s] = slotCount - 1 - s;
+        }
+        return pTable;
+    }
+
+    VirtualTexturePageTable::PageId VirtualTexturePageTable::getPageId(uint32_t index) const
+    {
+        PageId page;
+        while (page.mip + 1 < mMips.size() && mMips[page.mip + 1].firstPage <= index)
+        {
+            page.mip++;
+        }
+        const Mip& mip = mMips[page.mip];
+        page.x = (index - mip.firstPage) % mip.pagesX;
+        page.y = (index - mip.firstPage) / mip.pagesX;
+        return page;
+    }
+
+    bool VirtualTexturePageTable::isValid(const PageId& page) const
+    {
+        return page.mip < mMips.size() && page.x < mMips[page.mip].pagesX && page.y < mMips[page.mip].pagesY;
+    }
+
+    void VirtualTexturePageTable::lruRemove(uint32_t index)
+    {
+        Page& p = mPages[index];
+        if (p.lruPrev != kInvalidSlot) mPages[p.lruPrev].lruNext = p.lruNext;
+        else mLruHead = p.lruNext;
+        if (p.lruNext != kInvalidSlot) mPages[p.lruNext].lruPrev = p.lruPrev;
+        else mLruTail = p.lruPrev;
+        p.lruPrev = p.lruNext = kInvalidSlot;
+    }
+
+    void VirtualTexturePageTable::lruPushFront(uint32_t index)
+    {
+        Page& p = mPages[index];
+        p.lruPrev = kInvalidSlot;
+        p.lruNext = mLruHead;
+        if (mLruHead != kInvalidSlot) mPages[mLruHead].lruPrev = index;
+        mLruHead = index;
+        if (mLruTail == kInvalidSlot) mLruTail = index;
+    }
+
+    void VirtualTexturePageTable::touch(uint32_t index)
+    {
+        Page& p = mPages[index];
+        p.lastUsedFrame = mFrame;
+        if (p.state == State::Resident && mLruHead != index && index < mMips.back().firstPage)
+        {
+            lruRemove(index);
+            lruPushFront(index);
+        }
+    }
+
+    void VirtualTexturePageTable::beginFrame()
+    {
+        mFrame++;
+        mRequests.clear();
+        mStats.requestedCount = 0;
+
+        const Mip& coarsest = mMips.back();
+        for (uint32_t y = 0; y < coarsest.pagesY; y++)
+        {
+            for (uint32_t x = 0; x < coarsest.pagesX; x++)
+            {
+                PageId page;
+                page.mip = (uint32_t)mMips.size() - 1;
+                page.x = x;
+                page.y = y;
+                requestPage(page);
+            }
+        }
+    }
+
+    void VirtualTexturePageTable::requestPage(const PageId& page)
+    {
+        if (isValid(page) == false) return;
+
+        // Walk up the pyramid. The ancestors are the fallbacks used while the page loads, keep them warm too
+        PageId p = page;
+        while (true)
+        {
+            uint32_t index = getPageIndex(p);
+            Page& entry = mPages[index];
+            if (entry.requestedFrame == mFrame)
+            {
+                // Already handled this frame, and so were its ancestors
+                break;
+            }
+            entry.requestedFrame = mFrame;
+            touch(index);
+            if (entry.state == State::NotResident)
+            {
+                mRequests.push_back(index);
+                mStats.requestedCount++;
+            }
+
+            if (p.mip + 1 == mMips.size()) break;
+            p.mip++;
+            p.x >>= 1;
+            p.y >>= 1;
+        }
+    }
+
+    void VirtualTexturePageTable::requestRegion(uint32_t mip, const glm::vec2& uvMin, const glm::vec2& uvMax)
+    {
+        mip = std::min(mip, (uint32_t)mMips.size() - 1);
+        const Mip& m = mMips[mip];
+        glm::vec2 lo = glm::clamp(glm::min(uvMin, uvMax), glm::vec2(0), glm::vec2(1));
+        glm::vec2 hi = glm::clamp(glm::max(uvMin, uvMax), glm::vec2(0), glm::vec2(1));
+
+        PageId page;
+        page.mip = mip;
+        // The last row and column of pages can be partial, so convert to texels first
+        uint32_t x0 = std::min(m.pagesX - 1, (uint32_t)(lo.x * m.width) / mPageSize);
+        uint32_t x1 = std::min(m.pagesX - 1, (uint32_t)(hi.x * m.width) / mPageSize);
+        uint32_t y0 = std::min(m.pagesY - 1, (uint32_t)(lo.y * m.height) / mPageSize);
+        uint32_t y1 = std::min(m.pagesY - 1, (uint32_t)(hi.y * m.height) / mPageSize);
+        for (page.y = y0; page.y <= y1; page.y++)
+        {
+            for (page.x = x0; page.x <= x1; page.x++)
+            {
+                requestPage(page);
+            }
+        }
+    }
+
+    std::vector<VirtualTexturePageTable::PageId> VirtualTexturePageTable::getPagesToLoad(uint32_t maxCount)
+    {
+        // Coarse pages first. They cover more of the screen and are the fallbacks of the finer ones
+        std::stable_sort(mRequests.begin(), mRequests.end(), std::greater<uint32_t>());
+
+        std::vector<PageId> pages;
+        for (uint32_t index : mRequests)
+        {
+            if (pages.size() >= maxCount) break;
+            Page& p = mPages[index];
+            if (p.state != State::NotResident) continue;
+            p.state = State::Pending;
+            pages.push_back(getPageId(index));
+            mStats.pendingCount++;
+        }
+        mRequests.clear();
+        return pages;
+    }
+
+    uint32_t VirtualTexturePageTable::evictOne(bool force)
+    {
+        if (mLruTail == kInvalidSlot) return kInvalidSlot;
+        uint32_t index = mLruTail;
+        Page& p = mPages[index];
+        if (p.lastUsedFrame >= mFrame && force == false) return kInvalidSlot;
+
+        lruRemove(index);
+        uint32_t slot = p.slot;
+        p.state = State::NotResident;
+        p.slot = kInvalidSlot;
+        mSlotOwner[slot] = kInvalidSlot;
+        mStats.residentCount--;
+        mStats.evictedCount++;
+        onPageEvicted(getPageId(index));
+        return slot;
+    }
+
+    uint32_t VirtualTexturePageTable::onPageLoaded(const PageId& page)
+    {
+        if (isValid(page) == false) return kInvalidSlot;
+        uint32_t index = getPageIndex(page);
+        Page& p = mPages[index];
+        if (p.state != State::Pending) return kInvalidSlot;
+        mStats.pendingCount--;
+
+        uint32_t slot = kInvalidSlot;
+        if (mFreeSlots.size())
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            // The pinned pages must get in, even if it means evicting something the current frame uses
+            slot = evictOne(isPinned(page));
+        }
+
+        if (slot == kInvalidSlot)
+        {
+            p.state = State::NotResident;
+            mStats.droppedCount++;
+            return kInvalidSlot;
+        }
+
+        p.state = State::Resident;
+        p.slot = slot;
+        p.lastUsedFrame = mFrame;
+        mSlotOwner[slot] = index;
+        if (isPinned(page) == false) lruPushFront(index);
+        mStats.residentCount++;
+        mStats.loadedCount++;
+        onPageResident(page, slot);
+        return slot;
+    }
+
+    void VirtualTexturePageTable::onPageLoadFailed(const PageId& page)
+    {
+        if (isValid(page) == false) return;
+        Page& p = mPages[getPageIndex(page)];
+        if (p.state == State::Pending)
+        {
+            p.state = State::NotResident;
+            mStats.pendingCount--;
+        }
+    }
+
+    uint32_t VirtualTexturePageTable::getSlot(const PageId& page) const
+    {
+        if (isValid(page) == false) return kInvalidSlot;
+        const Page& p = mPages[getPageIndex(page)];
+        return p.state == State::Resident ? p.slot : kInvalidSlot;
+    }
+
+    void VirtualTexturePageTable::onPageResident(const PageId& page, uint32_t slot)
+    {
+        // The page becomes the target of every entry it covers which pointed to a coarser page
+        uint32_t entry = kEntryValid | (page.mip << kEntryMipShift) | slot;
+        for (uint32_t l = 0; l <= page.mip; l++)
+        {
+            uint32_t shift = page.mip - l;
+            const Mip& mip = mMips[l];
+            uint32_t x1 = std::min(mip.pagesX, (page.x + 1) << shift);
+            uint32_t y1 = std::min(mip.pagesY, (page.y + 1) << shift);
+            for (uint32_t y = page.y << shift; y < y1; y++)
+            {
+                for (uint32_t x = page.x << shift; x < x1; x++)
+                {
+                    uint32_t& e = mEntries[l][y * mip.pagesX + x];
+                    if ((e & kEntryValid) == 0 || ((e >> kEntryMipShift) & kEntryMipMask) > page.mip) e = entry;
+                }
+            }
+        }
+        mDirty = true;
+    }
+
+    void VirtualTexturePageTable::onPageEvicted(const PageId& page)
+    {
+        // Entries pointing to the page fall back to its finest resident ancestor. Entries pointing to finer pages are not affected
+        uint32_t fallback = 0;
+        PageId ancestor = page;
+        while (ancestor.mip + 1 < mMips.size())
+        {
+            ancestor.mip++;
+            ancestor.x >>= 1;
+            ancestor.y >>= 1;
+            uint32_t slot = getSlot(ancestor);
+            if (slot != kInvalidSlot)
+            {
+                fallback = kEntryValid | (ancestor.mip << kEntryMipShift) | slot;
+                break;
+            }
+        }
+
+        for (uint32_t l = 0; l <= page.mip; l++)
+        {
+            uint32_t shift = page.mip - l;
+            const Mip& mip = mMips[l];
+            uint32_t x1 = std::min(mip.pagesX, (page.x + 1) << shift);
+            uint32_t y1 = std::min(mip.pagesY, (page.y + 1) << shift);
+            for (uint32_t y = page.y << shift; y < y1; y++)
+            {
+                for (uint32_t x = page.x << shift; x < x1; x++)
+                {
+                    uint32_t& e = mEntries[l][y * mip.pagesX + x];
+                    if ((e & kEntryValid) && ((e >> kEntryMipShift) & kEntryMipMask) == page.mip) e = fallback;
+                }
+            }
+        }
+        mDirty = true;
+    }
+}
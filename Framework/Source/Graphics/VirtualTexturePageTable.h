@@ -0,0 +1,186 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "glm/vec2.hpp"
+#include "Data/HostDeviceSharedMacros.h"
+
+namespace Falcor
+{
+    /** CPU-side residency manager of a virtual texture.
+        Tracks which pages of the mip pyramid live in a fixed pool of physical slots, which ones are being loaded and which ones were requested this frame. Resident pages are kept in LRU order and the least recently used one is evicted when a newly loaded page needs a slot. Pages of the coarsest level are pinned, so every texel always has a resident fallback.
+        The class doesn't touch the GPU or the disk. The owner reports what the renderer needs with requestPage() or requestRegion(), fetches the pages to load with getPagesToLoad() and calls onPageLoaded() when the data arrived, so it can be driven and tested without a device.
+    */
+    class VirtualTexturePageTable
+    {
+    public:
+        using SharedPtr = std::shared_ptr<VirtualTexturePageTable>;
+        using SharedConstPtr = std::shared_ptr<const VirtualTexturePageTable>;
+
+        static const uint32_t kInvalidSlot = (uint32_t)-1;
+
+        /** Page table entries are kEntryValid | (mip << kEntryMipShift) | slot, or 0 if no page covering the entry is resident yet. The layout is shared with VirtualTexture.slang
+        */
+        static const uint32_t kEntryValid = VirtualTextureEntryValid;
+        static const uint32_t kEntryMipShift = VirtualTextureEntryMipShift;
+        static const uint32_t kEntryMipMask = VirtualTextureEntryMipMask;
+        static const uint32_t kEntrySlotMask = VirtualTextureEntrySlotMask;
+
+        struct PageId
+        {
+            uint32_t mip = 0;
+            uint32_t x = 0;
+            uint32_t y = 0;
+            bool operator==(const PageId& other) const { return mip == other.mip && x == other.x && y == other.y; }
+        };
+
+        struct Stats
+        {
+            uint32_t residentCount = 0;     ///< Pages currently holding a slot
+            uint32_t pendingCount = 0;      ///< Pages returned by getPagesToLoad() which didn't complete yet
+            uint32_t requestedCount = 0;    ///< Non-resident pages requested this frame
+            uint32_t loadedCount = 0;       ///< Pages which became resident, since creation
+            uint32_t evictedCount = 0;      ///< Pages evicted to make room, since creation
+            uint32_t droppedCount = 0;      ///< Loaded pages thrown away because every slot was used this frame, since creation
+        };
+
+        /** Create a page table
+            \param[in] width Width of mip 0, in texels
+            \param[in] height Height of mip 0, in texels
+            \param[in] mipCount Number of mip levels to manage
+            \param[in] pageSize Size of a page, in texels
+            \param[in] slotCount Number of physical slots. Must be large enough to hold the pages of the coarsest level
+            \return A new object, or nullptr if the arguments are invalid
+        */
+        static SharedPtr create(uint32_t width, uint32_t height, uint32_t mipCount, uint32_t pageSize, uint32_t slotCount);
+
+        /** Start a new frame. Pages used during the previous frames become candidates for eviction and the pinned pages are requested again if they are not resident
+        */
+        void beginFrame();
+
+        /** Mark a page as used this frame. If it is not resident, it is queued for loading along with its non-resident ancestors
+        */
+        void requestPage(const PageId& page);
+
+        /** Request all the pages of a mip level which overlap a UV rectangle. Coordinates are clamped to [0, 1]
+        */
+        void requestRegion(uint32_t mip, const glm::vec2& uvMin, const glm::vec2& uvMax);
+
+        /** Get the pages to load, coarsest first. The returned pages are marked as pending and the remaining requests of the frame are discarded
+        */
+        std::vector<PageId> getPagesToLoad(uint32_t maxCount);
+
+        /** Report that the data of a pending page arrived
+            \return The slot the data must be copied to, or kInvalidSlot if no slot could be freed. In that case the page goes back to non-resident
+        */
+        uint32_t onPageLoaded(const PageId& page);
+
+        /** Report that a pending page couldn't be loaded
+        */
+        void onPageLoadFailed(const PageId& page);
+
+        /** Get the slot of a resident page, or kInvalidSlot
+        */
+        uint32_t getSlot(const PageId& page) const;
+        bool isResident(const PageId& page) const { return getSlot(page) != kInvalidSlot; }
+
+        /** Get the page table entries of a mip level, one per page, in row-major order. Each entry points to the finest resident page covering it
+        */
+        const std::vector<uint32_t>& getEntries(uint32_t mip) const { return mEntries[mip]; }
+
+        /** Check if any entry changed since the last call to clearDirty()
+        */
+        bool isDirty() const { return mDirty; }
+        void clearDirty() { mDirty = false; }
+
+        uint32_t getMipCount() const { return (uint32_t)mMips.size(); }
+        uint32_t getPageCountX(uint32_t mip) const { return mMips[mip].pagesX; }
+        uint32_t getPageCountY(uint32_t mip) const { return mMips[mip].pagesY; }
+        uint32_t getPageSize() const { return mPageSize; }
+        uint32_t getSlotCount() const { return (uint32_t)mSlotOwner.size(); }
+        uint64_t getFrame() const { return mFrame; }
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        VirtualTexturePageTable() = default;
+
+        enum class State : uint8_t
+        {
+            NotResident,
+            Pending,
+            Resident,
+        };
+
+        struct Page
+        {
+            uint64_t lastUsedFrame = 0;
+            uint64_t requestedFrame = (uint64_t)-1;
+            uint32_t slot = kInvalidSlot;
+            uint32_t lruPrev = kInvalidSlot;    // Page indices, kInvalidSlot terminates the list
+            uint32_t lruNext = kInvalidSlot;
+            State state = State::NotResident;
+        };
+
+        struct Mip
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t pagesX = 0;
+            uint32_t pagesY = 0;
+            uint32_t firstPage = 0;
+        };
+
+        uint32_t getPageIndex(const PageId& page) const { return mMips[page.mip].firstPage + page.y * mMips[page.mip].pagesX + page.x; }
+        PageId getPageId(uint32_t index) const;
+        bool isValid(const PageId& page) const;
+        bool isPinned(const PageId& page) const { return page.mip + 1 == mMips.size(); }
+
+        void touch(uint32_t index);
+        void lruRemove(uint32_t index);
+        void lruPushFront(uint32_t index);
+        uint32_t evictOne(bool force);
+
+        void onPageResident(const PageId& page, uint32_t slot);
+        void onPageEvicted(const PageId& page);
+
+        std::vector<Mip> mMips;
+        std::vector<Page> mPages;
+        std::vector<std::vector<uint32_t>> mEntries;
+        std::vector<uint32_t> mSlotOwner;       // Page index per slot, kInvalidSlot if free
+        std::vector<uint32_t> mFreeSlots;
+        std::vector<uint32_t> mRequests;
+        uint32_t mLruHead = kInvalidSlot;       // Most recently used
+        uint32_t mLruTail = kInvalidSlot;       // Least recently used
+        uint32_t mPageSize = 0;
+        uint64_t mFrame = 0;
+        bool mDirty = true;
+        Stats mStats;
+    };
+}
@@ -0,0 +1,425 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuBvh.h"
+#include "glm/geometric.hpp"
+#include <xmmintrin.h>
+#include <algorithm>
+
+namespace Falcor
+{
+    static const uint32_t kMaxLeafSize = 4;
+    static const uint32_t kBinCount = 16;
+    static const uint32_t kMaxStackSize = 256;
+
+    // Past kMaxSahDepth the builder switches to median splits, which halve the primitive count at each level. That bounds the tree depth, and with it the traversal stack
+    static const uint32_t kMaxSahDepth = 48;
+    static_assert(kMaxSahDepth + 32 <= CpuBvh::kMaxDepth, "Median splits can add up to 32 levels");
+    // Each 4-wide node pops one entry and pushes at most 4, and the collapsed tree isn't deeper than the binary tree
+    static_assert(3 * CpuBvh::kMaxDepth + 1 <= kMaxStackSize, "The traversal stack is too small for the maximal tree depth");
+
+    struct CpuBvh::BuildPrim
+    {
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        glm::vec3 centroid;
+        uint32_t triangle;
+    };
+
+    struct CpuBvh::BuildNode
+    {
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        uint32_t children[2];
+        uint32_t first;
+        uint32_t count;     ///< Non-zero for leaves
+    };
+
+    static float surfaceArea(const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        glm::vec3 e = glm::max(boxMax - boxMin, glm::vec3(0));
+        return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    CpuBvh::SharedPtr CpuBvh::create(const std::vector<glm::vec3>& positions)
+    {
+        const uint32_t triCount = (uint32_t)(positions.size() / 3);
+        if (triCount == 0)
+        {
+            return nullptr;
+        }
+
+        std::vector<BuildPrim> prims(triCount);
+        for (uint32_t i = 0; i < triCount; i++)
+        {
+            const glm::vec3& a = positions[i * 3 + 0];
+            const glm::vec3& b = positions[i * 3 + 1];
+            const glm::vec3& c = positions[i * 3 + 2];
+            prims[i].boxMin = glm::min(a, glm::min(b, c));
+            prims[i].boxMax = glm::max(a, glm::max(b, c));
+            prims[i].centroid = (prims[i].boxMin + prims[i].boxMax) * 0.5f;
+            prims[i].triangle = i;
+        }
+
+        SharedPtr pBvh = SharedPtr(new CpuBvh());
+        std::vector<BuildNode> buildNodes;
+        buildNodes.reserve(triCount * 2);
+        uint32_t root = pBvh->buildBinary(prims, 0, triCount, 0, buildNodes);
+
+        // The leaves reference ranges of the reordered primitives
+        pBvh->mTriangles.resize(triCount);
+        for (uint32_t i = 0; i < triCount; i++)
+        {
+            uint32_t tri = prims[i].triangle;
+            Triangle& t = pBvh->mTriangles[i];
+            t.v0 = positions[tri * 3 + 0];
+            t.e1 = positions[tri * 3 + 1] - t.v0;
+            t.e2 = positions[tri * 3 + 2] - t.v0;
+            t.primId = tri;
+        }
+
+        pBvh->mNodes.reserve(buildNodes.size() / 2 + 1);
+        pBvh->collapse(buildNodes, root, 1);
+        return pBvh;
+    }
+
+    uint32_t CpuBvh::buildBinary(std::vector<BuildPrim>& prims, uint32_t begin, uint32_t end, uint32_t depth, std::vector<BuildNode>& buildNodes)
+    {
+        BuildNode node;
+        node.boxMin = glm::vec3(FLT_MAX);
+        node.boxMax = glm::vec3(-FLT_MAX);
+        glm::vec3 centroidMin(FLT_MAX);
+        glm::vec3 centroidMax(-FLT_MAX);
+        for (uint32_t i = begin; i < end; i++)
+        {
+            node.boxMin = glm::min(node.boxMin, prims[i].boxMin);
+            node.boxMax = glm::max(node.boxMax, prims[i].boxMax);
+            centroidMin = glm::min(centroidMin, prims[i].centroid);
+            centroidMax = glm::max(centroidMax, prims[i].centroid);
+        }
+        node.first = begin;
+        node.count = end - begin;
+        node.children[0] = node.children[1] = 0;
+
+        const uint32_t nodeIndex = (uint32_t)buildNodes.size();
+        buildNodes.push_back(node);
+        if (node.count <= kMaxLeafSize)
+        {
+            return nodeIndex;
+        }
+
+        // Binned SAH. Find the best split plane over all 3 axes
+        const glm::vec3 extent = centroidMax - centroidMin;
+        float bestCost = FLT_MAX;
+        int32_t bestAxis = -1;
+        uint32_t bestBin = 0;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            if (extent[axis] <= 0 || depth >= kMaxSahDepth) continue;
+
+            glm::vec3 binMin[kBinCount];
+            glm::vec3 binMax[kBinCount];
+            uint32_t binCount[kBinCount] = {};
+            for (uint32_t b = 0; b < kBinCount; b++)
+            {
+                binMin[b] = glm::vec3(FLT_MAX);
+                binMax[b] = glm::vec3(-FLT_MAX);
+            }
+
+            const float scale = kBinCount / extent[axis];
+            for (uint32_t i = begin; i < end; i++)
+            {
+                uint32_t b = std::min(kBinCount - 1, (uint32_t)((prims[i].centroid[axis] - centroidMin[axis]) * scale));
+                binCount[b]++;
+                binMin[b] = glm::min(binMin[b], prims[i].boxMin);
+                binMax[b] = glm::max(binMax[b], prims[i].boxMax);
+            }
+
+            // Sweep from the right to get the cost of each right side, then from the left
+            float rightArea[kBinCount];
+            uint32_t rightCount[kBinCount];
+            glm::vec3 accMin(FLT_MAX);
+            glm::vec3 accMax(-FLT_MAX);
+            uint32_t accCount = 0;
+            for (uint32_t b = kBinCount - 1; b > 0; b--)
+            {
+                accMin = glm::min(accMin, binMin[b]);
+                accMax = glm::max(accMax, binMax[b]);
+                accCount += binCount[b];
+                rightArea[b] = surfaceArea(accMin, accMax);
+                rightCount[b] = accCount;
+            }
+
+            accMin = glm::vec3(FLT_MAX);
+            accMax = glm::vec3(-FLT_MAX);
+            accCount = 0;
+            for (uint32_t b = 0; b < kBinCount - 1; b++)
+            {
+                accMin = glm::min(accMin, binMin[b]);
+                accMax = glm::max(accMax, binMax[b]);
+                accCount += binCount[b];
+                if (accCount == 0 || rightCount[b + 1] == 0) continue;
+                float cost = surfaceArea(accMin, accMax) * accCount + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        uint32_t mid;
+        if (bestAxis >= 0)
+        {
+            const float scale = kBinCount / extent[bestAxis];
+            const float minC = centroidMin[bestAxis];
+            auto it = std::partition(prims.begin() + begin, prims.begin() + end, [&](const BuildPrim& p)
+            {
+                return std::min(kBinCount - 1, (uint32_t)((p.centroid[bestAxis] - minC) * scale)) <= bestBin;
+            });
+            mid = (uint32_t)(it - prims.begin());
+        }
+        else
+        {
+            // The SAH depth budget is exhausted, or all centroids are at the same point. Split at the median of the largest axis
+            mid = (begin + end) / 2;
+            const uint32_t axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+            std::nth_element(prims.begin() + begin, prims.begin() + mid, prims.begin() + end, [axis](const BuildPrim& a, const BuildPrim& b)
+            {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+        }
+
+        if (mid == begin || mid == end)
+        {
+            mid = (begin + end) / 2;
+        }
+
+        uint32_t left = buildBinary(prims, begin, mid, depth + 1, buildNodes);
+        uint32_t right = buildBinary(prims, mid, end, depth + 1, buildNodes);
+        buildNodes[nodeIndex].children[0] = left;
+        buildNodes[nodeIndex].children[1] = right;
+        buildNodes[nodeIndex].count = 0;
+        return nodeIndex;
+    }
+
+    uint32_t CpuBvh::collapse(const std::vector<BuildNode>& buildNodes, uint32_t buildNodeIndex, uint32_t depth)
+    {
+        mDepth = std::max(mDepth, depth);
+
+        // Gather up to 4 children, by repeatedly opening the inner child with the largest surface area
+        uint32_t children[4];
+        uint32_t childCount = 0;
+        const BuildNode& root = buildNodes[buildNodeIndex];
+        if (root.count)
+        {
+            children[childCount++] = buildNodeIndex;
+        }
+        else
+        {
+            children[childCount++] = root.children[0];
+            children[childCount++] = root.children[1];
+        }
+
+        while (childCount < 4)
+        {
+            int32_t best = -1;
+            float bestArea = -1;
+            for (uint32_t i = 0; i < childCount; i++)
+            {
+                const BuildNode& c = buildNodes[children[i]];
+                float area = surfaceArea(c.boxMin, c.boxMax);
+                if (c.count == 0 && area > bestArea)
+                {
+                    best = i;
+                    bestArea = area;
+                }
+            }
+            if (best < 0) break;
+
+            const BuildNode& opened = buildNodes[children[best]];
+            children[best] = opened.children[0];
+            children[childCount++] = opened.children[1];
+        }
+
+        const uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.push_back(Node());
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            // Empty slots get a degenerate box far away, and are skipped by traverse() anyway
+            glm::vec3 boxMin(FLT_MAX);
+            glm::vec3 boxMax(FLT_MAX);
+            int32_t child = kEmptyChild;
+            uint32_t triCount = 0;
+
+            if (i < childCount)
+            {
+                const BuildNode& c = buildNodes[children[i]];
+                boxMin = c.boxMin;
+                boxMax = c.boxMax;
+                if (c.count)
+                {
+                    child = ~(int32_t)c.first;
+                    triCount = c.count;
+                }
+                else
+                {
+                    child = (int32_t)collapse(buildNodes, children[i], depth + 1);
+                }
+            }
+
+            // mNodes might have been reallocated by the recursion
+            Node& node = mNodes[nodeIndex];
+            node.minX[i] = boxMin.x;
+            node.minY[i] = boxMin.y;
+            node.minZ[i] = boxMin.z;
+            node.maxX[i] = boxMax.x;
+            node.maxY[i] = boxMax.y;
+            node.maxZ[i] = boxMax.z;
+            node.child[i] = child;
+            node.triCount[i] = triCount;
+        }
+        return nodeIndex;
+    }
+
+    static float safeInverse(float d)
+    {
+        const float kEpsilon = 1e-20f;
+        if (fabsf(d) < kEpsilon) d = (d < 0) ? -kEpsilon : kEpsilon;
+        return 1.0f / d;
+    }
+
+    template<bool anyHit>
+    bool CpuBvh::traverse(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, Hit& hit) const
+    {
+        const __m128 ox = _mm_set1_ps(origin.x);
+        const __m128 oy = _mm_set1_ps(origin.y);
+        const __m128 oz = _mm_set1_ps(origin.z);
+        const __m128 idx = _mm_set1_ps(safeInverse(dir.x));
+        const __m128 idy = _mm_set1_ps(safeInverse(dir.y));
+        const __m128 idz = _mm_set1_ps(safeInverse(dir.z));
+        const __m128 rayMin = _mm_set1_ps(tMin);
+
+        uint32_t stack[kMaxStackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        bool found = false;
+        float closest = tMax;
+
+        while (stackSize)
+        {
+            const Node& node = mNodes[stack[--stackSize]];
+
+            // Slab test against the 4 children
+            const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ox), idx);
+            const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ox), idx);
+            const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), oy), idy);
+            const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), oy), idy);
+            const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), oz), idz);
+            const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), oz), idz);
+
+            __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_max_ps(_mm_min_ps(tz0, tz1), rayMin));
+            __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_set1_ps(closest)));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+            if (mask == 0) continue;
+
+            alignas(16) float nearDist[4];
+            _mm_store_ps(nearDist, tNear);
+
+            // Sort the hit inner children far-to-near so that the nearest is popped first
+            uint32_t inner[4];
+            uint32_t innerCount = 0;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                int32_t child = node.child[i];
+                if ((mask & (1 << i)) == 0 || child == kEmptyChild) continue;
+                if (child >= 0)
+                {
+                    uint32_t j = innerCount++;
+                    while (j > 0 && nearDist[inner[j - 1]] < nearDist[i])
+                    {
+                        inner[j] = inner[j - 1];
+                        j--;
+                    }
+                    inner[j] = i;
+                    continue;
+                }
+
+                // Leaf. Moller-Trumbore against each triangle
+                const uint32_t first = (uint32_t)~child;
+                for (uint32_t t = first; t < first + node.triCount[i]; t++)
+                {
+                    const Triangle& tri = mTriangles[t];
+                    const glm::vec3 pvec = glm::cross(dir, tri.e2);
+                    const float det = glm::dot(tri.e1, pvec);
+                    if (fabsf(det) < 1e-12f) continue;
+                    const float invDet = 1.0f / det;
+                    const glm::vec3 tvec = origin - tri.v0;
+                    const float u = glm::dot(tvec, pvec) * invDet;
+                    if (u < 0 || u > 1) continue;
+                    const glm::vec3 qvec = glm::cross(tvec, tri.e1);
+                    const float v = glm::dot(dir, qvec) * invDet;
+                    if (v < 0 || u + v > 1) continue;
+                    const float dist = glm::dot(tri.e2, qvec) * invDet;
+                    if (dist <= tMin || dist >= closest) continue;
+
+                    closest = dist;
+                    hit.t = dist;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.primId = tri.primId;
+                    found = true;
+                    if (anyHit) return true;
+                }
+            }
+
+            // The depth bound in buildBinary() guarantees the stack is large enough. Stop rather than write past it if that ever breaks
+            assert(stackSize + innerCount <= kMaxStackSize);
+            if (stackSize + innerCount > kMaxStackSize) return found;
+            for (uint32_t i = 0; i < innerCount; i++)
+            {
+                stack[stackSize++] = (uint32_t)node.child[inner[i]];
+            }
+        }
+        return found;
+    }
+
+    bool CpuBvh::intersect(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, Hit& hit) const
+    {
+        return traverse<false>(origin, dir, tMin, tMax, hit);
+    }
+
+    bool CpuBvh::occluded(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax) const
+    {
+        Hit hit;
+        return traverse<true>(origin, dir, tMin, tMax, hit);
+    }
+}
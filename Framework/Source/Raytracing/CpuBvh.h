@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "glm/vec3.hpp"
+#include <vector>
+#include <memory>
+
+namespace Falcor
+{
+    /** A 4-wide bounding volume hierarchy over triangles, traversed on the CPU with SSE.
+        The hierarchy is built with a binned surface-area heuristic, then collapsed from a binary tree into nodes with 4 children so that each traversal step tests 4 boxes at once.
+    */
+    class CpuBvh
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuBvh>;
+        using SharedConstPtr = std::shared_ptr<const CpuBvh>;
+
+        static const uint32_t kMaxDepth = 80;   ///< Upper bound of getDepth()
+
+        struct Hit
+        {
+            float t;            ///< Distance along the ray
+            float u;            ///< Barycentric coordinate of the 2nd vertex
+            float v;            ///< Barycentric coordinate of the 3rd vertex
+            uint32_t primId;    ///< Index of the triangle, as passed to create()
+        };
+
+        /** Build a BVH
+            \param[in] positions Triangle vertices, 3 per triangle
+            \return A new object, or nullptr if there are no triangles
+        */
+        static SharedPtr create(const std::vector<glm::vec3>& positions);
+
+        /** Find the closest intersection along a ray
+            \param[in] origin Ray origin
+            \param[in] dir Ray direction. Doesn't need to be normalized, distances are in units of its length
+            \param[in] tMin Minimal hit distance
+            \param[in] tMax Maximal hit distance
+            \param[out] hit The closest hit. Only valid if the function returned true
+            \return true if the ray hit a triangle, otherwise false
+        */
+        bool intersect(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, Hit& hit) const;
+
+        /** Check if any triangle lies along a ray segment. Faster than intersect(), since it stops at the first hit
+        */
+        bool occluded(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax) const;
+
+        uint32_t getTriangleCount() const { return (uint32_t)mTriangles.size(); }
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+        /** Get the number of levels in the 4-wide tree. The builder bounds it, so that traversal never overflows its fixed-size stack
+        */
+        uint32_t getDepth() const { return mDepth; }
+
+    private:
+        CpuBvh() = default;
+
+        struct BuildNode;
+        struct BuildPrim;
+
+        // Edge form used by the Moller-Trumbore test
+        struct Triangle
+        {
+            glm::vec3 v0;
+            glm::vec3 e1;
+            glm::vec3 e2;
+            uint32_t primId;
+        };
+
+        // Children are stored SoA so a single SSE op tests all 4 boxes
+        struct alignas(16) Node
+        {
+            float minX[4];
+            float minY[4];
+            float minZ[4];
+            float maxX[4];
+            float maxY[4];
+            float maxZ[4];
+            int32_t child[4];       ///< >= 0 is an inner node index, < 0 is a leaf with ~child as the first triangle
+            uint32_t triCount[4];   ///< Number of triangles in a leaf child
+        };
+
+        static const int32_t kEmptyChild = -1 - 0x7fffffff;
+
+        uint32_t buildBinary(std::vector<BuildPrim>& prims, uint32_t begin, uint32_t end, uint32_t depth, std::vector<BuildNode>& buildNodes);
+        uint32_t collapse(const std::vector<BuildNode>& buildNodes, uint32_t buildNodeIndex, uint32_t depth);
+        template<bool anyHit>
+        bool traverse(const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, Hit& hit) const;
+
+        std::vector<Node> mNodes;
+        std::vector<Triangle> mTriangles;
+        uint32_t mDepth = 0;
+    };
+}
@@ -0,0 +1,996 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#define _USE_MATH_DEFINES
+#include "Framework.h"
+#include "CpuPathTracer.h"
+#include "API/Device.h"
+#include "Data/VertexAttrib.h"
+#include "glm/gtc/packing.hpp"
+#include "Graphics/DdsFile.h"
+#include "Utils/Bitmap.h"
+#include "Utils/StringUtils.h"
+#include <atomic>
+#include <thread>
+
+namespace Falcor
+{
+    static const uint32_t kTileSize = 16;
+    static const uint32_t kMaxAlphaTestIterations = 32;
+    static const uint32_t kRussianRouletteDepth = 3;
+    static const bool kTopDown = true;  // Same image layout as the texture loaders in TextureHelper.cpp
+
+    /** PCG hash based random numbers. Seeded per-pixel and per-frame, so the image doesn't depend on how tiles are scheduled between threads
+    */
+    class CpuPathTracer::Rng
+    {
+    public:
+        Rng(uint32_t pixel, uint32_t frame) : mState(hash(pixel ^ hash(frame))) {}
+
+        float next()
+        {
+            mState = hash(mState);
+            return (mState >> 8) * (1.0f / 16777216.0f);
+        }
+
+    private:
+        static uint32_t hash(uint32_t x)
+        {
+            uint32_t state = x * 747796405u + 2891336453u;
+            uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+            return (word >> 22u) ^ word;
+        }
+        uint32_t mState;
+    };
+
+    glm::vec4 CpuPathTracer::Image::sample(const glm::vec2& uv) const
+    {
+        // Bilinear filtering with wrap addressing
+        float x = (uv.x - floor(uv.x)) * width - 0.5f;
+        float y = (uv.y - floor(uv.y)) * height - 0.5f;
+        float fx = floor(x);
+        float fy = floor(y);
+        int32_t x0 = (int32_t)fx;
+        int32_t y0 = (int32_t)fy;
+
+        auto texel = [this](int32_t tx, int32_t ty)
+        {
+            tx = (tx + (int32_t)width) % (int32_t)width;
+            ty = (ty + (int32_t)height) % (int32_t)height;
+            return texels[ty * width + tx];
+        };
+
+        glm::vec4 top = glm::mix(texel(x0, y0), texel(x0 + 1, y0), x - fx);
+        glm::vec4 bottom = glm::mix(texel(x0, y0 + 1), texel(x0 + 1, y0 + 1), x - fx);
+        return glm::mix(top, bottom, y - fy);
+    }
+
+    CpuPathTracer::SharedPtr CpuPathTracer::create(const Scene::SharedPtr& pScene)
+    {
+        SharedPtr pTracer = SharedPtr(new CpuPathTracer(pScene));
+        return pTracer->rebuild() ? pTracer : nullptr;
+    }
+
+    /** Convert texels into linear RGBA. Returns false if the format isn't supported
+    */
+    static bool decodeTexels(const uint8_t* pData, uint32_t rowPitch, ResourceFormat format, bool srgb, uint32_t width, uint32_t height, std::vector<glm::vec4>& texels)
+    {
+        switch (format)
+        {
+        case ResourceFormat::R8Unorm:
+        case ResourceFormat::RG8Unorm:
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA32Float:
+            break;
+        default:
+            return false;
+        }
+
+        const uint32_t bytesPerTexel = getFormatBytesPerBlock(format);
+        texels.resize(width * height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint8_t* pTexel = pData + (size_t)y * rowPitch + x * bytesPerTexel;
+                glm::vec4& c = texels[y * width + x];
+                switch (format)
+                {
+                case ResourceFormat::R8Unorm:
+                    c = glm::vec4(pTexel[0] / 255.0f, 0, 0, 1);
+                    break;
+                case ResourceFormat::RG8Unorm:
+                    c = glm::vec4(pTexel[0] / 255.0f, pTexel[1] / 255.0f, 0, 1);
+                    break;
+                case ResourceFormat::RGBA8Unorm:
+                case ResourceFormat::RGBA8UnormSrgb:
+                    c = glm::vec4(pTexel[0], pTexel[1], pTexel[2], pTexel[3]) / 255.0f;
+                    break;
+                case ResourceFormat::BGRA8Unorm:
+                case ResourceFormat::BGRA8UnormSrgb:
+                    c = glm::vec4(pTexel[2], pTexel[1], pTexel[0], pTexel[3]) / 255.0f;
+                    break;
+                case ResourceFormat::BGRX8Unorm:
+                case ResourceFormat::BGRX8UnormSrgb:
+                    c = glm::vec4(pTexel[2] / 255.0f, pTexel[1] / 255.0f, pTexel[0] / 255.0f, 1);
+                    break;
+                case ResourceFormat::RGBA16Float:
+                {
+                    uint64_t packed;
+                    memcpy(&packed, pTexel, sizeof(packed));
+                    c = glm::unpackHalf4x16(packed);
+                }
+                break;
+                case ResourceFormat::RGB32Float:
+                    c = glm::vec4(((const float*)pTexel)[0], ((const float*)pTexel)[1], ((const float*)pTexel)[2], 1);
+                    break;
+                case ResourceFormat::RGBA32Float:
+                    memcpy(&c, pTexel, sizeof(c));
+                    break;
+                }
+
+                if (srgb)
+                {
+                    c = glm::vec4(SRGBToLinear(glm::vec3(c)), c.w);
+                }
+            }
+        }
+        return true;
+    }
+
+    /** Decode the most detailed level of an image file. Uncompressed DDS files are read directly, everything else through Bitmap
+    */
+    static bool loadImageFile(const std::string& filename, bool srgb, uint32_t& width, uint32_t& height, std::vector<glm::vec4>& texels)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false) return false;
+
+        if (hasSuffix(fullpath, ".dds", false))
+        {
+            DdsFile::SharedPtr pDds = DdsFile::open(fullpath);
+            if (pDds == nullptr || isCompressedFormat(pDds->getFormat())) return false;
+            const DdsFile::Subresource& level = pDds->getSubresource(0, 0);
+            width = level.width;
+            height = level.height;
+            return decodeTexels(level.pData, level.rowPitch, pDds->getFormat(), srgb, width, height, texels);
+        }
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(fullpath, kTopDown);
+        if (pBitmap == nullptr) return false;
+        width = pBitmap->getWidth();
+        height = pBitmap->getHeight();
+        return decodeTexels(pBitmap->getData(), width * getFormatBytesPerBlock(pBitmap->getFormat()), pBitmap->getFormat(), srgb, width, height, texels);
+    }
+
+    const CpuPathTracer::Image* CpuPathTracer::getImage(const Texture::SharedPtr& pTexture)
+    {
+        if (pTexture == nullptr) return nullptr;
+
+        auto it = mImages.find(pTexture.get());
+        if (it != mImages.end())
+        {
+            return it->second.width ? &it->second : nullptr;
+        }
+
+        // An empty image marks an unsupported texture, so that we only warn once
+        Image& image = mImages[pTexture.get()];
+        const ResourceFormat format = pTexture->getFormat();
+        const bool srgb = isSrgbFormat(format);
+
+        // Prefer the source file, it doesn't require a GPU round-trip and works for block-compressed textures
+        const std::string& filename = pTexture->getSourceFilename();
+        if (filename.size() && loadImageFile(filename, srgb, image.width, image.height, image.texels))
+        {
+            return &image;
+        }
+
+        image.width = pTexture->getWidth();
+        image.height = pTexture->getHeight();
+        const uint32_t rowPitch = image.width * getFormatBytesPerBlock(format);
+        std::vector<uint8> data;
+        if (isCompressedFormat(format) == false)
+        {
+            data = gpDevice->getRenderContext()->readTextureSubresource(pTexture.get(), 0);
+        }
+
+        if (data.size() < (size_t)rowPitch * image.height || decodeTexels(data.data(), rowPitch, format, srgb, image.width, image.height, image.texels) == false)
+        {
+            logWarning("CpuPathTracer - can't decode texture '" + filename + "' with format " + to_string(format) + ". The material constant will be used instead");
+            image = Image();
+            return nullptr;
+        }
+        return &image;
+    }
+
+    uint32_t CpuPathTracer::getMaterialId(const Material* pMaterial)
+    {
+        auto it = mMaterialIds.find(pMaterial);
+        if (it != mMaterialIds.end()) return it->second;
+
+        pMaterial->finalize();
+        const MaterialData& data = pMaterial->mData;
+        ShadingMaterial material;
+        material.desc = data.desc;
+        material.values = data.values;
+        for (uint32_t i = 0; i < MatMaxLayers; i++)
+        {
+            if (data.desc.layers[i].hasTexture)
+            {
+                material.pLayerImages[i] = getImage(data.textures.layers[i]);
+            }
+        }
+        material.pAlphaMap = getImage(data.textures.alphaMap);
+        mHasAlphaTest = mHasAlphaTest || (material.pAlphaMap != nullptr);
+
+        uint32_t id = (uint32_t)mMaterials.size();
+        mMaterials.push_back(material);
+        mMaterialIds[pMaterial] = id;
+        return id;
+    }
+
+    using BufferReads = std::unordered_map<const Buffer*, ReadbackRequest::SharedPtr>;
+
+    template<typename T>
+    static bool readAttribute(const Vao* pVao, uint32_t location, uint32_t vertexCount, BufferReads& reads, std::vector<T>& attrib)
+    {
+        Vao::ElementDesc element = pVao->getElementIndexByLocation(location);
+        if (element.vbIndex == Vao::ElementDesc::kInvalidIndex) return false;
+
+        const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(element.vbIndex).get();
+        const ResourceFormat format = pLayout->getElementFormat(element.elementIndex);
+        if (getFormatType(format) != FormatType::Float || getFormatBytesPerBlock(format) != getFormatChannelCount(format) * sizeof(float))
+        {
+            return false;
+        }
+
+        const std::vector<uint8>& data = reads[pVao->getVertexBuffer(element.vbIndex).get()]->getData();
+        const uint32_t offset = pLayout->getElementOffset(element.elementIndex);
+        const uint32_t stride = pLayout->getStride();
+        const size_t copySize = std::min(sizeof(T), (size_t)getFormatBytesPerBlock(format));
+        if (offset + (size_t)stride * (vertexCount - 1) + copySize > data.size())
+        {
+            return false;
+        }
+
+        attrib.assign(vertexCount, T(0));
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            memcpy(&attrib[i], data.data() + offset + (size_t)i * stride, copySize);
+        }
+        return true;
+    }
+
+    static bool isValidGeometry(const Mesh::CpuGeometry& geometry)
+    {
+        const size_t vertexCount = geometry.positions.size();
+        if (geometry.normals.size() && geometry.normals.size() != vertexCount) return false;
+        if (geometry.texCrd.size() && geometry.texCrd.size() != vertexCount) return false;
+        for (uint32_t index : geometry.indices)
+        {
+            if (index >= vertexCount) return false;
+        }
+        return true;
+    }
+
+    static bool readMeshGeometry(const Mesh* pMesh, BufferReads& reads, Mesh::CpuGeometry& geometry)
+    {
+        const Vao* pVao = pMesh->getVao().get();
+        if (pVao->getPrimitiveTopology() != Vao::Topology::TriangleList)
+        {
+            logWarning("CpuPathTracer - only triangle lists are supported. Skipping mesh");
+            return false;
+        }
+
+        const uint32_t vertexCount = pMesh->getVertexCount();
+        if (vertexCount == 0 || readAttribute(pVao, VERTEX_POSITION_LOC, vertexCount, reads, geometry.positions) == false)
+        {
+            logWarning("CpuPathTracer - can't read the mesh positions. Skipping mesh");
+            return false;
+        }
+        readAttribute(pVao, VERTEX_NORMAL_LOC, vertexCount, reads, geometry.normals);
+        readAttribute(pVao, VERTEX_TEXCOORD_LOC, vertexCount, reads, geometry.texCrd);
+
+        const Buffer* pIB = pVao->getIndexBuffer().get();
+        if (pIB)
+        {
+            const std::vector<uint8>& data = reads[pIB]->getData();
+            const bool is16Bit = (pVao->getIndexBufferFormat() == ResourceFormat::R16Uint);
+            const uint32_t indexCount = std::min(pMesh->getIndexCount(), (uint32_t)(data.size() / (is16Bit ? sizeof(uint16_t) : sizeof(uint32_t))));
+            geometry.indices.resize(indexCount);
+            for (uint32_t i = 0; i < indexCount; i++)
+            {
+                geometry.indices[i] = is16Bit ? ((const uint16_t*)data.data())[i] : ((const uint32_t*)data.data())[i];
+            }
+        }
+        else
+        {
+            geometry.indices.resize(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; i++) geometry.indices[i] = i;
+        }
+
+        if (isValidGeometry(geometry) == false)
+        {
+            logWarning("CpuPathTracer - mesh index is out of range. Skipping mesh");
+            return false;
+        }
+        return true;
+    }
+
+    bool CpuPathTracer::rebuild()
+    {
+        mpBvh = nullptr;
+        mTriangles.clear();
+        mMaterials.clear();
+        mMaterialIds.clear();
+        mImages.clear();
+        mLights.clear();
+        mHasAlphaTest = false;
+        resetAccumulation();
+
+        // Meshes loaded with Model::LoadFlags::KeepCpuGeometry are used as-is. The others are read back from the GPU.
+        // Record all the buffer reads first, so that we only wait for the GPU once
+        RenderContext* pContext = gpDevice->getRenderContext().get();
+        BufferReads reads;
+        auto readBuffer = [&](const Buffer* pBuffer)
+        {
+            if (pBuffer && reads.find(pBuffer) == reads.end()) reads[pBuffer] = pContext->asyncReadBuffer(pBuffer);
+        };
+
+        for (uint32_t modelId = 0; modelId < mpScene->getModelCount(); modelId++)
+        {
+            const Model* pModel = mpScene->getModel(modelId).get();
+            for (uint32_t meshId = 0; meshId < pModel->getMeshCount(); meshId++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshId).get();
+                if (pMesh->getCpuGeometry()) continue;
+                const Vao* pVao = pMesh->getVao().get();
+                for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++) readBuffer(pVao->getVertexBuffer(i).get());
+                readBuffer(pVao->getIndexBuffer().get());
+            }
+        }
+
+        if (reads.size())
+        {
+            logInfo("CpuPathTracer - some meshes don't have CPU geometry, reading them back from the GPU. Load the models with Model::LoadFlags::KeepCpuGeometry to avoid it");
+        }
+
+        std::unordered_map<const Mesh*, std::shared_ptr<const Mesh::CpuGeometry>> meshes;
+        std::vector<glm::vec3> positions;
+        for (uint32_t modelId = 0; modelId < mpScene->getModelCount(); modelId++)
+        {
+            const Model* pModel = mpScene->getModel(modelId).get();
+            for (uint32_t meshId = 0; meshId < pModel->getMeshCount(); meshId++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshId).get();
+                if (pMesh->getMaterial() == nullptr) continue;
+                auto meshIt = meshes.find(pMesh);
+                if (meshIt == meshes.end())
+                {
+                    std::shared_ptr<const Mesh::CpuGeometry> pGeometry = pMesh->getCpuGeometry();
+                    if (pGeometry && isValidGeometry(*pGeometry) == false)
+                    {
+                        logWarning("CpuPathTracer - the mesh CPU geometry is inconsistent. Skipping mesh");
+                        pGeometry = nullptr;
+                    }
+                    else if (pGeometry == nullptr)
+                    {
+                        auto pReadback = std::make_shared<Mesh::CpuGeometry>();
+                        if (readMeshGeometry(pMesh, reads, *pReadback)) pGeometry = pReadback;
+                    }
+                    meshIt = meshes.emplace(pMesh, pGeometry).first;
+                }
+
+                if (meshIt->second == nullptr || meshIt->second->indices.empty()) continue;
+                const Mesh::CpuGeometry& geometry = *meshIt->second;
+                const uint32_t materialId = getMaterialId(pMesh->getMaterial().get());
+
+                for (uint32_t modelInstance = 0; modelInstance < mpScene->getModelInstanceCount(modelId); modelInstance++)
+                {
+                    const glm::mat4& modelWorld = mpScene->getModelInstance(modelId, modelInstance)->getTransformMatrix();
+                    for (uint32_t meshInstance = 0; meshInstance < pModel->getMeshInstanceCount(meshId); meshInstance++)
+                    {
+                        const glm::mat4 world = modelWorld * pModel->getMeshInstance(meshId, meshInstance)->getTransformMatrix();
+                        const glm::mat3 normalMat = glm::transpose(glm::inverse(glm::mat3(world)));
+
+                        for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3)
+                        {
+                            TriangleAttribs tri;
+                            glm::vec3 p[3];
+                            for (uint32_t v = 0; v < 3; v++)
+                            {
+                                uint32_t index = geometry.indices[i + v];
+                                p[v] = glm::vec3(world * glm::vec4(geometry.positions[index], 1));
+                                tri.normals[v] = geometry.normals.empty() ? glm::vec3(0) : normalMat * geometry.normals[index];
+                                tri.texCrd[v] = geometry.texCrd.empty() ? glm::vec2(0) : geometry.texCrd[index];
+                                positions.push_back(p[v]);
+                            }
+                            glm::vec3 faceNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+                            float area = glm::length(faceNormal);
+                            tri.faceNormal = (area > 0) ? faceNormal / area : glm::vec3(0, 1, 0);
+                            tri.materialId = materialId;
+                            mTriangles.push_back(tri);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Area lights are created from emissive meshes, which are already sampled through the emissive triangle table
+        for (uint32_t i = 0; i < mpScene->getLightCount(); i++)
+        {
+            const LightData& light = mpScene->getLight(i)->getData();
+            if (light.type != LightArea)
+            {
+                mLights.push_back(light);
+            }
+        }
+
+        if (mpEmissiveTriangles == nullptr)
+        {
+            mpEmissiveTriangles = EmissiveTriangleTable::create();
+        }
+        mpEmissiveTriangles->update(mpScene.get());
+
+        mpBvh = CpuBvh::create(positions);
+        if (mpBvh == nullptr)
+        {
+            logWarning("CpuPathTracer - the scene doesn't contain any supported geometry");
+            return false;
+        }
+        return true;
+    }
+
+    bool CpuPathTracer::alphaTestPassed(const CpuBvh::Hit& hit) const
+    {
+        const TriangleAttribs& tri = mTriangles[hit.primId];
+        const ShadingMaterial& material = mMaterials[tri.materialId];
+        if (material.pAlphaMap == nullptr) return true;
+
+        glm::vec2 uv = tri.texCrd[0] * (1 - hit.u - hit.v) + tri.texCrd[1] * hit.u + tri.texCrd[2] * hit.v;
+        return material.pAlphaMap->sample(uv).x >= material.values.alphaThreshold;
+    }
+
+    bool CpuPathTracer::closestHit(const glm::vec3& origin, const glm::vec3& dir, CpuBvh::Hit& hit) const
+    {
+        float tMin = 0;
+        for (uint32_t i = 0; i < kMaxAlphaTestIterations; i++)
+        {
+            if (mpBvh->intersect(origin, dir, tMin, FLT_MAX, hit) == false) return false;
+            if (alphaTestPassed(hit)) return true;
+            // Continue past the alpha-tested hit
+            tMin = hit.t;
+        }
+        return false;
+    }
+
+    bool CpuPathTracer::isVisible(const glm::vec3& origin, const glm::vec3& dir, float distance) const
+    {
+        if (mHasAlphaTest == false)
+        {
+            return mpBvh->occluded(origin, dir, 0, distance) == false;
+        }
+
+        float tMin = 0;
+        for (uint32_t i = 0; i < kMaxAlphaTestIterations; i++)
+        {
+            CpuBvh::Hit hit;
+            if (mpBvh->intersect(origin, dir, tMin, distance, hit) == false) return true;
+            if (alphaTestPassed(hit)) return false;
+            tMin = hit.t;
+        }
+        return false;
+    }
+
+    static glm::vec3 offsetRayOrigin(const glm::vec3& P, const glm::vec3& Ng, const glm::vec3& dir)
+    {
+        // Scale the offset with the magnitude of the position, to stay above the floating-point error of the intersection
+        float maxCoord = glm::max(glm::max(fabsf(P.x), fabsf(P.y)), fabsf(P.z));
+        float epsilon = 1e-4f * (1 + maxCoord);
+        return P + Ng * ((glm::dot(Ng, dir) >= 0) ? epsilon : -epsilon);
+    }
+
+    void CpuPathTracer::prepareShadingPoint(const CpuBvh::Hit& hit, const glm::vec3& origin, const glm::vec3& dir, ShadingPoint& sp) const
+    {
+        const TriangleAttribs& tri = mTriangles[hit.primId];
+        const float w = 1 - hit.u - hit.v;
+        sp.pMaterial = &mMaterials[tri.materialId];
+        sp.P = origin + dir * hit.t;
+        sp.E = -dir;
+
+        // Shade both sides of the surface
+        sp.Ng = (glm::dot(tri.faceNormal, sp.E) >= 0) ? tri.faceNormal : -tri.faceNormal;
+        glm::vec3 N = tri.normals[0] * w + tri.normals[1] * hit.u + tri.normals[2] * hit.v;
+        float length = glm::length(N);
+        sp.N = (length > 0) ? N / length : sp.Ng;
+        if (glm::dot(sp.N, sp.Ng) < 0) sp.N = -sp.N;
+
+        // Same frame as createTangentFrame() in Helpers.slang
+        if (fabsf(sp.N.x) > fabsf(sp.N.y))
+        {
+            sp.B = glm::vec3(sp.N.z, 0, -sp.N.x) / glm::length(glm::vec2(sp.N.x, sp.N.z));
+        }
+        else
+        {
+            sp.B = glm::vec3(0, sp.N.z, -sp.N.y) / glm::length(glm::vec2(sp.N.y, sp.N.z));
+        }
+        sp.T = glm::normalize(glm::cross(sp.B, sp.N));
+
+        // Prefetch the layer albedos, like prepareShadingAttribs()
+        const glm::vec2 uv = tri.texCrd[0] * w + tri.texCrd[1] * hit.u + tri.texCrd[2] * hit.v;
+        for (uint32_t i = 0; i < MatMaxLayers; i++)
+        {
+            const Image* pImage = sp.pMaterial->pLayerImages[i];
+            sp.albedo[i] = pImage ? pImage->sample(uv) : sp.pMaterial->values.layers[i].albedo;
+        }
+    }
+
+    /** Host versions of the BSDF helpers in ShadingUtils/BSDFs.slang and the layer evaluation in ShadingUtils/Shading.slang
+    */
+    static float evalDiffuseBSDF(const glm::vec3& N, const glm::vec3& L)
+    {
+        return glm::max(0.f, glm::dot(N, L)) * (float)M_1_PI;
+    }
+
+    static float dielectricFresnel(float NdE, float IoR)
+    {
+        const float realIoR = (NdE >= 0.f) ? 1.f / IoR : IoR;
+        const float NdL2 = 1.f - realIoR * realIoR * (1.f - NdE * NdE);
+        if (NdL2 <= 0.f) return 1.f;
+        const float NdL = sqrt(NdL2);
+        NdE = fabsf(NdE);
+        const float Rp = (IoR * NdL - NdE) / (IoR * NdL + NdE);
+        const float Rs = (NdE - IoR * NdL) / (NdE + IoR * NdL);
+        return (Rp * Rp + Rs * Rs) * .5f;
+    }
+
+    static float conductorFresnel(float NdE, float IoR, float kappa)
+    {
+        const float kappa2 = kappa * kappa;
+        const float totalIoR2 = IoR * IoR + kappa2;
+        NdE = glm::clamp(NdE, 0.f, 1.f);
+        const float NdE2 = NdE * NdE;
+        const float reducedNdE2 = totalIoR2 * NdE2;
+        const float Rp2 = (reducedNdE2 - IoR * NdE * 2.f + 1.f) / (reducedNdE2 + IoR * NdE * 2.f + 1.f);
+        const float Rs2 = (totalIoR2 - IoR * NdE * 2.f + NdE2) / (totalIoR2 + IoR * NdE * 2.f + NdE2);
+        return (Rp2 + Rs2) * .5f;
+    }
+
+    static float evalBeckmannDistribution(const glm::vec3& H, const glm::vec2& rgns)
+    {
+        const float NoH2 = H.z * H.z;
+        const glm::vec2 Hproj(H.x, H.y);
+        const float exponent = glm::dot(Hproj / (rgns * rgns), Hproj) / NoH2;
+        return exp(-exponent) / ((float)M_PI * rgns.x * rgns.y * NoH2 * NoH2);
+    }
+
+    static float evalGGXDistribution(const glm::vec3& H, const glm::vec2& rgns)
+    {
+        const float anisoU = rgns.y < rgns.x ? rgns.y / rgns.x : 1.f;
+        const float anisoV = rgns.x < rgns.y ? rgns.x / rgns.y : 1.f;
+        const float r = glm::min(rgns.x, rgns.y);
+        const float NoH2 = H.z * H.z;
+        const glm::vec2 Hproj(H.x, H.y);
+        const float exponent = glm::dot(Hproj / glm::vec2(anisoU * anisoU, anisoV * anisoV), Hproj);
+        const float root = NoH2 * r * r + exponent;
+        return r * r / ((float)M_PI * anisoU * anisoV * root * root);
+    }
+
+    static float effectiveVisibleRoughness(const glm::vec3& dir, const glm::vec2& rghns)
+    {
+        const float recipSinThSq = 1.f / (1.f - dir.z * dir.z);
+        const glm::vec2 dirPlane(dir.x, dir.y);
+        const glm::vec2 cosSinPhiSq = dirPlane * dirPlane * recipSinThSq;
+        const glm::vec2 res = rghns * rghns * cosSinPhiSq;
+        return sqrt(res.x + res.y);
+    }
+
+    static float GSmith(const glm::vec3& dir, const glm::vec3& h, const glm::vec2& rghns, uint32_t ndfType)
+    {
+        if (glm::dot(dir, h) * dir.z <= 0.f) return 0.f;
+        const float sinThSq = 1.f - dir.z * dir.z;
+        if (sinThSq <= 0.f) return 1.f;
+        const float recipSlope = sqrt(sinThSq) / dir.z;
+        const float alpha = effectiveVisibleRoughness(dir, rghns);
+        if (ndfType == NDFBeckmann)
+        {
+            const float a = 1.f / (alpha * recipSlope);
+            if (a > 1.6f) return 1.f;
+            const float aSq = a * a;
+            return (3.535f * a + 2.181f * aSq) / (1.f + 2.276f * a + 2.577f * aSq);
+        }
+
+        const float isectRoot = alpha * recipSlope;
+        return 2.f / (1.f + glm::length(glm::vec2(1.f, isectRoot)));
+    }
+
+    static glm::vec4 evalSpecularLayer(const MaterialLayerDesc& desc, const MaterialLayerValues& data, const glm::vec4& albedo, const glm::vec3& T, const glm::vec3& B, const glm::vec3& N, const glm::vec3& E, const glm::vec3& L, const glm::vec3& lightIntensity)
+    {
+        // Ignore the layer if it's a transmission or backfacing
+        if (glm::dot(L, N) * glm::dot(E, N) <= 0.f) return glm::vec4(0);
+
+        glm::vec2 roughness = (desc.hasTexture & ROUGHNESS_CHANNEL_BIT) ? glm::vec2(albedo.w) : glm::vec2(data.roughness);
+        roughness *= roughness;
+
+        // Respect perfect specular cutoff
+        if (glm::max(roughness.x, roughness.y) < 1e-3f) return glm::vec4(0);
+
+        const glm::vec3 hW = glm::normalize(E + L);
+        const glm::vec3 h = glm::normalize(glm::vec3(glm::dot(hW, T), glm::dot(hW, B), glm::dot(hW, N)));
+
+        glm::vec3 value = lightIntensity;
+        value *= (desc.ndf == NDFBeckmann) ? evalBeckmannDistribution(h, roughness) : evalGGXDistribution(h, roughness);
+
+        // Shadowing and masking
+        const glm::vec3 lTg(glm::dot(T, L), glm::dot(B, L), glm::dot(N, L));
+        const glm::vec3 vTg(glm::dot(T, E), glm::dot(B, E), glm::dot(N, E));
+        value *= GSmith(vTg, h, roughness, desc.ndf) * GSmith(lTg, h, roughness, desc.ndf);
+
+        // Cook-Torrance Jacobian
+        value /= 4.f * glm::dot(E, N);
+
+        const float HoE = glm::dot(hW, E);
+        const float F = (desc.type == MatConductor) ? conductorFresnel(HoE, data.extraParam.x, data.extraParam.y) : 1.f - dielectricFresnel(HoE, data.extraParam.x);
+        return glm::vec4(value * F, F);
+    }
+
+    static glm::vec3 blendLayer(const glm::vec4& albedo, const glm::vec4& layerOut, uint32_t blendType, const glm::vec3& currentValue)
+    {
+        const glm::vec3 scaledLayerOut = glm::vec3(layerOut) * glm::vec3(albedo);
+        const float weight = (blendType == BlendConstant) ? albedo.w : layerOut.w;
+        return (blendType != BlendAdd) ? glm::mix(currentValue, scaledLayerOut, weight) : currentValue + scaledLayerOut;
+    }
+
+    glm::vec3 CpuPathTracer::evalMaterial(const ShadingPoint& sp, const glm::vec3& L, const glm::vec3& lightIntensity) const
+    {
+        glm::vec3 value(0);
+        for (uint32_t i = 0; i < MatMaxLayers; i++)
+        {
+            const MaterialLayerDesc& desc = sp.pMaterial->desc.layers[i];
+            if (desc.type == MatNone) break;
+
+            glm::vec4 layerOut(0);
+            switch (desc.type)
+            {
+            case MatLambert:
+                layerOut = glm::vec4(lightIntensity * evalDiffuseBSDF(sp.N, L), sp.albedo[i].w);
+                break;
+            case MatConductor:
+            case MatDielectric:
+                layerOut = evalSpecularLayer(desc, sp.pMaterial->values.layers[i], sp.albedo[i], sp.T, sp.B, sp.N, sp.E, L, lightIntensity);
+                break;
+            }
+            value = blendLayer(sp.albedo[i], layerOut, desc.blending, value);
+        }
+        return value;
+    }
+
+    glm::vec3 CpuPathTracer::evalEmission(const ShadingPoint& sp) const
+    {
+        // Emissive layers are evaluated separately from the lights, so that they are only counted once per path vertex
+        glm::vec3 value(0);
+        for (uint32_t i = 0; i < MatMaxLayers; i++)
+        {
+            const MaterialLayerDesc& desc = sp.pMaterial->desc.layers[i];
+            if (desc.type == MatNone) break;
+            glm::vec4 layerOut = (desc.type == MatEmissive) ? glm::vec4(1) : glm::vec4(0);
+            value = blendLayer(sp.albedo[i], layerOut, desc.blending, value);
+        }
+        return value;
+    }
+
+    glm::vec3 CpuPathTracer::evalDirectLighting(const ShadingPoint& sp) const
+    {
+        glm::vec3 result(0);
+        for (const LightData& light : mLights)
+        {
+            // Same attenuation as prepareLightAttribs() in ShadingUtils/Lights.slang
+            glm::vec3 L;
+            glm::vec3 intensity = light.intensity;
+            float distance = FLT_MAX;
+            if (light.type == LightDirectional)
+            {
+                L = -glm::normalize(light.worldDir);
+            }
+            else
+            {
+                const glm::vec3 posToLight = light.worldPos - sp.P;
+                const float distSq = glm::dot(posToLight, posToLight);
+                if (distSq <= 1e-3f) continue;
+                distance = sqrt(distSq);
+                L = posToLight / distance;
+
+                float atten = 1.f;
+                const float cosTheta = -glm::dot(L, light.worldDir);
+                if (cosTheta < light.cosOpeningAngle) atten = 0.f;
+                if (light.penumbraAngle > 0.f)
+                {
+                    float deltaAngle = light.openingAngle - acos(glm::clamp(cosTheta, -1.f, 1.f));
+                    atten *= glm::clamp((deltaAngle - light.penumbraAngle) / light.penumbraAngle, 0.f, 1.f);
+                }
+                intensity *= atten / glm::max(1e-3f, distSq);
+            }
+
+            const glm::vec3 value = evalMaterial(sp, L, intensity);
+            if (value == glm::vec3(0)) continue;
+
+            const glm::vec3 origin = offsetRayOrigin(sp.P, sp.Ng, L);
+            if (isVisible(origin, L, distance))
+            {
+                result += value;
+            }
+        }
+        return result;
+    }
+
+    glm::vec3 CpuPathTracer::evalEmissiveLighting(const ShadingPoint& sp, Rng& rng) const
+    {
+        if (mpEmissiveTriangles->getTriangleCount() == 0) return glm::vec3(0);
+
+        // Pick a triangle proportionally to its flux, then a uniform point on it
+        float pdf;
+        const uint32_t triId = mpEmissiveTriangles->sampleTriangle(rng.next(), pdf);
+        const EmissiveTriangle& tri = mpEmissiveTriangles->getTriangle(triId);
+        if (pdf <= 0) return glm::vec3(0);
+        const glm::vec3 lightPos = EmissiveTriangleTable::sampleTrianglePoint(tri, glm::vec2(rng.next(), rng.next()));
+
+        const glm::vec3 posToLight = lightPos - sp.P;
+        const float distSq = glm::dot(posToLight, posToLight);
+        if (distSq <= 1e-6f) return glm::vec3(0);
+        const float distance = sqrt(distSq);
+        const glm::vec3 L = posToLight / distance;
+
+        // Convert the area pdf into a solid angle pdf. Emissive surfaces are shaded from both sides, like evalEmission()
+        const float cosLight = fabsf(glm::dot(tri.normal, L));
+        if (cosLight <= 0) return glm::vec3(0);
+        const float solidAnglePdf = pdf / tri.area * distSq / cosLight;
+
+        const glm::vec3 value = evalMaterial(sp, L, tri.radiance / solidAnglePdf);
+        if (value == glm::vec3(0)) return value;
+
+        // Stop short of the light, so that the emitter itself doesn't occlude the sample
+        const glm::vec3 origin = offsetRayOrigin(sp.P, sp.Ng, L);
+        return isVisible(origin, L, distance * (1 - 1e-3f)) ? value : glm::vec3(0);
+    }
+
+    glm::vec3 CpuPathTracer::tracePath(glm::vec3 origin, glm::vec3 dir, Rng& rng) const
+    {
+        glm::vec3 radiance(0);
+        glm::vec3 throughput(1);
+        for (uint32_t depth = 0; ; depth++)
+        {
+            CpuBvh::Hit hit;
+            if (closestHit(origin, dir, hit) == false) break;
+
+            ShadingPoint sp;
+            prepareShadingPoint(hit, origin, dir, sp);
+            // Once emissive triangles are sampled explicitly, hitting them after a bounce would count them twice
+            const bool addEmission = (depth == 0) || (mpEmissiveTriangles->getTriangleCount() == 0);
+            radiance += throughput * ((addEmission ? evalEmission(sp) : glm::vec3(0)) + evalDirectLighting(sp) + evalEmissiveLighting(sp, rng));
+            if (depth >= mMaxBounces) break;
+
+            // Cosine-weighted hemisphere sampling
+            const float phi = 2 * (float)M_PI * rng.next();
+            const float r = rng.next();
+            const float sinTheta = sqrt(r);
+            const float cosTheta = sqrt(1 - r);
+            const float pdf = cosTheta * (float)M_1_PI;
+            if (pdf < 1e-6f) break;
+            const glm::vec3 wi = glm::normalize(sp.T * (cos(phi) * sinTheta) + sp.B * (sin(phi) * sinTheta) + sp.N * cosTheta);
+
+            throughput *= evalMaterial(sp, wi, glm::vec3(1)) / pdf;
+            if (throughput == glm::vec3(0)) break;
+
+            if (depth >= kRussianRouletteDepth)
+            {
+                const float survival = glm::min(0.95f, glm::max(throughput.x, glm::max(throughput.y, throughput.z)));
+                if (rng.next() >= survival) break;
+                throughput /= survival;
+            }
+
+            origin = offsetRayOrigin(sp.P, sp.Ng, wi);
+            dir = wi;
+        }
+        return radiance;
+    }
+
+    void CpuPathTracer::renderTile(uint32_t tileX, uint32_t tileY, const CameraData& camera, uint32_t frame)
+    {
+        const uint32_t xEnd = glm::min(mWidth, (tileX + 1) * kTileSize);
+        const uint32_t yEnd = glm::min(mHeight, (tileY + 1) * kTileSize);
+        for (uint32_t y = tileY * kTileSize; y < yEnd; y++)
+        {
+            for (uint32_t x = tileX * kTileSize; x < xEnd; x++)
+            {
+                const uint32_t pixel = y * mWidth + x;
+                Rng rng(pixel, frame);
+                glm::vec3 sum(0);
+                for (uint32_t s = 0; s < mSamplesPerPixel; s++)
+                {
+                    // Unproject a jittered point on the near and far planes
+                    const glm::vec2 ndc((x + rng.next()) / mWidth * 2 - 1, 1 - (y + rng.next()) / mHeight * 2);
+                    const glm::vec4 nearPoint = camera.invViewProj * glm::vec4(ndc, 0, 1);
+                    const glm::vec4 farPoint = camera.invViewProj * glm::vec4(ndc, 1, 1);
+                    const glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+                    const glm::vec3 dir = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+                    sum += tracePath(origin, dir, rng);
+                }
+                mAccumulation[pixel] += sum / (float)mSamplesPerPixel;
+            }
+        }
+    }
+
+    void CpuPathTracer::writeTarget(const Texture* pTexture)
+    {
+        const ResourceFormat format = pTexture->getFormat();
+        const uint32_t bytesPerTexel = getFormatBytesPerBlock(format);
+        const bool srgb = isSrgbFormat(format);
+        const float scale = 1.0f / mAccumulatedFrames;
+
+        std::vector<uint8> data(mAccumulation.size() * bytesPerTexel);
+        for (size_t i = 0; i < mAccumulation.size(); i++)
+        {
+            glm::vec3 c = mAccumulation[i] * scale;
+            uint8* pTexel = data.data() + i * bytesPerTexel;
+            switch (format)
+            {
+            case ResourceFormat::RGBA32Float:
+                ((glm::vec4*)pTexel)[0] = glm::vec4(c, 1);
+                break;
+            case ResourceFormat::RGBA16Float:
+                ((uint64_t*)pTexel)[0] = glm::packHalf4x16(glm::vec4(c, 1));
+                break;
+            case ResourceFormat::RGBA8Unorm:
+            case ResourceFormat::RGBA8UnormSrgb:
+            case ResourceFormat::BGRA8Unorm:
+            case ResourceFormat::BGRA8UnormSrgb:
+            case ResourceFormat::BGRX8Unorm:
+            case ResourceFormat::BGRX8UnormSrgb:
+            {
+                c = glm::clamp(srgb ? LinearToSRGB(c) : c, 0.f, 1.f);
+                const bool bgr = (format != ResourceFormat::RGBA8Unorm) && (format != ResourceFormat::RGBA8UnormSrgb);
+                pTexel[0] = (uint8)(255 * (bgr ? c.z : c.x) + 0.5f);
+                pTexel[1] = (uint8)(255 * c.y + 0.5f);
+                pTexel[2] = (uint8)(255 * (bgr ? c.x : c.z) + 0.5f);
+                pTexel[3] = 255;
+            }
+            break;
+            default:
+                logWarning("CpuPathTracer::render() - target format " + to_string(format) + " is not supported");
+                return;
+            }
+        }
+        gpDevice->getRenderContext()->updateTextureSubresource(pTexture, 0, data.data());
+    }
+
+    bool CpuPathTracer::saveImage(const std::string& filename) const
+    {
+        if (mAccumulatedFrames == 0)
+        {
+            logWarning("CpuPathTracer::saveImage() - no frame was rendered");
+            return false;
+        }
+
+        const float scale = 1.0f / mAccumulatedFrames;
+        const bool pfm = hasSuffix(filename, ".pfm", false);
+        if (pfm || hasSuffix(filename, ".exr", false))
+        {
+            // Bitmap writes HDR images bottom row first, regardless of the isTopDown argument
+            std::vector<glm::vec4> texels(mAccumulation.size());
+            for (uint32_t y = 0; y < mHeight; y++)
+            {
+                for (uint32_t x = 0; x < mWidth; x++)
+                {
+                    texels[(mHeight - 1 - y) * mWidth + x] = glm::vec4(mAccumulation[y * mWidth + x] * scale, 1);
+                }
+            }
+            return Bitmap::saveImage(filename, mWidth, mHeight, pfm ? Bitmap::FileFormat::PfmFile : Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA32Float, kTopDown, texels.data());
+        }
+        else if (hasSuffix(filename, ".png", false))
+        {
+            std::vector<uint8_t> texels(mAccumulation.size() * 4);
+            for (size_t i = 0; i < mAccumulation.size(); i++)
+            {
+                const glm::vec3 c = glm::clamp(LinearToSRGB(mAccumulation[i] * scale), 0.f, 1.f);
+                texels[i * 4 + 0] = (uint8_t)(255 * c.z + 0.5f);
+                texels[i * 4 + 1] = (uint8_t)(255 * c.y + 0.5f);
+                texels[i * 4 + 2] = (uint8_t)(255 * c.x + 0.5f);
+                texels[i * 4 + 3] = 255;
+            }
+            return Bitmap::saveImage(filename, mWidth, mHeight, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::BGRA8Unorm, kTopDown, texels.data());
+        }
+
+        logWarning("CpuPathTracer::saveImage() - unsupported file extension in '" + filename + "'. Use .png, .pfm or .exr");
+        return false;
+    }
+
+    void CpuPathTracer::render(const Camera::SharedPtr& pCamera, uint32_t width, uint32_t height)
+    {
+        if (mpBvh == nullptr || width == 0 || height == 0) return;
+
+        const CameraData& camera = pCamera->getData();
+        if (width != mWidth || height != mHeight || camera.viewProjMat != mViewProj)
+        {
+            mWidth = width;
+            mHeight = height;
+            mViewProj = camera.viewProjMat;
+            mAccumulation.resize(mWidth * mHeight);
+            mAccumulatedFrames = 0;
+        }
+
+        if (mAccumulatedFrames == 0)
+        {
+            std::fill(mAccumulation.begin(), mAccumulation.end(), glm::vec3(0));
+        }
+
+        // Threads grab tiles from a shared counter, so that expensive tiles don't stall a static partition
+        const uint32_t tilesX = (mWidth + kTileSize - 1) / kTileSize;
+        const uint32_t tilesY = (mHeight + kTileSize - 1) / kTileSize;
+        const uint32_t tileCount = tilesX * tilesY;
+        std::atomic<uint32_t> nextTile(0);
+        auto worker = [&]()
+        {
+            for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+            {
+                renderTile(tile % tilesX, tile / tilesX, camera, mFrameIndex);
+            }
+        };
+
+        uint32_t threadCount = mThreadCount ? mThreadCount : std::thread::hardware_concurrency();
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& t : threads) t.join();
+
+        mAccumulatedFrames++;
+        mFrameIndex++;
+    }
+
+    void CpuPathTracer::render(const Fbo::SharedPtr& pTarget, const Camera::SharedPtr& pCamera)
+    {
+        if (mpBvh == nullptr) return;
+
+        const Texture::SharedPtr& pTexture = pTarget->getColorTexture(0);
+        if (pTexture == nullptr)
+        {
+            logWarning("CpuPathTracer::render() - the target FBO doesn't have a color texture at index 0");
+            return;
+        }
+
+        render(pCamera, pTexture->getWidth(), pTexture->getHeight());
+        writeTarget(pTexture.get());
+    }
+}
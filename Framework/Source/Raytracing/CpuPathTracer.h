@@ -0,0 +1,194 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Scene/Scene.h"
+#include "API/FBO.h"
+#include "Graphics/Scene/EmissiveTriangleTable.h"
+#include "Raytracing/CpuBvh.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    /** A CPU reference path tracer.
+        Traces and shades all the paths on the CPU, so it can produce ground-truth images on machines without OptiX support. The Fbo overload of render() mirrors RTContext::render(), so samples can switch between the two.
+        Geometry, materials and lights are read from the scene when the object is created, or when calling rebuild(). Materials are evaluated with the same layered model used by the rasterizer (ShadingUtils/Shading.slang).
+        The scene is read from system memory when possible: meshes loaded with Model::LoadFlags::KeepCpuGeometry and textures which have a source file don't touch the GPU. Other meshes and textures are read back from the GPU, once, in rebuild().
+        Each call to render() adds a frame to a progressive accumulation buffer. The accumulation restarts when the camera or the image size changes.
+        The result stays on the CPU (getAccumulationBuffer(), saveImage()), unless rendering into an Fbo, which uploads it into the target texture.
+        Emissive geometry is sampled as a light source through an EmissiveTriangleTable, so AreaLight objects are skipped.
+        Limitations: only triangle lists are supported, skinning and normal maps are ignored and perfectly specular layers don't scatter indirect light.
+    */
+    class CpuPathTracer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuPathTracer>;
+        using SharedConstPtr = std::shared_ptr<const CpuPathTracer>;
+
+        /** Create a new object
+            \param[in] pScene The scene to render
+            \return A new object, or nullptr if the scene doesn't contain any supported geometry
+        */
+        static SharedPtr create(const Scene::SharedPtr& pScene);
+
+        /** Render a frame and accumulate it. The result is only written into the CPU accumulation buffer
+            \param[in] pCamera The camera to render from
+            \param[in] width The image width in pixels
+            \param[in] height The image height in pixels
+        */
+        void render(const Camera::SharedPtr& pCamera, uint32_t width, uint32_t height);
+
+        /** Render a frame, accumulate it and upload the average into a texture
+            \param[in] pTarget The target FBO. The result is written into color target 0, which must be RGBA32Float, RGBA16Float or an 8-bit RGBA/BGRA format
+            \param[in] pCamera The camera to render from
+        */
+        void render(const Fbo::SharedPtr& pTarget, const Camera::SharedPtr& pCamera);
+
+        /** Get the accumulation buffer. It holds the sum of the accumulated frames in linear radiance, top row first. Divide by getAccumulatedFrameCount() to get the image
+        */
+        const std::vector<glm::vec3>& getAccumulationBuffer() const { return mAccumulation; }
+
+        /** Get the size of the accumulation buffer
+        */
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+
+        /** Save the accumulated image to a file, without going through the GPU
+            \param[in] filename The output file. .pfm and .exr files store the linear radiance, .png files are converted to 8-bit sRGB
+            \return false if nothing was rendered yet or the file couldn't be written
+        */
+        bool saveImage(const std::string& filename) const;
+
+        /** Re-read the scene geometry, materials and lights. Call this after the scene was modified
+        */
+        bool rebuild();
+
+        /** Restart the progressive accumulation
+        */
+        void resetAccumulation() { mAccumulatedFrames = 0; }
+
+        /** Get the number of frames accumulated into the current image
+        */
+        uint32_t getAccumulatedFrameCount() const { return mAccumulatedFrames; }
+
+        /** Set the maximal number of indirect bounces. 0 means direct lighting only
+        */
+        void setMaxBounces(uint32_t bounces) { mMaxBounces = bounces; resetAccumulation(); }
+        uint32_t getMaxBounces() const { return mMaxBounces; }
+
+        /** Set the number of paths traced per-pixel in each frame
+        */
+        void setSamplesPerPixel(uint32_t spp) { mSamplesPerPixel = (spp > 0) ? spp : 1; resetAccumulation(); }
+        uint32_t getSamplesPerPixel() const { return mSamplesPerPixel; }
+
+        /** Set the number of worker threads. 0 means one thread per hardware thread
+        */
+        void setThreadCount(uint32_t count) { mThreadCount = count; }
+        uint32_t getThreadCount() const { return mThreadCount; }
+
+        /** Get the BVH
+        */
+        const CpuBvh::SharedConstPtr getBvh() const { return mpBvh; }
+
+    private:
+        CpuPathTracer(const Scene::SharedPtr& pScene) : mpScene(pScene) {}
+
+        struct Image
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<glm::vec4> texels;
+            glm::vec4 sample(const glm::vec2& uv) const;
+        };
+
+        struct ShadingMaterial
+        {
+            MaterialDesc desc;
+            MaterialValues values;
+            const Image* pLayerImages[MatMaxLayers] = {};
+            const Image* pAlphaMap = nullptr;
+        };
+
+        struct TriangleAttribs
+        {
+            glm::vec3 normals[3];
+            glm::vec2 texCrd[3];
+            glm::vec3 faceNormal;
+            uint32_t materialId;
+        };
+
+        struct ShadingPoint
+        {
+            glm::vec3 P;
+            glm::vec3 N;
+            glm::vec3 T;
+            glm::vec3 B;
+            glm::vec3 Ng;
+            glm::vec3 E;
+            glm::vec4 albedo[MatMaxLayers];
+            const ShadingMaterial* pMaterial;
+        };
+
+        class Rng;
+
+        const Image* getImage(const Texture::SharedPtr& pTexture);
+        uint32_t getMaterialId(const Material* pMaterial);
+        bool alphaTestPassed(const CpuBvh::Hit& hit) const;
+        bool closestHit(const glm::vec3& origin, const glm::vec3& dir, CpuBvh::Hit& hit) const;
+        bool isVisible(const glm::vec3& origin, const glm::vec3& dir, float distance) const;
+        void prepareShadingPoint(const CpuBvh::Hit& hit, const glm::vec3& origin, const glm::vec3& dir, ShadingPoint& sp) const;
+        glm::vec3 evalMaterial(const ShadingPoint& sp, const glm::vec3& L, const glm::vec3& lightIntensity) const;
+        glm::vec3 evalEmission(const ShadingPoint& sp) const;
+        glm::vec3 evalDirectLighting(const ShadingPoint& sp) const;
+        glm::vec3 evalEmissiveLighting(const ShadingPoint& sp, Rng& rng) const;
+        glm::vec3 tracePath(glm::vec3 origin, glm::vec3 dir, Rng& rng) const;
+        void renderTile(uint32_t tileX, uint32_t tileY, const CameraData& camera, uint32_t frame);
+        void writeTarget(const Texture* pTexture);
+
+        Scene::SharedPtr mpScene;
+        CpuBvh::SharedPtr mpBvh;
+        std::vector<TriangleAttribs> mTriangles;
+        std::vector<ShadingMaterial> mMaterials;
+        std::unordered_map<const Material*, uint32_t> mMaterialIds;
+        std::unordered_map<const Texture*, Image> mImages;
+        std::vector<LightData> mLights;
+        EmissiveTriangleTable::SharedPtr mpEmissiveTriangles;
+        bool mHasAlphaTest = false;
+
+        uint32_t mMaxBounces = 3;
+        uint32_t mSamplesPerPixel = 1;
+        uint32_t mThreadCount = 0;
+
+        // Accumulation state
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        uint32_t mAccumulatedFrames = 0;
+        uint32_t mFrameIndex = 0;
+        glm::mat4 mViewProj;
+        std::vector<glm::vec3> mAccumulation;
+    };
+}
@@ -155,9 +155,13 @@ namespace Falcor
         mpDefaultFBO.reset();
         mpTextRenderer.reset();
         mpPixelZoom.reset();
+        mpTelemetry.reset();
         mpRenderContext.reset();
         gpDevice->cleanup();
         gpDevice.reset();
+
+        // Make sure the screen captures still being encoded make it to disk
+        Bitmap::flushPendingExports();
     }
 
     void Sample::run(const SampleConfig& config)
@@ -220,6 +224,7 @@ namespace Falcor
         // Load and run
         mArgList.parseCommandLine(GetCommandLineA());
         mpPixelZoom = PixelZoom::create(mpDefaultFBO.get());
+        initTelemetry();
 
         onLoad();
         pBar = nullptr;
@@ -296,6 +301,11 @@ namespace Falcor
             mpGui->endGroup();
         }
 
+        if (mpTelemetry)
+        {
+            mpTelemetry->renderUI(mpGui.get(), "Telemetry");
+        }
+
         onGuiRender();
         mpGui->popWindow();
 
@@ -314,6 +324,7 @@ namespace Falcor
         }
 
         mFrameRate.newFrame();
+        if (mpTelemetry) mpTelemetry->beginFrame();
         {
             PROFILE(onFrameRender);
             // The swap-chain FBO might have changed between frames, so get it
@@ -343,13 +354,29 @@ namespace Falcor
         {
             captureScreen();
         }
+        if (mpTelemetry) mpTelemetry->beginPresent();
         {
             PROFILE(present);
             gpDevice->present();
         }
+        if (mpTelemetry) mpTelemetry->endFrame(mFrameRate.getFrameCount(), mFrameRate.getLastFrameTime());
+    }
+
+    void Sample::initTelemetry()
+    {
+        // -telemetry <file> streams the per-frame records to a file, -telemetryport <port> to a local TCP listener. -telemetryjson switches from CSV to JSON lines
+        FrameTelemetry::Desc desc;
+        std::vector<ArgList::Arg> file = mArgList.getValues("telemetry");
+        std::vector<ArgList::Arg> port = mArgList.getValues("telemetryport");
+        if (file.empty() && port.empty()) return;
+
+        if (!file.empty()) desc.filename = file[0].asString();
+        if (!port.empty()) desc.port = (uint16_t)port[0].asUint();
+        desc.format = mArgList.argExists("telemetryjson") ? FrameTelemetry::ExportFormat::Json : FrameTelemetry::ExportFormat::Csv;
+        mpTelemetry = FrameTelemetry::create(desc);
     }
 
-    void Sample::captureScreen()
+    std::string Sample::getScreenCaptureFilename() const
     {
         std::string filename = getExecutableName();
 
@@ -357,16 +384,24 @@ namespace Falcor
         std::string prefix = std::string(filename);
         std::string executableDir = getExecutableDirectory();
         std::string pngFile;
-        if (findAvailableFilename(prefix, executableDir, "png", pngFile))
+        if (findAvailableFilename(prefix, executableDir, "png", pngFile) == false)
         {
-            Texture::SharedPtr pTexture = gpDevice->getSwapChainFbo()->getColorTexture(0);
-            pTexture->captureToFile(0, 0, pngFile);
+            logError("Could not find available filename when capturing screen");
+            pngFile.clear();
         }
-        else
+        return pngFile;
+    }
+
+    std::string Sample::captureScreen()
+    {
+        std::string pngFile = getScreenCaptureFilename();
+        if (pngFile.size())
         {
-            logError("Could not find available filename when capturing screen");
+            Texture::SharedPtr pTexture = gpDevice->getSwapChainFbo()->getColorTexture(0);
+            pTexture->captureToFile(0, 0, pngFile);
         }
         mCaptureScreen = false;
+        return pngFile;
     }
 
     void Sample::initUI()
@@ -484,11 +519,17 @@ namespace Falcor
     {
         if (mVideoCapture.pVideoCapture)
         {
+            // Make sure all the frames in flight were appended
+            if (mVideoCapture.pLastFrameReadback)
+            {
+                mVideoCapture.pLastFrameReadback->wait();
+            }
             mVideoCapture.pVideoCapture->endCapture();
             mShowUI = true;
         }
         mVideoCapture.pUI = nullptr;
         mVideoCapture.pVideoCapture = nullptr;
+        mVideoCapture.pLastFrameReadback = nullptr;
         safe_delete_array(mVideoCapture.pFrame);
     }
 
@@ -496,7 +537,10 @@ namespace Falcor
     {
         if (mVideoCapture.pVideoCapture)
         {
-            mVideoCapture.pVideoCapture->appendFrame(mpRenderContext->readTextureSubresource(mpDefaultFBO->getColorTexture(0).get(), 0).data());
+            // Frames are appended by the readback callback. Readbacks complete in order, so the frames will be in the right order
+            VideoEncoder* pEncoder = mVideoCapture.pVideoCapture.get();
+            auto appendFunc = [pEncoder](const std::vector<uint8>& data) { pEncoder->appendFrame(data.data()); };
+            mVideoCapture.pLastFrameReadback = mpRenderContext->asyncReadTextureSubresource(mpDefaultFBO->getColorTexture(0).get(), 0, appendFunc);
 
             if (mVideoCapture.pUI->useTimeRange())
             {
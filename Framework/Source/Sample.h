@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include "API/Window.h"
 #include "utils/FrameRate.h"
+#include "Utils/FrameTelemetry.h"
 #include "utils/Gui.h"
 #include "utils/TextRenderer.h"
 #include "API/RenderContext.h"
@@ -169,13 +170,22 @@ namespace Falcor
         virtual float getTimeScale() final { return mTimeScale; }
         void initVideoCapture();
     
-        void captureScreen();
+        /** Save the swap-chain image to the next available <exe name>.<n>.png file in the executable directory
+            \return The screenshot filename, or an empty string if no filename was available
+        */
+        std::string captureScreen();
+
+        /** Find the next available <exe name>.<n>.png file in the executable directory
+            \return The filename, or an empty string if no filename was available
+        */
+        std::string getScreenCaptureFilename() const;
         void toggleText(bool enabled);
         uint32_t getFrameID() const { return mFrameRate.getFrameCount(); }
 
     private:
         // Private functions
         void initUI();
+        void initTelemetry();
         void printProfileData();
         void calculateTime();
 
@@ -196,12 +206,14 @@ namespace Falcor
             VideoEncoderUI::UniquePtr pUI;
             VideoEncoder::UniquePtr pVideoCapture;
             uint8_t* pFrame = nullptr;
+            ReadbackRequest::SharedPtr pLastFrameReadback;
             float timeDelta;
         };
 
         VideoCaptureData mVideoCapture;
 
         FrameRate mFrameRate;
+        FrameTelemetry::SharedPtr mpTelemetry;            ///< Only created when telemetry is requested on the command line
         float mTimeScale;
 
         TextRenderer::UniquePtr mpTextRenderer;
@@ -29,6 +29,24 @@
 
 namespace Falcor
 {
+    static const uint32_t kPerfHistogramBins = 32;
+
+    static std::string escapeXmlAttribute(const std::string& str)
+    {
+        std::string result;
+        for (char c : str)
+        {
+            switch (c)
+            {
+            case '&': result += "&amp;"; break;
+            case '<': result += "&lt;"; break;
+            case '>': result += "&gt;"; break;
+            case '"': result += "&quot;"; break;
+            default: result += c;
+            }
+        }
+        return result;
+    }
 
     bool SampleTest::hasTests() const
     {
@@ -41,6 +59,24 @@ namespace Falcor
         {
             initFrameTests();
             initTimeTests();
+
+            //  In-process screenshot comparison. Screenshot i is compared against <prefix>i.png
+            std::vector<ArgList::Arg> imageDiffRef = mArgList.getValues("imagediffref");
+            if (!imageDiffRef.empty())
+            {
+                mImageDiffRefPrefix = imageDiffRef[0].asString();
+            }
+
+            //  Statistical perf mode. The profiler has to run for the whole test to fill the event breakdown
+            if (mArgList.argExists("perfstats"))
+            {
+                mPerfStats = true;
+#if _PROFILING_ENABLED
+                gProfileEnabled = true;
+#else
+                logWarning("SampleTest: -perfstats requires _PROFILING_ENABLED. Only CPU frame times will be recorded.");
+#endif
+            }
             onInitializeTesting();
         }
     }
@@ -191,6 +227,14 @@ namespace Falcor
             of << "\tNumMemoryFrameChecks=\"" << std::to_string(numMemFrameCheck) << "\"\n";
             of << "\tNumMemoryTimeChecks=\"" << std::to_string(numMemTimeCheck) << "\"\n";
             of << "/>\n";
+            if (mPerfStats)
+            {
+                writePerfStats(of);
+            }
+            if (!mScreenCompares.empty())
+            {
+                writeImageCompares(of);
+            }
             of << "</TestLog>";
             of.close();
         }
@@ -415,11 +459,14 @@ namespace Falcor
                 captureMemory(frameRate().getFrameCount(), mCurrentTime, true, false);
                 break;
             case TaskType::LoadTime:
+                mCurrentFrameTest->mResult += frameRate().getLastFrameTime();
+                break;
             case TaskType::MeasureFps:
                 mCurrentFrameTest->mResult += frameRate().getLastFrameTime();
+                recordPerfSample();
                 break;
             case TaskType::ScreenCapture:
-                captureScreen();
+                captureTestScreen();
                 //re-enable text
                 toggleText(true);
                 break;
@@ -454,7 +501,7 @@ namespace Falcor
         }
         case TaskType::ScreenCapture:
         {
-            captureScreen();
+            captureTestScreen();
             toggleText(true);
             ++mCurrentTimeTest;
             break;
@@ -469,6 +516,7 @@ namespace Falcor
             else
             {
                 mCurrentTimeTest->mResult += frameRate().getLastFrameTime();
+                recordPerfSample();
             }
             break;
         }
@@ -638,4 +686,264 @@ namespace Falcor
         }
     }
 
+
+    void SampleTest::recordPerfSample()
+    {
+        if (mPerfStats == false) return;
+
+        auto getSeries = [this](const std::string& name) -> PerfSeries&
+        {
+            auto it = mPerfSamples.find(name);
+            if (it == mPerfSamples.end())
+            {
+                mPerfEventOrder.push_back(name);
+                it = mPerfSamples.emplace(name, PerfSeries()).first;
+            }
+            return it->second;
+        };
+
+        //  The profiler resolved the previous frame's events in Sample::printProfileData(), so the breakdown lags the frame time by one frame.
+        //  That doesn't matter for the distributions as long as the perf ranges are longer than a couple of frames.
+        float gpuFrameTime = 0;
+        PerfSeries& frame = getSeries("Frame");
+        for (const Profiler::EventData* pEvent : Profiler::getEvents())
+        {
+            PerfSeries& series = getSeries(pEvent->name);
+            series.cpuTimes.push_back(pEvent->lastCpuTime);
+            series.gpuTimes.push_back(pEvent->lastGpuTime);
+            if (pEvent->level == 0)
+            {
+                gpuFrameTime += pEvent->lastGpuTime;
+            }
+        }
+
+        frame.cpuTimes.push_back(frameRate().getLastFrameTime() * 1000.0f);
+        if (gProfileEnabled)
+        {
+            frame.gpuTimes.push_back(gpuFrameTime);
+        }
+    }
+
+    SampleTest::PerfStatistics SampleTest::computePerfStatistics(std::vector<float> samples)
+    {
+        PerfStatistics stats;
+        stats.count = (uint32_t)samples.size();
+        if (samples.empty()) return stats;
+
+        std::sort(samples.begin(), samples.end());
+        stats.min = samples.front();
+        stats.max = samples.back();
+
+        double sum = 0;
+        for (float s : samples) sum += s;
+        stats.mean = sum / samples.size();
+
+        //  Two passes to keep the variance numerically stable for long ranges
+        double sumSq = 0;
+        for (float s : samples) sumSq += (s - stats.mean) * (s - stats.mean);
+        stats.variance = samples.size() > 1 ? sumSq / (samples.size() - 1) : 0;
+
+        //  Linear interpolation between closest ranks
+        auto percentile = [&samples](float p)
+        {
+            float rank = p * (samples.size() - 1);
+            size_t lo = (size_t)rank;
+            size_t hi = std::min(lo + 1, samples.size() - 1);
+            return samples[lo] + (samples[hi] - samples[lo]) * (rank - lo);
+        };
+        stats.p50 = percentile(0.50f);
+        stats.p95 = percentile(0.95f);
+        stats.p99 = percentile(0.99f);
+
+        stats.histogram.assign(kPerfHistogramBins, 0);
+        float range = stats.max - stats.min;
+        for (float s : samples)
+        {
+            uint32_t bin = range > 0 ? (uint32_t)((s - stats.min) / range * kPerfHistogramBins) : 0;
+            stats.histogram[std::min(bin, kPerfHistogramBins - 1)]++;
+        }
+        return stats;
+    }
+
+    void SampleTest::writePerfStats(std::ofstream& of) const
+    {
+        of << "<PerfStats HistogramBins=\"" << kPerfHistogramBins << "\">\n";
+        for (const std::string& name : mPerfEventOrder)
+        {
+            const PerfSeries& series = mPerfSamples.at(name);
+            const std::pair<const char*, const std::vector<float>*> timers[] = { { "Cpu", &series.cpuTimes }, { "Gpu", &series.gpuTimes } };
+            for (const auto& timer : timers)
+            {
+                const std::vector<float>& samples = *timer.second;
+                if (samples.empty()) continue;
+
+                PerfStatistics stats = computePerfStatistics(samples);
+                of << "<Event\n";
+                of << "\tName=\"" << escapeXmlAttribute(name) << "\"\n";
+                of << "\tTimer=\"" << timer.first << "\"\n";
+                of << "\tCount=\"" << stats.count << "\"\n";
+                of << "\tMean=\"" << std::to_string(stats.mean) << "\"\n";
+                of << "\tVariance=\"" << std::to_string(stats.variance) << "\"\n";
+                of << "\tMin=\"" << std::to_string(stats.min) << "\"\n";
+                of << "\tMax=\"" << std::to_string(stats.max) << "\"\n";
+                of << "\tP50=\"" << std::to_string(stats.p50) << "\"\n";
+                of << "\tP95=\"" << std::to_string(stats.p95) << "\"\n";
+                of << "\tP99=\"" << std::to_string(stats.p99) << "\"\n";
+                of << "\tHistogram=\"";
+                for (size_t i = 0; i < stats.histogram.size(); i++)
+                {
+                    of << (i ? " " : "") << stats.histogram[i];
+                }
+                of << "\"\n";
+                //  The raw samples are what the comparator runs its rank test on
+                of << "\tSamples=\"";
+                for (size_t i = 0; i < samples.size(); i++)
+                {
+                    of << (i ? " " : "") << std::to_string(samples[i]);
+                }
+                of << "\"\n";
+                of << "/>\n";
+            }
+        }
+        of << "</PerfStats>\n";
+    }
+
+    void SampleTest::captureTestScreen()
+    {
+        if (mImageDiffRefPrefix.empty())
+        {
+            captureScreen();
+            return;
+        }
+
+        std::unique_ptr<ScreenCompare> pCompare = std::make_unique<ScreenCompare>();
+        pCompare->screenshotFile = getScreenCaptureFilename();
+        if (pCompare->screenshotFile.empty()) return;
+        pCompare->referenceFile = mImageDiffRefPrefix + std::to_string(mScreenCompares.size()) + ".png";
+        bool compare = doesFileExist(pCompare->referenceFile);
+        if (compare == false)
+        {
+            logWarning("SampleTest: can't find reference image " + pCompare->referenceFile + ". The screenshot won't be compared.");
+        }
+
+        Texture::SharedPtr pTexture = gpDevice->getSwapChainFbo()->getColorTexture(0);
+        uint32_t width = pTexture->getWidth();
+        uint32_t height = pTexture->getHeight();
+        ResourceFormat format = pTexture->getFormat();
+
+        //  The entries are heap allocated so that the pointer stays valid while mScreenCompares grows
+        ScreenCompare* pData = pCompare.get();
+        auto readbackFunc = [this, pData, compare, width, height, format](const std::vector<uint8>& textureData)
+        {
+            Bitmap::saveImageAsync(pData->screenshotFile, width, height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, format, true, std::vector<uint8_t>(textureData));
+            if (compare == false) return;
+
+            //  Loading the reference and writing the heat map would stall the frame, so the comparison runs on the worker
+            auto pImage = std::make_shared<std::vector<uint8_t>>(textureData);
+            std::packaged_task<ImageDiff::Result()> job([pData, pImage, width, height, format]
+            {
+                ImageDiff::Result result;
+                Bitmap::UniqueConstPtr pReference = Bitmap::createFromFile(pData->referenceFile, true);
+                if (pReference == nullptr) return result;
+                if (pReference->getWidth() != width || pReference->getHeight() != height)
+                {
+                    logWarning("SampleTest: reference image " + pData->referenceFile + " doesn't match the screen size");
+                    return result;
+                }
+
+                result = ImageDiff::compare(pImage->data(), format, pReference->getData(), pReference->getFormat(), width, height);
+                if (result.valid)
+                {
+                    //  <exe>.<n>.png -> <exe>.<n>.diff.png and <exe>.<n>.tiles.xml
+                    std::string base = pData->screenshotFile.substr(0, pData->screenshotFile.size() - 4);
+                    if (result.mse > 0)
+                    {
+                        ImageDiff::saveHeatMap(result, base + ".diff.png");
+                    }
+                    ImageDiff::saveTileStats(result, base + ".tiles.xml");
+                }
+                return result;
+            });
+            pData->result = job.get_future();
+            queueImageDiff(std::move(job));
+        };
+        pCompare->pReadback = gpDevice->getRenderContext()->asyncReadTextureSubresource(pTexture.get(), 0, readbackFunc);
+        mScreenCompares.push_back(std::move(pCompare));
+    }
+
+    void SampleTest::queueImageDiff(std::packaged_task<ImageDiff::Result()>&& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mDiffWorker.mutex);
+            if (mDiffWorker.thread.joinable() == false)
+            {
+                mDiffWorker.terminate = false;
+                mDiffWorker.thread = std::thread(&SampleTest::runDiffWorker, this);
+            }
+            mDiffWorker.jobs.push_back(std::move(job));
+        }
+        mDiffWorker.jobAdded.notify_one();
+    }
+
+    void SampleTest::runDiffWorker()
+    {
+        std::unique_lock<std::mutex> lock(mDiffWorker.mutex);
+        while (true)
+        {
+            //  The queue is drained before exiting, so every queued comparison gets a result
+            mDiffWorker.jobAdded.wait(lock, [this] { return mDiffWorker.terminate || mDiffWorker.jobs.empty() == false; });
+            if (mDiffWorker.jobs.empty()) return;
+            std::packaged_task<ImageDiff::Result()> job = std::move(mDiffWorker.jobs.front());
+            mDiffWorker.jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    void SampleTest::stopDiffWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mDiffWorker.mutex);
+            mDiffWorker.terminate = true;
+        }
+        mDiffWorker.jobAdded.notify_all();
+        if (mDiffWorker.thread.joinable()) mDiffWorker.thread.join();
+    }
+
+    SampleTest::~SampleTest()
+    {
+        stopDiffWorker();
+    }
+
+    void SampleTest::writeImageCompares(std::ofstream& of)
+    {
+        of << "<ImageCompares>\n";
+        for (size_t i = 0; i < mScreenCompares.size(); i++)
+        {
+            ScreenCompare* pCompare = mScreenCompares[i].get();
+            ImageDiff::Result result;
+            if (pCompare->pReadback)
+            {
+                //  Resolving the request runs the callback, which queues the comparison
+                pCompare->pReadback->wait();
+                if (pCompare->result.valid()) result = pCompare->result.get();
+            }
+
+            of << "\t<ImageCompare";
+            of << " Index=\"" << i << "\"";
+            of << " Reference=\"" << escapeXmlAttribute(pCompare->referenceFile) << "\"";
+            of << " Valid=\"" << (result.valid ? 1 : 0) << "\"";
+            of << " Passed=\"" << (result.passed ? 1 : 0) << "\"";
+            of << " MSE=\"" << result.mse << "\"";
+            of << " PSNR=\"" << result.psnr << "\"";
+            of << " SSIM=\"" << result.ssim << "\"";
+            of << " MeanDeltaE=\"" << result.meanDeltaE << "\"";
+            of << " MaxDeltaE=\"" << result.maxDeltaE << "\"";
+            of << " FailingPixelRatio=\"" << result.failingPixelRatio << "\"";
+            of << "/>\n";
+        }
+        of << "</ImageCompares>\n";
+        stopDiffWorker();
+    }
 }
@@ -27,12 +27,19 @@
 ***************************************************************************/
 #pragma once
 #include "Falcor.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 
 namespace Falcor
 {
     class SampleTest : public Sample
     {
     public:
+        ~SampleTest();
+
         /** Checks whether testing is enabled, returns true if either Test Task vector isn't empty
         */
         bool hasTests() const;
@@ -168,5 +175,83 @@ namespace Falcor
         */
         void captureMemory(uint64_t frameCount, float currentTime, bool frameTest = true, bool endRange = false);
 
+        //  Per-frame samples collected over the perf ranges when running with -perfstats.
+        //  Event "Frame" holds the frame time on the CPU and the sum of the top-level profiler events on the GPU.
+        struct PerfSeries
+        {
+            std::vector<float> cpuTimes;
+            std::vector<float> gpuTimes;
+        };
+
+        //  Order statistics of one series, in ms.
+        struct PerfStatistics
+        {
+            uint32_t count = 0;
+            double mean = 0;
+            double variance = 0;
+            float min = 0;
+            float max = 0;
+            float p50 = 0;
+            float p95 = 0;
+            float p99 = 0;
+            std::vector<uint32_t> histogram;
+        };
+
+        bool mPerfStats = false;
+        std::map<std::string, PerfSeries> mPerfSamples;
+        std::vector<std::string> mPerfEventOrder;
+
+        /** Record the frame time and the profiler event breakdown of the last frame. Called for every frame inside a perf range.
+        */
+        void recordPerfSample();
+
+        /** Compute the mean, unbiased variance, p50/p95/p99 and a fixed-width histogram of a series.
+        */
+        static PerfStatistics computePerfStatistics(std::vector<float> samples);
+
+        /** Write the PerfStats element of the xml log.
+        */
+        void writePerfStats(std::ofstream& of) const;
+
+        //  In-process comparison of a screenshot against its reference image, enabled with -imagediffref.
+        //  The swap-chain image is read back asynchronously, once for both the PNG export and the comparison, and compared on a worker thread.
+        struct ScreenCompare
+        {
+            std::string screenshotFile;
+            std::string referenceFile;
+            ReadbackRequest::SharedPtr pReadback;
+            std::future<ImageDiff::Result> result;
+        };
+
+        std::string mImageDiffRefPrefix;
+        std::vector<std::unique_ptr<ScreenCompare>> mScreenCompares;
+
+        //  A single thread runs the comparisons in order, so capturing several screenshots doesn't start a thread per screenshot
+        struct DiffWorker
+        {
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable jobAdded;
+            std::deque<std::packaged_task<ImageDiff::Result()>> jobs;
+            bool terminate = false;
+        } mDiffWorker;
+
+        /** Queue a comparison. The worker is started by the first one
+        */
+        void queueImageDiff(std::packaged_task<ImageDiff::Result()>&& job);
+        void runDiffWorker();
+
+        /** Finish the queued comparisons and stop the worker
+        */
+        void stopDiffWorker();
+
+        /** Capture the screen and, with -imagediffref, start comparing it against the reference image.
+        */
+        void captureTestScreen();
+
+        /** Wait for the pending comparisons and write their ImageCompare elements to the xml log.
+        */
+        void writeImageCompares(std::ofstream& of);
+
     };
 }
\ No newline at end of file
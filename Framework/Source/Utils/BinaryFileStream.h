@@ -80,19 +80,20 @@ namespace Falcor
             std::remove(mFilename.c_str());
         }
 
-		uint32_t getRemainingStreamSize()
+		uint64_t getRemainingStreamSize()
 		{	
 			std::streamoff currentPos = mStream.tellg();
 			mStream.seekg(0, mStream.end);
 			std::streamoff length = mStream.tellg();
 			mStream.seekg(currentPos);
-			return (uint32_t)(length - currentPos); 
+			return (uint64_t)(length - currentPos); 
 		}
 
         bool isGood() { return mStream.good(); }
         bool isBad()  { return mStream.bad(); }
         bool isFail() { return mStream.fail(); }
         bool isEof() { return mStream.eof(); }
+        void setFail() { mStream.setstate(std::ios::failbit); }
 
         BinaryFileStream& read(void* pData, size_t Count) { mStream.read((char*)pData, Count); return *this; }
 
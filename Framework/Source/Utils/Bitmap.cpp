@@ -29,6 +29,11 @@
 #include "Bitmap.h"
 #include "FreeImage.h"
 #include "OS.h"
+#include <emmintrin.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace Falcor
 {
@@ -186,11 +191,57 @@ namespace Falcor
         return FIT_BITMAP;
     }
 
-    void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData)
+    // Swap the R and B channels of RGBA8 pixels and force alpha to 1. FreeImage expects BGRA for 32-bit images and ignores the channel masks
+    static void swizzleRgbaToBgra(const uint32_t* pSrc, uint32_t* pDst, uint32_t count)
+    {
+        const __m128i lowMask = _mm_set1_epi32(0x000000ff);
+        const __m128i greenMask = _mm_set1_epi32(0x0000ff00);
+        const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(pSrc + i));
+            __m128i r = _mm_slli_epi32(_mm_and_si128(v, lowMask), 16);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), lowMask);
+            __m128i g = _mm_and_si128(v, greenMask);
+            _mm_storeu_si128((__m128i*)(pDst + i), _mm_or_si128(_mm_or_si128(r, b), _mm_or_si128(g, alpha)));
+        }
+
+        for (; i < count; i++)
+        {
+            uint32_t v = pSrc[i];
+            pDst[i] = ((v & 0xff) << 16) | ((v >> 16) & 0xff) | (v & 0xff00) | 0xff000000;
+        }
+    }
+
+    // Create a FreeImage bitmap from an 8-bit/channel buffer. RGBA formats are swizzled straight into the bitmap's scanlines, so the source buffer is left untouched
+    static FIBITMAP* convertFromRawBits(const void* pData, uint32_t width, uint32_t height, uint32_t bytesPerPixel, ResourceFormat resourceFormat, bool isTopDown)
+    {
+        if (resourceFormat != ResourceFormat::RGBA8Uint && resourceFormat != ResourceFormat::RGBA8Snorm && resourceFormat != ResourceFormat::RGBA8UnormSrgb)
+        {
+            return FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
+        }
+
+        FIBITMAP* pImage = FreeImage_Allocate(width, height, 32, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK);
+        if (pImage == nullptr) return nullptr;
+
+        // FreeImage stores the bottom row first
+        const uint32_t* pSrc = (const uint32_t*)pData;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint32_t scanline = isTopDown ? height - 1 - y : y;
+            swizzleRgbaToBgra(pSrc + (size_t)y * width, (uint32_t*)FreeImage_GetScanLine(pImage, scanline), width);
+        }
+        return pImage;
+    }
+
+    bool Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, const void* pData)
     {
         if(pData == nullptr)
         {
             logError("Bitmap::saveImage provided no data to save.");
+            return false;
         }
         
         if(is_set(exportFlags, ExportFlags::Uncompressed) && is_set(exportFlags, ExportFlags::Lossy))
@@ -202,23 +253,10 @@ namespace Falcor
         FIBITMAP* pImage;
         uint32_t bytesPerPixel = getFormatBytesPerBlock(resourceFormat);
 
-        //TODO replace this code for swapping channels. Can't use freeimage masks b/c they only care about 16 bpp images
-        //issue #74 in gitlab
-        if (resourceFormat == ResourceFormat::RGBA8Uint || resourceFormat == ResourceFormat::RGBA8Snorm || resourceFormat == ResourceFormat::RGBA8UnormSrgb)
-        {
-            for (uint32_t a = 0; a < width*height; a++)
-            {
-                uint32_t* pPixel = (uint32_t*)pData;
-                pPixel += a;
-                uint8_t* ch = (uint8_t*)pPixel;
-                std::swap(ch[0], ch[2]);                
-                ch[3] = 0xff;
-            }
-        }
         if (fileFormat == Bitmap::FileFormat::PngFile)
         {
-            pImage = FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
-            if(is_set(exportFlags, ExportFlags::ExportAlpha) == false)
+            pImage = convertFromRawBits(pData, width, height, bytesPerPixel, resourceFormat, isTopDown);
+            if(pImage && is_set(exportFlags, ExportFlags::ExportAlpha) == false)
             {
                 auto pTemp = pImage;
                 pImage = FreeImage_ConvertTo24Bits(pImage);
@@ -238,9 +276,9 @@ namespace Falcor
         }
         else if (fileFormat == Bitmap::FileFormat::JpegFile)
         {
-            FIBITMAP* pTemp = FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel * 8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
-            pImage = FreeImage_ConvertTo24Bits(pTemp);
-            FreeImage_Unload(pTemp);
+            FIBITMAP* pTemp = convertFromRawBits(pData, width, height, bytesPerPixel, resourceFormat, isTopDown);
+            pImage = pTemp ? FreeImage_ConvertTo24Bits(pTemp) : nullptr;
+            if (pTemp) FreeImage_Unload(pTemp);
             if(is_set(exportFlags, ExportFlags::Lossy) == false || is_set(exportFlags, ExportFlags::Uncompressed))
             {
                 flags = JPEG_QUALITYSUPERB | JPEG_SUBSAMPLING_444;
@@ -335,7 +373,122 @@ namespace Falcor
             }
         }
 
-        FreeImage_Save(toFreeImageFormat(fileFormat), pImage, filename.c_str(), flags);
+        if (pImage == nullptr)
+        {
+            logError("Bitmap::saveImage can't convert the image data for " + filename);
+            return false;
+        }
+
+        bool saved = FreeImage_Save(toFreeImageFormat(fileFormat), pImage, filename.c_str(), flags) != FALSE;
         FreeImage_Unload(pImage);
+        if (saved == false)
+        {
+            logError("Bitmap::saveImage can't write " + filename);
+        }
+        return saved;
+    }
+
+    // Encodes the images handed to saveImageAsync(). The workers are started on first use
+    class ExportQueue
+    {
+    public:
+        static ExportQueue& get()
+        {
+            static ExportQueue sQueue;
+            return sQueue;
+        }
+
+        ~ExportQueue()
+        {
+            // The workers drain the queue before exiting, so nothing captured before shutdown is lost
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mTerminate = true;
+            }
+            mJobAdded.notify_all();
+            for (auto& t : mThreads) t.join();
+        }
+
+        void push(std::function<void()>&& job)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (mThreads.empty())
+            {
+                // Leave most of the cores to the render thread and the driver
+                uint32_t threadCount = std::max(1u, std::min(kMaxThreads, std::thread::hardware_concurrency() / 2));
+                for (uint32_t i = 0; i < threadCount; i++) mThreads.push_back(std::thread(&ExportQueue::worker, this));
+            }
+
+            // Back-pressure. Encoding can't keep up with capturing every frame, don't let the queue grow without bounds
+            mJobDone.wait(lock, [this] { return mJobs.size() < kMaxQueuedJobs; });
+            mJobs.push_back(std::move(job));
+            mPendingCount++;
+            lock.unlock();
+            mJobAdded.notify_one();
+        }
+
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobDone.wait(lock, [this] { return mPendingCount == 0; });
+        }
+
+        uint32_t getPendingCount()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mPendingCount;
+        }
+
+    private:
+        ExportQueue() = default;
+
+        void worker()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (true)
+            {
+                mJobAdded.wait(lock, [this] { return mTerminate || mJobs.empty() == false; });
+                if (mJobs.empty()) return;
+
+                std::function<void()> job = std::move(mJobs.front());
+                mJobs.pop_front();
+                lock.unlock();
+                job();
+                lock.lock();
+                mPendingCount--;
+                mJobDone.notify_all();
+            }
+        }
+
+        static const uint32_t kMaxThreads = 4;
+        static const size_t kMaxQueuedJobs = 64;
+
+        std::mutex mMutex;
+        std::condition_variable mJobAdded;
+        std::condition_variable mJobDone;
+        std::deque<std::function<void()>> mJobs;
+        std::vector<std::thread> mThreads;
+        uint32_t mPendingCount = 0;
+        bool mTerminate = false;
+    };
+
+    void Bitmap::saveImageAsync(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, std::vector<uint8_t>&& data, const ExportCallback& callback)
+    {
+        auto pData = std::make_shared<std::vector<uint8_t>>(std::move(data));
+        ExportQueue::get().push([=]
+        {
+            bool success = saveImage(filename, width, height, fileFormat, exportFlags, resourceFormat, isTopDown, pData->data());
+            if (callback) callback(filename, success);
+        });
+    }
+
+    void Bitmap::flushPendingExports()
+    {
+        ExportQueue::get().flush();
+    }
+
+    uint32_t Bitmap::getPendingExportCount()
+    {
+        return ExportQueue::get().getPendingCount();
     }
 }
\ No newline at end of file
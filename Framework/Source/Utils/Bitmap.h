@@ -26,7 +26,9 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace Falcor
 {
@@ -60,6 +62,13 @@ namespace Falcor
             \return If loading was successful, a new object. Otherwise, nullptr.
         */
         static UniqueConstPtr createFromFile(const std::string& filename, bool isTopDown);
+
+        /** Called once an asynchronous export finished. It is invoked on an export thread.
+            \param[in] filename The file that was written
+            \param[in] success False if the image couldn't be encoded or written
+        */
+        using ExportCallback = std::function<void(const std::string& filename, bool success)>;
+
         /** Store a memory buffer to a PNG file.
             \param[in] filename Output filename. Can include a path - absolute or relative to the executable directory.
             \param[in] width The width of the image.
@@ -68,9 +77,27 @@ namespace Falcor
             \param[in] exportFlags The flags to export the file. See ExportFlags above.
             \param[in] ResourceFormat the format of the resource data
             \param[in] isTopDown Control the memory layout of the image. If true, the top-left pixel will be stored first, otherwise the bottom-left pixel will be stored first
-            \param[in] pData Pointer to the buffer containing the image
+            \param[in] pData Pointer to the buffer containing the image. The buffer is not modified
+            \return true if the file was written, otherwise false
+        */
+        static bool saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, const void* pData);
+
+        /** Queue a memory buffer to be stored to a file by the export threads. The function returns immediately, the conversion and encoding happen on a worker thread.
+            Several images are encoded in parallel, so they can complete out of order. The call only blocks if the queue is full.
+            \param[in] data The image data, the queue takes ownership of it
+            \param[in] callback Optional. Called from the export thread once the file was written
+            The other parameters are the same as in saveImage()
         */
-        static void saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData);
+        static void saveImageAsync(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, std::vector<uint8_t>&& data, const ExportCallback& callback = nullptr);
+
+        /** Block until all the queued exports were written
+        */
+        static void flushPendingExports();
+
+        /** Get the number of exports which are queued or being encoded
+        */
+        static uint32_t getPendingExportCount();
+
         ~Bitmap();
 
         /** Get a pointer to the bitmap's data store
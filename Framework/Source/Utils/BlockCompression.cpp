@@ -0,0 +1,884 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BlockCompression.h"
+#include "glm/gtc/packing.hpp"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace Falcor
+{
+    static uint32_t gThreadCount = 0;
+
+    // BC6H and BC7 interpolation weights for 4-bit indices, out of 64
+    static const uint32_t kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Run a worker on threadCount threads, including the calling thread
+    template<typename WorkerType>
+    static void runWorkers(uint32_t threadCount, const WorkerType& worker)
+    {
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& t : threads) t.join();
+    }
+
+    /** Channels of the 16 pixels of a block, stored as structure-of-arrays so that 4 pixels are processed at a time
+    */
+    template<uint32_t N>
+    struct BlockPixels
+    {
+        float c[N][16];
+    };
+
+    /** Get the starting endpoints of a block: the extremes of the pixels projected on the principal axis
+    */
+    template<uint32_t N>
+    static void findInitialEndpoints(const BlockPixels<N>& px, BlockCompression::Quality quality, float e0[N], float e1[N])
+    {
+        float mean[N];
+        float minValue[N];
+        float maxValue[N];
+        for (uint32_t c = 0; c < N; c++)
+        {
+            mean[c] = 0;
+            minValue[c] = FLT_MAX;
+            maxValue[c] = -FLT_MAX;
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                mean[c] += px.c[c][i];
+                minValue[c] = std::min(minValue[c], px.c[c][i]);
+                maxValue[c] = std::max(maxValue[c], px.c[c][i]);
+            }
+            mean[c] /= 16.0f;
+        }
+
+        if (N == 1)
+        {
+            e0[0] = minValue[0];
+            e1[0] = maxValue[0];
+            return;
+        }
+
+        float cov[N][N];
+        for (uint32_t a = 0; a < N; a++)
+        {
+            for (uint32_t b = a; b < N; b++)
+            {
+                float sum = 0;
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    sum += (px.c[a][i] - mean[a]) * (px.c[b][i] - mean[b]);
+                }
+                cov[a][b] = cov[b][a] = sum;
+            }
+        }
+
+        // Power iteration, starting from the bounding box diagonal
+        float axis[N];
+        for (uint32_t c = 0; c < N; c++) axis[c] = maxValue[c] - minValue[c];
+        const uint32_t iterations = (quality == BlockCompression::Quality::Fast) ? 3 : 8;
+        for (uint32_t it = 0; it < iterations; it++)
+        {
+            float next[N];
+            float length = 0;
+            for (uint32_t a = 0; a < N; a++)
+            {
+                next[a] = 0;
+                for (uint32_t b = 0; b < N; b++) next[a] += cov[a][b] * axis[b];
+                length = std::max(length, std::abs(next[a]));
+            }
+            if (length < 1e-12f) break;
+            for (uint32_t c = 0; c < N; c++) axis[c] = next[c] / length;
+        }
+
+        float minT = FLT_MAX;
+        float maxT = -FLT_MAX;
+        float axisLength = 0;
+        for (uint32_t c = 0; c < N; c++) axisLength += axis[c] * axis[c];
+        if (axisLength < 1e-12f)
+        {
+            // Constant block
+            for (uint32_t c = 0; c < N; c++) e0[c] = e1[c] = mean[c];
+            return;
+        }
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float t = 0;
+            for (uint32_t c = 0; c < N; c++) t += (px.c[c][i] - mean[c]) * axis[c];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        minT /= axisLength;
+        maxT /= axisLength;
+        for (uint32_t c = 0; c < N; c++)
+        {
+            e0[c] = mean[c] + axis[c] * minT;
+            e1[c] = mean[c] + axis[c] * maxT;
+        }
+    }
+
+    /** Find the closest palette entry of every pixel
+        \return The total squared error
+    */
+    template<uint32_t N, uint32_t Count>
+    static float assignIndices(const BlockPixels<N>& px, const float (&palette)[Count][N], uint8_t indices[16])
+    {
+        __m128 total = _mm_setzero_ps();
+        for (uint32_t i = 0; i < 16; i += 4)
+        {
+            __m128 pixel[N];
+            for (uint32_t c = 0; c < N; c++) pixel[c] = _mm_loadu_ps(&px.c[c][i]);
+
+            __m128 bestDist = _mm_set1_ps(FLT_MAX);
+            __m128 bestIndex = _mm_setzero_ps();
+            for (uint32_t k = 0; k < Count; k++)
+            {
+                __m128 dist = _mm_setzero_ps();
+                for (uint32_t c = 0; c < N; c++)
+                {
+                    __m128 d = _mm_sub_ps(pixel[c], _mm_set1_ps(palette[k][c]));
+                    dist = _mm_add_ps(dist, _mm_mul_ps(d, d));
+                }
+                __m128 closer = _mm_cmplt_ps(dist, bestDist);
+                bestDist = _mm_min_ps(dist, bestDist);
+                bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)k)), _mm_andnot_ps(closer, bestIndex));
+            }
+            total = _mm_add_ps(total, bestDist);
+
+            float index[4];
+            _mm_storeu_ps(index, bestIndex);
+            for (uint32_t j = 0; j < 4; j++) indices[i + j] = (uint8_t)index[j];
+        }
+
+        float sum[4];
+        _mm_storeu_ps(sum, total);
+        return sum[0] + sum[1] + sum[2] + sum[3];
+    }
+
+    /** Least-squares endpoints for a fixed set of indices
+        \return false if the system is degenerate (all the pixels use the same weight)
+    */
+    template<typename Codec>
+    static bool refineEndpoints(const BlockPixels<Codec::kChannels>& px, const uint8_t indices[16], float e0[Codec::kChannels], float e1[Codec::kChannels])
+    {
+        const uint32_t N = Codec::kChannels;
+        float aa = 0, ab = 0, bb = 0;
+        float ax[N] = {};
+        float bx[N] = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const float b = Codec::weight(indices[i]);
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < N; c++)
+            {
+                ax[c] += a * px.c[c][i];
+                bx[c] += b * px.c[c][i];
+            }
+        }
+
+        const float det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f) return false;
+        for (uint32_t c = 0; c < N; c++)
+        {
+            e0[c] = (bb * ax[c] - ab * bx[c]) / det;
+            e1[c] = (aa * bx[c] - ab * ax[c]) / det;
+        }
+        return true;
+    }
+
+    /** Fit the endpoints of a single-subset block. The codec quantizes the endpoints and builds the palette the hardware decodes
+        \return The squared error of the best candidate
+    */
+    template<typename Codec>
+    static float fitBlock(const BlockPixels<Codec::kChannels>& px, BlockCompression::Quality quality, Codec& best, uint8_t indices[16])
+    {
+        float e0[Codec::kChannels];
+        float e1[Codec::kChannels];
+        findInitialEndpoints<Codec::kChannels>(px, quality, e0, e1);
+
+        const uint32_t passes = (quality == BlockCompression::Quality::Fast) ? 0 : ((quality == BlockCompression::Quality::Normal) ? 1 : 4);
+        float bestError = FLT_MAX;
+        Codec codec;
+        uint8_t candidate[16];
+        for (uint32_t pass = 0; ; pass++)
+        {
+            codec.quantize(e0, e1);
+            float error = assignIndices(px, codec.palette, candidate);
+            if (error < bestError)
+            {
+                bestError = error;
+                best = codec;
+                std::memcpy(indices, candidate, 16);
+            }
+            if (pass == passes || error == 0 || refineEndpoints<Codec>(px, candidate, e0, e1) == false) break;
+        }
+        return bestError;
+    }
+
+    static uint32_t quantizeUnorm(float value, uint32_t maxCode)
+    {
+        float v = std::min(std::max(value / 255.0f, 0.0f), 1.0f);
+        return (uint32_t)(v * maxCode + 0.5f);
+    }
+
+    /** BC1 color endpoints, RGB565
+    */
+    struct Bc1Codec
+    {
+        static const uint32_t kChannels = 3;
+        static const uint32_t kIndexCount = 4;
+        static float weight(uint32_t index)
+        {
+            static const float kWeights[kIndexCount] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            return kWeights[index];
+        }
+
+        uint16_t c0, c1;
+        float palette[kIndexCount][kChannels];
+
+        static uint16_t pack(const float* e, float* q)
+        {
+            uint32_t r = quantizeUnorm(e[0], 31);
+            uint32_t g = quantizeUnorm(e[1], 63);
+            uint32_t b = quantizeUnorm(e[2], 31);
+            q[0] = (float)((r << 3) | (r >> 2));
+            q[1] = (float)((g << 2) | (g >> 4));
+            q[2] = (float)((b << 3) | (b >> 2));
+            return (uint16_t)((r << 11) | (g << 5) | b);
+        }
+
+        void quantize(const float* e0, const float* e1)
+        {
+            c0 = pack(e0, palette[0]);
+            c1 = pack(e1, palette[1]);
+            for (uint32_t c = 0; c < kChannels; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3.0f;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3.0f;
+            }
+        }
+
+        void write(uint8_t indices[16], uint8_t* pDst) const
+        {
+            // color0 > color1 selects the 4-color mode. Swapping the endpoints swaps indices 0<->1 and 2<->3
+            uint16_t color0 = c0;
+            uint16_t color1 = c1;
+            if (color0 < color1)
+            {
+                std::swap(color0, color1);
+                for (uint32_t i = 0; i < 16; i++) indices[i] ^= 1;
+            }
+            else if (color0 == color1)
+            {
+                std::memset(indices, 0, 16);
+            }
+
+            uint32_t bits = 0;
+            for (uint32_t i = 0; i < 16; i++) bits |= (uint32_t)indices[i] << (2 * i);
+            std::memcpy(pDst, &color0, 2);
+            std::memcpy(pDst + 2, &color1, 2);
+            std::memcpy(pDst + 4, &bits, 4);
+        }
+    };
+
+    /** BC4 single-channel endpoints, also used for the BC3 alpha and the BC5 channels
+    */
+    struct Bc4Codec
+    {
+        static const uint32_t kChannels = 1;
+        static const uint32_t kIndexCount = 8;
+        static float weight(uint32_t index)
+        {
+            return (index < 2) ? (float)index : (index - 1) / 7.0f;
+        }
+
+        uint8_t r0, r1;
+        float palette[kIndexCount][kChannels];
+
+        void quantize(const float* e0, const float* e1)
+        {
+            r0 = (uint8_t)quantizeUnorm(e0[0], 255);
+            r1 = (uint8_t)quantizeUnorm(e1[0], 255);
+            for (uint32_t i = 0; i < kIndexCount; i++)
+            {
+                palette[i][0] = r0 + (r1 - r0) * weight(i);
+            }
+        }
+
+        void write(uint8_t indices[16], uint8_t* pDst) const
+        {
+            // red0 > red1 selects the 8-value mode. Swapping the endpoints swaps indices 0<->1 and i<->9-i for the others
+            uint8_t red0 = r0;
+            uint8_t red1 = r1;
+            if (red0 < red1)
+            {
+                std::swap(red0, red1);
+                for (uint32_t i = 0; i < 16; i++) indices[i] = (indices[i] < 2) ? (indices[i] ^ 1) : (9 - indices[i]);
+            }
+            else if (red0 == red1)
+            {
+                std::memset(indices, 0, 16);
+            }
+
+            uint64_t bits = 0;
+            for (uint32_t i = 0; i < 16; i++) bits |= (uint64_t)indices[i] << (3 * i);
+            pDst[0] = red0;
+            pDst[1] = red1;
+            std::memcpy(pDst + 2, &bits, 6);
+        }
+    };
+
+    /** Writes bit fields LSB-first into a 128-bit block
+    */
+    struct BitWriter
+    {
+        uint8_t* pDst;
+        uint32_t pos = 0;
+
+        BitWriter(uint8_t* pBlock) : pDst(pBlock) { std::memset(pDst, 0, 16); }
+
+        void write(uint32_t value, uint32_t bitCount)
+        {
+            for (uint32_t i = 0; i < bitCount; i++, pos++)
+            {
+                pDst[pos >> 3] |= (uint8_t)(((value >> i) & 1) << (pos & 7));
+            }
+        }
+    };
+
+    // The anchor pixel's index is stored without its MSB. If it's set, the endpoints are swapped and the indices mirrored
+    static bool fixAnchorIndex(uint8_t indices[16])
+    {
+        if (indices[0] < 8) return false;
+        for (uint32_t i = 0; i < 16; i++) indices[i] = 15 - indices[i];
+        return true;
+    }
+
+    /** BC7 mode 6: RGBA 7-bit endpoints with a per-endpoint P-bit, 4-bit indices
+    */
+    struct Bc7Codec
+    {
+        static const uint32_t kChannels = 4;
+        static const uint32_t kIndexCount = 16;
+        static float weight(uint32_t index) { return kWeights4[index] / 64.0f; }
+
+        uint8_t q0[kChannels], q1[kChannels];
+        uint8_t p0, p1;
+        float palette[kIndexCount][kChannels];
+
+        // Pick the P-bit with the smallest quantization error. Opaque endpoints need P=1 to decode to an alpha of exactly 255
+        static uint8_t pack(const float* e, uint8_t* q, uint32_t* expanded)
+        {
+            float bestError = FLT_MAX;
+            uint8_t bestP = 0;
+            for (uint32_t p = (e[3] > 254.5f) ? 1 : 0; p < 2; p++)
+            {
+                float error = 0;
+                uint8_t codes[kChannels];
+                for (uint32_t c = 0; c < kChannels; c++)
+                {
+                    float v = std::min(std::max(e[c], 0.0f), 255.0f);
+                    codes[c] = (uint8_t)std::min(std::max((int32_t)std::floor((v - p) / 2.0f + 0.5f), 0), 127);
+                    float d = v - (float)((codes[c] << 1) | p);
+                    error += d * d;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestP = (uint8_t)p;
+                    std::memcpy(q, codes, kChannels);
+                }
+            }
+            for (uint32_t c = 0; c < kChannels; c++) expanded[c] = (q[c] << 1) | bestP;
+            return bestP;
+        }
+
+        void quantize(const float* e0, const float* e1)
+        {
+            uint32_t x0[kChannels], x1[kChannels];
+            p0 = pack(e0, q0, x0);
+            p1 = pack(e1, q1, x1);
+            for (uint32_t i = 0; i < kIndexCount; i++)
+            {
+                for (uint32_t c = 0; c < kChannels; c++)
+                {
+                    palette[i][c] = (float)(((64 - kWeights4[i]) * x0[c] + kWeights4[i] * x1[c] + 32) >> 6);
+                }
+            }
+        }
+
+        void write(uint8_t indices[16], uint8_t* pDst) const
+        {
+            const bool swap = fixAnchorIndex(indices);
+            const uint8_t* pE0 = swap ? q1 : q0;
+            const uint8_t* pE1 = swap ? q0 : q1;
+
+            BitWriter writer(pDst);
+            writer.write(1 << 6, 7);    // Mode 6
+            for (uint32_t c = 0; c < kChannels; c++)
+            {
+                writer.write(pE0[c], 7);
+                writer.write(pE1[c], 7);
+            }
+            writer.write(swap ? p1 : p0, 1);
+            writer.write(swap ? p0 : p1, 1);
+            writer.write(indices[0], 3);
+            for (uint32_t i = 1; i < 16; i++) writer.write(indices[i], 4);
+            assert(writer.pos == 128);
+        }
+    };
+
+    /** BC6H mode 11: unsigned RGB 10-bit endpoints, 4-bit indices.
+        The pixels are in the decoder's unquantized domain, the half-float bits scaled by 64/31, where interpolation happens.
+    */
+    struct Bc6hCodec
+    {
+        static const uint32_t kChannels = 3;
+        static const uint32_t kIndexCount = 16;
+        static float weight(uint32_t index) { return kWeights4[index] / 64.0f; }
+
+        uint16_t q0[kChannels], q1[kChannels];
+        float palette[kIndexCount][kChannels];
+
+        static uint32_t unquantize(uint32_t code)
+        {
+            if (code == 0) return 0;
+            if (code == 1023) return 0xFFFF;
+            return ((code << 16) + 0x8000) >> 10;
+        }
+
+        static uint16_t pack(float value)
+        {
+            return (uint16_t)std::min(std::max((int32_t)std::floor((value - 32.0f) / 64.0f + 0.5f), 0), 1023);
+        }
+
+        void quantize(const float* e0, const float* e1)
+        {
+            uint32_t x0[kChannels], x1[kChannels];
+            for (uint32_t c = 0; c < kChannels; c++)
+            {
+                q0[c] = pack(e0[c]);
+                q1[c] = pack(e1[c]);
+                x0[c] = unquantize(q0[c]);
+                x1[c] = unquantize(q1[c]);
+            }
+            for (uint32_t i = 0; i < kIndexCount; i++)
+            {
+                for (uint32_t c = 0; c < kChannels; c++)
+                {
+                    palette[i][c] = (float)(((64 - kWeights4[i]) * x0[c] + kWeights4[i] * x1[c] + 32) >> 6);
+                }
+            }
+        }
+
+        void write(uint8_t indices[16], uint8_t* pDst) const
+        {
+            const bool swap = fixAnchorIndex(indices);
+            const uint16_t* pE0 = swap ? q1 : q0;
+            const uint16_t* pE1 = swap ? q0 : q1;
+
+            BitWriter writer(pDst);
+            writer.write(0x03, 5);      // Mode 11
+            for (uint32_t c = 0; c < kChannels; c++) writer.write(pE0[c], 10);
+            for (uint32_t c = 0; c < kChannels; c++) writer.write(pE1[c], 10);
+            writer.write(indices[0], 3);
+            for (uint32_t i = 1; i < 16; i++) writer.write(indices[i], 4);
+            assert(writer.pos == 128);
+        }
+    };
+
+    template<typename Codec>
+    static void encodeBlock(const BlockPixels<Codec::kChannels>& px, BlockCompression::Quality quality, uint8_t* pDst)
+    {
+        Codec codec;
+        uint8_t indices[16];
+        fitBlock(px, quality, codec, indices);
+        codec.write(indices, pDst);
+    }
+
+    /** An uncompressed mip level. LDR images are stored as RGBA8, HDR images as RGBA32Float
+    */
+    struct MipImage
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> ldr;
+        std::vector<float> hdr;
+    };
+
+    static bool isHdrFormat(ResourceFormat format)
+    {
+        return format == ResourceFormat::RGBA32Float || format == ResourceFormat::RGB32Float || format == ResourceFormat::RGBA16Float || format == ResourceFormat::RGB16Float;
+    }
+
+    static bool loadMipImage(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat format, MipImage& image)
+    {
+        const size_t count = (size_t)width * height;
+        image.width = width;
+        image.height = height;
+
+        switch (format)
+        {
+        case ResourceFormat::BGRA8Unorm:
+        {
+            const uint8_t* pBgra = (const uint8_t*)pSrc;
+            image.ldr.resize(count * 4);
+            for (size_t i = 0; i < count; i++)
+            {
+                image.ldr[i * 4 + 0] = pBgra[i * 4 + 2];
+                image.ldr[i * 4 + 1] = pBgra[i * 4 + 1];
+                image.ldr[i * 4 + 2] = pBgra[i * 4 + 0];
+                image.ldr[i * 4 + 3] = pBgra[i * 4 + 3];
+            }
+            return true;
+        }
+        case ResourceFormat::RG8Unorm:
+        case ResourceFormat::R8Unorm:
+        {
+            const uint32_t channels = (format == ResourceFormat::RG8Unorm) ? 2 : 1;
+            const uint8_t* pData = (const uint8_t*)pSrc;
+            image.ldr.assign(count * 4, 0);
+            for (size_t i = 0; i < count; i++)
+            {
+                for (uint32_t c = 0; c < channels; c++) image.ldr[i * 4 + c] = pData[i * channels + c];
+                image.ldr[i * 4 + 3] = 255;
+            }
+            return true;
+        }
+        case ResourceFormat::RGBA32Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGB16Float:
+        {
+            const uint32_t channels = getFormatChannelCount(format);
+            const bool isHalf = (format == ResourceFormat::RGBA16Float || format == ResourceFormat::RGB16Float);
+            image.hdr.assign(count * 4, 1.0f);
+            for (size_t i = 0; i < count; i++)
+            {
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    image.hdr[i * 4 + c] = isHalf ? glm::unpackHalf1x16(((const uint16_t*)pSrc)[i * channels + c]) : ((const float*)pSrc)[i * channels + c];
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    static float srgbToLinear(float v)
+    {
+        return (v <= 0.04045f) ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float linearToSrgb(float v)
+    {
+        return (v <= 0.0031308f) ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+    }
+
+    /** 2x2 box filter. sRGB colors are averaged in linear space, normals are renormalized
+    */
+    static void downsample(const MipImage& src, MipImage& dst, bool isSrgb, bool isNormalMap)
+    {
+        dst.width = std::max(src.width / 2, 1u);
+        dst.height = std::max(src.height / 2, 1u);
+        const bool isHdr = src.hdr.size() != 0;
+        if (isHdr) dst.hdr.resize(dst.width * dst.height * 4);
+        else dst.ldr.resize(dst.width * dst.height * 4);
+
+        float toLinear[256];
+        for (uint32_t i = 0; i < 256; i++) toLinear[i] = isSrgb ? srgbToLinear(i / 255.0f) : i / 255.0f;
+
+        for (uint32_t y = 0; y < dst.height; y++)
+        {
+            for (uint32_t x = 0; x < dst.width; x++)
+            {
+                float sum[4] = {};
+                for (uint32_t s = 0; s < 4; s++)
+                {
+                    const uint32_t sx = std::min(x * 2 + (s & 1), src.width - 1);
+                    const uint32_t sy = std::min(y * 2 + (s >> 1), src.height - 1);
+                    const size_t srcIndex = ((size_t)sy * src.width + sx) * 4;
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        if (isHdr) sum[c] += src.hdr[srcIndex + c];
+                        else sum[c] += (c < 3) ? toLinear[src.ldr[srcIndex + c]] : src.ldr[srcIndex + c] / 255.0f;
+                    }
+                }
+
+                const size_t dstIndex = ((size_t)y * dst.width + x) * 4;
+                for (uint32_t c = 0; c < 4; c++) sum[c] *= 0.25f;
+                if (isHdr)
+                {
+                    for (uint32_t c = 0; c < 4; c++) dst.hdr[dstIndex + c] = sum[c];
+                    continue;
+                }
+
+                if (isNormalMap)
+                {
+                    glm::vec3 n = glm::vec3(sum[0], sum[1], sum[2]) * 2.0f - 1.0f;
+                    n = (glm::dot(n, n) > 0) ? glm::normalize(n) : glm::vec3(0, 0, 1);
+                    sum[0] = n.x * 0.5f + 0.5f;
+                    sum[1] = n.y * 0.5f + 0.5f;
+                    sum[2] = n.z * 0.5f + 0.5f;
+                }
+                else if (isSrgb)
+                {
+                    for (uint32_t c = 0; c < 3; c++) sum[c] = linearToSrgb(sum[c]);
+                }
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    dst.ldr[dstIndex + c] = (uint8_t)(std::min(std::max(sum[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+
+    /** Gather the pixels of a block. Pixels outside the image repeat the edge, for mips smaller than 4x4
+    */
+    template<uint32_t N>
+    static void loadBlock(const MipImage& image, uint32_t bx, uint32_t by, uint32_t firstChannel, BlockPixels<N>& px)
+    {
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t x = std::min(bx * 4 + (i & 3), image.width - 1);
+            const uint32_t y = std::min(by * 4 + (i >> 2), image.height - 1);
+            const size_t index = ((size_t)y * image.width + x) * 4 + firstChannel;
+            for (uint32_t c = 0; c < N; c++)
+            {
+                px.c[c][i] = image.ldr[index + c];
+            }
+        }
+    }
+
+    static void loadHdrBlock(const MipImage& image, uint32_t bx, uint32_t by, BlockPixels<3>& px)
+    {
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t x = std::min(bx * 4 + (i & 3), image.width - 1);
+            const uint32_t y = std::min(by * 4 + (i >> 2), image.height - 1);
+            const size_t index = ((size_t)y * image.width + x) * 4;
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                // Negative values can't be represented. NaN fails both comparisons and becomes 0
+                float v = image.hdr[index + c];
+                v = (v > 0) ? std::min(v, 65504.0f) : 0.0f;
+                px.c[c][i] = glm::packHalf1x16(v) * (64.0f / 31.0f);
+            }
+        }
+    }
+
+    static void encodeBlock(const MipImage& image, uint32_t bx, uint32_t by, ResourceFormat format, BlockCompression::Quality quality, uint8_t* pDst)
+    {
+        switch (srgbToLinearFormat(format))
+        {
+        case ResourceFormat::BC1Unorm:
+        {
+            BlockPixels<3> px;
+            loadBlock(image, bx, by, 0, px);
+            encodeBlock<Bc1Codec>(px, quality, pDst);
+            break;
+        }
+        case ResourceFormat::BC3Unorm:
+        {
+            BlockPixels<1> alpha;
+            BlockPixels<3> px;
+            loadBlock(image, bx, by, 3, alpha);
+            loadBlock(image, bx, by, 0, px);
+            encodeBlock<Bc4Codec>(alpha, quality, pDst);
+            encodeBlock<Bc1Codec>(px, quality, pDst + 8);
+            break;
+        }
+        case ResourceFormat::BC4Unorm:
+        {
+            BlockPixels<1> px;
+            loadBlock(image, bx, by, 0, px);
+            encodeBlock<Bc4Codec>(px, quality, pDst);
+            break;
+        }
+        case ResourceFormat::BC5Unorm:
+        {
+            BlockPixels<1> red, green;
+            loadBlock(image, bx, by, 0, red);
+            loadBlock(image, bx, by, 1, green);
+            encodeBlock<Bc4Codec>(red, quality, pDst);
+            encodeBlock<Bc4Codec>(green, quality, pDst + 8);
+            break;
+        }
+        case ResourceFormat::BC7Unorm:
+        {
+            BlockPixels<4> px;
+            loadBlock(image, bx, by, 0, px);
+            encodeBlock<Bc7Codec>(px, quality, pDst);
+            break;
+        }
+        case ResourceFormat::BC6HU16:
+        {
+            BlockPixels<3> px;
+            loadHdrBlock(image, bx, by, px);
+            encodeBlock<Bc6hCodec>(px, quality, pDst);
+            break;
+        }
+        default:
+            should_not_get_here();
+        }
+    }
+
+    static void encodeMipImage(const MipImage& image, ResourceFormat format, BlockCompression::Quality quality, uint8_t* pDst)
+    {
+        const uint32_t blocksX = (image.width + 3) / 4;
+        const uint32_t blocksY = (image.height + 3) / 4;
+        const uint32_t blockSize = getFormatBytesPerBlock(format);
+
+        // Small mips aren't worth the thread startup
+        uint32_t threadCount = gThreadCount ? gThreadCount : std::max(std::thread::hardware_concurrency(), 1u);
+        if (blocksX * blocksY < 1024) threadCount = 1;
+        threadCount = std::min(threadCount, blocksY);
+
+        std::atomic<uint32_t> nextRow(0);
+        auto worker = [&]()
+        {
+            for (uint32_t by = nextRow++; by < blocksY; by = nextRow++)
+            {
+                uint8_t* pRow = pDst + (size_t)by * blocksX * blockSize;
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    encodeBlock(image, bx, by, format, quality, pRow + bx * blockSize);
+                }
+            }
+        };
+        runWorkers(threadCount, worker);
+    }
+
+    ResourceFormat BlockCompression::chooseFormat(ResourceFormat srcFormat, bool hasAlpha, bool isNormalMap, Quality quality)
+    {
+        switch (srcFormat)
+        {
+        case ResourceFormat::BGRA8Unorm:
+            if (isNormalMap) return ResourceFormat::BC5Unorm;
+            if (quality == Quality::Fast) return hasAlpha ? ResourceFormat::BC3Unorm : ResourceFormat::BC1Unorm;
+            return ResourceFormat::BC7Unorm;
+        case ResourceFormat::RG8Unorm:
+            return ResourceFormat::BC5Unorm;
+        case ResourceFormat::R8Unorm:
+            return ResourceFormat::BC4Unorm;
+        case ResourceFormat::RGBA32Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA16Float:
+        case ResourceFormat::RGB16Float:
+            return ResourceFormat::BC6HU16;
+        default:
+            return ResourceFormat::Unknown;
+        }
+    }
+
+    bool BlockCompression::hasAlpha(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat srcFormat)
+    {
+        if (srcFormat != ResourceFormat::BGRA8Unorm) return false;
+
+        const uint8_t* pData = (const uint8_t*)pSrc;
+        const size_t count = (size_t)width * height;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (pData[i * 4 + 3] != 255) return true;
+        }
+        return false;
+    }
+
+    uint32_t BlockCompression::encode(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat srcFormat, ResourceFormat dstFormat, Quality quality, uint32_t mipLevels, std::vector<uint8_t>& dst, bool isNormalMap)
+    {
+        const ResourceFormat linearFormat = srgbToLinearFormat(dstFormat);
+        const bool hdrDst = (linearFormat == ResourceFormat::BC6HU16);
+        const bool supported = linearFormat == ResourceFormat::BC1Unorm || linearFormat == ResourceFormat::BC3Unorm || linearFormat == ResourceFormat::BC4Unorm ||
+            linearFormat == ResourceFormat::BC5Unorm || linearFormat == ResourceFormat::BC7Unorm || linearFormat == ResourceFormat::BC6HU16;
+        if (supported == false || hdrDst != isHdrFormat(srcFormat))
+        {
+            logWarning("BlockCompression::encode() - can't encode " + to_string(srcFormat) + " images to " + to_string(dstFormat));
+            return 0;
+        }
+        if ((width % 4) != 0 || (height % 4) != 0)
+        {
+            logWarning("BlockCompression::encode() - the image size must be a multiple of 4");
+            return 0;
+        }
+
+        MipImage image;
+        if (loadMipImage(pSrc, width, height, srcFormat, image) == false)
+        {
+            logWarning("BlockCompression::encode() - unsupported source format " + to_string(srcFormat));
+            return 0;
+        }
+
+        uint32_t maxLevels = 1;
+        while ((std::max(width, height) >> maxLevels) != 0) maxLevels++;
+        mipLevels = std::min(std::max(mipLevels, 1u), maxLevels);
+
+        // Compute the total size up front so that the blocks are written in place
+        const uint32_t blockSize = getFormatBytesPerBlock(dstFormat);
+        size_t totalSize = 0;
+        for (uint32_t level = 0; level < mipLevels; level++)
+        {
+            const uint32_t w = std::max(width >> level, 1u);
+            const uint32_t h = std::max(height >> level, 1u);
+            totalSize += (size_t)((w + 3) / 4) * ((h + 3) / 4) * blockSize;
+        }
+        dst.resize(totalSize);
+
+        size_t offset = 0;
+        for (uint32_t level = 0; level < mipLevels; level++)
+        {
+            if (level > 0)
+            {
+                MipImage next;
+                downsample(image, next, isSrgbFormat(dstFormat), isNormalMap);
+                image = std::move(next);
+            }
+            encodeMipImage(image, dstFormat, quality, dst.data() + offset);
+            offset += (size_t)((image.width + 3) / 4) * ((image.height + 3) / 4) * blockSize;
+        }
+        return mipLevels;
+    }
+
+    void BlockCompression::setThreadCount(uint32_t threadCount)
+    {
+        gThreadCount = threadCount;
+    }
+}
@@ -0,0 +1,83 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Formats.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU block-compression encoder.
+        Encodes 8-bit and floating-point images into BC1, BC3, BC4, BC5, BC6H and BC7 blocks, so that textures loaded from PNG, JPG or HDR files can use the same compressed formats as pre-cooked DDS files.
+        Endpoints are fitted along the principal axis of each block and refined with least squares, and indices are selected 4 pixels at a time with SSE. Images are split across threads by rows of blocks.
+        BC7 blocks are always encoded with mode 6 and BC6H blocks with mode 11, the single-subset modes. They cover smooth gradients well, but blocks with several distinct colors have more error than a full mode search would give.
+    */
+    class BlockCompression
+    {
+    public:
+        /** Quality/speed trade-off
+        */
+        enum class Quality
+        {
+            Fast,       ///< Single endpoint fit, cheapest
+            Normal,     ///< One refinement pass
+            High,       ///< Several refinement passes, keeps the best candidate
+        };
+
+        /** Get the block-compressed format to use for an image.
+            \param[in] srcFormat The image format. Must be one of the formats Bitmap returns
+            \param[in] hasAlpha Whether the image has a non-opaque alpha channel
+            \param[in] isNormalMap Whether the image is a tangent-space normal map. Normal maps are encoded as BC5, the shader reconstructs Z
+            \param[in] quality The quality preset. Fast prefers BC1/BC3 over BC7 for color images
+            \return The compressed format, or ResourceFormat::Unknown if the image format can't be compressed
+        */
+        static ResourceFormat chooseFormat(ResourceFormat srcFormat, bool hasAlpha, bool isNormalMap, Quality quality);
+
+        /** Check whether an 8-bit image has any non-opaque pixel
+        */
+        static bool hasAlpha(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat srcFormat);
+
+        /** Encode an image and a full mip chain generated from it.
+            Block-compressed textures can't generate their mips on the GPU, so the mips are box-filtered on the CPU before encoding. sRGB images are filtered in linear space, and normal maps are renormalized.
+            \param[in] pSrc Source pixels, tightly packed top-down rows. Must be one of the formats Bitmap returns
+            \param[in] width Image width. Must be a multiple of 4
+            \param[in] height Image height. Must be a multiple of 4
+            \param[in] srcFormat Source format
+            \param[in] dstFormat Compressed format. sRGB formats filter the mips in linear space
+            \param[in] quality The quality preset
+            \param[in] mipLevels Number of mip levels to encode. Texture::kMaxPossible encodes the full chain
+            \param[out] dst The blocks of all the mip levels, in the layout Texture::create2D() expects
+            \param[in] isNormalMap Renormalize the normals when generating mips
+            \return The number of encoded mip levels, or 0 if the format combination or the image size is not supported
+        */
+        static uint32_t encode(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat srcFormat, ResourceFormat dstFormat, Quality quality, uint32_t mipLevels, std::vector<uint8_t>& dst, bool isNormalMap = false);
+
+        /** Set the number of threads used to encode. 0 uses all the hardware threads
+        */
+        static void setThreadCount(uint32_t threadCount);
+    };
+}
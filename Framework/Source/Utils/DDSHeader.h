@@ -110,13 +110,15 @@ namespace Falcor
 
             static const uint32_t kCubeMapMask = 0x4;
         };
-
-        struct DdsData
-        {
-            DdsHeader header;
-            DdsHeaderDX10 dx10Header;
-            bool hasDX10Header;
-            std::vector<uint8_t> data;
-        };
     }
-}
\ No newline at end of file
+
+    /** Convert a DXGI format to a Falcor format
+        \return The Falcor format, or ResourceFormat::Unknown if Falcor doesn't support it
+    */
+    ResourceFormat falcorFormatFromDXGIFormat(DXGI_FORMAT fmt);
+
+    /** Convert a Falcor format to the DXGI format stored in DDS files
+        \return The DXGI format, or DXGI_FORMAT_UNKNOWN if there is none
+    */
+    DXGI_FORMAT dxgiFormatFromFalcorFormat(ResourceFormat format);
+}
@@ -0,0 +1,472 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "DepthRasterizer.h"
+#include "Graphics/Model/Mesh.h"
+#include "Utils/AABB.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+namespace Falcor
+{
+    // Vertices closer than this are clipped. Avoids dividing by w close to 0
+    static const float kMinClipW = 1e-4f;
+
+    // Occluder lists with fewer triangles are rasterized on the calling thread
+    static const uint64_t kParallelTriangleThreshold = 2048;
+
+    // Relative bias applied to the nearest depth of a tested box, so that surfaces lying on their own bounding box don't hide it
+    static const float kBoxDepthBias = 1e-3f;
+
+    // Run a worker on threadCount threads, including the calling thread. The worker gets its thread index
+    template<typename WorkerType>
+    static void runWorkers(uint32_t threadCount, const WorkerType& worker)
+    {
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.push_back(std::thread(worker, i));
+        }
+        worker(0);
+        for (auto& t : threads) t.join();
+    }
+
+    DepthRasterizer::SharedPtr DepthRasterizer::create(uint32_t width, uint32_t height)
+    {
+        return SharedPtr(new DepthRasterizer(width, height));
+    }
+
+    DepthRasterizer::DepthRasterizer(uint32_t width, uint32_t height)
+    {
+        resize(width, height);
+    }
+
+    void DepthRasterizer::resize(uint32_t width, uint32_t height)
+    {
+        // Rows are processed 4 pixels at a time
+        mWidth = (std::max(width, 1u) + 3) & ~3u;
+        mHeight = std::max(height, 1u);
+        mInvDepth.assign(mWidth * mHeight, 0.0f);
+    }
+
+    bool DepthRasterizer::begin(const glm::mat4& viewProjMat)
+    {
+        mViewProjMat = viewProjMat;
+        std::fill(mInvDepth.begin(), mInvDepth.end(), 0.0f);
+
+        // The buffer stores 1/w. An orthographic projection doesn't write the view depth into w, so its clip w doesn't depend on the position
+        const glm::vec3 wAxis(viewProjMat[0][3], viewProjMat[1][3], viewProjMat[2][3]);
+        mPerspective = glm::dot(wAxis, wAxis) > 1e-12f;
+        if (mPerspective == false && mOrthographicWarned == false)
+        {
+            logWarning("DepthRasterizer::begin() - orthographic projections are not supported. Nothing will be rasterized");
+            mOrthographicWarned = true;
+        }
+        return mPerspective;
+    }
+
+    void DepthRasterizer::rasterizeClipTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, const Rect& scissor)
+    {
+        // To screen space. y goes down, pixel centers are at half-integers
+        const glm::vec4 clip[3] = { v0, v1, v2 };
+        glm::vec2 p[3];
+        float invW[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            invW[i] = 1.0f / clip[i].w;
+            p[i].x = (clip[i].x * invW[i] * 0.5f + 0.5f) * mWidth;
+            p[i].y = (0.5f - clip[i].y * invW[i] * 0.5f) * mHeight;
+        }
+
+        float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+        if (fabsf(area) < 1e-8f) return;
+
+        // Make the edge functions positive inside regardless of the winding. No back-face culling, casters and receivers can be seen from both sides
+        if (area < 0)
+        {
+            std::swap(p[1], p[2]);
+            std::swap(invW[1], invW[2]);
+            area = -area;
+        }
+
+        const float minX = std::min(p[0].x, std::min(p[1].x, p[2].x));
+        const float maxX = std::max(p[0].x, std::max(p[1].x, p[2].x));
+        const float minY = std::min(p[0].y, std::min(p[1].y, p[2].y));
+        const float maxY = std::max(p[0].y, std::max(p[1].y, p[2].y));
+        if (maxX < scissor.x0 || maxY < scissor.y0 || minX >= scissor.x1 + 1 || minY >= scissor.y1 + 1) return;
+
+        // Clamp to the scissor before converting, a float outside the int32_t range can't be cast. The clamp value comes first, so that a NaN bound is replaced by it
+        // The scissor starts on a multiple of 4 and its width is a multiple of 4, so the 4-wide stores stay inside it
+        const int32_t x0 = (int32_t)std::max((float)scissor.x0, minX) & ~3;
+        const int32_t x1 = (int32_t)std::min((float)scissor.x1, maxX);
+        const int32_t y0 = (int32_t)std::max((float)scissor.y0, minY);
+        const int32_t y1 = (int32_t)std::min((float)scissor.y1, maxY);
+
+        // Edge i is opposite to vertex i. e(x, y) = a * x + b * y + c
+        float a[3], b[3], c[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            const glm::vec2& s = p[(i + 1) % 3];
+            const glm::vec2& e = p[(i + 2) % 3];
+            a[i] = s.y - e.y;
+            b[i] = e.x - s.x;
+            c[i] = s.x * e.y - s.y * e.x;
+        }
+
+        // 1/w is linear in screen space
+        const float invArea = 1.0f / area;
+        const float dzdx = (a[0] * invW[0] + a[1] * invW[1] + a[2] * invW[2]) * invArea;
+        const float dzdy = (b[0] * invW[0] + b[1] * invW[1] + b[2] * invW[2]) * invArea;
+        const float z0 = (c[0] * invW[0] + c[1] * invW[1] + c[2] * invW[2]) * invArea;
+
+        const __m128 xOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]);
+        const __m128 stepE0 = _mm_set1_ps(a[0] * 4), stepE1 = _mm_set1_ps(a[1] * 4), stepE2 = _mm_set1_ps(a[2] * 4), stepZ = _mm_set1_ps(dzdx * 4);
+        for (int32_t y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+            const __m128 px = _mm_add_ps(_mm_set1_ps((float)x0), xOffset);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), _mm_set1_ps(b[0] * py + c[0]));
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), _mm_set1_ps(b[1] * py + c[1]));
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), _mm_set1_ps(b[2] * py + c[2]));
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(dzdy * py + z0));
+
+            float* pRow = mInvDepth.data() + y * mWidth;
+            for (int32_t x = x0; x <= x1; x += 4)
+            {
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside))
+                {
+                    // Larger 1/w is closer
+                    const __m128 old = _mm_loadu_ps(pRow + x);
+                    const __m128 closer = _mm_max_ps(old, z);
+                    _mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+                }
+                e0 = _mm_add_ps(e0, stepE0);
+                e1 = _mm_add_ps(e1, stepE1);
+                e2 = _mm_add_ps(e2, stepE2);
+                z = _mm_add_ps(z, stepZ);
+            }
+        }
+    }
+
+    uint32_t DepthRasterizer::clipTriangle(const glm::vec4 v[3], ClipTriangle result[2]) const
+    {
+        uint32_t insideCount = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            insideCount += (v[i].w >= kMinClipW) ? 1 : 0;
+        }
+
+        if (insideCount == 0) return 0;
+        if (insideCount == 3)
+        {
+            result[0] = { v[0], v[1], v[2] };
+            return 1;
+        }
+
+        // Clip against w = kMinClipW. The result has 3 or 4 vertices
+        glm::vec4 poly[4];
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            const glm::vec4& s = v[i];
+            const glm::vec4& e = v[(i + 1) % 3];
+            if (s.w >= kMinClipW) poly[count++] = s;
+            if ((s.w >= kMinClipW) != (e.w >= kMinClipW))
+            {
+                poly[count++] = glm::mix(s, e, (kMinClipW - s.w) / (e.w - s.w));
+            }
+        }
+        result[0] = { poly[0], poly[1], poly[2] };
+        if (count == 3) return 1;
+        result[1] = { poly[0], poly[2], poly[3] };
+        return 2;
+    }
+
+    void DepthRasterizer::rasterizeTriangles(const glm::vec3* pVertices, uint32_t triangleCount, const glm::mat4& worldMat)
+    {
+        if (mPerspective == false) return;
+
+        const glm::mat4 mat = mViewProjMat * worldMat;
+        const Rect fullRect = getFullRect();
+        for (uint32_t t = 0; t < triangleCount; t++)
+        {
+            glm::vec4 v[3];
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                v[i] = mat * glm::vec4(pVertices[t * 3 + i], 1);
+            }
+
+            ClipTriangle clipped[2];
+            const uint32_t count = clipTriangle(v, clipped);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                rasterizeClipTriangle(clipped[i].v[0], clipped[i].v[1], clipped[i].v[2], fullRect);
+            }
+        }
+    }
+
+    void DepthRasterizer::rasterizeOccluders(const std::vector<Occluder>& occluders)
+    {
+        if (mPerspective == false) return;
+
+        const uint32_t tilesX = (mWidth + kTileWidth - 1) / kTileWidth;
+        const uint32_t tilesY = (mHeight + kTileHeight - 1) / kTileHeight;
+        const uint32_t tileCount = tilesX * tilesY;
+
+        uint64_t triangleCount = 0;
+        for (const auto& occluder : occluders) triangleCount += occluder.triangleCount;
+
+        const uint32_t threadCount = mThreadCount ? mThreadCount : std::thread::hardware_concurrency();
+        if (triangleCount < kParallelTriangleThreshold || threadCount <= 1)
+        {
+            // Binning doesn't pay off on a single thread
+            for (const auto& occluder : occluders)
+            {
+                rasterizeTriangles(occluder.pVertices, occluder.triangleCount, occluder.worldMat);
+            }
+            return;
+        }
+
+        mThreadBins.resize(threadCount);
+        for (auto& bins : mThreadBins)
+        {
+            bins.triangles.clear();
+            bins.tiles.resize(tileCount);
+            for (auto& tile : bins.tiles) tile.clear();
+        }
+
+        // Transform, clip and bin the triangles. Each thread writes its own bins, so no synchronization is needed
+        std::atomic<uint32_t> nextOccluder(0);
+        auto binWorker = [&](uint32_t threadIndex)
+        {
+            ThreadBins& bins = mThreadBins[threadIndex];
+            for (uint32_t o = nextOccluder++; o < (uint32_t)occluders.size(); o = nextOccluder++)
+            {
+                const Occluder& occluder = occluders[o];
+                const glm::mat4 mat = mViewProjMat * occluder.worldMat;
+                for (uint32_t t = 0; t < occluder.triangleCount; t++)
+                {
+                    glm::vec4 v[3];
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        v[i] = mat * glm::vec4(occluder.pVertices[t * 3 + i], 1);
+                    }
+
+                    ClipTriangle clipped[2];
+                    const uint32_t count = clipTriangle(v, clipped);
+                    for (uint32_t c = 0; c < count; c++)
+                    {
+                        glm::vec2 minP(std::numeric_limits<float>::max());
+                        glm::vec2 maxP(-std::numeric_limits<float>::max());
+                        for (uint32_t i = 0; i < 3; i++)
+                        {
+                            const glm::vec4& p = clipped[c].v[i];
+                            const glm::vec2 screen((p.x / p.w * 0.5f + 0.5f) * mWidth, (0.5f - p.y / p.w * 0.5f) * mHeight);
+                            minP = glm::min(minP, screen);
+                            maxP = glm::max(maxP, screen);
+                        }
+                        if (maxP.x < 0 || maxP.y < 0 || minP.x >= mWidth || minP.y >= mHeight) continue;
+
+                        const uint32_t tx0 = (uint32_t)std::max(minP.x, 0.0f) / kTileWidth;
+                        const uint32_t ty0 = (uint32_t)std::max(minP.y, 0.0f) / kTileHeight;
+                        const uint32_t tx1 = std::min((uint32_t)maxP.x / kTileWidth, tilesX - 1);
+                        const uint32_t ty1 = std::min((uint32_t)maxP.y / kTileHeight, tilesY - 1);
+                        const uint32_t index = (uint32_t)bins.triangles.size();
+                        bins.triangles.push_back(clipped[c]);
+                        for (uint32_t ty = ty0; ty <= ty1; ty++)
+                        {
+                            for (uint32_t tx = tx0; tx <= tx1; tx++)
+                            {
+                                bins.tiles[ty * tilesX + tx].push_back(index);
+                            }
+                        }
+                    }
+                }
+            }
+        };
+        runWorkers(threadCount, binWorker);
+
+        // Rasterize the tiles. A tile is only written by the thread which owns it
+        std::atomic<uint32_t> nextTile(0);
+        auto rasterWorker = [&](uint32_t threadIndex)
+        {
+            for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+            {
+                const int32_t tx = (int32_t)(tile % tilesX);
+                const int32_t ty = (int32_t)(tile / tilesX);
+                Rect scissor;
+                scissor.x0 = tx * kTileWidth;
+                scissor.y0 = ty * kTileHeight;
+                scissor.x1 = std::min(scissor.x0 + (int32_t)kTileWidth, (int32_t)mWidth) - 1;
+                scissor.y1 = std::min(scissor.y0 + (int32_t)kTileHeight, (int32_t)mHeight) - 1;
+                for (const auto& bins : mThreadBins)
+                {
+                    for (uint32_t index : bins.tiles[tile])
+                    {
+                        const ClipTriangle& triangle = bins.triangles[index];
+                        rasterizeClipTriangle(triangle.v[0], triangle.v[1], triangle.v[2], scissor);
+                    }
+                }
+            }
+        };
+        runWorkers(std::min(threadCount, tileCount), rasterWorker);
+    }
+
+    bool DepthRasterizer::isBoxVisible(const BoundingBox& box) const
+    {
+        glm::vec2 minP(std::numeric_limits<float>::max());
+        glm::vec2 maxP(-std::numeric_limits<float>::max());
+        float maxInvW = 0;
+        uint32_t behindCount = 0;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            const glm::vec3 corner = box.center + box.extent * glm::vec3((i & 1) ? 1 : -1, (i & 2) ? 1 : -1, (i & 4) ? 1 : -1);
+            const glm::vec4 p = mViewProjMat * glm::vec4(corner, 1);
+            if (p.w < kMinClipW)
+            {
+                behindCount++;
+                continue;
+            }
+
+            const float invW = 1.0f / p.w;
+            const glm::vec2 screen((p.x * invW * 0.5f + 0.5f) * mWidth, (0.5f - p.y * invW * 0.5f) * mHeight);
+            minP = glm::min(minP, screen);
+            maxP = glm::max(maxP, screen);
+            maxInvW = std::max(maxInvW, invW);
+        }
+
+        // Boxes crossing the near plane can't be bounded on screen
+        if (behindCount == 8) return false;
+        if (behindCount > 0) return true;
+        if (maxP.x < 0 || maxP.y < 0 || minP.x >= mWidth || minP.y >= mHeight) return false;
+
+        // Test every pixel the box's screen rectangle touches. The nearest corner is the nearest point of the box, so the box is hidden if all the pixels are closer than it
+        const int32_t x0 = std::max((int32_t)minP.x, 0);
+        const int32_t x1 = std::min((int32_t)maxP.x, (int32_t)mWidth - 1);
+        const int32_t y0 = std::max((int32_t)minP.y, 0);
+        const int32_t y1 = std::min((int32_t)maxP.y, (int32_t)mHeight - 1);
+
+        const __m128 boxInvDepth = _mm_set1_ps(maxInvW * (1 + kBoxDepthBias));
+        const __m128 laneOffset = _mm_setr_ps(0, 1, 2, 3);
+        const __m128 rectMin = _mm_set1_ps((float)x0);
+        const __m128 rectMax = _mm_set1_ps((float)x1);
+        for (int32_t y = y0; y <= y1; y++)
+        {
+            const float* pRow = mInvDepth.data() + y * mWidth;
+            for (int32_t x = x0 & ~3; x <= x1; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+                const __m128 inRect = _mm_and_ps(_mm_cmpge_ps(px, rectMin), _mm_cmple_ps(px, rectMax));
+                const __m128 farther = _mm_cmple_ps(_mm_loadu_ps(pRow + x), boxInvDepth);
+                if (_mm_movemask_ps(_mm_and_ps(inRect, farther))) return true;
+            }
+        }
+        return false;
+    }
+
+    void DepthRasterizer::cacheMeshes(const std::vector<std::shared_ptr<const Mesh>>& meshes)
+    {
+        pruneMeshCache();
+
+        std::vector<std::shared_ptr<const Mesh>> newMeshes;
+        std::vector<const Mesh*> newMeshPtrs;
+        for (const auto& pMesh : meshes)
+        {
+            if (pMesh == nullptr) continue;
+            auto cached = mMeshTriangles.find(pMesh.get());
+            if (cached != mMeshTriangles.end() && cached->second.pMesh.lock() == pMesh) continue;
+            if (std::find(newMeshPtrs.begin(), newMeshPtrs.end(), pMesh.get()) != newMeshPtrs.end()) continue;
+            newMeshes.push_back(pMesh);
+            newMeshPtrs.push_back(pMesh.get());
+        }
+
+        // Unsupported meshes keep an empty list, so they're not read again
+        std::vector<std::vector<glm::vec3>> triangles = Mesh::readTriangles(newMeshPtrs);
+        for (size_t i = 0; i < newMeshes.size(); i++)
+        {
+            MeshTriangles& entry = mMeshTriangles[newMeshPtrs[i]];
+            entry.pMesh = newMeshes[i];
+            entry.vertices = std::move(triangles[i]);
+        }
+    }
+
+    void DepthRasterizer::pruneMeshCache()
+    {
+        for (auto it = mMeshTriangles.begin(); it != mMeshTriangles.end();)
+        {
+            it = it->second.pMesh.expired() ? mMeshTriangles.erase(it) : std::next(it);
+        }
+    }
+
+    const std::vector<glm::vec3>* DepthRasterizer::getMeshTriangles(const Mesh* pMesh) const
+    {
+        auto it = mMeshTriangles.find(pMesh);
+        if (it == mMeshTriangles.end() || it->second.vertices.empty() || it->second.pMesh.expired()) return nullptr;
+        return &it->second.vertices;
+    }
+
+    bool DepthRasterizer::rasterizeMesh(const Mesh* pMesh, const glm::mat4& worldMat)
+    {
+        const std::vector<glm::vec3>* pVertices = getMeshTriangles(pMesh);
+        if (pVertices == nullptr || mPerspective == false) return false;
+        rasterizeTriangles(pVertices->data(), (uint32_t)pVertices->size() / 3, worldMat);
+        return true;
+    }
+
+    bool DepthRasterizer::getDepthRange(glm::vec2& depthRange) const
+    {
+        // Uncovered pixels are 0. Replace them by +inf for the minimum
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        __m128 minInvDepth = inf;
+        __m128 maxInvDepth = zero;
+        for (size_t i = 0; i < mInvDepth.size(); i += 4)
+        {
+            const __m128 d = _mm_loadu_ps(mInvDepth.data() + i);
+            const __m128 covered = _mm_cmpgt_ps(d, zero);
+            minInvDepth = _mm_min_ps(minInvDepth, _mm_or_ps(_mm_and_ps(covered, d), _mm_andnot_ps(covered, inf)));
+            maxInvDepth = _mm_max_ps(maxInvDepth, d);
+        }
+
+        float minValues[4], maxValues[4];
+        _mm_storeu_ps(minValues, minInvDepth);
+        _mm_storeu_ps(maxValues, maxInvDepth);
+        const float minInv = std::min(std::min(minValues[0], minValues[1]), std::min(minValues[2], minValues[3]));
+        const float maxInv = std::max(std::max(maxValues[0], maxValues[1]), std::max(maxValues[2], maxValues[3]));
+        if (maxInv <= 0) return false;
+
+        depthRange = glm::vec2(1.0f / maxInv, 1.0f / minInv);
+        return true;
+    }
+}
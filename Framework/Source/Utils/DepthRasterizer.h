@@ -0,0 +1,168 @@
+/***************************************************************************
+# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "glm/mat4x4.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace Falcor
+{
+    class Mesh;
+    struct BoundingBox;
+
+    /** Low-resolution software depth rasterizer.
+        Rasterizes triangles into a small CPU depth buffer using SSE, without touching the GPU. The buffer stores the reciprocal of the view-space depth (1/w), which is linear in screen space and independent of the projection depth convention. Only perspective projections are supported: with an orthographic projection w is constant, so begin() rejects it and nothing is rasterized.
+        Mesh positions are read once, the first time a mesh is passed to cacheMeshes(), from the CPU geometry of meshes loaded with Model::LoadFlags::KeepCpuGeometry and from the GPU otherwise. The cache only holds weak references, and entries of destroyed meshes are dropped by pruneMeshCache().
+        Large occluder sets can be rasterized across threads with rasterizeOccluders(), which bins the triangles into screen tiles, and bounding boxes can be tested against the result with isBoxVisible().
+    */
+    class DepthRasterizer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<DepthRasterizer>;
+        using SharedConstPtr = std::shared_ptr<const DepthRasterizer>;
+
+        static const uint32_t kTileWidth = 32;     ///< Width of the tiles used by rasterizeOccluders(). A multiple of 4
+        static const uint32_t kTileHeight = 16;    ///< Height of the tiles used by rasterizeOccluders()
+
+        /** A triangle list to rasterize with rasterizeOccluders()
+        */
+        struct Occluder
+        {
+            const glm::vec3* pVertices = nullptr;  ///< Object-space positions, 3 per triangle
+            uint32_t triangleCount = 0;
+            glm::mat4 worldMat;
+        };
+
+        /** Create a new rasterizer
+            \param[in] width Buffer width in pixels. Rounded up to a multiple of 4
+            \param[in] height Buffer height in pixels
+        */
+        static SharedPtr create(uint32_t width, uint32_t height);
+
+        /** Change the buffer size. The content is lost
+        */
+        void resize(uint32_t width, uint32_t height);
+
+        /** Clear the buffer and set the view-projection matrix used by the following rasterize calls
+            \return false if the projection isn't a perspective projection. The rasterize calls are then ignored, which leaves every box visible
+        */
+        bool begin(const glm::mat4& viewProjMat);
+
+        /** Rasterize a triangle list
+            \param[in] pVertices Object-space positions, 3 per triangle
+            \param[in] triangleCount Number of triangles
+            \param[in] worldMat Object-to-world transform
+        */
+        void rasterizeTriangles(const glm::vec3* pVertices, uint32_t triangleCount, const glm::mat4& worldMat);
+
+        /** Read the positions of meshes which are not cached yet, using Mesh::readTriangles(). Meshes which are not triangle lists with float positions are skipped. Calls pruneMeshCache() first
+        */
+        void cacheMeshes(const std::vector<std::shared_ptr<const Mesh>>& meshes);
+
+        /** Drop the cached triangles of destroyed meshes. Meant to be called every frame
+        */
+        void pruneMeshCache();
+
+        /** Get the cached object-space triangles of a mesh, 3 vertices per triangle
+            \return The vertices, or nullptr if the mesh wasn't cached, couldn't be read or was destroyed
+        */
+        const std::vector<glm::vec3>* getMeshTriangles(const Mesh* pMesh) const;
+
+        /** Rasterize a cached mesh
+            \return false if the mesh is not cached or the projection isn't a perspective projection, otherwise true
+        */
+        bool rasterizeMesh(const Mesh* pMesh, const glm::mat4& worldMat);
+
+        /** Rasterize a list of occluders. The triangles are transformed and binned into screen tiles in parallel, then the tiles are rasterized in parallel. Small lists are rasterized on the calling thread
+        */
+        void rasterizeOccluders(const std::vector<Occluder>& occluders);
+
+        /** Set the number of threads used by rasterizeOccluders(). 0 uses one thread per hardware thread
+        */
+        void setThreadCount(uint32_t threadCount) { mThreadCount = threadCount; }
+
+        /** Check if any part of a world-space box may be visible. Conservative: boxes crossing the near plane are visible, boxes behind the camera are hidden, and a box is only hidden if every pixel it overlaps is covered by a closer occluder. Boxes outside the screen are hidden
+        */
+        bool isBoxVisible(const BoundingBox& box) const;
+
+        /** Get the range of view-space depths of the covered pixels
+            \param[out] depthRange The nearest and farthest depth
+            \return false if no pixel was covered, otherwise true
+        */
+        bool getDepthRange(glm::vec2& depthRange) const;
+
+        /** Get the reciprocal depth of a pixel. 0 means the pixel wasn't covered
+        */
+        float getInvDepth(uint32_t x, uint32_t y) const { return mInvDepth[y * mWidth + x]; }
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+
+    private:
+        DepthRasterizer(uint32_t width, uint32_t height);
+
+        // Pixel rectangle, inclusive
+        struct Rect
+        {
+            int32_t x0, y0, x1, y1;
+        };
+
+        // Clip-space triangle, in front of the near plane
+        struct ClipTriangle
+        {
+            glm::vec4 v[3];
+        };
+
+        void rasterizeClipTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, const Rect& scissor);
+        uint32_t clipTriangle(const glm::vec4 v[3], ClipTriangle result[2]) const;
+        Rect getFullRect() const { return{ 0, 0, (int32_t)mWidth - 1, (int32_t)mHeight - 1 }; }
+
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        glm::mat4 mViewProjMat;
+        bool mPerspective = true;
+        bool mOrthographicWarned = false;
+        std::vector<float> mInvDepth;
+        uint32_t mThreadCount = 0;
+
+        // Triangles binned by one thread of rasterizeOccluders(). Kept between calls to reuse the allocations
+        struct ThreadBins
+        {
+            std::vector<ClipTriangle> triangles;
+            std::vector<std::vector<uint32_t>> tiles;   ///< Indices into triangles, per tile
+        };
+        std::vector<ThreadBins> mThreadBins;
+
+        struct MeshTriangles
+        {
+            std::weak_ptr<const Mesh> pMesh;    ///< Detects a new mesh allocated at the address of a destroyed one
+            std::vector<glm::vec3> vertices;    ///< Object-space vertices, 3 per triangle
+        };
+        std::unordered_map<const Mesh*, MeshTriangles> mMeshTriangles;
+    };
+}
@@ -28,6 +28,7 @@
 #pragma once
 #include <chrono>
 #include <vector>
+#include <algorithm>
 #include "CpuTimer.h"
 
 namespace Falcor
@@ -50,6 +51,8 @@ namespace Falcor
         {
             newFrame();
             mFrameCount = 0;
+            std::fill(mFrameTimes.begin(), mFrameTimes.end(), 0.0f);
+            mWindowSum = 0;
         }
 
         /** Tick the timer.
@@ -59,7 +62,10 @@ namespace Falcor
         {
             mFrameCount++;
             mTimer.update();
-            mFrameTimes[mFrameCount % sFrameWindow] = mTimer.getElapsedTime();
+            // Keep a running sum of the window, so the average doesn't need to re-sum it
+            float& slot = mFrameTimes[mFrameCount % sFrameWindow];
+            mWindowSum += double(mTimer.getElapsedTime()) - double(slot);
+            slot = mTimer.getElapsedTime();
         }
 
         /** Get the time in ms it took to render a frame
@@ -67,13 +73,8 @@ namespace Falcor
         float getAverageFrameTime() const
         {
             uint32_t frames = min(mFrameCount, sFrameWindow);
-            double elapsedTime = 0;
-            for(uint32_t i = 0; i < frames; i++)
-            {
-                elapsedTime += mFrameTimes[i];
-            }
-
-            double time = elapsedTime / double(frames) * 1000;
+            if (frames == 0) return 0;
+            double time = mWindowSum / double(frames) * 1000;
             return float(time);
         }
 
@@ -94,6 +95,7 @@ namespace Falcor
 
         CpuTimer mTimer;
         std::vector<float> mFrameTimes;
+        double mWindowSum = 0;
         uint32_t mFrameCount;
         static const uint32_t sFrameWindow = 60;
     };
@@ -0,0 +1,392 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+// winsock2.h has to be included before windows.h, which the API headers pull in
+#define NOMINMAX
+#include <winsock2.h>
+#include "Framework.h"
+#include "FrameTelemetry.h"
+#include "Utils/Gui.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace Falcor
+{
+    FrameCounters gFrameCounters;
+
+    // How often the exporter thread wakes up to drain the ring
+    static const uint32_t kExportIntervalMs = 10;
+
+    // How often the exporter retries connecting to the local port
+    static const uint32_t kReconnectIntervalMs = 1000;
+
+    static const char* kCsvHeader = "frame,timestamp,cpuTime,gpuTime,presentTime,drawCalls,uploadBytes\n";
+
+    void FrameTelemetry::Statistics::add(double value)
+    {
+        mCount++;
+        if (mCount == 1)
+        {
+            mMin = mMax = value;
+        }
+        else
+        {
+            mMin = std::min(mMin, value);
+            mMax = std::max(mMax, value);
+        }
+        // Welford's update
+        double delta = value - mMean;
+        mMean += delta / mCount;
+        mM2 += delta * (value - mMean);
+    }
+
+    void FrameTelemetry::Statistics::reset()
+    {
+        *this = Statistics();
+    }
+
+    FrameTelemetry::Histogram::Histogram(double resolution) : mResolution(resolution)
+    {
+        mBuckets.resize(2 * kSubBucketCount + kMaxShift * kSubBucketCount, 0);
+    }
+
+    uint32_t FrameTelemetry::Histogram::getBucket(uint64_t value) const
+    {
+        // The first 2 * kSubBucketCount values get a bucket each. Larger values keep their kSubBucketBits + 1 most significant bits
+        if (value < 2 * kSubBucketCount) return (uint32_t)value;
+        uint32_t shift = 1;
+        while ((value >> shift) >= 2 * kSubBucketCount) shift++;
+        if (shift > kMaxShift) return (uint32_t)mBuckets.size() - 1;
+        return 2 * kSubBucketCount + (shift - 1) * kSubBucketCount + (uint32_t)(value >> shift) - kSubBucketCount;
+    }
+
+    double FrameTelemetry::Histogram::getBucketValue(uint32_t bucket) const
+    {
+        if (bucket < 2 * kSubBucketCount) return bucket * mResolution;
+        uint32_t shift = (bucket - 2 * kSubBucketCount) / kSubBucketCount + 1;
+        uint64_t first = (uint64_t)((bucket - 2 * kSubBucketCount) % kSubBucketCount + kSubBucketCount) << shift;
+        uint64_t width = 1ull << shift;
+        // Middle of the bucket
+        return (first + (width - 1) * 0.5) * mResolution;
+    }
+
+    void FrameTelemetry::Histogram::add(double value)
+    {
+        uint64_t quantized = (value > 0) ? (uint64_t)(value / mResolution + 0.5) : 0;
+        mBuckets[getBucket(quantized)]++;
+        mCount++;
+    }
+
+    void FrameTelemetry::Histogram::reset()
+    {
+        std::fill(mBuckets.begin(), mBuckets.end(), 0);
+        mCount = 0;
+    }
+
+    double FrameTelemetry::Histogram::getPercentile(double fraction) const
+    {
+        if (mCount == 0) return 0;
+        uint64_t target = std::max((uint64_t)std::ceil(std::min(std::max(fraction, 0.0), 1.0) * mCount), (uint64_t)1);
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < mBuckets.size(); i++)
+        {
+            sum += mBuckets[i];
+            if (sum >= target) return getBucketValue(i);
+        }
+        return getBucketValue((uint32_t)mBuckets.size() - 1);
+    }
+
+    FrameTelemetry::SharedPtr FrameTelemetry::create(const Desc& desc)
+    {
+        return SharedPtr(new FrameTelemetry(desc));
+    }
+
+    FrameTelemetry::FrameTelemetry(const Desc& desc) : mDesc(desc), mWriteIndex(0), mReadIndex(0), mDroppedRecords(0), mStopExport(false)
+    {
+        mStartTime = CpuTimer::getCurrentTimePoint();
+        if (mDesc.measureGpuTime)
+        {
+            mpGpuTimers[0] = GpuTimer::create();
+            mpGpuTimers[1] = GpuTimer::create();
+        }
+
+        if (mDesc.filename.size() || mDesc.port)
+        {
+            uint64_t ringSize = 1;
+            while (ringSize < std::max(mDesc.ringSize, 2u)) ringSize <<= 1;
+            mRing.resize(ringSize);
+            mRingMask = ringSize - 1;
+            mExportThread = std::thread(&FrameTelemetry::exportLoop, this);
+        }
+    }
+
+    FrameTelemetry::~FrameTelemetry()
+    {
+        // Publish the last frame without its GPU time rather than losing it
+        if (mHasPendingRecord)
+        {
+            publish(mPendingRecord);
+        }
+        if (mExportThread.joinable())
+        {
+            mStopExport = true;
+            mExportThread.join();
+        }
+    }
+
+    void FrameTelemetry::beginFrame()
+    {
+        if (mDesc.measureGpuTime)
+        {
+            mpGpuTimers[mGpuTimerIndex]->begin();
+        }
+    }
+
+    void FrameTelemetry::beginPresent()
+    {
+        // End the GPU timer before present() submits the command list
+        if (mDesc.measureGpuTime)
+        {
+            mpGpuTimers[mGpuTimerIndex]->end();
+        }
+        mPresentStart = CpuTimer::getCurrentTimePoint();
+    }
+
+    void FrameTelemetry::endFrame(uint64_t frameId, float cpuFrameTime)
+    {
+        CpuTimer::TimePoint now = CpuTimer::getCurrentTimePoint();
+
+        Record record;
+        record.frameId = frameId;
+        record.timestamp = std::chrono::duration<double>(now - mStartTime).count();
+        record.cpuTime = cpuFrameTime * 1000.0f;
+        record.presentTime = CpuTimer::calcDuration(mPresentStart, now);
+        // Read and clear in one step, so counts added by other threads in between aren't lost
+        record.drawCalls = (uint32_t)gFrameCounters.drawCalls.exchange(0);
+        record.uploadBytes = gFrameCounters.uploadBytes.exchange(0);
+
+        // The previous frame's timer is done by now. Complete its record and keep this one until the next frame
+        if (mHasPendingRecord)
+        {
+            if (mDesc.measureGpuTime)
+            {
+                mPendingRecord.gpuTime = (float)mpGpuTimers[1 - mGpuTimerIndex]->getElapsedTime();
+            }
+            publish(mPendingRecord);
+        }
+        mPendingRecord = record;
+        mHasPendingRecord = true;
+        mGpuTimerIndex = 1 - mGpuTimerIndex;
+    }
+
+    void FrameTelemetry::publish(const Record& record)
+    {
+        mSummary.cpuTime.add(record.cpuTime);
+        mSummary.presentTime.add(record.presentTime);
+        mSummary.drawCalls.add(record.drawCalls);
+        mSummary.uploadBytes.add((double)record.uploadBytes);
+        mSummary.cpuTimeHistogram.add(record.cpuTime);
+        mSummary.presentTimeHistogram.add(record.presentTime);
+        if (mDesc.measureGpuTime)
+        {
+            mSummary.gpuTime.add(record.gpuTime);
+            mSummary.gpuTimeHistogram.add(record.gpuTime);
+        }
+
+        if (mRing.empty()) return;
+        uint64_t writeIndex = mWriteIndex.load(std::memory_order_relaxed);
+        if (writeIndex - mReadIndex.load(std::memory_order_acquire) >= mRing.size())
+        {
+            mDroppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        mRing[writeIndex & mRingMask] = record;
+        mWriteIndex.store(writeIndex + 1, std::memory_order_release);
+    }
+
+    void FrameTelemetry::reset()
+    {
+        mSummary = Summary();
+    }
+
+    std::string FrameTelemetry::formatRecord(const Record& record) const
+    {
+        std::ostringstream ss;
+        if (mDesc.format == ExportFormat::Csv)
+        {
+            ss << record.frameId << ',' << record.timestamp << ',' << record.cpuTime << ',' << record.gpuTime << ',' << record.presentTime << ','
+                << record.drawCalls << ',' << record.uploadBytes << '\n';
+        }
+        else
+        {
+            ss << "{\"frame\":" << record.frameId << ",\"timestamp\":" << record.timestamp << ",\"cpuTime\":" << record.cpuTime << ",\"gpuTime\":" << record.gpuTime
+                << ",\"presentTime\":" << record.presentTime << ",\"drawCalls\":" << record.drawCalls << ",\"uploadBytes\":" << record.uploadBytes << "}\n";
+        }
+        return ss.str();
+    }
+
+    static SOCKET connectToLocalPort(uint16_t port)
+    {
+        SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_SOCKET) return s;
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(s, (const sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR)
+        {
+            closesocket(s);
+            return INVALID_SOCKET;
+        }
+        return s;
+    }
+
+    static bool sendAll(SOCKET s, const std::string& data)
+    {
+        size_t offset = 0;
+        while (offset < data.size())
+        {
+            int sent = send(s, data.data() + offset, (int)std::min(data.size() - offset, (size_t)INT_MAX), 0);
+            if (sent == SOCKET_ERROR) return false;
+            offset += sent;
+        }
+        return true;
+    }
+
+    void FrameTelemetry::exportLoop()
+    {
+        const char* header = (mDesc.format == ExportFormat::Csv) ? kCsvHeader : "";
+
+        std::ofstream file;
+        if (mDesc.filename.size())
+        {
+            file.open(mDesc.filename);
+            if (file.fail())
+            {
+                logWarning("FrameTelemetry: can't open " + mDesc.filename + " for writing");
+            }
+            file << header;
+        }
+
+        bool useSocket = false;
+        if (mDesc.port)
+        {
+            WSADATA wsaData;
+            useSocket = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+            if (useSocket == false) logWarning("FrameTelemetry: can't initialize Winsock. Records won't be sent to port " + std::to_string(mDesc.port));
+        }
+        SOCKET s = INVALID_SOCKET;
+        auto lastConnectAttempt = std::chrono::steady_clock::now() - std::chrono::milliseconds(kReconnectIntervalMs);
+
+        while (true)
+        {
+            // Check for the stop request before draining, so that everything published before it gets exported
+            bool stop = mStopExport.load();
+
+            uint64_t readIndex = mReadIndex.load(std::memory_order_relaxed);
+            uint64_t writeIndex = mWriteIndex.load(std::memory_order_acquire);
+            std::string batch;
+            for (; readIndex < writeIndex; readIndex++)
+            {
+                batch += formatRecord(mRing[readIndex & mRingMask]);
+            }
+            mReadIndex.store(readIndex, std::memory_order_release);
+
+            if (file.is_open() && batch.size())
+            {
+                file << batch;
+                file.flush();
+            }
+
+            if (useSocket)
+            {
+                // The listener can come and go. Reconnect periodically and send the header on each new connection
+                auto now = std::chrono::steady_clock::now();
+                if (s == INVALID_SOCKET && now - lastConnectAttempt >= std::chrono::milliseconds(kReconnectIntervalMs))
+                {
+                    lastConnectAttempt = now;
+                    s = connectToLocalPort(mDesc.port);
+                    if (s != INVALID_SOCKET && sendAll(s, header) == false)
+                    {
+                        closesocket(s);
+                        s = INVALID_SOCKET;
+                    }
+                }
+                if (s != INVALID_SOCKET && batch.size() && sendAll(s, batch) == false)
+                {
+                    closesocket(s);
+                    s = INVALID_SOCKET;
+                }
+            }
+
+            if (stop) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(kExportIntervalMs));
+        }
+
+        if (s != INVALID_SOCKET) closesocket(s);
+        if (useSocket) WSACleanup();
+    }
+
+    void FrameTelemetry::renderUI(Gui* pGui, const char* group) const
+    {
+        if (group == nullptr || pGui->beginGroup(group))
+        {
+            auto formatTimes = [](const char* name, const Statistics& stats, const Histogram& histogram)
+            {
+                std::ostringstream ss;
+                ss.setf(std::ios::fixed);
+                ss.precision(2);
+                ss << name << ": avg " << stats.getMean() << ", p50 " << histogram.getPercentile(0.5) << ", p95 " << histogram.getPercentile(0.95)
+                    << ", p99 " << histogram.getPercentile(0.99) << ", max " << stats.getMax() << " ms\n";
+                return ss.str();
+            };
+
+            std::string text = "Frames: " + std::to_string(mSummary.cpuTime.getCount()) + "\n";
+            text += formatTimes("CPU", mSummary.cpuTime, mSummary.cpuTimeHistogram);
+            if (mDesc.measureGpuTime)
+            {
+                text += formatTimes("GPU", mSummary.gpuTime, mSummary.gpuTimeHistogram);
+            }
+            text += formatTimes("Present", mSummary.presentTime, mSummary.presentTimeHistogram);
+            text += "Draw calls: " + std::to_string((uint64_t)mSummary.drawCalls.getMean()) + " avg, " + std::to_string((uint64_t)mSummary.drawCalls.getMax()) + " max\n";
+            text += "Uploads: " + std::to_string((uint64_t)mSummary.uploadBytes.getMean() >> 10) + " KB avg, " + std::to_string((uint64_t)mSummary.uploadBytes.getMax() >> 10) + " KB max";
+            if (mRing.size())
+            {
+                text += "\nDropped records: " + std::to_string(getDroppedRecordCount());
+            }
+            pGui->addText(text.c_str());
+            if (group) pGui->endGroup();
+        }
+    }
+}
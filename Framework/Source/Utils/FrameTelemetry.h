@@ -0,0 +1,224 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/GpuTimer.h"
+#include "Utils/CpuTimer.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+    class Gui;
+
+    /** Counters the render and copy contexts increment as commands are recorded.
+        Buffers and textures can be updated from loader and worker threads, so the counters are atomic. FrameTelemetry reads and clears them once a frame.
+    */
+    struct FrameCounters
+    {
+        std::atomic<uint64_t> drawCalls{ 0 };     ///< Draw calls, including indirect draws
+        std::atomic<uint64_t> uploadBytes{ 0 };   ///< Bytes copied from the CPU into buffers and textures
+    };
+
+    extern FrameCounters gFrameCounters;
+
+    /** Per-frame telemetry.
+        Every frame produces a record with the CPU frame time, the GPU time of the frame, the time spent in present(), the draw-call count and the uploaded bytes.
+        Records update running statistics in O(1): mean and variance are accumulated with Welford's method, and the times go into log-linear histograms (in the style of HdrHistogram) with 32 buckets per power of 2, from which percentiles are read. A bucket is at most 1/32 of its values wide, so a percentile is off by at most 1/64.
+        Records are also pushed into a single-producer/single-consumer lock-free ring, which an exporter thread drains into a CSV or JSON-lines file and/or a TCP connection to a local port. If the exporter falls behind, records are dropped rather than stalling the frame.
+        GPU times are read with the same one-frame latency as the Profiler, so the record of a frame is completed and published at the end of the next frame.
+        Telemetry is off unless an object is created. Sample creates one when started with -telemetry <file> or -telemetryport <port>.
+    */
+    class FrameTelemetry
+    {
+    public:
+        using SharedPtr = std::shared_ptr<FrameTelemetry>;
+        using SharedConstPtr = std::shared_ptr<const FrameTelemetry>;
+
+        /** Export file format
+        */
+        enum class ExportFormat
+        {
+            Csv,        ///< Header line and one comma-separated line per frame
+            Json,       ///< One JSON object per line
+        };
+
+        struct Desc
+        {
+            std::string filename;                   ///< File to stream the records to. Empty to disable
+            uint16_t port = 0;                      ///< Local TCP port to stream the records to. 0 to disable
+            ExportFormat format = ExportFormat::Csv;
+            uint32_t ringSize = 1024;               ///< Capacity of the export ring, rounded up to a power of 2
+            bool measureGpuTime = true;             ///< Time the frame on the GPU. Costs two timestamp queries a frame
+        };
+
+        /** A frame's record. Times are in milliseconds
+        */
+        struct Record
+        {
+            uint64_t frameId = 0;
+            double timestamp = 0;       ///< Seconds since the telemetry was created, at the end of the frame
+            float cpuTime = 0;          ///< Time between the start of this frame and the start of the previous one
+            float gpuTime = 0;          ///< Time between the GPU timestamps at the start and end of the frame
+            float presentTime = 0;      ///< CPU time spent in present(), which includes waiting for v-sync and for the GPU to catch up
+            uint32_t drawCalls = 0;
+            uint64_t uploadBytes = 0;
+        };
+
+        /** Running statistics of a value. Mean, variance, min and max are exact
+        */
+        class Statistics
+        {
+        public:
+            void add(double value);
+            void reset();
+            uint64_t getCount() const { return mCount; }
+            double getMean() const { return mMean; }
+            double getVariance() const { return (mCount > 1) ? mM2 / (mCount - 1) : 0; }
+            double getMin() const { return mMin; }
+            double getMax() const { return mMax; }
+
+        private:
+            uint64_t mCount = 0;
+            double mMean = 0;
+            double mM2 = 0;
+            double mMin = 0;
+            double mMax = 0;
+        };
+
+        /** Log-linear histogram of positive values.
+            Values are quantized to multiples of the resolution. The first 64 buckets are exact, after that every power of 2 is split into 32 buckets. A bucket is at most 1/32 of its values wide and percentiles return its middle, so a percentile is off by at most 1/64 of its value
+        */
+        class Histogram
+        {
+        public:
+            /** \param[in] resolution Smallest distinguishable value
+            */
+            Histogram(double resolution = 1e-3);
+            void add(double value);
+            void reset();
+            uint64_t getCount() const { return mCount; }
+
+            /** Get the value below which the given fraction of the samples lie. Walks the buckets, so it costs O(bucket count)
+                \param[in] fraction In [0, 1], for example 0.99 for the 99th percentile
+            */
+            double getPercentile(double fraction) const;
+
+        private:
+            static const uint32_t kSubBucketBits = 5;
+            static const uint32_t kSubBucketCount = 1 << kSubBucketBits;
+            static const uint32_t kMaxShift = 40;
+            uint32_t getBucket(uint64_t value) const;
+            double getBucketValue(uint32_t bucket) const;
+
+            double mResolution;
+            std::vector<uint32_t> mBuckets;
+            uint64_t mCount = 0;
+        };
+
+        /** Aggregated statistics since the creation or the last reset()
+        */
+        struct Summary
+        {
+            Statistics cpuTime;
+            Statistics gpuTime;
+            Statistics presentTime;
+            Statistics drawCalls;
+            Statistics uploadBytes;
+            Histogram cpuTimeHistogram;
+            Histogram gpuTimeHistogram;
+            Histogram presentTimeHistogram;
+        };
+
+        /** Create a telemetry object and start the exporter thread if an export target is set
+        */
+        static SharedPtr create(const Desc& desc);
+
+        /** Flushes the ring and stops the exporter thread
+        */
+        ~FrameTelemetry();
+
+        /** Call at the start of the frame, before recording any command
+        */
+        void beginFrame();
+
+        /** Call right before present()
+        */
+        void beginPresent();
+
+        /** Call at the end of the frame, after present()
+            \param[in] frameId The frame number
+            \param[in] cpuFrameTime The CPU frame time in seconds, as returned by FrameRate::getLastFrameTime()
+        */
+        void endFrame(uint64_t frameId, float cpuFrameTime);
+
+        /** Get the statistics. Only valid on the rendering thread
+        */
+        const Summary& getSummary() const { return mSummary; }
+
+        /** Clear the statistics. Records which are already queued for export are still exported
+        */
+        void reset();
+
+        /** Get the number of records dropped because the export ring was full
+        */
+        uint64_t getDroppedRecordCount() const { return mDroppedRecords.load(); }
+
+        /** Render the percentiles and averages
+        */
+        void renderUI(Gui* pGui, const char* group = nullptr) const;
+
+    private:
+        FrameTelemetry(const Desc& desc);
+        void publish(const Record& record);
+        void exportLoop();
+        std::string formatRecord(const Record& record) const;
+
+        Desc mDesc;
+        Summary mSummary;
+        CpuTimer::TimePoint mStartTime;
+        CpuTimer::TimePoint mPresentStart;
+        float mPresentTime = 0;
+
+        // The GPU timers are double-buffered. The record of the previous frame waits for its GPU time in mPendingRecord
+        GpuTimer::SharedPtr mpGpuTimers[2];
+        uint32_t mGpuTimerIndex = 0;
+        Record mPendingRecord;
+        bool mHasPendingRecord = false;
+
+        // Single-producer/single-consumer ring. The rendering thread only writes mWriteIndex and the exporter only writes mReadIndex
+        std::vector<Record> mRing;
+        uint64_t mRingMask = 0;
+        std::atomic<uint64_t> mWriteIndex;
+        std::atomic<uint64_t> mReadIndex;
+        std::atomic<uint64_t> mDroppedRecords;
+        std::atomic<bool> mStopExport;
+        std::thread mExportThread;
+    };
+}
@@ -143,8 +143,9 @@ namespace Falcor
 
         // Need to create a new VAO
         std::vector<Buffer::SharedPtr> pVB(1);
-        pVB[0] = createVB ? Buffer::create(requiredVbSize + sizeof(ImDrawVert) * 1000, Buffer::BindFlags::Vertex, Buffer::CpuAccess::Write, nullptr) : mpVao->getVertexBuffer(0);
-        Buffer::SharedPtr pIB = createIB ? Buffer::create(requiredIbSize, Buffer::BindFlags::Index, Buffer::CpuAccess::Write, nullptr): mpVao->getIndexBuffer();
+        // The buffers are rewritten every frame, so they can live in the upload ring
+        pVB[0] = createVB ? Buffer::createTransient(requiredVbSize + sizeof(ImDrawVert) * 1000, Buffer::BindFlags::Vertex) : mpVao->getVertexBuffer(0);
+        Buffer::SharedPtr pIB = createIB ? Buffer::createTransient(requiredIbSize, Buffer::BindFlags::Index): mpVao->getIndexBuffer();
         mpVao = Vao::create(pVB, mpLayout, pIB, ResourceFormat::R16Uint, Vao::Topology::TriangleList);
     }
     
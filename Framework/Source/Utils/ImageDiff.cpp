@@ -0,0 +1,556 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ImageDiff.h"
+#include "Utils/Bitmap.h"
+#include "glm/gtc/packing.hpp"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+namespace Falcor
+{
+    // SSIM window radius. The window is (2 * kSsimRadius + 1) pixels wide
+    static const uint32_t kSsimRadius = 3;
+    static const uint32_t kSsimWindow = 2 * kSsimRadius + 1;
+
+    // SSIM stabilization constants for a dynamic range of 1
+    static const float kSsimC1 = 0.01f * 0.01f;
+    static const float kSsimC2 = 0.03f * 0.03f;
+
+    // Rows handed to a worker at a time
+    static const uint32_t kRowsPerJob = 16;
+
+    // Run a worker on threadCount threads, including the calling thread
+    template<typename WorkerType>
+    static void runWorkers(uint32_t threadCount, const WorkerType& worker)
+    {
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < threadCount; i++)
+        {
+            threads.push_back(std::thread(worker));
+        }
+        worker();
+        for (auto& t : threads) t.join();
+    }
+
+    // Call func(first, last) for ranges of rows, pulled from a shared counter by every thread
+    template<typename FuncType>
+    static void parallelRows(uint32_t threadCount, uint32_t rowCount, const FuncType& func)
+    {
+        std::atomic<uint32_t> nextRow(0);
+        auto worker = [&]
+        {
+            while (true)
+            {
+                uint32_t first = nextRow.fetch_add(kRowsPerJob);
+                if (first >= rowCount) break;
+                func(first, std::min(first + kRowsPerJob, rowCount));
+            }
+        };
+        runWorkers(threadCount, worker);
+    }
+
+    static float srgbToLinear(float c)
+    {
+        return (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float linearToSrgb(float c)
+    {
+        return (c <= 0.0031308f) ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    static const float* getSrgbToLinearTable()
+    {
+        static float sTable[256];
+        static bool sInit = [] { for (uint32_t i = 0; i < 256; i++) sTable[i] = srgbToLinear(i / 255.0f); return true; }();
+        (void)sInit;
+        return sTable;
+    }
+
+    /** One decoded row. Encoded values are the display values used by MSE and SSIM, linear values are used by the CIELAB conversion
+    */
+    struct DecodedRow
+    {
+        std::vector<float> encoded[3];
+        std::vector<float> linear[3];
+
+        void resize(uint32_t size)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                encoded[c].assign(size, 0.0f);
+                linear[c].assign(size, 0.0f);
+            }
+        }
+    };
+
+    static void decodeRow(const uint8_t* pRow, ResourceFormat format, uint32_t width, DecodedRow& row)
+    {
+        const float* pTable = getSrgbToLinearTable();
+        switch (format)
+        {
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+        {
+            bool bgr = (format != ResourceFormat::RGBA8Unorm) && (format != ResourceFormat::RGBA8UnormSrgb);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint8_t* pPixel = pRow + x * 4;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    uint8_t v = pPixel[bgr ? 2 - c : c];
+                    row.encoded[c][x] = v * (1.0f / 255.0f);
+                    row.linear[c][x] = pTable[v];
+                }
+            }
+            break;
+        }
+        case ResourceFormat::RGBA32Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA16Float:
+        {
+            uint32_t channels = (format == ResourceFormat::RGB32Float) ? 3 : 4;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    float v;
+                    if (format == ResourceFormat::RGBA16Float)
+                    {
+                        v = glm::unpackHalf1x16(((const uint16_t*)pRow)[x * channels + c]);
+                    }
+                    else
+                    {
+                        v = ((const float*)pRow)[x * channels + c];
+                    }
+                    v = (v == v) ? std::min(std::max(v, 0.0f), 1.0f) : 0.0f;
+                    row.linear[c][x] = v;
+                    row.encoded[c][x] = linearToSrgb(v);
+                }
+            }
+            break;
+        }
+        default:
+            should_not_get_here();
+        }
+    }
+
+    // Cube root for x in [0, 2], refined from x^(1/4) with Newton iterations
+    static __m128 cbrt_ps(__m128 x)
+    {
+        const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 tiny = _mm_set1_ps(1e-6f);
+        __m128 y = _mm_max_ps(_mm_sqrt_ps(_mm_sqrt_ps(x)), tiny);
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            y = _mm_mul_ps(third, _mm_add_ps(_mm_mul_ps(two, y), _mm_div_ps(x, _mm_mul_ps(y, y))));
+        }
+        return y;
+    }
+
+    // CIELAB companding function
+    static __m128 labF_ps(__m128 t)
+    {
+        const __m128 epsilon = _mm_set1_ps(216.0f / 24389.0f);
+        __m128 cubic = cbrt_ps(t);
+        __m128 linear = _mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(24389.0f / 27.0f / 116.0f)), _mm_set1_ps(16.0f / 116.0f));
+        __m128 mask = _mm_cmpgt_ps(t, epsilon);
+        return _mm_or_ps(_mm_and_ps(mask, cubic), _mm_andnot_ps(mask, linear));
+    }
+
+    // Convert 4 linear sRGB pixels to CIELAB (D65 white)
+    static void linearToLab_ps(__m128 r, __m128 g, __m128 b, __m128& L, __m128& A, __m128& B)
+    {
+        auto dot = [&](float x, float y, float z)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(x)), _mm_mul_ps(g, _mm_set1_ps(y))), _mm_mul_ps(b, _mm_set1_ps(z)));
+        };
+        // The rows of the sRGB-to-XYZ matrix are divided by the white point
+        __m128 fx = labF_ps(dot(0.4124f / 0.95047f, 0.3576f / 0.95047f, 0.1805f / 0.95047f));
+        __m128 fy = labF_ps(dot(0.2126f, 0.7152f, 0.0722f));
+        __m128 fz = labF_ps(dot(0.0193f / 1.08883f, 0.1192f / 1.08883f, 0.9505f / 1.08883f));
+        L = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(116.0f), fy), _mm_set1_ps(16.0f));
+        A = _mm_mul_ps(_mm_set1_ps(500.0f), _mm_sub_ps(fx, fy));
+        B = _mm_mul_ps(_mm_set1_ps(200.0f), _mm_sub_ps(fy, fz));
+    }
+
+    static float horizontalSum(__m128 v)
+    {
+        float f[4];
+        _mm_storeu_ps(f, v);
+        return (f[0] + f[1]) + (f[2] + f[3]);
+    }
+
+    // Heat-map color of a pixel. Differences below the JND show the dimmed reference so that the image stays readable
+    static void heatMapColor(float deltaE, float refLuma, const ImageDiff::Desc& desc, uint8_t* pBgra)
+    {
+        static const float kRamp[][3] = { { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } };
+        static const uint32_t kRampSize = arraysize(kRamp);
+
+        float rgb[3];
+        if (deltaE <= desc.jnd)
+        {
+            rgb[0] = rgb[1] = rgb[2] = refLuma * 0.25f;
+        }
+        else
+        {
+            float range = std::max(desc.heatMapScale - desc.jnd, 1e-3f);
+            float t = std::min((deltaE - desc.jnd) / range, 1.0f) * (kRampSize - 1);
+            uint32_t i = std::min((uint32_t)t, kRampSize - 2);
+            float f = t - i;
+            for (uint32_t c = 0; c < 3; c++) rgb[c] = kRamp[i][c] * (1 - f) + kRamp[i + 1][c] * f;
+        }
+        pBgra[0] = (uint8_t)(rgb[2] * 255.0f + 0.5f);
+        pBgra[1] = (uint8_t)(rgb[1] * 255.0f + 0.5f);
+        pBgra[2] = (uint8_t)(rgb[0] * 255.0f + 0.5f);
+        pBgra[3] = 0xff;
+    }
+
+    bool ImageDiff::isFormatSupported(ResourceFormat format)
+    {
+        switch (format)
+        {
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+        case ResourceFormat::RGBA32Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA16Float:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    ImageDiff::Result ImageDiff::compare(const void* pImage, ResourceFormat imageFormat, const void* pReference, ResourceFormat referenceFormat, uint32_t width, uint32_t height, const Desc& desc)
+    {
+        Result result;
+        result.width = width;
+        result.height = height;
+        if (pImage == nullptr || pReference == nullptr || width == 0 || height == 0)
+        {
+            logWarning("ImageDiff::compare() - empty image");
+            return result;
+        }
+        if (isFormatSupported(imageFormat) == false || isFormatSupported(referenceFormat) == false)
+        {
+            logWarning("ImageDiff::compare() - unsupported format " + to_string(imageFormat) + " or " + to_string(referenceFormat));
+            return result;
+        }
+
+        uint32_t threadCount = desc.threadCount ? desc.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+        threadCount = std::min(threadCount, (height + kRowsPerJob - 1) / kRowsPerJob);
+
+        // Planes are stored with a stride padded to 4 pixels so that the SSE loops don't need a scalar tail
+        const uint32_t stride = (width + 3) & ~3u;
+        const size_t planeSize = (size_t)stride * height;
+        std::vector<float> lumaImage(planeSize), lumaRef(planeSize), sqError(planeSize), deltaE(planeSize), ssim(planeSize);
+        if (desc.generateHeatMap) result.heatMap.resize((size_t)width * height * 4);
+
+        const uint32_t imagePitch = width * getFormatBytesPerBlock(imageFormat);
+        const uint32_t refPitch = width * getFormatBytesPerBlock(referenceFormat);
+
+        // Decode both images, and compute the luma, the squared error and the Delta E of every pixel
+        parallelRows(threadCount, height, [&](uint32_t firstRow, uint32_t lastRow)
+        {
+            DecodedRow a, b;
+            a.resize(stride);
+            b.resize(stride);
+            const __m128 third = _mm_set1_ps(1.0f / 3.0f);
+            const __m128 lumaR = _mm_set1_ps(0.2126f), lumaG = _mm_set1_ps(0.7152f), lumaB = _mm_set1_ps(0.0722f);
+            for (uint32_t y = firstRow; y < lastRow; y++)
+            {
+                decodeRow((const uint8_t*)pImage + (size_t)y * imagePitch, imageFormat, width, a);
+                decodeRow((const uint8_t*)pReference + (size_t)y * refPitch, referenceFormat, width, b);
+                float* pLumaA = lumaImage.data() + (size_t)y * stride;
+                float* pLumaB = lumaRef.data() + (size_t)y * stride;
+                float* pSqError = sqError.data() + (size_t)y * stride;
+                float* pDeltaE = deltaE.data() + (size_t)y * stride;
+                for (uint32_t x = 0; x < stride; x += 4)
+                {
+                    __m128 ea[3], eb[3], la[3], lb[3];
+                    __m128 sq = _mm_setzero_ps();
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        ea[c] = _mm_loadu_ps(&a.encoded[c][x]);
+                        eb[c] = _mm_loadu_ps(&b.encoded[c][x]);
+                        la[c] = _mm_loadu_ps(&a.linear[c][x]);
+                        lb[c] = _mm_loadu_ps(&b.linear[c][x]);
+                        __m128 d = _mm_sub_ps(ea[c], eb[c]);
+                        sq = _mm_add_ps(sq, _mm_mul_ps(d, d));
+                    }
+                    _mm_storeu_ps(pSqError + x, _mm_mul_ps(sq, third));
+                    _mm_storeu_ps(pLumaA + x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ea[0], lumaR), _mm_mul_ps(ea[1], lumaG)), _mm_mul_ps(ea[2], lumaB)));
+                    _mm_storeu_ps(pLumaB + x, _mm_add_ps(_mm_add_ps(_mm_mul_ps(eb[0], lumaR), _mm_mul_ps(eb[1], lumaG)), _mm_mul_ps(eb[2], lumaB)));
+
+                    __m128 labA[3], labB[3];
+                    linearToLab_ps(la[0], la[1], la[2], labA[0], labA[1], labA[2]);
+                    linearToLab_ps(lb[0], lb[1], lb[2], labB[0], labB[1], labB[2]);
+                    __m128 dist = _mm_setzero_ps();
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        __m128 d = _mm_sub_ps(labA[c], labB[c]);
+                        dist = _mm_add_ps(dist, _mm_mul_ps(d, d));
+                    }
+                    _mm_storeu_ps(pDeltaE + x, _mm_sqrt_ps(dist));
+                }
+
+                if (desc.generateHeatMap)
+                {
+                    uint8_t* pHeat = result.heatMap.data() + (size_t)y * width * 4;
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        heatMapColor(pDeltaE[x], pLumaB[x], desc, pHeat + x * 4);
+                    }
+                }
+            }
+        });
+
+        // Box-filtered moments of the luma. The horizontal pass sums each row into 5 planes, zero-padded so that the border windows simply have fewer pixels
+        std::vector<float> sums[5];
+        for (auto& s : sums) s.resize(planeSize);
+        parallelRows(threadCount, height, [&](uint32_t firstRow, uint32_t lastRow)
+        {
+            const uint32_t paddedSize = stride + 2 * kSsimRadius + 4;
+            std::vector<float> moments[5];
+            for (auto& m : moments) m.assign(paddedSize, 0.0f);
+            for (uint32_t y = firstRow; y < lastRow; y++)
+            {
+                const float* pA = lumaImage.data() + (size_t)y * stride;
+                const float* pB = lumaRef.data() + (size_t)y * stride;
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    float a = pA[x], b = pB[x];
+                    moments[0][x + kSsimRadius] = a;
+                    moments[1][x + kSsimRadius] = b;
+                    moments[2][x + kSsimRadius] = a * a;
+                    moments[3][x + kSsimRadius] = b * b;
+                    moments[4][x + kSsimRadius] = a * b;
+                }
+                for (uint32_t m = 0; m < 5; m++)
+                {
+                    const float* pSrc = moments[m].data();
+                    float* pDst = sums[m].data() + (size_t)y * stride;
+                    for (uint32_t x = 0; x < stride; x += 4)
+                    {
+                        __m128 s = _mm_loadu_ps(pSrc + x);
+                        for (uint32_t k = 1; k < kSsimWindow; k++) s = _mm_add_ps(s, _mm_loadu_ps(pSrc + x + k));
+                        _mm_storeu_ps(pDst + x, s);
+                    }
+                }
+            }
+        });
+
+        // Number of pixels of the horizontal window of each column
+        std::vector<float> columnCount(stride);
+        for (uint32_t x = 0; x < stride; x++)
+        {
+            uint32_t first = (x >= kSsimRadius) ? x - kSsimRadius : 0;
+            uint32_t last = std::min(x + kSsimRadius, width - 1);
+            columnCount[x] = (x < width) ? (float)(last - first + 1) : 1.0f;
+        }
+
+        // Vertical pass and SSIM map
+        parallelRows(threadCount, height, [&](uint32_t firstRow, uint32_t lastRow)
+        {
+            const __m128 c1 = _mm_set1_ps(kSsimC1), c2 = _mm_set1_ps(kSsimC2), two = _mm_set1_ps(2.0f), one = _mm_set1_ps(1.0f);
+            for (uint32_t y = firstRow; y < lastRow; y++)
+            {
+                uint32_t y0 = (y >= kSsimRadius) ? y - kSsimRadius : 0;
+                uint32_t y1 = std::min(y + kSsimRadius, height - 1);
+                const __m128 rowCount = _mm_set1_ps((float)(y1 - y0 + 1));
+                float* pSsim = ssim.data() + (size_t)y * stride;
+                for (uint32_t x = 0; x < stride; x += 4)
+                {
+                    __m128 s[5];
+                    for (uint32_t m = 0; m < 5; m++)
+                    {
+                        s[m] = _mm_setzero_ps();
+                        for (uint32_t r = y0; r <= y1; r++) s[m] = _mm_add_ps(s[m], _mm_loadu_ps(sums[m].data() + (size_t)r * stride + x));
+                    }
+                    __m128 invCount = _mm_div_ps(one, _mm_mul_ps(rowCount, _mm_loadu_ps(&columnCount[x])));
+                    __m128 muA = _mm_mul_ps(s[0], invCount);
+                    __m128 muB = _mm_mul_ps(s[1], invCount);
+                    __m128 muAB = _mm_mul_ps(muA, muB);
+                    __m128 muA2 = _mm_mul_ps(muA, muA);
+                    __m128 muB2 = _mm_mul_ps(muB, muB);
+                    __m128 varA = _mm_sub_ps(_mm_mul_ps(s[2], invCount), muA2);
+                    __m128 varB = _mm_sub_ps(_mm_mul_ps(s[3], invCount), muB2);
+                    __m128 covar = _mm_sub_ps(_mm_mul_ps(s[4], invCount), muAB);
+                    __m128 num = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(two, muAB), c1), _mm_add_ps(_mm_mul_ps(two, covar), c2));
+                    __m128 den = _mm_mul_ps(_mm_add_ps(_mm_add_ps(muA2, muB2), c1), _mm_add_ps(_mm_add_ps(varA, varB), c2));
+                    _mm_storeu_ps(pSsim + x, _mm_div_ps(num, den));
+                }
+            }
+        });
+
+        // Per-tile statistics. Each job reduces one row of tiles. The tiles start on a multiple of 4 so the 4-wide loads stay inside the padded rows
+        const uint32_t tileSize = (std::max(desc.tileSize, 4u) + 3) & ~3u;
+        result.tileCountX = (width + tileSize - 1) / tileSize;
+        result.tileCountY = (height + tileSize - 1) / tileSize;
+        result.tiles.resize(result.tileCountX * result.tileCountY);
+        std::atomic<uint32_t> nextTileRow(0);
+        runWorkers(std::min(threadCount, result.tileCountY), [&]
+        {
+            const __m128 jnd = _mm_set1_ps(desc.jnd);
+            const __m128 one = _mm_set1_ps(1.0f);
+            while (true)
+            {
+                uint32_t tileY = nextTileRow.fetch_add(1);
+                if (tileY >= result.tileCountY) break;
+                for (uint32_t tileX = 0; tileX < result.tileCountX; tileX++)
+                {
+                    TileStats& tile = result.tiles[tileY * result.tileCountX + tileX];
+                    tile.x = tileX * tileSize;
+                    tile.y = tileY * tileSize;
+                    tile.width = std::min(tileSize, width - tile.x);
+                    tile.height = std::min(tileSize, height - tile.y);
+
+                    // The tile size is a multiple of 4 except for the last column of tiles, which masks the padding
+                    double sumSq = 0, sumSsim = 0, sumDeltaE = 0, failing = 0;
+                    float maxDeltaE = 0;
+                    for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+                    {
+                        __m128 rowSq = _mm_setzero_ps(), rowSsim = _mm_setzero_ps(), rowDeltaE = _mm_setzero_ps(), rowFailing = _mm_setzero_ps(), rowMax = _mm_setzero_ps();
+                        const size_t rowOffset = (size_t)y * stride;
+                        for (uint32_t x = tile.x; x < tile.x + tile.width; x += 4)
+                        {
+                            uint32_t valid = std::min(tile.x + tile.width - x, 4u);
+                            static const uint32_t kMasks[5][4] = { { 0, 0, 0, 0 }, { ~0u, 0, 0, 0 }, { ~0u, ~0u, 0, 0 }, { ~0u, ~0u, ~0u, 0 }, { ~0u, ~0u, ~0u, ~0u } };
+                            __m128 mask = _mm_loadu_ps((const float*)kMasks[valid]);
+                            __m128 e = _mm_and_ps(mask, _mm_loadu_ps(deltaE.data() + rowOffset + x));
+                            rowSq = _mm_add_ps(rowSq, _mm_and_ps(mask, _mm_loadu_ps(sqError.data() + rowOffset + x)));
+                            rowSsim = _mm_add_ps(rowSsim, _mm_and_ps(mask, _mm_loadu_ps(ssim.data() + rowOffset + x)));
+                            rowDeltaE = _mm_add_ps(rowDeltaE, e);
+                            rowFailing = _mm_add_ps(rowFailing, _mm_and_ps(_mm_cmpgt_ps(e, jnd), one));
+                            rowMax = _mm_max_ps(rowMax, e);
+                        }
+                        sumSq += horizontalSum(rowSq);
+                        sumSsim += horizontalSum(rowSsim);
+                        sumDeltaE += horizontalSum(rowDeltaE);
+                        failing += horizontalSum(rowFailing);
+                        float m[4];
+                        _mm_storeu_ps(m, rowMax);
+                        maxDeltaE = std::max(maxDeltaE, std::max(std::max(m[0], m[1]), std::max(m[2], m[3])));
+                    }
+                    double pixelCount = (double)tile.width * tile.height;
+                    tile.mse = (float)(sumSq / pixelCount);
+                    tile.ssim = (float)(sumSsim / pixelCount);
+                    tile.meanDeltaE = (float)(sumDeltaE / pixelCount);
+                    tile.maxDeltaE = maxDeltaE;
+                    tile.failingPixelRatio = (float)(failing / pixelCount);
+                }
+            }
+        });
+
+        // Global statistics, weighted by the tile sizes
+        double pixelCount = (double)width * height;
+        double sumSq = 0, sumSsim = 0, sumDeltaE = 0, failing = 0;
+        for (const TileStats& tile : result.tiles)
+        {
+            double tilePixels = (double)tile.width * tile.height;
+            sumSq += tile.mse * tilePixels;
+            sumSsim += tile.ssim * tilePixels;
+            sumDeltaE += tile.meanDeltaE * tilePixels;
+            failing += tile.failingPixelRatio * tilePixels;
+            result.maxDeltaE = std::max(result.maxDeltaE, (double)tile.maxDeltaE);
+        }
+        result.mse = sumSq / pixelCount;
+        result.psnr = (result.mse > 0) ? 10.0 * log10(1.0 / result.mse) : std::numeric_limits<double>::infinity();
+        result.ssim = sumSsim / pixelCount;
+        result.meanDeltaE = sumDeltaE / pixelCount;
+        result.failingPixelRatio = failing / pixelCount;
+        result.valid = true;
+        result.passed = (result.failingPixelRatio <= desc.maxFailingPixelRatio) && (result.ssim >= desc.minSsim);
+        return result;
+    }
+
+    ImageDiff::Result ImageDiff::compare(const std::string& imageFile, const std::string& referenceFile, const Desc& desc)
+    {
+        Bitmap::UniqueConstPtr pImage = Bitmap::createFromFile(imageFile, true);
+        Bitmap::UniqueConstPtr pReference = Bitmap::createFromFile(referenceFile, true);
+        if (pImage == nullptr || pReference == nullptr)
+        {
+            return Result();
+        }
+        if (pImage->getWidth() != pReference->getWidth() || pImage->getHeight() != pReference->getHeight())
+        {
+            logWarning("ImageDiff::compare() - " + imageFile + " and " + referenceFile + " have different sizes");
+            Result result;
+            result.width = pImage->getWidth();
+            result.height = pImage->getHeight();
+            return result;
+        }
+        return compare(pImage->getData(), pImage->getFormat(), pReference->getData(), pReference->getFormat(), pImage->getWidth(), pImage->getHeight(), desc);
+    }
+
+    void ImageDiff::saveHeatMap(const Result& result, const std::string& filename)
+    {
+        if (result.heatMap.empty())
+        {
+            logWarning("ImageDiff::saveHeatMap() - the result has no heat map");
+            return;
+        }
+        Bitmap::saveImage(filename, result.width, result.height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::BGRA8Unorm, true, result.heatMap.data());
+    }
+
+    void ImageDiff::saveTileStats(const Result& result, const std::string& filename)
+    {
+        std::ofstream of(filename);
+        if (of.fail())
+        {
+            logWarning("ImageDiff::saveTileStats() - can't open " + filename);
+            return;
+        }
+        of << "<?xml version = \"1.0\" encoding = \"UTF-8\"?>\n";
+        of << "<ImageDiff Width=\"" << result.width << "\" Height=\"" << result.height << "\" Valid=\"" << result.valid << "\" Passed=\"" << result.passed
+            << "\" MSE=\"" << result.mse << "\" PSNR=\"" << result.psnr << "\" SSIM=\"" << result.ssim << "\" MeanDeltaE=\"" << result.meanDeltaE
+            << "\" MaxDeltaE=\"" << result.maxDeltaE << "\" FailingPixelRatio=\"" << result.failingPixelRatio << "\">\n";
+        for (const TileStats& tile : result.tiles)
+        {
+            of << "\t<Tile X=\"" << tile.x << "\" Y=\"" << tile.y << "\" Width=\"" << tile.width << "\" Height=\"" << tile.height
+                << "\" MSE=\"" << tile.mse << "\" SSIM=\"" << tile.ssim << "\" MeanDeltaE=\"" << tile.meanDeltaE << "\" MaxDeltaE=\"" << tile.maxDeltaE
+                << "\" FailingPixelRatio=\"" << tile.failingPixelRatio << "\"/>\n";
+        }
+        of << "</ImageDiff>\n";
+    }
+}
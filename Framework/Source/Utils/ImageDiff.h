@@ -0,0 +1,119 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Formats.h"
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU image comparator for regression screenshots.
+        Compares an image against a reference and reports the MSE, PSNR, SSIM and a perceptual metric, globally and per screen tile, along with a heat map of the differences.
+        The perceptual metric is the CIELAB color difference (Delta E*ab) of each pixel. A pixel is counted as visibly different when its Delta E is above the just-noticeable difference, and an image passes when few enough pixels are visibly different and its SSIM is high enough. This tolerates the small, sparse differences driver updates and floating-point ordering cause, while still catching missing objects or shifted shading.
+        SSIM is computed on the luma with a 7x7 box window. All the passes are vectorized with SSE and split across threads by rows.
+    */
+    class ImageDiff
+    {
+    public:
+        /** Comparison settings
+        */
+        struct Desc
+        {
+            uint32_t tileSize = 64;                 ///< Size in pixels of the tiles the statistics are reported for. Rounded up to a multiple of 4
+            float jnd = 2.3f;                       ///< Delta E*ab above which a pixel is visibly different
+            float maxFailingPixelRatio = 0.001f;    ///< Maximum fraction of visibly different pixels for the image to pass
+            float minSsim = 0.98f;                  ///< Minimum mean SSIM for the image to pass
+            float heatMapScale = 10.0f;             ///< Delta E*ab shown with the hottest heat-map color
+            bool generateHeatMap = true;            ///< Fill Result::heatMap
+            uint32_t threadCount = 0;               ///< Number of threads. 0 uses all the hardware threads
+        };
+
+        /** Statistics of one tile
+        */
+        struct TileStats
+        {
+            uint32_t x = 0;                 ///< Left pixel of the tile
+            uint32_t y = 0;                 ///< Top pixel of the tile
+            uint32_t width = 0;
+            uint32_t height = 0;
+            float mse = 0;
+            float ssim = 1;
+            float meanDeltaE = 0;
+            float maxDeltaE = 0;
+            float failingPixelRatio = 0;    ///< Fraction of the tile's pixels above the just-noticeable difference
+        };
+
+        /** Comparison result
+        */
+        struct Result
+        {
+            bool valid = false;             ///< False if the images couldn't be compared, for example because their sizes differ
+            bool passed = false;            ///< Whether the image passed the Desc thresholds
+            uint32_t width = 0;
+            uint32_t height = 0;
+            double mse = 0;                 ///< Mean squared error over the RGB channels, with channels in [0, 1]
+            double psnr = 0;                ///< Peak signal-to-noise ratio in dB. Infinite for identical images
+            double ssim = 1;                ///< Mean structural similarity of the luma
+            double meanDeltaE = 0;          ///< Mean Delta E*ab
+            double maxDeltaE = 0;           ///< Largest Delta E*ab
+            double failingPixelRatio = 0;   ///< Fraction of the pixels above the just-noticeable difference
+            uint32_t tileCountX = 0;
+            uint32_t tileCountY = 0;
+            std::vector<TileStats> tiles;   ///< Row-major tile statistics
+            std::vector<uint8_t> heatMap;   ///< BGRA8 top-down heat map of the Delta E, if Desc::generateHeatMap is set
+        };
+
+        /** Check whether an image format can be compared
+        */
+        static bool isFormatSupported(ResourceFormat format);
+
+        /** Compare two images of the same size.
+            8-bit formats are treated as sRGB-encoded whether or not the format has the Srgb suffix, since that's how screenshots and PNG files store them. Float formats are treated as linear and clamped to [0, 1].
+            \param[in] pImage Image pixels, tightly packed top-down rows
+            \param[in] imageFormat Image format
+            \param[in] pReference Reference pixels, tightly packed top-down rows
+            \param[in] referenceFormat Reference format. Can differ from imageFormat, for example a BGRA swap-chain image against an RGBA file
+            \param[in] width Width of both images
+            \param[in] height Height of both images
+            \param[in] desc Comparison settings
+        */
+        static Result compare(const void* pImage, ResourceFormat imageFormat, const void* pReference, ResourceFormat referenceFormat, uint32_t width, uint32_t height, const Desc& desc = Desc());
+
+        /** Compare two image files. The result is invalid if a file can't be loaded or the sizes differ
+        */
+        static Result compare(const std::string& imageFile, const std::string& referenceFile, const Desc& desc = Desc());
+
+        /** Save the heat map of a result to a PNG file
+        */
+        static void saveHeatMap(const Result& result, const std::string& filename);
+
+        /** Save the global and per-tile statistics of a result to an xml file
+        */
+        static void saveTileStats(const Result& result, const std::string& filename);
+    };
+}
@@ -55,7 +55,10 @@ namespace Falcor
         samplerDesc.setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp).setFilterMode(Sampler::Filter::Point, Sampler::Filter::Point, Sampler::Filter::Point).setLodParams(0, 0, 0);
         mpPointSampler = Sampler::create(samplerDesc);
 
+        // The last pass writes the result into a single texel, so reading back its subresource transfers exactly the reduction result
+        mResultSize = getFormatBytesPerBlock(texFormat);
         mpResultFbo.resize(readbackLatency + 1);
+        mpResultReadbacks.resize(readbackLatency + 1);
         for(auto& pFbo : mpResultFbo)
         {
             Fbo::Desc fboDesc;
@@ -121,22 +124,21 @@ namespace Falcor
 
         runProgram(pRenderCtx, pInput, pProgram, mpResultFbo[mCurFbo], pVars, mpPointSampler);
 
+        // Request the result. It will be consumed after readbackLatency calls
+        mpResultReadbacks[mCurFbo] = pRenderCtx->asyncReadTextureSubresource(mpResultFbo[mCurFbo]->getColorTexture(0).get(), 0);
+
         // Read back the results
         mCurFbo = (mCurFbo + 1) % mpResultFbo.size();
 
-        uint32_t bytesToRead = 0;
+        // The request was issued readbackLatency calls ago, so usually the GPU is already done with it and this doesn't stall
         glm::vec4 result(0);
-        switch(mReductionType)
+        ReadbackRequest* pReadback = mpResultReadbacks[mCurFbo].get();
+        if(pReadback)
         {
-        case Type::MinMax:
-            bytesToRead = sizeof(glm::vec2);
-            break;
-        default:
-            should_not_get_here();
+            const std::vector<uint8>& texData = pReadback->getData();
+            assert(texData.size() == mResultSize && mResultSize <= sizeof(result));
+            memcpy(&result, texData.data(), mResultSize);
         }
-
-        auto texData = pRenderCtx->readTextureSubresource(mpResultFbo[mCurFbo]->getColorTexture(0).get(), 0);
-        result = *(vec4*)texData.data();
         return result;
     }
 }
\ No newline at end of file
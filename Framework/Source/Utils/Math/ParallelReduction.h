@@ -31,6 +31,7 @@
 #include "API/ProgramVars.h"
 #include "API/FBO.h"
 #include "API/Sampler.h"
+#include "API/AsyncReadback.h"
 
 namespace Falcor
 {
@@ -54,7 +55,9 @@ namespace Falcor
         FullScreenPass::UniquePtr mpRestIterProg;
         GraphicsVars::SharedPtr pVars;
         std::vector<Fbo::SharedPtr> mpResultFbo;
+        std::vector<ReadbackRequest::SharedPtr> mpResultReadbacks;
         uint32_t mCurFbo = 0;
+        uint32_t mResultSize = 0;
         Type mReductionType;
         Sampler::SharedPtr mpPointSampler;
 
@@ -147,6 +147,17 @@ namespace Falcor
     */
     bool readFileToString(const std::string& fullpath, std::string& str);
 
+    /** Map a file into memory for reading. The function expects a full path to the file, and will not look in the common directories.
+        \param[in] fullpath The path to the requested file
+        \param[out] size On successful return, the size of the file in bytes
+        \return A pointer to the file content, or nullptr if the file can't be opened or is empty. Release it with unmapFile()
+    */
+    const void* mapFileForReading(const std::string& fullpath, size_t& size);
+
+    /** Release a file mapped with mapFileForReading()
+    */
+    void unmapFile(const void* pData);
+
     /** Adds a folder into the search directory. Once added, calls to FindFileInCommonDirs() will seach that directory as well
         \param[in] dir The new directory to add to the common directories.
     */
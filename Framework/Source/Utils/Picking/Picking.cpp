@@ -147,8 +147,9 @@ namespace Falcor
         if (currentData.pCamera)
         {
             // Set camera for regular shader
-            ConstantBuffer* pCB = mpProgramVars->getConstantBuffer(kPerFrameCbName).get();
-            currentData.pCamera->setIntoConstantBuffer(pCB, sCameraDataOffset);
+            const ProgramBindings& bindings = getProgramBindings(mpProgramVars.get());
+            ConstantBuffer* pCB = mpProgramVars->getConstantBuffer(bindings.perFrameCb).get();
+            currentData.pCamera->setIntoConstantBuffer(pCB, bindings.cameraDataOffset);
         }
     }
 
@@ -181,8 +182,10 @@ namespace Falcor
 
     bool Picking::setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID)
     {
-        ConstantBuffer* pCB = currentData.pContext->getGraphicsVars()->getConstantBuffer(kPerMeshCbName).get();
-        pCB->setBlob(&currentData.drawID, sDrawIDOffset + drawInstanceID * sizeof(uint32_t), sizeof(uint32_t));
+        const ProgramVars* pVars = currentData.pContext->getGraphicsVars().get();
+        const ProgramBindings& bindings = getProgramBindings(pVars);
+        ConstantBuffer* pCB = pVars->getConstantBuffer(bindings.perMeshCb).get();
+        pCB->setBlob(&currentData.drawID, bindings.drawIdOffset + drawInstanceID * sizeof(uint32_t), sizeof(uint32_t));
 
         mDrawIDToInstance[currentData.drawID] = Instance(const_cast<Scene::ModelInstance*>(pModelInstance)->shared_from_this(), const_cast<Model::MeshInstance*>(pMeshInstance)->shared_from_this());
 
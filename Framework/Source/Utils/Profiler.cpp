@@ -39,6 +39,7 @@ namespace Falcor
     bool gProfileEnabled = false;
 
     std::map<size_t, Profiler::EventData*> Profiler::sProfilerEvents;
+    std::map<std::string, double> Profiler::sReportedValues;
     uint32_t Profiler::sCurrentLevel = 0;
     uint32_t Profiler::sGpuTimerIndex = 0;
     std::vector<Profiler::EventData*> Profiler::sProfilerVector;
@@ -130,6 +131,8 @@ namespace Falcor
 			uint32_t nameIndent = pData->level * 2 + 1;
 			uint32_t cpuIndent = 32 - (nameIndent + (uint32_t)pData->name.size());
 			sprintf_s(event, "%#*s%s %*.3f %36.3f\n", nameIndent, " ", pData->name.c_str(), cpuIndent, pData->cpuTotal, gpuTime);
+            pData->lastCpuTime = pData->cpuTotal;
+            pData->lastGpuTime = (float)gpuTime;
 #if _PROFILING_LOG == 1
 			pData->cpuMs[pData->stepNr] = pData->cpuTotal;
 			pData->gpuMs[pData->stepNr] = gpuTime;
@@ -153,6 +156,15 @@ namespace Falcor
             profileResults += event;
         }
 
+        for (const auto& value : sReportedValues)
+        {
+            char line[1000];
+            int valueIndent = std::max(1, 31 - (int)value.first.size());
+            sprintf_s(line, " %s%*.3f\n", value.first.c_str(), valueIndent, value.second);
+            profileResults += line;
+        }
+        sReportedValues.clear();
+
         sGpuTimerIndex = 1 - sGpuTimerIndex;
     }
 
@@ -174,6 +186,11 @@ namespace Falcor
 	}
 #endif
 
+    void Profiler::reportValue(const std::string& name, double value)
+    {
+        sReportedValues[name] = value;
+    }
+
     void Profiler::clearEvents()
     {
         for (EventData* pData : sProfilerVector)
@@ -182,6 +199,7 @@ namespace Falcor
         }
         sProfilerEvents.clear();
         sProfilerVector.clear();
+        sReportedValues.clear();
         sCurrentLevel = 0;
         sGpuTimerIndex = 0;
     }
@@ -80,6 +80,8 @@ namespace Falcor
             CpuTimer::TimePoint cpuEnd;
             float cpuTotal = 0;
 			float gpuTotal = 0;
+            float lastCpuTime = 0;  ///< CPU time in ms resolved by the last endFrame() call
+            float lastGpuTime = 0;  ///< GPU time in ms resolved by the last endFrame() call
             uint32_t level;
 #if _PROFILING_LOG == 1
 			int stepNr = 0;
@@ -142,7 +144,19 @@ namespace Falcor
         */
         static void clearEvents();
 
+        /** Report a value which is not a time measurement, like a counter or a cache hit-rate. The value will be appended to the results of the next call to endFrame().
+            \param[in] name The name of the value. Reporting the same name again overwrites the previous value.
+            \param[in] value The value.
+        */
+        static void reportValue(const std::string& name, double value);
+
+        /** Get all the registered events, in registration order.
+            The lastCpuTime and lastGpuTime fields of each event hold the times resolved by the last call to endFrame(). Due to the double-buffering, the GPU time lags one frame behind.
+        */
+        static const std::vector<EventData*>& getEvents() { return sProfilerVector; }
+
     private:
+        static std::map<std::string, double> sReportedValues;
         static std::map<size_t, EventData*> sProfilerEvents;
         static std::vector<EventData*> sProfilerVector;
         static uint32_t sCurrentLevel;
@@ -66,9 +66,9 @@ namespace Falcor
         static const std::string kVsFile("Framework/Shaders/TextRenderer.vs.slang");
         static const std::string kFsFile("Framework/Shaders/TextRenderer.ps.slang");
 
-        // Create a vertex buffer
+        // Create a vertex buffer. It's remapped every time we render text, so it can live in the upload ring
         const uint32_t vbSize = (uint32_t)(sizeof(Vertex)*kMaxBatchSize*arraysize(kVertexPos));
-        mpVertexBuffer = Buffer::create(vbSize, Buffer::BindFlags::Vertex, Buffer::CpuAccess::Write, nullptr);
+        mpVertexBuffer = Buffer::createTransient(vbSize, Buffer::BindFlags::Vertex);
 
         // Create the RenderState
         mpPipelineState = GraphicsState::create();
@@ -258,7 +258,8 @@ namespace Falcor
 
     bool readFileToString(const std::string& fullpath, std::string& str)
     {
-        std::ifstream t(fullpath.c_str());
+        // Binary mode, so that the content is the exact bytes of the file
+        std::ifstream t(fullpath.c_str(), std::ios::binary);
         if ((t.rdstate() & std::ifstream::failbit) == 0)
         {
             str = std::string((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
@@ -267,6 +268,46 @@ namespace Falcor
         return false;
     }
 
+    const void* mapFileForReading(const std::string& fullpath, size_t& size)
+    {
+        HANDLE hFile = CreateFileA(fullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(hFile, &fileSize) == FALSE || fileSize.QuadPart == 0)
+        {
+            CloseHandle(hFile);
+            return nullptr;
+        }
+
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (hMapping == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The view keeps the mapping alive
+        const void* pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(hMapping);
+        if (pData)
+        {
+            size = (size_t)fileSize.QuadPart;
+        }
+        return pData;
+    }
+
+    void unmapFile(const void* pData)
+    {
+        if (pData)
+        {
+            UnmapViewOfFile(pData);
+        }
+    }
+
     bool findAvailableFilename(const std::string& prefix, const std::string& directory, const std::string& extension, std::string& filename)
     {
         for (UINT32 i = 0; i < UINT32_MAX; i++)
@@ -74,6 +74,8 @@ namespace Falcor
     {
         return vr::TextureType_Vulkan;
     }
+#elif defined FALCOR_NULL
+    // The null backend has nothing to hand over to the compositor, VRSystem::submit() is a no-op
 #else
 #error VRSystem doesn't support the selected API backend
 #endif
@@ -408,6 +410,10 @@ namespace Falcor
     {
         if (!mpCompositor) return false;
 
+#ifdef FALCOR_NULL
+        UNSUPPORTED_IN_NULL("VRSystem::submit()");
+        return false;
+#else
         auto submitTex = prepareSubmitData(pDisplayTex, pRenderCtx);
         vr::Texture_t subTex;
         subTex.eType = getVrTextureType();
@@ -416,6 +422,7 @@ namespace Falcor
 
         mpCompositor->Submit((whichEye == VRDisplay::Eye::Right) ? vr::Eye_Right : vr::Eye_Left, &subTex, NULL);
         return true;
+#endif
     }
 
 
@@ -192,11 +192,13 @@ void FeatureDemo::initSkyBox(const std::string& name)
 
 void FeatureDemo::initEnvMap(const std::string& name)
 {
-    mpEnvMap = createTextureFromFile(name, false, isSrgbFormat(mpDefaultFBO->getColorTexture(0)->getFormat()));
-    if (mpEnvMap->getType() != Texture::Type::Texture2D)
+    // Prefilter the probe once instead of sampling the raw environment map per pixel
+    mpLightProbe = LightProbe::create(name);
+    if (mpLightProbe == nullptr)
     {
-        logError("Environment map must be a 2D texture");
-        mpEnvMap = nullptr;
+        // Without a probe the reflection path has nothing to sample, fall back to the constant ambient term
+        mControls[ControlID::EnableReflections].enabled = false;
+        if (mLightingPass.pProgram) applyLightingProgramControl(ControlID::EnableReflections);
     }
 }
 
@@ -295,7 +297,7 @@ void FeatureDemo::lightingPass()
 
     if (mControls[EnableReflections].enabled)
     {
-        mLightingPass.pVars->setTexture("gEnvMap", mpEnvMap);
+        if (mpLightProbe) mpLightProbe->setIntoProgramVars(mLightingPass.pVars.get(), pCB.get(), "gProbe");
         mLightingPass.pVars->setSampler("gSampler", mpSceneSampler);
     }
 
@@ -156,7 +156,7 @@ private:
     void setSceneSampler(uint32_t maxAniso);
 
 
-    Texture::SharedPtr mpEnvMap;
+    LightProbe::SharedPtr mpLightProbe;
     Sampler::SharedPtr mpSceneSampler;
 
     struct ProgramControl
@@ -48,7 +48,7 @@ void FeatureDemo::initControls()
     mControls[ControlID::SuperSampling] = { false, false, "INTERPOLATION_MODE", "sample" };
     mControls[ControlID::EnableSpecAA] = { true, true, "_MS_DISABLE_ROUGHNESS_FILTERING" };
     mControls[ControlID::EnableShadows] = { true, false, "_ENABLE_SHADOWS" };
-    mControls[ControlID::EnableReflections] = { true, false, "_ENABLE_REFLECTIONS" };
+    mControls[ControlID::EnableReflections] = { mpLightProbe != nullptr, false, "_ENABLE_REFLECTIONS" };
     mControls[ControlID::EnableHashedAlpha] = { true, true, "_DEFAULT_ALPHA_TEST" };
     mControls[ControlID::EnableTransparency] = { false, false, "_ENABLE_TRANSPARENCY" };
     mControls[ControlID::EnableSSAO] = { false, false, "" };
@@ -257,6 +257,7 @@ void FeatureDemo::onGuiRender()
         {
             if (mpGui->addCheckBox("Enable", mControls[ControlID::EnableReflections].enabled))
             {
+                mControls[ControlID::EnableReflections].enabled &= (mpLightProbe != nullptr);
                 applyLightingProgramControl(ControlID::EnableReflections);
             }
 
@@ -128,11 +128,19 @@ def getImageCompareResultsTable(slnInfo):
                 if len(result.CompareImageResults) > 0:
                     html += '<tr>\n'
                     html += '<td>' + result.Name + '</td>\n'
-                    for compare in result.CompareImageResults:
-                        if float(compare) > testingUtil.gDefaultImageCompareMargin or float(compare) < 0:
-                            html += '<td bgcolor="red"><font color="white">' + str(compare) + '</font></td>\n'
+                    #in-process compares carry their own pass/fail and SSIM, ImageMagick ones only the MSE
+                    inProcess = len(result.CompareImagePassed) == len(result.CompareImageResults)
+                    for i, compare in enumerate(result.CompareImageResults):
+                        if inProcess:
+                            failed = not result.CompareImagePassed[i]
+                            text = str(compare) + ' (SSIM ' + str(result.CompareImageSsim[i]) + ')'
                         else:
-                            html += '<td>' + str(compare) + '</td>\n'
+                            failed = float(compare) > testingUtil.gDefaultImageCompareMargin or float(compare) < 0
+                            text = str(compare)
+                        if failed:
+                            html += '<td bgcolor="red"><font color="white">' + text + '</font></td>\n'
+                        else:
+                            html += '<td>' + text + '</td>\n'
                     html += '</tr>\n'
             html += '</table>\n'
             return html
@@ -211,6 +219,35 @@ def getMemoryCompareResultsTable(slnInfo):
 
 
 
+def getPerfCompareResultsTable(slnInfo):
+    hasPerfResults = False
+    for result in slnInfo.systemResultList:
+        if len(result.ComparePerfResults) > 0:
+            hasPerfResults = True
+
+    if not hasPerfResults:
+        return ''
+
+    html = '<table style="width:100%" border="1">\n'
+    html += '<tr>\n'
+    html += '<th colspan=\'10\'>Frame Time Distribution Checks</th>\n'
+    html += '</tr>\n'
+    html += '<th>Test</th>\n<th>Event</th>\n<th>Timer</th>\n<th>p50</th>\n<th>Ref p50</th>\n'
+    html += '<th>p95</th>\n<th>Ref p95</th>\n<th>p99</th>\n<th>Ref p99</th>\n<th>p-value</th>\n'
+    for result in slnInfo.systemResultList:
+        for compare in result.ComparePerfResults:
+            values = [result.Name, compare.Name, compare.Timer, compare.P50, compare.RefP50,
+                compare.P95, compare.RefP95, compare.P99, compare.RefP99, compare.PValue]
+            html += '<tr>\n'
+            for value in values:
+                if compare.Regressed:
+                    html += '<td bgcolor="red"><font color="white">' + str(value) + '</font></td>\n'
+                else:
+                    html += '<td>' + str(value) + '</td>\n'
+            html += '</tr>\n'
+    html += '</table>\n'
+    return html
+
 def skipToHTML(name, reason):
     html = '<tr>\n'
     html += '<td bgcolor="red"><font color="white">' + name + '</font></td>\n'
@@ -242,6 +279,8 @@ def outputHTML(openSummary, slnInfo, pullBranch):
     html += '<br><br>'
     html += getMemoryCompareResultsTable(slnInfo)
     html += '<br><br>'
+    html += getPerfCompareResultsTable(slnInfo)
+    html += '<br><br>'
     html += getSkipsTable(slnInfo)
     if pullBranch:
         resultSummaryName = slnInfo.resultsDir + '\\' + slnInfo.name + '_' + pullBranch + '_TestSummary.html'
@@ -0,0 +1,103 @@
+import math
+from xml.dom import minidom
+from xml.parsers.expat import ExpatError
+
+#one-sided significance level of the rank test
+gPerfSignificance = 0.01
+#the median must also grow by this fraction of the reference median to count as a regression
+gPerfMedianMargin = 0.05
+#ms, ignore events too short for timer noise to be meaningful
+gPerfMinMedianDelta = 0.02
+#below this many samples on either side the normal approximation is not trusted
+gPerfMinSamples = 20
+
+class PerfCompareResult(object):
+    def __init__(self, name, timer):
+        self.Name = name
+        self.Timer = timer
+        self.P50 = 0
+        self.P95 = 0
+        self.P99 = 0
+        self.RefP50 = 0
+        self.RefP95 = 0
+        self.RefP99 = 0
+        self.PValue = 1.0
+        self.Regressed = False
+
+#returns {(name, timer) : (attributes dict, samples list)} from the PerfStats element of a testing log, empty if there is none
+def readPerfStats(xmlFilename):
+    try:
+        doc = minidom.parse(xmlFilename)
+    except (ExpatError, IOError):
+        return {}
+    stats = {}
+    for perfStats in doc.getElementsByTagName('PerfStats'):
+        for event in perfStats.getElementsByTagName('Event'):
+            attributes = dict((k, v) for k, v in event.attributes.items())
+            samples = [float(s) for s in attributes.get('Samples', '').split()]
+            stats[(attributes['Name'], attributes['Timer'])] = (attributes, samples)
+    return stats
+
+def normalSf(z):
+    return 0.5 * math.erfc(z / math.sqrt(2.0))
+
+#one-sided Mann-Whitney U test of 'result tends to be larger than reference'
+#frame times are skewed and heavy tailed, so a rank test is used instead of a t-test on the means
+#returns the p-value from the tie-corrected normal approximation
+def mannWhitneyGreater(result, reference):
+    n1 = len(result)
+    n2 = len(reference)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+
+    #rank the pooled samples, giving tied values their average rank
+    pooled = sorted([(v, 0) for v in result] + [(v, 1) for v in reference])
+    rankSumResult = 0.0
+    tieTerm = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        avgRank = (i + j) / 2.0 + 1.0
+        tieCount = j - i + 1
+        tieTerm += tieCount ** 3 - tieCount
+        for k in range(i, j + 1):
+            if pooled[k][1] == 0:
+                rankSumResult += avgRank
+        i = j + 1
+
+    u = rankSumResult - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    mean = n1 * n2 / 2.0
+    variance = n1 * n2 / 12.0 * ((n + 1) - tieTerm / (n * (n - 1.0)))
+    if variance <= 0:
+        return 1.0
+    #continuity correction
+    z = (u - mean - 0.5) / math.sqrt(variance)
+    return normalSf(z)
+
+#compares every event present in both logs, returns a list of PerfCompareResult
+def comparePerfStats(resultFile, referenceFile):
+    result = readPerfStats(resultFile)
+    reference = readPerfStats(referenceFile)
+    compareResults = []
+    for key in sorted(result.keys()):
+        if key not in reference:
+            continue
+        resAttr, resSamples = result[key]
+        refAttr, refSamples = reference[key]
+        compare = PerfCompareResult(key[0], key[1])
+        compare.P50 = float(resAttr['P50'])
+        compare.P95 = float(resAttr['P95'])
+        compare.P99 = float(resAttr['P99'])
+        compare.RefP50 = float(refAttr['P50'])
+        compare.RefP95 = float(refAttr['P95'])
+        compare.RefP99 = float(refAttr['P99'])
+        if len(resSamples) >= gPerfMinSamples and len(refSamples) >= gPerfMinSamples:
+            compare.PValue = mannWhitneyGreater(resSamples, refSamples)
+            medianDelta = compare.P50 - compare.RefP50
+            compare.Regressed = (compare.PValue < gPerfSignificance and
+                medianDelta > max(compare.RefP50 * gPerfMedianMargin, gPerfMinMedianDelta))
+        compareResults.append(compare)
+    return compareResults
@@ -11,6 +11,7 @@ from datetime import date
 #custom written modules
 import OutputTestingHtml as htmlWriter
 import TestingUtil as testingUtil
+import PerfCompare as perfCompare
 
 #relevant paths
 gBuildBatchFile = 'BuildFalcor.ps1 '
@@ -52,15 +53,21 @@ class TestInfo(object):
 
     def determineIndex(self, generateReference,):
         initialFilename = self.getResultsFile()
+        self.Index = self.findIndex(generateReference)
+        if self.Index != 0:
+            testingUtil.overwriteMove(initialFilename, self.getResultsFile())
+
+    #returns the index determineIndex will pick, without renaming anything
+    def findIndex(self, generateReference):
+        index = self.Index
         if generateReference:
-            while os.path.isfile(self.getReferenceFile()):
-                self.Index += 1
+            while os.path.isfile(self.getReferenceDir() + '\\' + self.Name + '_TestingLog_' + str(index) + '.xml'):
+                index += 1
         else:
             if os.path.isdir(self.getResultsDir()):
-                while os.path.isfile(self.getResultsDir() + '\\' + self.getResultsFile()):
-                    self.Index += 1
-        if self.Index != 0:
-            testingUtil.overwriteMove(initialFilename, self.getResultsFile())
+                while os.path.isfile(self.getResultsDir() + '\\' + self.Name + '_TestingLog_' + str(index) + '.xml'):
+                    index += 1
+        return index
 
     def getResultsFile(self):
         return self.Name + '_TestingLog_' + str(self.Index) + '.xml'
@@ -114,8 +121,12 @@ class SystemResult(object):
         self.LoadErrorMargin = gDefaultLoadTimeMargin
         self.FrameErrorMargin = gDefaultFrameTimeMargin
         self.CompareImageResults = []
+        #filled when SampleTest compared the screenshots in-process
+        self.CompareImagePassed = []
+        self.CompareImageSsim = []
         self.CompareMemoryFrameResults = []
         self.CompareMemoryTimeResults = []
+        self.ComparePerfResults = []
 
 class LowLevelResult(object):
     def __init__(self):
@@ -172,6 +183,46 @@ def compareImages(resultObj, testInfo, numScreenshots, slnInfo):
                 ' average difference per pixel. (Exceeds threshold .01)'))
 
 
+#uses the ImageCompare elements SampleTest writes when it ran with -imagediffref
+def useImageCompareResults(resultObj, imageCompares, testInfo, numScreenshots, slnInfo):
+    renameScreenshots(testInfo, numScreenshots)
+    imagesDir = testInfo.getResultsDir() + '\\Images'
+    testingUtil.makeDirIfDoesntExist(imagesDir)
+    for i in range(0, numScreenshots):
+        compare = imageCompares[i]
+        testScreenshot = testInfo.getRenamedFileForIndex(i) + '.png'
+        refScreenshot = testInfo.getReferenceFileForIndex(i) + '.png'
+        valid = int(compare.attributes['Valid'].value) != 0
+        passed = int(compare.attributes['Passed'].value) != 0
+        mse = float(compare.attributes['MSE'].value)
+        ssim = float(compare.attributes['SSIM'].value)
+        if not valid:
+            mse = -1
+            slnInfo.errorList.append(('For test ' + testInfo.getFullName() +
+                ' failed to compare screenshot ' + testScreenshot + ' with ref ' + refScreenshot))
+        elif not passed:
+            slnInfo.errorList.append(('For test ' + testInfo.getFullName() + ', screenshot ' +
+                testScreenshot + ' differs from ' + refScreenshot + ': MSE ' + str(mse) + ', PSNR ' +
+                compare.attributes['PSNR'].value + ' dB, SSIM ' + str(ssim) + ', ' +
+                str(float(compare.attributes['FailingPixelRatio'].value) * 100) + '% of the pixels above the JND, max Delta E ' +
+                compare.attributes['MaxDeltaE'].value))
+        resultObj.CompareImageResults.append(mse)
+        resultObj.CompareImagePassed.append(valid and passed)
+        resultObj.CompareImageSsim.append(ssim)
+
+        # Move the screenshot, the heat map and the tile statistics to the results folder
+        testingUtil.overwriteMove(testScreenshot, imagesDir)
+        heatMap = testInfo.getInitialFileForIndex(i) + '.diff.png'
+        if os.path.isfile(heatMap):
+            outFile = testInfo.Name + '_' + str(testInfo.Index) + '_' + str(i) + '_Compare.png'
+            os.rename(heatMap, outFile)
+            testingUtil.overwriteMove(outFile, imagesDir)
+        tileStats = testInfo.getInitialFileForIndex(i) + '.tiles.xml'
+        if os.path.isfile(tileStats):
+            outFile = testInfo.Name + '_' + str(testInfo.Index) + '_' + str(i) + '_Tiles.xml'
+            os.rename(tileStats, outFile)
+            testingUtil.overwriteMove(outFile, imagesDir)
+
 def renameMemoryChecks(testInfo, countMemoryChecks, typefix=""):
     print typefix
     for i in range (0, countMemoryChecks):
@@ -351,8 +402,20 @@ def processSystemTest(xmlElement, testInfo, slnInfo):
             str(newSysResult.LoadErrorMargin) + ' seconds'))
 
 
-    # Compare the images.
-    compareImages(newSysResult, testInfo, numScreenshots, slnInfo)
+    # Compare the per-event frame time distributions, if the test ran with -perfstats.
+    newSysResult.ComparePerfResults = perfCompare.comparePerfStats(resultFile, referenceFile)
+    for compare in newSysResult.ComparePerfResults:
+        if compare.Regressed:
+            slnInfo.errorList.append((testInfo.getFullName() + ': ' + compare.Timer + ' time of event ' + compare.Name +
+            ' regressed, p50 ' + str(compare.P50) + ' ms vs reference ' + str(compare.RefP50) + ' ms, p95 ' +
+            str(compare.P95) + ' ms vs reference ' + str(compare.RefP95) + ' ms (p-value ' + str(compare.PValue) + ')'))
+
+    # Compare the images. SampleTest already did it if the test ran with -imagediffref, otherwise use ImageMagick.
+    imageCompares = getXMLTag(resultFile, 'ImageCompare')
+    if imageCompares and len(imageCompares) == numScreenshots:
+        useImageCompareResults(newSysResult, imageCompares, testInfo, numScreenshots, slnInfo)
+    else:
+        compareImages(newSysResult, testInfo, numScreenshots, slnInfo)
 
     # Compare the Memory Checks.
     if(numMemoryFrameChecks != 0):
@@ -460,6 +523,10 @@ def runTest(testInfo, cmdLine, generateReference, slnInfo):
     if not os.path.exists(testPath):
         slnInfo.skippedList.append((testInfo.getFullName(), 'Unable to find ' + testPath))
         return
+    # Let SampleTest compare the screenshots against the reference images of the index the results will be given
+    if cmdLine and not generateReference:
+        refPrefix = os.path.abspath(testInfo.getReferenceDir()) + '\\' + testInfo.Name + '_' + str(testInfo.findIndex(False)) + '_'
+        cmdLine += ' -imagediffref ' + refPrefix
     try:
         p = subprocess.Popen(testPath + ' ' + cmdLine)
         # Run test until timeout or return.
@@ -0,0 +1,286 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BenchmarkBase.h"
+#include "Externals/RapidJson/include/rapidjson/document.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::atomic<uint64_t> gAllocCount(0);
+    std::atomic<uint64_t> gAllocBytes(0);
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+// Count every heap allocation made by the process. The array and nothrow versions forward to these by default.
+void* operator new(size_t size)
+{
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+BenchmarkBase::BenchmarkBase()
+{
+    mBenchmarkName = getExecutableName();
+    //slice off '.exe'
+    mBenchmarkName = mBenchmarkName.substr(0, mBenchmarkName.size() - 4);
+}
+
+BenchmarkBase::~BenchmarkBase()
+{
+    for (auto it = mpBenchmarkList.begin(); it != mpBenchmarkList.end(); ++it)
+        delete *it;
+}
+
+void BenchmarkBase::init(const std::string& commandLine)
+{
+    //Turns off error message boxes
+    SetErrorMode(GetErrorMode() | SEM_NOGPFAULTERRORBOX);
+    _CrtSetReportMode(_CRT_ASSERT, 0);
+    _set_error_mode(_OUT_TO_STDERR);
+
+    mArgList.parseCommandLine(commandLine);
+    if (mArgList.argExists("repetitions"))
+    {
+        mRepetitions = std::max(1u, mArgList["repetitions"].asUint());
+    }
+    if (mArgList.argExists("batchtime"))
+    {
+        mMinBatchTime = mArgList["batchtime"].asFloat() / 1000.0;
+    }
+    if (mArgList.argExists("threshold"))
+    {
+        mThreshold = mArgList["threshold"].asFloat();
+    }
+    if (mArgList.argExists("baseline"))
+    {
+        readBaseline(mArgList["baseline"].asString());
+    }
+
+    addBenchmarks();
+
+    // Resource creation and shader reflection need a device. With the null backend this doesn't touch a GPU or open a window.
+    Device::Desc desc;
+#ifdef FALCOR_NULL
+    Window::SharedPtr pWindow;
+    gpDevice = Device::create(pWindow, desc);
+#else
+    mpWindow = Window::create(Window::Desc(), &mDummyCallbacks);
+    gpDevice = Device::create(mpWindow, desc);
+#endif
+
+    onInit();
+}
+
+int BenchmarkBase::run()
+{
+    std::string filter = mArgList.argExists("filter") ? mArgList["filter"].asString() : "";
+    std::vector<Result> results;
+    int regressions = 0;
+
+    for (Benchmark* pBenchmark : mpBenchmarkList)
+    {
+        if (filter.size() && pBenchmark->mName.find(filter) == std::string::npos) continue;
+
+        Result r = runBenchmark(pBenchmark);
+        if (r.skipped)
+        {
+            std::cout << pBenchmark->mName << ": skipped\n";
+        }
+        else
+        {
+            char line[512];
+            sprintf_s(line, "%-32s %14.1f ns/op %14.1f items/s %10.2f allocs/op %12.1f bytes/op", r.name.c_str(), r.nsPerOp, r.itemsPerSecond, r.allocsPerOp, r.allocBytesPerOp);
+            std::cout << line;
+            if (r.baselineNsPerOp > 0)
+            {
+                double ratio = r.nsPerOp / r.baselineNsPerOp;
+                sprintf_s(line, "   %+6.1f%% vs baseline", (ratio - 1) * 100);
+                std::cout << line;
+                if (ratio > 1 + mThreshold)
+                {
+                    std::cout << " REGRESSION";
+                    ++regressions;
+                }
+            }
+            std::cout << "\n";
+        }
+        results.push_back(r);
+    }
+
+    std::string outFile = mArgList.argExists("out") ? mArgList["out"].asString() : mBenchmarkName + "_Benchmarks.json";
+    writeJson(outFile, results);
+    return regressions;
+}
+
+BenchmarkBase::Result BenchmarkBase::runBenchmark(Benchmark* pBenchmark)
+{
+    Result r;
+    r.name = pBenchmark->mName;
+
+    try
+    {
+        if (pBenchmark->setup() == false)
+        {
+            r.skipped = true;
+            return r;
+        }
+
+        // Warm up and find a batch size which takes at least mMinBatchTime
+        pBenchmark->run();
+        uint64_t batchSize = 1;
+        while (true)
+        {
+            Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < batchSize; i++) pBenchmark->run();
+            if (secondsSince(start) >= mMinBatchTime || batchSize >= (1ull << 40)) break;
+            batchSize *= 2;
+        }
+
+        std::vector<double> nsPerOp(mRepetitions);
+        uint64_t allocCount = gAllocCount.load();
+        uint64_t allocBytes = gAllocBytes.load();
+        for (uint32_t rep = 0; rep < mRepetitions; rep++)
+        {
+            Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < batchSize; i++) pBenchmark->run();
+            nsPerOp[rep] = secondsSince(start) * 1e9 / batchSize;
+        }
+        allocCount = gAllocCount.load() - allocCount;
+        allocBytes = gAllocBytes.load() - allocBytes;
+        pBenchmark->teardown();
+
+        r.iterations = batchSize * mRepetitions;
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        r.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+        r.nsPerOpMin = nsPerOp[0];
+        r.itemsPerSecond = pBenchmark->mItemsPerOp * 1e9 / r.nsPerOp;
+        r.bytesPerSecond = pBenchmark->mBytesPerOp * 1e9 / r.nsPerOp;
+        r.allocsPerOp = (double)allocCount / r.iterations;
+        r.allocBytesPerOp = (double)allocBytes / r.iterations;
+
+        auto baseline = mBaseline.find(r.name);
+        r.baselineNsPerOp = (baseline != mBaseline.end()) ? baseline->second : 0;
+    }
+    catch (...)
+    {
+        logError("Benchmark " + r.name + " threw an exception");
+        r.skipped = true;
+    }
+    return r;
+}
+
+void BenchmarkBase::readBaseline(const std::string& filename)
+{
+    std::string json;
+    if (readFileToString(filename, json) == false)
+    {
+        logError("Can't open benchmark baseline " + filename);
+        return;
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(json.c_str());
+    if (doc.HasParseError() || doc.IsObject() == false || doc.HasMember("benchmarks") == false || doc["benchmarks"].IsArray() == false)
+    {
+        logError("Benchmark baseline " + filename + " is not a valid results file");
+        return;
+    }
+
+    const rapidjson::Value& benchmarks = doc["benchmarks"];
+    for (rapidjson::SizeType i = 0; i < benchmarks.Size(); i++)
+    {
+        const rapidjson::Value& b = benchmarks[i];
+        if (b.HasMember("name") && b["name"].IsString() && b.HasMember("nsPerOp") && b["nsPerOp"].IsNumber())
+        {
+            mBaseline[b["name"].GetString()] = b["nsPerOp"].GetDouble();
+        }
+    }
+}
+
+void BenchmarkBase::writeJson(const std::string& filename, const std::vector<Result>& results)
+{
+    std::ofstream of(filename);
+    if (of.fail())
+    {
+        logError("Can't write benchmark results to " + filename);
+        return;
+    }
+
+    of.precision(17);
+    of << "{\n";
+    of << "    \"executable\": \"" << mBenchmarkName << "\",\n";
+#ifdef FALCOR_NULL
+    of << "    \"backend\": \"null\",\n";
+#else
+    of << "    \"backend\": \"d3d12\",\n";
+#endif
+    of << "    \"benchmarks\": [";
+    bool first = true;
+    for (const Result& r : results)
+    {
+        if (r.skipped) continue;
+        of << (first ? "\n" : ",\n");
+        first = false;
+        of << "        {\n";
+        of << "            \"name\": \"" << r.name << "\",\n";
+        of << "            \"iterations\": " << r.iterations << ",\n";
+        of << "            \"nsPerOp\": " << r.nsPerOp << ",\n";
+        of << "            \"nsPerOpMin\": " << r.nsPerOpMin << ",\n";
+        of << "            \"itemsPerSecond\": " << r.itemsPerSecond << ",\n";
+        of << "            \"bytesPerSecond\": " << r.bytesPerSecond << ",\n";
+        of << "            \"allocsPerOp\": " << r.allocsPerOp << ",\n";
+        of << "            \"allocBytesPerOp\": " << r.allocBytesPerOp;
+        if (r.baselineNsPerOp > 0)
+        {
+            of << ",\n            \"baselineNsPerOp\": " << r.baselineNsPerOp;
+        }
+        of << "\n        }";
+    }
+    of << "\n    ]\n}\n";
+}
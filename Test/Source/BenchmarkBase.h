@@ -0,0 +1,123 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+
+using namespace Falcor;
+
+/** Base class for CPU micro-benchmarks. Mirrors TestBase: the derived class adds benchmark functors in addBenchmarks(), run() times them and writes the results.
+    Every benchmark is timed in batches. The batch size is doubled until a batch takes at least the minimum batch time, then a fixed number of batches are timed and the median is reported.
+    Heap allocations are counted by replacing the global operator new/delete, so the numbers include everything the code under test allocates.
+    Command line:
+        -filter <substr>        Only run benchmarks whose name contains substr
+        -out <file>             JSON results file, defaults to <exe name>_Benchmarks.json
+        -baseline <file>        JSON results of a previous run. Benchmarks slower than the baseline by more than the threshold are reported as regressions
+        -threshold <fraction>   Regression threshold, defaults to 0.1
+        -repetitions <n>        Number of timed batches, defaults to 7
+        -batchtime <ms>         Minimum batch time, defaults to 20
+    run() returns the number of regressions, so it can be used as the process exit code.
+*/
+class BenchmarkBase
+{
+public:
+    struct Result
+    {
+        std::string name;
+        bool skipped = false;
+        uint64_t iterations = 0;        ///< Total number of timed ops
+        double nsPerOp = 0;             ///< Median over the batches
+        double nsPerOpMin = 0;          ///< Fastest batch
+        double itemsPerSecond = 0;
+        double bytesPerSecond = 0;
+        double allocsPerOp = 0;
+        double allocBytesPerOp = 0;
+        double baselineNsPerOp = 0;     ///< 0 if the benchmark isn't in the baseline
+    };
+
+    virtual ~BenchmarkBase();
+    void init(const std::string& commandLine);
+    int run();
+
+protected:
+    BenchmarkBase();
+    virtual void addBenchmarks() = 0;
+    virtual void onInit() {}
+
+    class Benchmark
+    {
+    public:
+        virtual ~Benchmark() {}
+        /** Untimed. Returning false skips the benchmark, e.g. when an input file is missing
+        */
+        virtual bool setup() { return true; }
+        /** A single op. Everything that's not the code under test should happen in setup()
+        */
+        virtual void run() = 0;
+        virtual void teardown() {}
+
+        std::string mName;
+        uint64_t mItemsPerOp = 1;   ///< Used for the items/s throughput
+        uint64_t mBytesPerOp = 0;   ///< Used for the bytes/s throughput, 0 if the benchmark doesn't have a meaningful byte count
+    };
+
+    //This is templatized but it expects a type that derives from Benchmark
+    template <typename T>
+    void addBenchmarkToList()
+    {
+        T* pBenchmark = new T();
+        std::string wholeName = std::string(typeid(*pBenchmark).name());
+        size_t colonIndex = wholeName.find(":");
+        pBenchmark->mName = wholeName.substr(colonIndex + 2, std::string::npos);
+
+        mpBenchmarkList.push_back(pBenchmark);
+    }
+
+    std::vector<Benchmark*> mpBenchmarkList;
+    ArgList mArgList;
+
+private:
+    Result runBenchmark(Benchmark* pBenchmark);
+    void readBaseline(const std::string& filename);
+    void writeJson(const std::string& filename, const std::vector<Result>& results);
+
+    std::string mBenchmarkName;
+    std::unordered_map<std::string, double> mBaseline;
+    uint32_t mRepetitions = 7;
+    double mMinBatchTime = 0.02;
+    float mThreshold = 0.1f;
+
+    class DummyWindowCallbacks : public Window::ICallbacks
+    {
+        void renderFrame() override {}
+        void handleWindowSizeChange() override {}
+        void handleKeyboardEvent(const KeyboardEvent& keyEvent) override {}
+        void handleMouseEvent(const MouseEvent& mouseEvent) override {}
+    } mDummyCallbacks;
+
+    Window::SharedPtr mpWindow; //used for dummy device creation
+};
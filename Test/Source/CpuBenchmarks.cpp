@@ -0,0 +1,363 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "CpuBenchmarks.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <random>
+#include <stdexcept>
+
+std::string CpuBenchmarks::sModelFile = "teapot.obj";
+std::string CpuBenchmarks::sBinaryModelFile;
+std::string CpuBenchmarks::sSceneFile = "Scenes/bumpyplane.fscene";
+std::string CpuBenchmarks::sAnimatedModelFile;
+
+static const uint32_t kBoxCount = 4096;
+
+static std::vector<BoundingBox> createRandomBoxes(uint32_t count, float range, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(-range, range);
+    std::uniform_real_distribution<float> size(0.1f, 2.0f);
+    std::vector<BoundingBox> boxes(count);
+    for (BoundingBox& box : boxes)
+    {
+        box.center = glm::vec3(pos(rng), pos(rng), pos(rng));
+        box.extent = glm::vec3(size(rng), size(rng), size(rng));
+    }
+    return boxes;
+}
+
+void CpuBenchmarks::addBenchmarks()
+{
+    addBenchmarkToList<BoundingBoxTransform>();
+    addBenchmarkToList<CameraCulling>();
+    addBenchmarkToList<GraphWalk>();
+    addBenchmarkToList<ReflectionLookup>();
+    addBenchmarkToList<SetVariableByName>();
+    addBenchmarkToList<SetVariableByOffset>();
+    addBenchmarkToList<ModelLoad>();
+    addBenchmarkToList<BinaryModelLoad>();
+    addBenchmarkToList<SceneLoad>();
+    addBenchmarkToList<ModelAnimate>();
+    addBenchmarkToList<OcclusionCulling>();
+}
+
+void CpuBenchmarks::onInit()
+{
+    if (mArgList.argExists("model")) sModelFile = mArgList["model"].asString();
+    if (mArgList.argExists("binmodel")) sBinaryModelFile = mArgList["binmodel"].asString();
+    if (mArgList.argExists("scene")) sSceneFile = mArgList["scene"].asString();
+    if (mArgList.argExists("animatedmodel")) sAnimatedModelFile = mArgList["animatedmodel"].asString();
+}
+
+// BoundingBox::transform() over a batch of boxes and matrices, as done per mesh instance when updating scene bounds
+bool CpuBenchmarks::BoundingBoxTransform::setup()
+{
+    mBoxes = createRandomBoxes(kBoxCount, 100, 1);
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    mTransforms.resize(kBoxCount);
+    for (glm::mat4& m : mTransforms)
+    {
+        glm::vec3 axis = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)) + glm::vec3(0, 0, 2));
+        m = glm::translate(glm::mat4(), glm::vec3(dist(rng), dist(rng), dist(rng)) * 50.0f) * glm::rotate(glm::mat4(), dist(rng) * 3.14f, axis);
+    }
+    mItemsPerOp = kBoxCount;
+    return true;
+}
+
+void CpuBenchmarks::BoundingBoxTransform::run()
+{
+    BoundingBox result = mBoxes[0];
+    for (uint32_t i = 0; i < kBoxCount; i++)
+    {
+        result = BoundingBox::fromUnion(result, mBoxes[i].transform(mTransforms[i]));
+    }
+    mResult = result;
+}
+
+// Camera::isObjectCulled() over a batch of boxes spread around the camera, so roughly a quarter of them are visible
+bool CpuBenchmarks::CameraCulling::setup()
+{
+    mpCamera = Camera::create();
+    mpCamera->setAspectRatio(16.0f / 9.0f);
+    mpCamera->setDepthRange(0.1f, 1000.0f);
+    mpCamera->setPosition(glm::vec3(0, 0, 0));
+    mpCamera->setTarget(glm::vec3(0, 0, -1));
+    mBoxes = createRandomBoxes(kBoxCount, 200, 3);
+    mItemsPerOp = kBoxCount;
+    return true;
+}
+
+void CpuBenchmarks::CameraCulling::run()
+{
+    uint32_t visible = 0;
+    for (const BoundingBox& box : mBoxes)
+    {
+        visible += mpCamera->isObjectCulled(box) ? 0 : 1;
+    }
+    mVisibleCount = visible;
+}
+
+// Graph::walk() along existing edges. This is the lookup pattern of the state-object caches: the same sequence of state changes is walked every frame.
+bool CpuBenchmarks::GraphWalk::setup()
+{
+    const uint32_t pathCount = 256;
+    const uint32_t pathLength = 8;
+    std::mt19937_64 rng(4);
+    std::uniform_int_distribution<uint64_t> edge(0, 15);
+
+    mpGraph = GraphType::create();
+    mPaths.resize(pathCount);
+    for (auto& path : mPaths)
+    {
+        mpGraph->gotoStart();
+        for (uint32_t i = 0; i < pathLength; i++)
+        {
+            path.push_back(edge(rng));
+            if (mpGraph->walk(path.back()) == false)
+            {
+                mpGraph->setCurrentNodeData((uint32_t)rng());
+            }
+        }
+    }
+    mItemsPerOp = pathCount * pathLength;
+    return true;
+}
+
+void CpuBenchmarks::GraphWalk::run()
+{
+    uint32_t sum = 0;
+    for (const auto& path : mPaths)
+    {
+        mpGraph->gotoStart();
+        for (uint64_t e : path)
+        {
+            mpGraph->walk(e);
+        }
+        sum += mpGraph->getCurrentNode();
+    }
+    mNodeSum = sum;
+}
+
+// Buffer and variable lookups by name, as done by ProgramVars and the scene renderer when binding
+static GraphicsProgram::SharedPtr createEditorProgram()
+{
+    return GraphicsProgram::createFromFile("Framework/Shaders/SceneEditorVS.slang", "Framework/Shaders/SceneEditorPS.slang");
+}
+
+static const char* kPerFrameVars[] = { "gCam.viewMat", "gCam.projMat", "gCam.viewProjMat", "gCam.position", "gAmbientLighting", "gLightsCount", "gLights[0].worldPos", "gLights[0].intensity" };
+
+bool CpuBenchmarks::ReflectionLookup::setup()
+{
+    GraphicsProgram::SharedPtr pProgram = createEditorProgram();
+    if (pProgram == nullptr || pProgram->getActiveVersion() == nullptr) return false;
+    mpReflector = pProgram->getActiveVersion()->getReflector();
+    // run() looks the buffer up on every op, so make sure it exists before timing it
+    if (mpReflector->getBufferDesc("InternalPerFrameCB", ProgramReflection::BufferReflection::Type::Constant) == nullptr)
+    {
+        logError(mName + ": can't find InternalPerFrameCB");
+        return false;
+    }
+    mVarNames.assign(std::begin(kPerFrameVars), std::end(kPerFrameVars));
+    mItemsPerOp = mVarNames.size() + 1;
+    return true;
+}
+
+void CpuBenchmarks::ReflectionLookup::run()
+{
+    size_t sum = 0;
+    auto pBufferDesc = mpReflector->getBufferDesc("InternalPerFrameCB", ProgramReflection::BufferReflection::Type::Constant);
+    if (pBufferDesc == nullptr)
+    {
+        throw std::runtime_error("InternalPerFrameCB not found");
+    }
+    for (const std::string& name : mVarNames)
+    {
+        size_t offset = 0;
+        pBufferDesc->getVariableData(name, offset);
+        sum += offset;
+    }
+    mOffsetSum = sum;
+}
+
+static ConstantBuffer::SharedPtr createPerFrameCB()
+{
+    GraphicsProgram::SharedPtr pProgram = createEditorProgram();
+    if (pProgram == nullptr || pProgram->getActiveVersion() == nullptr) return nullptr;
+    auto pBufferDesc = pProgram->getActiveVersion()->getReflector()->getBufferDesc("InternalPerFrameCB", ProgramReflection::BufferReflection::Type::Constant);
+    if (pBufferDesc == nullptr) return nullptr;
+    return ConstantBuffer::create(pBufferDesc);
+}
+
+// VariablesBuffer::setVariable() with a name lookup per call
+bool CpuBenchmarks::SetVariableByName::setup()
+{
+    mpCB = createPerFrameCB();
+    mMatrix = glm::mat4(2.0f);
+    mItemsPerOp = 4;
+    return mpCB != nullptr;
+}
+
+void CpuBenchmarks::SetVariableByName::run()
+{
+    mpCB->setVariable("gCam.viewMat", mMatrix);
+    mpCB->setVariable("gCam.projMat", mMatrix);
+    mpCB->setVariable("gCam.viewProjMat", mMatrix);
+    mpCB->setVariable("gCam.position", glm::vec3(mMatrix[3]));
+}
+
+// VariablesBuffer::setVariable() with offsets resolved once, for comparison with SetVariableByName
+bool CpuBenchmarks::SetVariableByOffset::setup()
+{
+    mpCB = createPerFrameCB();
+    if (mpCB == nullptr) return false;
+    mOffsets = { mpCB->getVariableOffset("gCam.viewMat"), mpCB->getVariableOffset("gCam.projMat"), mpCB->getVariableOffset("gCam.viewProjMat"), mpCB->getVariableOffset("gCam.position") };
+    mMatrix = glm::mat4(2.0f);
+    mItemsPerOp = 4;
+    return true;
+}
+
+void CpuBenchmarks::SetVariableByOffset::run()
+{
+    mpCB->setVariable(mOffsets[0], mMatrix);
+    mpCB->setVariable(mOffsets[1], mMatrix);
+    mpCB->setVariable(mOffsets[2], mMatrix);
+    mpCB->setVariable(mOffsets[3], glm::vec3(mMatrix[3]));
+}
+
+static bool findInput(const std::string& filename, const std::string& benchmark)
+{
+    std::string fullpath;
+    if (filename.empty()) return false;
+    if (findFileInDataDirectories(filename, fullpath) == false)
+    {
+        logWarning(benchmark + ": can't find " + filename);
+        return false;
+    }
+    return true;
+}
+
+// Model::createFromFile() for an Assimp-imported model, including tangent generation
+bool CpuBenchmarks::ModelLoad::setup()
+{
+    return findInput(sModelFile, mName);
+}
+
+void CpuBenchmarks::ModelLoad::run()
+{
+    Model::createFromFile(sModelFile.c_str());
+}
+
+// Model::createFromFile() for a BinaryModelImporter model
+bool CpuBenchmarks::BinaryModelLoad::setup()
+{
+    return findInput(sBinaryModelFile, mName);
+}
+
+void CpuBenchmarks::BinaryModelLoad::run()
+{
+    Model::createFromFile(sBinaryModelFile.c_str());
+}
+
+// Scene::loadFromFile(), JSON parsing plus the model loads it triggers
+bool CpuBenchmarks::SceneLoad::setup()
+{
+    return findInput(sSceneFile, mName);
+}
+
+void CpuBenchmarks::SceneLoad::run()
+{
+    Scene::loadFromFile(sSceneFile);
+}
+
+// Model::animate() at 60 steps per second
+bool CpuBenchmarks::ModelAnimate::setup()
+{
+    if (findInput(sAnimatedModelFile, mName) == false) return false;
+    mpModel = Model::createFromFile(sAnimatedModelFile.c_str());
+    return mpModel && mpModel->hasAnimations();
+}
+
+void CpuBenchmarks::ModelAnimate::run()
+{
+    mTime += 1.0 / 60.0;
+    mpModel->animate(mTime);
+}
+
+// OcclusionCuller::build() from the scene camera, then an occlusion test of every frustum-visible mesh instance, as done by SceneRenderer every frame.
+// The models keep their CPU geometry, so the occluders are read without a GPU readback.
+bool CpuBenchmarks::OcclusionCulling::setup()
+{
+    if (findInput(sSceneFile, mName) == false) return false;
+    mpScene = Scene::loadFromFile(sSceneFile, Model::LoadFlags::KeepCpuGeometry);
+    if (mpScene == nullptr || mpScene->getActiveCamera() == nullptr) return false;
+
+    const Camera* pCamera = mpScene->getActiveCamera().get();
+    mpCuller = OcclusionCuller::create();
+    mpCuller->selectOccluders(mpScene.get(), pCamera);
+
+    mBoxes.clear();
+    for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+    {
+        const Model* pModel = mpScene->getModel(modelID).get();
+        for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+        {
+            const auto& pModelInstance = mpScene->getModelInstance(modelID, instanceID);
+            if (pModelInstance->isVisible() == false) continue;
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                {
+                    const auto& pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID);
+                    BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                    if (pMeshInstance->isVisible() && pCamera->isObjectCulled(box) == false) mBoxes.push_back(box);
+                }
+            }
+        }
+    }
+    mItemsPerOp = std::max<uint64_t>(mBoxes.size(), 1);
+    return true;
+}
+
+void CpuBenchmarks::OcclusionCulling::run()
+{
+    mpCuller->build(mpScene.get(), mpScene->getActiveCamera().get());
+    uint32_t visible = 0;
+    for (const BoundingBox& box : mBoxes)
+    {
+        visible += mpCuller->isVisible(box) ? 1 : 0;
+    }
+    mVisibleCount = visible;
+}
+
+int main()
+{
+    CpuBenchmarks cb;
+    cb.init(GetCommandLineA());
+    return cb.run();
+}
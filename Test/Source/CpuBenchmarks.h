@@ -0,0 +1,159 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "BenchmarkBase.h"
+#include "Utils/Graph.h"
+
+/** Micro-benchmarks for the framework's CPU hot paths. Build with the DebugNull/ReleaseNull configs to run without a GPU.
+    Inputs default to files in Media/ and can be overridden:
+        -model <file>           Model loaded by ModelLoad (Assimp path, including tangent generation)
+        -binmodel <file>        Model loaded by BinaryModelLoad. Skipped if not specified
+        -scene <file>           Scene loaded by SceneLoad
+        -animatedmodel <file>   Model animated by ModelAnimate. Skipped if not specified or if the model has no animations
+    OcclusionCulling uses the -scene file and its active camera.
+*/
+class CpuBenchmarks : public BenchmarkBase
+{
+private:
+    void addBenchmarks() override;
+    void onInit() override;
+
+    static std::string sModelFile;
+    static std::string sBinaryModelFile;
+    static std::string sSceneFile;
+    static std::string sAnimatedModelFile;
+
+    class BoundingBoxTransform : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        std::vector<BoundingBox> mBoxes;
+        std::vector<glm::mat4> mTransforms;
+        BoundingBox mResult;
+    };
+
+    class CameraCulling : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        Camera::SharedPtr mpCamera;
+        std::vector<BoundingBox> mBoxes;
+        uint32_t mVisibleCount = 0;
+    };
+
+    class GraphWalk : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        using GraphType = Graph<uint32_t, uint64_t>;
+        GraphType::SharedPtr mpGraph;
+        std::vector<std::vector<uint64_t>> mPaths;
+        uint32_t mNodeSum = 0;
+    };
+
+    class ReflectionLookup : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        ProgramReflection::SharedConstPtr mpReflector;
+        std::vector<std::string> mVarNames;
+        size_t mOffsetSum = 0;
+    };
+
+    class SetVariableByName : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        ConstantBuffer::SharedPtr mpCB;
+        glm::mat4 mMatrix;
+    };
+
+    class SetVariableByOffset : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        ConstantBuffer::SharedPtr mpCB;
+        std::vector<size_t> mOffsets;
+        glm::mat4 mMatrix;
+    };
+
+    class ModelLoad : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    };
+
+    class BinaryModelLoad : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    };
+
+    class SceneLoad : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    };
+
+    class ModelAnimate : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        Model::SharedPtr mpModel;
+        double mTime = 0;
+    };
+
+    class OcclusionCulling : public Benchmark
+    {
+    public:
+        bool setup() override;
+        void run() override;
+    private:
+        Scene::SharedPtr mpScene;
+        OcclusionCuller::SharedPtr mpCuller;
+        std::vector<BoundingBox> mBoxes;
+        uint32_t mVisibleCount = 0;
+    };
+};
@@ -0,0 +1,192 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "CpuBvhTest.h"
+#include "Raytracing/CpuBvh.h"
+#include <random>
+
+void CpuBvhTest::addTests()
+{
+    addTestToList<TestEmpty>();
+    addTestToList<TestClosestHit>();
+    addTestToList<TestOccluded>();
+    addTestToList<TestDepthBound>();
+}
+
+// Reference intersection, testing every triangle
+static bool bruteForceIntersect(const std::vector<glm::vec3>& positions, const glm::vec3& origin, const glm::vec3& dir, float tMin, float tMax, float& closest)
+{
+    bool found = false;
+    closest = tMax;
+    for (size_t i = 0; i + 2 < positions.size(); i += 3)
+    {
+        const glm::vec3 e1 = positions[i + 1] - positions[i];
+        const glm::vec3 e2 = positions[i + 2] - positions[i];
+        const glm::vec3 pvec = glm::cross(dir, e2);
+        const float det = glm::dot(e1, pvec);
+        if (fabsf(det) < 1e-12f) continue;
+        const float invDet = 1.0f / det;
+        const glm::vec3 tvec = origin - positions[i];
+        const float u = glm::dot(tvec, pvec) * invDet;
+        if (u < 0 || u > 1) continue;
+        const glm::vec3 qvec = glm::cross(tvec, e1);
+        const float v = glm::dot(dir, qvec) * invDet;
+        if (v < 0 || u + v > 1) continue;
+        const float t = glm::dot(e2, qvec) * invDet;
+        if (t <= tMin || t >= closest) continue;
+        closest = t;
+        found = true;
+    }
+    return found;
+}
+
+static std::vector<glm::vec3> createRandomTriangles(uint32_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::vector<glm::vec3> positions;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const glm::vec3 center(dist(rng) * 10, dist(rng) * 10, dist(rng) * 10);
+        for (uint32_t v = 0; v < 3; v++)
+        {
+            positions.push_back(center + glm::vec3(dist(rng), dist(rng), dist(rng)));
+        }
+    }
+    return positions;
+}
+
+static glm::vec3 randomDirection(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1, 1);
+    return glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)) + glm::vec3(1e-3f));
+}
+
+testing_func(CpuBvhTest, TestEmpty)
+{
+    if (CpuBvh::create(std::vector<glm::vec3>()) != nullptr)
+    {
+        return test_fail("A BVH was created without triangles");
+    }
+    return test_pass();
+}
+
+testing_func(CpuBvhTest, TestClosestHit)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    const std::vector<glm::vec3> positions = createRandomTriangles(3000, rng);
+    CpuBvh::SharedPtr pBvh = CpuBvh::create(positions);
+    if (pBvh == nullptr || pBvh->getTriangleCount() != 3000)
+    {
+        return test_fail("Failed to create the BVH");
+    }
+
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        const glm::vec3 origin(dist(rng) * 15, dist(rng) * 15, dist(rng) * 15);
+        const glm::vec3 dir = randomDirection(rng);
+        float expectedT;
+        const bool expected = bruteForceIntersect(positions, origin, dir, 0, FLT_MAX, expectedT);
+
+        CpuBvh::Hit hit;
+        if (pBvh->intersect(origin, dir, 0, FLT_MAX, hit) != expected)
+        {
+            return test_fail("BVH and brute force disagree on whether the ray hits");
+        }
+        if (expected && (fabsf(hit.t - expectedT) > 1e-4f || hit.primId >= 3000))
+        {
+            return test_fail("BVH didn't return the closest hit");
+        }
+    }
+    return test_pass();
+}
+
+testing_func(CpuBvhTest, TestOccluded)
+{
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    const std::vector<glm::vec3> positions = createRandomTriangles(1000, rng);
+    CpuBvh::SharedPtr pBvh = CpuBvh::create(positions);
+
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        const glm::vec3 origin(dist(rng) * 15, dist(rng) * 15, dist(rng) * 15);
+        const glm::vec3 dir = randomDirection(rng);
+        const float tMax = (dist(rng) + 1) * 10;
+        float closest;
+        const bool expected = bruteForceIntersect(positions, origin, dir, 0, tMax, closest);
+        if (pBvh->occluded(origin, dir, 0, tMax) != expected)
+        {
+            return test_fail("BVH and brute force disagree on occlusion");
+        }
+    }
+    return test_pass();
+}
+
+testing_func(CpuBvhTest, TestDepthBound)
+{
+    // Inputs which make a pure SAH build degenerate into long chains: identical triangles, and triangles spaced exponentially along an axis
+    std::vector<glm::vec3> identical(30000 * 3, glm::vec3(1));
+    std::vector<glm::vec3> exponential;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        const float x = powf(1.001f, (float)i);
+        exponential.push_back(glm::vec3(x, 0, 0));
+        exponential.push_back(glm::vec3(x, 1, 0));
+        exponential.push_back(glm::vec3(x, 0, 1));
+    }
+
+    for (const auto& positions : { identical, exponential })
+    {
+        CpuBvh::SharedPtr pBvh = CpuBvh::create(positions);
+        if (pBvh == nullptr || pBvh->getDepth() > CpuBvh::kMaxDepth)
+        {
+            return test_fail("BVH depth exceeds CpuBvh::kMaxDepth");
+        }
+    }
+
+    // Rays along the exponential axis must still hit
+    CpuBvh::SharedPtr pBvh = CpuBvh::create(exponential);
+    for (uint32_t i = 0; i < 20000; i += 97)
+    {
+        const float x = powf(1.001f, (float)i);
+        CpuBvh::Hit hit;
+        if (pBvh->intersect(glm::vec3(x, 0.25f, 0.25f) - glm::vec3(0.5f, 0, 0), glm::vec3(1, 0, 0), 0, FLT_MAX, hit) == false)
+        {
+            return test_fail("Ray missed a triangle of the degenerate BVH");
+        }
+    }
+    return test_pass();
+}
+
+int main()
+{
+    CpuBvhTest cbt;
+    cbt.init(false);
+    cbt.run();
+    return 0;
+}
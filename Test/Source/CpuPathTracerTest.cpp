@@ -0,0 +1,196 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "CpuPathTracerTest.h"
+
+static const uint32_t kWidth = 64;
+static const uint32_t kHeight = 64;
+
+void CpuPathTracerTest::addTests()
+{
+    addTestToList<TestKeepCpuGeometry>();
+    addTestToList<TestRenderToCpuBuffer>();
+    addTestToList<TestAccumulationReset>();
+    addTestToList<TestSaveImage>();
+}
+
+// A box in front of the camera, lit by a directional light. The background stays black
+static Scene::SharedPtr createScene(Camera::SharedPtr& pCamera)
+{
+    Model::SharedPtr pModel = Model::createFromFile("box.obj", Model::LoadFlags::KeepCpuGeometry);
+    if (pModel == nullptr) return nullptr;
+
+    Scene::SharedPtr pScene = Scene::create();
+    pScene->addModelInstance(pModel, "box");
+    DirectionalLight::SharedPtr pLight = DirectionalLight::create();
+    pLight->setWorldDirection(glm::vec3(-0.3f, -1, -0.5f));
+    pLight->setIntensity(glm::vec3(2));
+    pScene->addLight(pLight);
+
+    const float radius = pModel->getRadius();
+    pCamera = Camera::create();
+    pCamera->setAspectRatio((float)kWidth / kHeight);
+    pCamera->setPosition(pModel->getCenter() + glm::vec3(radius, radius, radius * 2.5f));
+    pCamera->setTarget(pModel->getCenter());
+    pCamera->setDepthRange(0.01f * radius, 100 * radius);
+    return pScene;
+}
+
+testing_func(CpuPathTracerTest, TestKeepCpuGeometry)
+{
+    Model::SharedPtr pModel = Model::createFromFile("box.obj", Model::LoadFlags::KeepCpuGeometry);
+    if (pModel == nullptr || pModel->getMeshCount() == 0)
+    {
+        return test_fail("Failed to load the model");
+    }
+
+    for (uint32_t i = 0; i < pModel->getMeshCount(); i++)
+    {
+        const Mesh::SharedPtr& pMesh = pModel->getMesh(i);
+        const auto& pGeometry = pMesh->getCpuGeometry();
+        if (pGeometry == nullptr)
+        {
+            return test_fail("Mesh was loaded with KeepCpuGeometry but doesn't have CPU geometry");
+        }
+        if (pGeometry->positions.size() != pMesh->getVertexCount() || pGeometry->indices.size() != pMesh->getIndexCount())
+        {
+            return test_fail("CPU geometry doesn't match the mesh vertex or index count");
+        }
+    }
+
+    Model::SharedPtr pGpuOnly = Model::createFromFile("box.obj", Model::LoadFlags::None);
+    if (pGpuOnly->getMesh(0)->getCpuGeometry() != nullptr)
+    {
+        return test_fail("CPU geometry was kept without KeepCpuGeometry");
+    }
+    return test_pass();
+}
+
+testing_func(CpuPathTracerTest, TestRenderToCpuBuffer)
+{
+    Camera::SharedPtr pCamera;
+    Scene::SharedPtr pScene = createScene(pCamera);
+    CpuPathTracer::SharedPtr pTracer = pScene ? CpuPathTracer::create(pScene) : nullptr;
+    if (pTracer == nullptr)
+    {
+        return test_fail("Failed to create the path tracer");
+    }
+
+    pTracer->setMaxBounces(1);
+    pTracer->render(pCamera, kWidth, kHeight);
+    pTracer->render(pCamera, kWidth, kHeight);
+    const std::vector<glm::vec3>& accumulation = pTracer->getAccumulationBuffer();
+    if (pTracer->getAccumulatedFrameCount() != 2 || pTracer->getWidth() != kWidth || pTracer->getHeight() != kHeight || accumulation.size() != kWidth * kHeight)
+    {
+        return test_fail("Unexpected accumulation buffer size or frame count");
+    }
+
+    for (const glm::vec3& c : accumulation)
+    {
+        if (std::isfinite(c.x) == false || std::isfinite(c.y) == false || std::isfinite(c.z) == false || glm::min(c.x, glm::min(c.y, c.z)) < 0)
+        {
+            return test_fail("Accumulation buffer contains negative or non-finite values");
+        }
+    }
+
+    // The camera looks at the center of the box, the corner of the image only sees the background
+    if (accumulation[(kHeight / 2) * kWidth + kWidth / 2] == glm::vec3(0))
+    {
+        return test_fail("The box is not lit");
+    }
+    if (accumulation[0] != glm::vec3(0))
+    {
+        return test_fail("The background is not black");
+    }
+    return test_pass();
+}
+
+testing_func(CpuPathTracerTest, TestAccumulationReset)
+{
+    Camera::SharedPtr pCamera;
+    Scene::SharedPtr pScene = createScene(pCamera);
+    CpuPathTracer::SharedPtr pTracer = pScene ? CpuPathTracer::create(pScene) : nullptr;
+    if (pTracer == nullptr)
+    {
+        return test_fail("Failed to create the path tracer");
+    }
+
+    pTracer->setMaxBounces(0);
+    pTracer->render(pCamera, kWidth, kHeight);
+    pTracer->render(pCamera, kWidth, kHeight);
+    pCamera->setPosition(pCamera->getPosition() * 1.1f);
+    pTracer->render(pCamera, kWidth, kHeight);
+    if (pTracer->getAccumulatedFrameCount() != 1)
+    {
+        return test_fail("Moving the camera didn't restart the accumulation");
+    }
+
+    pTracer->render(pCamera, kWidth / 2, kHeight);
+    if (pTracer->getAccumulatedFrameCount() != 1 || pTracer->getAccumulationBuffer().size() != kWidth / 2 * kHeight)
+    {
+        return test_fail("Resizing the image didn't restart the accumulation");
+    }
+    return test_pass();
+}
+
+testing_func(CpuPathTracerTest, TestSaveImage)
+{
+    Camera::SharedPtr pCamera;
+    Scene::SharedPtr pScene = createScene(pCamera);
+    CpuPathTracer::SharedPtr pTracer = pScene ? CpuPathTracer::create(pScene) : nullptr;
+    if (pTracer == nullptr)
+    {
+        return test_fail("Failed to create the path tracer");
+    }
+
+    if (pTracer->saveImage("CpuPathTracerTest.pfm"))
+    {
+        return test_fail("Saved an image before rendering a frame");
+    }
+
+    pTracer->setMaxBounces(0);
+    pTracer->render(pCamera, kWidth, kHeight);
+    if (pTracer->saveImage("CpuPathTracerTest.pfm") == false || pTracer->saveImage("CpuPathTracerTest.png") == false)
+    {
+        return test_fail("Failed to save the image");
+    }
+
+    Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile("CpuPathTracerTest.png", true);
+    if (pBitmap == nullptr || pBitmap->getWidth() != kWidth || pBitmap->getHeight() != kHeight)
+    {
+        return test_fail("The saved image can't be read back");
+    }
+    return test_pass();
+}
+
+int main()
+{
+    CpuPathTracerTest cptt;
+    cptt.init(true);
+    cptt.run();
+    return 0;
+}
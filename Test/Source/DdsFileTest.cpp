@@ -0,0 +1,189 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "DdsFileTest.h"
+#include "Graphics/DdsFile.h"
+#include "Utils/DDSHeader.h"
+#include <fstream>
+#include <cstdio>
+
+using namespace DdsHelper;
+
+static const char* kTestFile = "DdsFileTest.dds";
+
+void DdsFileTest::addTests()
+{
+    addTestToList<TestRejectInvalidCounts>();
+    addTestToList<TestMipStreamingOrder>();
+}
+
+void DdsFileTest::onInit()
+{
+    // The invalid files are expected to log errors
+    Logger::showBoxOnError(false);
+}
+
+// Byte value every texel of a mip is filled with, so a readback tells which level was uploaded
+static uint8_t getMipValue(uint32_t mip) { return (uint8_t)(0x10 * (mip + 1)); }
+
+/** Write a square RGBA8 2D texture array with a DX10 header.
+    \param[in] headerMipCount The mip count written into the header
+    \param[in] storedMipCount The number of levels actually written per array slice
+*/
+static void writeTestFile(uint32_t size, uint32_t headerMipCount, uint32_t storedMipCount, uint32_t arraySize, uint32_t storedSliceCount)
+{
+    DdsHeader header = {};
+    header.headerSize = sizeof(DdsHeader);
+    header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kMipCountMask;
+    header.width = size;
+    header.height = size;
+    header.mipCount = headerMipCount;
+    header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+    header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+    header.pixelFormat.fourCC = 'D' | ('X' << 8) | ('1' << 16) | ('0' << 24);
+    header.caps[0] = DdsHeader::kCapsTextureMask;
+
+    DdsHeaderDX10 dx10Header = {};
+    dx10Header.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    dx10Header.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+    dx10Header.arraySize = arraySize;
+
+    std::ofstream file(kTestFile, std::ios::binary);
+    const uint32_t magic = 0x20534444;
+    file.write((const char*)&magic, sizeof(magic));
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)&dx10Header, sizeof(dx10Header));
+    for (uint32_t slice = 0; slice < storedSliceCount; slice++)
+    {
+        for (uint32_t mip = 0; mip < storedMipCount; mip++)
+        {
+            uint32_t mipSize = std::max(size >> mip, 1u);
+            std::vector<uint8_t> texels(mipSize * mipSize * 4, getMipValue(mip));
+            file.write((const char*)texels.data(), texels.size());
+        }
+    }
+}
+
+testing_func(DdsFileTest, TestRejectInvalidCounts)
+{
+    // A 16x16 texture has at most 5 levels
+    writeTestFile(16, 6, 6, 1, 1);
+    bool tooManyMips = (DdsFile::open(kTestFile) != nullptr);
+
+    // An array size the file can't possibly hold must be rejected before the subresource table is allocated
+    writeTestFile(16, 1, 1, 0x40000000, 1);
+    bool tooManySlices = (DdsFile::open(kTestFile) != nullptr);
+
+    writeTestFile(16, 5, 5, 2, 2);
+    DdsFile::SharedPtr pFile = DdsFile::open(kTestFile);
+    bool validOpened = (pFile != nullptr) && (pFile->getMipCount() == 5) && (pFile->getArraySize() == 2);
+    pFile = nullptr;
+    std::remove(kTestFile);
+
+    if (tooManyMips)
+    {
+        return test_fail("A file with more mips than its size allows was opened");
+    }
+    if (tooManySlices)
+    {
+        return test_fail("A file with an array size larger than its payload was opened");
+    }
+    if (validOpened == false)
+    {
+        return test_fail("A valid file was rejected");
+    }
+    return test_pass();
+}
+
+testing_func(DdsFileTest, TestMipStreamingOrder)
+{
+    // 16x16 with 5 levels. Mip 2 is 4x4 texels, 64 bytes, so a 64-byte tail makes mips 4, 3 and 2 resident up front
+    writeTestFile(16, 5, 5, 1, 1);
+    DdsFile::SharedPtr pFile = DdsFile::open(kTestFile);
+    if (pFile == nullptr)
+    {
+        std::remove(kTestFile);
+        return test_fail("Can't open the test file");
+    }
+
+    RenderContext::SharedPtr pCtx = gpDevice->getRenderContext();
+    Texture::SharedPtr pTexture = pFile->createTexture(Texture::BindFlags::ShaderResource, false, 64);
+
+    // The first texel of a resident level must hold the value written for it
+    auto isResident = [&](uint32_t mip)
+    {
+        std::vector<uint8> texels = pCtx->readTextureSubresource(pTexture.get(), pTexture->getSubresourceIndex(0, mip));
+        return texels.size() >= 4 && texels[0] == getMipValue(mip) && texels[3] == getMipValue(mip);
+    };
+    auto areResident = [&](uint32_t firstMip)
+    {
+        for (uint32_t mip = firstMip; mip < pTexture->getMipCount(); mip++)
+        {
+            if (isResident(mip) == false) return false;
+        }
+        return true;
+    };
+
+    std::string error;
+    if (pTexture == nullptr || pTexture->getMipCount() != 5)
+    {
+        error = "Can't create the texture";
+    }
+    else if (pFile->getResidentMip() != 2 || areResident(2) == false)
+    {
+        error = "The mip tail wasn't uploaded first";
+    }
+    else if (pFile->streamNextMip(pCtx.get()) == false || pFile->getResidentMip() != 1 || areResident(1) == false)
+    {
+        error = "Streaming didn't upload the next finer level";
+    }
+    else if (pFile->streamNextMip(pCtx.get()) || pFile->getResidentMip() != 0 || areResident(0) == false)
+    {
+        error = "Streaming didn't finish with the most detailed level";
+    }
+    else if (pFile->streamNextMip(pCtx.get()) || pFile->getResidentMip() != 0)
+    {
+        error = "Streaming continued after the chain was complete";
+    }
+
+    pTexture = nullptr;
+    pFile = nullptr;
+    std::remove(kTestFile);
+    if (error.size())
+    {
+        return test_fail(error);
+    }
+    return test_pass();
+}
+
+int main()
+{
+    DdsFileTest dft;
+    dft.init(true);
+    dft.run();
+    return 0;
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "ImageDiffTest.h"
+#include "Utils/ImageDiff.h"
+#include <random>
+
+// Not a multiple of 4, so the last column of tiles is partial
+static const uint32_t kWidth = 67;
+static const uint32_t kHeight = 45;
+
+void ImageDiffTest::addTests()
+{
+    addTestToList<TestIdenticalImages>();
+    addTestToList<TestUniformOffset>();
+    addTestToList<TestSinglePixel>();
+}
+
+static std::vector<uint8_t> createImage(uint8_t value)
+{
+    return std::vector<uint8_t>(kWidth * kHeight * 4, value);
+}
+
+static bool isClose(double value, double expected, double relTolerance)
+{
+    return std::abs(value - expected) <= relTolerance * std::abs(expected);
+}
+
+testing_func(ImageDiffTest, TestIdenticalImages)
+{
+    std::mt19937 rng(1);
+    std::vector<uint8_t> image = createImage(0);
+    for (uint8_t& v : image) v = (uint8_t)rng();
+
+    // Tile sizes which are not a multiple of 4 are rounded up
+    for (uint32_t tileSize : { 4u, 5u, 7u, 13u, 64u })
+    {
+        ImageDiff::Desc desc;
+        desc.tileSize = tileSize;
+        ImageDiff::Result result = ImageDiff::compare(image.data(), ResourceFormat::RGBA8Unorm, image.data(), ResourceFormat::RGBA8Unorm, kWidth, kHeight, desc);
+        if (result.valid == false || result.passed == false)
+        {
+            return test_fail("An image doesn't match itself with a tile size of " + std::to_string(tileSize));
+        }
+        if (result.mse != 0 || std::isinf(result.psnr) == false || std::abs(result.ssim - 1) > 1e-5 || result.maxDeltaE != 0 || result.failingPixelRatio != 0)
+        {
+            return test_fail("Wrong metrics for identical images with a tile size of " + std::to_string(tileSize));
+        }
+
+        uint32_t tilePixels = 0;
+        for (const ImageDiff::TileStats& tile : result.tiles)
+        {
+            if (tile.x % 4 != 0)
+            {
+                return test_fail("A tile doesn't start on a multiple of 4");
+            }
+            tilePixels += tile.width * tile.height;
+        }
+        if (tilePixels != kWidth * kHeight)
+        {
+            return test_fail("The tiles don't cover the image");
+        }
+    }
+    return test_pass();
+}
+
+testing_func(ImageDiffTest, TestUniformOffset)
+{
+    // Every channel differs by 10/255. Both images are flat, so the SSIM only has the luminance term
+    std::vector<uint8_t> image = createImage(128);
+    std::vector<uint8_t> reference = createImage(138);
+    ImageDiff::Result result = ImageDiff::compare(image.data(), ResourceFormat::RGBA8Unorm, reference.data(), ResourceFormat::RGBA8Unorm, kWidth, kHeight);
+
+    const double error = 10.0 / 255.0;
+    const double muA = 128.0 / 255.0;
+    const double muB = 138.0 / 255.0;
+    const double c1 = 0.01 * 0.01;
+    const double expectedSsim = (2 * muA * muB + c1) / (muA * muA + muB * muB + c1);
+    if (result.valid == false || isClose(result.mse, error * error, 1e-4) == false || isClose(result.psnr, -20.0 * log10(error), 1e-4) == false)
+    {
+        return test_fail("Wrong MSE or PSNR for a uniform offset");
+    }
+    if (isClose(result.ssim, expectedSsim, 1e-4) == false)
+    {
+        return test_fail("Wrong SSIM for a uniform offset");
+    }
+    // A Delta E of about 3.9 is above the just-noticeable difference everywhere
+    if (result.failingPixelRatio != 1 || result.passed)
+    {
+        return test_fail("A uniform visible offset passed");
+    }
+    return test_pass();
+}
+
+testing_func(ImageDiffTest, TestSinglePixel)
+{
+    std::vector<uint8_t> image = createImage(128);
+    std::vector<uint8_t> reference = image;
+    uint8_t* pPixel = &reference[(10 * kWidth + 20) * 4];
+    pPixel[0] = pPixel[1] = pPixel[2] = 255;
+    ImageDiff::Result result = ImageDiff::compare(image.data(), ResourceFormat::RGBA8Unorm, reference.data(), ResourceFormat::RGBA8Unorm, kWidth, kHeight);
+
+    const double pixelCount = kWidth * kHeight;
+    const double error = 127.0 / 255.0;
+    if (result.valid == false || isClose(result.mse, error * error / pixelCount, 1e-4) == false)
+    {
+        return test_fail("Wrong MSE for a single different pixel");
+    }
+    if (isClose(result.failingPixelRatio, 1 / pixelCount, 1e-4) == false)
+    {
+        return test_fail("Wrong failing pixel ratio for a single different pixel");
+    }
+    if (result.ssim >= 1 || result.ssim < 0.9)
+    {
+        return test_fail("Wrong SSIM for a single different pixel");
+    }
+    return test_pass();
+}
+
+int main()
+{
+    ImageDiffTest idt;
+    idt.init(false);
+    idt.run();
+    return 0;
+}
@@ -0,0 +1,174 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "LightClustersTest.h"
+#include "Graphics/Scene/LightClusters.h"
+#include "Graphics/Camera/Camera.h"
+
+void LightClustersTest::addTests()
+{
+    addTestToList<TestBenchmarkMatchesBruteForce>();
+    addTestToList<TestGlobalLights>();
+    addTestToList<TestGridSize>();
+    addTestToList<TestValidateDetectsMismatch>();
+}
+
+static Camera::SharedPtr createTestCamera()
+{
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setPosition(glm::vec3(0, 0, 5));
+    pCamera->setTarget(glm::vec3(0, 0, 0));
+    pCamera->setUpVector(glm::vec3(0, 1, 0));
+    pCamera->setAspectRatio(16.0f / 9.0f);
+    pCamera->setDepthRange(0.1f, 1000.0f);
+    return pCamera;
+}
+
+static uint32_t countIndices(const LightClusters* pClusters)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < pClusters->getClusterCount(); i++)
+    {
+        count += pClusters->getClusterRange(i).y;
+    }
+    return count;
+}
+
+testing_func(LightClustersTest, TestBenchmarkMatchesBruteForce)
+{
+    Camera::SharedPtr pCamera = createTestCamera();
+    LightClusters::SharedPtr pClusters = LightClusters::create();
+
+    // Enough lights to take the multi-threaded path
+    const uint32_t lightCounts[] = { 1, 100, 4000 };
+    for (uint32_t lightCount : lightCounts)
+    {
+        const LightClusters::Stats stats = pClusters->benchmark(pCamera.get(), lightCount, 2, false);
+        if (pClusters->validate() != 0)
+        {
+            return test_fail("Cluster light lists don't match the brute-force result for " + std::to_string(lightCount) + " lights");
+        }
+        if (stats.lightCount != lightCount || stats.globalLightCount != 0)
+        {
+            return test_fail("Wrong light count in the benchmark statistics");
+        }
+        if (stats.indexCount != countIndices(pClusters.get()) || stats.indexCount != pClusters->getLightIndices().size())
+        {
+            return test_fail("Index count doesn't match the cluster ranges");
+        }
+        if (stats.maxClusterLightCount > lightCount)
+        {
+            return test_fail("A cluster has more lights than the scene");
+        }
+    }
+    return test_pass();
+}
+
+testing_func(LightClustersTest, TestGlobalLights)
+{
+    Camera::SharedPtr pCamera = createTestCamera();
+    LightClusters::SharedPtr pClusters = LightClusters::create(8, 4, 8);
+
+    std::vector<LightData> lights(2);
+    lights[0].type = LightDirectional;
+    lights[0].worldDir = glm::vec3(0, -1, 0);
+    lights[0].intensity = glm::vec3(1);
+    // A point light far behind the camera reaches no cluster
+    lights[1].type = LightPoint;
+    lights[1].worldPos = glm::vec3(0, 0, 1000);
+    lights[1].intensity = glm::vec3(1);
+    pClusters->build(lights, pCamera.get());
+
+    if (pClusters->validate() != 0)
+    {
+        return test_fail("Cluster light lists don't match the brute-force result");
+    }
+    if (pClusters->getStats().globalLightCount != 1)
+    {
+        return test_fail("The directional light wasn't treated as a global light");
+    }
+    for (uint32_t i = 0; i < pClusters->getClusterCount(); i++)
+    {
+        const glm::uvec2& range = pClusters->getClusterRange(i);
+        if (range.y != 1 || pClusters->getLightIndices()[range.x] != 0)
+        {
+            return test_fail("Every cluster should contain only the directional light");
+        }
+    }
+    return test_pass();
+}
+
+testing_func(LightClustersTest, TestGridSize)
+{
+    Camera::SharedPtr pCamera = createTestCamera();
+    LightClusters::SharedPtr pClusters = LightClusters::create(4, 4, 4);
+    pClusters->benchmark(pCamera.get(), 64, 1, false);
+    if (pClusters->getClusterCount() != 64)
+    {
+        return test_fail("Wrong cluster count");
+    }
+
+    pClusters->setGridSize(5, 3, 7);
+    pClusters->benchmark(pCamera.get(), 64, 1, false);
+    const LightClusterParams& params = pClusters->getParams();
+    if (params.gridSizeX != 5 || params.gridSizeY != 3 || params.gridSizeZ != 7 || pClusters->getClusterCount() != 5 * 3 * 7)
+    {
+        return test_fail("The grid size wasn't applied by build()");
+    }
+    if (pClusters->validate() != 0)
+    {
+        return test_fail("Cluster light lists don't match the brute-force result after resizing the grid");
+    }
+    return test_pass();
+}
+
+testing_func(LightClustersTest, TestValidateDetectsMismatch)
+{
+    Camera::SharedPtr pCamera = createTestCamera();
+    LightClusters::SharedPtr pClusters = LightClusters::create(8, 4, 8);
+    pClusters->benchmark(pCamera.get(), 100, 1, false);
+    if (pClusters->validate() != 0)
+    {
+        return test_fail("Cluster light lists don't match the brute-force result");
+    }
+
+    // A lower threshold makes the brute-force light bounds 10 times larger than the ones the clusters were built with
+    pClusters->setIntensityThreshold(pClusters->getIntensityThreshold() * 0.01f);
+    if (pClusters->validate() == 0)
+    {
+        return test_fail("validate() didn't detect clusters built with smaller light bounds");
+    }
+    return test_pass();
+}
+
+int main()
+{
+    LightClustersTest lct;
+    lct.init(false);
+    lct.run();
+    return 0;
+}
@@ -0,0 +1,212 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "VirtualTexturePageTableTest.h"
+#include "Graphics/VirtualTexturePageTable.h"
+
+using PageId = VirtualTexturePageTable::PageId;
+
+void VirtualTexturePageTableTest::addTests()
+{
+    addTestToList<TestPinnedPages>();
+    addTestToList<TestLruEviction>();
+    addTestToList<TestFallbackToCoarserMip>();
+}
+
+// 512x512 texels with 128-texel pages: 4x4 pages in mip 0, 2x2 in mip 1 and a single pinned page in mip 2
+static VirtualTexturePageTable::SharedPtr createTestTable(uint32_t slotCount)
+{
+    return VirtualTexturePageTable::create(512, 512, 3, 128, slotCount);
+}
+
+static PageId makePage(uint32_t mip, uint32_t x, uint32_t y)
+{
+    PageId page;
+    page.mip = mip;
+    page.x = x;
+    page.y = y;
+    return page;
+}
+
+// Run a frame which requests the given pages and loads everything it asks for
+static void runFrame(VirtualTexturePageTable* pTable, const std::vector<PageId>& pages)
+{
+    pTable->beginFrame();
+    for (const auto& page : pages) pTable->requestPage(page);
+    for (const auto& page : pTable->getPagesToLoad(64)) pTable->onPageLoaded(page);
+}
+
+static uint32_t getEntryMip(uint32_t entry) { return (entry >> VirtualTexturePageTable::kEntryMipShift) & VirtualTexturePageTable::kEntryMipMask; }
+static uint32_t getEntrySlot(uint32_t entry) { return entry & VirtualTexturePageTable::kEntrySlotMask; }
+
+testing_func(VirtualTexturePageTableTest, TestPinnedPages)
+{
+    if (createTestTable(1) != nullptr)
+    {
+        return test_fail("A table was created without a slot to stream into");
+    }
+
+    VirtualTexturePageTable::SharedPtr pTable = createTestTable(3);
+    const PageId pinned = makePage(2, 0, 0);
+
+    // Nothing is resident before the first frame
+    if (pTable->getEntries(0)[0] != 0)
+    {
+        return test_fail("Page table entries are valid before any page was loaded");
+    }
+
+    // Stream many more pages than there are slots. The pinned page must survive all the evictions
+    for (uint32_t frame = 0; frame < 16; frame++)
+    {
+        runFrame(pTable.get(), { makePage(0, frame % 4, (frame / 4) % 4) });
+        if (pTable->isResident(pinned) == false)
+        {
+            return test_fail("The pinned page of the coarsest level was evicted");
+        }
+    }
+    if (pTable->getStats().evictedCount == 0)
+    {
+        return test_fail("No page was evicted, the test doesn't exercise the slot pressure");
+    }
+
+    // Every entry of every level has a resident fallback
+    for (uint32_t mip = 0; mip < pTable->getMipCount(); mip++)
+    {
+        for (uint32_t entry : pTable->getEntries(mip))
+        {
+            if ((entry & VirtualTexturePageTable::kEntryValid) == 0)
+            {
+                return test_fail("A page table entry has no resident page");
+            }
+        }
+    }
+    return test_pass();
+}
+
+testing_func(VirtualTexturePageTableTest, TestLruEviction)
+{
+    // One slot for the pinned page and three for streaming
+    VirtualTexturePageTable::SharedPtr pTable = createTestTable(4);
+    const PageId a = makePage(1, 0, 0);
+    const PageId b = makePage(1, 1, 0);
+    const PageId c = makePage(1, 0, 1);
+    const PageId d = makePage(1, 1, 1);
+    runFrame(pTable.get(), { a });
+    runFrame(pTable.get(), { b });
+    runFrame(pTable.get(), { c });
+    if (pTable->isResident(a) == false || pTable->isResident(b) == false || pTable->isResident(c) == false)
+    {
+        return test_fail("Pages weren't loaded while slots were free");
+    }
+
+    // Using a again makes b the least recently used page
+    runFrame(pTable.get(), { a, d });
+    if (pTable->isResident(b) || pTable->isResident(a) == false || pTable->isResident(d) == false)
+    {
+        return test_fail("The least recently used page wasn't the one evicted");
+    }
+    if (pTable->getStats().evictedCount != 1)
+    {
+        return test_fail("Wrong eviction count");
+    }
+
+    // Every resident page is used this frame, so the new page can't get a slot
+    pTable->beginFrame();
+    for (const auto& page : { a, b, c, d }) pTable->requestPage(page);
+    std::vector<PageId> pages = pTable->getPagesToLoad(64);
+    if (pages.size() != 1 || !(pages[0] == b))
+    {
+        return test_fail("Only the non-resident page should be loaded");
+    }
+    if (pTable->onPageLoaded(b) != VirtualTexturePageTable::kInvalidSlot || pTable->getStats().droppedCount != 1)
+    {
+        return test_fail("A page used this frame was evicted");
+    }
+    return test_pass();
+}
+
+testing_func(VirtualTexturePageTableTest, TestFallbackToCoarserMip)
+{
+    // One slot for the pinned page and two for streaming
+    VirtualTexturePageTable::SharedPtr pTable = createTestTable(3);
+    const PageId pinned = makePage(2, 0, 0);
+    const PageId a = makePage(1, 0, 0);
+    const PageId b = makePage(1, 1, 0);
+    const PageId c = makePage(1, 0, 1);
+
+    runFrame(pTable.get(), { a });
+    const uint32_t pinnedSlot = pTable->getSlot(pinned);
+    const uint32_t slotA = pTable->getSlot(a);
+    if (pinnedSlot == VirtualTexturePageTable::kInvalidSlot || slotA == VirtualTexturePageTable::kInvalidSlot)
+    {
+        return test_fail("The requested page or its ancestor wasn't loaded");
+    }
+
+    // The mip 0 pages under a point to a, the others to the pinned page
+    const std::vector<uint32_t>& entries = pTable->getEntries(0);
+    for (uint32_t y = 0; y < pTable->getPageCountY(0); y++)
+    {
+        for (uint32_t x = 0; x < pTable->getPageCountX(0); x++)
+        {
+            const uint32_t entry = entries[y * pTable->getPageCountX(0) + x];
+            const bool underA = (x < 2 && y < 2);
+            if ((entry & VirtualTexturePageTable::kEntryValid) == 0 || getEntryMip(entry) != (underA ? 1u : 2u) || getEntrySlot(entry) != (underA ? slotA : pinnedSlot))
+            {
+                return test_fail("A mip 0 entry doesn't point to the finest resident page covering it");
+            }
+        }
+    }
+
+    // Loading c evicts a, whose entries must fall back to the pinned page
+    runFrame(pTable.get(), { b });
+    runFrame(pTable.get(), { c });
+    if (pTable->isResident(a))
+    {
+        return test_fail("The least recently used page wasn't evicted");
+    }
+    for (uint32_t mip = 0; mip < 2; mip++)
+    {
+        const uint32_t entry = pTable->getEntries(mip)[0];
+        if (getEntryMip(entry) != 2 || getEntrySlot(entry) != pinnedSlot)
+        {
+            return test_fail("Entries of an evicted page don't fall back to the coarser resident level");
+        }
+    }
+    if (pTable->isDirty() == false)
+    {
+        return test_fail("The table isn't dirty after pages changed");
+    }
+    return test_pass();
+}
+
+int main()
+{
+    VirtualTexturePageTableTest vtt;
+    vtt.init(false);
+    vtt.run();
+    return 0;
+}